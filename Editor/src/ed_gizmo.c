@@ -132,7 +132,6 @@ static Qs_Engine   *s_engine;
 /* GPU resources */
 static Qs_GpuPipeline       *s_pipeline;
 static Qs_GpuPipelineLayout *s_layout;
-static Qs_GpuBuffer         *s_vbuf;
 static Qs_RenderNode        *s_node;
 
 /* Frame geometry */
@@ -366,14 +365,12 @@ static void build_scale(const float pos[3], float size, int hl)
 static void gizmo_render(const Qs_RenderContext *ctx, void *user_data)
 {
     (void)user_data;
-    if (s_vert_count == 0 || !s_pipeline || !s_vbuf) return;
+    if (s_vert_count == 0 || !s_pipeline) return;
     if (!ctx->swapchain_view || ctx->swapchain_width == 0) return;
 
-    Qs_GpuContext *gpu = qs_engine_gpu(s_engine);
-    void *mapped = qs_gpu_map_buffer(gpu, s_vbuf);
-    if (!mapped) return;
-    memcpy(mapped, s_verts, s_vert_count * sizeof(GizmoVert));
-    qs_gpu_unmap_buffer(gpu, s_vbuf);
+    Qs_FrameAlloc vbuf;
+    if (!qs_renderer_frame_alloc(ctx, s_vert_count * sizeof(GizmoVert), &vbuf)) return;
+    memcpy(vbuf.data, s_verts, s_vert_count * sizeof(GizmoVert));
 
     qs_cmd_begin_rendering(ctx->cmd, &(Qs_GpuRenderTarget){
         .color      = ctx->swapchain_view,
@@ -392,7 +389,7 @@ static void gizmo_render(const Qs_RenderContext *ctx, void *user_data)
                           QS_GPU_SHADER_VERTEX | QS_GPU_SHADER_FRAGMENT,
                           0, 64, mvp);
 
-    qs_cmd_bind_vertex_buffer(ctx->cmd, 0, s_vbuf, 0);
+    qs_cmd_bind_vertex_buffer(ctx->cmd, 0, vbuf.buffer, vbuf.offset);
     qs_cmd_draw(ctx->cmd, s_vert_count, 0);
 
     qs_cmd_end_rendering(ctx->cmd);
@@ -588,12 +585,6 @@ void ed_gizmo_init(Qs_Engine *engine)
         return;
     }
 
-    s_vbuf = qs_gpu_create_buffer(gpu, &(Qs_GpuBufferDesc){
-        .size   = GIZMO_MAX_VERTS * sizeof(GizmoVert),
-        .usage  = QS_GPU_BUFFER_VERTEX,
-        .memory = QS_GPU_MEMORY_HOST_VISIBLE,
-    });
-
     s_vert_count  = 0;
     s_hover_axis  = -1;
     s_drag_axis   = -1;
@@ -602,7 +593,6 @@ void ed_gizmo_init(Qs_Engine *engine)
 void ed_gizmo_shutdown(Qs_Engine *engine)
 {
     Qs_GpuContext *gpu = qs_engine_gpu(engine);
-    if (s_vbuf)     { qs_gpu_destroy_buffer(gpu, s_vbuf);            s_vbuf     = NULL; }
     if (s_pipeline) { qs_gpu_destroy_pipeline(gpu, s_pipeline);      s_pipeline = NULL; }
     if (s_layout)   { qs_gpu_destroy_pipeline_layout(gpu, s_layout); s_layout   = NULL; }
     s_node   = NULL;
@@ -163,12 +163,13 @@ static void pick_pass_execute(const Qs_RenderContext *ctx, void *user_data)
     float vp[16];
     qs_m4_mul(ctx->proj, ctx->view, vp);
 
-    for (uint32_t i = 0; i < ctx->renderable_count; i++) {
+    for (uint32_t vi = 0; vi < ctx->visible_count; vi++) {
+        uint32_t i = ctx->visible[vi];
         const Qs_Renderable *ren = &ctx->renderables[i];
-        if (!ren->vertex_buffer) continue;
+        if (!ren->position_buffer) continue;
 
         float mvp[16];
-        qs_m4_mul(vp, ren->transform, mvp);
+        qs_m4_mul(vp, ctx->transforms[i], mvp);
 
         PickPC pc;
         memcpy(pc.mvp, mvp, 64);
@@ -179,7 +180,7 @@ static void pick_pass_execute(const Qs_RenderContext *ctx, void *user_data)
                               QS_GPU_SHADER_VERTEX | QS_GPU_SHADER_FRAGMENT,
                               0, sizeof(PickPC), &pc);
 
-        qs_cmd_bind_vertex_buffer(ctx->cmd, 0, ren->vertex_buffer, 0);
+        qs_cmd_bind_vertex_buffer(ctx->cmd, 0, ren->position_buffer, 0);
         if (ren->index_buffer) {
             qs_cmd_bind_index_buffer(ctx->cmd, ren->index_buffer, ren->index_16bit);
             qs_cmd_draw_indexed(ctx->cmd, ren->index_count, 0, 0);
@@ -222,11 +223,11 @@ void ed_pick_init(Qs_Engine *engine)
     Qs_GpuVertexAttribute attr = {
         .location = 0,
         .format   = QS_GPU_VERTEX_FORMAT_FLOAT3,
-        .offset   = offsetof(Qs_Vertex, position),
+        .offset   = 0,
     };
     Qs_GpuVertexBinding vb = {
         .binding         = 0,
-        .stride          = sizeof(Qs_Vertex),
+        .stride          = QS_VERTEX_POSITION_STRIDE,
         .attributes      = &attr,
         .attribute_count = 1,
     };
@@ -317,14 +318,13 @@ Qs_Entity ed_pick_entity_at(Qs_Engine *engine, float norm_x, float norm_y)
     qs_gpu_end_transfer(gpu, cmd);
 
     /* Read back the pixel */
-    uint8_t *pixel = (uint8_t *)qs_gpu_map_buffer(gpu, s_readback_buf);
+    const uint8_t *pixel = qs_gpu_buffer_data(s_readback_buf);
     if (!pixel) return QS_ENTITY_INVALID;
 
     uint8_t r = pixel[0];
     uint8_t g = pixel[1];
     uint8_t b = pixel[2];
     uint8_t a = pixel[3];
-    qs_gpu_unmap_buffer(gpu, s_readback_buf);
 
     /* Alpha == 0 means the clear colour = no entity */
     if (a == 0) return QS_ENTITY_INVALID;
@@ -224,6 +224,46 @@ const char *g_editor_css =
     "}"
 
     /* ---- Console ---- */
+    ".console-toolbar {"
+    "  height: " ED_H_ROW_LG "px;"
+    "  width: 100%;"
+    "  padding-left: 6px;"
+    "  padding-right: 6px;"
+    "  gap: 8px;"
+    "  align-items: center;"
+    "  background: " ED_COL_ELEVATED ";"
+    "}"
+
+    ".console-level-cb {"
+    "  color: " ED_COL_TEXT_MUTED ";"
+    "  font-size: " ED_FS "px;"
+    "}"
+
+    ".console-filter-input {"
+    "  flex-grow: 1;"
+    "  height: " ED_H_ROW_TIGHT "px;"
+    "  background: " ED_COL_VOID ";"
+    "  color: " ED_COL_TEXT_BRIGHT ";"
+    "  font-size: " ED_FS "px;"
+    "  padding-left: 6px;"
+    "  corner-radius: " ED_R_BASE ";"
+    "}"
+
+    ".console-nav-btn {"
+    "  height: " ED_H_ROW_TIGHT "px;"
+    "  padding-left: 6px;"
+    "  padding-right: 6px;"
+    "  background: " ED_COL_SURFACE ";"
+    "  color: " ED_COL_TEXT_MUTED ";"
+    "  font-size: " ED_FS "px;"
+    "  corner-radius: " ED_R_BASE ";"
+    "}"
+
+    ".console-status {"
+    "  color: " ED_COL_TEXT_SEC ";"
+    "  font-size: " ED_FS "px;"
+    "}"
+
     ".console-scroll {"
     "  overflow-y: scroll;"
     "  padding: 4px;"
@@ -219,17 +219,18 @@ static void on_frame(Qs_Engine *engine, void *userdata)
     ed_camera_update(&ed->cam, ed->scene_renderer, qs_engine_dt(ed->engine));
     ed_gizmo_update(ed, qs_engine_dt(ed->engine));
 
-    /* Submit scene renderables and lights for this frame */
+    /* Sync scene render proxies and submit lights for this frame */
     Qs_Scene *scene = qs_scene_active();
     if (scene && ed->scene_renderer) {
-        qs_renderer_clear_renderables(ed->scene_renderer);
         qs_renderer_clear_lights(ed->scene_renderer);
 
-        /* Recursive submission walks the scene + every PrototypeComp's
-           inner scene, composing world transforms.  Lights are submitted
-           only at the top level. */
+        /* Recursive sync walks the scene + every PrototypeComp's inner
+           scene, composing world transforms.  Lights are submitted only
+           at the top level. */
         qs_scene_submit_renderables(scene, ed->engine, ed->scene_renderer, NULL);
     }
+    if (ed->scene_renderer)
+        qs_renderer_publish(ed->scene_renderer);
 
     ed_menu_bar_sync();
     ed_hierarchy_update(ed);
@@ -753,6 +754,7 @@ void editor_destroy(Editor *ed)
     ed_gizmo_shutdown(ed->engine);
     ed_undo_shutdown();
     ed_keybinds_shutdown();
+    ed_console_shutdown();
     qs_engine_destroy(ed->engine);
     qs_project_destroy(ed->project);
     free(ed);
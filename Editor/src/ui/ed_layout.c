@@ -7,14 +7,33 @@
 #include <stdio.h>
 #include <string.h>
 
-/* ---- Console ---- */
-#define CONSOLE_MAX_LINES 100
+/* ---- Console ----
+   Virtualized: a fixed pool of labels shows a window of CONSOLE_WINDOW_ROWS
+   rows of a filtered log view; only that window is ever formatted. */
+#define CONSOLE_WINDOW_ROWS 100
+#define CONSOLE_FILTER_MAX  128
 
-static Ca_Window *s_console_window;
-static Ca_Label  *s_console_lines[CONSOLE_MAX_LINES];
-static uint32_t   s_prev_log_count;
+static Ca_Window  *s_console_window;
+static Ca_Label   *s_console_lines[CONSOLE_WINDOW_ROWS];
+static Ca_Label   *s_console_status;
+static Qs_LogView *s_console_view;
+static uint32_t    s_console_levels = QS_LOG_LEVEL_MASK_ALL;
+static char        s_console_filter[CONSOLE_FILTER_MAX];
+static bool        s_console_filter_dirty = true;
+static bool        s_console_follow = true;   /* pin the window to the newest rows */
+static uint32_t    s_console_top;             /* first row of the window */
+static uint32_t    s_shown_top    = UINT32_MAX;
+static uint32_t    s_shown_count  = UINT32_MAX;
+static uint64_t    s_shown_first  = UINT64_MAX;
 static bool        s_needs_scroll;
 
+typedef struct { Qs_LogLevel level; } ConsoleLevelCtx;
+static ConsoleLevelCtx s_level_ctx[QS_LOG_LEVEL_COUNT];
+
+static const char *k_level_names[QS_LOG_LEVEL_COUNT] = {
+    "Debug", "Trace", "Info", "Warn", "Error", "Fatal"
+};
+
 static uint32_t log_level_color(Qs_LogLevel level)
 {
     switch (level) {
@@ -28,6 +47,64 @@ static uint32_t log_level_color(Qs_LogLevel level)
     }
 }
 
+static void on_console_level(Ca_Checkbox *cb, void *user_data)
+{
+    const ConsoleLevelCtx *ctx = user_data;
+    uint32_t bit = 1u << ctx->level;
+    if (ca_checkbox_get(cb)) s_console_levels |= bit;
+    else                     s_console_levels &= ~bit;
+    s_console_filter_dirty = true;
+}
+
+static void on_console_filter(Ca_TextInput *input, void *user_data)
+{
+    (void)user_data;
+    const char *text = ca_get_text(input);
+    snprintf(s_console_filter, sizeof(s_console_filter), "%s", text ? text : "");
+    s_console_filter_dirty = true;
+}
+
+static void on_console_top(Ca_Button *btn, void *user_data)
+{
+    (void)btn; (void)user_data;
+    s_console_follow = false;
+    s_console_top    = 0;
+    ca_scroll_to_top(s_console_window, "console");
+}
+
+static void on_console_page_up(Ca_Button *btn, void *user_data)
+{
+    (void)btn; (void)user_data;
+    s_console_follow = false;
+    s_console_top    = s_console_top > CONSOLE_WINDOW_ROWS
+                     ? s_console_top - CONSOLE_WINDOW_ROWS : 0;
+    s_needs_scroll   = true;
+}
+
+static void on_console_page_down(Ca_Button *btn, void *user_data)
+{
+    (void)btn; (void)user_data;
+    s_console_top += CONSOLE_WINDOW_ROWS;
+    ca_scroll_to_top(s_console_window, "console");
+}
+
+static void on_console_bottom(Ca_Button *btn, void *user_data)
+{
+    (void)btn; (void)user_data;
+    s_console_follow = true;
+    s_needs_scroll   = true;
+}
+
+static void console_nav_btn(const char *text, Ca_ClickFn fn)
+{
+    ca_btn_begin(&(Ca_BtnDesc){
+        .text     = text,
+        .style    = "console-nav-btn",
+        .on_click = fn,
+    });
+    ca_btn_end();
+}
+
 void ed_layout(Ca_Window *window, void *editor)
 {
     (void)editor;
@@ -135,13 +212,44 @@ void ed_layout(Ca_Window *window, void *editor)
                 .inactive_bg   = CA_THEME_TRANSPARENT,
             });
 
-            /* Console content — scrollable log lines */
+            /* Console toolbar — level filters, text filter, paging */
+            ca_div_begin(&(Ca_DivDesc){
+                .direction = CA_HORIZONTAL,
+                .style     = "console-toolbar",
+            });
+            for (uint32_t l = 0; l < QS_LOG_LEVEL_COUNT; l++) {
+                s_level_ctx[l].level = (Qs_LogLevel)l;
+                ca_checkbox(&(Ca_CheckboxDesc){
+                    .text        = k_level_names[l],
+                    .checked     = (s_console_levels & (1u << l)) != 0,
+                    .style       = "console-level-cb",
+                    .on_change   = on_console_level,
+                    .change_data = &s_level_ctx[l],
+                });
+            }
+            ca_input(&(Ca_InputDesc){
+                .text        = s_console_filter,
+                .placeholder = "Filter...",
+                .style       = "console-filter-input",
+                .on_change   = on_console_filter,
+            });
+            console_nav_btn("Top",  on_console_top);
+            console_nav_btn("Up",   on_console_page_up);
+            console_nav_btn("Down", on_console_page_down);
+            console_nav_btn("End",  on_console_bottom);
+            s_console_status = ca_text(&(Ca_TextDesc){
+                .text  = "",
+                .style = "console-status",
+            });
+            ca_div_end();
+
+            /* Console content — the visible window of log rows */
             ca_div_begin(&(Ca_DivDesc){
                 .direction = CA_VERTICAL,
                 .style     = "console-scroll",
                 .id        = "console",
             });
-            for (uint32_t i = 0; i < CONSOLE_MAX_LINES; i++) {
+            for (uint32_t i = 0; i < CONSOLE_WINDOW_ROWS; i++) {
                 s_console_lines[i] = ca_text(&(Ca_TextDesc){
                     .text   = "",
                     .style  = "console-line",
@@ -159,44 +267,89 @@ void ed_console_update(void *editor)
 {
     (void)editor;
 
-    uint32_t count = 0;
-    const Qs_LogEntry *entries = qs_log_entries(&count);
+    if (!s_console_view) {
+        s_console_view = qs_log_view_create();
+        if (!s_console_view) return;
+    }
+    if (s_console_filter_dirty) {
+        s_console_filter_dirty = false;
+        qs_log_view_set_filter(s_console_view, s_console_levels, s_console_filter);
+        s_shown_count = UINT32_MAX;
+        s_console_follow = true;
+        s_needs_scroll   = true;
+    }
 
-    /* Scroll to bottom on the NEXT frame so content_h is up to date */
-    if (s_needs_scroll) {
+    /* Scroll on the NEXT frame so content_h is up to date */
+    if (s_needs_scroll && s_shown_count != UINT32_MAX) {
         s_needs_scroll = false;
         ca_scroll_to_bottom(s_console_window, "console");
     }
 
-    if (count == s_prev_log_count) return;
-    s_prev_log_count = count;
-    s_needs_scroll   = true;   /* scroll after next layout pass */
+    uint32_t count    = qs_log_view_refresh(s_console_view);
+    bool     scanning = qs_log_view_scanning(s_console_view);
+
+    uint32_t last_top = count > CONSOLE_WINDOW_ROWS ? count - CONSOLE_WINDOW_ROWS : 0;
+    if (s_console_follow || s_console_top >= last_top) {
+        if (!s_console_follow) s_needs_scroll = true;
+        s_console_follow = true;
+        s_console_top    = last_top;
+    }
+
+    /* Re-format only when the window or its contents actually moved. */
+    Qs_LogEntry first_entry = {0};
+    char        probe[1];
+    uint64_t    first_seq = qs_log_view_row(s_console_view, s_console_top, &first_entry,
+                                            probe, sizeof(probe))
+                          ? first_entry.seq : UINT64_MAX;
+    if (count == s_shown_count && s_console_top == s_shown_top && first_seq == s_shown_first)
+        return;
 
-    /* Show the most recent entries that fit in the label pool */
-    uint32_t start   = count > CONSOLE_MAX_LINES ? count - CONSOLE_MAX_LINES : 0;
-    uint32_t visible = count - start;
+    uint32_t visible = count - s_console_top;
+    if (visible > CONSOLE_WINDOW_ROWS) visible = CONSOLE_WINDOW_ROWS;
+    if (s_console_follow && count != s_shown_count) s_needs_scroll = true;
+
+    s_shown_count = count;
+    s_shown_top   = s_console_top;
+    s_shown_first = first_seq;
 
     char line_buf[512];
-    for (uint32_t i = 0; i < CONSOLE_MAX_LINES; i++) {
-        if (i < visible) {
-            const Qs_LogEntry *e = &entries[start + i];
-            int hrs = (int)(e->timestamp / 3600.0);
-            int min = (int)(e->timestamp / 60.0) % 60;
-            int sec = (int)e->timestamp % 60;
-            int ms  = (int)((e->timestamp - (int)e->timestamp) * 1000.0);
+    char msg_buf[480];
+    for (uint32_t i = 0; i < CONSOLE_WINDOW_ROWS; i++) {
+        Qs_LogEntry e;
+        if (i < visible &&
+            qs_log_view_row(s_console_view, s_console_top + i, &e, msg_buf, sizeof(msg_buf))) {
+            int hrs = (int)(e.timestamp / 3600.0);
+            int min = (int)(e.timestamp / 60.0) % 60;
+            int sec = (int)e.timestamp % 60;
+            int ms  = (int)((e.timestamp - (int)e.timestamp) * 1000.0);
 
             snprintf(line_buf, sizeof(line_buf),
                      "[%02d:%02d:%02d.%03d] [%s] %s",
                      hrs, min, sec, ms,
-                     qs_log_level_str(e->level), e->message);
+                     qs_log_level_str(e.level), e.message);
 
             ca_set_text(s_console_lines[i], line_buf);
-            ca_set_color(s_console_lines[i], log_level_color(e->level));
+            ca_set_color(s_console_lines[i], log_level_color(e.level));
             ca_set_hidden(s_console_lines[i], false);
         } else {
             ca_set_hidden(s_console_lines[i], true);
         }
     }
+
+    char status[96];
+    if (count == 0)
+        snprintf(status, sizeof(status), "%s", scanning ? "Indexing..." : "No messages");
+    else
+        snprintf(status, sizeof(status), "%u-%u of %u%s",
+                 s_console_top + 1, s_console_top + visible, count,
+                 scanning ? " (indexing...)" : "");
+    ca_set_text(s_console_status, status);
+}
+
+void ed_console_shutdown(void)
+{
+    qs_log_view_destroy(s_console_view);
+    s_console_view = NULL;
 }
 
 /* ================================================================
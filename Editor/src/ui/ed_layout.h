@@ -7,9 +7,13 @@
 
 void ed_layout(Ca_Window *window, void *editor);
 
-/// Refreshes the console panel with latest log entries.
+/// Refreshes the console panel: indexes new log entries and re-formats the
+/// visible window only when it changed.
 void ed_console_update(void *editor);
 
+/// Releases the console's log view.
+void ed_console_shutdown(void);
+
 /// Bottom status bar.
 void ed_status_bar(Ca_Window *window, void *editor);
 
@@ -19,7 +19,9 @@ typedef struct Qs_Project  Qs_Project;
    .qstex   — binary texture: header + mip-0 RGBA8 (or RG8 / R8) bytes.
               Mip chain is regenerated on GPU at upload time (mip_count
               field is reserved for future on-disk mip storage).
-   .qsmesh  — binary mesh: header + Qs_Vertex[] + uint32_t[] indices.
+   .qsmesh  — binary mesh: header + vertices + uint32_t[] indices.  The
+              vertices are interleaved Qs_Vertex[] (v1), or the position
+              and attribute streams when QS_MESH_FLAG_SPLIT_STREAMS is set.
    .qsmat   — JSON material: PBR factors + relative .qstex paths.
    .qproto  — JSON scene file (uses qs_scene_to_json/from_json).
 
@@ -35,10 +37,12 @@ typedef struct Qs_Project  Qs_Project;
 #define QS_MESH_MAGIC  0x534D5351u   /* "QSMS" little-endian */
 
 #define QS_TEX_VERSION   1u
-#define QS_MESH_VERSION  1u
+#define QS_MESH_VERSION  2u   /* v2 adds Qs_MeshFileHeader.flags */
 
 #define QS_TEX_FLAG_SRGB     (1u << 0)
 
+#define QS_MESH_FLAG_SPLIT_STREAMS (1u << 0)
+
 typedef struct Qs_TexFileHeader {
     uint32_t magic;
     uint32_t version;
@@ -62,9 +66,14 @@ typedef struct Qs_MeshFileHeader {
     float    aabb_min[3];
     float    aabb_max[3];
     char     surface_name[64];
+    uint32_t flags;         /* QS_MESH_FLAG_*; absent from v1 files */
     /* Followed by:
          Qs_Vertex vertices[vertex_count];
-         uint32_t  indices [index_count];
+       or, with QS_MESH_FLAG_SPLIT_STREAMS,
+         float               positions [vertex_count][3];
+         Qs_VertexAttributes attributes[vertex_count];
+       then
+         uint32_t            indices   [index_count];
      */
 } Qs_MeshFileHeader;
 
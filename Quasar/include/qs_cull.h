@@ -0,0 +1,59 @@
+#ifndef QS_CULL_H
+#define QS_CULL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "qs_math.h"
+
+/* ================================================================
+   VISIBILITY CULLING
+   Pure CPU code — no GPU context required, so it can be driven with
+   synthetic cameras and bounds.
+   ================================================================ */
+
+/// Number of boxes the frustum kernel tests per iteration.
+#define QS_CULL_LANES 8
+
+/// Six clip planes (a, b, c, d) with inward-facing normals; a point p is
+/// inside a plane when a*p.x + b*p.y + c*p.z + d >= 0.
+/// Order: left, right, bottom, top, near, far.
+typedef struct Qs_Frustum {
+    float planes[6][4];
+} Qs_Frustum;
+
+/// World-space bounds stored as structure-of-arrays centers and extents,
+/// the layout the frustum kernel streams through.
+typedef struct Qs_CullBounds {
+    float   *center[3];
+    float   *extent[3];
+    uint32_t count;
+    uint32_t capacity;
+} Qs_CullBounds;
+
+/// Extracts the frustum of a column-major view-projection matrix. Works
+/// for both [-1,1] and [0,1] clip depth; for [0,1] the near plane is
+/// conservative.
+void qs_frustum_from_matrix(Qs_Frustum *out, const float view_proj[16]);
+
+/// Grows bounds to hold at least capacity boxes. Existing boxes are kept.
+bool qs_cull_bounds_reserve(Qs_CullBounds *bounds, uint32_t capacity);
+
+/// Frees the arrays and zeroes bounds.
+void qs_cull_bounds_free(Qs_CullBounds *bounds);
+
+/// Stores box at index (index < capacity) and extends count past it.
+void qs_cull_bounds_set(Qs_CullBounds *bounds, uint32_t index, const Qs_AABB *box);
+
+/// Swap-removes the box at index: the last box moves into its place and
+/// count shrinks by one.
+void qs_cull_bounds_remove(Qs_CullBounds *bounds, uint32_t index);
+
+/// Tests every box in bounds against frustum and writes the indices of the
+/// boxes that intersect or lie inside it to out_visible, in ascending
+/// order. out_visible must hold bounds->count entries. Returns the number
+/// of visible boxes.
+uint32_t qs_cull_frustum(const Qs_Frustum *frustum, const Qs_CullBounds *bounds,
+                         uint32_t *out_visible);
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef QS_DRAW_LIST_H
+#define QS_DRAW_LIST_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* ================================================================
+   SORTED DRAW LISTS
+   Passes pack each draw's state into a 64-bit key, sort, and walk the
+   result so draws sharing a pipeline, material or mesh run back to
+   back.  Key layout, most significant bits first:
+
+     opaque:   pass:4 | pipeline:8 | material:16 | mesh:16 | depth:20
+     blended:  pass:4 | depth:20   | pipeline:8  | material:16 | mesh:16
+
+   Opaque depth ascends (front-to-back, helps early-Z); blended depth
+   is inverted (back-to-front, required for correct compositing).
+   ================================================================ */
+
+#define QS_DRAW_KEY_PASS_BITS      4
+#define QS_DRAW_KEY_PIPELINE_BITS  8
+#define QS_DRAW_KEY_MATERIAL_BITS  16
+#define QS_DRAW_KEY_MESH_BITS      16
+#define QS_DRAW_KEY_DEPTH_BITS     20
+
+/// Keys plus one payload word per draw (typically a renderable index),
+/// permuted together by qs_draw_list_sort.
+typedef struct Qs_DrawList {
+    uint64_t *keys;
+    uint32_t *items;
+    uint64_t *scratch_keys;
+    uint32_t *scratch_items;
+    uint32_t  count;
+    uint32_t  capacity;
+} Qs_DrawList;
+
+/// Grows the list to hold at least capacity draws.  Existing draws are kept.
+bool qs_draw_list_reserve(Qs_DrawList *list, uint32_t capacity);
+
+/// Frees the arrays and zeroes list.
+void qs_draw_list_free(Qs_DrawList *list);
+
+/// Sorts draws by ascending key.  Stable; runs only the radix passes
+/// whose digit differs between keys.
+void qs_draw_list_sort(Qs_DrawList *list);
+
+/// Appends a draw.  The list must have room (see qs_draw_list_reserve).
+static inline void qs_draw_list_push(Qs_DrawList *list, uint64_t key, uint32_t item)
+{
+    list->keys[list->count]  = key;
+    list->items[list->count] = item;
+    list->count++;
+}
+
+/// Quantizes a normalized depth (0 = near, 1 = far) to the key's depth
+/// field.  Out-of-range values are clamped.
+static inline uint64_t qs_draw_key_depth(float depth01)
+{
+    const float max = (float)((1u << QS_DRAW_KEY_DEPTH_BITS) - 1u);
+    float d = depth01 < 0.0f ? 0.0f : (depth01 > 1.0f ? 1.0f : depth01);
+    return (uint64_t)(d * max);
+}
+
+/// Builds a front-to-back key for an opaque or alpha-tested draw.
+static inline uint64_t qs_draw_key_opaque(uint32_t pass, uint32_t pipeline,
+                                          uint32_t material, uint32_t mesh,
+                                          float depth01)
+{
+    uint64_t k = pass & ((1u << QS_DRAW_KEY_PASS_BITS) - 1u);
+    k = (k << QS_DRAW_KEY_PIPELINE_BITS) | (pipeline & ((1u << QS_DRAW_KEY_PIPELINE_BITS) - 1u));
+    k = (k << QS_DRAW_KEY_MATERIAL_BITS) | (material & ((1u << QS_DRAW_KEY_MATERIAL_BITS) - 1u));
+    k = (k << QS_DRAW_KEY_MESH_BITS)     | (mesh     & ((1u << QS_DRAW_KEY_MESH_BITS)     - 1u));
+    k = (k << QS_DRAW_KEY_DEPTH_BITS)    | qs_draw_key_depth(depth01);
+    return k;
+}
+
+/// Builds a back-to-front key for a blended draw.
+static inline uint64_t qs_draw_key_blended(uint32_t pass, uint32_t pipeline,
+                                           uint32_t material, uint32_t mesh,
+                                           float depth01)
+{
+    const uint64_t depth_max = (1u << QS_DRAW_KEY_DEPTH_BITS) - 1u;
+    uint64_t k = pass & ((1u << QS_DRAW_KEY_PASS_BITS) - 1u);
+    k = (k << QS_DRAW_KEY_DEPTH_BITS)    | (depth_max - qs_draw_key_depth(depth01));
+    k = (k << QS_DRAW_KEY_PIPELINE_BITS) | (pipeline & ((1u << QS_DRAW_KEY_PIPELINE_BITS) - 1u));
+    k = (k << QS_DRAW_KEY_MATERIAL_BITS) | (material & ((1u << QS_DRAW_KEY_MATERIAL_BITS) - 1u));
+    k = (k << QS_DRAW_KEY_MESH_BITS)     | (mesh     & ((1u << QS_DRAW_KEY_MESH_BITS)     - 1u));
+    return k;
+}
+
+#endif
@@ -18,8 +18,8 @@ void        qs_dylib_close(Qs_Dylib *lib);
 /// Returns NULL if the symbol is not found.
 void       *qs_dylib_sym(Qs_Dylib *lib, const char *name);
 
-/// Returns a human-readable string describing the last error, or NULL.
-/// Valid until the next qs_dylib_* call on any library.
+/// Returns a human-readable string describing the calling thread's last
+/// error, or NULL. Valid until that thread's next qs_dylib_* call.
 const char *qs_dylib_error(void);
 
 /// Writes the directory containing the current executable into out_dir.
@@ -10,6 +10,10 @@ typedef uint32_t Qs_EventId;
 /// User-defined events start at this value.
 #define QS_EVENT_USER_BASE 0x10000
 
+/// Largest payload qs_event_post() copies inline. Post a pointer to
+/// caller-owned storage for anything bigger.
+#define QS_EVENT_POST_MAX_DATA 64
+
 /* ── Built-in engine events ─────────────────────────────────── */
 
 #define QS_EVENT_NONE           ((Qs_EventId)0)
@@ -46,15 +50,34 @@ typedef struct Qs_Event {
 typedef bool (*Qs_EventFn)(const Qs_Event* event, void* user_data);
 
 /// Subscribes a listener to an event ID. Returns a handle for unsubscribing.
+/// Main thread only.
 uint32_t qs_event_subscribe(Qs_EventBus* bus, Qs_EventId id,
                             Qs_EventFn callback, void* user_data);
 
-/// Removes a listener by its handle.
+/// Removes a listener by its handle. Safe to call from inside a listener;
+/// the remaining listeners keep their order. Main thread only.
 void qs_event_unsubscribe(Qs_EventBus* bus, uint32_t handle);
 
 /// Fires an event immediately. Listeners are called in subscription order.
-/// Stops early if a listener marks the event as handled.
+/// Stops early if a listener marks the event as handled. Main thread only;
+/// other threads use qs_event_post().
 void qs_event_fire(Qs_EventBus* bus, Qs_EventId id,
                    void* data, uint32_t data_size);
 
+/// Queues an event from any thread without locking. data_size bytes of
+/// data (at most QS_EVENT_POST_MAX_DATA) are copied. Returns false if the
+/// payload is too large or the queue is full (the drop is logged).
+/// Delivered on the main thread by qs_event_dispatch_posted().
+bool qs_event_post(Qs_EventBus* bus, Qs_EventId id,
+                   const void* data, uint32_t data_size);
+
+/// When enabled, multiple posts of id between two drains are collapsed
+/// into the most recent one. Main thread only.
+void qs_event_set_coalesce(Qs_EventBus* bus, Qs_EventId id, bool coalesce);
+
+/// Fires every event posted so far, in post order. The engine calls this
+/// once per frame after systems update and before the frame callback.
+/// Events posted by listeners during the drain are delivered next drain.
+void qs_event_dispatch_posted(Qs_EventBus* bus);
+
 #endif
@@ -16,9 +16,12 @@ typedef struct Qs_Engine  Qs_Engine;
 typedef struct Qs_GpuContext          Qs_GpuContext;     ///< Engine GPU context (device, queue, pools)
 typedef struct Qs_Viewport            Qs_Viewport;       ///< UI viewport widget (render target)
 typedef struct Qs_GpuCmd              Qs_GpuCmd;         ///< Command buffer for recording GPU commands
+typedef struct Qs_GpuCmdPool          Qs_GpuCmdPool;     ///< Single-thread pool of secondary command buffers
+typedef struct Qs_GpuFence            Qs_GpuFence;       ///< Host-visible marker of recorded GPU work completing
 typedef struct Qs_GpuBuffer           Qs_GpuBuffer;      ///< GPU buffer (vertex, index, uniform, storage)
 typedef struct Qs_GpuImage            Qs_GpuImage;       ///< GPU image (texture, depth)
 typedef struct Qs_GpuImageView        Qs_GpuImageView;   ///< Image view for shader access or attachments
+typedef struct Qs_GpuMemory           Qs_GpuMemory;      ///< Device-local block images can be placed in
 typedef struct Qs_GpuSampler          Qs_GpuSampler;     ///< Texture sampler
 typedef struct Qs_GpuShader           Qs_GpuShader;      ///< Compiled shader module
 typedef struct Qs_GpuPipeline         Qs_GpuPipeline;    ///< Graphics or compute pipeline
@@ -79,11 +82,12 @@ typedef enum {
     QS_GPU_BUFFER_UNIFORM  = 0x04,
     QS_GPU_BUFFER_STORAGE  = 0x08,
     QS_GPU_BUFFER_TRANSFER = 0x10,
+    QS_GPU_BUFFER_INDIRECT = 0x20,
 } Qs_GpuBufferUsage;
 
 typedef enum {
     QS_GPU_MEMORY_DEVICE_LOCAL = 0,  ///< GPU-only fast memory
-    QS_GPU_MEMORY_HOST_VISIBLE = 1,  ///< CPU-writable (persistently mappable)
+    QS_GPU_MEMORY_HOST_VISIBLE = 1,  ///< CPU-writable, persistently mapped (see qs_gpu_buffer_data)
 } Qs_GpuMemoryUsage;
 
 typedef enum {
@@ -93,6 +97,12 @@ typedef enum {
     QS_GPU_DESCRIPTOR_STORAGE_IMAGE          = 3,
 } Qs_GpuDescriptorType;
 
+/// Descriptor-indexing binding flags; see qs_gpu_descriptor_indexing_enabled.
+typedef enum {
+    QS_GPU_DESCRIPTOR_PARTIALLY_BOUND   = 0x1, ///< Elements the shader never reads may stay unwritten.
+    QS_GPU_DESCRIPTOR_UPDATE_AFTER_BIND = 0x2, ///< Unused elements may be written while the set is in use.
+} Qs_GpuDescriptorBindingFlags;
+
 typedef enum {
     QS_GPU_TOPOLOGY_TRIANGLES = 0,
     QS_GPU_TOPOLOGY_LINES     = 1,
@@ -105,6 +115,13 @@ typedef enum {
     QS_GPU_CULL_FRONT = 2,
 } Qs_GpuCullMode;
 
+/// Depth test comparison.  EQUAL passes only fragments matching depth a
+/// pre-pass already wrote.
+typedef enum {
+    QS_GPU_COMPARE_LESS  = 0,
+    QS_GPU_COMPARE_EQUAL = 1,
+} Qs_GpuCompareOp;
+
 typedef enum {
     QS_GPU_VERTEX_FORMAT_FLOAT  = 0,   ///< float  (1 component)
     QS_GPU_VERTEX_FORMAT_FLOAT2 = 1,   ///< vec2   (2 components)
@@ -140,8 +157,19 @@ typedef struct Qs_GpuImageDesc {
     Qs_GpuImageFormat format;
     Qs_GpuImageUsage  usage;
     uint32_t          sample_count;  ///< 1 = no MSAA (default), 2/4/8 = multisample
+    /// Optional block to place the image in at memory_offset instead of a
+    /// dedicated allocation.  Images placed in overlapping ranges alias;
+    /// the block must outlive them.
+    Qs_GpuMemory     *memory;
+    uint64_t          memory_offset;
 } Qs_GpuImageDesc;
 
+typedef struct Qs_GpuMemoryRequirements {
+    uint64_t size;
+    uint64_t alignment;
+    uint32_t type_bits;              ///< Bit i set = memory type i is compatible.
+} Qs_GpuMemoryRequirements;
+
 typedef struct Qs_GpuImageViewDesc {
     Qs_GpuImage      *image;
     Qs_GpuImageFormat format;        ///< Must match the image's format
@@ -160,10 +188,11 @@ typedef struct Qs_GpuSamplerDesc {
 } Qs_GpuSamplerDesc;
 
 typedef struct Qs_GpuDescriptorBinding {
-    uint32_t             binding;
-    Qs_GpuDescriptorType type;
-    uint32_t             count;
-    Qs_GpuShaderStage    stages;
+    uint32_t                     binding;
+    Qs_GpuDescriptorType         type;
+    uint32_t                     count;
+    Qs_GpuShaderStage            stages;
+    Qs_GpuDescriptorBindingFlags flags;
 } Qs_GpuDescriptorBinding;
 
 typedef struct Qs_GpuDescriptorPoolSize {
@@ -175,6 +204,7 @@ typedef struct Qs_GpuDescriptorPoolDesc {
     const Qs_GpuDescriptorPoolSize *sizes;
     uint32_t                        size_count;
     uint32_t                        max_sets;
+    bool                            update_after_bind; ///< For QS_GPU_DESCRIPTOR_UPDATE_AFTER_BIND layouts
 } Qs_GpuDescriptorPoolDesc;
 
 typedef struct Qs_GpuVertexAttribute {
@@ -201,8 +231,14 @@ typedef struct Qs_GpuPipelineLayoutDesc {
     uint32_t                          set_layout_count;
     const Qs_GpuPushConstantRange    *push_constants;
     uint32_t                          push_constant_count;
+    bool                              compute; ///< Descriptor sets bind at the compute bind point.
 } Qs_GpuPipelineLayoutDesc;
 
+typedef struct Qs_GpuComputePipelineDesc {
+    Qs_GpuPipelineLayout *layout;  ///< Created with compute = true.
+    Qs_GpuShader         *shader;
+} Qs_GpuComputePipelineDesc;
+
 typedef struct Qs_GpuGraphicsPipelineDesc {
     Qs_GpuPipelineLayout      *layout;
     Qs_GpuShader              *vertex_shader;
@@ -217,8 +253,51 @@ typedef struct Qs_GpuGraphicsPipelineDesc {
     Qs_GpuImageFormat          depth_format;   ///< QS_GPU_FORMAT_DEPTH_AUTO = no depth attachment
     bool                       wireframe;      ///< Draw triangles as lines (VK_POLYGON_MODE_LINE)
     uint32_t                   sample_count;   ///< 1 = no MSAA (default), 2/4/8 = multisample
+    Qs_GpuCompareOp            depth_compare;  ///< QS_GPU_COMPARE_LESS by default
+    const uint32_t            *fragment_constants;      ///< Values of fragment specialization constants 0..n-1
+    uint32_t                   fragment_constant_count;
 } Qs_GpuGraphicsPipelineDesc;
 
+/// Pipeline accesses that order buffer reads and writes in qs_cmd_buffer_barrier.
+typedef enum {
+    QS_GPU_ACCESS_TRANSFER_WRITE = 0x01,
+    QS_GPU_ACCESS_COMPUTE_READ   = 0x02,
+    QS_GPU_ACCESS_COMPUTE_WRITE  = 0x04,
+    QS_GPU_ACCESS_VERTEX_READ    = 0x08, ///< Vertex-shader storage / uniform reads.
+    QS_GPU_ACCESS_INDIRECT_READ  = 0x10, ///< Indirect draw command reads.
+    QS_GPU_ACCESS_FRAGMENT_READ  = 0x20, ///< Fragment-shader storage / uniform reads.
+} Qs_GpuAccess;
+
+typedef struct Qs_GpuBufferBarrier {
+    Qs_GpuBuffer *buffer;
+    Qs_GpuAccess  src;
+    Qs_GpuAccess  dst;
+} Qs_GpuBufferBarrier;
+
+typedef struct Qs_GpuBufferCopy {
+    uint64_t src_offset;
+    uint64_t dst_offset;
+    uint64_t size;
+} Qs_GpuBufferCopy;
+
+/// Matches VkDrawIndirectCommand.
+typedef struct Qs_GpuDrawIndirect {
+    uint32_t vertex_count;
+    uint32_t instance_count;
+    uint32_t first_vertex;
+    uint32_t first_instance;
+} Qs_GpuDrawIndirect;
+
+/// Matches VkDrawIndexedIndirectCommand.  instance_count sits at the same
+/// offset as in Qs_GpuDrawIndirect.
+typedef struct Qs_GpuDrawIndexedIndirect {
+    uint32_t index_count;
+    uint32_t instance_count;
+    uint32_t first_index;
+    int32_t  vertex_offset;
+    uint32_t first_instance;
+} Qs_GpuDrawIndexedIndirect;
+
 typedef struct Qs_GpuImageBarrier {
     Qs_GpuImage      *image;
     Qs_GpuImageLayout old_layout;
@@ -226,6 +305,10 @@ typedef struct Qs_GpuImageBarrier {
     Qs_GpuImageAspect aspect;
     uint32_t          base_mip;
     uint32_t          mip_count;
+    /// With old_layout UNDEFINED, the layout the previous user of the
+    /// image's memory (e.g. an aliasing image) left it in, so that user's
+    /// accesses finish first.  UNDEFINED = nothing to wait for.
+    Qs_GpuImageLayout wait_layout;
 } Qs_GpuImageBarrier;
 
 typedef struct Qs_GpuRenderTarget {
@@ -240,6 +323,9 @@ typedef struct Qs_GpuRenderTarget {
     uint32_t         height;
     bool             load_color;      ///< true = LOAD existing contents instead of CLEAR
     bool             load_depth;      ///< true = LOAD existing depth instead of CLEAR
+    /// true = the pass body is recorded in secondary command buffers and
+    /// replayed with qs_cmd_execute; no draws may be recorded inline.
+    bool             secondary;
 } Qs_GpuRenderTarget;
 
 /* ================================================================
@@ -273,6 +359,14 @@ Qs_GpuContext *qs_engine_gpu(Qs_Engine *engine);
 /// and depth images used as render targets (always a power of 2, minimum 1).
 uint32_t qs_gpu_max_sample_count(Qs_GpuContext *gpu);
 
+/// Returns true when the device was created with the descriptor-indexing
+/// features bindless sampler arrays rely on enabled: runtime-sized arrays,
+/// non-uniform indexing, partially bound and update-after-bind sampled
+/// images.  Support alone is not enough; the build must declare that
+/// Causality enables them (CMake option QUASAR_DESCRIPTOR_INDEXING).
+/// Layouts using Qs_GpuDescriptorBindingFlags fail to create otherwise.
+bool qs_gpu_descriptor_indexing_enabled(Qs_GpuContext *gpu);
+
 /* ================================================================
    BUFFER API
    ================================================================ */
@@ -288,11 +382,39 @@ Qs_GpuBuffer *qs_gpu_create_buffer_from_data(Qs_GpuContext *gpu, Qs_GpuBufferUsa
 /// Destroys a buffer and frees its memory.
 void qs_gpu_destroy_buffer(Qs_GpuContext *gpu, Qs_GpuBuffer *buffer);
 
-/// Maps a HOST_VISIBLE buffer for CPU writes.  Returns the mapped pointer.
-void *qs_gpu_map_buffer(Qs_GpuContext *gpu, Qs_GpuBuffer *buffer);
+/// Returns the CPU pointer of a HOST_VISIBLE buffer, which stays mapped
+/// (host-coherent) for its lifetime.  NULL for device-local buffers.
+void *qs_gpu_buffer_data(const Qs_GpuBuffer *buffer);
 
-/// Unmaps a previously mapped buffer.
-void qs_gpu_unmap_buffer(Qs_GpuContext *gpu, Qs_GpuBuffer *buffer);
+/// Alignment satisfying both uniform and storage descriptor offsets.
+uint64_t qs_gpu_buffer_offset_alignment(Qs_GpuContext *gpu);
+
+/* ================================================================
+   FENCE API
+   Marks the end of work recorded into a frame's command buffer so the
+   host can tell when resources it used may be rewritten.
+   ================================================================ */
+
+Qs_GpuFence *qs_gpu_create_fence(Qs_GpuContext *gpu);
+
+/// Destroys a fence, waiting for the device if it is still pending.
+void qs_gpu_destroy_fence(Qs_GpuContext *gpu, Qs_GpuFence *fence);
+
+/// Records a signal of fence once all previously recorded commands finish.
+/// Must be recorded outside a rendering pass.
+void qs_cmd_signal_fence(Qs_GpuCmd *cmd, Qs_GpuFence *fence);
+
+/// Blocks until the last recorded signal has executed, then re-arms the
+/// fence.  Returns immediately if no signal is pending; returns false on
+/// timeout or device loss, leaving the fence pending.  The wait spins
+/// briefly, then sleeps with a growing interval.
+///
+/// later (may be NULL) is a fence signaled after fence in submission
+/// order.  Once it has executed, fence is treated as passed even if its
+/// own signal never ran — the command buffer holding it was dropped
+/// without being submitted.
+bool qs_gpu_wait_fence(Qs_GpuContext *gpu, Qs_GpuFence *fence,
+                       const Qs_GpuFence *later, uint64_t timeout_ns);
 
 /* ================================================================
    IMAGE API
@@ -301,9 +423,20 @@ void qs_gpu_unmap_buffer(Qs_GpuContext *gpu, Qs_GpuBuffer *buffer);
 /// Creates a GPU image.  Destroy with qs_gpu_destroy_image.
 Qs_GpuImage *qs_gpu_create_image(Qs_GpuContext *gpu, const Qs_GpuImageDesc *desc);
 
-/// Destroys an image and frees its memory.
+/// Destroys an image and frees its memory (unless placed in a Qs_GpuMemory).
 void qs_gpu_destroy_image(Qs_GpuContext *gpu, Qs_GpuImage *image);
 
+/// Returns the memory an image created from desc would need, without
+/// creating it.  desc->memory is ignored.
+Qs_GpuMemoryRequirements qs_gpu_image_requirements(Qs_GpuContext *gpu,
+                                                   const Qs_GpuImageDesc *desc);
+
+/// Allocates a device-local block of a memory type in type_bits.
+/// Destroy with qs_gpu_destroy_memory after every image placed in it.
+Qs_GpuMemory *qs_gpu_create_memory(Qs_GpuContext *gpu, uint64_t size, uint32_t type_bits);
+
+void qs_gpu_destroy_memory(Qs_GpuContext *gpu, Qs_GpuMemory *memory);
+
 /// Uploads pixel data to an image via a staging buffer.
 /// Handles staging creation, layout transitions, optional mipmap generation.
 bool qs_gpu_upload_image(Qs_GpuContext *gpu, Qs_GpuImage *image,
@@ -331,6 +464,7 @@ void qs_gpu_destroy_sampler(Qs_GpuContext *gpu, Qs_GpuSampler *sampler);
    ================================================================ */
 
 /// Compiles GLSL source into a shader module.  Destroy with qs_gpu_destroy_shader.
+/// Callable from any thread; concurrent calls are serialized.
 Qs_GpuShader *qs_gpu_compile_shader(Qs_GpuContext *gpu, const char *glsl_source,
                                      Qs_GpuShaderStage stage);
 
@@ -370,9 +504,16 @@ void qs_gpu_write_image_descriptor(Qs_GpuContext *gpu, Qs_GpuDescriptorSet *set,
                                     uint32_t binding,
                                     Qs_GpuSampler *sampler, Qs_GpuImageView *view);
 
-/// Writes a uniform buffer binding into a descriptor set.
+/// Writes one element of a combined image+sampler array binding.
+void qs_gpu_write_image_array_descriptor(Qs_GpuContext *gpu, Qs_GpuDescriptorSet *set,
+                                          uint32_t binding, uint32_t element,
+                                          Qs_GpuSampler *sampler, Qs_GpuImageView *view);
+
+/// Writes a uniform or storage buffer binding into a descriptor set.
+/// range 0 = whole buffer.
 void qs_gpu_write_buffer_descriptor(Qs_GpuContext *gpu, Qs_GpuDescriptorSet *set,
-                                     uint32_t binding, Qs_GpuBuffer *buffer,
+                                     uint32_t binding, Qs_GpuDescriptorType type,
+                                     Qs_GpuBuffer *buffer,
                                      uint64_t offset, uint64_t range);
 
 /* ================================================================
@@ -390,6 +531,10 @@ void qs_gpu_destroy_pipeline_layout(Qs_GpuContext *gpu, Qs_GpuPipelineLayout *la
 Qs_GpuPipeline *qs_gpu_create_graphics_pipeline(Qs_GpuContext *gpu,
                                                   const Qs_GpuGraphicsPipelineDesc *desc);
 
+/// Creates a compute pipeline.  Destroy with qs_gpu_destroy_pipeline.
+Qs_GpuPipeline *qs_gpu_create_compute_pipeline(Qs_GpuContext *gpu,
+                                                 const Qs_GpuComputePipelineDesc *desc);
+
 /// Destroys a pipeline.
 void qs_gpu_destroy_pipeline(Qs_GpuContext *gpu, Qs_GpuPipeline *pipeline);
 
@@ -398,6 +543,8 @@ void qs_gpu_destroy_pipeline(Qs_GpuContext *gpu, Qs_GpuPipeline *pipeline);
    Two usage patterns:
      1. Frame commands: via Qs_GpuFrame.cmd in the viewport render callback
      2. Transfer commands: via qs_gpu_begin_transfer / qs_gpu_end_transfer
+     3. Secondary commands: via qs_gpu_begin_secondary, recorded on any
+        thread that owns the pool and replayed with qs_cmd_execute
    ================================================================ */
 
 /// Allocates and begins a one-shot transfer command buffer.
@@ -406,6 +553,34 @@ Qs_GpuCmd *qs_gpu_begin_transfer(Qs_GpuContext *gpu);
 /// Ends, submits, waits, and frees a transfer command buffer.
 void qs_gpu_end_transfer(Qs_GpuContext *gpu, Qs_GpuCmd *cmd);
 
+/// Creates a pool of secondary command buffers.  A pool and the buffers it
+/// hands out must only be used by one thread at a time.  Returns NULL when
+/// the queue family frames are recorded on cannot be determined (more than
+/// one graphics-capable family); record on the primary instead.
+Qs_GpuCmdPool *qs_gpu_create_cmd_pool(Qs_GpuContext *gpu);
+
+/// Destroys a pool and every command buffer it handed out.
+void qs_gpu_destroy_cmd_pool(Qs_GpuContext *gpu, Qs_GpuCmdPool *pool);
+
+/// Recycles every buffer handed out since the last reset.  The GPU must
+/// have finished executing them.
+void qs_gpu_reset_cmd_pool(Qs_GpuContext *gpu, Qs_GpuCmdPool *pool);
+
+/// Begins a secondary command buffer that continues a rendering pass into
+/// target.  Attachment formats and sample count come from target's views,
+/// which must be created through qs_gpu.  Nothing is inherited from the
+/// primary: set viewport, pipeline and descriptor sets before drawing.
+/// Returns NULL on failure.
+Qs_GpuCmd *qs_gpu_begin_secondary(Qs_GpuContext *gpu, Qs_GpuCmdPool *pool,
+                                  const Qs_GpuRenderTarget *target);
+
+/// Finishes recording a secondary command buffer.
+void qs_gpu_end_secondary(Qs_GpuCmd *cmd);
+
+/// Replays secondary command buffers in order.  cmd must be inside a
+/// rendering pass begun with Qs_GpuRenderTarget.secondary set.
+void qs_cmd_execute(Qs_GpuCmd *cmd, Qs_GpuCmd *const *secondaries, uint32_t count);
+
 /// Begins a dynamic rendering pass into the specified render target.
 void qs_cmd_begin_rendering(Qs_GpuCmd *cmd, const Qs_GpuRenderTarget *target);
 
@@ -415,10 +590,10 @@ void qs_cmd_end_rendering(Qs_GpuCmd *cmd);
 /// Sets viewport + scissor to cover the given dimensions.
 void qs_cmd_set_viewport(Qs_GpuCmd *cmd, uint32_t width, uint32_t height);
 
-/// Binds a graphics pipeline.
+/// Binds a graphics or compute pipeline.
 void qs_cmd_bind_pipeline(Qs_GpuCmd *cmd, Qs_GpuPipeline *pipeline);
 
-/// Binds a descriptor set.
+/// Binds a descriptor set at the bind point of layout.
 void qs_cmd_bind_descriptor_set(Qs_GpuCmd *cmd, Qs_GpuPipelineLayout *layout,
                                  uint32_t set_index, Qs_GpuDescriptorSet *set);
 
@@ -441,6 +616,37 @@ void qs_cmd_draw(Qs_GpuCmd *cmd, uint32_t vertex_count, uint32_t first_vertex);
 void qs_cmd_draw_indexed(Qs_GpuCmd *cmd, uint32_t index_count,
                           uint32_t first_index, int32_t vertex_offset);
 
+/// Issues a non-indexed draw of instance_count instances.  gl_InstanceIndex
+/// starts at first_instance.
+void qs_cmd_draw_instanced(Qs_GpuCmd *cmd, uint32_t vertex_count, uint32_t first_vertex,
+                            uint32_t instance_count, uint32_t first_instance);
+
+/// Issues an indexed draw of instance_count instances.  gl_InstanceIndex
+/// starts at first_instance.
+void qs_cmd_draw_indexed_instanced(Qs_GpuCmd *cmd, uint32_t index_count,
+                                    uint32_t first_index, int32_t vertex_offset,
+                                    uint32_t instance_count, uint32_t first_instance);
+
+/// Issues one draw per Qs_GpuDrawIndirect read from buffer at offset.
+/// Without the multiDrawIndirect device feature draw_count must be 0 or 1.
+void qs_cmd_draw_indirect(Qs_GpuCmd *cmd, Qs_GpuBuffer *buffer, uint64_t offset,
+                          uint32_t draw_count, uint32_t stride);
+
+/// Indexed variant of qs_cmd_draw_indirect reading Qs_GpuDrawIndexedIndirect.
+void qs_cmd_draw_indexed_indirect(Qs_GpuCmd *cmd, Qs_GpuBuffer *buffer, uint64_t offset,
+                                   uint32_t draw_count, uint32_t stride);
+
+/// Dispatches the bound compute pipeline.
+void qs_cmd_dispatch(Qs_GpuCmd *cmd, uint32_t groups_x, uint32_t groups_y, uint32_t groups_z);
+
+/// Makes src-stage writes to a buffer visible to dst-stage accesses.
+/// Must be recorded outside a rendering pass.
+void qs_cmd_buffer_barrier(Qs_GpuCmd *cmd, const Qs_GpuBufferBarrier *barrier);
+
+/// Copies regions between buffers.  Must be recorded outside a rendering pass.
+void qs_cmd_copy_buffer(Qs_GpuCmd *cmd, Qs_GpuBuffer *src, Qs_GpuBuffer *dst,
+                         const Qs_GpuBufferCopy *regions, uint32_t region_count);
+
 /// Inserts a pipeline/image memory barrier to transition an image's layout.
 void qs_cmd_image_barrier(Qs_GpuCmd *cmd, const Qs_GpuImageBarrier *barrier);
 
@@ -453,6 +659,12 @@ void qs_cmd_copy_image_to_buffer(Qs_GpuCmd *cmd, Qs_GpuImage *src,
                                   Qs_GpuBuffer *dst, uint32_t x, uint32_t y,
                                   uint32_t width, uint32_t height);
 
+/// Copies mip 0 of src into dst, which must share its format.  src must
+/// be in TRANSFER_SRC layout and dst in TRANSFER_DST; record outside a
+/// rendering pass.
+void qs_cmd_copy_image(Qs_GpuCmd *cmd, Qs_GpuImage *src, Qs_GpuImage *dst,
+                       Qs_GpuImageAspect aspect, uint32_t width, uint32_t height);
+
 /// Blits between two mip levels of the same image (for mipmap generation).
 void qs_cmd_blit_image_mip(Qs_GpuCmd *cmd, Qs_GpuImage *image,
                             uint32_t src_mip, uint32_t src_w, uint32_t src_h,
@@ -2,6 +2,7 @@
 #define QS_JOB_H
 
 #include <stdint.h>
+#include <stdbool.h>
 
 /// Opaque job system handle.
 typedef struct Qs_JobSystem Qs_JobSystem;
@@ -16,8 +17,23 @@ typedef void (*Qs_JobFn)(void* data);
 typedef struct Qs_JobDesc {
     Qs_JobFn  fn;           ///< Function to execute.
     void*     data;         ///< User data passed to fn.
+    /// Label shown in traces. Must outlive the job system (string literal).
+    /// NULL records the job as "job".
+    const char* name;
 } Qs_JobDesc;
 
+/// Live job system counters. Rates cover the interval since the previous
+/// qs_job_stats() call.
+typedef struct Qs_JobStats {
+    uint32_t queue_depth;       ///< Jobs waiting in the queue right now.
+    uint32_t worker_count;      ///< Number of worker threads.
+    uint64_t jobs_completed;    ///< Total jobs finished since startup.
+    uint64_t jobs_assisted;     ///< Jobs run by threads blocked in qs_job_wait.
+    double   jobs_per_second;   ///< Completion rate over the sample interval.
+    double   assist_ratio;      ///< Fraction of interval jobs run by waiters (0..1).
+    double   idle_percent;      ///< Average worker idle time over the interval (0..100).
+} Qs_JobStats;
+
 /// Allocates a counter for tracking job completion.
 Qs_JobCounter* qs_job_counter_create(Qs_JobSystem* system);
 
@@ -41,4 +57,23 @@ void qs_job_wait(Qs_JobSystem* system, Qs_JobCounter* counter);
 /// Returns the number of worker threads.
 uint32_t qs_job_system_thread_count(const Qs_JobSystem* system);
 
+/// Enables or disables per-job trace recording. Each worker records into its
+/// own fixed ring; the oldest events are overwritten once a ring is full.
+/// Disabled tracing costs one relaxed atomic load per job.
+void qs_job_trace_enable(Qs_JobSystem* system, bool enabled);
+
+/// Returns whether trace recording is enabled.
+bool qs_job_trace_enabled(const Qs_JobSystem* system);
+
+/// Discards all recorded trace events.
+void qs_job_trace_clear(Qs_JobSystem* system);
+
+/// Writes recorded trace events to path as Chrome Trace Event JSON
+/// (loadable in Perfetto or chrome://tracing). Returns false on I/O failure.
+bool qs_job_trace_dump(Qs_JobSystem* system, const char* path);
+
+/// Samples live counters into out. Interval rates are measured from the
+/// previous call, so poll at a steady cadence (e.g. once per frame).
+void qs_job_stats(Qs_JobSystem* system, Qs_JobStats* out);
+
 #endif
@@ -15,33 +15,84 @@ typedef enum Qs_LogLevel {
     QS_LOG_LEVEL_COUNT
 } Qs_LogLevel;
 
-/// A single log entry.
+/// Bit mask selecting every level in a view filter (bit n = Qs_LogLevel n).
+#define QS_LOG_LEVEL_MASK_ALL ((1u << QS_LOG_LEVEL_COUNT) - 1u)
+
+/// A single log entry, copied out of the history.
 typedef struct Qs_LogEntry {
+    uint64_t    seq;            ///< Monotonic sequence number since startup.
     Qs_LogLevel level;
     double      timestamp;      ///< Seconds since engine start.
-    const char *message;        ///< Null-terminated log text.
+    const char *message;        ///< Null-terminated text in the caller's buffer.
 } Qs_LogEntry;
 
+/// Opaque filtered, incrementally indexed view over the log history.
+typedef struct Qs_LogView Qs_LogView;
+
 /// Emits a formatted log message at the given severity.
+/// Formatting and I/O are deferred to the log writer thread: only fmt and
+/// the raw argument values (strings copied) are queued, so fmt must have
+/// static storage duration (a string literal). Never blocks on I/O.
 void qs_log(Qs_LogLevel level, const char *fmt, ...);
 
 /// Returns the severity label string for a level (e.g. "INFO").
 const char *qs_log_level_str(Qs_LogLevel level);
 
-/// Returns all buffered log entries and their count.
-/// The returned pointer is valid until the next call to qs_log() or shutdown.
-const Qs_LogEntry *qs_log_entries(uint32_t *out_count);
+/// Caps the in-memory history (default 262144 entries). History is kept in
+/// fixed-size chunks; the oldest chunk is dropped once the cap is exceeded.
+/// Dropped entries remain in the log file.
+void qs_log_set_history_limit(uint32_t max_entries);
+
+/// Sets the size at which quasar.log is rotated to quasar.1.log
+/// (default 64 MiB). 0 disables rotation.
+void qs_log_set_file_limit(uint64_t max_bytes);
+
+/// Returns the retained history as the sequence range [first, end).
+/// Entries appear once the writer thread has processed them.
+void qs_log_history_range(uint64_t *out_first, uint64_t *out_end);
+
+/// Copies entry seq into out, with its text in buf. Returns false if seq
+/// is outside the retained history.
+bool qs_log_entry_copy(uint64_t seq, Qs_LogEntry *out, char *buf, uint32_t buf_size);
+
+/// Creates a view matching every level with no text filter.
+/// A view must only be used from one thread at a time.
+Qs_LogView *qs_log_view_create(void);
+
+/// Destroys a view.
+void qs_log_view_destroy(Qs_LogView *view);
+
+/// Sets the filter: level_mask selects levels (bit n = level n), text is a
+/// case-insensitive substring (NULL or "" matches all). Resets the index.
+void qs_log_view_set_filter(Qs_LogView *view, uint32_t level_mask, const char *text);
+
+/// Indexes newly appended entries and drops evicted ones, then returns the
+/// row count. Scanning is budgeted per call; use qs_log_view_scanning() to
+/// tell whether more calls are needed to catch up. Chunks whose level
+/// counts or trigram filter rule out a match are skipped whole.
+uint32_t qs_log_view_refresh(Qs_LogView *view);
+
+/// Returns true while the view has not yet indexed the whole history.
+bool qs_log_view_scanning(const Qs_LogView *view);
+
+/// Copies the entry at row (0 = oldest match) into out, with its text in
+/// buf. Rows are as of the last refresh. Returns false if out of range or
+/// evicted since.
+bool qs_log_view_row(const Qs_LogView *view, uint32_t row,
+                     Qs_LogEntry *out, char *buf, uint32_t buf_size);
 
 /// Sets the minimum level that gets recorded. Messages below this are discarded.
 void qs_log_set_level(Qs_LogLevel min_level);
 
-/// Forces an immediate flush of the log buffer to disk.
+/// Blocks until every message queued before the call has been written to
+/// the console and flushed to disk.
 void qs_log_flush(void);
 
-/// Callback invoked whenever a log entry is appended.
+/// Callback invoked on the log writer thread after a batch of entries
+/// has been appended.
 typedef void (*Qs_LogListenerFn)(void *userdata);
 
-/// Sets a listener called after each log entry. Pass NULL to clear.
+/// Sets the append listener. Pass NULL to clear.
 void qs_log_set_listener(Qs_LogListenerFn fn, void *userdata);
 
 /* ── Convenience macros ─────────────────────────────────────── */
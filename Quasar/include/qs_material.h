@@ -9,6 +9,12 @@ typedef struct Qs_Engine     Qs_Engine;
 typedef struct Qs_Material   Qs_Material;  ///< Opaque — defined by the material backend.
 typedef struct Qs_Texture    Qs_Texture;
 
+/// Capacity of the material system; every material id is below it.
+#define QS_MAX_MATERIALS 256
+
+/// Texture slots per material (see qs_material_set_texture).
+#define QS_MATERIAL_TEXTURE_SLOTS 5
+
 /* ================================================================
    ALPHA MODE
    ================================================================ */
@@ -112,6 +118,17 @@ Qs_GpuDescriptorSet *qs_material_descriptor_set(const Qs_Material *material);
 /// Returns the descriptor set layout shared by all materials.
 Qs_GpuDescriptorSetLayout *qs_material_set_layout(void);
 
+/// Returns the bindless texture set, or NULL when descriptor indexing is
+/// not enabled on the device (see qs_gpu_descriptor_indexing_enabled).
+/// Binding 0 is a partially bound sampler2D array of QS_MAX_MATERIALS *
+/// QS_MATERIAL_TEXTURE_SLOTS elements: slot s of material id m lives at
+/// m * QS_MATERIAL_TEXTURE_SLOTS + s.  It is written alongside the
+/// per-material sets and may be updated while bound.
+Qs_GpuDescriptorSet *qs_material_bindless_set(void);
+
+/// Returns the layout of qs_material_bindless_set, or NULL without it.
+Qs_GpuDescriptorSetLayout *qs_material_bindless_set_layout(void);
+
 /// Returns the materialâ€™s PBR parameters for GPU upload.
 const Qs_PBRParams *qs_material_params(const Qs_Material *material);
 
@@ -121,6 +138,13 @@ Qs_AlphaMode qs_material_alpha_mode(const Qs_Material *material);
 /// Returns true if the material is double-sided.
 bool qs_material_double_sided(const Qs_Material *material);
 
+/// Returns a value that changes whenever the material's textures or
+/// parameters change.  Never repeats across materials.
+uint32_t qs_material_version(const Qs_Material *material);
+
+/// Returns a small index, unique among live materials, for draw sort keys.
+uint32_t qs_material_id(const Qs_Material *material);
+
 /// Updates a texture slot on an existing material and rewrites the
 /// corresponding descriptor set binding.  Slot indices:
 ///   0 = base_color, 1 = metallic_roughness, 2 = normal,
@@ -133,8 +157,9 @@ void qs_material_set_texture(Qs_Material *mat, uint32_t slot, Qs_Texture *tex);
 Qs_Texture *qs_material_get_texture(const Qs_Material *mat, uint32_t slot);
 
 /// Overwrites the material's PBR scalar parameter block.  The new values
-/// take effect on the next rendered frame (params are copied per-frame into
-/// each Qs_Renderable).  Does NOT affect texture bindings.
+/// take effect on the next rendered frame: the version bump makes scene
+/// sync re-copy params into each render proxy.  Does NOT affect texture
+/// bindings.
 void qs_material_update_params(Qs_Material *mat, const Qs_PBRParams *params);
 
 /// Returns the number of live (in-use) materials managed by the material system.
@@ -205,6 +205,32 @@ static inline void qs_m4_ortho_lrtbnf(float out[16],
     out[15] =  1.0f;
 }
 
+/* ================================================================
+   Axis-aligned bounding box
+   ================================================================ */
+
+typedef struct Qs_AABB {
+    float min[3];
+    float max[3];
+} Qs_AABB;
+
+/// Transforms a box by an affine column-major matrix and returns the
+/// tightest axis-aligned box around the result (Arvo's method).
+static inline void qs_aabb_transform(const Qs_AABB *box, const float m[16], Qs_AABB *out)
+{
+    for (int r = 0; r < 3; r++) {
+        float lo = m[12 + r], hi = m[12 + r];
+        for (int c = 0; c < 3; c++) {
+            float a = m[c*4 + r] * box->min[c];
+            float b = m[c*4 + r] * box->max[c];
+            lo += a < b ? a : b;
+            hi += a < b ? b : a;
+        }
+        out->min[r] = lo;
+        out->max[r] = hi;
+    }
+}
+
 /* ================================================================
    Quaternion → TRS matrix
    ================================================================ */
@@ -2,6 +2,7 @@
 #define QS_MESH_H
 
 #include "qs_gpu.h"
+#include "qs_math.h"
 #include <stdbool.h>
 #include <stdint.h>
 
@@ -12,7 +13,10 @@ typedef struct Qs_Mesh       Qs_Mesh;   ///< Opaque — defined by the mesh back
    VERTEX FORMAT â€” PBR-ready interleaved vertex
    ================================================================ */
 
-/// Standard PBR vertex layout: position, normal, tangent, UV.
+/// Standard PBR vertex layout: position, normal, tangent, UV.  Meshes
+/// store it as two streams — positions (QS_VERTEX_POSITION_STRIDE bytes
+/// per vertex) and Qs_VertexAttributes — so that depth-only passes fetch
+/// positions alone.
 typedef struct Qs_Vertex {
     float position[3];    ///< World-space position.
     float normal[3];      ///< Unit normal vector.
@@ -20,6 +24,16 @@ typedef struct Qs_Vertex {
     float uv[2];          ///< Texture coordinates.
 } Qs_Vertex;
 
+/// Everything in Qs_Vertex but the position: the attribute stream.
+typedef struct Qs_VertexAttributes {
+    float normal[3];
+    float tangent[4];
+    float uv[2];
+} Qs_VertexAttributes;
+
+/// Bytes per vertex in the position stream (xyz).
+#define QS_VERTEX_POSITION_STRIDE (3 * sizeof(float))
+
 /// Index type for mesh indices.
 typedef enum Qs_IndexType {
     QS_INDEX_TYPE_UINT16 = 0,
@@ -32,12 +46,15 @@ typedef enum Qs_IndexType {
 
 /// Configuration for creating a GPU mesh.
 typedef struct Qs_MeshDesc {
-    const char       *name;           ///< Debug label.
-    const Qs_Vertex  *vertices;       ///< Vertex array.
-    uint32_t          vertex_count;
-    const void       *indices;        ///< Index array (uint16_t or uint32_t).
-    uint32_t          index_count;
-    Qs_IndexType      index_type;     ///< Default: UINT32.
+    const char                *name;         ///< Debug label.
+    const Qs_Vertex           *vertices;     ///< Interleaved, split on upload.  NULL = the streams below.
+    const float               *positions;    ///< xyz per vertex, when vertices is NULL.
+    const Qs_VertexAttributes *attributes;   ///< One per vertex, when vertices is NULL.
+    uint32_t                   vertex_count;
+    const void                *indices;      ///< Index array (uint16_t or uint32_t).
+    uint32_t                   index_count;
+    Qs_IndexType               index_type;   ///< Default: UINT32.
+    const Qs_AABB             *bounds;       ///< Local-space bounds. NULL = computed from vertices.
 } Qs_MeshDesc;
 
 /* ================================================================
@@ -59,14 +76,23 @@ uint32_t qs_mesh_vertex_count(const Qs_Mesh *mesh);
 /// Returns the number of indices (0 if non-indexed).
 uint32_t qs_mesh_index_count(const Qs_Mesh *mesh);
 
-/// Binds vertex and index buffers to a command buffer.
+/// Returns the local-space bounding box. NULL if mesh is NULL.
+const Qs_AABB *qs_mesh_bounds(const Qs_Mesh *mesh);
+
+/// Returns a small index, unique among live meshes, for draw sort keys.
+uint32_t qs_mesh_id(const Qs_Mesh *mesh);
+
+/// Binds the position (binding 0), attribute (binding 1) and index buffers.
 void qs_mesh_bind(const Qs_Mesh *mesh, Qs_GpuCmd *cmd);
 
 /// Binds and issues the draw call.
 void qs_mesh_draw(const Qs_Mesh *mesh, Qs_GpuCmd *cmd);
 
-/// Returns the GPU vertex buffer.  Used by the engine to pack renderables.
-Qs_GpuBuffer *qs_mesh_vertex_buffer(const Qs_Mesh *mesh);
+/// Returns the GPU position stream.  Used by the engine to pack renderables.
+Qs_GpuBuffer *qs_mesh_position_buffer(const Qs_Mesh *mesh);
+
+/// Returns the GPU attribute stream (Qs_VertexAttributes per vertex).
+Qs_GpuBuffer *qs_mesh_attribute_buffer(const Qs_Mesh *mesh);
 
 /// Returns the GPU index buffer, or NULL if the mesh is non-indexed.
 Qs_GpuBuffer *qs_mesh_index_buffer(const Qs_Mesh *mesh);
@@ -0,0 +1,76 @@
+#ifndef QS_OCCLUSION_H
+#define QS_OCCLUSION_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "qs_cull.h"
+#include "qs_job.h"
+
+/* ================================================================
+   SOFTWARE OCCLUSION CULLING
+   Masked occlusion: occluder triangles are rasterized at low resolution
+   into tiles that each keep a per-pixel coverage mask and two depths —
+   a conservative farthest depth for the whole tile and the farthest
+   depth of the partially covered layer being built up.  Boxes are then
+   tested against the tile depths.  Pure CPU code — no GPU context
+   required, so it can be driven with synthetic cameras and geometry.
+   ================================================================ */
+
+/// Tile size in pixels; one 64-bit coverage mask per tile.
+#define QS_OCCLUSION_TILE_WIDTH  8
+#define QS_OCCLUSION_TILE_HEIGHT 8
+
+/// Tile rows rasterized per job when a job system is given.
+#define QS_OCCLUSION_BAND_TILE_ROWS 2
+
+/// Model-space occluder geometry: an indexed triangle list.  Usually a
+/// low-poly stand-in lying inside the rendered mesh, since whatever it
+/// covers is assumed hidden.  Both windings are rasterized.
+typedef struct Qs_OccluderMesh {
+    const float    *positions;     ///< xyz per vertex.
+    const uint32_t *indices;       ///< Three per triangle.
+    uint32_t        vertex_count;
+    uint32_t        index_count;
+} Qs_OccluderMesh;
+
+/// Opaque tiled depth buffer plus the occluder triangles queued for it.
+typedef struct Qs_OcclusionBuffer Qs_OcclusionBuffer;
+
+/// Creates a buffer of width x height pixels, both multiples of the
+/// tile size.  NULL on failure.
+Qs_OcclusionBuffer *qs_occlusion_create(uint32_t width, uint32_t height);
+
+/// Frees the buffer.  Must not be called while a rasterize is running.
+void qs_occlusion_destroy(Qs_OcclusionBuffer *buffer);
+
+/// Returns the pixel size the buffer was created with.
+void qs_occlusion_size(const Qs_OcclusionBuffer *buffer,
+                       uint32_t *out_width, uint32_t *out_height);
+
+/// Empties the depth tiles and the triangle queue for a new view.
+void qs_occlusion_clear(Qs_OcclusionBuffer *buffer);
+
+/// Transforms mesh by the column-major clip_from_model matrix (a
+/// view-projection times a model matrix, [-1,1] clip depth), clips it to
+/// the view frustum and queues the surviving triangles.  Returns false
+/// when the queue cannot grow; triangles queued so far are kept.
+bool qs_occlusion_add(Qs_OcclusionBuffer *buffer, const Qs_OccluderMesh *mesh,
+                      const float clip_from_model[16]);
+
+/// Rasterizes the queued triangles into the tiles and empties the queue.
+/// With a job system the tiles are split into bands of
+/// QS_OCCLUSION_BAND_TILE_ROWS rows rasterized in parallel; with NULL
+/// everything runs on the calling thread.
+void qs_occlusion_rasterize(Qs_OcclusionBuffer *buffer, Qs_JobSystem *jobs);
+
+/// Tests the boxes of bounds listed in candidates against the rasterized
+/// occluders and writes the indices of those not provably hidden to
+/// out_visible, keeping their order.  out_visible may alias candidates.
+/// view_proj must be the matrix the occluders were added with, minus the
+/// model matrices.  Returns the number of visible boxes.
+uint32_t qs_occlusion_cull(const Qs_OcclusionBuffer *buffer, const float view_proj[16],
+                           const Qs_CullBounds *bounds, const uint32_t *candidates,
+                           uint32_t count, uint32_t *out_visible);
+
+#endif
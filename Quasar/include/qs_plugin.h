@@ -80,6 +80,10 @@ Qs_PluginManager *qs_plugin_manager_create(Qs_Engine *engine,
 /// Call once after the core engine systems (Log, Job, Event, Input) are
 /// registered and before Scene is registered, so that renderer plugins can
 /// register their systems in the correct order.
+/// Libraries are opened and their entry points resolved concurrently on the
+/// job system, so static initialisers and QS_PLUGIN_ENTRY_SYMBOL must not
+/// touch engine state. on_load then runs on the calling thread in discovery
+/// order.
 void qs_plugin_manager_scan(Qs_PluginManager *pm);
 
 /// Calls on_unload for every loaded plugin in reverse load order,
@@ -0,0 +1,90 @@
+#ifndef QS_RENDER_GRAPH_H
+#define QS_RENDER_GRAPH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "qs_gpu.h"
+
+/* ================================================================
+   RENDER GRAPH COMPILER
+   Passes declare the images they read and write; compiling orders the
+   passes, drops those whose results nobody consumes, derives the
+   layout transitions between them and packs transient images with
+   disjoint lifetimes into one shared memory heap.
+   Pure CPU code — no GPU context required, so plans can be checked
+   with synthetic passes and memory requirements.
+   ================================================================ */
+
+/// Pass and resource sets are uint32_t masks, so neither limit may exceed 32.
+#define QS_RG_MAX_PASSES     32
+#define QS_RG_MAX_RESOURCES  32
+#define QS_RG_MAX_ACCESSES   8
+#define QS_RG_MAX_BARRIERS   (QS_RG_MAX_PASSES * QS_RG_MAX_ACCESSES + QS_RG_MAX_RESOURCES)
+
+/// Qs_RgPlan.heap_offset of a resource that is not placed in the heap.
+#define QS_RG_NOT_ALIASED    UINT64_MAX
+
+/// One image a pass touches.  COLOR_ATTACHMENT and DEPTH_ATTACHMENT
+/// layouts write; every other layout reads.
+typedef struct Qs_RgAccess {
+    uint32_t          resource;
+    Qs_GpuImageLayout layout;
+} Qs_RgAccess;
+
+/// A pass in declaration order; ties in the dependency order keep it.
+/// A pass without accesses is opaque: it stays ordered against every
+/// other pass and is never culled.
+typedef struct Qs_RgPass {
+    Qs_RgAccess accesses[QS_RG_MAX_ACCESSES];
+    uint32_t    access_count;
+    bool        side_effects;   ///< Writes outside the graph (e.g. the swapchain); never culled.
+} Qs_RgPass;
+
+typedef struct Qs_RgResource {
+    /// Contents live within one frame: the first access discards them and
+    /// the memory may be shared with other transients.  Persistent
+    /// resources keep their contents and are never aliased.
+    bool              transient;
+    /// Persistent: layout held between frames.  Ignored for transients.
+    Qs_GpuImageLayout layout;
+    /// Transient: memory the image needs at its current size.
+    uint64_t          size;
+    uint64_t          alignment;
+    uint32_t          type_bits;
+} Qs_RgResource;
+
+typedef struct Qs_RgBarrier {
+    uint32_t          resource;
+    Qs_GpuImageLayout old_layout;
+    Qs_GpuImageLayout new_layout;
+    /// old_layout UNDEFINED: layout the memory's previous occupant ends in
+    /// (see Qs_GpuImageBarrier.wait_layout).
+    Qs_GpuImageLayout wait_layout;
+} Qs_RgBarrier;
+
+typedef struct Qs_RgPlan {
+    /// Surviving passes in execution order (indices into the pass array).
+    uint32_t     order[QS_RG_MAX_PASSES];
+    uint32_t     order_count;
+    /// barriers[barrier_start[i] .. barrier_start[i + 1]) are recorded
+    /// before order[i]; the range starting at barrier_start[order_count]
+    /// runs after the last pass and restores persistent layouts.
+    uint32_t     barrier_start[QS_RG_MAX_PASSES + 1];
+    Qs_RgBarrier barriers[QS_RG_MAX_BARRIERS];
+    uint32_t     barrier_count;
+    /// Per resource: byte offset in the transient heap, or
+    /// QS_RG_NOT_ALIASED for persistent resources and transients whose
+    /// memory types exclude the heap's (they need dedicated memory).
+    uint64_t     heap_offset[QS_RG_MAX_RESOURCES];
+    uint64_t     heap_size;
+    uint32_t     heap_type_bits;
+} Qs_RgPlan;
+
+/// Compiles passes over resources into out.  Returns false when a count
+/// or index is out of range or the declared dependencies form a cycle.
+bool qs_render_graph_compile(const Qs_RgResource *resources, uint32_t resource_count,
+                             const Qs_RgPass *passes, uint32_t pass_count,
+                             Qs_RgPlan *out);
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef QS_RENDER_THREAD_H
+#define QS_RENDER_THREAD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* ================================================================
+   RENDER SNAPSHOT HANDOFF
+   Passes render snapshots from the simulation to the recorder without
+   either side waiting on the other.  Snapshots are indices into a
+   caller-owned array of QS_RENDER_HANDOFF_SNAPSHOTS; each role touches
+   only the snapshot it currently holds.
+
+     no render thread:  write -> ready -> record
+     render thread:     write -> ready -> prepare -> prepared -> record
+
+   Every arrow is a swap under the handoff mutex.  A role that finds
+   nothing new keeps the snapshot it holds, so the recorder redraws its
+   last snapshot and an unconsumed one is overwritten by the next.
+   ================================================================ */
+
+#define QS_RENDER_HANDOFF_SNAPSHOTS 5
+
+/// Runs on the render thread for each snapshot it takes.  The snapshot
+/// goes to the recorder when the call returns.
+typedef void (*Qs_RenderPrepareFn)(uint32_t snapshot, void *user_data);
+
+typedef struct Qs_RenderHandoff Qs_RenderHandoff;
+
+/// prepare = NULL hands published snapshots straight to the recorder
+/// and uses only three of them.  Otherwise starts a render thread that
+/// calls prepare on every snapshot before the recorder sees it.
+Qs_RenderHandoff *qs_render_handoff_create(Qs_RenderPrepareFn prepare, void *user_data);
+
+/// Stops and joins the render thread once its current prepare returns.
+void qs_render_handoff_destroy(Qs_RenderHandoff *handoff);
+
+/// True when a render thread prepares the snapshots.
+bool qs_render_handoff_threaded(const Qs_RenderHandoff *handoff);
+
+/// Simulation side: the snapshot to fill before the next publish.
+uint32_t qs_render_handoff_write_index(const Qs_RenderHandoff *handoff);
+
+/// Simulation side: hands the write snapshot on and returns the next
+/// one to fill.  Wakes the render thread.
+uint32_t qs_render_handoff_publish(Qs_RenderHandoff *handoff);
+
+/// Recorder side: takes the newest snapshot ready to record and returns
+/// it, or keeps the held one when nothing newer is ready.  The returned
+/// snapshot stays put until the next acquire.
+uint32_t qs_render_handoff_acquire(Qs_RenderHandoff *handoff);
+
+/// Blocks until the render thread has prepared everything published so
+/// far.  Returns at once without a render thread.
+void qs_render_handoff_flush(Qs_RenderHandoff *handoff);
+
+#endif /* QS_RENDER_THREAD_H */
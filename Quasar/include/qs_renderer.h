@@ -4,6 +4,8 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "qs_cull.h"
+#include "qs_occlusion.h"
 #include "qs_gpu.h"
 #include "qs_light.h"
 #include "qs_mesh.h"
@@ -55,66 +57,84 @@ typedef struct Qs_FrameUBO {
     float    _pad;
 } Qs_FrameUBO; /* 224 bytes, std140 */
 
-#define QS_LIGHTS_MAX 128
+#define QS_LIGHTS_MAX 4096
 
-/// Per-frame lights uniform block written by the engine each frame.
-typedef struct Qs_LightsUBO {
-    Qs_LightGPU lights[QS_LIGHTS_MAX];
+/// Per-frame lights storage buffer (std430) written by the engine each
+/// frame.  Only the first count lights are uploaded.
+typedef struct Qs_LightsBuffer {
     uint32_t    count;
     uint32_t    _pad[3];
-} Qs_LightsUBO;
+    Qs_LightGPU lights[QS_LIGHTS_MAX];
+} Qs_LightsBuffer;
 
 /* ================================================================
    RENDERABLE
 
-   Qs_RenderableDesc  — submission struct; caller provides Qs_Mesh / Qs_Material.
+   Qs_RenderableDesc  — proxy creation struct; caller provides Qs_Mesh / Qs_Material.
    Qs_Renderable      — GPU-packed struct the engine stores and passes to plugins.
                          The engine extracts vertex/index buffers and material
-                         descriptor data at submit time so pass nodes never need
-                         to call into the mesh or material systems directly.
+                         descriptor data when a proxy is created or its geometry
+                         changes so pass nodes never need to call into the mesh
+                         or material systems directly.
    ================================================================ */
 
-typedef struct Qs_AABB {
-    float min[3];
-    float max[3];
-} Qs_AABB;
+/// Handle to a persistent renderable owned by a Qs_Renderer.
+typedef uint32_t Qs_RenderProxy;
+#define QS_RENDER_PROXY_INVALID UINT32_MAX
 
-/// Submission descriptor — fill this and pass to qs_renderer_submit_renderable.
+/// Proxy descriptor — fill this and pass to qs_renderer_proxy_create.
 typedef struct Qs_RenderableDesc {
     Qs_Mesh     *mesh;              ///< Required.
     Qs_Material *material;          ///< NULL → engine uses the renderer default material.
     float        transform[16];     ///< Column-major model matrix.
     Qs_AABB      bounds;            ///< World-space AABB for engine-side culling.
+    float        tint[4];           ///< Per-instance RGBA multiplier; {1,1,1,1} = none.
     Qs_Entity    entity;            ///< Source entity for GPU picking.
     bool         cast_shadows;
     bool         receive_shadows;
+    const Qs_OccluderMesh *occluder; ///< NULL = not an occluder; see qs_renderer_proxy_set_occluder.
 } Qs_RenderableDesc;
 
 /// GPU-packed renderable — populated by the engine; passed to render-pass nodes
 /// via Qs_RenderContext.renderables.  Pass nodes work at the GPU command level
-/// and do not need to access the mesh or material systems.
+/// and do not need to access the mesh or material systems.  Holds the data
+/// that only changes with the mesh or material; the model matrix lives in
+/// the parallel Qs_RenderContext.transforms array.
 typedef struct Qs_Renderable {
     /* Mesh — extracted from Qs_Mesh at submit time */
-    Qs_GpuBuffer *vertex_buffer;
+    Qs_GpuBuffer *position_buffer;  ///< Binding 0, xyz; all depth-only passes read.
+    Qs_GpuBuffer *attribute_buffer; ///< Binding 1, Qs_VertexAttributes.
     Qs_GpuBuffer *index_buffer;     ///< NULL for non-indexed meshes.
     uint32_t      vertex_count;
     uint32_t      index_count;
     bool          index_16bit;      ///< true = UINT16, false = UINT32.
+    uint32_t      mesh_id;          ///< qs_mesh_id — groups draws in sort keys.
 
     /* Material — extracted from Qs_Material (or renderer default) at submit time */
     Qs_GpuDescriptorSet *material_set;    ///< Ready-to-bind descriptor set.
     Qs_PBRParams         material_params; ///< Value copy; safe across frames.
     Qs_AlphaMode         alpha_mode;
     bool                 double_sided;
+    uint32_t             material_id;     ///< qs_material_id — groups draws in sort keys.
+    float                tint[4];         ///< Per-instance RGBA multiplier on base color.
 
-    /* Transform and visibility */
-    float    transform[16];  ///< Column-major model matrix.
-    Qs_AABB  bounds;         ///< World-space AABB.
     Qs_Entity entity;        ///< Source entity for GPU picking.
     bool     cast_shadows;
     bool     receive_shadows;
+    const Qs_OccluderMesh *occluder; ///< Software occlusion stand-in; NULL = none.
 } Qs_Renderable;
 
+/// Per-frame culling and draw counters, refreshed on every render.
+typedef struct Qs_RenderStats {
+    uint32_t renderables;   ///< Live render proxies.
+    uint32_t visible;       ///< Inside the camera frustum and not occluded.
+    uint32_t culled;        ///< Rejected by the camera frustum.
+    uint32_t occluded;      ///< Inside the frustum but hidden behind occluders.
+    uint32_t draws;         ///< Draw calls recorded by pass nodes.
+    uint32_t binds;         ///< Pipeline / descriptor / buffer binds issued.
+    uint32_t binds_skipped; ///< Binds elided because sorted neighbours shared state.
+} Qs_RenderStats;
+
 /* ================================================================
    RENDER ATTACHMENT â€” engine-managed off-screen image
    ================================================================ */
@@ -137,26 +157,65 @@ typedef struct Qs_RenderAttachmentDesc {
     /// Fixed pixel size.  When > 0, overrides scale; image is never resized.
     uint32_t                   fixed_width;
     uint32_t                   fixed_height;
+    /// Contents live within one frame, so the image may share memory with
+    /// transients used by other nodes.  Only nodes declaring it as an
+    /// access may touch it.  The image is created on the first resize and
+    /// recreated whenever the render graph is rebuilt, each time followed
+    /// by renderer_on_resize.
+    bool                       transient;
+    /// Also usable as a qs_cmd_copy_image destination.
+    bool                       copy_dst;
 } Qs_RenderAttachmentDesc;
 
 /* ================================================================
    RENDER PASS NODE â€” pipeline phase
    ================================================================ */
 
+/// Frames the CPU may record ahead of the GPU.  Per-frame GPU data that
+/// nodes rewrite every frame must be ringed by Qs_RenderContext.frame_slot.
+#define QS_RENDER_FRAMES_IN_FLIGHT 2
+
 /// Context supplied to every render-pass node callback each frame.
 typedef struct Qs_RenderContext {
     Qs_Renderer        *renderer;
     Qs_GpuCmd          *cmd;
+    /// Frame-in-flight slot (< QS_RENDER_FRAMES_IN_FLIGHT).  The GPU has
+    /// finished the previous frame recorded with this slot.
+    uint32_t            frame_slot;
     uint32_t            width;
     uint32_t            height;
     float               view[16];
     float               proj[16];
     float               dt;
+    /// Camera and render settings as of the published snapshot.  Read
+    /// these rather than the live qs_renderer_camera / _wireframe.
+    const Qs_Camera    *camera;
+    bool                wireframe;
 
-    /// Engine-populated renderable list for this frame.
+    /// Renderable list of the published snapshot.  transforms[i] is the
+    /// column-major model matrix of renderables[i].
     const Qs_Renderable *renderables;
+    const float        (*transforms)[16];
     uint32_t             renderable_count;
 
+    /// Indices into renderables whose bounds intersect the camera frustum
+    /// and are not hidden behind occluders, ascending.  Shadow passes
+    /// should walk the full list instead since off-screen and occluded
+    /// objects can still cast into view.
+    const uint32_t      *visible;
+    uint32_t             visible_count;
+
+    /// World-space bounds of renderables[i], structure-of-arrays.
+    const Qs_CullBounds *bounds;
+
+    /// Indices into renderables whose transform, bounds, tint or geometry
+    /// changed since the previously rendered snapshot, including proxies
+    /// created or moved by a destroy.  Ascending; empty when the same
+    /// snapshot is rendered again.  Nodes that mirror renderables on the
+    /// GPU upload only these.
+    const uint32_t      *dirty;
+    uint32_t             dirty_count;
+
     /// Engine-populated GPU-packed light list for this frame.
     const Qs_LightGPU   *lights;
     uint32_t             light_count;
@@ -169,11 +228,30 @@ typedef struct Qs_RenderContext {
 
 typedef void (*Qs_RenderNodeFn)(const Qs_RenderContext *ctx, void *user_data);
 
+#define QS_RENDER_NODE_ACCESSES_MAX 8
+
+/// An attachment a node samples (SHADER_READ) or renders to
+/// (COLOR_ATTACHMENT / DEPTH_ATTACHMENT).
+typedef struct Qs_RenderAccess {
+    Qs_RenderAttachment *attachment;
+    Qs_GpuImageLayout    layout;
+} Qs_RenderAccess;
+
 typedef struct Qs_RenderNodeDesc {
     const char      *name;
     int32_t          priority; ///< Execution order â€” lower runs first.
     Qs_RenderNodeFn  execute;
     void            *user_data;
+    /// Attachments the node touches (copied).  Nodes run in dependency
+    /// order of these, ties broken by priority; the renderer records each
+    /// node's layout transitions before it runs and skips nodes whose
+    /// writes no surviving node reads.  A node declaring none runs in
+    /// priority order against every other node and is never skipped.
+    const Qs_RenderAccess *accesses;
+    uint32_t               access_count;   ///< At most QS_RENDER_NODE_ACCESSES_MAX.
+    /// Writes outside its declared attachments (e.g. the swapchain), so
+    /// it is never skipped.
+    bool                   side_effects;
 } Qs_RenderNodeDesc;
 
 /* ================================================================
@@ -189,6 +267,10 @@ typedef struct Qs_RendererDesc {
     /// Optional PBR material used when a submitted renderable has no material.
     /// If NULL the engine creates a built-in grey dielectric fallback.
     const Qs_MaterialDesc *default_material;
+    /// Cull published snapshots (frustum and occlusion) on a dedicated
+    /// render thread, overlapping the next frame's simulation.  Frames
+    /// then draw the newest snapshot the thread has finished.
+    bool         render_thread;
 } Qs_RendererDesc;
 
 /* ================================================================
@@ -212,8 +294,9 @@ typedef struct Qs_RendererBackend {
                                const Qs_RendererDesc *desc, Qs_Renderer *handle);
     void  (*renderer_destroy)(void *ctx, void *impl);
 
-    /// Called after the engine has resized all viewport-scaled attachments.
-    /// Backend should re-write descriptor sets that reference those image views.
+    /// Called after the engine has recreated viewport-scaled and transient
+    /// attachments.  Backend should re-write descriptor sets that reference
+    /// those image views.
     void  (*renderer_on_resize)(void *ctx, void *impl, uint32_t w, uint32_t h);
 } Qs_RendererBackend;
 
@@ -261,30 +344,121 @@ Qs_RenderAttachment *qs_renderer_add_attachment(Qs_Renderer *renderer,
 Qs_GpuImageView     *qs_attachment_view (const Qs_RenderAttachment *att);
 Qs_GpuImage         *qs_attachment_image(const Qs_RenderAttachment *att);
 
-/// Engine-managed depth buffer view (NULL when depth_test=false).
+/// Engine-managed depth buffer view (NULL when depth_test=false).  The
+/// image is also sampled, so passes may read the depth they wrote.
 Qs_GpuImageView *qs_renderer_depth_view(const Qs_Renderer *renderer);
+/// The image behind qs_renderer_depth_view, for barriers between passes.
+/// It rests in DEPTH_ATTACHMENT from creation on; a pass that moves it to
+/// another layout must return it there.
+Qs_GpuImage     *qs_renderer_depth_image(const Qs_Renderer *renderer);
 
 /* ================================================================
    ENGINE UBO ACCESSORS
-   Return the engine-owned per-frame UBO handles so backends can
-   write descriptor sets that reference them during renderer_create.
+   Return the engine-owned per-frame buffer handles of a frame-in-flight
+   slot so backends can write one descriptor set per slot during
+   renderer_create.
    ================================================================ */
 
-Qs_GpuBuffer *qs_renderer_get_frame_ubo (const Qs_Renderer *renderer);
-Qs_GpuBuffer *qs_renderer_get_lights_ubo(const Qs_Renderer *renderer);
+Qs_GpuBuffer *qs_renderer_get_frame_ubo (const Qs_Renderer *renderer, uint32_t slot);
+Qs_GpuBuffer *qs_renderer_get_lights_buffer(const Qs_Renderer *renderer, uint32_t slot);
+
+/* ================================================================
+   PER-FRAME ALLOCATION
+   ================================================================ */
+
+/// A range of the current frame slot's persistently mapped,
+/// host-coherent arena.  Valid until the slot comes round again.
+typedef struct Qs_FrameAlloc {
+    void         *data;
+    Qs_GpuBuffer *buffer;
+    uint64_t      offset;   ///< Aligned for uniform and storage descriptors.
+} Qs_FrameAlloc;
+
+/// Bump-allocates size bytes of dynamic uniform, storage, vertex, index
+/// or indirect data for this frame.  Call from node callbacks only (not
+/// from qs_renderer_record_draws ranges).  Returns false on exhaustion.
+bool qs_renderer_frame_alloc(const Qs_RenderContext *ctx, uint64_t size,
+                             Qs_FrameAlloc *out);
 
 /* ================================================================
-   RENDERABLE / LIGHT SUBMISSION
+   RENDER PROXIES / LIGHT SUBMISSION
+   Renderables persist across frames: create a proxy once, update it
+   only when its transform or geometry changes, destroy it when the
+   source object goes away.
    ================================================================ */
 
-/// Submit a renderable for this frame.  The engine extracts GPU handles from
-/// desc->mesh and desc->material and stores a GPU-packed Qs_Renderable
-/// internally.  If desc->material is NULL the renderer default material is used.
-void                  qs_renderer_submit_renderable (Qs_Renderer *renderer,
-                                                      const Qs_RenderableDesc *desc);
-void                  qs_renderer_clear_renderables (Qs_Renderer *renderer);
-const Qs_Renderable  *qs_renderer_renderables       (const Qs_Renderer *renderer,
-                                                      uint32_t *out_count);
+/// Publishes the camera, render settings, lights and proxies as an
+/// immutable snapshot for the render side.  Call once per frame after
+/// the scene has been synced.  Renders draw the newest snapshot, so
+/// the simulation may mutate the renderer while a frame is recorded
+/// from a snapshot on another thread; nothing is drawn before the
+/// first publish.  Only proxies changed since a snapshot buffer was
+/// last written are copied into it.  With Qs_RendererDesc.render_thread
+/// the snapshot is culled on the render thread before it is drawn.
+void qs_renderer_publish(Qs_Renderer *renderer);
+
+/// Creates a persistent renderable.  The engine extracts GPU handles from
+/// desc->mesh and desc->material into a GPU-packed Qs_Renderable.  If
+/// desc->material is NULL the renderer default material is used.
+/// Returns QS_RENDER_PROXY_INVALID on failure.
+Qs_RenderProxy qs_renderer_proxy_create(Qs_Renderer *renderer,
+                                        const Qs_RenderableDesc *desc);
+void           qs_renderer_proxy_destroy(Qs_Renderer *renderer, Qs_RenderProxy proxy);
+bool           qs_renderer_proxy_valid  (const Qs_Renderer *renderer, Qs_RenderProxy proxy);
+
+/// Updates the model matrix and world-space bounds of a proxy.
+void qs_renderer_proxy_set_transform(Qs_Renderer *renderer, Qs_RenderProxy proxy,
+                                     const float transform[16], const Qs_AABB *bounds);
+
+/// Updates the per-instance tint of a proxy.
+void qs_renderer_proxy_set_tint(Qs_Renderer *renderer, Qs_RenderProxy proxy,
+                                const float tint[4]);
+
+/// Makes a proxy an occluder: occluder is rasterized on the CPU with
+/// the proxy's model matrix each frame the proxy is in view, and
+/// visible proxies whose bounds it hides are dropped from
+/// Qs_RenderContext.visible.  NULL = not an occluder.  The mesh is not
+/// copied: keep it alive and unchanged while a snapshot may reference
+/// it, i.e. for the lifetime of the renderer.
+void qs_renderer_proxy_set_occluder(Qs_Renderer *renderer, Qs_RenderProxy proxy,
+                                    const Qs_OccluderMesh *occluder);
+
+/// Re-extracts mesh and material data, e.g. after a reassignment or a
+/// qs_material_update_params call.  NULL material = renderer default.
+void qs_renderer_proxy_set_geometry(Qs_Renderer *renderer, Qs_RenderProxy proxy,
+                                    Qs_Mesh *mesh, Qs_Material *material);
+
+/// Returns the live renderables in dense order (not stable across
+/// proxy destruction).  out_transforms may be NULL.
+const Qs_Renderable  *qs_renderer_renderables(const Qs_Renderer *renderer,
+                                               const float (**out_transforms)[16],
+                                               uint32_t *out_count);
+const Qs_RenderStats *qs_renderer_stats      (const Qs_Renderer *renderer);
+
+/// Accumulates a pass node's draw and bind counts into this frame's stats.
+void qs_renderer_add_draw_stats(Qs_Renderer *renderer, uint32_t draws,
+                                uint32_t binds, uint32_t binds_skipped);
+
+/// Upper bound on the ranges qs_renderer_record_draws splits a pass into.
+#define QS_RENDER_RECORD_RANGES_MAX 32
+
+/// Records draws [begin, end) of a pass into cmd.  range (below
+/// QS_RENDER_RECORD_RANGES_MAX) indexes the caller's per-range state;
+/// ranges of one pass may run concurrently on job workers.
+typedef void (*Qs_RecordRangeFn)(Qs_GpuCmd *cmd, uint32_t range,
+                                 uint32_t begin, uint32_t end, void *user_data);
+
+/// Begins rendering into target, records draws [0, count) through fn with
+/// the viewport covering the target, and ends rendering.  Large passes are
+/// split into contiguous ranges recorded in parallel into secondary
+/// command buffers, one command pool per worker slot, and replayed in
+/// range order so the result matches a serial recording.  fn must bind
+/// every pipeline and descriptor set it draws with.  Returns the number
+/// of ranges used.
+uint32_t qs_renderer_record_draws(const Qs_RenderContext *ctx,
+                                  const Qs_GpuRenderTarget *target,
+                                  uint32_t count, Qs_RecordRangeFn fn,
+                                  void *user_data);
 
 void               qs_renderer_submit_light    (Qs_Renderer *renderer, Qs_Light *light);
 void               qs_renderer_submit_light_comp(Qs_Renderer *renderer,
@@ -15,6 +15,7 @@ typedef struct Qs_TypeInfo       Qs_TypeInfo;
 typedef struct Qs_Mesh           Qs_Mesh;
 typedef struct Qs_Material       Qs_Material;
 typedef struct Qs_Project        Qs_Project;
+typedef struct Qs_Renderer       Qs_Renderer;
 struct cJSON;
 
 /* ================================================================
@@ -90,8 +91,16 @@ typedef struct Qs_MeshComp {
     Qs_Mesh     *mesh;             ///< Resolved at load (runtime-only).
     Qs_Material *material;         ///< Resolved at load (runtime-only).
     bool         visible;          ///< Default: true.
+    float        tint[4];          ///< Per-instance RGBA multiplier. Default: {1, 1, 1, 1}.
     char         mesh_path[256];   ///< Project-relative or scene-relative .qsmesh path.
     char         material_path[256];///< Project-relative or scene-relative .qsmat path.
+    /* ---- runtime fields (not serialized via reflection) ---- */
+    Qs_Renderer       *proxy_renderer;   ///< Renderer holding `proxy`; NULL = none.
+    uint32_t           proxy;            ///< Qs_RenderProxy handle.
+    const Qs_Mesh     *proxy_mesh;       ///< Mesh the proxy was extracted from.
+    const Qs_Material *proxy_material;   ///< Material the proxy was extracted from.
+    uint32_t           proxy_material_version;
+    float              proxy_tint[4];    ///< Tint last pushed to the proxy.
 } Qs_MeshComp;
 
 /// Light component — all parameters stored inline for reflection, serialization,
@@ -383,18 +392,22 @@ void qs_scene_world_matrix(const Qs_Scene *scene, Qs_Entity entity,
 /* ================================================================
    RENDERING SUBMISSION
    ================================================================
-   Scenes know how to submit their renderables and lights to a
-   renderer.  PrototypeComp entities recurse into their inner scene,
-   composing the parent's world matrix so nested prototypes render
-   correctly.
+   Each visible MeshComp owns a persistent render proxy in the
+   renderer.  Scenes cache world matrices between syncs and only push
+   transforms, mesh or material data for proxies whose source changed,
+   so a static scene costs one compare per entity.  PrototypeComp
+   entities recurse into their inner scene, composing the parent's
+   world matrix so nested prototypes render correctly.  Deactivating a
+   scene releases its proxies.
    ================================================================ */
 
-typedef struct Qs_Renderer Qs_Renderer;
-
-/// Submit every visible MeshComp + LightComp entity in `scene` (and
-/// recursively in nested PrototypeComp scenes) to `renderer`.
-/// `parent_world` is the world matrix to compose with each entity's
-/// local transform — pass an identity matrix for top-level scenes.
+/// Syncs render proxies for every MeshComp in `scene` (and recursively in
+/// nested PrototypeComp scenes) with `renderer`, and submits LightComp
+/// entities for this frame.  `parent_world` is the world matrix to compose
+/// with each entity's local transform — pass NULL for top-level scenes.
+/// Transform and bounds extraction is spread across the engine's job
+/// system; renderer calls stay on the calling thread.  Reentrant for
+/// distinct root scenes.
 void qs_scene_submit_renderables(Qs_Scene *scene,
                                  Qs_Engine *engine,
                                  Qs_Renderer *renderer,
@@ -90,6 +90,32 @@ void qs_engine_set_project(Qs_Engine* engine, Qs_Project* project);
 /// Returns the active project handle, or NULL if none is set.
 Qs_Project* qs_engine_project(Qs_Engine* engine);
 
+/// One timed step of engine startup: a system init, a plugin library open
+/// or on_load, or an engine-level phase. Nested steps overlap their parent.
+typedef struct Qs_StartupEntry {
+    char        name[64];     ///< System name, plugin file/name, or phase label.
+    const char* category;     ///< "engine", "system", "plugin.open" or "plugin.load".
+    uint64_t    start_ns;     ///< Offset from the start of qs_engine_create.
+    uint64_t    duration_ns;
+    uint32_t    thread;       ///< 0 = main thread; >0 = job worker that ran the step.
+} Qs_StartupEntry;
+
+/// Returns the number of steps recorded while qs_engine_create ran.
+uint32_t qs_engine_startup_count(const Qs_Engine* engine);
+
+/// Returns startup step idx, in the order the steps began. NULL if out of range.
+const Qs_StartupEntry* qs_engine_startup_entry(const Qs_Engine* engine, uint32_t idx);
+
+/// Returns the wall-clock time qs_engine_create took.
+uint64_t qs_engine_startup_total_ns(const Qs_Engine* engine);
+
+/// Writes the startup timeline to path as Chrome Trace Event JSON
+/// (loadable in Perfetto or chrome://tracing). Returns false on I/O failure.
+bool qs_engine_startup_dump(const Qs_Engine* engine, const char* path);
+
+/// Returns a monotonic clock in nanoseconds, for measuring durations.
+uint64_t qs_clock_ns(void);
+
 /// Wakes the event loop from another thread.
 void qs_engine_wake(void);
 
@@ -2,6 +2,7 @@
 #include "qs_plugin.h"
 #include "qs_ext.h"
 #include "qs_dylib.h"
+#include "qs_trace_internal.h"
 
 #ifdef _WIN32
   #ifndef WIN32_LEAN_AND_MEAN
@@ -16,6 +17,10 @@
 #define QS_VERSION_MINOR 1
 #define QS_VERSION_PATCH 0
 
+#define QS_STARTUP_INITIAL_CAP 64
+#define QS_STARTUP_MAX_LANES   64
+#define QS_STARTUP_NO_SLOT     UINT32_MAX
+
 /* Internal system descriptors — not part of the public API. */
 Qs_SystemDesc qs_log_system_desc(void);
 Qs_SystemDesc qs_job_system_desc(void);
@@ -45,23 +50,100 @@ struct Qs_Engine {
     void*             frame_userdata;
     Qs_ExtRegistry*   extensions;
     Qs_Project*       project;
+
+    /* Startup timeline — written from any thread until qs_engine_create
+       returns, read-only afterwards. */
+    Ca_Mutex*         startup_mutex;
+    Qs_StartupEntry*  startup;
+    uint32_t          startup_count;
+    uint32_t          startup_cap;
+    const void*       startup_lanes[QS_STARTUP_MAX_LANES];
+    uint32_t          startup_lane_count;
+    uint64_t          startup_epoch_ns;
+    uint64_t          startup_total_ns;
+    bool              startup_sealed;
 };
 
-static double engine_clock(void)
+uint64_t qs_clock_ns(void)
 {
 #ifdef _WIN32
     static LARGE_INTEGER freq = {0};
     if (!freq.QuadPart) QueryPerformanceFrequency(&freq);
     LARGE_INTEGER counter;
     QueryPerformanceCounter(&counter);
-    return (double)counter.QuadPart / (double)freq.QuadPart;
+    return (uint64_t)((double)counter.QuadPart * 1e9 / (double)freq.QuadPart);
 #else
     struct timespec ts;
     clock_gettime(CLOCK_MONOTONIC, &ts);
-    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
 #endif
 }
 
+static double engine_clock(void)
+{
+    return (double)qs_clock_ns() / 1e9;
+}
+
+/* ── Startup timeline ───────────────────────────────────────── */
+
+/* Each thread's address of this variable identifies its trace lane. */
+static _Thread_local char t_startup_lane_tag;
+
+static uint32_t startup_lane(Qs_Engine* engine)
+{
+    const void* tag = &t_startup_lane_tag;
+    for (uint32_t i = 0; i < engine->startup_lane_count; i++)
+        if (engine->startup_lanes[i] == tag) return i;
+    if (engine->startup_lane_count == QS_STARTUP_MAX_LANES)
+        return QS_STARTUP_MAX_LANES - 1;
+    engine->startup_lanes[engine->startup_lane_count] = tag;
+    return engine->startup_lane_count++;
+}
+
+/* Opens a startup step and returns its slot, or QS_STARTUP_NO_SLOT once the
+   timeline is sealed. Thread-safe; also used by the plugin manager. */
+uint32_t qs_engine_startup_begin(Qs_Engine* engine, const char* category,
+                                 const char* name)
+{
+    if (!engine || engine->startup_sealed || !engine->startup_mutex)
+        return QS_STARTUP_NO_SLOT;
+
+    uint64_t now  = qs_clock_ns();
+    uint32_t slot = QS_STARTUP_NO_SLOT;
+    ca_mutex_lock(engine->startup_mutex);
+    if (engine->startup_count == engine->startup_cap) {
+        uint32_t new_cap = engine->startup_cap ? engine->startup_cap * 2
+                                               : QS_STARTUP_INITIAL_CAP;
+        Qs_StartupEntry* grown = realloc(engine->startup,
+                                         new_cap * sizeof(Qs_StartupEntry));
+        if (grown) {
+            engine->startup     = grown;
+            engine->startup_cap = new_cap;
+        }
+    }
+    if (engine->startup_count < engine->startup_cap) {
+        slot = engine->startup_count++;
+        Qs_StartupEntry* e = &engine->startup[slot];
+        memset(e, 0, sizeof(*e));
+        snprintf(e->name, sizeof(e->name), "%s", name ? name : "?");
+        e->category = category;
+        e->start_ns = now - engine->startup_epoch_ns;
+        e->thread   = startup_lane(engine);
+    }
+    ca_mutex_unlock(engine->startup_mutex);
+    return slot;
+}
+
+void qs_engine_startup_end(Qs_Engine* engine, uint32_t slot)
+{
+    if (!engine || slot == QS_STARTUP_NO_SLOT) return;
+    uint64_t now = qs_clock_ns() - engine->startup_epoch_ns;
+    ca_mutex_lock(engine->startup_mutex);
+    Qs_StartupEntry* e = &engine->startup[slot];
+    e->duration_ns = now - e->start_ns;
+    ca_mutex_unlock(engine->startup_mutex);
+}
+
 /* Internal update — computes dt and ticks all systems. */
 static void engine_update(Qs_Engine* engine)
 {
@@ -78,6 +160,8 @@ static void engine_frame(void *userdata)
 {
     Qs_Engine *engine = userdata;
     engine_update(engine);
+    /* Deliver events posted from jobs/other threads since the last frame. */
+    qs_event_dispatch_posted(qs_engine_event_bus(engine));
     if (engine->on_frame)
         engine->on_frame(engine, engine->frame_userdata);
     /* Clear per-frame input accumulators after all consumers have run. */
@@ -90,6 +174,8 @@ Qs_Engine* qs_engine_create(const Qs_EngineDesc* desc) {
     Qs_Engine* engine = calloc(1, sizeof(Qs_Engine));
     if (!engine) return NULL;
 
+    engine->startup_epoch_ns = qs_clock_ns();
+    engine->startup_mutex    = ca_mutex_create();
     engine->last_time = engine_clock();
     engine->dt        = 1.0f / 60.0f;
 
@@ -105,11 +191,15 @@ Qs_Engine* qs_engine_create(const Qs_EngineDesc* desc) {
     engine->version_patch = desc->version_patch;
 
     /* ---- Create Causality instance ---- */
+    uint32_t step = qs_engine_startup_begin(engine, "engine", "GPU instance");
     engine->ca_instance = ca_instance_create(&(Ca_InstanceDesc){
         .app_name     = desc->app_name,
         .font_size_px = desc->font_size_px > 0 ? desc->font_size_px : 14.0f,
     });
+    qs_engine_startup_end(engine, step);
     if (!engine->ca_instance) {
+        free(engine->startup);
+        if (engine->startup_mutex) ca_mutex_destroy(engine->startup_mutex);
         free(engine->app_name);
         free(engine);
         return NULL;
@@ -120,13 +210,17 @@ Qs_Engine* qs_engine_create(const Qs_EngineDesc* desc) {
     ca_instance_set_continuous(engine->ca_instance, true);
 
     /* ---- Create window ---- */
+    step = qs_engine_startup_begin(engine, "engine", "Window");
     engine->window = ca_window_create(engine->ca_instance, &(Ca_WindowDesc){
         .title  = desc->app_name,
         .width  = desc->window_width  > 0 ? desc->window_width  : 1280,
         .height = desc->window_height > 0 ? desc->window_height : 720,
     });
+    qs_engine_startup_end(engine, step);
     if (!engine->window) {
         ca_instance_destroy(engine->ca_instance);
+        free(engine->startup);
+        if (engine->startup_mutex) ca_mutex_destroy(engine->startup_mutex);
         free(engine->app_name);
         free(engine);
         return NULL;
@@ -158,9 +252,11 @@ Qs_Engine* qs_engine_create(const Qs_EngineDesc* desc) {
     /* ---- Plugin loading ----
        Plugins may register additional systems (e.g. renderer) here,
        before Scene is initialised so dependency order is preserved. */
+    step = qs_engine_startup_begin(engine, "engine", "Plugin scan");
     engine->plugins = qs_plugin_manager_create(engine, desc->plugin_dir);
     if (engine->plugins)
         qs_plugin_manager_scan(engine->plugins);
+    qs_engine_startup_end(engine, step);
 
     /* ---- Renderer systems ---- */
     Qs_SystemDesc render_desc = qs_render_system_desc();
@@ -186,12 +282,20 @@ Qs_Engine* qs_engine_create(const Qs_EngineDesc* desc) {
     Qs_SystemDesc scene_desc = qs_scene_system_desc();
     if (!qs_system_register(engine->systems, &scene_desc)) goto fail;
 
-    QS_LOG_INFO("Quasar Engine %s initialized (%s) [%u worker threads]",
+    step = qs_engine_startup_begin(engine, "engine", "Init listeners");
+    qs_event_fire(qs_engine_event_bus(engine), QS_EVENT_ENGINE_INIT, NULL, 0);
+    qs_engine_startup_end(engine, step);
+
+    ca_mutex_lock(engine->startup_mutex);
+    engine->startup_total_ns = qs_clock_ns() - engine->startup_epoch_ns;
+    engine->startup_sealed   = true;
+    ca_mutex_unlock(engine->startup_mutex);
+
+    QS_LOG_INFO("Quasar Engine %s initialized (%s) in %.1f ms [%u worker threads]",
                 qs_version_string(),
                 engine->app_name ? engine->app_name : "unnamed",
+                (double)engine->startup_total_ns / 1e6,
                 qs_job_system_thread_count(qs_engine_job_system(engine)));
-
-    qs_event_fire(qs_engine_event_bus(engine), QS_EVENT_ENGINE_INIT, NULL, 0);
     return engine;
 
 fail:
@@ -199,6 +303,8 @@ fail:
     if (engine->extensions) qs_ext_registry_destroy(engine->extensions);
     if (engine->systems) qs_system_manager_destroy(engine->systems);
     ca_instance_destroy(engine->ca_instance);
+    free(engine->startup);
+    if (engine->startup_mutex) ca_mutex_destroy(engine->startup_mutex);
     free(engine->app_name);
     free(engine);
     return NULL;
@@ -213,6 +319,8 @@ void qs_engine_destroy(Qs_Engine* engine) {
     qs_system_manager_destroy(engine->systems);
     if (engine->stylesheet) ca_css_destroy(engine->stylesheet);
     ca_instance_destroy(engine->ca_instance);
+    free(engine->startup);
+    if (engine->startup_mutex) ca_mutex_destroy(engine->startup_mutex);
     free(engine->app_name);
     free(engine);
 }
@@ -298,6 +406,46 @@ Qs_ExtRegistry* qs_engine_ext_registry(const Qs_Engine* engine) {
     return engine ? engine->extensions : NULL;
 }
 
+uint32_t qs_engine_startup_count(const Qs_Engine* engine) {
+    return engine && engine->startup_sealed ? engine->startup_count : 0;
+}
+
+const Qs_StartupEntry* qs_engine_startup_entry(const Qs_Engine* engine, uint32_t idx) {
+    if (!engine || !engine->startup_sealed || idx >= engine->startup_count) return NULL;
+    return &engine->startup[idx];
+}
+
+uint64_t qs_engine_startup_total_ns(const Qs_Engine* engine) {
+    return engine ? engine->startup_total_ns : 0;
+}
+
+bool qs_engine_startup_dump(const Qs_Engine* engine, const char* path) {
+    if (!engine || !engine->startup_sealed || !path) return false;
+
+    FILE* f = qs_trace_open(path, "ms", "Quasar Startup");
+    if (!f) {
+        QS_LOG_ERROR("Startup trace: cannot open '%s' for writing", path);
+        return false;
+    }
+
+    for (uint32_t lane = 0; lane < engine->startup_lane_count; lane++) {
+        char name[32];
+        if (lane == 0) snprintf(name, sizeof(name), "Main thread");
+        else           snprintf(name, sizeof(name), "Helper %u", lane);
+        qs_trace_thread_name(f, lane, name);
+    }
+    for (uint32_t i = 0; i < engine->startup_count; i++) {
+        const Qs_StartupEntry* e = &engine->startup[i];
+        qs_trace_event(f, e->name, e->category, e->thread,
+                       (double)e->start_ns / 1000.0, (double)e->duration_ns / 1000.0, NULL);
+    }
+    bool ok = qs_trace_close(f);
+
+    if (ok) QS_LOG_INFO("Startup trace: %u steps written to '%s'", engine->startup_count, path);
+    else    QS_LOG_ERROR("Startup trace: write to '%s' failed", path);
+    return ok;
+}
+
 const char* qs_version_string(void) {
     static char version[32];
     snprintf(version, sizeof(version), "%d.%d.%d",
@@ -377,7 +525,10 @@ Qs_System *qs_system_register(Qs_SystemManager *manager, const Qs_SystemDesc *de
         if (!s->data) { free(s->name); free(s); return NULL; }
     }
 
-    if (s->init && !s->init(s, manager->engine)) {
+    uint32_t step = qs_engine_startup_begin(manager->engine, "system", desc->name);
+    bool ok = !s->init || s->init(s, manager->engine);
+    qs_engine_startup_end(manager->engine, step);
+    if (!ok) {
         free(s->data);
         free(s->name);
         free(s);
@@ -14,6 +14,7 @@
  */
 
 #include "qs_asset_pack.h"
+#include "qs_asset_pack_internal.h"
 
 #include "qs_asset.h"
 #include "qs_mesh.h"
@@ -310,6 +311,23 @@ static void optimize_mesh(Qs_Vertex **verts_io, uint32_t *vc_io,
     *idx_io   = new_idx;
 }
 
+bool qs_asset_split_vertex_streams(Qs_Vertex *verts, uint32_t vc)
+{
+    Qs_VertexAttributes *attrs = malloc(sizeof(Qs_VertexAttributes) * vc);
+    if (!attrs) return false;
+    float *positions = (float *)verts;
+    for (uint32_t i = 0; i < vc; i++) {
+        Qs_Vertex v = verts[i];
+        memcpy(attrs[i].normal,  v.normal,  sizeof(v.normal));
+        memcpy(attrs[i].tangent, v.tangent, sizeof(v.tangent));
+        memcpy(attrs[i].uv,      v.uv,      sizeof(v.uv));
+        memcpy(positions + 3 * (size_t)i, v.position, sizeof(v.position));
+    }
+    memcpy(positions + 3 * (size_t)vc, attrs, sizeof(Qs_VertexAttributes) * vc);
+    free(attrs);
+    return true;
+}
+
 static bool write_qsmesh(const char *path, const Qs_ImportMesh *m, bool optimize)
 {
     if (!m || !m->vertices || !m->indices) return false;
@@ -331,9 +349,11 @@ static bool write_qsmesh(const char *path, const Qs_ImportMesh *m, bool optimize
         .version      = QS_MESH_VERSION,
         .vertex_count = vc,
         .index_count  = ic,
+        .flags        = QS_MESH_FLAG_SPLIT_STREAMS,
     };
     snprintf(h.surface_name, sizeof(h.surface_name), "%s", m->name);
     compute_aabb(verts, vc, h.aabb_min, h.aabb_max);
+    if (!qs_asset_split_vertex_streams(verts, vc)) { free(verts); free(idx); return false; }
 
     FILE *f = fopen(path, "wb");
     if (!f) {
@@ -350,19 +370,27 @@ static bool write_qsmesh(const char *path, const Qs_ImportMesh *m, bool optimize
     return true;
 }
 
-static bool read_qsmesh(const char *path,
-                        Qs_MeshFileHeader *out_header,
-                        Qs_Vertex **out_verts,
-                        uint32_t  **out_idx)
+bool qs_asset_read_qsmesh(const char *path,
+                          Qs_MeshFileHeader *out_header,
+                          void      **out_verts,
+                          uint32_t  **out_idx)
 {
     FILE *f = fopen(path, "rb");
     if (!f) return false;
-    Qs_MeshFileHeader h;
-    if (fread(&h, sizeof(h), 1, f) != 1) { fclose(f); return false; }
+    Qs_MeshFileHeader h = {0};
+    const size_t v1_size = offsetof(Qs_MeshFileHeader, flags);
+    if (fread(&h, v1_size, 1, f) != 1) { fclose(f); return false; }
     if (h.magic != QS_MESH_MAGIC) {
         QS_LOG_ERROR("Not a .qsmesh file: %s", path);
         fclose(f); return false;
     }
+    if (h.version > QS_MESH_VERSION) {
+        QS_LOG_ERROR("Unsupported .qsmesh version %u: %s", h.version, path);
+        fclose(f); return false;
+    }
+    if (h.version >= 2 && fread(&h.flags, sizeof(h.flags), 1, f) != 1) {
+        fclose(f); return false;
+    }
     Qs_Vertex *v = malloc(sizeof(Qs_Vertex) * h.vertex_count);
     uint32_t  *i = malloc(sizeof(uint32_t)  * h.index_count);
     if (!v || !i) { free(v); free(i); fclose(f); return false; }
@@ -898,17 +926,26 @@ Qs_Mesh *qs_asset_cache_mesh(Qs_Engine *engine, const char *abs_path)
     if (hit) { hit->ref_count++; return hit->data.mesh; }
 
     Qs_MeshFileHeader h;
-    Qs_Vertex *v = NULL; uint32_t *idx = NULL;
-    if (!read_qsmesh(abs_path, &h, &v, &idx)) return NULL;
+    void *v = NULL; uint32_t *idx = NULL;
+    if (!qs_asset_read_qsmesh(abs_path, &h, &v, &idx)) return NULL;
 
+    Qs_AABB bounds;
+    memcpy(bounds.min, h.aabb_min, sizeof(bounds.min));
+    memcpy(bounds.max, h.aabb_max, sizeof(bounds.max));
     Qs_MeshDesc md = {
         .name         = h.surface_name[0] ? h.surface_name : abs_path,
-        .vertices     = v,
         .vertex_count = h.vertex_count,
         .indices      = idx,
         .index_count  = h.index_count,
         .index_type   = QS_INDEX_TYPE_UINT32,
+        .bounds       = &bounds,
     };
+    if (h.flags & QS_MESH_FLAG_SPLIT_STREAMS) {
+        md.positions  = v;
+        md.attributes = (const Qs_VertexAttributes *)((const float *)v + 3 * (size_t)h.vertex_count);
+    } else {
+        md.vertices   = v;
+    }
     Qs_Mesh *mesh = qs_mesh_create(engine, &md);
     free(v); free(idx);
     if (!mesh) return NULL;
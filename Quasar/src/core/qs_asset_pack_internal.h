@@ -0,0 +1,26 @@
+#ifndef QS_ASSET_PACK_INTERNAL_H
+#define QS_ASSET_PACK_INTERNAL_H
+
+#include "qs_asset_pack.h"
+#include "qs_mesh.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* ================================================================
+   .QSMESH I/O — shared by the asset pack and its tests, not part of
+   the public API.
+   ================================================================ */
+
+/// Rewrites interleaved vertices in place as the position stream followed
+/// by the attribute stream; both layouts take vc * sizeof(Qs_Vertex) bytes.
+bool qs_asset_split_vertex_streams(Qs_Vertex *verts, uint32_t vc);
+
+/// Reads a v1 (interleaved) or v2 .qsmesh.  *out_verts holds vertex_count
+/// * sizeof(Qs_Vertex) bytes laid out as out_header->flags says; v1
+/// headers come back with flags 0.  Fails on a bad magic, a version newer
+/// than QS_MESH_VERSION or a truncated file.
+bool qs_asset_read_qsmesh(const char *path, Qs_MeshFileHeader *out_header,
+                          void **out_verts, uint32_t **out_idx);
+
+#endif /* QS_ASSET_PACK_INTERNAL_H */
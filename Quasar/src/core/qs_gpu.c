@@ -3,8 +3,14 @@
 #include "causality.h"
 #include <vulkan/vulkan.h>
 
+#include <stdatomic.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
 
 /*
  * Private struct definitions.  Backends only see forward declarations;
@@ -19,19 +25,45 @@ struct Qs_GpuBuffer {
     VkBuffer       buffer;
     VkDeviceMemory memory;
     uint64_t       size;
+    void          *mapped;   /* persistent mapping of host-visible memory */
 };
 
 struct Qs_GpuImage {
     VkImage        image;
-    VkDeviceMemory memory;
+    VkDeviceMemory memory;   /* VK_NULL_HANDLE when placed in a Qs_GpuMemory */
     uint32_t       width;
     uint32_t       height;
     uint32_t       mip_levels;
     VkFormat       format;
+    VkSampleCountFlagBits samples;
+};
+
+struct Qs_GpuMemory {
+    VkDeviceMemory memory;
+    uint64_t       size;
 };
 
 struct Qs_GpuImageView {
-    VkImageView view;
+    VkImageView           view;
+    VkFormat              format;   /* VK_FORMAT_UNDEFINED for wrapped swapchain views */
+    VkSampleCountFlagBits samples;
+};
+
+/* GPU-to-host completion marker.  Causality owns queue submission, so a
+   VkEvent set at the end of a recorded frame stands in for a fence. */
+struct Qs_GpuFence {
+    VkEvent event;
+    bool    pending;
+};
+
+/* Secondary command buffers recycled by qs_gpu_reset_cmd_pool.  Wrappers
+   are allocated one by one so handed-out pointers survive growth. */
+struct Qs_GpuCmdPool {
+    VkCommandPool pool;
+    Qs_GpuCmd   **cmds;
+    uint32_t      count;
+    uint32_t      capacity;
+    uint32_t      used;
 };
 
 struct Qs_GpuSampler {
@@ -43,11 +75,13 @@ struct Qs_GpuShader {
 };
 
 struct Qs_GpuPipeline {
-    VkPipeline pipeline;
+    VkPipeline          pipeline;
+    VkPipelineBindPoint bind_point;
 };
 
 struct Qs_GpuPipelineLayout {
-    VkPipelineLayout layout;
+    VkPipelineLayout    layout;
+    VkPipelineBindPoint bind_point;
 };
 
 struct Qs_GpuDescriptorSetLayout {
@@ -170,9 +204,10 @@ static VkPipelineStageFlags layout_to_src_stage(Qs_GpuImageLayout layout)
     switch (layout) {
     case QS_GPU_IMAGE_LAYOUT_TRANSFER_SRC:     return VK_PIPELINE_STAGE_TRANSFER_BIT;
     case QS_GPU_IMAGE_LAYOUT_TRANSFER_DST:     return VK_PIPELINE_STAGE_TRANSFER_BIT;
-    case QS_GPU_IMAGE_LAYOUT_SHADER_READ:      return VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    case QS_GPU_IMAGE_LAYOUT_SHADER_READ:      return VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT |
+                                                      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
     case QS_GPU_IMAGE_LAYOUT_COLOR_ATTACHMENT: return VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    case QS_GPU_IMAGE_LAYOUT_DEPTH_ATTACHMENT: return VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+    case QS_GPU_IMAGE_LAYOUT_DEPTH_ATTACHMENT: return VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
     default: return VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
     }
 }
@@ -182,7 +217,8 @@ static VkPipelineStageFlags layout_to_dst_stage(Qs_GpuImageLayout layout)
     switch (layout) {
     case QS_GPU_IMAGE_LAYOUT_TRANSFER_SRC:     return VK_PIPELINE_STAGE_TRANSFER_BIT;
     case QS_GPU_IMAGE_LAYOUT_TRANSFER_DST:     return VK_PIPELINE_STAGE_TRANSFER_BIT;
-    case QS_GPU_IMAGE_LAYOUT_SHADER_READ:      return VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    case QS_GPU_IMAGE_LAYOUT_SHADER_READ:      return VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT |
+                                                      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
     case QS_GPU_IMAGE_LAYOUT_COLOR_ATTACHMENT: return VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
     case QS_GPU_IMAGE_LAYOUT_DEPTH_ATTACHMENT: return VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
     default: return VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
@@ -196,7 +232,8 @@ static VkAccessFlags layout_to_access(Qs_GpuImageLayout layout)
     case QS_GPU_IMAGE_LAYOUT_TRANSFER_DST:     return VK_ACCESS_TRANSFER_WRITE_BIT;
     case QS_GPU_IMAGE_LAYOUT_SHADER_READ:      return VK_ACCESS_SHADER_READ_BIT;
     case QS_GPU_IMAGE_LAYOUT_COLOR_ATTACHMENT: return VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-    case QS_GPU_IMAGE_LAYOUT_DEPTH_ATTACHMENT: return VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    case QS_GPU_IMAGE_LAYOUT_DEPTH_ATTACHMENT: return VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+                                                      VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
     default: return 0;
     }
 }
@@ -261,11 +298,18 @@ static Qs_GpuBuffer *create_buffer_raw(VkDevice device, VkPhysicalDevice pd,
     }
     vkBindBufferMemory(device, vk_buf, vk_mem, 0);
 
+    void *mapped = NULL;
+    if ((mem_flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) &&
+        vkMapMemory(device, vk_mem, 0, VK_WHOLE_SIZE, 0, &mapped) != VK_SUCCESS) {
+        vkDestroyBuffer(device, vk_buf, NULL); vkFreeMemory(device, vk_mem, NULL); return NULL;
+    }
+
     Qs_GpuBuffer *buf = calloc(1, sizeof(Qs_GpuBuffer));
     if (!buf) { vkDestroyBuffer(device, vk_buf, NULL); vkFreeMemory(device, vk_mem, NULL); return NULL; }
     buf->buffer = vk_buf;
     buf->memory = vk_mem;
     buf->size   = (uint64_t)size;
+    buf->mapped = mapped;
     return buf;
 }
 
@@ -432,6 +476,129 @@ uint32_t qs_gpu_max_sample_count(Qs_GpuContext *gpu)
     return 1;
 }
 
+/* Causality creates the VkDevice and does not report which features it
+   enabled, and Vulkan has no query for them, so the build states it:
+   QS_GPU_DESCRIPTOR_INDEXING (CMake QUASAR_DESCRIPTOR_INDEXING) when the
+   linked Causality enables descriptor indexing wherever the device
+   supports it.  Using a feature the device was not created with is
+   undefined behaviour even where the driver happens to accept it. */
+bool qs_gpu_descriptor_indexing_enabled(Qs_GpuContext *gpu)
+{
+#ifndef QS_GPU_DESCRIPTOR_INDEXING
+    (void)gpu;
+    return false;
+#else
+    VkPhysicalDeviceDescriptorIndexingFeatures indexing = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES,
+    };
+    VkPhysicalDeviceFeatures2 features = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+        .pNext = &indexing,
+    };
+    vkGetPhysicalDeviceFeatures2(ca_gpu_physical_device(to_ca(gpu)), &features);
+    return indexing.runtimeDescriptorArray &&
+           indexing.shaderSampledImageArrayNonUniformIndexing &&
+           indexing.descriptorBindingPartiallyBound &&
+           indexing.descriptorBindingSampledImageUpdateAfterBind &&
+           indexing.descriptorBindingUpdateUnusedWhilePending;
+#endif
+}
+
+uint64_t qs_gpu_buffer_offset_alignment(Qs_GpuContext *gpu)
+{
+    VkPhysicalDeviceProperties props;
+    vkGetPhysicalDeviceProperties(ca_gpu_physical_device(to_ca(gpu)), &props);
+    VkDeviceSize u = props.limits.minUniformBufferOffsetAlignment;
+    VkDeviceSize s = props.limits.minStorageBufferOffsetAlignment;
+    VkDeviceSize a = u > s ? u : s;
+    return a > 0 ? (uint64_t)a : 1;
+}
+
+/* ================================================================
+   FENCES
+   ================================================================ */
+
+Qs_GpuFence *qs_gpu_create_fence(Qs_GpuContext *gpu)
+{
+    VkEventCreateInfo ci = { .sType = VK_STRUCTURE_TYPE_EVENT_CREATE_INFO };
+    Qs_GpuFence *fence = calloc(1, sizeof(Qs_GpuFence));
+    if (!fence) return NULL;
+    if (vkCreateEvent(ca_gpu_device(to_ca(gpu)), &ci, NULL, &fence->event) != VK_SUCCESS) {
+        free(fence);
+        return NULL;
+    }
+    return fence;
+}
+
+void qs_gpu_destroy_fence(Qs_GpuContext *gpu, Qs_GpuFence *fence)
+{
+    if (!fence) return;
+    VkDevice device = ca_gpu_device(to_ca(gpu));
+    if (fence->pending) vkDeviceWaitIdle(device);
+    vkDestroyEvent(device, fence->event, NULL);
+    free(fence);
+}
+
+void qs_cmd_signal_fence(Qs_GpuCmd *cmd, Qs_GpuFence *fence)
+{
+    vkCmdSetEvent(cmd->cmd, fence->event, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+    fence->pending = true;
+}
+
+/* Polling backoff: the first few polls only spin, then the host sleeps
+   for a doubling interval so a long wait does not burn a core. */
+#define QS_FENCE_SPIN_POLLS   64
+#define QS_FENCE_NAP_MIN_US   20
+#define QS_FENCE_NAP_MAX_US   1000
+
+static void fence_nap(uint32_t us)
+{
+#ifdef _WIN32
+    Sleep(us / 1000);   /* Sleep(0) yields the rest of the time slice */
+#else
+    struct timespec ts = { 0, (long)us * 1000L };
+    nanosleep(&ts, NULL);
+#endif
+}
+
+bool qs_gpu_wait_fence(Qs_GpuContext *gpu, Qs_GpuFence *fence,
+                       const Qs_GpuFence *later, uint64_t timeout_ns)
+{
+    if (!fence->pending) return true;
+    VkDevice device = ca_gpu_device(to_ca(gpu));
+
+    struct timespec start, now;
+    timespec_get(&start, TIME_UTC);
+    uint32_t polls = 0, nap_us = QS_FENCE_NAP_MIN_US;
+    for (;;) {
+        VkResult res = vkGetEventStatus(device, fence->event);
+        if (res == VK_EVENT_SET) break;
+        if (res != VK_EVENT_RESET) return false;
+
+        /* Events are signaled in submission order: once a later signal
+           has executed, an unset earlier one was recorded into a command
+           buffer that was never submitted, and nothing it used is busy. */
+        if (later && later != fence && later->pending) {
+            res = vkGetEventStatus(device, later->event);
+            if (res == VK_EVENT_SET) break;
+            if (res != VK_EVENT_RESET) return false;
+        }
+
+        timespec_get(&now, TIME_UTC);
+        uint64_t elapsed = (uint64_t)(now.tv_sec - start.tv_sec) * 1000000000ull
+                         + (uint64_t)(now.tv_nsec - start.tv_nsec);
+        if (elapsed >= timeout_ns) return false;
+
+        if (++polls > QS_FENCE_SPIN_POLLS) {
+            fence_nap(nap_us);
+            if (nap_us < QS_FENCE_NAP_MAX_US) nap_us *= 2;
+        }
+    }
+    vkResetEvent(device, fence->event);
+    fence->pending = false;
+    return true;
+}
+
 /* ================================================================
    BUFFER IMPLEMENTATION
    ================================================================ */
@@ -444,6 +611,7 @@ static VkBufferUsageFlags buffer_usage_to_vk(Qs_GpuBufferUsage usage)
     if (usage & QS_GPU_BUFFER_UNIFORM)  flags |= VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
     if (usage & QS_GPU_BUFFER_STORAGE)  flags |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
     if (usage & QS_GPU_BUFFER_TRANSFER) flags |= VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    if (usage & QS_GPU_BUFFER_INDIRECT) flags |= VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
     return flags;
 }
 
@@ -475,10 +643,7 @@ Qs_GpuBuffer *qs_gpu_create_buffer_from_data(Qs_GpuContext *gpu, Qs_GpuBufferUsa
         VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
     if (!staging) return NULL;
 
-    void *mapped;
-    vkMapMemory(device, staging->memory, 0, (VkDeviceSize)size, 0, &mapped);
-    memcpy(mapped, data, (size_t)size);
-    vkUnmapMemory(device, staging->memory);
+    memcpy(staging->mapped, data, (size_t)size);
 
     /* Device-local destination */
     VkBufferUsageFlags vk_usage = buffer_usage_to_vk(usage);
@@ -515,34 +680,20 @@ void qs_gpu_destroy_buffer(Qs_GpuContext *gpu, Qs_GpuBuffer *buffer)
     free(buffer);
 }
 
-void *qs_gpu_map_buffer(Qs_GpuContext *gpu, Qs_GpuBuffer *buffer)
+void *qs_gpu_buffer_data(const Qs_GpuBuffer *buffer)
 {
-    if (!buffer) return NULL;
-    void *mapped = NULL;
-    if (vkMapMemory(ca_gpu_device(to_ca(gpu)), buffer->memory, 0, (VkDeviceSize)buffer->size, 0, &mapped) != VK_SUCCESS)
-        return NULL;
-    return mapped;
-}
-
-void qs_gpu_unmap_buffer(Qs_GpuContext *gpu, Qs_GpuBuffer *buffer)
-{
-    if (buffer) vkUnmapMemory(ca_gpu_device(to_ca(gpu)), buffer->memory);
+    return buffer ? buffer->mapped : NULL;
 }
 
 /* ================================================================
    IMAGE IMPLEMENTATION
    ================================================================ */
 
-Qs_GpuImage *qs_gpu_create_image(Qs_GpuContext *gpu, const Qs_GpuImageDesc *desc)
+/* Fills ci from desc; shared by creation and requirement queries so
+   both describe the same image. */
+static void image_create_info(VkPhysicalDevice pd, const Qs_GpuImageDesc *desc,
+                              VkImageCreateInfo *ci)
 {
-    Ca_Instance    *ca     = to_ca(gpu);
-    VkDevice        device = ca_gpu_device(ca);
-    VkPhysicalDevice pd    = ca_gpu_physical_device(ca);
-
-    VkFormat vk_fmt = (desc->format == QS_GPU_FORMAT_DEPTH_AUTO)
-        ? pick_depth_format(pd)
-        : gpu_format_to_vk(desc->format);
-
     VkImageUsageFlags usage = 0;
     if (desc->usage & QS_GPU_IMAGE_SAMPLED)          usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
     if (desc->usage & QS_GPU_IMAGE_TRANSFER_SRC)     usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
@@ -550,14 +701,14 @@ Qs_GpuImage *qs_gpu_create_image(Qs_GpuContext *gpu, const Qs_GpuImageDesc *desc
     if (desc->usage & QS_GPU_IMAGE_COLOR_ATTACHMENT) usage |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
     if (desc->usage & QS_GPU_IMAGE_DEPTH_ATTACHMENT) usage |= VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
 
-    uint32_t mip_levels = desc->mip_levels > 0 ? desc->mip_levels : 1;
-
-    VkImageCreateInfo ci = {
+    *ci = (VkImageCreateInfo){
         .sType         = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
         .imageType     = VK_IMAGE_TYPE_2D,
-        .format        = vk_fmt,
+        .format        = (desc->format == QS_GPU_FORMAT_DEPTH_AUTO)
+                         ? pick_depth_format(pd)
+                         : gpu_format_to_vk(desc->format),
         .extent        = { desc->width, desc->height, 1 },
-        .mipLevels     = mip_levels,
+        .mipLevels     = desc->mip_levels > 0 ? desc->mip_levels : 1,
         .arrayLayers   = 1,
         .samples       = sample_count_to_vk(desc->sample_count),
         .tiling        = VK_IMAGE_TILING_OPTIMAL,
@@ -565,38 +716,56 @@ Qs_GpuImage *qs_gpu_create_image(Qs_GpuContext *gpu, const Qs_GpuImageDesc *desc
         .sharingMode   = VK_SHARING_MODE_EXCLUSIVE,
         .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
     };
+}
+
+Qs_GpuImage *qs_gpu_create_image(Qs_GpuContext *gpu, const Qs_GpuImageDesc *desc)
+{
+    Ca_Instance    *ca     = to_ca(gpu);
+    VkDevice        device = ca_gpu_device(ca);
+    VkPhysicalDevice pd    = ca_gpu_physical_device(ca);
+
+    VkImageCreateInfo ci;
+    image_create_info(pd, desc, &ci);
 
     VkImage vk_image;
     if (vkCreateImage(device, &ci, NULL, &vk_image) != VK_SUCCESS) return NULL;
 
-    VkMemoryRequirements req;
-    vkGetImageMemoryRequirements(device, vk_image, &req);
-    uint32_t mi = find_memory_type(pd, req.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-    if (mi == UINT32_MAX) { vkDestroyImage(device, vk_image, NULL); return NULL; }
-
-    VkMemoryAllocateInfo ai = {
-        .sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-        .allocationSize  = req.size,
-        .memoryTypeIndex = mi,
-    };
-    VkDeviceMemory vk_mem;
-    if (vkAllocateMemory(device, &ai, NULL, &vk_mem) != VK_SUCCESS) {
-        vkDestroyImage(device, vk_image, NULL); return NULL;
+    VkDeviceMemory vk_mem = VK_NULL_HANDLE;
+    if (desc->memory) {
+        if (vkBindImageMemory(device, vk_image, desc->memory->memory,
+                              desc->memory_offset) != VK_SUCCESS) {
+            vkDestroyImage(device, vk_image, NULL); return NULL;
+        }
+    } else {
+        VkMemoryRequirements req;
+        vkGetImageMemoryRequirements(device, vk_image, &req);
+        uint32_t mi = find_memory_type(pd, req.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        if (mi == UINT32_MAX) { vkDestroyImage(device, vk_image, NULL); return NULL; }
+
+        VkMemoryAllocateInfo ai = {
+            .sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+            .allocationSize  = req.size,
+            .memoryTypeIndex = mi,
+        };
+        if (vkAllocateMemory(device, &ai, NULL, &vk_mem) != VK_SUCCESS) {
+            vkDestroyImage(device, vk_image, NULL); return NULL;
+        }
+        vkBindImageMemory(device, vk_image, vk_mem, 0);
     }
-    vkBindImageMemory(device, vk_image, vk_mem, 0);
 
     Qs_GpuImage *img = calloc(1, sizeof(Qs_GpuImage));
     if (!img) {
         vkDestroyImage(device, vk_image, NULL);
-        vkFreeMemory(device, vk_mem, NULL);
+        if (vk_mem) vkFreeMemory(device, vk_mem, NULL);
         return NULL;
     }
     img->image      = vk_image;
     img->memory     = vk_mem;
     img->width      = desc->width;
     img->height     = desc->height;
-    img->mip_levels = mip_levels;
-    img->format     = vk_fmt;
+    img->mip_levels = ci.mipLevels;
+    img->format     = ci.format;
+    img->samples    = ci.samples;
     return img;
 }
 
@@ -610,6 +779,57 @@ void qs_gpu_destroy_image(Qs_GpuContext *gpu, Qs_GpuImage *image)
     free(image);
 }
 
+Qs_GpuMemoryRequirements qs_gpu_image_requirements(Qs_GpuContext *gpu,
+                                                   const Qs_GpuImageDesc *desc)
+{
+    Ca_Instance *ca = to_ca(gpu);
+    VkImageCreateInfo ci;
+    image_create_info(ca_gpu_physical_device(ca), desc, &ci);
+
+    VkDeviceImageMemoryRequirements info = {
+        .sType       = VK_STRUCTURE_TYPE_DEVICE_IMAGE_MEMORY_REQUIREMENTS,
+        .pCreateInfo = &ci,
+    };
+    VkMemoryRequirements2 req = { .sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2 };
+    vkGetDeviceImageMemoryRequirements(ca_gpu_device(ca), &info, &req);
+    return (Qs_GpuMemoryRequirements){
+        .size      = req.memoryRequirements.size,
+        .alignment = req.memoryRequirements.alignment,
+        .type_bits = req.memoryRequirements.memoryTypeBits,
+    };
+}
+
+Qs_GpuMemory *qs_gpu_create_memory(Qs_GpuContext *gpu, uint64_t size, uint32_t type_bits)
+{
+    Ca_Instance *ca     = to_ca(gpu);
+    VkDevice     device = ca_gpu_device(ca);
+    uint32_t mi = find_memory_type(ca_gpu_physical_device(ca), type_bits,
+                                   VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    if (mi == UINT32_MAX) return NULL;
+
+    Qs_GpuMemory *mem = calloc(1, sizeof(Qs_GpuMemory));
+    if (!mem) return NULL;
+    VkMemoryAllocateInfo ai = {
+        .sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+        .allocationSize  = size,
+        .memoryTypeIndex = mi,
+    };
+    if (vkAllocateMemory(device, &ai, NULL, &mem->memory) != VK_SUCCESS) {
+        free(mem); return NULL;
+    }
+    mem->size = size;
+    return mem;
+}
+
+void qs_gpu_destroy_memory(Qs_GpuContext *gpu, Qs_GpuMemory *memory)
+{
+    if (!memory) return;
+    VkDevice device = ca_gpu_device(to_ca(gpu));
+    vkDeviceWaitIdle(device);
+    vkFreeMemory(device, memory->memory, NULL);
+    free(memory);
+}
+
 bool qs_gpu_upload_image(Qs_GpuContext *gpu, Qs_GpuImage *image,
                          const void *pixels, uint64_t size, bool generate_mips)
 {
@@ -624,10 +844,7 @@ bool qs_gpu_upload_image(Qs_GpuContext *gpu, Qs_GpuImage *image,
         VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
     if (!staging) return false;
 
-    void *mapped;
-    vkMapMemory(device, staging->memory, 0, (VkDeviceSize)size, 0, &mapped);
-    memcpy(mapped, pixels, (size_t)size);
-    vkUnmapMemory(device, staging->memory);
+    memcpy(staging->mapped, pixels, (size_t)size);
 
     Qs_GpuCmd qs_cmd;
     begin_transfer_internal(ca, &qs_cmd);
@@ -704,7 +921,9 @@ Qs_GpuImageView *qs_gpu_create_image_view(Qs_GpuContext *gpu,
 
     Qs_GpuImageView *view = calloc(1, sizeof(Qs_GpuImageView));
     if (!view) { vkDestroyImageView(device, vk_view, NULL); return NULL; }
-    view->view = vk_view;
+    view->view    = vk_view;
+    view->format  = vk_fmt;
+    view->samples = desc->image->samples;
     return view;
 }
 
@@ -736,7 +955,9 @@ Qs_GpuImageView *qs_gpu_create_image_view_for(Qs_GpuContext *gpu, Qs_GpuImage *i
     if (vkCreateImageView(device, &ci, NULL, &vk_view) != VK_SUCCESS) return NULL;
     Qs_GpuImageView *view = calloc(1, sizeof(Qs_GpuImageView));
     if (!view) { vkDestroyImageView(device, vk_view, NULL); return NULL; }
-    view->view = vk_view;
+    view->view    = vk_view;
+    view->format  = image->format;
+    view->samples = image->samples;
     return view;
 }
 
@@ -797,13 +1018,37 @@ void qs_gpu_destroy_sampler(Qs_GpuContext *gpu, Qs_GpuSampler *sampler)
    SHADER IMPLEMENTATION
    ================================================================ */
 
+/* ca_shader_compile makes no thread-safety guarantee and the GLSL front
+   end it wraps keeps process-global state, so compiles from job threads
+   are serialized.  The mutex is created on first use and lives for the
+   process. */
+static _Atomic(Ca_Mutex *) s_shader_mutex;
+
+static Ca_Mutex *shader_mutex(void)
+{
+    Ca_Mutex *m = atomic_load_explicit(&s_shader_mutex, memory_order_acquire);
+    if (m) return m;
+    Ca_Mutex *created = ca_mutex_create();
+    if (!created) return NULL;
+    if (!atomic_compare_exchange_strong(&s_shader_mutex, &m, created)) {
+        ca_mutex_destroy(created);
+        return m;
+    }
+    return created;
+}
+
 Qs_GpuShader *qs_gpu_compile_shader(Qs_GpuContext *gpu, const char *glsl_source,
                                      Qs_GpuShaderStage stage)
 {
+    Ca_Mutex *mutex = shader_mutex();
+    if (!mutex) return NULL;
+
     Ca_Instance *ca   = to_ca(gpu);
     VkDevice device   = ca_gpu_device(ca);
+    ca_mutex_lock(mutex);
     VkShaderModule mod = ca_shader_compile(device, glsl_source,
                                             gpu_stage_to_vk_single(stage));
+    ca_mutex_unlock(mutex);
     if (!mod) return NULL;
 
     Qs_GpuShader *shader = calloc(1, sizeof(Qs_GpuShader));
@@ -828,10 +1073,18 @@ Qs_GpuDescriptorSetLayout *qs_gpu_create_descriptor_set_layout(
 {
     VkDevice device = ca_gpu_device(to_ca(gpu));
 
+    for (uint32_t i = 0; i < count; i++)
+        if (bindings[i].flags && !qs_gpu_descriptor_indexing_enabled(gpu)) {
+            QS_LOG_ERROR("Descriptor-indexing binding flags used without the device features enabled");
+            return NULL;
+        }
+
     VkDescriptorSetLayoutBinding *vk_bindings =
         calloc(count, sizeof(VkDescriptorSetLayoutBinding));
-    if (!vk_bindings) return NULL;
+    VkDescriptorBindingFlags *vk_flags = calloc(count, sizeof(VkDescriptorBindingFlags));
+    if (!vk_bindings || !vk_flags) { free(vk_bindings); free(vk_flags); return NULL; }
 
+    bool indexed = false, update_after_bind = false;
     for (uint32_t i = 0; i < count; i++) {
         vk_bindings[i] = (VkDescriptorSetLayoutBinding){
             .binding         = bindings[i].binding,
@@ -839,16 +1092,33 @@ Qs_GpuDescriptorSetLayout *qs_gpu_create_descriptor_set_layout(
             .descriptorCount = bindings[i].count,
             .stageFlags      = gpu_stages_to_vk(bindings[i].stages),
         };
+        if (bindings[i].flags & QS_GPU_DESCRIPTOR_PARTIALLY_BOUND)
+            vk_flags[i] |= VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT;
+        if (bindings[i].flags & QS_GPU_DESCRIPTOR_UPDATE_AFTER_BIND) {
+            vk_flags[i] |= VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+                           VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+            update_after_bind = true;
+        }
+        indexed |= vk_flags[i] != 0;
     }
 
+    VkDescriptorSetLayoutBindingFlagsCreateInfo flags_ci = {
+        .sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
+        .bindingCount  = count,
+        .pBindingFlags = vk_flags,
+    };
     VkDescriptorSetLayoutCreateInfo ci = {
         .sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .pNext        = indexed ? &flags_ci : NULL,
+        .flags        = update_after_bind
+                      ? VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT : 0,
         .bindingCount = count,
         .pBindings    = vk_bindings,
     };
     VkDescriptorSetLayout vk_layout;
     VkResult result = vkCreateDescriptorSetLayout(device, &ci, NULL, &vk_layout);
     free(vk_bindings);
+    free(vk_flags);
     if (result != VK_SUCCESS) return NULL;
 
     Qs_GpuDescriptorSetLayout *layout = calloc(1, sizeof(Qs_GpuDescriptorSetLayout));
@@ -883,7 +1153,9 @@ Qs_GpuDescriptorPool *qs_gpu_create_descriptor_pool(Qs_GpuContext *gpu,
 
     VkDescriptorPoolCreateInfo ci = {
         .sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
-        .flags         = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT,
+        .flags         = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT |
+                         (desc->update_after_bind
+                          ? VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT : 0),
         .maxSets       = desc->max_sets,
         .poolSizeCount = desc->size_count,
         .pPoolSizes    = vk_sizes,
@@ -937,6 +1209,13 @@ void qs_gpu_free_descriptor_set(Qs_GpuContext *gpu, Qs_GpuDescriptorPool *pool,
 void qs_gpu_write_image_descriptor(Qs_GpuContext *gpu, Qs_GpuDescriptorSet *set,
                                     uint32_t binding,
                                     Qs_GpuSampler *sampler, Qs_GpuImageView *view)
+{
+    qs_gpu_write_image_array_descriptor(gpu, set, binding, 0, sampler, view);
+}
+
+void qs_gpu_write_image_array_descriptor(Qs_GpuContext *gpu, Qs_GpuDescriptorSet *set,
+                                          uint32_t binding, uint32_t element,
+                                          Qs_GpuSampler *sampler, Qs_GpuImageView *view)
 {
     VkDescriptorImageInfo img_info = {
         .sampler     = sampler->sampler,
@@ -947,6 +1226,7 @@ void qs_gpu_write_image_descriptor(Qs_GpuContext *gpu, Qs_GpuDescriptorSet *set,
         .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
         .dstSet          = set->set,
         .dstBinding      = binding,
+        .dstArrayElement = element,
         .descriptorCount = 1,
         .descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
         .pImageInfo      = &img_info,
@@ -955,7 +1235,8 @@ void qs_gpu_write_image_descriptor(Qs_GpuContext *gpu, Qs_GpuDescriptorSet *set,
 }
 
 void qs_gpu_write_buffer_descriptor(Qs_GpuContext *gpu, Qs_GpuDescriptorSet *set,
-                                     uint32_t binding, Qs_GpuBuffer *buffer,
+                                     uint32_t binding, Qs_GpuDescriptorType type,
+                                     Qs_GpuBuffer *buffer,
                                      uint64_t offset, uint64_t range)
 {
     VkDescriptorBufferInfo buf_info = {
@@ -968,7 +1249,7 @@ void qs_gpu_write_buffer_descriptor(Qs_GpuContext *gpu, Qs_GpuDescriptorSet *set
         .dstSet          = set->set,
         .dstBinding      = binding,
         .descriptorCount = 1,
-        .descriptorType  = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+        .descriptorType  = gpu_descriptor_type_to_vk(type),
         .pBufferInfo     = &buf_info,
     };
     vkUpdateDescriptorSets(ca_gpu_device(to_ca(gpu)), 1, &write, 0, NULL);
@@ -1019,7 +1300,9 @@ Qs_GpuPipelineLayout *qs_gpu_create_pipeline_layout(Qs_GpuContext *gpu,
 
     Qs_GpuPipelineLayout *layout = calloc(1, sizeof(Qs_GpuPipelineLayout));
     if (!layout) { vkDestroyPipelineLayout(device, vk_layout, NULL); return NULL; }
-    layout->layout = vk_layout;
+    layout->layout     = vk_layout;
+    layout->bind_point = desc->compute ? VK_PIPELINE_BIND_POINT_COMPUTE
+                                       : VK_PIPELINE_BIND_POINT_GRAPHICS;
     return layout;
 }
 
@@ -1052,6 +1335,27 @@ Qs_GpuPipeline *qs_gpu_create_graphics_pipeline(Qs_GpuContext *gpu,
         },
     };
 
+    /* Fragment specialization constants: constant_id i is 32 bits at i * 4 */
+    VkSpecializationMapEntry *spec_entries = NULL;
+    VkSpecializationInfo      spec_info;
+    if (desc->fragment_constant_count) {
+        spec_entries = calloc(desc->fragment_constant_count, sizeof(VkSpecializationMapEntry));
+        if (!spec_entries) return NULL;
+        for (uint32_t i = 0; i < desc->fragment_constant_count; i++)
+            spec_entries[i] = (VkSpecializationMapEntry){
+                .constantID = i,
+                .offset     = i * (uint32_t)sizeof(uint32_t),
+                .size       = sizeof(uint32_t),
+            };
+        spec_info = (VkSpecializationInfo){
+            .mapEntryCount = desc->fragment_constant_count,
+            .pMapEntries   = spec_entries,
+            .dataSize      = desc->fragment_constant_count * sizeof(uint32_t),
+            .pData         = desc->fragment_constants,
+        };
+        stages[1].pSpecializationInfo = &spec_info;
+    }
+
     /* Vertex input */
     uint32_t total_attrs = 0;
     for (uint32_t b = 0; b < desc->vertex_binding_count; b++)
@@ -1062,7 +1366,7 @@ Qs_GpuPipeline *qs_gpu_create_graphics_pipeline(Qs_GpuContext *gpu,
     VkVertexInputAttributeDescription *vk_attrs =
         calloc(total_attrs, sizeof(VkVertexInputAttributeDescription));
     if (!vk_bindings || !vk_attrs) {
-        free(vk_bindings); free(vk_attrs); return NULL;
+        free(vk_bindings); free(vk_attrs); free(spec_entries); return NULL;
     }
 
     uint32_t attr_idx = 0;
@@ -1130,11 +1434,14 @@ Qs_GpuPipeline *qs_gpu_create_graphics_pipeline(Qs_GpuContext *gpu,
         .rasterizationSamples = sample_count_to_vk(desc->sample_count),
     };
 
+    static const VkCompareOp compare_ops[] = {
+        VK_COMPARE_OP_LESS, VK_COMPARE_OP_EQUAL,
+    };
     VkPipelineDepthStencilStateCreateInfo depth_stencil = {
         .sType            = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
         .depthTestEnable  = desc->depth_test  ? VK_TRUE : VK_FALSE,
         .depthWriteEnable = desc->depth_write ? VK_TRUE : VK_FALSE,
-        .depthCompareOp   = VK_COMPARE_OP_LESS,
+        .depthCompareOp   = compare_ops[desc->depth_compare],
     };
 
     VkPipelineColorBlendAttachmentState blend_att = {
@@ -1187,11 +1494,39 @@ Qs_GpuPipeline *qs_gpu_create_graphics_pipeline(Qs_GpuContext *gpu,
                                                 &vk_pipeline);
     free(vk_bindings);
     free(vk_attrs);
+    free(spec_entries);
     if (result != VK_SUCCESS) return NULL;
 
     Qs_GpuPipeline *pipeline = calloc(1, sizeof(Qs_GpuPipeline));
     if (!pipeline) { vkDestroyPipeline(device, vk_pipeline, NULL); return NULL; }
-    pipeline->pipeline = vk_pipeline;
+    pipeline->pipeline   = vk_pipeline;
+    pipeline->bind_point = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    return pipeline;
+}
+
+Qs_GpuPipeline *qs_gpu_create_compute_pipeline(Qs_GpuContext *gpu,
+                                                 const Qs_GpuComputePipelineDesc *desc)
+{
+    VkDevice device = ca_gpu_device(to_ca(gpu));
+
+    VkComputePipelineCreateInfo ci = {
+        .sType  = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .stage  = {
+            .sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage  = VK_SHADER_STAGE_COMPUTE_BIT,
+            .module = desc->shader->module,
+            .pName  = "main",
+        },
+        .layout = desc->layout->layout,
+    };
+    VkPipeline vk_pipeline;
+    if (vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &ci, NULL, &vk_pipeline) != VK_SUCCESS)
+        return NULL;
+
+    Qs_GpuPipeline *pipeline = calloc(1, sizeof(Qs_GpuPipeline));
+    if (!pipeline) { vkDestroyPipeline(device, vk_pipeline, NULL); return NULL; }
+    pipeline->pipeline   = vk_pipeline;
+    pipeline->bind_point = VK_PIPELINE_BIND_POINT_COMPUTE;
     return pipeline;
 }
 
@@ -1221,6 +1556,131 @@ void qs_gpu_end_transfer(Qs_GpuContext *gpu, Qs_GpuCmd *cmd)
     free(cmd);
 }
 
+#define QS_GPU_MAX_QUEUE_FAMILIES 16
+
+/* Secondary buffers must come from a pool on the queue family of the
+   primary they execute in, and Causality does not report the family it
+   records frames on.  Frame primaries hold draws, so that family supports
+   graphics: when exactly one family does, it is the one.  With several
+   candidates the family is unknown and false is returned. */
+static bool graphics_queue_family(VkPhysicalDevice pd, uint32_t *out_family)
+{
+    VkQueueFamilyProperties props[QS_GPU_MAX_QUEUE_FAMILIES];
+    uint32_t count = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(pd, &count, NULL);
+    if (count > QS_GPU_MAX_QUEUE_FAMILIES) return false;
+    vkGetPhysicalDeviceQueueFamilyProperties(pd, &count, props);
+
+    uint32_t found = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        if (!(props[i].queueFlags & VK_QUEUE_GRAPHICS_BIT)) continue;
+        *out_family = i;
+        found++;
+    }
+    return found == 1;
+}
+
+Qs_GpuCmdPool *qs_gpu_create_cmd_pool(Qs_GpuContext *gpu)
+{
+    Ca_Instance *ca = to_ca(gpu);
+    uint32_t family;
+    if (!graphics_queue_family(ca_gpu_physical_device(ca), &family)) return NULL;
+    VkCommandPoolCreateInfo ci = {
+        .sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+        .flags            = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+        .queueFamilyIndex = family,
+    };
+    Qs_GpuCmdPool *pool = calloc(1, sizeof(Qs_GpuCmdPool));
+    if (!pool) return NULL;
+    if (vkCreateCommandPool(ca_gpu_device(ca), &ci, NULL, &pool->pool) != VK_SUCCESS) {
+        free(pool);
+        return NULL;
+    }
+    return pool;
+}
+
+void qs_gpu_destroy_cmd_pool(Qs_GpuContext *gpu, Qs_GpuCmdPool *pool)
+{
+    if (!pool) return;
+    vkDestroyCommandPool(ca_gpu_device(to_ca(gpu)), pool->pool, NULL);
+    for (uint32_t i = 0; i < pool->count; i++) free(pool->cmds[i]);
+    free(pool->cmds);
+    free(pool);
+}
+
+void qs_gpu_reset_cmd_pool(Qs_GpuContext *gpu, Qs_GpuCmdPool *pool)
+{
+    if (!pool->used) return;
+    vkResetCommandPool(ca_gpu_device(to_ca(gpu)), pool->pool, 0);
+    pool->used = 0;
+}
+
+Qs_GpuCmd *qs_gpu_begin_secondary(Qs_GpuContext *gpu, Qs_GpuCmdPool *pool,
+                                  const Qs_GpuRenderTarget *target)
+{
+    if (pool->used == pool->count) {
+        if (pool->count == pool->capacity) {
+            uint32_t cap = pool->capacity ? pool->capacity * 2 : 8;
+            Qs_GpuCmd **cmds = realloc(pool->cmds, cap * sizeof(Qs_GpuCmd *));
+            if (!cmds) return NULL;
+            pool->cmds     = cmds;
+            pool->capacity = cap;
+        }
+        Qs_GpuCmd *cmd = calloc(1, sizeof(Qs_GpuCmd));
+        if (!cmd) return NULL;
+        VkCommandBufferAllocateInfo ai = {
+            .sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            .commandPool        = pool->pool,
+            .level              = VK_COMMAND_BUFFER_LEVEL_SECONDARY,
+            .commandBufferCount = 1,
+        };
+        if (vkAllocateCommandBuffers(ca_gpu_device(to_ca(gpu)), &ai, &cmd->cmd) != VK_SUCCESS) {
+            free(cmd);
+            return NULL;
+        }
+        pool->cmds[pool->count++] = cmd;
+    }
+    Qs_GpuCmd *cmd = pool->cmds[pool->used];
+
+    const Qs_GpuImageView *ms = target->color ? target->color : target->depth;
+    VkFormat color_format = target->color ? target->color->format : VK_FORMAT_UNDEFINED;
+    VkCommandBufferInheritanceRenderingInfo rendering = {
+        .sType                   = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO,
+        .colorAttachmentCount    = target->color ? 1 : 0,
+        .pColorAttachmentFormats = target->color ? &color_format : NULL,
+        .depthAttachmentFormat   = target->depth ? target->depth->format : VK_FORMAT_UNDEFINED,
+        .rasterizationSamples    = ms ? ms->samples : VK_SAMPLE_COUNT_1_BIT,
+    };
+    VkCommandBufferInheritanceInfo inherit = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+        .pNext = &rendering,
+    };
+    VkCommandBufferBeginInfo bi = {
+        .sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags            = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT |
+                            VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT,
+        .pInheritanceInfo = &inherit,
+    };
+    if (vkBeginCommandBuffer(cmd->cmd, &bi) != VK_SUCCESS) return NULL;
+    pool->used++;
+    return cmd;
+}
+
+void qs_gpu_end_secondary(Qs_GpuCmd *cmd)
+{
+    vkEndCommandBuffer(cmd->cmd);
+}
+
+void qs_cmd_execute(Qs_GpuCmd *cmd, Qs_GpuCmd *const *secondaries, uint32_t count)
+{
+    VkCommandBuffer bufs[64];
+    for (uint32_t base = 0; base < count; base += 64) {
+        uint32_t n = count - base < 64 ? count - base : 64;
+        for (uint32_t i = 0; i < n; i++) bufs[i] = secondaries[base + i]->cmd;
+        vkCmdExecuteCommands(cmd->cmd, n, bufs);
+    }
+}
+
 void qs_cmd_begin_rendering(Qs_GpuCmd *cmd, const Qs_GpuRenderTarget *target)
 {
     VkRenderingAttachmentInfo color_att = {
@@ -1257,6 +1717,8 @@ void qs_cmd_begin_rendering(Qs_GpuCmd *cmd, const Qs_GpuRenderTarget *target)
         .pColorAttachments    = target->color ? &color_att : NULL,
         .pDepthAttachment     = target->depth ? &depth_att : NULL,
     };
+    if (target->secondary)
+        ri.flags = VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT;
     vkCmdBeginRendering(cmd->cmd, &ri);
 }
 
@@ -1275,13 +1737,13 @@ void qs_cmd_set_viewport(Qs_GpuCmd *cmd, uint32_t width, uint32_t height)
 
 void qs_cmd_bind_pipeline(Qs_GpuCmd *cmd, Qs_GpuPipeline *pipeline)
 {
-    vkCmdBindPipeline(cmd->cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->pipeline);
+    vkCmdBindPipeline(cmd->cmd, pipeline->bind_point, pipeline->pipeline);
 }
 
 void qs_cmd_bind_descriptor_set(Qs_GpuCmd *cmd, Qs_GpuPipelineLayout *layout,
                                  uint32_t set_index, Qs_GpuDescriptorSet *set)
 {
-    vkCmdBindDescriptorSets(cmd->cmd, VK_PIPELINE_BIND_POINT_GRAPHICS,
+    vkCmdBindDescriptorSets(cmd->cmd, layout->bind_point,
                             layout->layout, set_index, 1, &set->set, 0, NULL);
 }
 
@@ -1317,11 +1779,114 @@ void qs_cmd_draw_indexed(Qs_GpuCmd *cmd, uint32_t index_count,
     vkCmdDrawIndexed(cmd->cmd, index_count, 1, first_index, vertex_offset, 0);
 }
 
+void qs_cmd_draw_instanced(Qs_GpuCmd *cmd, uint32_t vertex_count, uint32_t first_vertex,
+                            uint32_t instance_count, uint32_t first_instance)
+{
+    vkCmdDraw(cmd->cmd, vertex_count, instance_count, first_vertex, first_instance);
+}
+
+void qs_cmd_draw_indexed_instanced(Qs_GpuCmd *cmd, uint32_t index_count,
+                                    uint32_t first_index, int32_t vertex_offset,
+                                    uint32_t instance_count, uint32_t first_instance)
+{
+    vkCmdDrawIndexed(cmd->cmd, index_count, instance_count, first_index,
+                     vertex_offset, first_instance);
+}
+
+void qs_cmd_draw_indirect(Qs_GpuCmd *cmd, Qs_GpuBuffer *buffer, uint64_t offset,
+                          uint32_t draw_count, uint32_t stride)
+{
+    vkCmdDrawIndirect(cmd->cmd, buffer->buffer, (VkDeviceSize)offset, draw_count, stride);
+}
+
+void qs_cmd_draw_indexed_indirect(Qs_GpuCmd *cmd, Qs_GpuBuffer *buffer, uint64_t offset,
+                                   uint32_t draw_count, uint32_t stride)
+{
+    vkCmdDrawIndexedIndirect(cmd->cmd, buffer->buffer, (VkDeviceSize)offset,
+                             draw_count, stride);
+}
+
+void qs_cmd_dispatch(Qs_GpuCmd *cmd, uint32_t groups_x, uint32_t groups_y, uint32_t groups_z)
+{
+    vkCmdDispatch(cmd->cmd, groups_x, groups_y, groups_z);
+}
+
+static void access_to_vk(Qs_GpuAccess access, VkPipelineStageFlags *stages,
+                         VkAccessFlags *flags)
+{
+    *stages = 0;
+    *flags  = 0;
+    if (access & QS_GPU_ACCESS_TRANSFER_WRITE) {
+        *stages |= VK_PIPELINE_STAGE_TRANSFER_BIT;
+        *flags  |= VK_ACCESS_TRANSFER_WRITE_BIT;
+    }
+    if (access & QS_GPU_ACCESS_COMPUTE_READ) {
+        *stages |= VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+        *flags  |= VK_ACCESS_SHADER_READ_BIT;
+    }
+    if (access & QS_GPU_ACCESS_COMPUTE_WRITE) {
+        *stages |= VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+        *flags  |= VK_ACCESS_SHADER_WRITE_BIT;
+    }
+    if (access & QS_GPU_ACCESS_VERTEX_READ) {
+        *stages |= VK_PIPELINE_STAGE_VERTEX_SHADER_BIT;
+        *flags  |= VK_ACCESS_SHADER_READ_BIT;
+    }
+    if (access & QS_GPU_ACCESS_INDIRECT_READ) {
+        *stages |= VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT;
+        *flags  |= VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+    }
+    if (access & QS_GPU_ACCESS_FRAGMENT_READ) {
+        *stages |= VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+        *flags  |= VK_ACCESS_SHADER_READ_BIT;
+    }
+}
+
+void qs_cmd_buffer_barrier(Qs_GpuCmd *cmd, const Qs_GpuBufferBarrier *barrier)
+{
+    VkPipelineStageFlags src_stages, dst_stages;
+    VkAccessFlags        src_access, dst_access;
+    access_to_vk(barrier->src, &src_stages, &src_access);
+    access_to_vk(barrier->dst, &dst_stages, &dst_access);
+
+    VkBufferMemoryBarrier b = {
+        .sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+        .srcAccessMask       = src_access,
+        .dstAccessMask       = dst_access,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .buffer              = barrier->buffer->buffer,
+        .offset              = 0,
+        .size                = VK_WHOLE_SIZE,
+    };
+    vkCmdPipelineBarrier(cmd->cmd, src_stages, dst_stages, 0,
+                         0, NULL, 1, &b, 0, NULL);
+}
+
+void qs_cmd_copy_buffer(Qs_GpuCmd *cmd, Qs_GpuBuffer *src, Qs_GpuBuffer *dst,
+                         const Qs_GpuBufferCopy *regions, uint32_t region_count)
+{
+    VkBufferCopy vk[64];
+    for (uint32_t base = 0; base < region_count; base += 64) {
+        uint32_t n = region_count - base < 64 ? region_count - base : 64;
+        for (uint32_t i = 0; i < n; i++) {
+            vk[i] = (VkBufferCopy){
+                .srcOffset = (VkDeviceSize)regions[base + i].src_offset,
+                .dstOffset = (VkDeviceSize)regions[base + i].dst_offset,
+                .size      = (VkDeviceSize)regions[base + i].size,
+            };
+        }
+        vkCmdCopyBuffer(cmd->cmd, src->buffer, dst->buffer, n, vk);
+    }
+}
+
 void qs_cmd_image_barrier(Qs_GpuCmd *cmd, const Qs_GpuImageBarrier *barrier)
 {
+    Qs_GpuImageLayout src = barrier->old_layout == QS_GPU_IMAGE_LAYOUT_UNDEFINED
+                          ? barrier->wait_layout : barrier->old_layout;
     VkImageMemoryBarrier b = {
         .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-        .srcAccessMask       = layout_to_access(barrier->old_layout),
+        .srcAccessMask       = layout_to_access(src),
         .dstAccessMask       = layout_to_access(barrier->new_layout),
         .oldLayout           = layout_to_vk(barrier->old_layout),
         .newLayout           = layout_to_vk(barrier->new_layout),
@@ -1337,7 +1902,7 @@ void qs_cmd_image_barrier(Qs_GpuCmd *cmd, const Qs_GpuImageBarrier *barrier)
         },
     };
     vkCmdPipelineBarrier(cmd->cmd,
-        layout_to_src_stage(barrier->old_layout),
+        layout_to_src_stage(src),
         layout_to_dst_stage(barrier->new_layout),
         0, 0, NULL, 0, NULL, 1, &b);
 }
@@ -1367,6 +1932,18 @@ void qs_cmd_copy_image_to_buffer(Qs_GpuCmd *cmd, Qs_GpuImage *src,
                            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, dst->buffer, 1, &region);
 }
 
+void qs_cmd_copy_image(Qs_GpuCmd *cmd, Qs_GpuImage *src, Qs_GpuImage *dst,
+                       Qs_GpuImageAspect aspect, uint32_t width, uint32_t height)
+{
+    VkImageCopy region = {
+        .srcSubresource = { aspect_to_vk(aspect), 0, 0, 1 },
+        .dstSubresource = { aspect_to_vk(aspect), 0, 0, 1 },
+        .extent         = { width, height, 1 },
+    };
+    vkCmdCopyImage(cmd->cmd, src->image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                   dst->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+}
+
 void qs_cmd_blit_image_mip(Qs_GpuCmd *cmd, Qs_GpuImage *image,
                             uint32_t src_mip, uint32_t src_w, uint32_t src_h,
                             uint32_t dst_mip, uint32_t dst_w, uint32_t dst_h)
@@ -38,6 +38,11 @@
 
 #define QS_MAX_PATH 1024
 
+/* Startup timeline hooks — defined in engine.c, not part of the public API. */
+uint32_t qs_engine_startup_begin(Qs_Engine *engine, const char *category,
+                                 const char *name);
+void     qs_engine_startup_end(Qs_Engine *engine, uint32_t slot);
+
 /* ================================================================
    INTERNAL TYPES
    ================================================================ */
@@ -193,16 +198,39 @@ static void save_state(Qs_PluginManager *pm)
    LOAD / UNLOAD ONE PLUGIN
    ================================================================ */
 
-static bool plugin_load(Qs_PluginManager *pm, Qs_PluginState *s)
+static const char *path_basename(const char *path)
 {
-    if (s->loaded) return true;
+    const char *base = path;
+    for (const char *p = path; *p; p++)
+        if (*p == '/' || *p == '\\') base = p + 1;
+    return base;
+}
+
+/* Opens the library and resolves its descriptor without running any plugin
+   code besides static initialisers and the entry function, so it is safe
+   to run for several plugins concurrently. */
+/* The log writer formats records after the fact and keeps only their
+   format pointers, which may point into the library's string table:
+   drain the rings before the image is unmapped. */
+static void plugin_lib_close(Qs_Dylib *lib)
+{
+    qs_log_flush();
+    qs_dylib_close(lib);
+}
+
+static bool plugin_open(Qs_PluginManager *pm, Qs_PluginState *s)
+{
+    if (s->lib) return true;
     if (s->path[0] == '\0') return false;
 
+    uint32_t step = qs_engine_startup_begin(pm->engine, "plugin.open",
+                                            path_basename(s->path));
     Qs_Dylib *lib = qs_dylib_open(s->path);
     if (!lib) {
         QS_LOG_ERROR("Plugin '%s': failed to open library: %s",
                      s->id[0] ? s->id : s->path,
                      qs_dylib_error() ? qs_dylib_error() : "unknown");
+        qs_engine_startup_end(pm->engine, step);
         return false;
     }
 
@@ -211,14 +239,16 @@ static bool plugin_load(Qs_PluginManager *pm, Qs_PluginState *s)
     if (!entry_fn) {
         QS_LOG_ERROR("Plugin '%s': symbol '%s' not found",
                      s->path, QS_PLUGIN_ENTRY_SYMBOL);
-        qs_dylib_close(lib);
+        plugin_lib_close(lib);
+        qs_engine_startup_end(pm->engine, step);
         return false;
     }
 
     const Qs_PluginDesc *desc = entry_fn();
     if (!desc) {
         QS_LOG_ERROR("Plugin '%s': entry returned NULL descriptor", s->path);
-        qs_dylib_close(lib);
+        plugin_lib_close(lib);
+        qs_engine_startup_end(pm->engine, step);
         return false;
     }
 
@@ -226,7 +256,8 @@ static bool plugin_load(Qs_PluginManager *pm, Qs_PluginState *s)
         QS_LOG_ERROR("Plugin '%s': API version mismatch (plugin=%u, engine=%u)",
                      desc->name ? desc->name : s->path,
                      desc->api_version, QS_PLUGIN_API_VERSION);
-        qs_dylib_close(lib);
+        plugin_lib_close(lib);
+        qs_engine_startup_end(pm->engine, step);
         return false;
     }
 
@@ -235,16 +266,82 @@ static bool plugin_load(Qs_PluginManager *pm, Qs_PluginState *s)
     if (desc->version) snprintf(s->version, sizeof(s->version), "%s", desc->version);
     if (desc->author)  snprintf(s->author,  sizeof(s->author),  "%s", desc->author);
 
-    s->lib    = lib;
-    s->desc   = desc;
+    s->lib  = lib;
+    s->desc = desc;
+    qs_engine_startup_end(pm->engine, step);
+    return true;
+}
+
+/* Runs on_load for an opened plugin. Main thread only — on_load registers
+   systems and extensions whose order matters. */
+static void plugin_activate(Qs_PluginManager *pm, Qs_PluginState *s)
+{
+    const Qs_PluginDesc *desc = s->desc;
     s->loaded = true;
 
+    uint32_t step = qs_engine_startup_begin(pm->engine, "plugin.load",
+                                            desc->name ? desc->name : s->id);
     if (desc->on_load) desc->on_load(pm->engine);
+    qs_engine_startup_end(pm->engine, step);
 
     QS_LOG_INFO("Plugin '%s' v%s loaded", desc->name, desc->version);
+}
+
+static bool plugin_load(Qs_PluginManager *pm, Qs_PluginState *s)
+{
+    if (s->loaded) return true;
+    if (!plugin_open(pm, s)) return false;
+    plugin_activate(pm, s);
     return true;
 }
 
+typedef struct PluginOpenTask {
+    Qs_PluginManager *pm;
+    Qs_PluginState   *state;
+} PluginOpenTask;
+
+static void plugin_open_job(void *data)
+{
+    PluginOpenTask *task = data;
+    plugin_open(task->pm, task->state);
+}
+
+/* Opens every discovered library, spreading dlopen and symbol resolution
+   across the job system. Falls back to opening inline if no job system or
+   scratch memory is available. */
+static void plugins_open_all(Qs_PluginManager *pm)
+{
+    Qs_JobSystem *jobs = qs_engine_job_system(pm->engine);
+    PluginOpenTask *tasks = pm->count > 1 && jobs
+        ? malloc(pm->count * sizeof(PluginOpenTask)) : NULL;
+    Qs_JobDesc *descs = tasks ? malloc(pm->count * sizeof(Qs_JobDesc)) : NULL;
+    Qs_JobCounter *counter = descs ? qs_job_counter_create(jobs) : NULL;
+
+    if (!counter) {
+        for (uint32_t i = 0; i < pm->count; i++)
+            plugin_open(pm, &pm->entries[i]);
+    } else {
+        for (uint32_t i = 0; i < pm->count; i++) {
+            tasks[i] = (PluginOpenTask){ pm, &pm->entries[i] };
+            descs[i] = (Qs_JobDesc){ .fn = plugin_open_job, .data = &tasks[i],
+                                     .name = "plugin_open" };
+        }
+        qs_job_dispatch_batch(jobs, descs, pm->count, counter);
+        qs_job_wait(jobs, counter);
+        qs_job_counter_destroy(jobs, counter);
+    }
+    free(descs);
+    free(tasks);
+}
+
+static void plugin_close(Qs_PluginState *s)
+{
+    plugin_lib_close(s->lib);
+    s->lib    = NULL;
+    s->desc   = NULL;
+    s->loaded = false;
+}
+
 static void plugin_unload(Qs_PluginManager *pm, Qs_PluginState *s)
 {
     if (!s->loaded) return;
@@ -255,10 +352,7 @@ static void plugin_unload(Qs_PluginManager *pm, Qs_PluginState *s)
     QS_LOG_INFO("Plugin '%s' unloaded",
                 s->desc && s->desc->name ? s->desc->name : s->id);
 
-    qs_dylib_close(s->lib);
-    s->lib    = NULL;
-    s->desc   = NULL;
-    s->loaded = false;
+    plugin_close(s);
 }
 
 /* ================================================================
@@ -388,21 +482,19 @@ void qs_plugin_manager_scan(Qs_PluginManager *pm)
     /* 1. Discover plugin libraries on disk */
     discover_plugins(pm);
 
-    /* 2. Load ALL to get their IDs and descriptors */
-    for (uint32_t i = 0; i < pm->count; i++) {
-        Qs_PluginState *s = &pm->entries[i];
-        if (!s->loaded && s->path[0])
-            plugin_load(pm, s);
-    }
+    /* 2. Open ALL in parallel to get their IDs and descriptors */
+    plugins_open_all(pm);
 
     /* 3. Apply saved enable/disable state (now IDs are known) */
     if (pm->state_path[0]) load_state(pm);
 
-    /* 4. Unload any that the state file says should be disabled */
+    /* 4. Run on_load in discovery order for enabled plugins; close the
+          libraries of disabled ones without ever running their code. */
     for (uint32_t i = 0; i < pm->count; i++) {
         Qs_PluginState *s = &pm->entries[i];
-        if (!s->enabled && s->loaded)
-            plugin_unload(pm, s);
+        if (!s->lib || s->loaded) continue;
+        if (s->enabled) plugin_activate(pm, s);
+        else            plugin_close(s);
     }
 
     save_state(pm);
@@ -573,7 +665,7 @@ struct Qs_Dylib {
 #endif
 };
 
-static char s_error_buf[512];
+static _Thread_local char s_error_buf[512];
 
 /* ================================================================
    API
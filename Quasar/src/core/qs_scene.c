@@ -8,6 +8,7 @@
 #include "qs_mesh.h"
 #include "qs_material.h"
 #include "qs_project.h"
+#include "qs_job.h"
 #include "quasar.h"
 #include "cJSON.h"
 
@@ -31,6 +32,15 @@ static void resolve_path(const Qs_Scene *scene, const char *rel,
 #define QS_MAX_ENTITIES         4096
 #define QS_MAX_COMPONENT_TYPES  64
 #define QS_ENTITY_MASK_WORDS    ((QS_MAX_ENTITIES + 63) / 64)
+#define QS_MAX_HIERARCHY_DEPTH  64
+/* Hard cap on prototype recursion depth.  This is a defense-in-depth
+   guard: cyclic prototype references are supposed to be rejected at
+   edit time (see qs_prototype_would_create_cycle) and at save time,
+   but a corrupted file on disk could still bring the runtime down
+   without this safety net. */
+#define QS_PROTO_RUNTIME_DEPTH_MAX 16
+/* MeshComp entities per render-sync job. */
+#define QS_SCENE_SYNC_CHUNK     256
 
 /* ================================================================
    INTERNAL TYPES
@@ -84,6 +94,23 @@ struct Qs_Scene {
     /* Component storage — one per registered type */
     ComponentStore    stores[QS_MAX_COMPONENT_TYPES];
 
+    /* World transforms retained between render syncs (allocated on first sync) */
+    Qs_Transform     *xf_local;                        /* local transform at last update */
+    float           (*xf_world)[16];                   /* world matrix at last update    */
+    uint64_t          xf_valid[QS_ENTITY_MASK_WORDS];  /* cache entry populated          */
+    uint64_t          xf_moved[QS_ENTITY_MASK_WORDS];  /* world changed this sync        */
+    uint64_t          xf_done[QS_ENTITY_MASK_WORDS];   /* resolved this sync             */
+    float             xf_parent_world[16];
+    bool              xf_parent_valid;
+
+    /* Render sync scratch, reused by syncs rooted at this scene */
+    struct SceneSyncTask *sync_tasks;
+    Qs_JobDesc           *sync_jobs;
+    struct SceneProxyOp  *sync_ops;
+    uint32_t              sync_task_capacity;
+    uint32_t              sync_op_capacity;
+    Qs_JobCounter        *sync_counter;
+
     /* Callbacks */
     Qs_SceneCallback  on_activate;
     Qs_SceneCallback  on_deactivate;
@@ -260,12 +287,23 @@ static void mesh_comp_init(void *comp, Qs_Scene *scene, Qs_Entity entity)
     (void)scene; (void)entity;
     Qs_MeshComp *mc = (Qs_MeshComp *)comp;
     mc->visible = true;
+    mc->tint[0] = mc->tint[1] = mc->tint[2] = mc->tint[3] = 1.0f;
+    mc->proxy   = QS_RENDER_PROXY_INVALID;
+}
+
+static void mesh_comp_release_proxy(Qs_MeshComp *mc)
+{
+    if (mc->proxy_renderer)
+        qs_renderer_proxy_destroy(mc->proxy_renderer, mc->proxy);
+    mc->proxy_renderer = NULL;
+    mc->proxy          = QS_RENDER_PROXY_INVALID;
 }
 
 static void mesh_comp_destroy(void *comp, Qs_Scene *scene, Qs_Entity entity)
 {
     (void)entity;
     Qs_MeshComp *mc = (Qs_MeshComp *)comp;
+    mesh_comp_release_proxy(mc);
     if (mc->mesh_path[0]) {
         char abs[1024];
         resolve_path(scene, mc->mesh_path, abs, sizeof(abs));
@@ -558,6 +596,7 @@ static const Qs_TypeInfo s_transform_type_info = {
 
 static const Qs_FieldInfo s_mesh_comp_fields[] = {
     QS_FIELD(Qs_MeshComp, visible,       QS_FIELD_BOOL),
+    QS_FIELD(Qs_MeshComp, tint,          QS_FIELD_FLOAT4),
     QS_FIELD(Qs_MeshComp, mesh_path,     QS_FIELD_STRING),
     QS_FIELD(Qs_MeshComp, material_path, QS_FIELD_STRING),
 };
@@ -694,6 +733,48 @@ static void register_builtin_types(Qs_Engine *engine)
     });
 }
 
+/* ================================================================
+   RENDER PROXY RELEASE
+   ================================================================ */
+
+/// Destroys the render proxies of every MeshComp in `scene` and in its
+/// loaded prototype scenes.
+static void scene_release_proxies(Qs_Scene *scene, int depth)
+{
+    if (depth >= QS_PROTO_RUNTIME_DEPTH_MAX) return;
+
+    if (s_mesh_comp_type) {
+        const ComponentStore *store = &scene->stores[s_mesh_comp_type->index];
+        for (uint32_t i = 0; i < store->count; i++)
+            mesh_comp_release_proxy((Qs_MeshComp *)(store->data +
+                (size_t)i * s_mesh_comp_type->data_size));
+    }
+    if (s_prototype_comp_type) {
+        const ComponentStore *store = &scene->stores[s_prototype_comp_type->index];
+        for (uint32_t i = 0; i < store->count; i++) {
+            Qs_PrototypeComp *pc = (Qs_PrototypeComp *)(store->data +
+                (size_t)i * s_prototype_comp_type->data_size);
+            if (pc->inner) scene_release_proxies(pc->inner, depth + 1);
+        }
+    }
+}
+
+/// Called by qs_renderer_destroy before the renderer frees its proxy pool.
+void qs_scene_release_renderer(Qs_Renderer *renderer)
+{
+    if (!g_scene_system || !s_mesh_comp_type) return;
+    for (uint32_t s = 0; s < QS_MAX_SCENES; s++) {
+        Qs_Scene *scene = g_scene_system->scenes[s];
+        if (!scene) continue;
+        const ComponentStore *store = &scene->stores[s_mesh_comp_type->index];
+        for (uint32_t i = 0; i < store->count; i++) {
+            Qs_MeshComp *mc = (Qs_MeshComp *)(store->data +
+                (size_t)i * s_mesh_comp_type->data_size);
+            if (mc->proxy_renderer == renderer) mesh_comp_release_proxy(mc);
+        }
+    }
+}
+
 /* ================================================================
    SCENE LIFECYCLE
    ================================================================ */
@@ -760,6 +841,16 @@ void qs_scene_destroy(Qs_Scene *scene)
         free(scene->stores[t].sparse);  scene->stores[t].sparse = NULL;
         free(scene->stores[t].dense);   scene->stores[t].dense  = NULL;
     }
+    free(scene->xf_local);  scene->xf_local = NULL;
+    free(scene->xf_world);  scene->xf_world = NULL;
+    free(scene->sync_tasks); scene->sync_tasks = NULL;
+    free(scene->sync_jobs);  scene->sync_jobs  = NULL;
+    free(scene->sync_ops);   scene->sync_ops   = NULL;
+    if (scene->sync_counter) {
+        qs_job_counter_destroy(qs_engine_job_system(g_scene_system->engine),
+                               scene->sync_counter);
+        scene->sync_counter = NULL;
+    }
 
     /* Remove from system array */
     for (uint32_t i = 0; i < QS_MAX_SCENES; i++) {
@@ -789,8 +880,11 @@ void qs_scene_set_active(Qs_Scene *scene)
     Qs_Scene *prev = g_scene_system->active_scene;
     if (prev == scene) return;
 
-    if (prev && prev->on_deactivate)
-        prev->on_deactivate(prev, prev->user_data);
+    if (prev) {
+        scene_release_proxies(prev, 0);
+        if (prev->on_deactivate)
+            prev->on_deactivate(prev, prev->user_data);
+    }
 
     g_scene_system->active_scene = scene;
 
@@ -871,6 +965,7 @@ void qs_entity_destroy(Qs_Scene *scene, Qs_Entity entity)
 
     bit_clear(scene->alive, entity);
     bit_clear(scene->enabled, entity);
+    bit_clear(scene->xf_valid, entity);
     scene->entity_names[entity][0] = '\0';
     scene->parent_entity[entity]   = QS_ENTITY_INVALID;
     if (scene->entity_count > 0) scene->entity_count--;
@@ -926,6 +1021,7 @@ void qs_entity_set_parent(Qs_Scene *scene, Qs_Entity entity, Qs_Entity parent)
         return;
     }
     scene->parent_entity[entity] = parent;
+    bit_clear(scene->xf_valid, entity);
 }
 
 Qs_Entity qs_entity_get_parent(const Qs_Scene *scene, Qs_Entity entity)
@@ -1538,6 +1634,116 @@ void qs_scene_world_matrix(const Qs_Scene *scene, Qs_Entity entity,
     }
 }
 
+/* ================================================================
+   RETAINED WORLD TRANSFORMS
+   Render sync resolves world matrices lazily (an entity and its
+   ancestors, once per sync) and recomposes only entities whose own
+   Transform, parent or ancestors changed since the previous sync.
+   ================================================================ */
+
+static const Qs_Transform s_identity_transform = {
+    .rotation = { 0.0f, 0.0f, 0.0f, 1.0f },
+    .scale    = { 1.0f, 1.0f, 1.0f },
+};
+
+/// Starts a sync pass.  Returns false if the cache cannot be allocated.
+static bool scene_xf_begin(Qs_Scene *scene, const float parent_world[16],
+                           bool *out_root_moved)
+{
+    if (!scene->xf_world) {
+        scene->xf_local = malloc(QS_MAX_ENTITIES * sizeof(*scene->xf_local));
+        scene->xf_world = malloc(QS_MAX_ENTITIES * sizeof(*scene->xf_world));
+        if (!scene->xf_local || !scene->xf_world) {
+            free(scene->xf_local); scene->xf_local = NULL;
+            free(scene->xf_world); scene->xf_world = NULL;
+            return false;
+        }
+        memset(scene->xf_valid, 0, sizeof(scene->xf_valid));
+        scene->xf_parent_valid = false;
+    }
+
+    *out_root_moved = !scene->xf_parent_valid ||
+                      memcmp(scene->xf_parent_world, parent_world,
+                             sizeof(scene->xf_parent_world)) != 0;
+    if (*out_root_moved) {
+        memcpy(scene->xf_parent_world, parent_world, sizeof(scene->xf_parent_world));
+        scene->xf_parent_valid = true;
+    }
+    memset(scene->xf_moved, 0, sizeof(scene->xf_moved));
+    memset(scene->xf_done,  0, sizeof(scene->xf_done));
+    return true;
+}
+
+/// Brings xf_world[entity] and its ancestors up to date for this sync.
+/// Returns true if the entity's world matrix changed.
+static bool scene_xf_resolve(Qs_Scene *scene, Qs_Entity entity, bool root_moved)
+{
+    Qs_Entity chain[QS_MAX_HIERARCHY_DEPTH];
+    int depth = 0;
+    for (Qs_Entity e = entity;
+         e != QS_ENTITY_INVALID && depth < QS_MAX_HIERARCHY_DEPTH &&
+         !bit_test(scene->xf_done, e);
+         e = scene->parent_entity[e])
+    {
+        chain[depth++] = e;
+    }
+
+    /* Root down to leaf: world = parent_world * ... * parent * local */
+    for (int i = depth - 1; i >= 0; i--) {
+        Qs_Entity e = chain[i];
+        Qs_Entity p = scene->parent_entity[e];
+        bool has_parent = p != QS_ENTITY_INVALID && bit_test(scene->xf_done, p);
+        bool moved = has_parent ? bit_test(scene->xf_moved, p) : root_moved;
+
+        const Qs_Transform *t = (const Qs_Transform *)qs_entity_get(
+            scene, e, s_transform_type);
+        if (!t) t = &s_identity_transform;
+        if (!bit_test(scene->xf_valid, e) ||
+            memcmp(t, &scene->xf_local[e], sizeof(*t)) != 0)
+            moved = true;
+
+        if (moved) {
+            float local[16];
+            qs_m4_from_trs(local, t->position, t->rotation, t->scale);
+            qs_m4_mul(has_parent ? scene->xf_world[p] : scene->xf_parent_world,
+                      local, scene->xf_world[e]);
+            scene->xf_local[e] = *t;
+            bit_set(scene->xf_valid, e);
+            bit_set(scene->xf_moved, e);
+        }
+        bit_set(scene->xf_done, e);
+    }
+    return bit_test(scene->xf_moved, entity);
+}
+
+/// Brings xf_world[entity] up to date when its parent is already resolved
+/// this sync.  Touches only the entity's own cache slots and leaves the
+/// cache bits to the caller, so disjoint leaves may resolve concurrently.
+static bool scene_xf_resolve_leaf(Qs_Scene *scene, Qs_Entity entity, bool root_moved)
+{
+    if (bit_test(scene->xf_done, entity)) return bit_test(scene->xf_moved, entity);
+
+    Qs_Entity p = scene->parent_entity[entity];
+    bool has_parent = p != QS_ENTITY_INVALID && bit_test(scene->xf_done, p);
+    bool moved = has_parent ? bit_test(scene->xf_moved, p) : root_moved;
+
+    const Qs_Transform *t = (const Qs_Transform *)qs_entity_get(
+        scene, entity, s_transform_type);
+    if (!t) t = &s_identity_transform;
+    if (!bit_test(scene->xf_valid, entity) ||
+        memcmp(t, &scene->xf_local[entity], sizeof(*t)) != 0)
+        moved = true;
+
+    if (moved) {
+        float local[16];
+        qs_m4_from_trs(local, t->position, t->rotation, t->scale);
+        qs_m4_mul(has_parent ? scene->xf_world[p] : scene->xf_parent_world,
+                  local, scene->xf_world[entity]);
+        scene->xf_local[entity] = *t;
+    }
+    return moved;
+}
+
 /* ================================================================
    ASSET RESOLUTION + RENDERABLE SUBMISSION
    ================================================================ */
@@ -1634,114 +1840,258 @@ void qs_scene_resolve_assets(Qs_Scene *scene, Qs_Engine *engine)
     }
 }
 
-void qs_scene_submit_renderables(Qs_Scene *scene,
-                                 Qs_Engine *engine,
-                                 Qs_Renderer *renderer,
-                                 const float parent_world[16])
-{
-    if (!scene || !renderer) return;
+/* Render sync runs in three phases.  A serial gather walks the scene and
+   its prototype instances (lazy loads, overrides, ancestor transforms)
+   and splits every MeshComp dense array into chunks.  Chunks run as jobs,
+   each resolving its leaf transforms and bounds into its own op slice,
+   since the renderer's proxy API is single-threaded.  A prefix sum then
+   compacts the slices in chunk order and the ops are applied serially. */
 
-    /* Hard cap on prototype recursion depth.  This is a defense-in-depth
-       guard: cyclic prototype references are supposed to be rejected at
-       edit time (see qs_prototype_would_create_cycle) and at save time,
-       but a corrupted file on disk could still bring the runtime down
-       without this safety net. */
-    enum { QS_PROTO_RUNTIME_DEPTH_MAX = 16 };
-    static int s_proto_recursion_depth;
-    if (s_proto_recursion_depth >= QS_PROTO_RUNTIME_DEPTH_MAX) {
-        static bool warned;
-        if (!warned) {
-            QS_LOG_ERROR("Prototype recursion depth exceeded (%d) — "
-                         "cyclic .qproto reference detected, aborting submit",
-                         QS_PROTO_RUNTIME_DEPTH_MAX);
-            warned = true;
-        }
+enum {
+    SCENE_OP_RELEASE   = 1u << 0,
+    SCENE_OP_CREATE    = 1u << 1,
+    SCENE_OP_GEOMETRY  = 1u << 2,
+    SCENE_OP_TRANSFORM = 1u << 3,
+    SCENE_OP_TINT      = 1u << 4,
+};
+
+typedef struct SceneProxyOp {
+    Qs_Scene    *scene;
+    Qs_MeshComp *mc;
+    Qs_Entity    entity;
+    uint32_t     flags;
+    uint32_t     material_version;
+    Qs_AABB      bounds;
+} SceneProxyOp;
+
+typedef struct SceneSyncTask {
+    Qs_Scene     *scene;
+    Qs_Renderer  *renderer;
+    SceneProxyOp *ops;        /* slice of capacity end - begin */
+    uint32_t      op_base;
+    uint32_t      op_count;
+    uint32_t      begin;
+    uint32_t      end;
+    bool          root_moved;
+} SceneSyncTask;
+
+typedef struct SceneSync {
+    Qs_Scene    *root;
+    Qs_Engine   *engine;
+    Qs_Renderer *renderer;
+    uint32_t     task_count;
+    uint32_t     op_total;
+    bool         failed;
+} SceneSync;
+
+static void scene_sync_entity(SceneSyncTask *task, Qs_Entity e, Qs_MeshComp *mc)
+{
+    Qs_Renderer *renderer = task->renderer;
+    uint32_t flags = 0;
+    if (mc->proxy_renderer && mc->proxy_renderer != renderer)
+        flags |= SCENE_OP_RELEASE;
+
+    SceneProxyOp *op = &task->ops[task->op_count];
+    if (!mc->visible || !mc->mesh || !mc->material) {
+        if (!mc->proxy_renderer) return;
+        *op = (SceneProxyOp){ .scene = task->scene, .mc = mc, .entity = e,
+                              .flags = SCENE_OP_RELEASE };
+        task->op_count++;
         return;
     }
 
-    float identity[16];
-    if (!parent_world) {
-        qs_m4_identity(identity);
-        parent_world = identity;
+    bool moved = scene_xf_resolve_leaf(task->scene, e, task->root_moved);
+    uint32_t mat_version = qs_material_version(mc->material);
+
+    if (mc->proxy_renderer != renderer) {
+        flags |= SCENE_OP_CREATE;
+    } else {
+        if (mc->proxy_mesh != mc->mesh || mc->proxy_material != mc->material ||
+            mc->proxy_material_version != mat_version)
+            flags |= SCENE_OP_GEOMETRY;
+        if (moved || mc->proxy_mesh != mc->mesh)
+            flags |= SCENE_OP_TRANSFORM;
+        if (memcmp(mc->proxy_tint, mc->tint, sizeof(mc->tint)) != 0)
+            flags |= SCENE_OP_TINT;
+    }
+    if (!flags) return;
+
+    *op = (SceneProxyOp){ .scene = task->scene, .mc = mc, .entity = e,
+                          .flags = flags, .material_version = mat_version };
+    if (flags & (SCENE_OP_CREATE | SCENE_OP_TRANSFORM))
+        qs_aabb_transform(qs_mesh_bounds(mc->mesh), task->scene->xf_world[e],
+                          &op->bounds);
+    task->op_count++;
+}
+
+static void scene_sync_task_run(void *data)
+{
+    SceneSyncTask *task = data;
+    const ComponentStore *store = &task->scene->stores[s_mesh_comp_type->index];
+    task->op_count = 0;
+    for (uint32_t i = task->begin; i < task->end; i++)
+        scene_sync_entity(task, store->dense[i],
+                          (Qs_MeshComp *)(store->data + (size_t)i * s_mesh_comp_type->data_size));
+}
+
+static void scene_proxy_apply(const SceneProxyOp *op, Qs_Renderer *renderer)
+{
+    Qs_MeshComp *mc = op->mc;
+    if (op->flags & SCENE_OP_RELEASE) mesh_comp_release_proxy(mc);
+    if (op->flags == SCENE_OP_RELEASE) return;
+
+    bit_set(op->scene->xf_valid, op->entity);
+    const float *world = op->scene->xf_world[op->entity];
+
+    if (op->flags & SCENE_OP_CREATE) {
+        Qs_RenderableDesc r = {
+            .mesh            = mc->mesh,
+            .material        = mc->material,
+            .entity          = op->entity,
+            .bounds          = op->bounds,
+            .cast_shadows    = true,
+            .receive_shadows = true,
+        };
+        memcpy(r.transform, world, sizeof(r.transform));
+        memcpy(r.tint, mc->tint, sizeof(r.tint));
+        mc->proxy = qs_renderer_proxy_create(renderer, &r);
+        if (mc->proxy == QS_RENDER_PROXY_INVALID) return;
+        mc->proxy_renderer = renderer;
+    } else {
+        if (op->flags & SCENE_OP_GEOMETRY)
+            qs_renderer_proxy_set_geometry(renderer, mc->proxy, mc->mesh, mc->material);
+        if (op->flags & SCENE_OP_TRANSFORM)
+            qs_renderer_proxy_set_transform(renderer, mc->proxy, world, &op->bounds);
+        if (op->flags & SCENE_OP_TINT)
+            qs_renderer_proxy_set_tint(renderer, mc->proxy, mc->tint);
+    }
+    memcpy(mc->proxy_tint, mc->tint, sizeof(mc->tint));
+    mc->proxy_mesh             = mc->mesh;
+    mc->proxy_material         = mc->material;
+    mc->proxy_material_version = op->material_version;
+}
+
+static bool scene_sync_reserve_tasks(Qs_Scene *root, uint32_t count)
+{
+    if (count <= root->sync_task_capacity) return true;
+    uint32_t cap = root->sync_task_capacity ? root->sync_task_capacity * 2 : 16;
+    while (cap < count) cap *= 2;
+    void *p;
+    if (!(p = realloc(root->sync_tasks, cap * sizeof(SceneSyncTask)))) return false;
+    root->sync_tasks = p;
+    if (!(p = realloc(root->sync_jobs, cap * sizeof(Qs_JobDesc)))) return false;
+    root->sync_jobs = p;
+    root->sync_task_capacity = cap;
+    return true;
+}
+
+static bool scene_sync_reserve_ops(Qs_Scene *root, uint32_t count)
+{
+    if (count <= root->sync_op_capacity) return true;
+    SceneProxyOp *p = realloc(root->sync_ops, count * sizeof(SceneProxyOp));
+    if (!p) return false;
+    root->sync_ops         = p;
+    root->sync_op_capacity = count;
+    return true;
+}
+
+static Qs_Scene *prototype_load_inner(Qs_Scene *scene, Qs_Engine *engine,
+                                      Qs_PrototypeComp *pc)
+{
+    char abs[1024];
+    resolve_path(scene, pc->path, abs, sizeof(abs));
+
+    /* Use the file basename (without extension) as the inner
+       scene's name so logs read "Scene 'ABeautifulGame'…"
+       rather than the full project-relative path. */
+    const char *base = strrchr(pc->path, '/');
+    base = base ? base + 1 : pc->path;
+    char inner_name[64];
+    snprintf(inner_name, sizeof(inner_name), "%s", base);
+    char *dot = strrchr(inner_name, '.');
+    if (dot) *dot = '\0';
+
+    Qs_Scene *inner = qs_scene_create(engine, &(Qs_SceneDesc){
+        .name = inner_name,
+    });
+    if (!inner) return NULL;
+    if (!qs_scene_load(inner, engine, abs)) {
+        qs_scene_destroy(inner);
+        return NULL;
     }
+    return inner;
+}
 
-    /* Mesh components */
+static void scene_sync_gather(SceneSync *sync, Qs_Scene *scene,
+                              const float parent_world[16], int depth)
+{
+    bool root_moved;
+    if (!scene_xf_begin(scene, parent_world, &root_moved)) {
+        QS_LOG_ERROR("Scene '%s': out of memory for world transform cache",
+                     scene->name);
+        return;
+    }
+
+    /* Mesh components — resolve every parent up front so each chunk only
+       writes its own entities' cache slots. */
     if (s_mesh_comp_type) {
-        for (Qs_Entity e = qs_scene_first(scene, s_mesh_comp_type);
-             e != QS_ENTITY_INVALID;
-             e = qs_scene_next(scene, s_mesh_comp_type, e))
-        {
-            Qs_MeshComp *mc = (Qs_MeshComp *)qs_entity_get(scene, e, s_mesh_comp_type);
-            if (!mc || !mc->visible || !mc->mesh || !mc->material) continue;
-
-            float local_world[16];
-            qs_scene_world_matrix(scene, e, local_world);
-            float world[16];
-            qs_m4_mul(parent_world, local_world, world);
-
-            Qs_RenderableDesc r;
-            r.mesh            = mc->mesh;
-            r.material        = mc->material;
-            r.entity          = e;
-            r.cast_shadows    = true;
-            r.receive_shadows = true;
-            r.bounds.min[0] = r.bounds.min[1] = r.bounds.min[2] = -100.0f;
-            r.bounds.max[0] = r.bounds.max[1] = r.bounds.max[2] =  100.0f;
-            memcpy(r.transform, world, sizeof(world));
-            qs_renderer_submit_renderable(renderer, &r);
+        const ComponentStore *store = &scene->stores[s_mesh_comp_type->index];
+        for (uint32_t i = 0; i < store->count; i++) {
+            Qs_Entity p = scene->parent_entity[store->dense[i]];
+            if (p != QS_ENTITY_INVALID) scene_xf_resolve(scene, p, root_moved);
+        }
+
+        uint32_t chunks = (store->count + QS_SCENE_SYNC_CHUNK - 1) / QS_SCENE_SYNC_CHUNK;
+        if (!scene_sync_reserve_tasks(sync->root, sync->task_count + chunks)) {
+            sync->failed = true;
+            return;
+        }
+        for (uint32_t begin = 0; begin < store->count; begin += QS_SCENE_SYNC_CHUNK) {
+            uint32_t end = begin + QS_SCENE_SYNC_CHUNK;
+            if (end > store->count) end = store->count;
+            sync->root->sync_tasks[sync->task_count++] = (SceneSyncTask){
+                .scene = scene, .renderer = sync->renderer, .op_base = sync->op_total,
+                .begin = begin, .end = end, .root_moved = root_moved };
+            sync->op_total += end - begin;
         }
     }
 
     /* Light components — only submit at the top level (not inside a prototype
        recursion) to avoid duplicating lights from every prototype instance. */
-    if (s_light_comp_type) {
-        bool top_level = (s_proto_recursion_depth == 0);
-        if (top_level) {
-            for (Qs_Entity e = qs_scene_first(scene, s_light_comp_type);
-                 e != QS_ENTITY_INVALID;
-                 e = qs_scene_next(scene, s_light_comp_type, e))
-            {
-                Qs_LightComp *lc = (Qs_LightComp *)qs_entity_get(scene, e, s_light_comp_type);
-                if (lc) qs_renderer_submit_light_comp(renderer, lc);
-            }
+    if (s_light_comp_type && depth == 0) {
+        for (Qs_Entity e = qs_scene_first(scene, s_light_comp_type);
+             e != QS_ENTITY_INVALID;
+             e = qs_scene_next(scene, s_light_comp_type, e))
+        {
+            Qs_LightComp *lc = (Qs_LightComp *)qs_entity_get(scene, e, s_light_comp_type);
+            if (lc) qs_renderer_submit_light_comp(sync->renderer, lc);
         }
     }
 
     /* Prototype components — recurse into nested scenes */
-    if (s_prototype_comp_type && engine) {
+    if (s_prototype_comp_type && sync->engine) {
         for (Qs_Entity e = qs_scene_first(scene, s_prototype_comp_type);
-             e != QS_ENTITY_INVALID;
+             e != QS_ENTITY_INVALID && !sync->failed;
              e = qs_scene_next(scene, s_prototype_comp_type, e))
         {
             Qs_PrototypeComp *pc =
                 (Qs_PrototypeComp *)qs_entity_get(scene, e, s_prototype_comp_type);
             if (!pc || pc->load_failed || !pc->path[0]) continue;
 
+            /* Cut the cycle at the instance that crosses the cap so it is
+               reported once rather than every frame. */
+            if (depth + 1 >= QS_PROTO_RUNTIME_DEPTH_MAX) {
+                QS_LOG_ERROR("Prototype recursion depth exceeded (%d) at '%s' — "
+                             "cyclic .qproto reference detected, skipping it",
+                             QS_PROTO_RUNTIME_DEPTH_MAX, pc->path);
+                pc->load_failed = true;
+                continue;
+            }
+
             /* Lazy-load the inner scene on first use. */
             if (!pc->inner) {
-                char abs[1024];
-                resolve_path(scene, pc->path, abs, sizeof(abs));
-
-                /* Use the file basename (without extension) as the inner
-                   scene's name so logs read "Scene 'ABeautifulGame'…"
-                   rather than the full project-relative path. */
-                const char *base = strrchr(pc->path, '/');
-                base = base ? base + 1 : pc->path;
-                char inner_name[64];
-                snprintf(inner_name, sizeof(inner_name), "%s", base);
-                char *dot = strrchr(inner_name, '.');
-                if (dot) *dot = '\0';
-
-                Qs_Scene *inner = qs_scene_create(engine, &(Qs_SceneDesc){
-                    .name = inner_name,
-                });
-                if (!inner) { pc->load_failed = true; continue; }
-                if (!qs_scene_load(inner, engine, abs)) {
-                    qs_scene_destroy(inner);
-                    pc->load_failed = true;
-                    continue;
-                }
-                pc->inner = inner;
+                pc->inner = prototype_load_inner(scene, sync->engine, pc);
+                if (!pc->inner) { pc->load_failed = true; continue; }
             }
 
             /* Apply per-instance overrides each frame so user edits are
@@ -1750,18 +2100,67 @@ void qs_scene_submit_renderables(Qs_Scene *scene,
                source .qproto file. */
             qs_prototype_apply_overrides(pc);
 
-            float local_world[16];
-            qs_scene_world_matrix(scene, e, local_world);
-            float world[16];
-            qs_m4_mul(parent_world, local_world, world);
-
-            s_proto_recursion_depth++;
-            qs_scene_submit_renderables(pc->inner, engine, renderer, world);
-            s_proto_recursion_depth--;
+            scene_xf_resolve(scene, e, root_moved);
+            scene_sync_gather(sync, pc->inner, scene->xf_world[e], depth + 1);
         }
     }
 }
 
+static void scene_sync_run(Qs_Scene *root, Qs_JobSystem *jobs, uint32_t task_count)
+{
+    if (jobs && task_count > 1 && !root->sync_counter)
+        root->sync_counter = qs_job_counter_create(jobs);
+
+    if (!jobs || task_count < 2 || !root->sync_counter) {
+        for (uint32_t i = 0; i < task_count; i++)
+            scene_sync_task_run(&root->sync_tasks[i]);
+        return;
+    }
+    for (uint32_t i = 0; i < task_count; i++)
+        root->sync_jobs[i] = (Qs_JobDesc){ .fn = scene_sync_task_run,
+                                           .data = &root->sync_tasks[i],
+                                           .name = "scene_sync" };
+    qs_job_dispatch_batch(jobs, root->sync_jobs, task_count, root->sync_counter);
+    qs_job_wait(jobs, root->sync_counter);
+}
+
+void qs_scene_submit_renderables(Qs_Scene *scene,
+                                 Qs_Engine *engine,
+                                 Qs_Renderer *renderer,
+                                 const float parent_world[16])
+{
+    if (!scene || !renderer) return;
+
+    float identity[16];
+    if (!parent_world) {
+        qs_m4_identity(identity);
+        parent_world = identity;
+    }
+
+    SceneSync sync = { .root = scene, .engine = engine, .renderer = renderer };
+    scene_sync_gather(&sync, scene, parent_world, 0);
+    if (sync.failed || !scene_sync_reserve_ops(scene, sync.op_total)) {
+        QS_LOG_ERROR("Scene '%s': out of memory for render sync", scene->name);
+        return;
+    }
+
+    for (uint32_t i = 0; i < sync.task_count; i++)
+        scene->sync_tasks[i].ops = scene->sync_ops + scene->sync_tasks[i].op_base;
+    scene_sync_run(scene, qs_engine_job_system(engine), sync.task_count);
+
+    /* Exclusive prefix sum over the per-chunk counts compacts the slices
+       into one stream in chunk order; destinations never pass sources. */
+    uint32_t op_count = 0;
+    for (uint32_t i = 0; i < sync.task_count; i++) {
+        const SceneSyncTask *t = &scene->sync_tasks[i];
+        if (t->op_count && op_count != t->op_base)
+            memmove(scene->sync_ops + op_count, t->ops, t->op_count * sizeof(SceneProxyOp));
+        op_count += t->op_count;
+    }
+    for (uint32_t i = 0; i < op_count; i++)
+        scene_proxy_apply(&scene->sync_ops[i], renderer);
+}
+
 /* ================================================================
    PROTOTYPE DEPENDENCY / CYCLE DETECTION
    ================================================================
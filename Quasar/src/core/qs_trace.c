@@ -0,0 +1,55 @@
+/* qs_trace.c — Chrome trace file framing for the job and startup traces. */
+
+#include "qs_trace_internal.h"
+
+void qs_json_write_string(FILE *f, const char *s)
+{
+    fputc('"', f);
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') { fputc('\\', f); fputc(c, f); }
+        else if (c < 0x20)         fprintf(f, "\\u%04x", c);
+        else                       fputc(c, f);
+    }
+    fputc('"', f);
+}
+
+FILE *qs_trace_open(const char *path, const char *display_unit, const char *process_name)
+{
+    FILE *f = fopen(path, "w");
+    if (!f) return NULL;
+    fprintf(f, "{\"displayTimeUnit\":\"%s\",\"traceEvents\":[\n", display_unit);
+    fprintf(f, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":");
+    qs_json_write_string(f, process_name);
+    fprintf(f, "}}");
+    return f;
+}
+
+void qs_trace_thread_name(FILE *f, uint32_t tid, const char *name)
+{
+    fprintf(f, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,"
+               "\"args\":{\"name\":", tid);
+    qs_json_write_string(f, name);
+    fprintf(f, "}}");
+}
+
+void qs_trace_event(FILE *f, const char *name, const char *category, uint32_t tid,
+                    double ts_us, double dur_us, const char *args)
+{
+    fprintf(f, ",\n{\"name\":");
+    qs_json_write_string(f, name);
+    fprintf(f, ",\"cat\":");
+    qs_json_write_string(f, category);
+    fprintf(f, ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f",
+            tid, ts_us, dur_us);
+    if (args) fprintf(f, ",\"args\":%s", args);
+    fputc('}', f);
+}
+
+bool qs_trace_close(FILE *f)
+{
+    fprintf(f, "\n]}\n");
+    bool ok = !ferror(f);
+    if (fclose(f) != 0) ok = false;
+    return ok;
+}
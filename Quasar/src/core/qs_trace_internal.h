@@ -0,0 +1,34 @@
+#ifndef QS_TRACE_INTERNAL_H
+#define QS_TRACE_INTERNAL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/* ================================================================
+   CHROME TRACE FILES — the framing shared by the job trace and the
+   startup trace (chrome://tracing / Perfetto JSON), not part of the
+   public API.  Every record after the process name is written with a
+   leading ",\n", so callers emit records in any order between open and
+   close.
+   ================================================================ */
+
+/// Opens path for writing and emits the trace header and the process_name
+/// record.  display_unit is "ns" or "ms".  NULL when path cannot be opened.
+FILE *qs_trace_open(const char *path, const char *display_unit, const char *process_name);
+
+/// Names track tid.
+void qs_trace_thread_name(FILE *f, uint32_t tid, const char *name);
+
+/// Writes a complete ("X") event; ts_us and dur_us are in microseconds.
+/// args is a JSON object written verbatim, or NULL for none.
+void qs_trace_event(FILE *f, const char *name, const char *category, uint32_t tid,
+                    double ts_us, double dur_us, const char *args);
+
+/// Ends the trace and closes f.  False when any write failed.
+bool qs_trace_close(FILE *f);
+
+/// Writes s as a quoted, escaped JSON string.
+void qs_json_write_string(FILE *f, const char *s);
+
+#endif /* QS_TRACE_INTERNAL_H */
@@ -0,0 +1,237 @@
+#include "qs_cull.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__AVX__)
+  #include <immintrin.h>
+  #define QS_CULL_AVX 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #include <emmintrin.h>
+  #define QS_CULL_SSE2 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+  #include <arm_neon.h>
+  #define QS_CULL_NEON 1
+#endif
+
+/* ================================================================
+   FRUSTUM EXTRACTION
+   ================================================================ */
+
+static void plane_from_rows(float out[4], const float m[16], int row, float sign)
+{
+    for (int c = 0; c < 4; c++)
+        out[c] = m[c*4 + 3] + sign * m[c*4 + row];
+    float len = sqrtf(out[0]*out[0] + out[1]*out[1] + out[2]*out[2]);
+    if (len > 0.0f) {
+        float inv = 1.0f / len;
+        for (int c = 0; c < 4; c++) out[c] *= inv;
+    }
+}
+
+void qs_frustum_from_matrix(Qs_Frustum *out, const float view_proj[16])
+{
+    plane_from_rows(out->planes[0], view_proj, 0,  1.0f);
+    plane_from_rows(out->planes[1], view_proj, 0, -1.0f);
+    plane_from_rows(out->planes[2], view_proj, 1,  1.0f);
+    plane_from_rows(out->planes[3], view_proj, 1, -1.0f);
+    plane_from_rows(out->planes[4], view_proj, 2,  1.0f);
+    plane_from_rows(out->planes[5], view_proj, 2, -1.0f);
+}
+
+/* ================================================================
+   BOUNDS STORAGE
+   All six streams share one allocation starting at center[0].
+   Capacity is a whole number of kernel iterations so full-width
+   loads never run past the end of a stream.
+   ================================================================ */
+
+bool qs_cull_bounds_reserve(Qs_CullBounds *b, uint32_t capacity)
+{
+    if (capacity <= b->capacity) return true;
+    uint32_t cap = (capacity + QS_CULL_LANES - 1) & ~(uint32_t)(QS_CULL_LANES - 1);
+
+    float *block = calloc((size_t)cap * 6, sizeof(float));
+    if (!block) return false;
+
+    float *old = b->center[0];
+    for (int k = 0; k < 3; k++) {
+        float *c = block + (size_t)cap * k;
+        float *e = block + (size_t)cap * (3 + k);
+        if (b->count) {
+            memcpy(c, b->center[k], b->count * sizeof(float));
+            memcpy(e, b->extent[k], b->count * sizeof(float));
+        }
+        b->center[k] = c;
+        b->extent[k] = e;
+    }
+    free(old);
+    b->capacity = cap;
+    return true;
+}
+
+void qs_cull_bounds_free(Qs_CullBounds *b)
+{
+    free(b->center[0]);
+    memset(b, 0, sizeof(*b));
+}
+
+void qs_cull_bounds_set(Qs_CullBounds *b, uint32_t index, const Qs_AABB *box)
+{
+    for (int k = 0; k < 3; k++) {
+        b->center[k][index] = (box->max[k] + box->min[k]) * 0.5f;
+        b->extent[k][index] = (box->max[k] - box->min[k]) * 0.5f;
+    }
+    if (index >= b->count) b->count = index + 1;
+}
+
+void qs_cull_bounds_remove(Qs_CullBounds *b, uint32_t index)
+{
+    uint32_t last = --b->count;
+    if (index == last) return;
+    for (int k = 0; k < 3; k++) {
+        b->center[k][index] = b->center[k][last];
+        b->extent[k][index] = b->extent[k][last];
+    }
+}
+
+/* ================================================================
+   FRUSTUM KERNEL
+   A box is rejected when it lies entirely behind any plane:
+   dot(n, center) + d + dot(|n|, extent) < 0.  Each iteration yields
+   an 8-bit mask with one bit per box that survived all six planes.
+   ================================================================ */
+
+#if QS_CULL_AVX
+
+static uint32_t cull_mask8(const Qs_Frustum *f, const Qs_CullBounds *b, uint32_t i)
+{
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    __m256 cx = _mm256_loadu_ps(b->center[0] + i);
+    __m256 cy = _mm256_loadu_ps(b->center[1] + i);
+    __m256 cz = _mm256_loadu_ps(b->center[2] + i);
+    __m256 ex = _mm256_loadu_ps(b->extent[0] + i);
+    __m256 ey = _mm256_loadu_ps(b->extent[1] + i);
+    __m256 ez = _mm256_loadu_ps(b->extent[2] + i);
+    __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+    for (int p = 0; p < 6; p++) {
+        __m256 a = _mm256_set1_ps(f->planes[p][0]);
+        __m256 bb = _mm256_set1_ps(f->planes[p][1]);
+        __m256 c = _mm256_set1_ps(f->planes[p][2]);
+        __m256 d = _mm256_set1_ps(f->planes[p][3]);
+        __m256 dist = _mm256_add_ps(
+            _mm256_add_ps(_mm256_mul_ps(cx, a), _mm256_mul_ps(cy, bb)),
+            _mm256_add_ps(_mm256_mul_ps(cz, c), d));
+        __m256 rad = _mm256_add_ps(
+            _mm256_add_ps(_mm256_mul_ps(ex, _mm256_andnot_ps(sign, a)),
+                          _mm256_mul_ps(ey, _mm256_andnot_ps(sign, bb))),
+            _mm256_mul_ps(ez, _mm256_andnot_ps(sign, c)));
+        inside = _mm256_and_ps(inside,
+            _mm256_cmp_ps(_mm256_add_ps(dist, rad), _mm256_setzero_ps(), _CMP_GE_OQ));
+    }
+    return (uint32_t)_mm256_movemask_ps(inside);
+}
+
+#elif QS_CULL_SSE2
+
+static uint32_t cull_mask4(const Qs_Frustum *f, const Qs_CullBounds *b, uint32_t i)
+{
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    __m128 cx = _mm_loadu_ps(b->center[0] + i);
+    __m128 cy = _mm_loadu_ps(b->center[1] + i);
+    __m128 cz = _mm_loadu_ps(b->center[2] + i);
+    __m128 ex = _mm_loadu_ps(b->extent[0] + i);
+    __m128 ey = _mm_loadu_ps(b->extent[1] + i);
+    __m128 ez = _mm_loadu_ps(b->extent[2] + i);
+    __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+    for (int p = 0; p < 6; p++) {
+        __m128 a = _mm_set1_ps(f->planes[p][0]);
+        __m128 bb = _mm_set1_ps(f->planes[p][1]);
+        __m128 c = _mm_set1_ps(f->planes[p][2]);
+        __m128 d = _mm_set1_ps(f->planes[p][3]);
+        __m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, a), _mm_mul_ps(cy, bb)),
+                                 _mm_add_ps(_mm_mul_ps(cz, c), d));
+        __m128 rad = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ex, _mm_andnot_ps(sign, a)),
+                                           _mm_mul_ps(ey, _mm_andnot_ps(sign, bb))),
+                                _mm_mul_ps(ez, _mm_andnot_ps(sign, c)));
+        inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(dist, rad), _mm_setzero_ps()));
+    }
+    return (uint32_t)_mm_movemask_ps(inside);
+}
+
+static uint32_t cull_mask8(const Qs_Frustum *f, const Qs_CullBounds *b, uint32_t i)
+{
+    return cull_mask4(f, b, i) | (cull_mask4(f, b, i + 4) << 4);
+}
+
+#elif QS_CULL_NEON
+
+static uint32_t cull_mask4(const Qs_Frustum *f, const Qs_CullBounds *b, uint32_t i)
+{
+    float32x4_t cx = vld1q_f32(b->center[0] + i);
+    float32x4_t cy = vld1q_f32(b->center[1] + i);
+    float32x4_t cz = vld1q_f32(b->center[2] + i);
+    float32x4_t ex = vld1q_f32(b->extent[0] + i);
+    float32x4_t ey = vld1q_f32(b->extent[1] + i);
+    float32x4_t ez = vld1q_f32(b->extent[2] + i);
+    uint32x4_t inside = vdupq_n_u32(~0u);
+    for (int p = 0; p < 6; p++) {
+        const float *pl = f->planes[p];
+        float32x4_t dist = vdupq_n_f32(pl[3]);
+        dist = vmlaq_n_f32(dist, cx, pl[0]);
+        dist = vmlaq_n_f32(dist, cy, pl[1]);
+        dist = vmlaq_n_f32(dist, cz, pl[2]);
+        dist = vmlaq_n_f32(dist, ex, fabsf(pl[0]));
+        dist = vmlaq_n_f32(dist, ey, fabsf(pl[1]));
+        dist = vmlaq_n_f32(dist, ez, fabsf(pl[2]));
+        inside = vandq_u32(inside, vcgeq_f32(dist, vdupq_n_f32(0.0f)));
+    }
+    static const uint32_t bits[4] = { 1, 2, 4, 8 };
+    return vaddvq_u32(vandq_u32(inside, vld1q_u32(bits)));
+}
+
+static uint32_t cull_mask8(const Qs_Frustum *f, const Qs_CullBounds *b, uint32_t i)
+{
+    return cull_mask4(f, b, i) | (cull_mask4(f, b, i + 4) << 4);
+}
+
+#else
+
+static uint32_t cull_mask8(const Qs_Frustum *f, const Qs_CullBounds *b, uint32_t i)
+{
+    uint32_t mask = 0;
+    for (uint32_t l = 0; l < QS_CULL_LANES; l++) {
+        bool inside = true;
+        for (int p = 0; p < 6 && inside; p++) {
+            const float *pl = f->planes[p];
+            float dist = pl[0]*b->center[0][i+l] + pl[1]*b->center[1][i+l]
+                       + pl[2]*b->center[2][i+l] + pl[3];
+            float rad  = fabsf(pl[0])*b->extent[0][i+l] + fabsf(pl[1])*b->extent[1][i+l]
+                       + fabsf(pl[2])*b->extent[2][i+l];
+            inside = dist + rad >= 0.0f;
+        }
+        mask |= (uint32_t)inside << l;
+    }
+    return mask;
+}
+
+#endif
+
+uint32_t qs_cull_frustum(const Qs_Frustum *frustum, const Qs_CullBounds *bounds,
+                         uint32_t *out_visible)
+{
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < bounds->count; i += QS_CULL_LANES) {
+        uint32_t mask = cull_mask8(frustum, bounds, i);
+        uint32_t rem  = bounds->count - i;
+        if (rem < QS_CULL_LANES) mask &= (1u << rem) - 1u;
+        while (mask) {
+            uint32_t l = 0;
+            while (!(mask & (1u << l))) l++;
+            out_visible[n++] = i + l;
+            mask &= mask - 1u;
+        }
+    }
+    return n;
+}
@@ -0,0 +1,85 @@
+#include "qs_draw_list.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define QS_RADIX_BITS    8
+#define QS_RADIX_BUCKETS (1u << QS_RADIX_BITS)
+#define QS_RADIX_PASSES  (64 / QS_RADIX_BITS)
+
+bool qs_draw_list_reserve(Qs_DrawList *list, uint32_t capacity)
+{
+    if (capacity <= list->capacity) return true;
+
+    void *p;
+    if (!(p = realloc(list->keys,          capacity * sizeof(uint64_t)))) return false;
+    list->keys = p;
+    if (!(p = realloc(list->items,         capacity * sizeof(uint32_t)))) return false;
+    list->items = p;
+    if (!(p = realloc(list->scratch_keys,  capacity * sizeof(uint64_t)))) return false;
+    list->scratch_keys = p;
+    if (!(p = realloc(list->scratch_items, capacity * sizeof(uint32_t)))) return false;
+    list->scratch_items = p;
+
+    list->capacity = capacity;
+    return true;
+}
+
+void qs_draw_list_free(Qs_DrawList *list)
+{
+    free(list->keys);
+    free(list->items);
+    free(list->scratch_keys);
+    free(list->scratch_items);
+    memset(list, 0, sizeof(*list));
+}
+
+/* LSD radix sort, one byte per pass.  All histograms are built in a
+   single read; a pass whose digit is identical across every key (one
+   bucket holds all of them) leaves the order unchanged and is skipped,
+   which drops the constant pass / pipeline bytes in typical frames. */
+void qs_draw_list_sort(Qs_DrawList *list)
+{
+    uint32_t n = list->count;
+    if (n < 2) return;
+
+    uint32_t hist[QS_RADIX_PASSES][QS_RADIX_BUCKETS];
+    memset(hist, 0, sizeof(hist));
+    for (uint32_t i = 0; i < n; i++) {
+        uint64_t k = list->keys[i];
+        for (uint32_t p = 0; p < QS_RADIX_PASSES; p++)
+            hist[p][(k >> (p * QS_RADIX_BITS)) & (QS_RADIX_BUCKETS - 1)]++;
+    }
+
+    uint64_t *src_k = list->keys,         *dst_k = list->scratch_keys;
+    uint32_t *src_i = list->items,        *dst_i = list->scratch_items;
+
+    for (uint32_t p = 0; p < QS_RADIX_PASSES; p++) {
+        uint32_t shift = p * QS_RADIX_BITS;
+        if (hist[p][(src_k[0] >> shift) & (QS_RADIX_BUCKETS - 1)] == n) continue;
+
+        uint32_t offset[QS_RADIX_BUCKETS];
+        uint32_t sum = 0;
+        for (uint32_t b = 0; b < QS_RADIX_BUCKETS; b++) {
+            offset[b] = sum;
+            sum += hist[p][b];
+        }
+        for (uint32_t i = 0; i < n; i++) {
+            uint32_t d = (uint32_t)(src_k[i] >> shift) & (QS_RADIX_BUCKETS - 1);
+            uint32_t o = offset[d]++;
+            dst_k[o] = src_k[i];
+            dst_i[o] = src_i[i];
+        }
+
+        uint64_t *tk = src_k; src_k = dst_k; dst_k = tk;
+        uint32_t *ti = src_i; src_i = dst_i; dst_i = ti;
+    }
+
+    /* Sorted data ended up in the scratch arrays — swap roles */
+    if (src_k != list->keys) {
+        list->scratch_keys  = list->keys;
+        list->scratch_items = list->items;
+        list->keys          = src_k;
+        list->items         = src_i;
+    }
+}
@@ -0,0 +1,570 @@
+#include "qs_occlusion.h"
+
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__AVX__)
+  #include <immintrin.h>
+  #define QS_OCCLUSION_AVX 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #include <emmintrin.h>
+  #define QS_OCCLUSION_SSE2 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+  #include <arm_neon.h>
+  #define QS_OCCLUSION_NEON 1
+#endif
+
+#define OCC_TILE_FULL     UINT64_MAX
+#define OCC_CLIP_PLANES   5
+#define OCC_CLIP_VERTICES (3 + OCC_CLIP_PLANES)
+
+/* Screen-space triangle in buffer pixels.  An edge (a, b, c) covers the
+   pixel centres (x, y) with a*x + b*y + c > 0; depth is the plane
+   z = dz[0]*x + dz[1]*y + dz[2], bounded by the vertex depths. */
+typedef struct OccTri {
+    float    edge[3][3];
+    float    dz[3];
+    float    z_min, z_max;
+    uint16_t tile_x0, tile_y0, tile_x1, tile_y1;   /* inclusive */
+} OccTri;
+
+typedef struct OccBand {
+    Qs_OcclusionBuffer *buffer;
+    uint32_t            row_begin, row_end;         /* tile rows */
+} OccBand;
+
+struct Qs_OcclusionBuffer {
+    uint32_t width, height;
+    uint32_t tiles_x, tiles_y;
+
+    /* Per tile: coverage of the working layer, the farthest depth of the
+       whole tile and the farthest depth of the working layer */
+    uint64_t *mask;
+    float    *z_tile;
+    float    *z_layer;
+
+    OccTri   *tris;
+    uint32_t  tri_count;
+    uint32_t  tri_capacity;
+
+    float   (*clip)[4];                             /* add() scratch */
+    uint32_t  clip_capacity;
+
+    OccBand       *bands;
+    Qs_JobDesc    *band_jobs;
+    uint32_t       band_count;
+    Qs_JobSystem  *jobs;
+    Qs_JobCounter *counter;
+};
+
+/* ================================================================
+   LIFETIME
+   ================================================================ */
+
+static void band_job(void *data);
+
+Qs_OcclusionBuffer *qs_occlusion_create(uint32_t width, uint32_t height)
+{
+    if (width == 0 || height == 0 ||
+        width % QS_OCCLUSION_TILE_WIDTH || height % QS_OCCLUSION_TILE_HEIGHT)
+        return NULL;
+    Qs_OcclusionBuffer *b = calloc(1, sizeof(*b));
+    if (!b) return NULL;
+
+    b->width      = width;
+    b->height     = height;
+    b->tiles_x    = width  / QS_OCCLUSION_TILE_WIDTH;
+    b->tiles_y    = height / QS_OCCLUSION_TILE_HEIGHT;
+    b->band_count = (b->tiles_y + QS_OCCLUSION_BAND_TILE_ROWS - 1) / QS_OCCLUSION_BAND_TILE_ROWS;
+
+    size_t tiles = (size_t)b->tiles_x * b->tiles_y;
+    b->mask      = malloc(tiles * sizeof(*b->mask));
+    b->z_tile    = malloc(tiles * sizeof(*b->z_tile));
+    b->z_layer   = malloc(tiles * sizeof(*b->z_layer));
+    b->bands     = malloc(b->band_count * sizeof(*b->bands));
+    b->band_jobs = malloc(b->band_count * sizeof(*b->band_jobs));
+    if (!b->mask || !b->z_tile || !b->z_layer || !b->bands || !b->band_jobs) {
+        qs_occlusion_destroy(b);
+        return NULL;
+    }
+
+    for (uint32_t i = 0; i < b->band_count; i++) {
+        uint32_t end = (i + 1) * QS_OCCLUSION_BAND_TILE_ROWS;
+        b->bands[i] = (OccBand){
+            .buffer    = b,
+            .row_begin = i * QS_OCCLUSION_BAND_TILE_ROWS,
+            .row_end   = end < b->tiles_y ? end : b->tiles_y,
+        };
+        b->band_jobs[i] = (Qs_JobDesc){
+            .fn   = band_job,
+            .data = &b->bands[i],
+            .name = "occlusion_band",
+        };
+    }
+    qs_occlusion_clear(b);
+    return b;
+}
+
+void qs_occlusion_destroy(Qs_OcclusionBuffer *b)
+{
+    if (!b) return;
+    if (b->counter) qs_job_counter_destroy(b->jobs, b->counter);
+    free(b->mask);
+    free(b->z_tile);
+    free(b->z_layer);
+    free(b->tris);
+    free(b->clip);
+    free(b->bands);
+    free(b->band_jobs);
+    free(b);
+}
+
+void qs_occlusion_size(const Qs_OcclusionBuffer *b, uint32_t *out_width, uint32_t *out_height)
+{
+    *out_width  = b->width;
+    *out_height = b->height;
+}
+
+void qs_occlusion_clear(Qs_OcclusionBuffer *b)
+{
+    uint32_t tiles = b->tiles_x * b->tiles_y;
+    memset(b->mask, 0, tiles * sizeof(*b->mask));
+    for (uint32_t i = 0; i < tiles; i++) {
+        b->z_tile[i]  = FLT_MAX;
+        b->z_layer[i] = 0.0f;
+    }
+    b->tri_count = 0;
+}
+
+/* ================================================================
+   TRIANGLE SETUP
+   Triangles crossing the near or a side plane are clipped in clip
+   space, so screen coordinates stay within the buffer and every
+   vertex has w > 0.  No far clip: depth beyond it hides nothing.
+   ================================================================ */
+
+/* Inward plane (a, b, c, d) on clip (x, y, z, w):
+   left, right, bottom, top, near */
+static const float k_clip_planes[OCC_CLIP_PLANES][4] = {
+    {  1.0f,  0.0f, 0.0f, 1.0f },
+    { -1.0f,  0.0f, 0.0f, 1.0f },
+    {  0.0f,  1.0f, 0.0f, 1.0f },
+    {  0.0f, -1.0f, 0.0f, 1.0f },
+    {  0.0f,  0.0f, 1.0f, 1.0f },
+};
+
+static float clip_distance(const float v[4], int p)
+{
+    const float *k = k_clip_planes[p];
+    return k[0]*v[0] + k[1]*v[1] + k[2]*v[2] + k[3]*v[3];
+}
+
+static uint32_t clip_outcode(const float v[4])
+{
+    uint32_t code = 0;
+    for (int p = 0; p < OCC_CLIP_PLANES; p++)
+        if (clip_distance(v, p) < 0.0f) code |= 1u << p;
+    return code;
+}
+
+static bool tris_reserve(Qs_OcclusionBuffer *b, uint32_t capacity)
+{
+    if (capacity <= b->tri_capacity) return true;
+    uint32_t cap = b->tri_capacity ? b->tri_capacity * 2 : 256;
+    while (cap < capacity) cap *= 2;
+    OccTri *tris = realloc(b->tris, cap * sizeof(*tris));
+    if (!tris) return false;
+    b->tris         = tris;
+    b->tri_capacity = cap;
+    return true;
+}
+
+static uint16_t tile_clamp(float px, uint32_t tile_size, uint32_t tiles)
+{
+    int t = (int)floorf(px) / (int)tile_size;
+    return (uint16_t)(t < 0 ? 0 : (t >= (int)tiles ? (int)tiles - 1 : t));
+}
+
+/* Projects a clipped triangle and queues its edge and depth equations.
+   Degenerate and pixel-centre-free triangles are dropped. */
+static bool tri_emit(Qs_OcclusionBuffer *b, const float *c0, const float *c1, const float *c2)
+{
+    const float *clip[3] = { c0, c1, c2 };
+    double x[3], y[3];
+    float  z[3];
+    for (int k = 0; k < 3; k++) {
+        if (clip[k][3] <= 0.0f) return true;
+        double inv_w = 1.0 / clip[k][3];
+        x[k] = (clip[k][0] * inv_w * 0.5 + 0.5) * b->width;
+        y[k] = (clip[k][1] * inv_w * 0.5 + 0.5) * b->height;
+        z[k] = (float)(clip[k][2] * inv_w);
+    }
+
+    double area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+    if (area == 0.0) return true;
+    double orient = area > 0.0 ? 1.0 : -1.0;
+
+    double min_x = fmin(x[0], fmin(x[1], x[2])), max_x = fmax(x[0], fmax(x[1], x[2]));
+    double min_y = fmin(y[0], fmin(y[1], y[2])), max_y = fmax(y[0], fmax(y[1], y[2]));
+    if (floor(max_x - 0.5) < ceil(min_x - 0.5) || floor(max_y - 0.5) < ceil(min_y - 0.5))
+        return true;
+
+    if (b->tri_count == b->tri_capacity && !tris_reserve(b, b->tri_count + 1)) return false;
+    OccTri *t = &b->tris[b->tri_count++];
+    for (int k = 0; k < 3; k++) {
+        int j = (k + 1) % 3;
+        double ea = (y[k] - y[j]) * orient;
+        double eb = (x[j] - x[k]) * orient;
+        t->edge[k][0] = (float)ea;
+        t->edge[k][1] = (float)eb;
+        t->edge[k][2] = (float)(-(ea * x[k] + eb * y[k]));
+    }
+    double dzdx = ((z[1] - z[0]) * (y[2] - y[0]) - (z[2] - z[0]) * (y[1] - y[0])) / area;
+    double dzdy = ((z[2] - z[0]) * (x[1] - x[0]) - (z[1] - z[0]) * (x[2] - x[0])) / area;
+    t->dz[0] = (float)dzdx;
+    t->dz[1] = (float)dzdy;
+    t->dz[2] = (float)(z[0] - dzdx * x[0] - dzdy * y[0]);
+    t->z_min = fminf(z[0], fminf(z[1], z[2]));
+    t->z_max = fmaxf(z[0], fmaxf(z[1], z[2]));
+    t->tile_x0 = tile_clamp((float)min_x, QS_OCCLUSION_TILE_WIDTH,  b->tiles_x);
+    t->tile_x1 = tile_clamp((float)max_x, QS_OCCLUSION_TILE_WIDTH,  b->tiles_x);
+    t->tile_y0 = tile_clamp((float)min_y, QS_OCCLUSION_TILE_HEIGHT, b->tiles_y);
+    t->tile_y1 = tile_clamp((float)max_y, QS_OCCLUSION_TILE_HEIGHT, b->tiles_y);
+    return true;
+}
+
+/* Sutherland-Hodgman against the planes in planes_mask, then a fan. */
+static bool tri_clip(Qs_OcclusionBuffer *b, const float *c0, const float *c1, const float *c2,
+                     uint32_t planes_mask)
+{
+    float    poly[2][OCC_CLIP_VERTICES][4];
+    uint32_t n = 3, cur = 0;
+    memcpy(poly[0][0], c0, sizeof(poly[0][0]));
+    memcpy(poly[0][1], c1, sizeof(poly[0][1]));
+    memcpy(poly[0][2], c2, sizeof(poly[0][2]));
+
+    for (int p = 0; p < OCC_CLIP_PLANES && n >= 3; p++) {
+        if (!(planes_mask & (1u << p))) continue;
+        const float (*in)[4]  = poly[cur];
+        float       (*out)[4] = poly[cur ^ 1];
+        uint32_t m = 0;
+        for (uint32_t i = 0; i < n; i++) {
+            const float *a = in[i], *c = in[(i + 1) % n];
+            float da = clip_distance(a, p), dc = clip_distance(c, p);
+            if (da >= 0.0f) memcpy(out[m++], a, sizeof(out[0]));
+            if ((da >= 0.0f) != (dc >= 0.0f)) {
+                float s = da / (da - dc);
+                for (int k = 0; k < 4; k++) out[m][k] = a[k] + (c[k] - a[k]) * s;
+                m++;
+            }
+        }
+        n = m;
+        cur ^= 1;
+    }
+
+    for (uint32_t i = 2; i < n; i++)
+        if (!tri_emit(b, poly[cur][0], poly[cur][i - 1], poly[cur][i])) return false;
+    return true;
+}
+
+bool qs_occlusion_add(Qs_OcclusionBuffer *b, const Qs_OccluderMesh *mesh,
+                      const float clip_from_model[16])
+{
+    if (mesh->vertex_count > b->clip_capacity) {
+        float (*clip)[4] = realloc(b->clip, mesh->vertex_count * sizeof(*clip));
+        if (!clip) return false;
+        b->clip          = clip;
+        b->clip_capacity = mesh->vertex_count;
+    }
+    const float *m = clip_from_model;
+    for (uint32_t i = 0; i < mesh->vertex_count; i++) {
+        const float *p = mesh->positions + (size_t)i * 3;
+        for (int r = 0; r < 4; r++)
+            b->clip[i][r] = m[r]*p[0] + m[r + 4]*p[1] + m[r + 8]*p[2] + m[r + 12];
+    }
+
+    for (uint32_t i = 0; i + 2 < mesh->index_count; i += 3) {
+        const float *c0 = b->clip[mesh->indices[i]];
+        const float *c1 = b->clip[mesh->indices[i + 1]];
+        const float *c2 = b->clip[mesh->indices[i + 2]];
+        uint32_t o0 = clip_outcode(c0), o1 = clip_outcode(c1), o2 = clip_outcode(c2);
+        if (o0 & o1 & o2) continue;
+        bool ok = (o0 | o1 | o2) ? tri_clip(b, c0, c1, c2, o0 | o1 | o2)
+                                 : tri_emit(b, c0, c1, c2);
+        if (!ok) return false;
+    }
+    return true;
+}
+
+/* ================================================================
+   COVERAGE KERNEL
+   Evaluates the three edge functions at the 8x8 pixel centres of a
+   tile, one row of 8 pixels per iteration.  Bit r*8 + l is pixel
+   (x + l, y + r).
+   ================================================================ */
+
+#if QS_OCCLUSION_AVX
+
+static uint64_t tile_coverage(const OccTri *t, float x, float y)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    __m256 xs = _mm256_add_ps(_mm256_set1_ps(x), _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7));
+    __m256 e[3], step[3];
+    for (int k = 0; k < 3; k++) {
+        e[k] = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(t->edge[k][0]), xs),
+                             _mm256_set1_ps(t->edge[k][1] * y + t->edge[k][2]));
+        step[k] = _mm256_set1_ps(t->edge[k][1]);
+    }
+    uint64_t mask = 0;
+    for (int r = 0; r < QS_OCCLUSION_TILE_HEIGHT; r++) {
+        __m256 in = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(e[0], zero, _CMP_GT_OQ),
+                                                _mm256_cmp_ps(e[1], zero, _CMP_GT_OQ)),
+                                  _mm256_cmp_ps(e[2], zero, _CMP_GT_OQ));
+        mask |= (uint64_t)_mm256_movemask_ps(in) << (r * QS_OCCLUSION_TILE_WIDTH);
+        for (int k = 0; k < 3; k++) e[k] = _mm256_add_ps(e[k], step[k]);
+    }
+    return mask;
+}
+
+#elif QS_OCCLUSION_SSE2
+
+static uint64_t tile_coverage(const OccTri *t, float x, float y)
+{
+    const __m128 zero = _mm_setzero_ps();
+    __m128 lo = _mm_add_ps(_mm_set1_ps(x), _mm_setr_ps(0, 1, 2, 3));
+    __m128 hi = _mm_add_ps(lo, _mm_set1_ps(4.0f));
+    __m128 e_lo[3], e_hi[3], step[3];
+    for (int k = 0; k < 3; k++) {
+        __m128 a    = _mm_set1_ps(t->edge[k][0]);
+        __m128 base = _mm_set1_ps(t->edge[k][1] * y + t->edge[k][2]);
+        e_lo[k] = _mm_add_ps(_mm_mul_ps(a, lo), base);
+        e_hi[k] = _mm_add_ps(_mm_mul_ps(a, hi), base);
+        step[k] = _mm_set1_ps(t->edge[k][1]);
+    }
+    uint64_t mask = 0;
+    for (int r = 0; r < QS_OCCLUSION_TILE_HEIGHT; r++) {
+        __m128 in_lo = _mm_and_ps(_mm_and_ps(_mm_cmpgt_ps(e_lo[0], zero),
+                                             _mm_cmpgt_ps(e_lo[1], zero)),
+                                  _mm_cmpgt_ps(e_lo[2], zero));
+        __m128 in_hi = _mm_and_ps(_mm_and_ps(_mm_cmpgt_ps(e_hi[0], zero),
+                                             _mm_cmpgt_ps(e_hi[1], zero)),
+                                  _mm_cmpgt_ps(e_hi[2], zero));
+        uint64_t row = (uint64_t)(_mm_movemask_ps(in_lo) | (_mm_movemask_ps(in_hi) << 4));
+        mask |= row << (r * QS_OCCLUSION_TILE_WIDTH);
+        for (int k = 0; k < 3; k++) {
+            e_lo[k] = _mm_add_ps(e_lo[k], step[k]);
+            e_hi[k] = _mm_add_ps(e_hi[k], step[k]);
+        }
+    }
+    return mask;
+}
+
+#elif QS_OCCLUSION_NEON
+
+static uint64_t tile_coverage(const OccTri *t, float x, float y)
+{
+    static const float    offsets[4] = { 0.0f, 1.0f, 2.0f, 3.0f };
+    static const uint32_t bits_lo[4] = { 1, 2, 4, 8 };
+    static const uint32_t bits_hi[4] = { 16, 32, 64, 128 };
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    float32x4_t lo = vaddq_f32(vdupq_n_f32(x), vld1q_f32(offsets));
+    float32x4_t hi = vaddq_f32(lo, vdupq_n_f32(4.0f));
+    float32x4_t e_lo[3], e_hi[3];
+    for (int k = 0; k < 3; k++) {
+        float32x4_t base = vdupq_n_f32(t->edge[k][1] * y + t->edge[k][2]);
+        e_lo[k] = vmlaq_n_f32(base, lo, t->edge[k][0]);
+        e_hi[k] = vmlaq_n_f32(base, hi, t->edge[k][0]);
+    }
+    uint64_t mask = 0;
+    for (int r = 0; r < QS_OCCLUSION_TILE_HEIGHT; r++) {
+        uint32x4_t in_lo = vandq_u32(vandq_u32(vcgtq_f32(e_lo[0], zero), vcgtq_f32(e_lo[1], zero)),
+                                     vcgtq_f32(e_lo[2], zero));
+        uint32x4_t in_hi = vandq_u32(vandq_u32(vcgtq_f32(e_hi[0], zero), vcgtq_f32(e_hi[1], zero)),
+                                     vcgtq_f32(e_hi[2], zero));
+        uint64_t row = vaddvq_u32(vandq_u32(in_lo, vld1q_u32(bits_lo))) +
+                       vaddvq_u32(vandq_u32(in_hi, vld1q_u32(bits_hi)));
+        mask |= row << (r * QS_OCCLUSION_TILE_WIDTH);
+        for (int k = 0; k < 3; k++) {
+            float32x4_t step = vdupq_n_f32(t->edge[k][1]);
+            e_lo[k] = vaddq_f32(e_lo[k], step);
+            e_hi[k] = vaddq_f32(e_hi[k], step);
+        }
+    }
+    return mask;
+}
+
+#else
+
+static uint64_t tile_coverage(const OccTri *t, float x, float y)
+{
+    uint64_t mask = 0;
+    for (int r = 0; r < QS_OCCLUSION_TILE_HEIGHT; r++) {
+        for (int l = 0; l < QS_OCCLUSION_TILE_WIDTH; l++) {
+            bool in = true;
+            for (int k = 0; k < 3 && in; k++)
+                in = t->edge[k][0] * (x + (float)l) + t->edge[k][1] * (y + (float)r)
+                   + t->edge[k][2] > 0.0f;
+            mask |= (uint64_t)in << (r * QS_OCCLUSION_TILE_WIDTH + l);
+        }
+    }
+    return mask;
+}
+
+#endif
+
+/* ================================================================
+   RASTERIZATION
+   Tiles are classified against each edge first: wholly outside any
+   edge → skipped, inside all three → full without the kernel.  The
+   merge follows masked occlusion: coverage accumulates into the
+   working layer, which replaces the tile depth once it covers the
+   whole tile; a triangle far in front of the working layer discards
+   it rather than dragging its depth back.
+   ================================================================ */
+
+static void tile_merge(Qs_OcclusionBuffer *b, uint32_t tile, uint64_t coverage, float z)
+{
+    if (z >= b->z_tile[tile]) return;
+    uint64_t mask = b->mask[tile];
+    float    zl   = b->z_layer[tile];
+    if (mask && zl - z > b->z_tile[tile] - zl) mask = 0;
+    zl    = mask ? fmaxf(zl, z) : z;
+    mask |= coverage;
+    if (mask == OCC_TILE_FULL) {
+        b->z_tile[tile] = zl;
+        mask = 0;
+    }
+    b->mask[tile]    = mask;
+    b->z_layer[tile] = zl;
+}
+
+static void rasterize_rows(Qs_OcclusionBuffer *b, uint32_t row_begin, uint32_t row_end)
+{
+    const float span_x = (float)(QS_OCCLUSION_TILE_WIDTH  - 1);
+    const float span_y = (float)(QS_OCCLUSION_TILE_HEIGHT - 1);
+    for (uint32_t i = 0; i < b->tri_count; i++) {
+        const OccTri *t = &b->tris[i];
+        uint32_t ty0 = t->tile_y0 > row_begin ? t->tile_y0 : row_begin;
+        uint32_t ty1 = (uint32_t)t->tile_y1 + 1 < row_end ? (uint32_t)t->tile_y1 + 1 : row_end;
+        for (uint32_t ty = ty0; ty < ty1; ty++) {
+            float y = (float)(ty * QS_OCCLUSION_TILE_HEIGHT) + 0.5f;
+            for (uint32_t tx = t->tile_x0; tx <= t->tile_x1; tx++) {
+                float x = (float)(tx * QS_OCCLUSION_TILE_WIDTH) + 0.5f;
+
+                bool outside = false, inside = true;
+                for (int k = 0; k < 3; k++) {
+                    const float *e = t->edge[k];
+                    float ax = e[0] * span_x, by = e[1] * span_y;
+                    float base = e[0] * x + e[1] * y + e[2];
+                    float hi = base + fmaxf(ax, 0.0f) + fmaxf(by, 0.0f);
+                    float lo = base + fminf(ax, 0.0f) + fminf(by, 0.0f);
+                    outside |= hi <= 0.0f;
+                    inside  &= lo > 0.0f;
+                }
+                if (outside) continue;
+
+                /* Plane depth range over the tile's pixel centres; tiles
+                   already nearer than all of it are left alone */
+                uint32_t tile = ty * b->tiles_x + tx;
+                float dx = t->dz[0] * span_x, dy = t->dz[1] * span_y;
+                float z  = t->dz[0] * x + t->dz[1] * y + t->dz[2];
+                float z_near = fmaxf(z + fminf(dx, 0.0f) + fminf(dy, 0.0f), t->z_min);
+                if (z_near >= b->z_tile[tile]) continue;
+
+                uint64_t coverage = inside ? OCC_TILE_FULL : tile_coverage(t, x, y);
+                if (!coverage) continue;
+                float z_far = z + fmaxf(dx, 0.0f) + fmaxf(dy, 0.0f);
+                tile_merge(b, tile, coverage, fminf(z_far, t->z_max));
+            }
+        }
+    }
+}
+
+static void band_job(void *data)
+{
+    const OccBand *band = data;
+    rasterize_rows(band->buffer, band->row_begin, band->row_end);
+}
+
+void qs_occlusion_rasterize(Qs_OcclusionBuffer *b, Qs_JobSystem *jobs)
+{
+    if (b->tri_count == 0) return;
+    if (jobs && b->jobs != jobs) {
+        if (b->counter) qs_job_counter_destroy(b->jobs, b->counter);
+        b->jobs    = jobs;
+        b->counter = qs_job_counter_create(jobs);
+    }
+    if (jobs && b->counter && b->band_count > 1) {
+        qs_job_dispatch_batch(jobs, b->band_jobs, b->band_count, b->counter);
+        qs_job_wait(jobs, b->counter);
+    } else {
+        rasterize_rows(b, 0, b->tiles_y);
+    }
+    b->tri_count = 0;
+}
+
+/* ================================================================
+   BOX TEST
+   A box is hidden when its nearest projected depth lies beyond the
+   tile depth of every tile its screen rectangle touches.  Boxes
+   reaching behind the camera are always kept.
+   ================================================================ */
+
+static bool box_occluded(const Qs_OcclusionBuffer *b, const float m[16],
+                         const float center[3], const float extent[3])
+{
+    /* Corner k in clip space: M*center +/- each column scaled by extent */
+    float base[4], axis[3][4];
+    for (int r = 0; r < 4; r++) {
+        base[r] = m[r]*center[0] + m[r + 4]*center[1] + m[r + 8]*center[2] + m[r + 12];
+        for (int a = 0; a < 3; a++) axis[a][r] = m[r + 4*a] * extent[a];
+    }
+    float lo[3] = {  INFINITY,  INFINITY, INFINITY };
+    float hi[2] = { -INFINITY, -INFINITY };
+    for (int k = 0; k < 8; k++) {
+        float c[4];
+        for (int r = 0; r < 4; r++)
+            c[r] = base[r] + ((k & 1) ? axis[0][r] : -axis[0][r])
+                           + ((k & 2) ? axis[1][r] : -axis[1][r])
+                           + ((k & 4) ? axis[2][r] : -axis[2][r]);
+        if (c[3] <= 0.0f) return false;
+        float inv_w = 1.0f / c[3];
+        for (int a = 0; a < 3; a++) {
+            float v = c[a] * inv_w;
+            lo[a] = fminf(lo[a], v);
+            if (a < 2) hi[a] = fmaxf(hi[a], v);
+        }
+    }
+    if (hi[0] < -1.0f || lo[0] > 1.0f || hi[1] < -1.0f || lo[1] > 1.0f) return false;
+
+    float x0 = (fmaxf(lo[0], -1.0f) * 0.5f + 0.5f) * (float)b->width;
+    float x1 = (fminf(hi[0],  1.0f) * 0.5f + 0.5f) * (float)b->width;
+    float y0 = (fmaxf(lo[1], -1.0f) * 0.5f + 0.5f) * (float)b->height;
+    float y1 = (fminf(hi[1],  1.0f) * 0.5f + 0.5f) * (float)b->height;
+    uint32_t tx0 = tile_clamp(x0, QS_OCCLUSION_TILE_WIDTH,  b->tiles_x);
+    uint32_t tx1 = tile_clamp(x1, QS_OCCLUSION_TILE_WIDTH,  b->tiles_x);
+    uint32_t ty0 = tile_clamp(y0, QS_OCCLUSION_TILE_HEIGHT, b->tiles_y);
+    uint32_t ty1 = tile_clamp(y1, QS_OCCLUSION_TILE_HEIGHT, b->tiles_y);
+    for (uint32_t ty = ty0; ty <= ty1; ty++) {
+        const float *row = b->z_tile + ty * b->tiles_x;
+        for (uint32_t tx = tx0; tx <= tx1; tx++)
+            if (lo[2] <= row[tx]) return false;
+    }
+    return true;
+}
+
+uint32_t qs_occlusion_cull(const Qs_OcclusionBuffer *b, const float view_proj[16],
+                           const Qs_CullBounds *bounds, const uint32_t *candidates,
+                           uint32_t count, uint32_t *out_visible)
+{
+    uint32_t n = 0;
+    for (uint32_t k = 0; k < count; k++) {
+        uint32_t i = candidates[k];
+        float center[3] = { bounds->center[0][i], bounds->center[1][i], bounds->center[2][i] };
+        float extent[3] = { bounds->extent[0][i], bounds->extent[1][i], bounds->extent[2][i] };
+        if (!box_occluded(b, view_proj, center, extent)) out_visible[n++] = i;
+    }
+    return n;
+}
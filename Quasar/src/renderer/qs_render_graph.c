@@ -0,0 +1,261 @@
+#include "qs_render_graph.h"
+
+#include <string.h>
+
+static bool layout_writes(Qs_GpuImageLayout layout)
+{
+    return layout == QS_GPU_IMAGE_LAYOUT_COLOR_ATTACHMENT ||
+           layout == QS_GPU_IMAGE_LAYOUT_DEPTH_ATTACHMENT;
+}
+
+static uint64_t align_up(uint64_t v, uint64_t alignment)
+{
+    return alignment > 1 ? (v + alignment - 1) / alignment * alignment : v;
+}
+
+/* ================================================================
+   SCHEDULING
+   ================================================================ */
+
+/* Fills preds[p] with the passes that must run before p.  Passes that
+   touch a common resource, at least one of them writing it, keep their
+   declaration order — except that a read declared before any writer of
+   a transient consumes this frame's contents, so that writer is pulled
+   ahead of the reader. */
+static void build_dependencies(const Qs_RgPass *passes, uint32_t pass_count,
+                               const uint32_t *reads, const uint32_t *writes,
+                               uint32_t transient, uint32_t *preds)
+{
+    uint32_t written_before = 0;
+    for (uint32_t i = 0; i < pass_count; i++) {
+        bool opaque_i = passes[i].access_count == 0;
+        for (uint32_t j = i + 1; j < pass_count; j++) {
+            bool opaque = opaque_i || passes[j].access_count == 0;
+            uint32_t hazard = (writes[i] & (reads[j] | writes[j])) | (reads[i] & writes[j]);
+            if (!opaque && !hazard) continue;
+
+            uint32_t pulled = reads[i] & writes[j] & transient & ~written_before;
+            if (!opaque && pulled && hazard == pulled)
+                preds[i] |= 1u << j;
+            else
+                preds[j] |= 1u << i;
+        }
+        written_before |= writes[i];
+    }
+}
+
+/* Kahn's algorithm, always taking the lowest ready declaration index so
+   independent passes keep their priority order.  False on a cycle. */
+static bool schedule(const uint32_t *preds, uint32_t pass_count, uint32_t *order)
+{
+    uint32_t done = 0;
+    for (uint32_t n = 0; n < pass_count; n++) {
+        uint32_t p = 0;
+        while (p < pass_count &&
+               ((done >> p & 1u) || (preds[p] & ~done)))
+            p++;
+        if (p == pass_count) return false;
+        order[n] = p;
+        done    |= 1u << p;
+    }
+    return true;
+}
+
+/* ================================================================
+   TRANSIENT ALIASING
+   ================================================================ */
+
+/* Greedy placement, largest first: each transient takes the lowest
+   offset not overlapping a placed transient whose lifetime (first to
+   last scheduled use) overlaps its own.  Transients whose memory types
+   exclude the heap's stay unplaced. */
+static void place_transients(const Qs_RgResource *resources, uint32_t resource_count,
+                             const uint32_t *first, const uint32_t *last,
+                             Qs_RgPlan *out)
+{
+    uint32_t sorted[QS_RG_MAX_RESOURCES];
+    uint32_t count = 0;
+    for (uint32_t r = 0; r < resource_count; r++) {
+        out->heap_offset[r] = QS_RG_NOT_ALIASED;
+        if (!resources[r].transient || first[r] == UINT32_MAX) continue;
+        uint32_t k = count++;
+        while (k > 0 && resources[sorted[k - 1]].size < resources[r].size) {
+            sorted[k] = sorted[k - 1];
+            k--;
+        }
+        sorted[k] = r;
+    }
+
+    uint32_t placed[QS_RG_MAX_RESOURCES];
+    uint32_t placed_count = 0;
+    uint32_t type_bits    = UINT32_MAX;
+    out->heap_size = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t r = sorted[i];
+        const Qs_RgResource *res = &resources[r];
+        if (!(res->type_bits & type_bits)) continue;
+
+        uint64_t offset = 0;
+        bool moved = true;
+        while (moved) {
+            moved = false;
+            for (uint32_t k = 0; k < placed_count; k++) {
+                uint32_t q = placed[k];
+                if (last[q] < first[r] || last[r] < first[q]) continue;
+                uint64_t q_end = out->heap_offset[q] + resources[q].size;
+                if (offset < q_end && out->heap_offset[q] < offset + res->size) {
+                    offset = align_up(q_end, res->alignment);
+                    moved  = true;
+                }
+            }
+        }
+
+        type_bits &= res->type_bits;
+        out->heap_offset[r]    = offset;
+        placed[placed_count++] = r;
+        if (offset + res->size > out->heap_size)
+            out->heap_size = offset + res->size;
+    }
+    out->heap_type_bits = placed_count > 0 ? type_bits : 0;
+}
+
+/* Last layout left in r's memory before its first use: that of the
+   latest earlier user of overlapping memory, or failing that the last
+   user of the previous frame (possibly r itself). */
+static Qs_GpuImageLayout previous_occupant_layout(const Qs_RgResource *resources,
+                                                  uint32_t resource_count,
+                                                  const Qs_RgPlan *plan, uint32_t r,
+                                                  const uint32_t *first, const uint32_t *last,
+                                                  const Qs_GpuImageLayout *last_layout)
+{
+    uint32_t best = r, best_key = 0;
+    for (uint32_t q = 0; q < resource_count; q++) {
+        if (first[q] == UINT32_MAX) continue;
+        if (q != r) {
+            if (plan->heap_offset[q] == QS_RG_NOT_ALIASED ||
+                plan->heap_offset[r] == QS_RG_NOT_ALIASED) continue;
+            uint64_t r_end = plan->heap_offset[r] + resources[r].size;
+            uint64_t q_end = plan->heap_offset[q] + resources[q].size;
+            if (plan->heap_offset[q] >= r_end || plan->heap_offset[r] >= q_end) continue;
+        }
+        /* Earlier this frame ranks above any use in the previous frame */
+        uint32_t key = last[q] < first[r] ? QS_RG_MAX_PASSES + 1 + last[q] : last[q] + 1;
+        if (key > best_key) { best_key = key; best = q; }
+    }
+    return last_layout[best];
+}
+
+/* ================================================================
+   COMPILE
+   ================================================================ */
+
+static void push_barrier(Qs_RgPlan *out, uint32_t r, Qs_GpuImageLayout old_layout,
+                         Qs_GpuImageLayout new_layout, Qs_GpuImageLayout wait_layout)
+{
+    out->barriers[out->barrier_count++] = (Qs_RgBarrier){
+        .resource    = r,
+        .old_layout  = old_layout,
+        .new_layout  = new_layout,
+        .wait_layout = wait_layout,
+    };
+}
+
+bool qs_render_graph_compile(const Qs_RgResource *resources, uint32_t resource_count,
+                             const Qs_RgPass *passes, uint32_t pass_count,
+                             Qs_RgPlan *out)
+{
+    if (resource_count > QS_RG_MAX_RESOURCES || pass_count > QS_RG_MAX_PASSES)
+        return false;
+    memset(out, 0, sizeof(*out));
+
+    uint32_t transient = 0;
+    for (uint32_t r = 0; r < resource_count; r++)
+        if (resources[r].transient) transient |= 1u << r;
+
+    uint32_t reads[QS_RG_MAX_PASSES] = {0}, writes[QS_RG_MAX_PASSES] = {0};
+    for (uint32_t p = 0; p < pass_count; p++) {
+        if (passes[p].access_count > QS_RG_MAX_ACCESSES) return false;
+        for (uint32_t a = 0; a < passes[p].access_count; a++) {
+            const Qs_RgAccess *acc = &passes[p].accesses[a];
+            if (acc->resource >= resource_count) return false;
+            if (layout_writes(acc->layout)) writes[p] |= 1u << acc->resource;
+            else                            reads[p]  |= 1u << acc->resource;
+        }
+    }
+
+    uint32_t preds[QS_RG_MAX_PASSES] = {0};
+    uint32_t sched[QS_RG_MAX_PASSES];
+    build_dependencies(passes, pass_count, reads, writes, transient, preds);
+    if (!schedule(preds, pass_count, sched)) return false;
+
+    /* Cull backwards: a pass survives if it is opaque, has side effects,
+       writes a persistent resource, or writes what a survivor reads */
+    bool     alive[QS_RG_MAX_PASSES] = {0};
+    uint32_t needed = 0;
+    for (uint32_t k = pass_count; k-- > 0;) {
+        uint32_t p = sched[k];
+        alive[p] = passes[p].side_effects || passes[p].access_count == 0 ||
+                   (writes[p] & (~transient | needed));
+        if (alive[p]) needed |= reads[p];
+    }
+    for (uint32_t k = 0; k < pass_count; k++)
+        if (alive[sched[k]]) out->order[out->order_count++] = sched[k];
+
+    uint32_t          first[QS_RG_MAX_RESOURCES], last[QS_RG_MAX_RESOURCES];
+    Qs_GpuImageLayout last_layout[QS_RG_MAX_RESOURCES];
+    for (uint32_t r = 0; r < resource_count; r++) {
+        first[r]       = UINT32_MAX;
+        last[r]        = 0;
+        last_layout[r] = resources[r].layout;
+    }
+    for (uint32_t k = 0; k < out->order_count; k++) {
+        const Qs_RgPass *pass = &passes[out->order[k]];
+        for (uint32_t a = 0; a < pass->access_count; a++) {
+            uint32_t r = pass->accesses[a].resource;
+            if (first[r] == UINT32_MAX) first[r] = k;
+            last[r]        = k;
+            last_layout[r] = pass->accesses[a].layout;
+        }
+    }
+
+    place_transients(resources, resource_count, first, last, out);
+
+    /* Barriers: a transient's first use discards its contents; later uses
+       transition on a layout change or around a write.  Reads in an
+       unchanged layout share the barrier that preceded the first one. */
+    Qs_GpuImageLayout state[QS_RG_MAX_RESOURCES];
+    uint32_t          wrote = 0;
+    for (uint32_t r = 0; r < resource_count; r++) {
+        state[r] = resources[r].layout;
+        if (!resources[r].transient && layout_writes(state[r])) wrote |= 1u << r;
+    }
+    for (uint32_t k = 0; k < out->order_count; k++) {
+        out->barrier_start[k] = out->barrier_count;
+        const Qs_RgPass *pass = &passes[out->order[k]];
+        uint32_t seen = 0;
+        for (uint32_t a = 0; a < pass->access_count; a++) {
+            uint32_t          r      = pass->accesses[a].resource;
+            Qs_GpuImageLayout layout = pass->accesses[a].layout;
+            uint32_t          bit    = 1u << r;
+            bool              write  = layout_writes(layout);
+
+            if ((seen & bit) && state[r] == layout) continue;
+            if (resources[r].transient && first[r] == k && !(seen & bit))
+                push_barrier(out, r, QS_GPU_IMAGE_LAYOUT_UNDEFINED, layout,
+                             previous_occupant_layout(resources, resource_count, out, r,
+                                                      first, last, last_layout));
+            else if (state[r] != layout || write || (wrote & bit))
+                push_barrier(out, r, state[r], layout, QS_GPU_IMAGE_LAYOUT_UNDEFINED);
+
+            seen    |= bit;
+            state[r] = layout;
+            wrote    = write ? (wrote | bit) : (wrote & ~bit);
+        }
+    }
+
+    out->barrier_start[out->order_count] = out->barrier_count;
+    for (uint32_t r = 0; r < resource_count; r++)
+        if (!resources[r].transient && state[r] != resources[r].layout)
+            push_barrier(out, r, state[r], resources[r].layout, QS_GPU_IMAGE_LAYOUT_UNDEFINED);
+    return true;
+}
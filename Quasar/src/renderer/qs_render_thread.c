@@ -0,0 +1,154 @@
+#include "qs_render_thread.h"
+
+#include <causality.h>
+#include <stdlib.h>
+
+struct Qs_RenderHandoff {
+    Ca_Mutex   *mutex;
+    Ca_CondVar *wake;        /* render thread: published or quitting */
+    Ca_CondVar *idle;        /* flush: render thread caught up */
+    Ca_Thread  *thread;
+
+    Qs_RenderPrepareFn prepare;
+    void              *user_data;
+
+    /* Snapshot held by each role */
+    uint32_t write;
+    uint32_t ready;
+    uint32_t preparing;
+    uint32_t prepared;
+    uint32_t record;
+
+    bool ready_fresh;        /* ready holds a snapshot nobody took yet */
+    bool prepared_fresh;
+    bool busy;               /* prepare() running */
+    bool quit;
+};
+
+static void swap_index(uint32_t *a, uint32_t *b)
+{
+    uint32_t t = *a;
+    *a = *b;
+    *b = t;
+}
+
+static void *render_thread_fn(void *arg)
+{
+    Qs_RenderHandoff *h = arg;
+    ca_mutex_lock(h->mutex);
+    for (;;) {
+        while (!h->ready_fresh && !h->quit)
+            ca_condvar_wait(h->wake, h->mutex);
+        if (h->quit) break;
+
+        swap_index(&h->ready, &h->preparing);
+        h->ready_fresh = false;
+        h->busy        = true;
+        ca_mutex_unlock(h->mutex);
+
+        h->prepare(h->preparing, h->user_data);
+
+        ca_mutex_lock(h->mutex);
+        swap_index(&h->preparing, &h->prepared);
+        h->prepared_fresh = true;
+        h->busy           = false;
+        if (!h->ready_fresh) ca_condvar_broadcast(h->idle);
+    }
+    ca_mutex_unlock(h->mutex);
+    return NULL;
+}
+
+static void handoff_release(Qs_RenderHandoff *h)
+{
+    ca_condvar_destroy(h->idle);
+    ca_condvar_destroy(h->wake);
+    ca_mutex_destroy(h->mutex);
+    free(h);
+}
+
+Qs_RenderHandoff *qs_render_handoff_create(Qs_RenderPrepareFn prepare, void *user_data)
+{
+    Qs_RenderHandoff *h = calloc(1, sizeof(Qs_RenderHandoff));
+    if (!h) return NULL;
+    h->write     = 0;
+    h->ready     = 1;
+    h->record    = 2;
+    h->preparing = 3;
+    h->prepared  = 4;
+    h->prepare   = prepare;
+    h->user_data = user_data;
+
+    h->mutex = ca_mutex_create();
+    h->wake  = ca_condvar_create();
+    h->idle  = ca_condvar_create();
+    if (!h->mutex || !h->wake || !h->idle) {
+        handoff_release(h);
+        return NULL;
+    }
+    if (prepare && !(h->thread = ca_thread_create(render_thread_fn, h))) {
+        handoff_release(h);
+        return NULL;
+    }
+    return h;
+}
+
+void qs_render_handoff_destroy(Qs_RenderHandoff *h)
+{
+    if (!h) return;
+    if (h->thread) {
+        ca_mutex_lock(h->mutex);
+        h->quit = true;
+        ca_condvar_signal(h->wake);
+        ca_mutex_unlock(h->mutex);
+        ca_thread_join(h->thread);
+    }
+    handoff_release(h);
+}
+
+bool qs_render_handoff_threaded(const Qs_RenderHandoff *h)
+{
+    return h->thread != NULL;
+}
+
+uint32_t qs_render_handoff_write_index(const Qs_RenderHandoff *h)
+{
+    /* Only the simulation side moves write */
+    return h->write;
+}
+
+uint32_t qs_render_handoff_publish(Qs_RenderHandoff *h)
+{
+    ca_mutex_lock(h->mutex);
+    swap_index(&h->write, &h->ready);
+    h->ready_fresh = true;
+    if (h->thread) ca_condvar_signal(h->wake);
+    uint32_t write = h->write;
+    ca_mutex_unlock(h->mutex);
+    return write;
+}
+
+uint32_t qs_render_handoff_acquire(Qs_RenderHandoff *h)
+{
+    ca_mutex_lock(h->mutex);
+    if (h->thread) {
+        if (h->prepared_fresh) {
+            swap_index(&h->prepared, &h->record);
+            h->prepared_fresh = false;
+        }
+    } else if (h->ready_fresh) {
+        swap_index(&h->ready, &h->record);
+        h->ready_fresh = false;
+    }
+    uint32_t record = h->record;
+    ca_mutex_unlock(h->mutex);
+    return record;
+}
+
+void qs_render_handoff_flush(Qs_RenderHandoff *h)
+{
+    if (!h->thread) return;
+    ca_mutex_lock(h->mutex);
+    while (h->ready_fresh || h->busy)
+        ca_condvar_wait(h->idle, h->mutex);
+    ca_mutex_unlock(h->mutex);
+}
@@ -1,4 +1,9 @@
 ﻿#include "qs_renderer.h"
+#include "qs_cull.h"
+#include "qs_draw_list.h"
+#include "qs_occlusion.h"
+#include "qs_render_graph.h"
+#include "qs_render_thread.h"
 #include "qs_math.h"
 #include "qs_scene.h"
 #include "qs_light.h"
@@ -6,7 +11,9 @@
 #include "qs_mesh.h"
 #include "qs_material.h"
 #include "qs_system.h"
+#include "qs_job.h"
 #include "qs_log.h"
+#include "quasar.h"
 
 #include <stddef.h>
 #include <stdlib.h>
@@ -21,7 +28,14 @@
 
 #define QS_MAX_RENDER_NODES  16
 #define QS_MAX_ATTACHMENTS   16
-#define QS_MAX_RENDERABLES   4096
+#define QS_RENDER_PROXY_INITIAL_CAPACITY 256
+#define QS_RENDER_PROXY_SLOT_MASK        0x00FFFFFFu
+#define QS_RENDER_PROXY_GEN_SHIFT        24
+#define QS_RENDER_RECORD_MIN_DRAWS       128
+#define QS_FRAME_ARENA_INITIAL_SIZE      (256u * 1024u)
+#define QS_FRAME_ARENA_RETIRED_MAX       4
+#define QS_FRAME_FENCE_TIMEOUT_NS        2000000000ull
+#define QS_OCCLUSION_BUFFER_WIDTH        256
 
 struct Qs_RenderNode {
     char             name[64];
@@ -29,6 +43,9 @@ struct Qs_RenderNode {
     Qs_RenderNodeFn  execute;
     void            *user_data;
     bool             active;
+    Qs_RenderAccess  accesses[QS_RENDER_NODE_ACCESSES_MAX];
+    uint32_t         access_count;
+    bool             side_effects;
 };
 
 struct Qs_RenderAttachment {
@@ -39,11 +56,70 @@ struct Qs_RenderAttachment {
     float                    height_scale;
     uint32_t                 fixed_width;
     uint32_t                 fixed_height;
+    bool                     transient;
+    bool                     copy_dst;
     Qs_GpuImage             *image;
     Qs_GpuImageView         *view;
     bool                     in_use;
 };
 
+/* Per-frame GPU data for one frame in flight.  Reused only once the
+   fence signalled at the end of that frame's commands has passed. */
+typedef struct FrameSlot {
+    Qs_GpuFence   *fence;
+    Qs_GpuBuffer  *frame_ubo;
+    Qs_GpuBuffer  *lights_buffer;
+
+    /* Parallel pass recording — one command pool per range slot */
+    Qs_GpuCmdPool *record_pools[QS_RENDER_RECORD_RANGES_MAX];
+    uint32_t       record_pool_count;
+
+    /* Linear allocator for dynamic uniforms and instance data.  An arena
+       outgrown mid-frame is retired until the slot comes round again. */
+    Qs_GpuBuffer  *arena;
+    uint64_t       arena_size;
+    uint64_t       arena_head;
+    Qs_GpuBuffer  *retired[QS_FRAME_ARENA_RETIRED_MAX];
+    uint32_t       retired_count;
+} FrameSlot;
+
+/* Immutable copy of everything the render side reads for one frame.
+   Arrays are synced incrementally: only proxies whose change serial is
+   newer than the snapshot's serial are copied on publish. */
+typedef struct RenderSnapshot {
+    uint32_t        serial;          /* publish serial; 0 = never published */
+    Qs_Camera       camera;
+    bool            wireframe;
+    uint32_t        debug_flags;
+    float           dt;
+    Qs_LightGPU     lights[QS_LIGHTS_MAX];
+    uint32_t        light_count;
+
+    float         (*transforms)[16];
+    Qs_CullBounds   bounds;
+    Qs_Renderable  *renderables;
+    uint32_t       *change_serial;
+    uint32_t        renderable_count;
+    uint32_t        capacity;
+
+    uint32_t        width;           /* viewport size at publish */
+    uint32_t        height;
+
+    /* Render-side scratch, sized with the arrays above */
+    uint32_t       *visible;
+    uint32_t       *dirty;
+
+    /* Culling results, filled by snapshot_prepare for prepared_width x
+       prepared_height (0 x 0 = not prepared yet) */
+    uint32_t        prepared_width;
+    uint32_t        prepared_height;
+    float           view[16];
+    float           proj[16];
+    float           view_proj[16];
+    uint32_t        in_frustum;
+    uint32_t        visible_count;
+} RenderSnapshot;
+
 struct Qs_Renderer {
     char name[64];
 
@@ -74,15 +150,51 @@ struct Qs_Renderer {
     Qs_RenderNode nodes[QS_MAX_RENDER_NODES];
     uint32_t      node_count;
 
-    /* Per-frame renderable and light submission buffers */
-    Qs_Renderable renderables[QS_MAX_RENDERABLES];
-    uint32_t      renderable_count;
+    /* Render graph compiled over nodes and attachments; rebuilt on resize
+       and after either changes.  Transient attachments live in
+       transient_heap at the offsets it assigns. */
+    Qs_RgPlan     graph;
+    bool          graph_dirty;
+    Qs_GpuMemory *transient_heap;
+
+    /* Persistent render proxies — dense, growable, indexed together.
+       Hot data (transforms, cull bounds) is kept apart from the cold
+       GPU-packed Qs_Renderable so culling streams only what it reads. */
+    float         (*transforms)[16];
+    Qs_CullBounds   cull_bounds;
+    Qs_Renderable  *renderables;
+    uint32_t       *proxy_slot;      /* dense index → handle slot */
+    uint32_t        renderable_count;
+    uint32_t        renderable_capacity;
+
+    /* Publish serial of the first snapshot to include each dense index's
+       latest change (transform, bounds, tint, geometry or a move) */
+    uint32_t       *change_serial;
+
+    /* Proxy handle slots: dense index (free: next free slot) + generation */
+    uint32_t       *slot_index;
+    uint8_t        *slot_gen;
+    uint32_t        slot_count;
+    uint32_t        slot_free;       /* UINT32_MAX = empty free list */
+
+    Qs_RenderStats  stats;
+
+    /* Per-frame light submission buffer */
     Qs_LightGPU   lights[QS_LIGHTS_MAX];
     uint32_t      light_count;
 
-    /* Engine-managed per-frame uniform buffers */
-    Qs_GpuBuffer *frame_ubo;
-    Qs_GpuBuffer *lights_ubo;
+    /* Render snapshots passed from the simulation to the viewport
+       callback, through the render thread when one is enabled */
+    RenderSnapshot    snapshots[QS_RENDER_HANDOFF_SNAPSHOTS];
+    Qs_RenderHandoff *handoff;
+    uint32_t          publish_serial;   /* simulation side */
+    uint32_t          consumed_serial;  /* render side: last snapshot rendered */
+
+    /* Frames in flight: the CPU records into frames[frame_index] while
+       the GPU may still be consuming the others */
+    FrameSlot     frames[QS_RENDER_FRAMES_IN_FLIGHT];
+    uint32_t      frame_index;
+    uint64_t      arena_align;
 
     /* Engine-managed default material (used when a renderable has none) */
     Qs_Material  *default_material;
@@ -93,8 +205,18 @@ struct Qs_Renderer {
 
     /* Bound viewport (for unbinding on destroy) */
     Qs_Viewport  *bound_viewport;
+
+    Qs_JobCounter *record_counter;
+
+    /* Software occlusion (render side): the buffer, recreated when the
+       viewport aspect changes, and this frame's occluders in view */
+    Qs_OcclusionBuffer *occlusion;
+    Qs_DrawList         occluders;
 };
 
+/* Defined in qs_scene.c — invalidates scene-held proxy handles. */
+void qs_scene_release_renderer(Qs_Renderer *renderer);
+
 /* ================================================================
    BACKEND REGISTRY
    ================================================================ */
@@ -244,40 +366,61 @@ static void destroy_attachment_resource(Qs_Renderer *r, Qs_RenderAttachment *att
     if (att->image) { qs_gpu_destroy_image(r->gpu, att->image);      att->image = NULL; }
 }
 
-static bool create_attachment_resource(Qs_Renderer *r, Qs_RenderAttachment *att,
-                                        uint32_t w, uint32_t h)
+static Qs_GpuImageDesc attachment_image_desc(const Qs_Renderer *r,
+                                             const Qs_RenderAttachment *att)
 {
-    Qs_GpuImageUsage usage_flags = (att->usage == QS_ATTACHMENT_DEPTH)
+    uint32_t w = att->fixed_width, h = att->fixed_height;
+    if (w == 0 || h == 0) {
+        /* Viewport-scaled: 1x1 placeholder until the first resize */
+        w = (uint32_t)(r->fb_width  * att->width_scale  + 0.5f);
+        h = (uint32_t)(r->fb_height * att->height_scale + 0.5f);
+    }
+    Qs_GpuImageUsage usage = (att->usage == QS_ATTACHMENT_DEPTH)
         ? (QS_GPU_IMAGE_DEPTH_ATTACHMENT | QS_GPU_IMAGE_SAMPLED)
         : (QS_GPU_IMAGE_COLOR_ATTACHMENT | QS_GPU_IMAGE_SAMPLED);
-
-    att->image = qs_gpu_create_image(r->gpu, &(Qs_GpuImageDesc){
-        .width      = w,
-        .height     = h,
+    if (att->copy_dst) usage |= QS_GPU_IMAGE_TRANSFER_DST;
+    return (Qs_GpuImageDesc){
+        .width      = w < 1 ? 1 : w,
+        .height     = h < 1 ? 1 : h,
         .mip_levels = 1,
         .format     = att->format,
-        .usage      = usage_flags,
-    });
-    if (!att->image) return false;
+        .usage      = usage,
+    };
+}
 
-    Qs_GpuImageAspect aspect = (att->usage == QS_ATTACHMENT_DEPTH)
+static Qs_GpuImageAspect attachment_aspect(const Qs_RenderAttachment *att)
+{
+    return (att->usage == QS_ATTACHMENT_DEPTH)
         ? QS_GPU_IMAGE_ASPECT_DEPTH
         : QS_GPU_IMAGE_ASPECT_COLOR;
+}
 
-    att->view = qs_gpu_create_image_view_for(r->gpu, att->image, aspect);
+/* Creates the image at the current framebuffer size, placed in memory
+   at offset when memory is non-NULL. */
+static bool create_attachment_resource(Qs_Renderer *r, Qs_RenderAttachment *att,
+                                        Qs_GpuMemory *memory, uint64_t offset)
+{
+    Qs_GpuImageDesc desc = attachment_image_desc(r, att);
+    desc.memory        = memory;
+    desc.memory_offset = offset;
+    att->image = qs_gpu_create_image(r->gpu, &desc);
+    if (!att->image) return false;
+
+    att->view = qs_gpu_create_image_view_for(r->gpu, att->image, attachment_aspect(att));
     if (!att->view) {
         qs_gpu_destroy_image(r->gpu, att->image); att->image = NULL;
         return false;
     }
+    if (att->transient) return true;
 
-    /* Initialise layout to SHADER_READ so the first per-frame barrier can
-       transition FROM it without a validation error. */
+    /* Persistent attachments rest in SHADER_READ between frames, the
+       layout the graph's closing barriers return them to. */
     Qs_GpuCmd *cmd = qs_gpu_begin_transfer(r->gpu);
     qs_cmd_image_barrier(cmd, &(Qs_GpuImageBarrier){
         .image      = att->image,
         .old_layout = QS_GPU_IMAGE_LAYOUT_UNDEFINED,
         .new_layout = QS_GPU_IMAGE_LAYOUT_SHADER_READ,
-        .aspect     = aspect,
+        .aspect     = attachment_aspect(att),
         .base_mip   = 0,
         .mip_count  = 1,
     });
@@ -285,6 +428,114 @@ static bool create_attachment_resource(Qs_Renderer *r, Qs_RenderAttachment *att,
     return true;
 }
 
+/* ================================================================
+   RENDER GRAPH
+   ================================================================ */
+
+/* Index of att in r->attachments, or UINT32_MAX when att is NULL, lies
+   outside the array or names a removed attachment. */
+static uint32_t attachment_index(const Qs_Renderer *r, const Qs_RenderAttachment *att)
+{
+    uintptr_t base = (uintptr_t)r->attachments, p = (uintptr_t)att;
+    if (!att || p < base) return UINT32_MAX;
+    uintptr_t offset = p - base;
+    if (offset % sizeof(*att) != 0) return UINT32_MAX;
+    uintptr_t index = offset / sizeof(*att);
+    if (index >= r->attachment_count || !r->attachments[index].in_use) return UINT32_MAX;
+    return (uint32_t)index;
+}
+
+/* Compiles the graph at the current framebuffer size and recreates the
+   transient attachments in the memory it assigns them.  If compiling
+   fails no node runs and transients get dedicated memory. */
+static void graph_build(Qs_Renderer *r)
+{
+    Qs_RgResource resources[QS_MAX_ATTACHMENTS];
+    for (uint32_t i = 0; i < r->attachment_count; i++) {
+        const Qs_RenderAttachment *att = &r->attachments[i];
+        resources[i] = (Qs_RgResource){
+            .transient = att->transient,
+            .layout    = QS_GPU_IMAGE_LAYOUT_SHADER_READ,
+        };
+        if (!att->transient) continue;
+        Qs_GpuImageDesc          desc = attachment_image_desc(r, att);
+        Qs_GpuMemoryRequirements req  = qs_gpu_image_requirements(r->gpu, &desc);
+        resources[i].size      = req.size;
+        resources[i].alignment = req.alignment;
+        resources[i].type_bits = req.type_bits;
+    }
+
+    Qs_RgPass passes[QS_MAX_RENDER_NODES];
+    for (uint32_t i = 0; i < r->node_count; i++) {
+        const Qs_RenderNode *node = &r->nodes[i];
+        passes[i].access_count = 0;
+        passes[i].side_effects = node->side_effects;
+        /* A bad access is dropped; a node left with none is kept and
+           ordered against every other node */
+        for (uint32_t a = 0; a < node->access_count; a++) {
+            uint32_t resource = attachment_index(r, node->accesses[a].attachment);
+            if (resource == UINT32_MAX) {
+                QS_LOG_ERROR("Renderer '%s': node '%s' access %u is not one of "
+                             "the renderer's attachments", r->name, node->name, a);
+                continue;
+            }
+            passes[i].accesses[passes[i].access_count++] = (Qs_RgAccess){
+                .resource = resource,
+                .layout   = node->accesses[a].layout,
+            };
+        }
+    }
+
+    bool ok = qs_render_graph_compile(resources, r->attachment_count,
+                                      passes, r->node_count, &r->graph);
+    if (!ok)
+        QS_LOG_ERROR("Renderer '%s': render graph has a dependency cycle", r->name);
+    r->graph_dirty = false;
+
+    for (uint32_t i = 0; i < r->attachment_count; i++)
+        if (r->attachments[i].transient)
+            destroy_attachment_resource(r, &r->attachments[i]);
+    qs_gpu_destroy_memory(r->gpu, r->transient_heap);
+    r->transient_heap = NULL;
+    if (ok && r->graph.heap_size > 0) {
+        r->transient_heap = qs_gpu_create_memory(r->gpu, r->graph.heap_size,
+                                                 r->graph.heap_type_bits);
+        if (!r->transient_heap)
+            QS_LOG_WARN("Renderer '%s': transient heap allocation failed, "
+                        "using dedicated memory", r->name);
+    }
+
+    for (uint32_t i = 0; i < r->attachment_count; i++) {
+        Qs_RenderAttachment *att = &r->attachments[i];
+        if (!att->transient) continue;
+        bool placed = r->transient_heap && r->graph.heap_offset[i] != QS_RG_NOT_ALIASED;
+        if (!create_attachment_resource(r, att, placed ? r->transient_heap : NULL,
+                                        placed ? r->graph.heap_offset[i] : 0))
+            QS_LOG_ERROR("Renderer '%s': failed to create attachment '%s'",
+                         r->name, att->name);
+    }
+}
+
+/* Records plan barriers [begin, end). */
+static void graph_barriers(const Qs_Renderer *r, Qs_GpuCmd *cmd,
+                           uint32_t begin, uint32_t end)
+{
+    for (uint32_t b = begin; b < end; b++) {
+        const Qs_RgBarrier        *rb  = &r->graph.barriers[b];
+        const Qs_RenderAttachment *att = &r->attachments[rb->resource];
+        if (!att->image) continue;
+        qs_cmd_image_barrier(cmd, &(Qs_GpuImageBarrier){
+            .image       = att->image,
+            .old_layout  = rb->old_layout,
+            .new_layout  = rb->new_layout,
+            .wait_layout = rb->wait_layout,
+            .aspect      = attachment_aspect(att),
+            .base_mip    = 0,
+            .mip_count   = 1,
+        });
+    }
+}
+
 /* ================================================================
    DEPTH ATTACHMENT HELPERS
    ================================================================ */
@@ -302,20 +553,342 @@ static void recreate_depth(Qs_Renderer *r, uint32_t w, uint32_t h)
     r->depth = qs_gpu_create_image(r->gpu, &(Qs_GpuImageDesc){
         .width=w, .height=h, .mip_levels=1,
         .format=QS_GPU_FORMAT_DEPTH_AUTO,
-        .usage =QS_GPU_IMAGE_DEPTH_ATTACHMENT,
+        .usage =QS_GPU_IMAGE_DEPTH_ATTACHMENT | QS_GPU_IMAGE_SAMPLED,
     });
     if (!r->depth) return;
     r->depth_view = qs_gpu_create_image_view_for(r->gpu, r->depth,
                                                   QS_GPU_IMAGE_ASPECT_DEPTH);
     if (!r->depth_view) {
         qs_gpu_destroy_image(r->gpu, r->depth); r->depth = NULL;
+        return;
     }
+
+    /* The depth buffer rests in DEPTH_ATTACHMENT, the layout passes that
+       sample it return it to, so their barriers hold from the first frame */
+    Qs_GpuCmd *cmd = qs_gpu_begin_transfer(r->gpu);
+    qs_cmd_image_barrier(cmd, &(Qs_GpuImageBarrier){
+        .image      = r->depth,
+        .old_layout = QS_GPU_IMAGE_LAYOUT_UNDEFINED,
+        .new_layout = QS_GPU_IMAGE_LAYOUT_DEPTH_ATTACHMENT,
+        .aspect     = QS_GPU_IMAGE_ASPECT_DEPTH,
+        .base_mip   = 0,
+        .mip_count  = 1,
+    });
+    qs_gpu_end_transfer(r->gpu, cmd);
+}
+
+/* ================================================================
+   RENDER PROXY POOL
+   ================================================================ */
+
+static bool proxy_pool_grow(Qs_Renderer *r)
+{
+    uint32_t cap = r->renderable_capacity ? r->renderable_capacity * 2
+                                          : QS_RENDER_PROXY_INITIAL_CAPACITY;
+    if (cap > QS_RENDER_PROXY_SLOT_MASK) return false;
+
+    /* Each array keeps its old block on failure, so the pool stays valid */
+    void *p;
+    if (!(p = realloc(r->transforms,  cap * sizeof(*r->transforms))))  return false;
+    r->transforms = p;
+    if (!(p = realloc(r->renderables, cap * sizeof(*r->renderables)))) return false;
+    r->renderables = p;
+    if (!(p = realloc(r->proxy_slot,  cap * sizeof(*r->proxy_slot))))  return false;
+    r->proxy_slot = p;
+    if (!(p = realloc(r->change_serial, cap * sizeof(*r->change_serial)))) return false;
+    r->change_serial = p;
+    if (!(p = realloc(r->slot_index,  cap * sizeof(*r->slot_index))))  return false;
+    r->slot_index = p;
+    if (!(p = realloc(r->slot_gen,    cap * sizeof(*r->slot_gen))))    return false;
+    r->slot_gen = p;
+    memset(r->slot_gen + r->renderable_capacity, 0,
+           (cap - r->renderable_capacity) * sizeof(*r->slot_gen));
+    if (!qs_cull_bounds_reserve(&r->cull_bounds, cap)) return false;
+
+    r->renderable_capacity = cap;
+    return true;
+}
+
+static void proxy_pool_free(Qs_Renderer *r)
+{
+    free(r->transforms);
+    free(r->renderables);
+    free(r->proxy_slot);
+    free(r->change_serial);
+    free(r->slot_index);
+    free(r->slot_gen);
+    qs_cull_bounds_free(&r->cull_bounds);
+}
+
+/* ================================================================
+   RENDER SNAPSHOTS
+   ================================================================ */
+
+static bool snapshot_reserve(RenderSnapshot *s, uint32_t capacity)
+{
+    if (capacity <= s->capacity) return true;
+
+    void *p;
+    if (!(p = realloc(s->transforms,    capacity * sizeof(*s->transforms))))    return false;
+    s->transforms = p;
+    if (!(p = realloc(s->renderables,   capacity * sizeof(*s->renderables))))   return false;
+    s->renderables = p;
+    if (!(p = realloc(s->change_serial, capacity * sizeof(*s->change_serial)))) return false;
+    s->change_serial = p;
+    if (!(p = realloc(s->visible,       capacity * sizeof(*s->visible))))       return false;
+    s->visible = p;
+    if (!(p = realloc(s->dirty,         capacity * sizeof(*s->dirty))))         return false;
+    s->dirty = p;
+    if (!qs_cull_bounds_reserve(&s->bounds, capacity)) return false;
+
+    s->capacity = capacity;
+    return true;
+}
+
+static void snapshot_free(RenderSnapshot *s)
+{
+    free(s->transforms);
+    free(s->renderables);
+    free(s->change_serial);
+    free(s->visible);
+    free(s->dirty);
+    qs_cull_bounds_free(&s->bounds);
+    memset(s, 0, sizeof(*s));
+}
+
+/* Brings s up to the live state.  A proxy changed since s was last
+   synced carries a change serial newer than s->serial. */
+static bool snapshot_sync(const Qs_Renderer *r, RenderSnapshot *s)
+{
+    uint32_t n = r->renderable_count;
+    if (!snapshot_reserve(s, r->renderable_capacity)) return false;
+
+    for (uint32_t i = 0; i < n; i++) {
+        if (r->change_serial[i] <= s->serial) continue;
+        memcpy(s->transforms[i], r->transforms[i], 64);
+        s->renderables[i]   = r->renderables[i];
+        s->change_serial[i] = r->change_serial[i];
+        for (int k = 0; k < 3; k++) {
+            s->bounds.center[k][i] = r->cull_bounds.center[k][i];
+            s->bounds.extent[k][i] = r->cull_bounds.extent[k][i];
+        }
+    }
+    s->renderable_count = n;
+    s->bounds.count     = n;
+
+    s->camera      = r->camera;
+    s->wireframe   = r->wireframe;
+    s->debug_flags = r->debug_flags;
+    s->dt          = g_render_dt;
+    s->light_count = r->light_count;
+    memcpy(s->lights, r->lights, r->light_count * sizeof(Qs_LightGPU));
+    return true;
+}
+
+void qs_renderer_publish(Qs_Renderer *r)
+{
+    if (!r) return;
+    RenderSnapshot *s = &r->snapshots[qs_render_handoff_write_index(r->handoff)];
+    if (!snapshot_sync(r, s)) {
+        QS_LOG_ERROR("Renderer '%s': cannot grow render snapshot to %u proxies",
+                     r->name, r->renderable_count);
+        return;
+    }
+    s->serial          = ++r->publish_serial;
+    s->width           = r->fb_width;
+    s->height          = r->fb_height;
+    s->prepared_width  = 0;
+    s->prepared_height = 0;
+    qs_render_handoff_publish(r->handoff);
+}
+
+/* Render side: takes the newest published (and, with a render thread,
+   prepared) snapshot, or keeps the current one when nothing new is ready. */
+static RenderSnapshot *snapshot_acquire(Qs_Renderer *r)
+{
+    return &r->snapshots[qs_render_handoff_acquire(r->handoff)];
+}
+
+/* Indices changed since the last snapshot rendered; empty when the same
+   snapshot is drawn again. */
+static uint32_t snapshot_dirty(Qs_Renderer *r, RenderSnapshot *s)
+{
+    uint32_t count = 0;
+    if (s->serial != r->consumed_serial) {
+        for (uint32_t i = 0; i < s->renderable_count; i++)
+            if (s->change_serial[i] > r->consumed_serial) s->dirty[count++] = i;
+        r->consumed_serial = s->serial;
+    }
+    return count;
+}
+
+/* ================================================================
+   FRAMES IN FLIGHT
+   ================================================================ */
+
+static bool frame_slots_create(Qs_Renderer *r)
+{
+    r->arena_align = qs_gpu_buffer_offset_alignment(r->gpu);
+    for (uint32_t i = 0; i < QS_RENDER_FRAMES_IN_FLIGHT; i++) {
+        FrameSlot *slot = &r->frames[i];
+        slot->fence         = qs_gpu_create_fence(r->gpu);
+        slot->frame_ubo     = qs_gpu_create_buffer(r->gpu, &(Qs_GpuBufferDesc){
+            .size=sizeof(Qs_FrameUBO), .usage=QS_GPU_BUFFER_UNIFORM,
+            .memory=QS_GPU_MEMORY_HOST_VISIBLE });
+        slot->lights_buffer = qs_gpu_create_buffer(r->gpu, &(Qs_GpuBufferDesc){
+            .size=sizeof(Qs_LightsBuffer), .usage=QS_GPU_BUFFER_STORAGE,
+            .memory=QS_GPU_MEMORY_HOST_VISIBLE });
+        if (!slot->fence || !slot->frame_ubo || !slot->lights_buffer) return false;
+    }
+    return true;
+}
+
+static void frame_slots_destroy(Qs_Renderer *r)
+{
+    for (uint32_t i = 0; i < QS_RENDER_FRAMES_IN_FLIGHT; i++) {
+        FrameSlot *slot = &r->frames[i];
+        qs_gpu_destroy_fence(r->gpu, slot->fence);
+        qs_gpu_destroy_buffer(r->gpu, slot->frame_ubo);
+        qs_gpu_destroy_buffer(r->gpu, slot->lights_buffer);
+        qs_gpu_destroy_buffer(r->gpu, slot->arena);
+        for (uint32_t k = 0; k < slot->retired_count; k++)
+            qs_gpu_destroy_buffer(r->gpu, slot->retired[k]);
+        for (uint32_t k = 0; k < slot->record_pool_count; k++)
+            qs_gpu_destroy_cmd_pool(r->gpu, slot->record_pools[k]);
+        memset(slot, 0, sizeof(*slot));
+    }
+}
+
+/* Called once the slot's fence has passed.  Retired arenas are freed
+   (qs_gpu_destroy_buffer idles the device, so outgrowing the arena
+   costs one stall before its size settles). */
+static void frame_slot_reset(Qs_Renderer *r, FrameSlot *slot)
+{
+    for (uint32_t i = 0; i < slot->record_pool_count; i++)
+        qs_gpu_reset_cmd_pool(r->gpu, slot->record_pools[i]);
+    for (uint32_t i = 0; i < slot->retired_count; i++)
+        qs_gpu_destroy_buffer(r->gpu, slot->retired[i]);
+    slot->retired_count = 0;
+    slot->arena_head    = 0;
+}
+
+bool qs_renderer_frame_alloc(const Qs_RenderContext *ctx, uint64_t size,
+                             Qs_FrameAlloc *out)
+{
+    Qs_Renderer *r    = ctx->renderer;
+    FrameSlot   *slot = &r->frames[ctx->frame_slot];
+    uint64_t     offset = (slot->arena_head + r->arena_align - 1) / r->arena_align * r->arena_align;
+
+    if (!slot->arena || offset + size > slot->arena_size) {
+        if (slot->arena && slot->retired_count == QS_FRAME_ARENA_RETIRED_MAX) return false;
+        uint64_t cap = slot->arena_size ? slot->arena_size * 2 : QS_FRAME_ARENA_INITIAL_SIZE;
+        while (cap < size) cap *= 2;
+        Qs_GpuBuffer *arena = qs_gpu_create_buffer(r->gpu, &(Qs_GpuBufferDesc){
+            .size   = cap,
+            .usage  = QS_GPU_BUFFER_VERTEX | QS_GPU_BUFFER_INDEX | QS_GPU_BUFFER_UNIFORM |
+                      QS_GPU_BUFFER_STORAGE | QS_GPU_BUFFER_TRANSFER | QS_GPU_BUFFER_INDIRECT,
+            .memory = QS_GPU_MEMORY_HOST_VISIBLE });
+        if (!arena) return false;
+        if (slot->arena) slot->retired[slot->retired_count++] = slot->arena;
+        slot->arena      = arena;
+        slot->arena_size = cap;
+        offset           = 0;
+    }
+
+    slot->arena_head = offset + size;
+    out->buffer = slot->arena;
+    out->offset = offset;
+    out->data   = (uint8_t *)qs_gpu_buffer_data(slot->arena) + offset;
+    return true;
 }
 
 /* ================================================================
    VIEWPORT CALLBACKS  (engine-registered, not plugin-registered)
    ================================================================ */
 
+/* Rasterizes the visible occluders front to back into the software
+   occlusion buffer, then drops the visible proxies they hide.  Returns
+   the new visible count; on failure nothing is dropped. */
+static uint32_t occlusion_cull(Qs_Renderer *r, RenderSnapshot *snap, const float view_proj[16],
+                               uint32_t w, uint32_t h, uint32_t visible_count)
+{
+    Qs_DrawList *list = &r->occluders;
+    list->count = 0;
+    const float *m = view_proj;
+    for (uint32_t k = 0; k < visible_count; k++) {
+        uint32_t i = snap->visible[k];
+        if (!snap->renderables[i].occluder) continue;
+        if (list->count == list->capacity && !qs_draw_list_reserve(list, visible_count))
+            return visible_count;
+        float c[3] = { snap->bounds.center[0][i], snap->bounds.center[1][i],
+                       snap->bounds.center[2][i] };
+        float cz = m[2]*c[0] + m[6]*c[1] + m[10]*c[2] + m[14];
+        float cw = m[3]*c[0] + m[7]*c[1] + m[11]*c[2] + m[15];
+        float depth = cw > 0.0f ? cz / cw * 0.5f + 0.5f : 0.0f;
+        qs_draw_list_push(list, qs_draw_key_depth(depth), i);
+    }
+    if (list->count == 0) return visible_count;
+
+    uint32_t bw = QS_OCCLUSION_BUFFER_WIDTH;
+    uint32_t bh = (uint32_t)((float)bw * (float)h / (float)w / QS_OCCLUSION_TILE_HEIGHT + 0.5f)
+                * QS_OCCLUSION_TILE_HEIGHT;
+    if (bh < QS_OCCLUSION_TILE_HEIGHT) bh = QS_OCCLUSION_TILE_HEIGHT;
+    if (r->occlusion) {
+        uint32_t cur_w, cur_h;
+        qs_occlusion_size(r->occlusion, &cur_w, &cur_h);
+        if (cur_w != bw || cur_h != bh) {
+            qs_occlusion_destroy(r->occlusion);
+            r->occlusion = NULL;
+        }
+    }
+    if (!r->occlusion && !(r->occlusion = qs_occlusion_create(bw, bh))) {
+        QS_LOG_WARN("Renderer '%s': cannot create a %ux%u occlusion buffer", r->name, bw, bh);
+        return visible_count;
+    }
+
+    qs_draw_list_sort(list);
+    qs_occlusion_clear(r->occlusion);
+    for (uint32_t k = 0; k < list->count; k++) {
+        uint32_t i = list->items[k];
+        float clip_from_model[16];
+        qs_m4_mul(view_proj, snap->transforms[i], clip_from_model);
+        if (!qs_occlusion_add(r->occlusion, snap->renderables[i].occluder, clip_from_model))
+            break;
+    }
+    qs_occlusion_rasterize(r->occlusion, qs_engine_job_system(g_engine_ref));
+    return qs_occlusion_cull(r->occlusion, view_proj, &snap->bounds,
+                             snap->visible, visible_count, snap->visible);
+}
+
+/* Computes the matrices and visible list of snap for a w x h viewport.
+   The occlusion buffer belongs to whichever side prepares snapshots, so
+   only that side may pass occlude. */
+static void snapshot_prepare(Qs_Renderer *r, RenderSnapshot *snap,
+                             uint32_t w, uint32_t h, bool occlude)
+{
+    compute_matrices(&snap->camera, w, h, snap->view, snap->proj);
+    qs_m4_mul(snap->proj, snap->view, snap->view_proj);
+    Qs_Frustum frustum;
+    qs_frustum_from_matrix(&frustum, snap->view_proj);
+
+    snap->in_frustum    = qs_cull_frustum(&frustum, &snap->bounds, snap->visible);
+    snap->visible_count = occlude
+        ? occlusion_cull(r, snap, snap->view_proj, w, h, snap->in_frustum)
+        : snap->in_frustum;
+    snap->prepared_width  = w;
+    snap->prepared_height = h;
+}
+
+/* Render thread: culls each published snapshot while the simulation
+   moves on to the next frame. */
+static void render_thread_prepare(uint32_t index, void *user_data)
+{
+    Qs_Renderer    *r    = user_data;
+    RenderSnapshot *snap = &r->snapshots[index];
+    if (snap->width > 0 && snap->height > 0)
+        snapshot_prepare(r, snap, snap->width, snap->height, true);
+}
+
 static void renderer_on_render(const Qs_GpuFrame *frame,
                                 Qs_Viewport *vp, void *user_data)
 {
@@ -324,56 +897,105 @@ static void renderer_on_render(const Qs_GpuFrame *frame,
     uint32_t w = frame->width, h = frame->height;
     if (w == 0 || h == 0) return;
 
-    /* Compute view / projection matrices */
-    float view[16], proj[16];
-    compute_matrices(&r->camera, w, h, view, proj);
+    RenderSnapshot *snap = snapshot_acquire(r);
+    if (snap->serial == 0) return;
+
+    /* Without a render thread snapshots are culled here.  With one they
+       arrive culled for the size at publish; after a resize they are
+       re-culled here, without occlusion, for the current size. */
+    if (snap->prepared_width != w || snap->prepared_height != h)
+        snapshot_prepare(r, snap, w, h, !qs_render_handoff_threaded(r->handoff));
+
+    /* The GPU may still read this slot's buffers.  Rather than rewrite
+       them under it, a slot that does not free up in time skips the frame
+       and is waited on again next time. */
+    FrameSlot *slot   = &r->frames[r->frame_index];
+    FrameSlot *newest = &r->frames[(r->frame_index + QS_RENDER_FRAMES_IN_FLIGHT - 1)
+                                   % QS_RENDER_FRAMES_IN_FLIGHT];
+    if (!qs_gpu_wait_fence(r->gpu, slot->fence, newest->fence,
+                           QS_FRAME_FENCE_TIMEOUT_NS)) {
+        QS_LOG_WARN("Renderer '%s': frame slot %u still busy, skipping frame",
+                    r->name, r->frame_index);
+        return;
+    }
+    frame_slot_reset(r, slot);
+
+    uint32_t visible_count = snap->visible_count;
+    uint32_t dirty_count   = snapshot_dirty(r, snap);
+    r->stats.renderables = snap->renderable_count;
+    r->stats.visible     = visible_count;
+    r->stats.culled      = snap->renderable_count - snap->in_frustum;
+    r->stats.occluded    = snap->in_frustum - visible_count;
+    r->stats.draws         = 0;
+    r->stats.binds         = 0;
+    r->stats.binds_skipped = 0;
 
     /* Write FrameUBO */
-    Qs_FrameUBO *fubo = qs_gpu_map_buffer(r->gpu, r->frame_ubo);
+    Qs_FrameUBO *fubo = qs_gpu_buffer_data(slot->frame_ubo);
     if (fubo) {
-        memcpy(fubo->view, view, 64);
-        memcpy(fubo->proj, proj, 64);
+        memcpy(fubo->view, snap->view, 64);
+        memcpy(fubo->proj, snap->proj, 64);
         qs_m4_identity(fubo->inv_view_proj);
-        fubo->cam_pos[0]    = r->camera.position[0];
-        fubo->cam_pos[1]    = r->camera.position[1];
-        fubo->cam_pos[2]    = r->camera.position[2];
-        fubo->time          = g_render_dt;
+        fubo->cam_pos[0]    = snap->camera.position[0];
+        fubo->cam_pos[1]    = snap->camera.position[1];
+        fubo->cam_pos[2]    = snap->camera.position[2];
+        fubo->time          = snap->dt;
         fubo->screen_width  = (float)w;
         fubo->screen_height = (float)h;
-        fubo->debug_flags   = r->debug_flags;
-        qs_gpu_unmap_buffer(r->gpu, r->frame_ubo);
+        fubo->debug_flags   = snap->debug_flags;
     }
 
-    /* Write LightsUBO */
-    Qs_LightsUBO *lubo = qs_gpu_map_buffer(r->gpu, r->lights_ubo);
-    if (lubo) {
-        lubo->count = r->light_count < QS_LIGHTS_MAX ? r->light_count:QS_LIGHTS_MAX;
-        memcpy(lubo->lights, r->lights, lubo->count * sizeof(Qs_LightGPU));
-        qs_gpu_unmap_buffer(r->gpu, r->lights_ubo);
+    /* Write the lights buffer */
+    Qs_LightsBuffer *lbuf = qs_gpu_buffer_data(slot->lights_buffer);
+    if (lbuf) {
+        lbuf->count = snap->light_count;
+        memcpy(lbuf->lights, snap->lights, lbuf->count * sizeof(Qs_LightGPU));
     }
 
     /* Invoke render nodes */
     Qs_RenderContext ctx = {
         .renderer         = r,
         .cmd              = frame->cmd,
+        .frame_slot       = r->frame_index,
         .width            = w,
         .height           = h,
-        .dt               = g_render_dt,
-        .renderables      = r->renderables,
-        .renderable_count = r->renderable_count,
-        .lights           = r->lights,
-        .light_count      = r->light_count,
+        .dt               = snap->dt,
+        .camera           = &snap->camera,
+        .wireframe        = snap->wireframe,
+        .renderables      = snap->renderables,
+        .transforms       = (const float (*)[16])snap->transforms,
+        .renderable_count = snap->renderable_count,
+        .visible          = snap->visible,
+        .visible_count    = visible_count,
+        .bounds           = &snap->bounds,
+        .dirty            = snap->dirty,
+        .dirty_count      = dirty_count,
+        .lights           = snap->lights,
+        .light_count      = snap->light_count,
         .swapchain_view   = frame->color_target,
         .swapchain_width  = w,
         .swapchain_height = h,
     };
-    memcpy(ctx.view, view, 64);
-    memcpy(ctx.proj, proj, 64);
+    memcpy(ctx.view, snap->view, 64);
+    memcpy(ctx.proj, snap->proj, 64);
 
-    for (uint32_t i = 0; i < r->node_count; i++) {
-        if (r->nodes[i].active && r->nodes[i].execute)
-            r->nodes[i].execute(&ctx, r->nodes[i].user_data);
+    if (r->graph_dirty) {
+        graph_build(r);
+        if (r->backend && r->backend->renderer_on_resize && r->impl)
+            r->backend->renderer_on_resize(r->ctx, r->impl, r->fb_width, r->fb_height);
     }
+
+    const Qs_RgPlan *g = &r->graph;
+    for (uint32_t k = 0; k < g->order_count; k++) {
+        graph_barriers(r, ctx.cmd, g->barrier_start[k], g->barrier_start[k + 1]);
+        Qs_RenderNode *node = &r->nodes[g->order[k]];
+        if (node->active && node->execute)
+            node->execute(&ctx, node->user_data);
+    }
+    graph_barriers(r, ctx.cmd, g->barrier_start[g->order_count], g->barrier_count);
+
+    qs_cmd_signal_fence(frame->cmd, slot->fence);
+    r->frame_index = (r->frame_index + 1) % QS_RENDER_FRAMES_IN_FLIGHT;
 }
 
 static void renderer_on_resize(Qs_Viewport *vp, uint32_t w, uint32_t h,
@@ -389,17 +1011,16 @@ static void renderer_on_resize(Qs_Viewport *vp, uint32_t w, uint32_t h,
     if (r->depth_enabled)
         recreate_depth(r, w, h);
 
-    /* Recreate viewport-scaled attachments (fixed-size are skipped) */
+    /* Recreate viewport-scaled persistent attachments; the graph rebuild
+       re-places every transient at the new sizes */
     for (uint32_t i = 0; i < r->attachment_count; i++) {
         Qs_RenderAttachment *att = &r->attachments[i];
-        if (!att->in_use || att->fixed_width > 0) continue;
-        uint32_t aw = (uint32_t)(w * att->width_scale  + 0.5f);
-        uint32_t ah = (uint32_t)(h * att->height_scale + 0.5f);
-        if (aw < 1) aw = 1;
-        if (ah < 1) ah = 1;
+        if (!att->in_use || att->transient ||
+            (att->fixed_width > 0 && att->fixed_height > 0)) continue;
         destroy_attachment_resource(r, att);
-        create_attachment_resource(r, att, aw, ah);
+        create_attachment_resource(r, att, NULL, 0);
     }
+    graph_build(r);
 
     /* Notify backend so it can re-write descriptor sets */
     if (r->backend && r->backend->renderer_on_resize && r->impl)
@@ -487,6 +1108,10 @@ Qs_Renderer *qs_renderer_create(Qs_Engine *engine, const Qs_RendererDesc *desc)
 
     Qs_Renderer *r = calloc(1, sizeof(Qs_Renderer));
     if (!r) return NULL;
+    r->slot_free = UINT32_MAX;
+    r->handoff   = qs_render_handoff_create(
+        desc && desc->render_thread ? render_thread_prepare : NULL, r);
+    if (!r->handoff) { free(r); return NULL; }
 
     r->backend       = entry->backend;
     r->ctx           = entry->ctx;
@@ -500,18 +1125,12 @@ Qs_Renderer *qs_renderer_create(Qs_Engine *engine, const Qs_RendererDesc *desc)
     }
     camera_defaults(&r->camera);
 
-    /* Create engine-owned per-frame UBOs before calling renderer_create so the
-       backend can query them via qs_renderer_get_frame_ubo / get_lights_ubo. */
-    r->frame_ubo = qs_gpu_create_buffer(r->gpu, &(Qs_GpuBufferDesc){
-        .size=sizeof(Qs_FrameUBO), .usage=QS_GPU_BUFFER_UNIFORM,
-        .memory=QS_GPU_MEMORY_HOST_VISIBLE });
-    r->lights_ubo = qs_gpu_create_buffer(r->gpu, &(Qs_GpuBufferDesc){
-        .size=sizeof(Qs_LightsUBO), .usage=QS_GPU_BUFFER_UNIFORM,
-        .memory=QS_GPU_MEMORY_HOST_VISIBLE });
-    if (!r->frame_ubo || !r->lights_ubo) {
-        QS_LOG_ERROR("qs_renderer_create: UBO allocation failed");
-        if (r->frame_ubo)  qs_gpu_destroy_buffer(r->gpu, r->frame_ubo);
-        if (r->lights_ubo) qs_gpu_destroy_buffer(r->gpu, r->lights_ubo);
+    /* Create engine-owned per-frame data before calling renderer_create so the
+       backend can query them via qs_renderer_get_frame_ubo / get_lights_buffer. */
+    if (!frame_slots_create(r)) {
+        QS_LOG_ERROR("qs_renderer_create: per-frame resource allocation failed");
+        frame_slots_destroy(r);
+        qs_render_handoff_destroy(r->handoff);
         free(r);
         return NULL;
     }
@@ -523,8 +1142,8 @@ Qs_Renderer *qs_renderer_create(Qs_Engine *engine, const Qs_RendererDesc *desc)
         /* Destroy any attachments the backend may have declared before failing */
         for (uint32_t i = 0; i < r->attachment_count; i++)
             destroy_attachment_resource(r, &r->attachments[i]);
-        qs_gpu_destroy_buffer(r->gpu, r->frame_ubo);
-        qs_gpu_destroy_buffer(r->gpu, r->lights_ubo);
+        frame_slots_destroy(r);
+        qs_render_handoff_destroy(r->handoff);
         free(r);
         return NULL;
     }
@@ -552,10 +1171,14 @@ Qs_Renderer *qs_renderer_create(Qs_Engine *engine, const Qs_RendererDesc *desc)
 void qs_renderer_destroy(Qs_Renderer *renderer)
 {
     if (!renderer) return;
+    /* Scenes drop their handles into this renderer's proxy pool */
+    qs_scene_release_renderer(renderer);
     /* Unbind from viewport so stale callbacks are never invoked */
     if (renderer->bound_viewport)
         qs_viewport_set_callbacks(renderer->bound_viewport,
                                   NULL, NULL, NULL, NULL);
+    /* Stop the render thread before anything it reads goes away */
+    qs_render_handoff_destroy(renderer->handoff);
     /* Backend cleanup first (frees descriptor sets that reference engine UBOs) */
     if (renderer->backend && renderer->backend->renderer_destroy)
         renderer->backend->renderer_destroy(renderer->ctx, renderer->impl);
@@ -567,8 +1190,15 @@ void qs_renderer_destroy(Qs_Renderer *renderer)
     destroy_depth(renderer);
     for (uint32_t i = 0; i < renderer->attachment_count; i++)
         destroy_attachment_resource(renderer, &renderer->attachments[i]);
-    if (renderer->frame_ubo)  qs_gpu_destroy_buffer(renderer->gpu, renderer->frame_ubo);
-    if (renderer->lights_ubo) qs_gpu_destroy_buffer(renderer->gpu, renderer->lights_ubo);
+    qs_gpu_destroy_memory(renderer->gpu, renderer->transient_heap);
+    frame_slots_destroy(renderer);
+    if (renderer->record_counter)
+        qs_job_counter_destroy(qs_engine_job_system(g_engine_ref), renderer->record_counter);
+    proxy_pool_free(renderer);
+    qs_occlusion_destroy(renderer->occlusion);
+    qs_draw_list_free(&renderer->occluders);
+    for (uint32_t i = 0; i < QS_RENDER_HANDOFF_SNAPSHOTS; i++)
+        snapshot_free(&renderer->snapshots[i]);
     free(renderer);
 }
 
@@ -638,14 +1268,24 @@ Qs_RenderNode *qs_renderer_add_node(Qs_Renderer *r, const Qs_RenderNodeDesc *des
         QS_LOG_WARN("qs_renderer_add_node: node limit reached on '%s'", r->name);
         return NULL;
     }
+    if (desc->access_count > QS_RENDER_NODE_ACCESSES_MAX) {
+        QS_LOG_WARN("qs_renderer_add_node: '%s' declares too many accesses",
+                    desc->name ? desc->name : "");
+        return NULL;
+    }
     Qs_RenderNode *node = &r->nodes[r->node_count++];
     memset(node, 0, sizeof(*node));
-    node->active    = true;
-    node->priority  = desc->priority;
-    node->execute   = desc->execute;
-    node->user_data = desc->user_data;
+    node->active       = true;
+    node->priority     = desc->priority;
+    node->execute      = desc->execute;
+    node->user_data    = desc->user_data;
+    node->access_count = desc->access_count;
+    node->side_effects = desc->side_effects;
+    if (desc->access_count > 0)
+        memcpy(node->accesses, desc->accesses, desc->access_count * sizeof(Qs_RenderAccess));
     if (desc->name) snprintf(node->name, sizeof(node->name), "%s", desc->name);
     qsort(r->nodes, r->node_count, sizeof(Qs_RenderNode), node_compare);
+    r->graph_dirty = true;
     return node;
 }
 
@@ -657,6 +1297,7 @@ void qs_renderer_remove_node(Qs_Renderer *r, Qs_RenderNode *node)
             memmove(&r->nodes[i], &r->nodes[i+1],
                     (r->node_count-i-1)*sizeof(Qs_RenderNode));
             r->node_count--;
+            r->graph_dirty = true;
             return;
         }
     }
@@ -683,18 +1324,13 @@ Qs_RenderAttachment *qs_renderer_add_attachment(Qs_Renderer *r,
     att->height_scale = desc->height_scale;
     att->fixed_width  = desc->fixed_width;
     att->fixed_height = desc->fixed_height;
+    att->transient    = desc->transient;
+    att->copy_dst     = desc->copy_dst;
     if (desc->name) snprintf(att->name, sizeof(att->name), "%s", desc->name);
+    r->graph_dirty = true;
 
-    uint32_t w, h;
-    if (desc->fixed_width > 0 && desc->fixed_height > 0) {
-        /* Fixed-size: create immediately */
-        w = desc->fixed_width;
-        h = desc->fixed_height;
-    } else {
-        /* Viewport-scaled: create 1x1 placeholder; will be resized on first bind */
-        w = 1; h = 1;
-    }
-    if (!create_attachment_resource(r, att, w, h)) {
+    /* Transients are created by the graph, which decides their memory */
+    if (!att->transient && !create_attachment_resource(r, att, NULL, 0)) {
         QS_LOG_ERROR("qs_renderer_add_attachment: failed to create '%s'",
                      att->name);
         att->in_use = false;
@@ -719,75 +1355,286 @@ Qs_GpuImageView *qs_renderer_depth_view(const Qs_Renderer *r)
     return (r && r->depth_enabled) ? r->depth_view : NULL;
 }
 
-Qs_GpuBuffer *qs_renderer_get_frame_ubo(const Qs_Renderer *r)
+Qs_GpuImage *qs_renderer_depth_image(const Qs_Renderer *r)
+{
+    return (r && r->depth_enabled) ? r->depth : NULL;
+}
+
+Qs_GpuBuffer *qs_renderer_get_frame_ubo(const Qs_Renderer *r, uint32_t slot)
 {
-    return r ? r->frame_ubo : NULL;
+    return (r && slot < QS_RENDER_FRAMES_IN_FLIGHT) ? r->frames[slot].frame_ubo : NULL;
 }
 
-Qs_GpuBuffer *qs_renderer_get_lights_ubo(const Qs_Renderer *r)
+Qs_GpuBuffer *qs_renderer_get_lights_buffer(const Qs_Renderer *r, uint32_t slot)
 {
-    return r ? r->lights_ubo : NULL;
+    return (r && slot < QS_RENDER_FRAMES_IN_FLIGHT) ? r->frames[slot].lights_buffer : NULL;
 }
 
 /* ================================================================
-   RENDERABLE / LIGHT SUBMISSION
+   RENDER PROXIES
    ================================================================ */
 
-void qs_renderer_submit_renderable(Qs_Renderer *r, const Qs_RenderableDesc *desc)
-{
-    if (!r || !desc || !desc->mesh) return;
-    if (r->renderable_count >= QS_MAX_RENDERABLES) {
-        static bool s_overflow_warned;
-        if (!s_overflow_warned) {
-            QS_LOG_WARN("qs_renderer_submit_renderable: buffer full (%u) "
-                        "\xe2\x80\x94 extra renderables dropped. "
-                        "Increase QS_MAX_RENDERABLES in qs_renderer.c.",
-                        QS_MAX_RENDERABLES);
-            s_overflow_warned = true;
-        }
-        return;
-    }
+static uint32_t proxy_index(const Qs_Renderer *r, Qs_RenderProxy proxy)
+{
+    uint32_t slot = proxy & QS_RENDER_PROXY_SLOT_MASK;
+    if (!r || proxy == QS_RENDER_PROXY_INVALID || slot >= r->slot_count ||
+        r->slot_gen[slot] != (uint8_t)(proxy >> QS_RENDER_PROXY_GEN_SHIFT))
+        return UINT32_MAX;
+    return r->slot_index[slot];
+}
 
-    /* Resolve material: use desc->material if provided, else renderer default */
-    Qs_Material *mat = desc->material ? desc->material : r->default_material;
+static void proxy_mark_dirty(Qs_Renderer *r, uint32_t i)
+{
+    r->change_serial[i] = r->publish_serial + 1;
+}
 
-    Qs_Renderable *ren = &r->renderables[r->renderable_count++];
+static void proxy_extract(const Qs_Renderer *r, Qs_Renderable *ren,
+                          Qs_Mesh *mesh, Qs_Material *material)
+{
+    /* Resolve material: use the given one if provided, else renderer default */
+    Qs_Material *mat = material ? material : r->default_material;
 
     /* Extract mesh GPU data */
-    ren->vertex_buffer = qs_mesh_vertex_buffer(desc->mesh);
-    ren->index_buffer  = qs_mesh_index_buffer(desc->mesh);
-    ren->vertex_count  = qs_mesh_vertex_count(desc->mesh);
-    ren->index_count   = qs_mesh_index_count(desc->mesh);
-    ren->index_16bit   = (qs_mesh_index_type(desc->mesh) == QS_INDEX_TYPE_UINT16);
+    ren->position_buffer  = qs_mesh_position_buffer(mesh);
+    ren->attribute_buffer = qs_mesh_attribute_buffer(mesh);
+    ren->index_buffer     = qs_mesh_index_buffer(mesh);
+    ren->vertex_count     = qs_mesh_vertex_count(mesh);
+    ren->index_count      = qs_mesh_index_count(mesh);
+    ren->index_16bit      = (qs_mesh_index_type(mesh) == QS_INDEX_TYPE_UINT16);
+    ren->mesh_id          = qs_mesh_id(mesh);
 
     /* Extract material GPU data */
     ren->material_set  = mat ? qs_material_descriptor_set(mat) : NULL;
     ren->alpha_mode    = mat ? qs_material_alpha_mode(mat)      : QS_ALPHA_MODE_OPAQUE;
     ren->double_sided  = mat ? qs_material_double_sided(mat)    : false;
+    ren->material_id   = mat ? qs_material_id(mat)              : 0;
     if (mat) {
         const Qs_PBRParams *p = qs_material_params(mat);
         if (p) ren->material_params = *p;
     }
+}
+
+Qs_RenderProxy qs_renderer_proxy_create(Qs_Renderer *r, const Qs_RenderableDesc *desc)
+{
+    if (!r || !desc || !desc->mesh) return QS_RENDER_PROXY_INVALID;
+    if (r->renderable_count == r->renderable_capacity && !proxy_pool_grow(r)) {
+        QS_LOG_ERROR("qs_renderer_proxy_create: cannot grow proxy pool past %u",
+                     r->renderable_capacity);
+        return QS_RENDER_PROXY_INVALID;
+    }
 
-    /* Transform and culling */
-    memcpy(ren->transform, desc->transform, 64);
-    ren->bounds          = desc->bounds;
+    uint32_t slot;
+    if (r->slot_free != UINT32_MAX) {
+        slot = r->slot_free;
+        r->slot_free = r->slot_index[slot];
+    } else {
+        slot = r->slot_count++;
+    }
+
+    uint32_t i = r->renderable_count++;
+    r->slot_index[slot] = i;
+    r->proxy_slot[i]    = slot;
+
+    Qs_Renderable *ren = &r->renderables[i];
+    memset(ren, 0, sizeof(*ren));
+    proxy_extract(r, ren, desc->mesh, desc->material);
+    memcpy(ren->tint, desc->tint, sizeof(ren->tint));
     ren->entity          = desc->entity;
     ren->cast_shadows    = desc->cast_shadows;
     ren->receive_shadows = desc->receive_shadows;
+    ren->occluder        = desc->occluder;
+
+    memcpy(r->transforms[i], desc->transform, 64);
+    qs_cull_bounds_set(&r->cull_bounds, i, &desc->bounds);
+    proxy_mark_dirty(r, i);
+
+    return slot | ((uint32_t)r->slot_gen[slot] << QS_RENDER_PROXY_GEN_SHIFT);
+}
+
+void qs_renderer_proxy_destroy(Qs_Renderer *r, Qs_RenderProxy proxy)
+{
+    uint32_t i = proxy_index(r, proxy);
+    if (i == UINT32_MAX) return;
+
+    /* Swap-remove: move the last proxy into the vacated dense index */
+    uint32_t last = --r->renderable_count;
+    if (i != last) {
+        memcpy(r->transforms[i], r->transforms[last], 64);
+        r->renderables[i] = r->renderables[last];
+        r->proxy_slot[i]  = r->proxy_slot[last];
+        r->slot_index[r->proxy_slot[i]] = i;
+        proxy_mark_dirty(r, i);
+    }
+    qs_cull_bounds_remove(&r->cull_bounds, i);
+
+    uint32_t slot = proxy & QS_RENDER_PROXY_SLOT_MASK;
+    r->slot_gen[slot]++;
+    r->slot_index[slot] = r->slot_free;
+    r->slot_free        = slot;
+}
+
+bool qs_renderer_proxy_valid(const Qs_Renderer *r, Qs_RenderProxy proxy)
+{
+    return proxy_index(r, proxy) != UINT32_MAX;
+}
+
+void qs_renderer_proxy_set_transform(Qs_Renderer *r, Qs_RenderProxy proxy,
+                                     const float transform[16], const Qs_AABB *bounds)
+{
+    uint32_t i = proxy_index(r, proxy);
+    if (i == UINT32_MAX || !transform || !bounds) return;
+    memcpy(r->transforms[i], transform, 64);
+    qs_cull_bounds_set(&r->cull_bounds, i, bounds);
+    proxy_mark_dirty(r, i);
+}
+
+void qs_renderer_proxy_set_tint(Qs_Renderer *r, Qs_RenderProxy proxy, const float tint[4])
+{
+    uint32_t i = proxy_index(r, proxy);
+    if (i == UINT32_MAX || !tint) return;
+    memcpy(r->renderables[i].tint, tint, sizeof(r->renderables[i].tint));
+    proxy_mark_dirty(r, i);
+}
+
+void qs_renderer_proxy_set_occluder(Qs_Renderer *r, Qs_RenderProxy proxy,
+                                    const Qs_OccluderMesh *occluder)
+{
+    uint32_t i = proxy_index(r, proxy);
+    if (i == UINT32_MAX) return;
+    r->renderables[i].occluder = occluder;
+    proxy_mark_dirty(r, i);
+}
+
+void qs_renderer_proxy_set_geometry(Qs_Renderer *r, Qs_RenderProxy proxy,
+                                    Qs_Mesh *mesh, Qs_Material *material)
+{
+    uint32_t i = proxy_index(r, proxy);
+    if (i == UINT32_MAX || !mesh) return;
+    proxy_extract(r, &r->renderables[i], mesh, material);
+    proxy_mark_dirty(r, i);
 }
 
-void qs_renderer_clear_renderables(Qs_Renderer *r)
+const Qs_Renderable *qs_renderer_renderables(const Qs_Renderer *r,
+                                             const float (**out_transforms)[16],
+                                             uint32_t *out_count)
 {
-    if (r) r->renderable_count = 0;
+    bool any = r && r->renderable_count > 0;
+    if (out_transforms) *out_transforms = any ? (const float (*)[16])r->transforms : NULL;
+    if (out_count)      *out_count      = r ? r->renderable_count : 0;
+    return any ? r->renderables : NULL;
 }
 
-const Qs_Renderable *qs_renderer_renderables(const Qs_Renderer *r, uint32_t *out_count)
+const Qs_RenderStats *qs_renderer_stats(const Qs_Renderer *r)
 {
-    if (out_count) *out_count = r ? r->renderable_count : 0;
-    return (r && r->renderable_count > 0) ? r->renderables : NULL;
+    return r ? &r->stats : NULL;
 }
 
+void qs_renderer_add_draw_stats(Qs_Renderer *r, uint32_t draws,
+                                uint32_t binds, uint32_t binds_skipped)
+{
+    if (!r) return;
+    r->stats.draws         += draws;
+    r->stats.binds         += binds;
+    r->stats.binds_skipped += binds_skipped;
+}
+
+/* ================================================================
+   PARALLEL PASS RECORDING
+   ================================================================ */
+
+typedef struct RecordTask {
+    Qs_GpuCmd                *cmd;
+    const Qs_GpuRenderTarget *target;
+    Qs_RecordRangeFn          fn;
+    void                     *user_data;
+    uint32_t                  range;
+    uint32_t                  begin;
+    uint32_t                  end;
+} RecordTask;
+
+static void record_task_run(void *data)
+{
+    RecordTask *t = data;
+    qs_cmd_set_viewport(t->cmd, t->target->width, t->target->height);
+    t->fn(t->cmd, t->range, t->begin, t->end, t->user_data);
+    qs_gpu_end_secondary(t->cmd);
+}
+
+/* One range per job worker plus the waiting thread, each holding at
+   least QS_RENDER_RECORD_MIN_DRAWS draws.  Pools are created on demand
+   and kept; if one cannot be created the split shrinks to what exists. */
+static uint32_t record_range_count(Qs_Renderer *r, FrameSlot *slot,
+                                   Qs_JobSystem *jobs, uint32_t count)
+{
+    if (!jobs) return 1;
+    uint32_t n = qs_job_system_thread_count(jobs) + 1;
+    if (n > count / QS_RENDER_RECORD_MIN_DRAWS) n = count / QS_RENDER_RECORD_MIN_DRAWS;
+    if (n > QS_RENDER_RECORD_RANGES_MAX)        n = QS_RENDER_RECORD_RANGES_MAX;
+    if (n < 2) return 1;
+
+    while (slot->record_pool_count < n) {
+        Qs_GpuCmdPool *pool = qs_gpu_create_cmd_pool(r->gpu);
+        if (!pool) break;
+        slot->record_pools[slot->record_pool_count++] = pool;
+    }
+    if (n > slot->record_pool_count) n = slot->record_pool_count;
+    if (!r->record_counter) r->record_counter = qs_job_counter_create(jobs);
+    return (n > 1 && r->record_counter) ? n : 1;
+}
+
+uint32_t qs_renderer_record_draws(const Qs_RenderContext *ctx,
+                                  const Qs_GpuRenderTarget *target,
+                                  uint32_t count, Qs_RecordRangeFn fn,
+                                  void *user_data)
+{
+    Qs_Renderer  *r      = ctx->renderer;
+    FrameSlot    *slot   = &r->frames[ctx->frame_slot];
+    Qs_JobSystem *jobs   = qs_engine_job_system(g_engine_ref);
+    uint32_t      ranges = record_range_count(r, slot, jobs, count);
+
+    /* Secondaries are begun here so a failure can still fall back to
+       recording inline; the begun ones are recycled by the next reset. */
+    Qs_GpuCmd *cmds[QS_RENDER_RECORD_RANGES_MAX];
+    for (uint32_t i = 0; i < ranges && ranges > 1; i++) {
+        cmds[i] = qs_gpu_begin_secondary(r->gpu, slot->record_pools[i], target);
+        if (!cmds[i]) ranges = 1;
+    }
+
+    Qs_GpuRenderTarget pass = *target;
+    pass.secondary = ranges > 1;
+    if (ranges == 1) {
+        qs_cmd_begin_rendering(ctx->cmd, &pass);
+        qs_cmd_set_viewport(ctx->cmd, target->width, target->height);
+        fn(ctx->cmd, 0, 0, count, user_data);
+        qs_cmd_end_rendering(ctx->cmd);
+        return 1;
+    }
+
+    RecordTask tasks[QS_RENDER_RECORD_RANGES_MAX];
+    Qs_JobDesc descs[QS_RENDER_RECORD_RANGES_MAX];
+    for (uint32_t i = 0; i < ranges; i++) {
+        tasks[i] = (RecordTask){
+            .cmd = cmds[i], .target = target, .fn = fn, .user_data = user_data,
+            .range = i,
+            .begin = (uint32_t)((uint64_t)count * i / ranges),
+            .end   = (uint32_t)((uint64_t)count * (i + 1) / ranges),
+        };
+        descs[i] = (Qs_JobDesc){ .fn = record_task_run, .data = &tasks[i],
+                                 .name = "record_draws" };
+    }
+    qs_job_dispatch_batch(jobs, descs, ranges, r->record_counter);
+    qs_job_wait(jobs, r->record_counter);
+
+    qs_cmd_begin_rendering(ctx->cmd, &pass);
+    qs_cmd_execute(ctx->cmd, cmds, ranges);
+    qs_cmd_end_rendering(ctx->cmd);
+    return ranges;
+}
+
+/* ================================================================
+   LIGHT SUBMISSION
+   ================================================================ */
+
 void qs_renderer_submit_light(Qs_Renderer *r, Qs_Light *light)
 {
     if (!r || !light) return;
@@ -2,55 +2,134 @@
 
 #include "qs_log.h"
 #include "qs_system.h"
+#include "quasar.h"
+#include "core/qs_trace_internal.h"
 #include <causality.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdarg.h>
 #include <string.h>
 #include <time.h>
+#include <stdatomic.h>
 
 #ifdef _WIN32
 #include <windows.h>
-static double get_time_sec(void) {
-    static LARGE_INTEGER freq = {0};
-    if (!freq.QuadPart) QueryPerformanceFrequency(&freq);
-    LARGE_INTEGER now;
-    QueryPerformanceCounter(&now);
-    return (double)now.QuadPart / (double)freq.QuadPart;
-}
-#else
-#include <sys/time.h>
-static double get_time_sec(void) {
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
-    return (double)tv.tv_sec + (double)tv.tv_usec * 1e-6;
-}
 #endif
 
-#define QS_LOG_INITIAL_CAP  1024
-#define QS_LOG_FLUSH_THRESH 256
+/* ================================================================
+   LOG SYSTEM
+   ================================================================
+   qs_log() never formats or touches I/O on the caller's thread.  Each
+   thread owns an SPSC byte ring that receives the format pointer plus the
+   raw argument bytes; a single writer thread drains all rings, formats
+   the text and feeds the console, the log file and the history.  Threads
+   arriving after QS_LOG_MAX_THREADS rings exist share one more ring whose
+   producers take a lock. */
+
 #define QS_LOG_MSG_MAX      1024
+#define QS_LOG_RING_SIZE    (64u * 1024u)   /* bytes per thread, power of two */
+#define QS_LOG_MAX_THREADS  256
+#define QS_LOG_BATCH_NAP_US 1000    /* writer pause between non-empty batches */
 #define QS_LOG_FILE_NAME    "quasar.log"
+#define QS_LOG_FILE_PREV    "quasar.1.log"
+
+#define QS_LOG_CHUNK_ENTRIES      1024
+#define QS_LOG_CHUNK_TEXT         (96u * 1024u)
+#define QS_LOG_BLOOM_BITS         4096u
+#define QS_LOG_DEFAULT_HISTORY    (256u * 1024u)        /* entries kept in memory */
+#define QS_LOG_DEFAULT_FILE_MAX   (64ull * 1024 * 1024) /* bytes before rotation */
+#define QS_LOG_VIEW_SCAN_BUDGET   65536u                /* entries per view refresh */
+#define QS_LOG_FILTER_MAX         128
+
+typedef enum {
+    QS_LOG_REC_PAD = 0,     /* filler up to the ring end; skip */
+    QS_LOG_REC_DEFERRED,    /* fmt + encoded arguments */
+    QS_LOG_REC_TEXT,        /* preformatted text (unsupported conversions) */
+} Qs_LogRecordKind;
+
+/* Records are 8-byte aligned and never straddle the ring end. */
+typedef struct {
+    uint32_t    size;       /* total bytes including this header */
+    uint8_t     level;
+    uint8_t     kind;
+    uint64_t    time_ns;
+    const char *fmt;
+} Qs_LogRecord;
 
 typedef struct {
-    char *text;
-} Qs_LogStorage;
+    _Atomic uint64_t head;              /* written by the owning thread */
+    _Atomic uint64_t dropped;           /* records lost to a full ring */
+    char             pad0[48];
+    _Atomic uint64_t tail;              /* written by the writer thread */
+    uint64_t         dropped_reported;
+    char             pad1[48];
+    uint8_t          data[QS_LOG_RING_SIZE];
+} Qs_LogRing;
+
+/* History is a ring of fixed-size chunks.  Each chunk carries a per-level
+   count and a trigram bloom filter so filtered scans can skip it whole. */
+typedef struct {
+    double   timestamp;
+    uint32_t offset;        /* into the chunk text arena */
+    uint16_t length;
+    uint8_t  level;
+} Qs_LogSlot;
 
 typedef struct {
-    Qs_LogEntry   *entries;
-    Qs_LogStorage *storage;
-    uint32_t       count;
-    uint32_t       capacity;
-    uint32_t       unflushed;
-    Qs_LogLevel    min_level;
-    double         start_time;
-    FILE          *file;
+    uint64_t   first_seq;
+    uint32_t   count;
+    uint32_t   text_used;
+    uint32_t   level_counts[QS_LOG_LEVEL_COUNT];
+    uint64_t   bloom[QS_LOG_BLOOM_BITS / 64];
+    Qs_LogSlot slots[QS_LOG_CHUNK_ENTRIES];
+    char       text[QS_LOG_CHUNK_TEXT];
+} Qs_LogChunk;
+
+typedef struct {
+    Qs_LogChunk **chunks;       /* ring, oldest at chunk_head */
+    uint32_t      chunk_cap;
+    uint32_t      chunk_head;
+    uint32_t      chunk_count;
+    uint32_t      max_chunks;
+    uint64_t      first_seq;    /* oldest retained entry */
+    uint64_t      end_seq;      /* one past the newest entry */
+} Qs_LogHistory;
+
+typedef struct {
+    Qs_LogHistory    history;
+    _Atomic int      min_level;
+    uint64_t         start_ns;
+    uint32_t         generation;
+    FILE            *file;
+    uint64_t         file_bytes;
+    uint64_t         file_limit;
     Qs_LogListenerFn listener;
     void            *listener_data;
-    Ca_Mutex        *mutex;   /* protects entries/storage/count/unflushed */
+    Ca_Mutex        *mutex;   /* protects history/listener/file_limit */
+
+    /* Per-thread rings; registration is the only locked step. */
+    Qs_LogRing      *rings[QS_LOG_MAX_THREADS];
+    _Atomic uint32_t ring_count;
+    Ca_Mutex        *ring_mutex;
+    Qs_LogRing      *shared_ring;       /* overflow; pushed under shared_mutex */
+    Ca_Mutex        *shared_mutex;
+
+    /* Writer thread */
+    Ca_Thread       *writer;
+    Ca_Mutex        *wake_mutex;
+    Ca_CondVar      *wake_cond;
+    Ca_CondVar      *flush_cond;
+    _Atomic bool     writer_sleeping;
+    bool             writer_running;    /* guarded by wake_mutex */
+    uint64_t         flush_requested;   /* guarded by wake_mutex */
+    uint64_t         flush_completed;   /* guarded by wake_mutex */
 } Qs_LogState;
 
 static Qs_LogState *g_log = NULL;
+static uint32_t     g_log_generation = 0;
+
+static _Thread_local Qs_LogRing *t_log_ring = NULL;
+static _Thread_local uint32_t    t_log_generation = 0;
 
 static const char *g_level_labels[QS_LOG_LEVEL_COUNT] = {
     "DEBUG", "TRACE", "INFO ", "WARN ", "ERROR", "FATAL"
@@ -74,78 +153,662 @@ static void format_timestamp(double elapsed, char *buf, size_t len)
     snprintf(buf, len, "%02d:%02d:%02d.%03d", hours, minutes, seconds, millis);
 }
 
-static void flush_to_file(Qs_LogState *state)
+/* ── Format spec parsing (shared by encoder and decoder) ─────── */
+
+typedef enum {
+    QS_LOG_ARG_NONE = 0,    /* "%%" */
+    QS_LOG_ARG_INT,
+    QS_LOG_ARG_UINT,
+    QS_LOG_ARG_CHAR,
+    QS_LOG_ARG_DOUBLE,
+    QS_LOG_ARG_STR,
+    QS_LOG_ARG_PTR,
+    QS_LOG_ARG_UNSUPPORTED,
+} Qs_LogArgKind;
+
+typedef struct {
+    Qs_LogArgKind kind;
+    const char   *body;         /* flags/width/precision text after '%' */
+    uint32_t      body_len;
+    char          length[3];    /* length modifier, NUL-terminated */
+    char          conv;
+    bool          star_width;
+    bool          star_prec;
+} Qs_LogSpec;
+
+/* Parses the conversion after a '%'. Returns the first char past it. */
+static const char *log_parse_spec(const char *p, Qs_LogSpec *spec)
 {
-    if (!state->file || state->unflushed == 0) return;
+    memset(spec, 0, sizeof(*spec));
+    spec->body = p;
+    while (*p && strchr("-+ #0", *p)) p++;
+    if (*p == '*') { spec->star_width = true; p++; }
+    else while (*p >= '0' && *p <= '9') p++;
+    if (*p == '.') {
+        p++;
+        if (*p == '*') { spec->star_prec = true; p++; }
+        else while (*p >= '0' && *p <= '9') p++;
+    }
+    spec->body_len = (uint32_t)(p - spec->body);
 
-    uint32_t start = state->count - state->unflushed;
-    for (uint32_t i = start; i < state->count; i++) {
-        Qs_LogEntry *e = &state->entries[i];
-        char ts[16];
-        format_timestamp(e->timestamp, ts, sizeof(ts));
-        fprintf(state->file, "[%s] [%s] %s\n",
-                ts, g_level_labels[e->level], e->message);
+    uint32_t n = 0;
+    while (*p && strchr("hlLjzt", *p)) {
+        if (n < 2) spec->length[n++] = *p;
+        p++;
     }
-    fflush(state->file);
-    state->unflushed = 0;
+
+    spec->conv = *p;
+    if (*p) p++;
+
+    bool wide = spec->length[0] == 'l' && spec->length[1] == '\0';
+    switch (spec->conv) {
+    case '%': spec->kind = QS_LOG_ARG_NONE; break;
+    case 'd': case 'i':
+        spec->kind = QS_LOG_ARG_INT; break;
+    case 'u': case 'o': case 'x': case 'X':
+        spec->kind = QS_LOG_ARG_UINT; break;
+    case 'c':
+        spec->kind = wide ? QS_LOG_ARG_UNSUPPORTED : QS_LOG_ARG_CHAR; break;
+    case 'f': case 'F': case 'e': case 'E':
+    case 'g': case 'G': case 'a': case 'A':
+        spec->kind = QS_LOG_ARG_DOUBLE; break;
+    case 's':
+        spec->kind = wide ? QS_LOG_ARG_UNSUPPORTED : QS_LOG_ARG_STR; break;
+    case 'p': spec->kind = QS_LOG_ARG_PTR; break;
+    default:  spec->kind = QS_LOG_ARG_UNSUPPORTED; break;
+    }
+    return p;
 }
 
-static bool log_system_init(Qs_System *system, Qs_Engine *engine)
+static long long log_read_int(const Qs_LogSpec *s, va_list *ap)
 {
-    (void)engine;
-    Qs_LogState *state = (Qs_LogState *)qs_system_data(system);
+    const char *l = s->length;
+    if (l[0] == 'h' && l[1] == 'h') return (signed char)va_arg(*ap, int);
+    if (l[0] == 'h')                return (short)va_arg(*ap, int);
+    if (l[0] == 'l' && l[1] == 'l') return va_arg(*ap, long long);
+    if (l[0] == 'l')                return va_arg(*ap, long);
+    if (l[0] == 'j')                return (long long)va_arg(*ap, intmax_t);
+    if (l[0] == 'z')                return (long long)va_arg(*ap, size_t);
+    if (l[0] == 't')                return (long long)va_arg(*ap, ptrdiff_t);
+    return va_arg(*ap, int);
+}
+
+static unsigned long long log_read_uint(const Qs_LogSpec *s, va_list *ap)
+{
+    const char *l = s->length;
+    if (l[0] == 'h' && l[1] == 'h') return (unsigned char)va_arg(*ap, unsigned int);
+    if (l[0] == 'h')                return (unsigned short)va_arg(*ap, unsigned int);
+    if (l[0] == 'l' && l[1] == 'l') return va_arg(*ap, unsigned long long);
+    if (l[0] == 'l')                return va_arg(*ap, unsigned long);
+    if (l[0] == 'j')                return (unsigned long long)va_arg(*ap, uintmax_t);
+    if (l[0] == 'z')                return (unsigned long long)va_arg(*ap, size_t);
+    if (l[0] == 't')                return (unsigned long long)va_arg(*ap, ptrdiff_t);
+    return va_arg(*ap, unsigned int);
+}
+
+/* ── Argument encoding (caller thread) ──────────────────────── */
 
-    state->capacity   = QS_LOG_INITIAL_CAP;
-    state->entries     = calloc(state->capacity, sizeof(Qs_LogEntry));
-    state->storage     = calloc(state->capacity, sizeof(Qs_LogStorage));
-    if (!state->entries || !state->storage) return false;
+#define LOG_PUT(buf, pos, cap, val) do {                         \
+        if ((pos) + sizeof(val) > (cap)) return false;           \
+        memcpy((buf) + (pos), &(val), sizeof(val));              \
+        (pos) += (uint32_t)sizeof(val);                          \
+    } while (0)
 
-    state->mutex = ca_mutex_create();
-    if (!state->mutex) { free(state->entries); free(state->storage); return false; }
+/* Serializes the arguments consumed by fmt into buf. Returns false if fmt
+   uses a conversion the decoder cannot replay or the args do not fit. */
+static bool log_encode_args(const char *fmt, va_list *ap,
+                            uint8_t *buf, uint32_t cap, uint32_t *out_len)
+{
+    uint32_t pos = 0;
+    for (const char *p = fmt; *p; ) {
+        if (*p++ != '%') continue;
+
+        Qs_LogSpec spec;
+        p = log_parse_spec(p, &spec);
+        if (spec.kind == QS_LOG_ARG_UNSUPPORTED) return false;
+        if (spec.kind == QS_LOG_ARG_NONE) continue;
+
+        if (spec.star_width) { int w  = va_arg(*ap, int); LOG_PUT(buf, pos, cap, w);  }
+        if (spec.star_prec)  { int pr = va_arg(*ap, int); LOG_PUT(buf, pos, cap, pr); }
+
+        switch (spec.kind) {
+        case QS_LOG_ARG_INT:    { long long v = log_read_int(&spec, ap);           LOG_PUT(buf, pos, cap, v); } break;
+        case QS_LOG_ARG_UINT:   { unsigned long long v = log_read_uint(&spec, ap); LOG_PUT(buf, pos, cap, v); } break;
+        case QS_LOG_ARG_CHAR:   { int v = va_arg(*ap, int);                        LOG_PUT(buf, pos, cap, v); } break;
+        case QS_LOG_ARG_PTR:    { void *v = va_arg(*ap, void *);                   LOG_PUT(buf, pos, cap, v); } break;
+        case QS_LOG_ARG_DOUBLE: {
+            double v = (spec.length[0] == 'L') ? (double)va_arg(*ap, long double)
+                                               : va_arg(*ap, double);
+            LOG_PUT(buf, pos, cap, v);
+        } break;
+        case QS_LOG_ARG_STR: {
+            const char *s = va_arg(*ap, const char *);
+            if (!s) s = "(null)";
+            uint32_t len  = (uint32_t)strlen(s);
+            uint32_t room = cap - pos;
+            if (room < sizeof(uint32_t) + 1) return false;
+            if (len > room - sizeof(uint32_t) - 1) len = room - (uint32_t)sizeof(uint32_t) - 1;
+            LOG_PUT(buf, pos, cap, len);
+            memcpy(buf + pos, s, len);
+            buf[pos + len] = '\0';
+            pos += len + 1;
+        } break;
+        default: break;
+        }
+    }
+    *out_len = pos;
+    return true;
+}
+
+#undef LOG_PUT
+
+/* ── Argument decoding (writer thread) ──────────────────────── */
+
+#define LOG_GET(src, pos, val) do {                              \
+        memcpy(&(val), (src) + (pos), sizeof(val));              \
+        (pos) += (uint32_t)sizeof(val);                          \
+    } while (0)
+
+#define LOG_EMIT(dst, n, spec, sw, w, sp, pr, val)                             \
+    ((sw) && (sp) ? snprintf((dst), (n), (spec), (w), (pr), (val))            \
+     : (sw)       ? snprintf((dst), (n), (spec), (w), (val))                  \
+     : (sp)       ? snprintf((dst), (n), (spec), (pr), (val))                 \
+     :              snprintf((dst), (n), (spec), (val)))
+
+static void log_decode(const char *fmt, const uint8_t *args, char *out, size_t cap)
+{
+    size_t   o   = 0;
+    uint32_t pos = 0;
+
+    for (const char *p = fmt; *p && o + 1 < cap; ) {
+        if (*p != '%') { out[o++] = *p++; continue; }
+        p++;
+
+        Qs_LogSpec spec;
+        p = log_parse_spec(p, &spec);
+        if (spec.kind == QS_LOG_ARG_NONE) { out[o++] = '%'; continue; }
+
+        int w = 0, pr = 0;
+        if (spec.star_width) LOG_GET(args, pos, w);
+        if (spec.star_prec)  LOG_GET(args, pos, pr);
+
+        /* Rebuild the conversion with a length matching the stored type. */
+        char sub[40];
+        uint32_t body = spec.body_len < 24 ? spec.body_len : 24;
+        const char *len_mod = (spec.kind == QS_LOG_ARG_INT || spec.kind == QS_LOG_ARG_UINT)
+                              ? "ll" : "";
+        snprintf(sub, sizeof(sub), "%%%.*s%s%c", (int)body, spec.body, len_mod, spec.conv);
+
+        char  *dst  = out + o;
+        size_t room = cap - o;
+        int    n    = 0;
+        switch (spec.kind) {
+        case QS_LOG_ARG_INT:    { long long v;          LOG_GET(args, pos, v); n = LOG_EMIT(dst, room, sub, spec.star_width, w, spec.star_prec, pr, v); } break;
+        case QS_LOG_ARG_UINT:   { unsigned long long v; LOG_GET(args, pos, v); n = LOG_EMIT(dst, room, sub, spec.star_width, w, spec.star_prec, pr, v); } break;
+        case QS_LOG_ARG_CHAR:   { int v;                LOG_GET(args, pos, v); n = LOG_EMIT(dst, room, sub, spec.star_width, w, spec.star_prec, pr, v); } break;
+        case QS_LOG_ARG_PTR:    { void *v;              LOG_GET(args, pos, v); n = LOG_EMIT(dst, room, sub, spec.star_width, w, spec.star_prec, pr, v); } break;
+        case QS_LOG_ARG_DOUBLE: { double v;             LOG_GET(args, pos, v); n = LOG_EMIT(dst, room, sub, spec.star_width, w, spec.star_prec, pr, v); } break;
+        case QS_LOG_ARG_STR: {
+            uint32_t len;
+            LOG_GET(args, pos, len);
+            const char *s = (const char *)args + pos;
+            pos += len + 1;
+            n = LOG_EMIT(dst, room, sub, spec.star_width, w, spec.star_prec, pr, s);
+        } break;
+        default: break;
+        }
+        if (n > 0) o += ((size_t)n < room) ? (size_t)n : room - 1;
+    }
+    out[o] = '\0';
+}
+
+#undef LOG_GET
+#undef LOG_EMIT
+
+/* ── Per-thread rings ───────────────────────────────────────── */
+
+/* Returns the calling thread's ring, registering one on first use.  Once
+   all QS_LOG_MAX_THREADS slots are taken (or allocation fails) the thread
+   is bound to the shared ring instead. */
+static Qs_LogRing *log_thread_ring(Qs_LogState *state)
+{
+    if (t_log_ring && t_log_generation == state->generation) return t_log_ring;
+
+    Qs_LogRing *ring = NULL;
+    if (atomic_load_explicit(&state->ring_count, memory_order_relaxed) < QS_LOG_MAX_THREADS)
+        ring = calloc(1, sizeof(Qs_LogRing));
+
+    ca_mutex_lock(state->ring_mutex);
+    uint32_t idx = atomic_load_explicit(&state->ring_count, memory_order_relaxed);
+    if (ring && idx < QS_LOG_MAX_THREADS) {
+        state->rings[idx] = ring;
+        atomic_store_explicit(&state->ring_count, idx + 1, memory_order_release);
+    } else {
+        free(ring);
+        ring = state->shared_ring;
+    }
+    ca_mutex_unlock(state->ring_mutex);
+
+    t_log_ring       = ring;
+    t_log_generation = state->generation;
+    return ring;
+}
+
+/* Copies a record (header + payload) into the ring. Never blocks; a full
+   ring drops the record and counts it. */
+static bool log_ring_push(Qs_LogRing *ring, const Qs_LogRecord *hdr,
+                          const void *payload, uint32_t payload_len)
+{
+    uint32_t size = (uint32_t)((sizeof(Qs_LogRecord) + payload_len + 7u) & ~7u);
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
 
-    state->min_level  = QS_LOG_DEBUG;
-    state->start_time = get_time_sec();
+    uint32_t off    = (uint32_t)(head & (QS_LOG_RING_SIZE - 1));
+    uint32_t to_end = QS_LOG_RING_SIZE - off;
+    uint32_t need   = to_end < size ? to_end + size : size;
+
+    if (head + need - tail > QS_LOG_RING_SIZE) {
+        atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+        return false;
+    }
+
+    if (to_end < size) {
+        Qs_LogRecord pad = { .size = to_end, .kind = QS_LOG_REC_PAD };
+        memcpy(ring->data + off, &pad, sizeof(uint32_t) * 2);
+        head += to_end;
+        off   = 0;
+    }
+
+    Qs_LogRecord rec = *hdr;
+    rec.size = size;
+    memcpy(ring->data + off, &rec, sizeof(rec));
+    if (payload_len)
+        memcpy(ring->data + off + sizeof(rec), payload, payload_len);
+
+    atomic_store_explicit(&ring->head, head + size, memory_order_seq_cst);
+    return true;
+}
+
+static bool log_ring_pending(const Qs_LogRing *r)
+{
+    return atomic_load_explicit(&r->head, memory_order_seq_cst) !=
+           atomic_load_explicit(&r->tail, memory_order_relaxed);
+}
+
+static bool log_rings_pending(Qs_LogState *state)
+{
+    uint32_t n = atomic_load_explicit(&state->ring_count, memory_order_acquire);
+    for (uint32_t i = 0; i < n; i++)
+        if (log_ring_pending(state->rings[i])) return true;
+    return log_ring_pending(state->shared_ring);
+}
+
+/* ── Writer thread ──────────────────────────────────────────── */
+
+static void log_nap(void)
+{
+#ifdef _WIN32
+    Sleep(QS_LOG_BATCH_NAP_US / 1000);
+#else
+    struct timespec ts = { 0, QS_LOG_BATCH_NAP_US * 1000L };
+    nanosleep(&ts, NULL);
+#endif
+}
+
+/* ── History ────────────────────────────────────────────────── */
+
+static char log_lower(char c)
+{
+    return (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c;
+}
+
+static uint32_t log_trigram_bit(const char *t)
+{
+    uint32_t h = 2166136261u;
+    for (int i = 0; i < 3; i++) h = (h ^ (uint8_t)log_lower(t[i])) * 16777619u;
+    return h & (QS_LOG_BLOOM_BITS - 1);
+}
+
+static Qs_LogChunk *history_chunk_at(const Qs_LogHistory *h, uint32_t i)
+{
+    return h->chunks[(h->chunk_head + i) % h->chunk_cap];
+}
+
+/* Returns the chunk index holding seq, or UINT32_MAX if not retained. */
+static uint32_t history_find_chunk(const Qs_LogHistory *h, uint64_t seq)
+{
+    if (seq < h->first_seq || seq >= h->end_seq) return UINT32_MAX;
+    uint32_t lo = 0, hi = h->chunk_count;
+    while (hi - lo > 1) {
+        uint32_t mid = (lo + hi) / 2;
+        if (history_chunk_at(h, mid)->first_seq <= seq) lo = mid;
+        else                                            hi = mid;
+    }
+    return lo;
+}
+
+static void history_set_limit(Qs_LogHistory *h, uint32_t max_entries)
+{
+    uint32_t chunks = (max_entries + QS_LOG_CHUNK_ENTRIES - 1) / QS_LOG_CHUNK_ENTRIES;
+    h->max_chunks = chunks < 2 ? 2 : chunks;
+}
+
+/* Opens a fresh chunk at the tail, recycling the oldest one once the
+   history is at its cap.  Evicted entries remain in the log file. */
+static Qs_LogChunk *history_open_chunk(Qs_LogHistory *h)
+{
+    Qs_LogChunk *chunk = NULL;
+
+    while (h->chunk_count >= h->max_chunks) {
+        Qs_LogChunk *old = h->chunks[h->chunk_head];
+        h->chunk_head = (h->chunk_head + 1) % h->chunk_cap;
+        h->chunk_count--;
+        h->first_seq = h->chunk_count ? history_chunk_at(h, 0)->first_seq : h->end_seq;
+        if (chunk) free(chunk);
+        chunk = old;
+    }
+
+    if (h->chunk_count == h->chunk_cap) {
+        uint32_t new_cap = h->chunk_cap ? h->chunk_cap * 2 : 16;
+        Qs_LogChunk **grown = malloc(new_cap * sizeof(Qs_LogChunk *));
+        if (!grown) { free(chunk); return NULL; }
+        for (uint32_t i = 0; i < h->chunk_count; i++)
+            grown[i] = history_chunk_at(h, i);
+        free(h->chunks);
+        h->chunks     = grown;
+        h->chunk_cap  = new_cap;
+        h->chunk_head = 0;
+    }
+
+    if (!chunk) chunk = malloc(sizeof(Qs_LogChunk));
+    if (!chunk) return NULL;
+    chunk->first_seq = h->end_seq;
+    chunk->count     = 0;
+    chunk->text_used = 0;
+    memset(chunk->level_counts, 0, sizeof(chunk->level_counts));
+    memset(chunk->bloom, 0, sizeof(chunk->bloom));
+
+    h->chunks[(h->chunk_head + h->chunk_count) % h->chunk_cap] = chunk;
+    if (h->chunk_count++ == 0) h->first_seq = h->end_seq;
+    return chunk;
+}
+
+static void history_append(Qs_LogHistory *h, Qs_LogLevel level,
+                           double elapsed, const char *text, uint32_t len)
+{
+    Qs_LogChunk *chunk = h->chunk_count ? history_chunk_at(h, h->chunk_count - 1) : NULL;
+    if (!chunk || chunk->count == QS_LOG_CHUNK_ENTRIES ||
+        chunk->text_used + len + 1 > QS_LOG_CHUNK_TEXT) {
+        chunk = history_open_chunk(h);
+        if (!chunk) return;
+    }
+
+    Qs_LogSlot *slot = &chunk->slots[chunk->count++];
+    slot->timestamp = elapsed;
+    slot->offset    = chunk->text_used;
+    slot->length    = (uint16_t)len;
+    slot->level     = (uint8_t)level;
+
+    memcpy(chunk->text + chunk->text_used, text, len);
+    chunk->text[chunk->text_used + len] = '\0';
+    chunk->text_used += len + 1;
+
+    chunk->level_counts[level]++;
+    for (uint32_t i = 0; i + 3 <= len; i++) {
+        uint32_t bit = log_trigram_bit(text + i);
+        chunk->bloom[bit / 64] |= 1ull << (bit % 64);
+    }
+    h->end_seq++;
+}
+
+static void history_release(Qs_LogHistory *h)
+{
+    for (uint32_t i = 0; i < h->chunk_count; i++) free(history_chunk_at(h, i));
+    free(h->chunks);
+    memset(h, 0, sizeof(*h));
+}
+
+static void history_copy_entry(const Qs_LogChunk *chunk, uint64_t seq,
+                               Qs_LogEntry *out, char *buf, uint32_t buf_size)
+{
+    const Qs_LogSlot *slot = &chunk->slots[seq - chunk->first_seq];
+    uint32_t n = slot->length < buf_size ? slot->length : buf_size - 1;
+    memcpy(buf, chunk->text + slot->offset, n);
+    buf[n] = '\0';
+    *out = (Qs_LogEntry){
+        .seq       = seq,
+        .level     = (Qs_LogLevel)slot->level,
+        .timestamp = slot->timestamp,
+        .message   = buf,
+    };
+}
+
+/* ── Log file ───────────────────────────────────────────────── */
+
+static void log_file_open(Qs_LogState *state)
+{
     state->file       = fopen(QS_LOG_FILE_NAME, "w");
+    state->file_bytes = 0;
+    if (!state->file) return;
+
+    time_t now = time(NULL);
+    struct tm *t = localtime(&now);
+    char date_buf[64];
+    strftime(date_buf, sizeof(date_buf), "%Y-%m-%d %H:%M:%S", t);
+    int n = fprintf(state->file, "=== Quasar Engine Log — %s ===\n\n", date_buf);
+    if (n > 0) state->file_bytes = (uint64_t)n;
+    fflush(state->file);
+}
 
-    g_log = state;
+/* Keeps one previous file so disk use stays within twice the limit. */
+static void log_file_rotate(Qs_LogState *state)
+{
+    fprintf(state->file, "\n=== Continued in new log file ===\n");
+    fclose(state->file);
+    remove(QS_LOG_FILE_PREV);
+    rename(QS_LOG_FILE_NAME, QS_LOG_FILE_PREV);
+    log_file_open(state);
+}
+
+static void log_store(Qs_LogState *state, Qs_LogLevel level,
+                      double elapsed, const char *text)
+{
+    char ts[16];
+    format_timestamp(elapsed, ts, sizeof(ts));
+    printf("%s[%s] [%s] %s\033[0m\n",
+           g_level_colors[level], ts, g_level_labels[level], text);
+
+    ca_mutex_lock(state->mutex);
+    uint64_t file_limit = state->file_limit;
+    history_append(&state->history, level, elapsed, text, (uint32_t)strlen(text));
+    ca_mutex_unlock(state->mutex);
 
     if (state->file) {
-        time_t now = time(NULL);
-        struct tm *t = localtime(&now);
-        char date_buf[64];
-        strftime(date_buf, sizeof(date_buf), "%Y-%m-%d %H:%M:%S", t);
-        fprintf(state->file, "=== Quasar Engine Log — %s ===\n\n", date_buf);
-        fflush(state->file);
+        int n = fprintf(state->file, "[%s] [%s] %s\n", ts, g_level_labels[level], text);
+        if (n > 0) state->file_bytes += (uint64_t)n;
+        if (file_limit && state->file_bytes >= file_limit)
+            log_file_rotate(state);
     }
+}
 
-    return true;
+static uint32_t log_drain_ring(Qs_LogState *state, Qs_LogRing *ring)
+{
+    uint32_t processed = 0;
+    uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+    while (tail != head) {
+        const uint8_t *at = ring->data + (tail & (QS_LOG_RING_SIZE - 1));
+        Qs_LogRecord rec;
+        memcpy(&rec, at, sizeof(uint32_t) * 2);
+        if (rec.kind != QS_LOG_REC_PAD) {
+            memcpy(&rec, at, sizeof(rec));
+            char text[QS_LOG_MSG_MAX];
+            if (rec.kind == QS_LOG_REC_TEXT)
+                snprintf(text, sizeof(text), "%s", (const char *)(at + sizeof(rec)));
+            else
+                log_decode(rec.fmt, at + sizeof(rec), text, sizeof(text));
+
+            double elapsed = (double)(rec.time_ns - state->start_ns) * 1e-9;
+            log_store(state, (Qs_LogLevel)rec.level, elapsed, text);
+            processed++;
+        }
+        tail += rec.size;
+        atomic_store_explicit(&ring->tail, tail, memory_order_release);
+    }
+
+    uint64_t dropped = atomic_load_explicit(&ring->dropped, memory_order_relaxed);
+    if (dropped != ring->dropped_reported) {
+        char text[96];
+        snprintf(text, sizeof(text), "%llu log messages dropped (thread ring full)",
+                 (unsigned long long)(dropped - ring->dropped_reported));
+        ring->dropped_reported = dropped;
+        log_store(state, QS_LOG_WARN,
+                  (double)(qs_clock_ns() - state->start_ns) * 1e-9, text);
+        processed++;
+    }
+    return processed;
 }
 
-static void log_system_shutdown(Qs_System *system, Qs_Engine *engine)
+static uint32_t log_drain(Qs_LogState *state)
+{
+    uint32_t processed = 0;
+    uint32_t n = atomic_load_explicit(&state->ring_count, memory_order_acquire);
+    for (uint32_t i = 0; i < n; i++)
+        processed += log_drain_ring(state, state->rings[i]);
+    return processed + log_drain_ring(state, state->shared_ring);
+}
+
+static void *log_writer_fn(void *arg)
+{
+    Qs_LogState *state = arg;
+
+    for (;;) {
+        ca_mutex_lock(state->wake_mutex);
+        uint64_t flush_req = state->flush_requested;
+        bool     running   = state->writer_running;
+        ca_mutex_unlock(state->wake_mutex);
+
+        uint32_t processed = log_drain(state);
+        if (processed) {
+            fflush(stdout);
+            if (state->file) fflush(state->file);
+
+            ca_mutex_lock(state->mutex);
+            Qs_LogListenerFn fn = state->listener;
+            void *fn_data       = state->listener_data;
+            ca_mutex_unlock(state->mutex);
+            if (fn) fn(fn_data);
+        }
+
+        ca_mutex_lock(state->wake_mutex);
+        if (flush_req > state->flush_completed) {
+            state->flush_completed = flush_req;
+            ca_condvar_broadcast(state->flush_cond);
+        }
+        if (!running) {
+            ca_mutex_unlock(state->wake_mutex);
+            break;
+        }
+        /* Publish the sleeping flag before re-checking the rings; producers
+           check it after publishing, so one side always sees the other. */
+        bool idle = !processed && state->writer_running &&
+                    state->flush_requested == flush_req;
+        if (idle) {
+            atomic_store(&state->writer_sleeping, true);
+            if (!log_rings_pending(state))
+                ca_condvar_wait(state->wake_cond, state->wake_mutex);
+            atomic_store(&state->writer_sleeping, false);
+        }
+        ca_mutex_unlock(state->wake_mutex);
+
+        /* While messages keep arriving, stay awake and batch them so
+           producers never pay for a wake-up. */
+        if (processed) log_nap();
+    }
+    return NULL;
+}
+
+static void log_wake_writer(Qs_LogState *state)
+{
+    if (!atomic_load(&state->writer_sleeping)) return;
+    ca_mutex_lock(state->wake_mutex);
+    ca_condvar_signal(state->wake_cond);
+    ca_mutex_unlock(state->wake_mutex);
+}
+
+/* ── System callbacks ───────────────────────────────────────── */
+
+static void log_state_release(Qs_LogState *state)
+{
+    uint32_t rings = atomic_load(&state->ring_count);
+    for (uint32_t i = 0; i < rings; i++) free(state->rings[i]);
+    free(state->shared_ring);
+    history_release(&state->history);
+    if (state->file) fclose(state->file);
+    ca_condvar_destroy(state->flush_cond);
+    ca_condvar_destroy(state->wake_cond);
+    ca_mutex_destroy(state->wake_mutex);
+    ca_mutex_destroy(state->shared_mutex);
+    ca_mutex_destroy(state->ring_mutex);
+    ca_mutex_destroy(state->mutex);
+    memset(state, 0, sizeof(*state));
+}
+
+static bool log_system_init(Qs_System *system, Qs_Engine *engine)
 {
     (void)engine;
     Qs_LogState *state = (Qs_LogState *)qs_system_data(system);
 
-    flush_to_file(state);
-
-    if (state->file) {
-        fprintf(state->file, "\n=== Log closed ===\n");
-        fclose(state->file);
-        state->file = NULL;
+    state->mutex        = ca_mutex_create();
+    state->ring_mutex   = ca_mutex_create();
+    state->shared_mutex = ca_mutex_create();
+    state->shared_ring  = calloc(1, sizeof(Qs_LogRing));
+    state->wake_mutex   = ca_mutex_create();
+    state->wake_cond    = ca_condvar_create();
+    state->flush_cond   = ca_condvar_create();
+    if (!state->mutex || !state->ring_mutex || !state->shared_mutex || !state->shared_ring ||
+        !state->wake_mutex || !state->wake_cond || !state->flush_cond) {
+        log_state_release(state);
+        return false;
     }
 
-    for (uint32_t i = 0; i < state->count; i++)
-        free(state->storage[i].text);
+    atomic_store(&state->min_level, QS_LOG_DEBUG);
+    state->start_ns   = qs_clock_ns();
+    state->generation = ++g_log_generation;
+    state->file_limit = QS_LOG_DEFAULT_FILE_MAX;
+    history_set_limit(&state->history, QS_LOG_DEFAULT_HISTORY);
+    log_file_open(state);
+
+    state->writer_running = true;
+    state->writer = ca_thread_create(log_writer_fn, state);
+    if (!state->writer) {
+        log_state_release(state);
+        return false;
+    }
 
-    free(state->entries);
-    free(state->storage);
-    state->entries = NULL;
-    state->storage = NULL;
-    state->count   = 0;
+    g_log = state;
+    return true;
+}
 
-    if (state->mutex) { ca_mutex_destroy(state->mutex); state->mutex = NULL; }
+static void log_system_shutdown(Qs_System *system, Qs_Engine *engine)
+{
+    (void)engine;
+    Qs_LogState *state = (Qs_LogState *)qs_system_data(system);
 
     g_log = NULL;
+
+    /* The writer drains every ring once more after observing the stop. */
+    ca_mutex_lock(state->wake_mutex);
+    state->writer_running = false;
+    ca_condvar_signal(state->wake_cond);
+    ca_mutex_unlock(state->wake_mutex);
+    ca_thread_join(state->writer);
+
+    if (state->file)
+        fprintf(state->file, "\n=== Log closed ===\n");
+
+    log_state_release(state);
 }
 
 Qs_SystemDesc qs_log_system_desc(void)
@@ -158,9 +821,12 @@ Qs_SystemDesc qs_log_system_desc(void)
     };
 }
 
+/* ── Public API ─────────────────────────────────────────────── */
+
 void qs_log(Qs_LogLevel level, const char *fmt, ...)
 {
-    if (!g_log) {
+    Qs_LogState *state = g_log;
+    if (!state) {
         /* Fallback before log system is up */
         va_list args;
         va_start(args, fmt);
@@ -170,120 +836,304 @@ void qs_log(Qs_LogLevel level, const char *fmt, ...)
         return;
     }
 
-    if (level < g_log->min_level) return;
+    if ((int)level < atomic_load_explicit(&state->min_level, memory_order_relaxed))
+        return;
+    if ((unsigned)level >= QS_LOG_LEVEL_COUNT || !fmt) return;
+
+    Qs_LogRing *ring = log_thread_ring(state);
+
+    Qs_LogRecord hdr = {
+        .level   = (uint8_t)level,
+        .kind    = QS_LOG_REC_DEFERRED,
+        .time_ns = qs_clock_ns(),
+        .fmt     = fmt,
+    };
+
+    uint8_t  payload[QS_LOG_MSG_MAX];
+    uint32_t payload_len = 0;
 
-    /* Format message (outside lock — uses only local stack) */
-    char buf[QS_LOG_MSG_MAX];
     va_list args;
     va_start(args, fmt);
-    vsnprintf(buf, sizeof(buf), fmt, args);
+    va_list fallback;
+    va_copy(fallback, args);
+    if (!log_encode_args(fmt, &args, payload, sizeof(payload), &payload_len)) {
+        /* Conversion the writer cannot replay (e.g. %ls) or oversized
+           arguments: format here instead. */
+        int n = vsnprintf((char *)payload, sizeof(payload), fmt, fallback);
+        payload_len = (n < 0) ? 1
+                    : ((uint32_t)n < sizeof(payload) ? (uint32_t)n + 1 : sizeof(payload));
+        if (n < 0) payload[0] = '\0';
+        hdr.kind = QS_LOG_REC_TEXT;
+        hdr.fmt  = NULL;
+    }
+    va_end(fallback);
     va_end(args);
 
-    double elapsed = get_time_sec() - g_log->start_time;
+    if (ring == state->shared_ring) {
+        ca_mutex_lock(state->shared_mutex);
+        log_ring_push(ring, &hdr, payload, payload_len);
+        ca_mutex_unlock(state->shared_mutex);
+    } else {
+        log_ring_push(ring, &hdr, payload, payload_len);
+    }
+    log_wake_writer(state);
 
-    /* Print to stdout first (outside lock) so interactive consoles stay
-       responsive even if the storage lock is briefly contended. */
-    char ts[16];
-    format_timestamp(elapsed, ts, sizeof(ts));
-    printf("%s[%s] [%s] %s\033[0m\n",
-           g_level_colors[level], ts, g_level_labels[level], buf);
-
-    if (g_log->mutex) ca_mutex_lock(g_log->mutex);
-
-    /* Grow arrays if needed.
-       Update each pointer immediately after its own realloc so that
-       g_log->entries is never left pointing at freed memory if the
-       second realloc fails (classic double-realloc use-after-free). */
-    if (g_log->count == g_log->capacity) {
-        uint32_t new_cap = g_log->capacity * 2;
-        Qs_LogEntry *ne = realloc(g_log->entries, new_cap * sizeof(Qs_LogEntry));
-        if (!ne) { if (g_log->mutex) ca_mutex_unlock(g_log->mutex); return; }
-        g_log->entries = ne;   /* update immediately — pointer is now valid */
-        Qs_LogStorage *ns = realloc(g_log->storage, new_cap * sizeof(Qs_LogStorage));
-        if (!ns) { if (g_log->mutex) ca_mutex_unlock(g_log->mutex); return; }
-        g_log->storage  = ns;
-        g_log->capacity = new_cap;
-    }
-
-    /* Store message */
-    size_t msg_len = strlen(buf);
-    char *text = malloc(msg_len + 1);
-    if (!text) {
-        if (g_log->mutex) ca_mutex_unlock(g_log->mutex);
-        return;
+    /* Make sure fatal messages reach disk before the process goes down. */
+    if (level == QS_LOG_FATAL) qs_log_flush();
+}
+
+const char *qs_log_level_str(Qs_LogLevel level)
+{
+    if (level >= QS_LOG_LEVEL_COUNT) return "?????";
+    return g_level_labels[level];
+}
+
+void qs_log_set_history_limit(uint32_t max_entries)
+{
+    if (!g_log) return;
+    ca_mutex_lock(g_log->mutex);
+    history_set_limit(&g_log->history, max_entries);
+    ca_mutex_unlock(g_log->mutex);
+}
+
+void qs_log_set_file_limit(uint64_t max_bytes)
+{
+    if (!g_log) return;
+    ca_mutex_lock(g_log->mutex);
+    g_log->file_limit = max_bytes;
+    ca_mutex_unlock(g_log->mutex);
+}
+
+void qs_log_history_range(uint64_t *out_first, uint64_t *out_end)
+{
+    uint64_t first = 0, end = 0;
+    if (g_log) {
+        ca_mutex_lock(g_log->mutex);
+        first = g_log->history.first_seq;
+        end   = g_log->history.end_seq;
+        ca_mutex_unlock(g_log->mutex);
     }
-    memcpy(text, buf, msg_len + 1);
+    if (out_first) *out_first = first;
+    if (out_end)   *out_end   = end;
+}
 
-    uint32_t idx = g_log->count++;
-    g_log->storage[idx].text = text;
-    g_log->entries[idx] = (Qs_LogEntry){
-        .level     = level,
-        .timestamp = elapsed,
-        .message   = text,
-    };
+bool qs_log_entry_copy(uint64_t seq, Qs_LogEntry *out, char *buf, uint32_t buf_size)
+{
+    if (!g_log || !out || !buf || buf_size == 0) return false;
+
+    ca_mutex_lock(g_log->mutex);
+    const Qs_LogHistory *h = &g_log->history;
+    uint32_t ci = history_find_chunk(h, seq);
+    if (ci != UINT32_MAX)
+        history_copy_entry(history_chunk_at(h, ci), seq, out, buf, buf_size);
+    ca_mutex_unlock(g_log->mutex);
+    return ci != UINT32_MAX;
+}
 
-    /* Auto-flush to file at threshold */
-    g_log->unflushed++;
-    if (g_log->unflushed >= QS_LOG_FLUSH_THRESH)
-        flush_to_file(g_log);
+/* ── Filtered views ─────────────────────────────────────────── */
+
+struct Qs_LogView {
+    uint32_t  level_mask;
+    char      text[QS_LOG_FILTER_MAX];
+    uint32_t  text_len;
+    uint32_t  generation;       /* log generation the rows belong to */
+    uint64_t  scanned_end;      /* entries below this seq have been tested */
+    uint64_t  first_seq;        /* history start at the last refresh */
+    uint64_t *rows;             /* matching seqs, ascending (filtered mode) */
+    uint32_t  row_begin;        /* first row still retained */
+    uint32_t  row_end;
+    uint32_t  row_cap;
+};
 
-    if (g_log->mutex) ca_mutex_unlock(g_log->mutex);
+static bool log_view_filtered(const Qs_LogView *v)
+{
+    return v->text_len > 0 || (v->level_mask & QS_LOG_LEVEL_MASK_ALL) != QS_LOG_LEVEL_MASK_ALL;
+}
 
-    /* Notify listener (outside lock to avoid re-entrancy deadlock) */
-    if (g_log->listener)
-        g_log->listener(g_log->listener_data);
+static bool log_text_contains(const char *hay, uint32_t hay_len,
+                              const char *needle, uint32_t needle_len)
+{
+    if (needle_len > hay_len) return false;
+    for (uint32_t i = 0; i + needle_len <= hay_len; i++) {
+        uint32_t k = 0;
+        while (k < needle_len && log_lower(hay[i + k]) == needle[k]) k++;
+        if (k == needle_len) return true;
+    }
+    return false;
 }
 
-const char *qs_log_level_str(Qs_LogLevel level)
+static bool log_chunk_may_match(const Qs_LogChunk *c, const Qs_LogView *v)
 {
-    if (level >= QS_LOG_LEVEL_COUNT) return "?????";
-    return g_level_labels[level];
+    bool level_hit = false;
+    for (uint32_t l = 0; l < QS_LOG_LEVEL_COUNT; l++)
+        if ((v->level_mask & (1u << l)) && c->level_counts[l]) { level_hit = true; break; }
+    if (!level_hit) return false;
+
+    for (uint32_t i = 0; i + 3 <= v->text_len; i++) {
+        uint32_t bit = log_trigram_bit(v->text + i);
+        if (!(c->bloom[bit / 64] & (1ull << (bit % 64)))) return false;
+    }
+    return true;
 }
 
-const Qs_LogEntry *qs_log_entries(uint32_t *out_count)
+static bool log_view_push(Qs_LogView *v, uint64_t seq)
 {
-    if (!g_log) {
-        if (out_count) *out_count = 0;
-        return NULL;
+    if (v->row_end == v->row_cap) {
+        /* Reclaim rows that fell out of the history before growing. */
+        if (v->row_begin > 0) {
+            memmove(v->rows, v->rows + v->row_begin,
+                    (v->row_end - v->row_begin) * sizeof(uint64_t));
+            v->row_end  -= v->row_begin;
+            v->row_begin = 0;
+        }
+        if (v->row_end == v->row_cap) {
+            uint32_t new_cap = v->row_cap ? v->row_cap * 2 : 1024;
+            uint64_t *grown = realloc(v->rows, new_cap * sizeof(uint64_t));
+            if (!grown) return false;
+            v->rows    = grown;
+            v->row_cap = new_cap;
+        }
+    }
+    v->rows[v->row_end++] = seq;
+    return true;
+}
+
+Qs_LogView *qs_log_view_create(void)
+{
+    Qs_LogView *v = calloc(1, sizeof(Qs_LogView));
+    if (!v) return NULL;
+    v->level_mask = QS_LOG_LEVEL_MASK_ALL;
+    return v;
+}
+
+void qs_log_view_destroy(Qs_LogView *view)
+{
+    if (!view) return;
+    free(view->rows);
+    free(view);
+}
+
+void qs_log_view_set_filter(Qs_LogView *view, uint32_t level_mask, const char *text)
+{
+    if (!view) return;
+    view->level_mask = level_mask & QS_LOG_LEVEL_MASK_ALL;
+    view->text_len   = 0;
+    for (const char *p = text; p && *p && view->text_len + 1 < QS_LOG_FILTER_MAX; p++)
+        view->text[view->text_len++] = log_lower(*p);
+    view->text[view->text_len] = '\0';
+
+    view->scanned_end = 0;
+    view->row_begin   = 0;
+    view->row_end     = 0;
+}
+
+uint32_t qs_log_view_refresh(Qs_LogView *view)
+{
+    if (!view || !g_log) return 0;
+
+    ca_mutex_lock(g_log->mutex);
+    const Qs_LogHistory *h = &g_log->history;
+
+    if (view->generation != g_log->generation) {
+        view->generation  = g_log->generation;
+        view->scanned_end = 0;
+        view->row_begin   = 0;
+        view->row_end     = 0;
+    }
+    view->first_seq = h->first_seq;
+
+    if (!log_view_filtered(view)) {
+        view->scanned_end = h->end_seq;
+        ca_mutex_unlock(g_log->mutex);
+        return (uint32_t)(h->end_seq - h->first_seq);
+    }
+
+    while (view->row_begin < view->row_end && view->rows[view->row_begin] < h->first_seq)
+        view->row_begin++;
+
+    uint64_t seq = view->scanned_end > h->first_seq ? view->scanned_end : h->first_seq;
+    uint32_t budget = QS_LOG_VIEW_SCAN_BUDGET;
+    uint32_t ci = history_find_chunk(h, seq);
+
+    for (; ci != UINT32_MAX && ci < h->chunk_count && budget > 0; ci++) {
+        const Qs_LogChunk *c = history_chunk_at(h, ci);
+        uint64_t chunk_end = c->first_seq + c->count;
+        if (!log_chunk_may_match(c, view)) { seq = chunk_end; continue; }
+
+        for (; seq < chunk_end && budget > 0; seq++, budget--) {
+            const Qs_LogSlot *slot = &c->slots[seq - c->first_seq];
+            if (!(view->level_mask & (1u << slot->level))) continue;
+            if (view->text_len &&
+                !log_text_contains(c->text + slot->offset, slot->length,
+                                   view->text, view->text_len))
+                continue;
+            if (!log_view_push(view, seq)) { budget = 0; break; }
+        }
+    }
+    view->scanned_end = seq;
+
+    ca_mutex_unlock(g_log->mutex);
+    return view->row_end - view->row_begin;
+}
+
+bool qs_log_view_scanning(const Qs_LogView *view)
+{
+    if (!view || !g_log) return false;
+    uint64_t end;
+    qs_log_history_range(NULL, &end);
+    return view->scanned_end < end;
+}
+
+bool qs_log_view_row(const Qs_LogView *view, uint32_t row,
+                     Qs_LogEntry *out, char *buf, uint32_t buf_size)
+{
+    if (!view) return false;
+    uint64_t seq;
+    if (log_view_filtered(view)) {
+        if (row >= view->row_end - view->row_begin) return false;
+        seq = view->rows[view->row_begin + row];
+    } else {
+        seq = view->first_seq + row;
     }
-    /* Lock so count and entries pointer are consistent w.r.t. concurrent
-       worker-thread calls to qs_log() that may realloc the array. */
-    if (g_log->mutex) ca_mutex_lock(g_log->mutex);
-    uint32_t n           = g_log->count;
-    const Qs_LogEntry *arr = g_log->entries;
-    if (g_log->mutex) ca_mutex_unlock(g_log->mutex);
-    if (out_count) *out_count = n;
-    return arr;
+    return qs_log_entry_copy(seq, out, buf, buf_size);
 }
 
 void qs_log_set_level(Qs_LogLevel min_level)
 {
     if (!g_log) return;
-    if (g_log->mutex) ca_mutex_lock(g_log->mutex);
-    g_log->min_level = min_level;
-    if (g_log->mutex) ca_mutex_unlock(g_log->mutex);
+    atomic_store_explicit(&g_log->min_level, (int)min_level, memory_order_relaxed);
 }
 
 void qs_log_flush(void)
 {
-    if (!g_log) return;
-    if (g_log->mutex) ca_mutex_lock(g_log->mutex);
-    flush_to_file(g_log);
-    if (g_log->mutex) ca_mutex_unlock(g_log->mutex);
+    Qs_LogState *state = g_log;
+    if (!state) return;
+
+    ca_mutex_lock(state->wake_mutex);
+    uint64_t ticket = ++state->flush_requested;
+    ca_condvar_signal(state->wake_cond);
+    while (state->flush_completed < ticket && state->writer_running)
+        ca_condvar_wait(state->flush_cond, state->wake_mutex);
+    ca_mutex_unlock(state->wake_mutex);
 }
 
 void qs_log_set_listener(Qs_LogListenerFn fn, void *userdata)
 {
     if (!g_log) return;
-    if (g_log->mutex) ca_mutex_lock(g_log->mutex);
+    ca_mutex_lock(g_log->mutex);
     g_log->listener      = fn;
     g_log->listener_data = userdata;
-    if (g_log->mutex) ca_mutex_unlock(g_log->mutex);
+    ca_mutex_unlock(g_log->mutex);
 }
 
 /* ================================================================
    EVENT SYSTEM  (was qs_event_system.c)
-   ================================================================ */
+   ================================================================
+   Listeners are bucketed per event ID behind an open-addressing map, so
+   firing touches only the listeners of that ID.  Removal leaves a
+   tombstone that keeps subscription order intact and is compacted once
+   no dispatch is running.  Posted events go through a bounded lock-free
+   MPSC ring drained on the main thread once per frame. */
 
 #include "qs_event.h"
 #include "qs_system.h"
@@ -291,30 +1141,213 @@ void qs_log_set_listener(Qs_LogListenerFn fn, void *userdata)
 #include <string.h>
 #include <stdio.h>
 
+#define QS_EVENT_INITIAL_CAP   32
+#define QS_EVENT_MAP_INITIAL   64      /* map slots, power of two */
+#define QS_EVENT_QUEUE_CAP     4096    /* posted events in flight, power of two */
+
 typedef struct Qs_Listener {
-    Qs_EventId  id;
-    Qs_EventFn  callback;
+    Qs_EventFn  callback;       /* NULL = removed (tombstone) */
     void       *user_data;
     uint32_t    handle;
 } Qs_Listener;
 
-struct Qs_EventBus {
+typedef struct {
+    Qs_EventId   id;
     Qs_Listener *listeners;
     uint32_t     count;
     uint32_t     capacity;
-    uint32_t     next_handle;
+    uint32_t     tombstones;
+    bool         coalesce;
+    uint64_t     coalesce_stamp;    /* drain serial of the last kept post */
+} Qs_EventBucket;
+
+/* u32 -> bucket index; key 0 marks an empty slot (keys are stored +1). */
+typedef struct {
+    uint32_t *keys;
+    uint32_t *values;
+    uint32_t  cap;
+    uint32_t  count;
+} Qs_EventMap;
+
+typedef struct {
+    _Atomic size_t seq;
+    Qs_EventId     id;
+    uint32_t       data_size;
+    uint8_t        data[QS_EVENT_POST_MAX_DATA];
+} Qs_EventCell;
+
+typedef struct {
+    Qs_EventId id;
+    uint32_t   data_size;
+    uint8_t    data[QS_EVENT_POST_MAX_DATA];
+} Qs_PostedEvent;
+
+struct Qs_EventBus {
+    Qs_EventBucket *buckets;
+    uint32_t        bucket_count;
+    uint32_t        bucket_cap;
+    Qs_EventMap     by_id;          /* event id -> bucket */
+    Qs_EventMap     by_handle;      /* listener handle -> bucket */
+    uint32_t        next_handle;
+    uint32_t        fire_depth;
+    bool            needs_compact;
+
+    /* Posted events (MPSC) */
+    Qs_EventCell   *cells;
+    _Atomic size_t  enqueue_pos;
+    size_t          dequeue_pos;
+    Qs_PostedEvent *batch;          /* drain scratch */
+    uint32_t        batch_cap;
+    uint64_t        drain_serial;
+    _Atomic uint32_t dropped;
 };
 
-#define QS_EVENT_INITIAL_CAP 32
+/* ── Map ────────────────────────────────────────────────────── */
+
+static uint32_t event_hash(uint32_t key)
+{
+    key ^= key >> 16;
+    key *= 0x7feb352du;
+    key ^= key >> 15;
+    key *= 0x846ca68bu;
+    key ^= key >> 16;
+    return key;
+}
+
+static bool event_map_init(Qs_EventMap *m, uint32_t cap)
+{
+    m->keys   = calloc(cap, sizeof(uint32_t));
+    m->values = calloc(cap, sizeof(uint32_t));
+    m->cap    = cap;
+    m->count  = 0;
+    return m->keys && m->values;
+}
+
+static void event_map_free(Qs_EventMap *m)
+{
+    free(m->keys);
+    free(m->values);
+    memset(m, 0, sizeof(*m));
+}
+
+static uint32_t *event_map_find(const Qs_EventMap *m, uint32_t key)
+{
+    uint32_t stored = key + 1;
+    for (uint32_t i = event_hash(key) & (m->cap - 1); m->keys[i];
+         i = (i + 1) & (m->cap - 1)) {
+        if (m->keys[i] == stored) return &m->values[i];
+    }
+    return NULL;
+}
+
+static bool event_map_put(Qs_EventMap *m, uint32_t key, uint32_t value)
+{
+    if ((m->count + 1) * 4 > m->cap * 3) {
+        Qs_EventMap grown;
+        if (!event_map_init(&grown, m->cap * 2)) { event_map_free(&grown); return false; }
+        for (uint32_t i = 0; i < m->cap; i++)
+            if (m->keys[i]) event_map_put(&grown, m->keys[i] - 1, m->values[i]);
+        event_map_free(m);
+        *m = grown;
+    }
+    uint32_t i = event_hash(key) & (m->cap - 1);
+    while (m->keys[i] && m->keys[i] != key + 1) i = (i + 1) & (m->cap - 1);
+    if (!m->keys[i]) m->count++;
+    m->keys[i]   = key + 1;
+    m->values[i] = value;
+    return true;
+}
+
+/* Backward-shift deletion keeps probe chains intact without tombstones. */
+static void event_map_remove(Qs_EventMap *m, uint32_t key)
+{
+    uint32_t mask = m->cap - 1;
+    uint32_t i = event_hash(key) & mask;
+    while (m->keys[i] && m->keys[i] != key + 1) i = (i + 1) & mask;
+    if (!m->keys[i]) return;
+
+    m->keys[i] = 0;
+    m->count--;
+    for (uint32_t j = (i + 1) & mask; m->keys[j]; j = (j + 1) & mask) {
+        uint32_t home = event_hash(m->keys[j] - 1) & mask;
+        bool movable = (i <= j) ? (home <= i || home > j) : (home <= i && home > j);
+        if (movable) {
+            m->keys[i]   = m->keys[j];
+            m->values[i] = m->values[j];
+            m->keys[j]   = 0;
+            i = j;
+        }
+    }
+}
+
+/* ── Buckets ────────────────────────────────────────────────── */
+
+static Qs_EventBucket *event_bucket(Qs_EventBus *bus, Qs_EventId id, bool create)
+{
+    uint32_t *idx = event_map_find(&bus->by_id, id);
+    if (idx) return &bus->buckets[*idx];
+    if (!create) return NULL;
+
+    if (bus->bucket_count == bus->bucket_cap) {
+        uint32_t new_cap = bus->bucket_cap * 2;
+        Qs_EventBucket *grown = realloc(bus->buckets, new_cap * sizeof(Qs_EventBucket));
+        if (!grown) return NULL;
+        bus->buckets    = grown;
+        bus->bucket_cap = new_cap;
+    }
+    uint32_t bi = bus->bucket_count;
+    if (!event_map_put(&bus->by_id, id, bi)) return NULL;
+    bus->buckets[bi] = (Qs_EventBucket){ .id = id };
+    bus->bucket_count++;
+    return &bus->buckets[bi];
+}
+
+static void event_bucket_compact(Qs_EventBucket *b)
+{
+    uint32_t w = 0;
+    for (uint32_t r = 0; r < b->count; r++)
+        if (b->listeners[r].callback) b->listeners[w++] = b->listeners[r];
+    b->count      = w;
+    b->tombstones = 0;
+}
+
+static void event_compact_all(Qs_EventBus *bus)
+{
+    for (uint32_t i = 0; i < bus->bucket_count; i++)
+        if (bus->buckets[i].tombstones) event_bucket_compact(&bus->buckets[i]);
+    bus->needs_compact = false;
+}
+
+/* ── System callbacks ───────────────────────────────────────── */
+
+static void event_bus_release(Qs_EventBus *bus)
+{
+    for (uint32_t i = 0; i < bus->bucket_count; i++)
+        free(bus->buckets[i].listeners);
+    free(bus->buckets);
+    event_map_free(&bus->by_id);
+    event_map_free(&bus->by_handle);
+    free(bus->cells);
+    free(bus->batch);
+    memset(bus, 0, sizeof(*bus));
+}
 
 static bool event_system_init(Qs_System *system, Qs_Engine *engine)
 {
     (void)engine;
     Qs_EventBus *bus = qs_system_data(system);
 
-    bus->capacity    = QS_EVENT_INITIAL_CAP;
-    bus->listeners   = calloc(bus->capacity, sizeof(Qs_Listener));
-    if (!bus->listeners) return false;
+    bus->bucket_cap = QS_EVENT_INITIAL_CAP;
+    bus->buckets    = calloc(bus->bucket_cap, sizeof(Qs_EventBucket));
+    bus->cells      = calloc(QS_EVENT_QUEUE_CAP, sizeof(Qs_EventCell));
+    if (!bus->buckets || !bus->cells ||
+        !event_map_init(&bus->by_id, QS_EVENT_MAP_INITIAL) ||
+        !event_map_init(&bus->by_handle, QS_EVENT_MAP_INITIAL)) {
+        event_bus_release(bus);
+        return false;
+    }
+    for (size_t i = 0; i < QS_EVENT_QUEUE_CAP; i++)
+        atomic_init(&bus->cells[i].seq, i);
     bus->next_handle = 1;
     return true;
 }
@@ -322,11 +1355,7 @@ static bool event_system_init(Qs_System *system, Qs_Engine *engine)
 static void event_system_shutdown(Qs_System *system, Qs_Engine *engine)
 {
     (void)engine;
-    Qs_EventBus *bus = qs_system_data(system);
-    free(bus->listeners);
-    bus->listeners = NULL;
-    bus->count     = 0;
-    bus->capacity  = 0;
+    event_bus_release(qs_system_data(system));
 }
 
 Qs_SystemDesc qs_event_system_desc(void)
@@ -339,22 +1368,29 @@ Qs_SystemDesc qs_event_system_desc(void)
     };
 }
 
+/* ── Public API ─────────────────────────────────────────────── */
+
 uint32_t qs_event_subscribe(Qs_EventBus *bus, Qs_EventId id,
                             Qs_EventFn callback, void *user_data)
 {
     if (!bus || !callback) return 0;
 
-    if (bus->count == bus->capacity) {
-        uint32_t new_cap = bus->capacity * 2;
-        Qs_Listener *grown = realloc(bus->listeners, new_cap * sizeof(Qs_Listener));
+    Qs_EventBucket *b = event_bucket(bus, id, true);
+    if (!b) return 0;
+
+    if (b->count == b->capacity) {
+        uint32_t new_cap = b->capacity ? b->capacity * 2 : 4;
+        Qs_Listener *grown = realloc(b->listeners, new_cap * sizeof(Qs_Listener));
         if (!grown) return 0;
-        bus->listeners = grown;
-        bus->capacity  = new_cap;
+        b->listeners = grown;
+        b->capacity  = new_cap;
     }
 
     uint32_t handle = bus->next_handle++;
-    bus->listeners[bus->count++] = (Qs_Listener){
-        .id        = id,
+    if (!event_map_put(&bus->by_handle, handle, (uint32_t)(b - bus->buckets)))
+        return 0;
+
+    b->listeners[b->count++] = (Qs_Listener){
         .callback  = callback,
         .user_data = user_data,
         .handle    = handle,
@@ -366,12 +1402,21 @@ void qs_event_unsubscribe(Qs_EventBus *bus, uint32_t handle)
 {
     if (!bus || handle == 0) return;
 
-    for (uint32_t i = 0; i < bus->count; ++i) {
-        if (bus->listeners[i].handle == handle) {
-            bus->listeners[i] = bus->listeners[--bus->count];
-            return;
+    uint32_t *bi = event_map_find(&bus->by_handle, handle);
+    if (!bi) return;
+    Qs_EventBucket *b = &bus->buckets[*bi];
+    event_map_remove(&bus->by_handle, handle);
+
+    for (uint32_t i = 0; i < b->count; ++i) {
+        if (b->listeners[i].handle == handle) {
+            b->listeners[i].callback = NULL;
+            b->tombstones++;
+            break;
         }
     }
+
+    if (bus->fire_depth == 0) event_bucket_compact(b);
+    else                      bus->needs_compact = true;
 }
 
 void qs_event_fire(Qs_EventBus *bus, Qs_EventId id,
@@ -379,6 +1424,10 @@ void qs_event_fire(Qs_EventBus *bus, Qs_EventId id,
 {
     if (!bus) return;
 
+    uint32_t *bi = event_map_find(&bus->by_id, id);
+    if (!bi) return;
+    uint32_t bucket_idx = *bi;
+
     Qs_Event event = {
         .id        = id,
         .data      = data,
@@ -386,14 +1435,112 @@ void qs_event_fire(Qs_EventBus *bus, Qs_EventId id,
         .handled   = false,
     };
 
-    for (uint32_t i = 0; i < bus->count; ++i) {
-        if (bus->listeners[i].id == id) {
-            if (bus->listeners[i].callback(&event, bus->listeners[i].user_data)) {
-                event.handled = true;
-                return;
-            }
+    /* Listeners may subscribe or unsubscribe re-entrantly: re-resolve the
+       bucket each step and only visit listeners present at fire time. */
+    bus->fire_depth++;
+    uint32_t count = bus->buckets[bucket_idx].count;
+    for (uint32_t i = 0; i < count; ++i) {
+        Qs_Listener l = bus->buckets[bucket_idx].listeners[i];
+        if (!l.callback) continue;
+        if (l.callback(&event, l.user_data)) {
+            event.handled = true;
+            break;
         }
     }
+    if (--bus->fire_depth == 0 && bus->needs_compact)
+        event_compact_all(bus);
+}
+
+bool qs_event_post(Qs_EventBus *bus, Qs_EventId id,
+                   const void *data, uint32_t data_size)
+{
+    if (!bus || data_size > QS_EVENT_POST_MAX_DATA || (data_size && !data))
+        return false;
+
+    size_t pos = atomic_load_explicit(&bus->enqueue_pos, memory_order_relaxed);
+    Qs_EventCell *cell;
+    for (;;) {
+        cell = &bus->cells[pos & (QS_EVENT_QUEUE_CAP - 1)];
+        size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&bus->enqueue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed))
+                break;
+        } else if (diff < 0) {
+            atomic_fetch_add_explicit(&bus->dropped, 1, memory_order_relaxed);
+            return false;
+        } else {
+            pos = atomic_load_explicit(&bus->enqueue_pos, memory_order_relaxed);
+        }
+    }
+
+    cell->id        = id;
+    cell->data_size = data_size;
+    if (data_size) memcpy(cell->data, data, data_size);
+    atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+    return true;
+}
+
+void qs_event_set_coalesce(Qs_EventBus *bus, Qs_EventId id, bool coalesce)
+{
+    if (!bus) return;
+    Qs_EventBucket *b = event_bucket(bus, id, coalesce);
+    if (b) b->coalesce = coalesce;
+}
+
+void qs_event_dispatch_posted(Qs_EventBus *bus)
+{
+    if (!bus) return;
+
+    uint32_t dropped = atomic_exchange_explicit(&bus->dropped, 0, memory_order_relaxed);
+    if (dropped)
+        QS_LOG_WARN("Event queue full — %u posted events dropped", dropped);
+
+    /* Take everything published so far into the scratch batch; events
+       posted by listeners or other threads during the drain wait for the
+       next one, so a busy producer cannot stall the frame. */
+    size_t end = atomic_load_explicit(&bus->enqueue_pos, memory_order_acquire);
+    uint32_t n = 0;
+    while (bus->dequeue_pos != end) {
+        Qs_EventCell *cell = &bus->cells[bus->dequeue_pos & (QS_EVENT_QUEUE_CAP - 1)];
+        size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        if (seq != bus->dequeue_pos + 1) break;
+
+        if (n == bus->batch_cap) {
+            uint32_t new_cap = bus->batch_cap ? bus->batch_cap * 2 : 64;
+            Qs_PostedEvent *grown = realloc(bus->batch, new_cap * sizeof(Qs_PostedEvent));
+            if (!grown) break;
+            bus->batch     = grown;
+            bus->batch_cap = new_cap;
+        }
+        Qs_PostedEvent *ev = &bus->batch[n++];
+        ev->id        = cell->id;
+        ev->data_size = cell->data_size;
+        memcpy(ev->data, cell->data, cell->data_size);
+
+        atomic_store_explicit(&cell->seq, bus->dequeue_pos + QS_EVENT_QUEUE_CAP,
+                              memory_order_release);
+        bus->dequeue_pos++;
+    }
+    if (n == 0) return;
+
+    /* Coalesced IDs keep only their newest post: walk backwards and mark
+       the first occurrence seen per bucket for this drain. */
+    uint64_t serial = ++bus->drain_serial;
+    for (uint32_t i = n; i-- > 0; ) {
+        Qs_EventBucket *b = event_bucket(bus, bus->batch[i].id, false);
+        if (!b || !b->coalesce) continue;
+        if (b->coalesce_stamp == serial) bus->batch[i].id = QS_EVENT_NONE;
+        else                             b->coalesce_stamp = serial;
+    }
+
+    for (uint32_t i = 0; i < n; i++) {
+        Qs_PostedEvent *ev = &bus->batch[i];
+        if (ev->id == QS_EVENT_NONE) continue;
+        qs_event_fire(bus, ev->id, ev->data_size ? ev->data : NULL, ev->data_size);
+    }
 }
 
 /* ================================================================
@@ -416,21 +1563,45 @@ void qs_event_fire(Qs_EventBus *bus, Qs_EventId id,
 /* ── Ring buffer job queue ──────────────────────────────────── */
 
 #define QS_JOB_QUEUE_CAP 4096
+#define QS_JOB_TRACE_CAP 8192   /* events per trace ring, power of two */
 
 typedef struct {
     Qs_JobFn        fn;
     void*           data;
     Qs_JobCounter*  counter;
+    const char*     name;
+    uint32_t        id;
+    uint32_t        parent;     /* id of the job that dispatched this one, 0 = none */
 } Qs_JobEntry;
 
 typedef struct {
     Qs_JobEntry entries[QS_JOB_QUEUE_CAP];
     uint32_t    head;
     uint32_t    tail;
+    uint32_t    next_id;
     Ca_Mutex*   mutex;
     Ca_CondVar* cond;
 } Qs_JobQueue;
 
+/* ── Tracing ────────────────────────────────────────────────── */
+
+/* seq holds slot + 1 once the event is fully written, so readers can skip
+   slots that are mid-write or were overwritten while being copied. */
+typedef struct {
+    _Atomic uint64_t seq;
+    const char*      name;
+    uint64_t         start_ns;
+    uint64_t         end_ns;
+    uint32_t         id;
+    uint32_t         parent;
+} Qs_JobTraceEvent;
+
+typedef struct {
+    Qs_JobTraceEvent events[QS_JOB_TRACE_CAP];
+    _Atomic uint64_t head;      /* total events claimed */
+    _Atomic uint64_t base;      /* first event still visible after a clear */
+} Qs_JobTraceRing;
+
 /* ── Counter ────────────────────────────────────────────────── */
 
 struct Qs_JobCounter {
@@ -441,22 +1612,50 @@ struct Qs_JobCounter {
 
 /* ── Job system ─────────────────────────────────────────────── */
 
+typedef struct {
+    Qs_JobSystem*    sys;
+    Ca_Thread*       thread;
+    uint32_t         index;
+    _Atomic uint64_t idle_ns;       /* accumulated time blocked on the queue */
+    _Atomic uint64_t idle_since;    /* start of the current wait, 0 = busy */
+} Qs_JobWorker;
+
 struct Qs_JobSystem {
-    Qs_JobQueue queue;
-    Ca_Thread** threads;
-    uint32_t    num_threads;
-    volatile int running;
+    Qs_JobQueue      queue;
+    Qs_JobWorker*    workers;
+    uint32_t         num_threads;
+    volatile int     running;
+
+    /* Trace rings: one per worker plus a shared ring for waiting threads. */
+    Qs_JobTraceRing* trace_rings;
+    _Atomic bool     trace_enabled;
+    uint64_t         epoch_ns;
+
+    _Atomic uint64_t jobs_completed;
+    _Atomic uint64_t jobs_assisted;
+
+    /* Previous qs_job_stats() sample (guarded by queue.mutex). */
+    uint64_t         sample_ns;
+    uint64_t         sample_completed;
+    uint64_t         sample_assisted;
+    uint64_t         sample_idle_ns;
 };
 
+static _Thread_local const Qs_JobSystem* t_worker_owner = NULL;
+static _Thread_local uint32_t            t_worker_index = 0;
+static _Thread_local uint32_t            t_current_job  = 0;
+
 /* ── Queue operations ───────────────────────────────────────── */
 
-static bool queue_push(Qs_JobQueue* q, const Qs_JobEntry* entry) {
+static bool queue_push(Qs_JobQueue* q, Qs_JobEntry* entry) {
     ca_mutex_lock(q->mutex);
     uint32_t next = (q->head + 1) % QS_JOB_QUEUE_CAP;
     if (next == q->tail) {
         ca_mutex_unlock(q->mutex);
         return false;
     }
+    entry->id = ++q->next_id;
+    if (entry->id == 0) entry->id = ++q->next_id;
     q->entries[q->head] = *entry;
     q->head = next;
     ca_condvar_signal(q->cond);
@@ -505,8 +1704,40 @@ static void counter_decrement_and_notify(Qs_JobCounter* c) {
 
 /* ── Execute one job ────────────────────────────────────────── */
 
-static void execute_job(const Qs_JobEntry* entry) {
+static void trace_record(Qs_JobSystem* sys, const Qs_JobEntry* entry,
+                         uint64_t start_ns, uint64_t end_ns) {
+    uint32_t ring_idx = (t_worker_owner == sys) ? t_worker_index : sys->num_threads;
+    Qs_JobTraceRing* ring = &sys->trace_rings[ring_idx];
+
+    uint64_t slot = atomic_fetch_add_explicit(&ring->head, 1, memory_order_relaxed);
+    Qs_JobTraceEvent* ev = &ring->events[slot & (QS_JOB_TRACE_CAP - 1)];
+
+    atomic_store_explicit(&ev->seq, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    ev->name     = entry->name ? entry->name : "job";
+    ev->start_ns = start_ns;
+    ev->end_ns   = end_ns;
+    ev->id       = entry->id;
+    ev->parent   = entry->parent;
+    atomic_store_explicit(&ev->seq, slot + 1, memory_order_release);
+}
+
+static void execute_job(Qs_JobSystem* sys, const Qs_JobEntry* entry, bool assisted) {
+    uint32_t outer_job = t_current_job;
+    t_current_job = entry->id;
+
+    bool tracing = atomic_load_explicit(&sys->trace_enabled, memory_order_acquire);
+    uint64_t start_ns = tracing ? qs_clock_ns() : 0;
+
     entry->fn(entry->data);
+
+    if (tracing) trace_record(sys, entry, start_ns, qs_clock_ns());
+    t_current_job = outer_job;
+
+    atomic_fetch_add_explicit(&sys->jobs_completed, 1, memory_order_relaxed);
+    if (assisted)
+        atomic_fetch_add_explicit(&sys->jobs_assisted, 1, memory_order_relaxed);
+
     if (entry->counter) {
         counter_decrement_and_notify(entry->counter);
     }
@@ -515,23 +1746,32 @@ static void execute_job(const Qs_JobEntry* entry) {
 /* ── Worker thread ──────────────────────────────────────────── */
 
 static void* worker_fn(void* arg) {
-    Qs_JobSystem* sys = (Qs_JobSystem*)arg;
+    Qs_JobWorker* worker = (Qs_JobWorker*)arg;
+    Qs_JobSystem* sys = worker->sys;
     Qs_JobEntry entry;
 
+    t_worker_owner = sys;
+    t_worker_index = worker->index;
+
     while (sys->running) {
         if (queue_pop(&sys->queue, &entry)) {
-            execute_job(&entry);
+            execute_job(sys, &entry, false);
         } else {
             ca_mutex_lock(sys->queue.mutex);
             if (sys->running && sys->queue.tail == sys->queue.head) {
+                uint64_t idle_start = qs_clock_ns();
+                atomic_store_explicit(&worker->idle_since, idle_start, memory_order_relaxed);
                 ca_condvar_wait(sys->queue.cond, sys->queue.mutex);
+                atomic_store_explicit(&worker->idle_since, 0, memory_order_relaxed);
+                atomic_fetch_add_explicit(&worker->idle_ns, qs_clock_ns() - idle_start,
+                                          memory_order_relaxed);
             }
             ca_mutex_unlock(sys->queue.mutex);
         }
     }
 
     while (queue_pop(&sys->queue, &entry)) {
-        execute_job(&entry);
+        execute_job(sys, &entry, false);
     }
 
     return NULL;
@@ -579,17 +1819,23 @@ static bool job_system_init(Qs_System *system, Qs_Engine *engine)
     if (n < 1) n = 1;
     sys->num_threads = n;
 
-    sys->threads = calloc(n, sizeof(Ca_Thread *));
-    if (!sys->threads) {
+    sys->workers = calloc(n, sizeof(Qs_JobWorker));
+    if (!sys->workers) {
         ca_condvar_destroy(sys->queue.cond);
         ca_mutex_destroy(sys->queue.mutex);
         free(sys);
         return false;
     }
 
+    sys->epoch_ns  = qs_clock_ns();
+    sys->sample_ns = sys->epoch_ns;
+
     sys->running = 1;
-    for (uint32_t i = 0; i < n; ++i)
-        sys->threads[i] = ca_thread_create(worker_fn, sys);
+    for (uint32_t i = 0; i < n; ++i) {
+        sys->workers[i].sys    = sys;
+        sys->workers[i].index  = i;
+        sys->workers[i].thread = ca_thread_create(worker_fn, &sys->workers[i]);
+    }
 
     *slot = sys;
     QS_LOG_DEBUG("%u worker threads spawned", n);
@@ -610,9 +1856,10 @@ static void job_system_shutdown(Qs_System *system, Qs_Engine *engine)
     ca_mutex_unlock(sys->queue.mutex);
 
     for (uint32_t i = 0; i < sys->num_threads; ++i)
-        ca_thread_join(sys->threads[i]);
+        ca_thread_join(sys->workers[i].thread);
 
-    free(sys->threads);
+    free(sys->workers);
+    free(sys->trace_rings);
     ca_condvar_destroy(sys->queue.cond);
     ca_mutex_destroy(sys->queue.mutex);
     free(sys);
@@ -664,6 +1911,8 @@ void qs_job_dispatch(Qs_JobSystem* sys, const Qs_JobDesc* job,
         .fn      = job->fn,
         .data    = job->data,
         .counter = counter,
+        .name    = job->name,
+        .parent  = t_current_job,
     };
     if (!queue_push(&sys->queue, &entry)) {
         /* Queue full: roll back the counter increment to prevent qs_job_wait
@@ -687,7 +1936,7 @@ void qs_job_wait(Qs_JobSystem* sys, Qs_JobCounter* counter) {
     Qs_JobEntry entry;
     while (counter->value > 0) {
         if (queue_pop(&sys->queue, &entry)) {
-            execute_job(&entry);
+            execute_job(sys, &entry, true);
         } else {
             ca_mutex_lock(counter->mutex);
             if (counter->value > 0) {
@@ -702,6 +1951,137 @@ uint32_t qs_job_system_thread_count(const Qs_JobSystem* sys) {
     return sys ? sys->num_threads : 0;
 }
 
+/* ── Tracing API ────────────────────────────────────────────── */
+
+void qs_job_trace_enable(Qs_JobSystem* sys, bool enabled) {
+    if (!sys) return;
+
+    /* Rings are allocated on first enable and kept until shutdown so that
+       in-flight jobs never observe them disappearing. */
+    if (enabled && !sys->trace_rings) {
+        sys->trace_rings = calloc(sys->num_threads + 1, sizeof(Qs_JobTraceRing));
+        if (!sys->trace_rings) {
+            QS_LOG_ERROR("Job trace: failed to allocate trace rings");
+            return;
+        }
+    }
+    atomic_store_explicit(&sys->trace_enabled, enabled, memory_order_release);
+}
+
+bool qs_job_trace_enabled(const Qs_JobSystem* sys) {
+    return sys && atomic_load_explicit(&((Qs_JobSystem*)sys)->trace_enabled,
+                                       memory_order_relaxed);
+}
+
+void qs_job_trace_clear(Qs_JobSystem* sys) {
+    if (!sys || !sys->trace_rings) return;
+    for (uint32_t r = 0; r <= sys->num_threads; ++r) {
+        Qs_JobTraceRing* ring = &sys->trace_rings[r];
+        atomic_store_explicit(&ring->base,
+                              atomic_load_explicit(&ring->head, memory_order_acquire),
+                              memory_order_relaxed);
+    }
+}
+
+bool qs_job_trace_dump(Qs_JobSystem* sys, const char* path) {
+    if (!sys || !path) return false;
+
+    FILE* f = qs_trace_open(path, "ns", "Quasar Jobs");
+    if (!f) {
+        QS_LOG_ERROR("Job trace: cannot open '%s' for writing", path);
+        return false;
+    }
+
+    uint32_t written = 0;
+    for (uint32_t r = 0; r <= sys->num_threads; ++r) {
+        char thread_name[32];
+        if (r < sys->num_threads) snprintf(thread_name, sizeof(thread_name), "Worker %u", r);
+        else                      snprintf(thread_name, sizeof(thread_name), "Waiting threads");
+        qs_trace_thread_name(f, r, thread_name);
+
+        if (!sys->trace_rings) continue;
+        Qs_JobTraceRing* ring = &sys->trace_rings[r];
+        uint64_t head  = atomic_load_explicit(&ring->head, memory_order_acquire);
+        uint64_t first = atomic_load_explicit(&ring->base, memory_order_relaxed);
+        if (head - first > QS_JOB_TRACE_CAP) first = head - QS_JOB_TRACE_CAP;
+
+        for (uint64_t slot = first; slot < head; ++slot) {
+            Qs_JobTraceEvent* src = &ring->events[slot & (QS_JOB_TRACE_CAP - 1)];
+            if (atomic_load_explicit(&src->seq, memory_order_acquire) != slot + 1)
+                continue;
+            const char* name  = src->name;
+            uint64_t start_ns = src->start_ns;
+            uint64_t end_ns   = src->end_ns;
+            uint32_t id       = src->id;
+            uint32_t parent   = src->parent;
+            atomic_thread_fence(memory_order_acquire);
+            if (atomic_load_explicit(&src->seq, memory_order_relaxed) != slot + 1)
+                continue;
+
+            char args[48];
+            snprintf(args, sizeof(args), "{\"id\":%u,\"parent\":%u}", id, parent);
+            qs_trace_event(f, name, "job", r,
+                           (double)(start_ns - sys->epoch_ns) / 1000.0,
+                           (double)(end_ns - start_ns) / 1000.0, args);
+            written++;
+        }
+    }
+
+    bool ok = qs_trace_close(f);
+
+    if (ok) QS_LOG_INFO("Job trace: %u events written to '%s'", written, path);
+    else    QS_LOG_ERROR("Job trace: write to '%s' failed", path);
+    return ok;
+}
+
+/* ── Live counters ──────────────────────────────────────────── */
+
+void qs_job_stats(Qs_JobSystem* sys, Qs_JobStats* out) {
+    if (!out) return;
+    memset(out, 0, sizeof(*out));
+    if (!sys) return;
+
+    uint64_t now       = qs_clock_ns();
+    uint64_t completed = atomic_load_explicit(&sys->jobs_completed, memory_order_relaxed);
+    uint64_t assisted  = atomic_load_explicit(&sys->jobs_assisted,  memory_order_relaxed);
+
+    /* Include the in-progress wait of blocked workers so a fully idle
+       pool reports 100% before anyone wakes it. */
+    uint64_t idle_ns = 0;
+    for (uint32_t i = 0; i < sys->num_threads; ++i) {
+        Qs_JobWorker* w = &sys->workers[i];
+        idle_ns += atomic_load_explicit(&w->idle_ns, memory_order_relaxed);
+        uint64_t since = atomic_load_explicit(&w->idle_since, memory_order_relaxed);
+        if (since && now > since) idle_ns += now - since;
+    }
+
+    ca_mutex_lock(sys->queue.mutex);
+    uint32_t depth = (sys->queue.head + QS_JOB_QUEUE_CAP - sys->queue.tail) % QS_JOB_QUEUE_CAP;
+
+    uint64_t dt_ns      = now - sys->sample_ns;
+    uint64_t d_complete = completed - sys->sample_completed;
+    uint64_t d_assisted = assisted  - sys->sample_assisted;
+    uint64_t d_idle     = idle_ns > sys->sample_idle_ns ? idle_ns - sys->sample_idle_ns : 0;
+
+    sys->sample_ns        = now;
+    sys->sample_completed = completed;
+    sys->sample_assisted  = assisted;
+    sys->sample_idle_ns   = idle_ns;
+    ca_mutex_unlock(sys->queue.mutex);
+
+    out->queue_depth    = depth;
+    out->worker_count   = sys->num_threads;
+    out->jobs_completed = completed;
+    out->jobs_assisted  = assisted;
+    if (d_complete > 0)
+        out->assist_ratio = (double)d_assisted / (double)d_complete;
+    if (dt_ns > 0) {
+        out->jobs_per_second = (double)d_complete * 1e9 / (double)dt_ns;
+        double idle = (double)d_idle * 100.0 / ((double)dt_ns * (double)sys->num_threads);
+        out->idle_percent = idle > 100.0 ? 100.0 : idle;
+    }
+}
+
 /* ================================================================
    INPUT SYSTEM  (was qs_input_system.c)
    ================================================================ */
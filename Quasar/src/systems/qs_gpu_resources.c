@@ -256,11 +256,13 @@ struct Qs_Mesh {
     char           name[64];
     bool           in_use;
     Qs_GpuContext *gpu;
-    Qs_GpuBuffer  *vertex_buffer;
+    Qs_GpuBuffer  *position_buffer;
+    Qs_GpuBuffer  *attribute_buffer;
     uint32_t       vertex_count;
     Qs_GpuBuffer  *index_buffer;
     uint32_t       index_count;
     Qs_IndexType   index_type;
+    Qs_AABB        bounds;
 };
 
 typedef struct {
@@ -279,7 +281,8 @@ static void mesh_destroy_one(Qs_Mesh *m)
 {
     if (!m || !m->in_use) return;
     if (m->index_buffer)  { qs_gpu_destroy_buffer(m->gpu, m->index_buffer);  m->index_buffer  = NULL; }
-    if (m->vertex_buffer) { qs_gpu_destroy_buffer(m->gpu, m->vertex_buffer); m->vertex_buffer = NULL; }
+    if (m->position_buffer)  { qs_gpu_destroy_buffer(m->gpu, m->position_buffer);  m->position_buffer  = NULL; }
+    if (m->attribute_buffer) { qs_gpu_destroy_buffer(m->gpu, m->attribute_buffer); m->attribute_buffer = NULL; }
     m->in_use = false;
 }
 
@@ -320,7 +323,8 @@ Qs_SystemDesc qs_mesh_system_desc(void)
 Qs_Mesh *qs_mesh_create(Qs_Engine *engine, const Qs_MeshDesc *desc)
 {
     (void)engine;
-    if (!g_mesh_sys || !desc || !desc->vertices || desc->vertex_count == 0) return NULL;
+    if (!g_mesh_sys || !desc || desc->vertex_count == 0) return NULL;
+    if (!desc->vertices && (!desc->positions || !desc->attributes)) return NULL;
 
     Qs_Mesh *m = NULL;
     for (uint32_t i = 0; i < QS_MAX_MESHES; i++) {
@@ -341,12 +345,48 @@ Qs_Mesh *qs_mesh_create(Qs_Engine *engine, const Qs_MeshDesc *desc)
     if (desc->name) snprintf(m->name, sizeof(m->name), "%s", desc->name);
     else            snprintf(m->name, sizeof(m->name), "mesh_%u", g_mesh_sys->count);
 
-    const uint64_t vb_size = (uint64_t)desc->vertex_count * sizeof(Qs_Vertex);
-    m->vertex_buffer = qs_gpu_create_buffer_from_data(g_mesh_sys->gpu,
-        QS_GPU_BUFFER_VERTEX, desc->vertices, vb_size);
-    if (!m->vertex_buffer) {
-        QS_LOG_ERROR("Mesh system: failed to create vertex buffer for '%s'", m->name);
-        m->in_use = false;
+    /* Interleaved input is split into the position and attribute streams */
+    const uint32_t             vc         = desc->vertex_count;
+    const float               *positions  = desc->positions;
+    const Qs_VertexAttributes *attributes = desc->attributes;
+    float                     *split      = NULL;
+    if (desc->vertices) {
+        split = malloc((size_t)vc * sizeof(Qs_Vertex));
+        if (!split) { m->in_use = false; return NULL; }
+        Qs_VertexAttributes *attrs = (Qs_VertexAttributes *)(split + 3 * (size_t)vc);
+        for (uint32_t i = 0; i < vc; i++) {
+            const Qs_Vertex *v = &desc->vertices[i];
+            memcpy(split + 3 * (size_t)i, v->position, sizeof(v->position));
+            memcpy(attrs[i].normal,  v->normal,  sizeof(v->normal));
+            memcpy(attrs[i].tangent, v->tangent, sizeof(v->tangent));
+            memcpy(attrs[i].uv,      v->uv,      sizeof(v->uv));
+        }
+        positions  = split;
+        attributes = attrs;
+    }
+
+    if (desc->bounds) {
+        m->bounds = *desc->bounds;
+    } else {
+        memcpy(m->bounds.min, positions, sizeof(m->bounds.min));
+        memcpy(m->bounds.max, positions, sizeof(m->bounds.max));
+        for (uint32_t i = 1; i < vc; i++) {
+            const float *p = positions + 3 * (size_t)i;
+            for (int k = 0; k < 3; k++) {
+                if (p[k] < m->bounds.min[k]) m->bounds.min[k] = p[k];
+                if (p[k] > m->bounds.max[k]) m->bounds.max[k] = p[k];
+            }
+        }
+    }
+
+    m->position_buffer = qs_gpu_create_buffer_from_data(g_mesh_sys->gpu,
+        QS_GPU_BUFFER_VERTEX, positions, (uint64_t)vc * QS_VERTEX_POSITION_STRIDE);
+    m->attribute_buffer = m->position_buffer ? qs_gpu_create_buffer_from_data(g_mesh_sys->gpu,
+        QS_GPU_BUFFER_VERTEX, attributes, (uint64_t)vc * sizeof(Qs_VertexAttributes)) : NULL;
+    free(split);
+    if (!m->attribute_buffer) {
+        QS_LOG_ERROR("Mesh system: failed to create vertex buffers for '%s'", m->name);
+        mesh_destroy_one(m);
         return NULL;
     }
 
@@ -380,14 +420,18 @@ void qs_mesh_destroy(Qs_Mesh *mesh)
 const char   *qs_mesh_name        (const Qs_Mesh *m) { return m ? m->name         : NULL; }
 uint32_t      qs_mesh_vertex_count(const Qs_Mesh *m) { return m ? m->vertex_count : 0; }
 uint32_t      qs_mesh_index_count (const Qs_Mesh *m) { return m ? m->index_count  : 0; }
-Qs_GpuBuffer *qs_mesh_vertex_buffer(const Qs_Mesh *m) { return m ? m->vertex_buffer : NULL; }
+const Qs_AABB *qs_mesh_bounds     (const Qs_Mesh *m) { return m ? &m->bounds      : NULL; }
+uint32_t      qs_mesh_id          (const Qs_Mesh *m) { return m ? (uint32_t)(m - g_mesh_sys->meshes) : 0; }
+Qs_GpuBuffer *qs_mesh_position_buffer (const Qs_Mesh *m) { return m ? m->position_buffer  : NULL; }
+Qs_GpuBuffer *qs_mesh_attribute_buffer(const Qs_Mesh *m) { return m ? m->attribute_buffer : NULL; }
 Qs_GpuBuffer *qs_mesh_index_buffer (const Qs_Mesh *m) { return m ? m->index_buffer  : NULL; }
 Qs_IndexType  qs_mesh_index_type   (const Qs_Mesh *m) { return m ? m->index_type : QS_INDEX_TYPE_UINT32; }
 
 void qs_mesh_bind(const Qs_Mesh *mesh, Qs_GpuCmd *cmd)
 {
     if (!mesh || !cmd) return;
-    qs_cmd_bind_vertex_buffer(cmd, 0, mesh->vertex_buffer, 0);
+    qs_cmd_bind_vertex_buffer(cmd, 0, mesh->position_buffer, 0);
+    qs_cmd_bind_vertex_buffer(cmd, 1, mesh->attribute_buffer, 0);
     if (mesh->index_buffer)
         qs_cmd_bind_index_buffer(cmd, mesh->index_buffer,
                                   mesh->index_type == QS_INDEX_TYPE_UINT16);
@@ -417,9 +461,6 @@ void qs_mesh_draw(const Qs_Mesh *mesh, Qs_GpuCmd *cmd)
 #include <stdlib.h>
 #include <string.h>
 
-#define QS_MAX_MATERIALS     256
-#define QS_PBR_BINDING_COUNT   5
-
 struct Qs_Material {
     char                 name[64];
     bool                 in_use;
@@ -433,6 +474,7 @@ struct Qs_Material {
     Qs_AlphaMode         alpha_mode;
     bool                 double_sided;
     Qs_GpuDescriptorSet *descriptor_set;
+    uint32_t             version;
 };
 
 typedef struct {
@@ -441,9 +483,13 @@ typedef struct {
     uint32_t                   count;
     Qs_GpuDescriptorSetLayout *set_layout;
     Qs_GpuDescriptorPool      *desc_pool;
+    Qs_GpuDescriptorSetLayout *bindless_layout;  /* NULL without descriptor indexing */
+    Qs_GpuDescriptorPool      *bindless_pool;
+    Qs_GpuDescriptorSet       *bindless_set;
     Qs_Texture                *default_white;
     Qs_Texture                *default_normal;
     Qs_Texture                *default_black;
+    uint32_t                   version_counter;
 } MaterialSystemData;
 
 static MaterialSystemData *g_material_sys;
@@ -454,8 +500,8 @@ static MaterialSystemData *g_material_sys;
 
 static bool create_descriptor_layout(void)
 {
-    Qs_GpuDescriptorBinding bindings[QS_PBR_BINDING_COUNT];
-    for (uint32_t i = 0; i < QS_PBR_BINDING_COUNT; i++) {
+    Qs_GpuDescriptorBinding bindings[QS_MATERIAL_TEXTURE_SLOTS];
+    for (uint32_t i = 0; i < QS_MATERIAL_TEXTURE_SLOTS; i++) {
         bindings[i] = (Qs_GpuDescriptorBinding){
             .binding = i,
             .type    = QS_GPU_DESCRIPTOR_COMBINED_IMAGE_SAMPLER,
@@ -464,7 +510,7 @@ static bool create_descriptor_layout(void)
         };
     }
     g_material_sys->set_layout = qs_gpu_create_descriptor_set_layout(
-        g_material_sys->gpu, bindings, QS_PBR_BINDING_COUNT);
+        g_material_sys->gpu, bindings, QS_MATERIAL_TEXTURE_SLOTS);
     return g_material_sys->set_layout != NULL;
 }
 
@@ -472,7 +518,7 @@ static bool create_descriptor_pool(void)
 {
     Qs_GpuDescriptorPoolSize pool_size = {
         .type  = QS_GPU_DESCRIPTOR_COMBINED_IMAGE_SAMPLER,
-        .count = QS_MAX_MATERIALS * QS_PBR_BINDING_COUNT,
+        .count = QS_MAX_MATERIALS * QS_MATERIAL_TEXTURE_SLOTS,
     };
     g_material_sys->desc_pool = qs_gpu_create_descriptor_pool(
         g_material_sys->gpu, &(Qs_GpuDescriptorPoolDesc){
@@ -483,6 +529,41 @@ static bool create_descriptor_pool(void)
     return g_material_sys->desc_pool != NULL;
 }
 
+/* One partially bound, update-after-bind sampler array holding every
+   material's textures.  Failure only disables the bindless path. */
+static bool create_bindless_set(void)
+{
+    MaterialSystemData *d = g_material_sys;
+    const uint32_t count = QS_MAX_MATERIALS * QS_MATERIAL_TEXTURE_SLOTS;
+    d->bindless_layout = qs_gpu_create_descriptor_set_layout(d->gpu,
+        &(Qs_GpuDescriptorBinding){
+            .binding = 0,
+            .type    = QS_GPU_DESCRIPTOR_COMBINED_IMAGE_SAMPLER,
+            .count   = count,
+            .stages  = QS_GPU_SHADER_FRAGMENT,
+            .flags   = QS_GPU_DESCRIPTOR_PARTIALLY_BOUND | QS_GPU_DESCRIPTOR_UPDATE_AFTER_BIND,
+        }, 1);
+    d->bindless_pool = qs_gpu_create_descriptor_pool(d->gpu, &(Qs_GpuDescriptorPoolDesc){
+        .sizes = &(Qs_GpuDescriptorPoolSize){
+            .type  = QS_GPU_DESCRIPTOR_COMBINED_IMAGE_SAMPLER,
+            .count = count,
+        },
+        .size_count        = 1,
+        .max_sets          = 1,
+        .update_after_bind = true,
+    });
+    if (d->bindless_layout && d->bindless_pool)
+        d->bindless_set = qs_gpu_alloc_descriptor_set(d->gpu, d->bindless_pool,
+                                                      d->bindless_layout);
+    if (d->bindless_set) return true;
+
+    qs_gpu_destroy_descriptor_pool(d->gpu, d->bindless_pool);
+    qs_gpu_destroy_descriptor_set_layout(d->gpu, d->bindless_layout);
+    d->bindless_pool   = NULL;
+    d->bindless_layout = NULL;
+    return false;
+}
+
 /* ================================================================
    DEFAULT FALLBACK TEXTURES
    ================================================================ */
@@ -503,10 +584,21 @@ static Qs_Texture *create_1x1_texture(Qs_Engine *engine, const char *name,
    DESCRIPTOR SET WRITE
    ================================================================ */
 
+static void write_texture(Qs_Material *m, uint32_t slot, Qs_Texture *tex)
+{
+    Qs_GpuSampler   *sampler = qs_texture_sampler(tex);
+    Qs_GpuImageView *view    = qs_texture_image_view(tex);
+    qs_gpu_write_image_descriptor(m->gpu, m->descriptor_set, slot, sampler, view);
+    if (g_material_sys->bindless_set)
+        qs_gpu_write_image_array_descriptor(m->gpu, g_material_sys->bindless_set, 0,
+                                            qs_material_id(m) * QS_MATERIAL_TEXTURE_SLOTS + slot,
+                                            sampler, view);
+}
+
 static void write_descriptor_set(Qs_Material *m)
 {
     struct { Qs_Texture *tex; Qs_Texture *fallback; }
-        slots[QS_PBR_BINDING_COUNT] = {
+        slots[QS_MATERIAL_TEXTURE_SLOTS] = {
             { m->base_color_texture,         g_material_sys->default_white  },
             { m->metallic_roughness_texture, g_material_sys->default_white  },
             { m->normal_texture,             g_material_sys->default_normal },
@@ -514,12 +606,8 @@ static void write_descriptor_set(Qs_Material *m)
             { m->emissive_texture,           g_material_sys->default_black  },
         };
 
-    for (uint32_t i = 0; i < QS_PBR_BINDING_COUNT; i++) {
-        Qs_Texture *tex = slots[i].tex ? slots[i].tex : slots[i].fallback;
-        qs_gpu_write_image_descriptor(m->gpu, m->descriptor_set, i,
-                                       qs_texture_sampler(tex),
-                                       qs_texture_image_view(tex));
-    }
+    for (uint32_t i = 0; i < QS_MATERIAL_TEXTURE_SLOTS; i++)
+        write_texture(m, i, slots[i].tex ? slots[i].tex : slots[i].fallback);
 }
 
 /* ================================================================
@@ -556,6 +644,9 @@ static bool material_sys_init(Qs_System *sys, Qs_Engine *engine)
         return false;
     }
 
+    if (qs_gpu_descriptor_indexing_enabled(data->gpu) && !create_bindless_set())
+        QS_LOG_WARN("Material system: bindless texture set unavailable, using per-material sets");
+
     data->default_white  = create_1x1_texture(engine, "_default_white",  255, 255, 255, 255);
     data->default_normal = create_1x1_texture(engine, "_default_normal", 128, 128, 255, 255);
     data->default_black  = create_1x1_texture(engine, "_default_black",    0,   0,   0, 255);
@@ -583,6 +674,8 @@ static void material_sys_shutdown(Qs_System *sys, Qs_Engine *engine)
     if (data->default_normal) qs_texture_destroy(data->default_normal);
     if (data->default_black)  qs_texture_destroy(data->default_black);
 
+    if (data->bindless_pool)   qs_gpu_destroy_descriptor_pool(data->gpu, data->bindless_pool);
+    if (data->bindless_layout) qs_gpu_destroy_descriptor_set_layout(data->gpu, data->bindless_layout);
     if (data->desc_pool)  qs_gpu_destroy_descriptor_pool(data->gpu, data->desc_pool);
     if (data->set_layout) qs_gpu_destroy_descriptor_set_layout(data->gpu, data->set_layout);
 
@@ -664,6 +757,7 @@ Qs_Material *qs_material_create(Qs_Engine *engine, const Qs_MaterialDesc *desc)
     }
 
     write_descriptor_set(m);
+    m->version = ++g_material_sys->version_counter;
 
     g_material_sys->count++;
     QS_LOG_INFO("Material system: '%s' created", m->name);
@@ -701,14 +795,34 @@ bool qs_material_double_sided(const Qs_Material *m)
     return m ? m->double_sided : false;
 }
 
+uint32_t qs_material_version(const Qs_Material *m)
+{
+    return m ? m->version : 0;
+}
+
+uint32_t qs_material_id(const Qs_Material *m)
+{
+    return m ? (uint32_t)(m - g_material_sys->materials) : 0;
+}
+
 Qs_GpuDescriptorSetLayout *qs_material_set_layout(void)
 {
     return g_material_sys ? g_material_sys->set_layout : NULL;
 }
 
+Qs_GpuDescriptorSet *qs_material_bindless_set(void)
+{
+    return g_material_sys ? g_material_sys->bindless_set : NULL;
+}
+
+Qs_GpuDescriptorSetLayout *qs_material_bindless_set_layout(void)
+{
+    return g_material_sys ? g_material_sys->bindless_layout : NULL;
+}
+
 void qs_material_set_texture(Qs_Material *mat, uint32_t slot, Qs_Texture *tex)
 {
-    if (!mat || !mat->in_use || !g_material_sys || slot >= QS_PBR_BINDING_COUNT)
+    if (!mat || !mat->in_use || !g_material_sys || slot >= QS_MATERIAL_TEXTURE_SLOTS)
         return;
 
     Qs_Texture **stored[] = {
@@ -727,10 +841,7 @@ void qs_material_set_texture(Qs_Material *mat, uint32_t slot, Qs_Texture *tex)
         g_material_sys->default_white,
         g_material_sys->default_black,
     };
-    Qs_Texture *actual = tex ? tex : fallbacks[slot];
-    qs_gpu_write_image_descriptor(mat->gpu, mat->descriptor_set, slot,
-                                   qs_texture_sampler(actual),
-                                   qs_texture_image_view(actual));
+    write_texture(mat, slot, tex ? tex : fallbacks[slot]);
 
     /* Update has_*_tex flags in PBR params */
     uint32_t *has_flags[] = {
@@ -741,11 +852,12 @@ void qs_material_set_texture(Qs_Material *mat, uint32_t slot, Qs_Texture *tex)
         &mat->params.has_emissive_tex,
     };
     *has_flags[slot] = (tex != NULL) ? 1 : 0;
+    mat->version = ++g_material_sys->version_counter;
 }
 
 Qs_Texture *qs_material_get_texture(const Qs_Material *mat, uint32_t slot)
 {
-    if (!mat || !mat->in_use || slot >= QS_PBR_BINDING_COUNT) return NULL;
+    if (!mat || !mat->in_use || slot >= QS_MATERIAL_TEXTURE_SLOTS) return NULL;
     const Qs_Texture * const stored[] = {
         mat->base_color_texture,
         mat->metallic_roughness_texture,
@@ -771,6 +883,7 @@ void qs_material_update_params(Qs_Material *mat, const Qs_PBRParams *params)
     mat->params.has_normal_tex             = has_norm;
     mat->params.has_occlusion_tex          = has_occ;
     mat->params.has_emissive_tex           = has_emit;
+    if (g_material_sys) mat->version = ++g_material_sys->version_counter;
 }
 
 uint32_t qs_material_count(void)
@@ -797,13 +910,14 @@ Qs_Material *qs_material_at(uint32_t index)
 
 #include "qs_light.h"
 #include "qs_math.h"
+#include "qs_renderer.h"
 #include "qs_system.h"
 #include "qs_log.h"
 #include <math.h>
 #include <stdio.h>
 #include <string.h>
 
-#define QS_MAX_LIGHTS 256
+#define QS_MAX_LIGHTS QS_LIGHTS_MAX
 
 struct Qs_Light {
     char         name[64];
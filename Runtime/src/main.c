@@ -1,11 +1,13 @@
 #include "quasar.h"
 
 static Ca_Viewport *s_vp;
+static Qs_Renderer *s_renderer;
 
 static void on_frame(Qs_Engine *engine, void *userdata)
 {
     (void)engine;
     (void)userdata;
+    qs_renderer_publish(s_renderer);
     ca_viewport_request_redraw(s_vp);
 }
 
@@ -21,7 +23,7 @@ int main(void)
     });
     if (!engine) return 1;
 
-    Qs_Renderer *renderer = qs_renderer_create(engine, &(Qs_RendererDesc){
+    s_renderer = qs_renderer_create(engine, &(Qs_RendererDesc){
         .name        = "main",
         .clear_color = { 0.05f, 0.05f, 0.10f, 1.0f },
         .depth_test  = true,
@@ -31,7 +33,7 @@ int main(void)
         .direction = CA_VERTICAL,
     });
     s_vp = ca_viewport(&(Ca_ViewportDesc){ 0 });
-    qs_renderer_bind(renderer, (Qs_Viewport *)s_vp);
+    qs_renderer_bind(s_renderer, (Qs_Viewport *)s_vp);
     ca_ui_end();
 
     qs_engine_set_on_frame(engine, on_frame, NULL);
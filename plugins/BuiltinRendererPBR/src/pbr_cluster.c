@@ -0,0 +1,342 @@
+/*
+ * pbr_cluster.c — Clustered light binning.
+ *
+ * CPU-only helpers used by the prepare pass.  The view frustum is cut
+ * into PBR_CLUSTER_X x PBR_CLUSTER_Y screen tiles and PBR_CLUSTER_Z depth
+ * slices spaced exponentially from the near to the far plane.  Every
+ * point and spot light with a range is bounded by a view-space sphere;
+ * the sphere's conservative tile and slice range is narrowed row by row
+ * with a sphere / box test over the row's cluster boxes, several boxes
+ * per SIMD iteration.  Directional and unbounded lights are global: the
+ * forward shader applies them to every pixel.  CLUSTER_COMP in
+ * pbr_forward.c is the GPU version of the cluster test.
+ */
+
+#include "pbr_internal.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__AVX__)
+  #include <immintrin.h>
+  #define PBR_CLUSTER_AVX 1
+  #define PBR_CLUSTER_LANES 8
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #include <emmintrin.h>
+  #define PBR_CLUSTER_SSE2 1
+  #define PBR_CLUSTER_LANES 4
+#elif defined(__aarch64__) || defined(_M_ARM64)
+  #include <arm_neon.h>
+  #define PBR_CLUSTER_NEON 1
+  #define PBR_CLUSTER_LANES 4
+#else
+  #define PBR_CLUSTER_LANES 1
+#endif
+
+/* ================================================================
+   GRID SETUP
+   ================================================================ */
+
+/* View depth of the near boundary of slice k; slice 0 reaches back to
+   the camera plane. */
+static float slice_depth(const PbrLightGrid *g, uint32_t k)
+{
+    if (k == 0) return 0.0f;
+    return g->z_near * powf(g->z_far / g->z_near, (float)k / (float)PBR_CLUSTER_Z);
+}
+
+/* Extent of the view-space coordinate ndc * w / scale for ndc in
+   [n0, n1] and w in [w0, w1]. */
+static void tile_span(float n0, float n1, float scale, float w0, float w1,
+                      float *center, float *extent)
+{
+    float a = n0 * w0 / scale, b = n1 * w0 / scale;
+    float c = n0 * w1 / scale, d = n1 * w1 / scale;
+    float lo = fminf(fminf(a, b), fminf(c, d));
+    float hi = fmaxf(fmaxf(a, b), fmaxf(c, d));
+    *center = (lo + hi) * 0.5f;
+    *extent = (hi - lo) * 0.5f;
+}
+
+void pbr_light_grid_setup(PbrLightGrid *g, const float proj[16])
+{
+    const float key[5] = { proj[0], proj[5], proj[10], proj[11], proj[14] };
+    if (g->ready && memcmp(g->key, key, sizeof(key)) == 0) return;
+    memcpy(g->key, key, sizeof(key));
+    g->ready = true;
+
+    /* Near and far planes back out of the depth terms */
+    bool  ortho = proj[11] == 0.0f;
+    float near_p, far_p;
+    if (ortho) {
+        near_p = (proj[14] + 1.0f) / proj[10];
+        far_p  = (proj[14] - 1.0f) / proj[10];
+    } else {
+        near_p = proj[14] / (proj[10] - 1.0f);
+        far_p  = proj[14] / (proj[10] + 1.0f);
+    }
+    g->ortho      = ortho;
+    g->near_plane = near_p;
+    g->z_near     = fmaxf(near_p, PBR_CLUSTER_DEPTH_MIN);
+    g->z_far      = fmaxf(far_p, g->z_near * 2.0f);
+    float log_range = logf(g->z_far / g->z_near);
+    g->header.z_scale = (float)PBR_CLUSTER_Z / log_range;
+    g->header.z_bias  = -(float)PBR_CLUSTER_Z * logf(g->z_near) / log_range;
+
+    const float tile_w = 2.0f / (float)PBR_CLUSTER_X;
+    const float tile_h = 2.0f / (float)PBR_CLUSTER_Y;
+    for (uint32_t z = 0; z < PBR_CLUSTER_Z; z++) {
+        float d0 = slice_depth(g, z), d1 = slice_depth(g, z + 1);
+        float w0 = ortho ? 1.0f : d0, w1 = ortho ? 1.0f : d1;
+        for (uint32_t y = 0; y < PBR_CLUSTER_Y; y++) {
+            float ny = -1.0f + tile_h * (float)y;
+            for (uint32_t x = 0; x < PBR_CLUSTER_X; x++) {
+                uint32_t c  = (z * PBR_CLUSTER_Y + y) * PBR_CLUSTER_X + x;
+                float    nx = -1.0f + tile_w * (float)x;
+                tile_span(nx, nx + tile_w, proj[0], w0, w1, &g->box[0][c], &g->box[3][c]);
+                tile_span(ny, ny + tile_h, proj[5], w0, w1, &g->box[1][c], &g->box[4][c]);
+                g->box[2][c] = -(d0 + d1) * 0.5f;
+                g->box[5][c] =  (d1 - d0) * 0.5f;
+            }
+        }
+    }
+}
+
+/* ================================================================
+   LIGHT BOUNDS
+   ================================================================ */
+
+/* World-space bounding sphere of a light's reach.  A spot light is
+   bounded by the smallest sphere around its cone (apex plus cap) when
+   the cone is narrower than a hemisphere.  False for global lights. */
+static bool light_sphere(const Qs_LightGPU *l, float out[4])
+{
+    if (l->type == (uint32_t)QS_LIGHT_DIRECTIONAL || !(l->range > 0.0f)) return false;
+    float r = l->range;
+    float c[3] = { l->position[0], l->position[1], l->position[2] };
+    const float *dir = l->direction;
+    float len = sqrtf(dir[0]*dir[0] + dir[1]*dir[1] + dir[2]*dir[2]);
+    float ca  = l->outer_cone_cos;
+    if (l->type == (uint32_t)QS_LIGHT_SPOT && ca > 0.0f && len > 0.0f) {
+        float t;
+        if (ca < 0.70710678f) {
+            t  = r * ca;
+            r *= sqrtf(1.0f - ca * ca);
+        } else {
+            r /= 2.0f * ca;
+            t  = r;
+        }
+        for (int k = 0; k < 3; k++) c[k] += dir[k] / len * t;
+    }
+    out[0] = c[0]; out[1] = c[1]; out[2] = c[2]; out[3] = r;
+    return true;
+}
+
+/* ================================================================
+   ROW KERNEL
+   A cluster meets the sphere when the squared distance from the
+   sphere centre to its box, sum of max(|c - s| - e, 0)^2 over the
+   axes, is within r^2.  One bit per box of the row.
+   ================================================================ */
+
+#if PBR_CLUSTER_AVX
+
+static uint32_t lane_mask(const PbrLightGrid *g, uint32_t i, const float s[4])
+{
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    const __m256 zero = _mm256_setzero_ps();
+    __m256 d2 = zero;
+    for (int k = 0; k < 3; k++) {
+        __m256 d = _mm256_sub_ps(_mm256_andnot_ps(sign,
+                       _mm256_sub_ps(_mm256_loadu_ps(g->box[k] + i), _mm256_set1_ps(s[k]))),
+                       _mm256_loadu_ps(g->box[3 + k] + i));
+        d  = _mm256_max_ps(d, zero);
+        d2 = _mm256_add_ps(d2, _mm256_mul_ps(d, d));
+    }
+    return (uint32_t)_mm256_movemask_ps(
+        _mm256_cmp_ps(d2, _mm256_set1_ps(s[3] * s[3]), _CMP_LE_OQ));
+}
+
+#elif PBR_CLUSTER_SSE2
+
+static uint32_t lane_mask(const PbrLightGrid *g, uint32_t i, const float s[4])
+{
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    const __m128 zero = _mm_setzero_ps();
+    __m128 d2 = zero;
+    for (int k = 0; k < 3; k++) {
+        __m128 d = _mm_sub_ps(_mm_andnot_ps(sign,
+                       _mm_sub_ps(_mm_loadu_ps(g->box[k] + i), _mm_set1_ps(s[k]))),
+                       _mm_loadu_ps(g->box[3 + k] + i));
+        d  = _mm_max_ps(d, zero);
+        d2 = _mm_add_ps(d2, _mm_mul_ps(d, d));
+    }
+    return (uint32_t)_mm_movemask_ps(_mm_cmple_ps(d2, _mm_set1_ps(s[3] * s[3])));
+}
+
+#elif PBR_CLUSTER_NEON
+
+static uint32_t lane_mask(const PbrLightGrid *g, uint32_t i, const float s[4])
+{
+    float32x4_t d2 = vdupq_n_f32(0.0f);
+    for (int k = 0; k < 3; k++) {
+        float32x4_t d = vsubq_f32(vabdq_f32(vld1q_f32(g->box[k] + i), vdupq_n_f32(s[k])),
+                                  vld1q_f32(g->box[3 + k] + i));
+        d  = vmaxq_f32(d, vdupq_n_f32(0.0f));
+        d2 = vmlaq_f32(d2, d, d);
+    }
+    static const uint32_t bits[4] = { 1, 2, 4, 8 };
+    uint32x4_t inside = vcleq_f32(d2, vdupq_n_f32(s[3] * s[3]));
+    return vaddvq_u32(vandq_u32(inside, vld1q_u32(bits)));
+}
+
+#else
+
+static uint32_t lane_mask(const PbrLightGrid *g, uint32_t i, const float s[4])
+{
+    float d2 = 0.0f;
+    for (int k = 0; k < 3; k++) {
+        float d = fmaxf(fabsf(g->box[k][i] - s[k]) - g->box[3 + k][i], 0.0f);
+        d2 += d * d;
+    }
+    return d2 <= s[3] * s[3] ? 1u : 0u;
+}
+
+#endif
+
+static uint32_t row_mask(const PbrLightGrid *g, uint32_t row, const float s[4])
+{
+    uint32_t mask = 0;
+    for (uint32_t x = 0; x < PBR_CLUSTER_X; x += PBR_CLUSTER_LANES)
+        mask |= lane_mask(g, row + x, s) << x;
+    return mask;
+}
+
+/* ================================================================
+   BINNING
+   ================================================================ */
+
+static bool grow(uint32_t **array, uint32_t *capacity, uint32_t count)
+{
+    if (*array && count <= *capacity) return true;
+    uint32_t cap = *capacity ? *capacity : PBR_DRAW_INITIAL_CAPACITY;
+    while (cap < count) cap *= 2;
+    uint32_t *grown = realloc(*array, cap * sizeof(uint32_t));
+    if (!grown) return false;
+    *array    = grown;
+    *capacity = cap;
+    return true;
+}
+
+/* Slice holding view depth d, clamped to the grid. */
+static uint32_t depth_slice(const PbrLightGrid *g, float d)
+{
+    if (d <= g->z_near) return 0;
+    float s = floorf(logf(d) * g->header.z_scale + g->header.z_bias);
+    return s >= (float)(PBR_CLUSTER_Z - 1) ? PBR_CLUSTER_Z - 1 : (uint32_t)s;
+}
+
+/* Tiles [*t0, *t1] covered by the NDC projections (scale * v / w) of
+   view coordinates [c - r, c + r] at divisors w in [w0, w1].  False
+   when the span misses the screen. */
+static bool tile_range(float c, float r, float scale, float w0, float w1,
+                       uint32_t tiles, uint32_t *t0, uint32_t *t1)
+{
+    float a  = scale * (c - r), b = scale * (c + r);
+    float lo = fminf(a, b), hi = fmaxf(a, b);
+    lo /= lo < 0.0f ? w0 : w1;
+    hi /= hi > 0.0f ? w0 : w1;
+    if (hi < -1.0f || lo > 1.0f) return false;
+    float n = (float)tiles;
+    float f0 = floorf((lo + 1.0f) * 0.5f * n), f1 = floorf((hi + 1.0f) * 0.5f * n);
+    *t0 = f0 <= 0.0f ? 0 : (uint32_t)f0;
+    *t1 = f1 >= n - 1.0f ? tiles - 1 : (uint32_t)f1;
+    return true;
+}
+
+/* Appends a pair per cluster of its tile and slice range the sphere
+   meets.  The pair array holds room for the whole range. */
+static void bin_sphere(PbrLightGrid *g, const float s[4], uint32_t light)
+{
+    float d = -s[2];
+    if (d + s[3] <= 0.0f || d - s[3] > g->z_far) return;
+
+    uint32_t x0, x1, y0, y1;
+    float w0 = g->ortho ? 1.0f : fmaxf(d - s[3], g->near_plane);
+    float w1 = g->ortho ? 1.0f : d + s[3];
+    if (!tile_range(s[0], s[3], g->key[0], w0, w1, PBR_CLUSTER_X, &x0, &x1) ||
+        !tile_range(s[1], s[3], g->key[1], w0, w1, PBR_CLUSTER_Y, &y0, &y1))
+        return;
+
+    uint32_t z1 = depth_slice(g, d + s[3]);
+    for (uint32_t z = depth_slice(g, d - s[3]); z <= z1; z++) {
+        for (uint32_t y = y0; y <= y1; y++) {
+            uint32_t row  = (z * PBR_CLUSTER_Y + y) * PBR_CLUSTER_X;
+            uint32_t mask = row_mask(g, row, s);
+            for (uint32_t x = x0; x <= x1; x++)
+                if (mask >> x & 1u)
+                    g->pairs[g->pair_count++] = (row + x) << 16 | light;
+        }
+    }
+}
+
+bool pbr_light_grid_build(PbrLightGrid *g, const float view[16],
+                          const Qs_LightGPU *lights, uint32_t light_count,
+                          bool clusters)
+{
+    PbrLightGridHeader *h = &g->header;
+    if (!grow(&g->indices, &g->index_capacity, light_count)) return false;
+
+    g->pair_count = 0;
+    h->global_count = 0;
+    for (uint32_t i = 0; i < light_count; i++) {
+        float s[4];
+        if (!light_sphere(&lights[i], s)) {
+            g->indices[h->global_count++] = i;
+            continue;
+        }
+        if (!clusters) continue;
+        if (!grow(&g->pairs, &g->pair_capacity, g->pair_count + PBR_CLUSTER_COUNT))
+            return false;
+        float v[4] = {
+            view[0]*s[0] + view[4]*s[1] + view[8]*s[2]  + view[12],
+            view[1]*s[0] + view[5]*s[1] + view[9]*s[2]  + view[13],
+            view[2]*s[0] + view[6]*s[1] + view[10]*s[2] + view[14],
+            s[3],
+        };
+        bin_sphere(g, v, i);
+    }
+    g->index_count = h->global_count;
+    if (!clusters) return true;
+
+    /* Counting sort by cluster; pairs arrive in light order, so every
+       cluster lists its lights ascending */
+    if (!grow(&g->indices, &g->index_capacity, h->global_count + g->pair_count))
+        return false;
+    memset(h->clusters, 0, sizeof(h->clusters));
+    for (uint32_t k = 0; k < g->pair_count; k++)
+        h->clusters[g->pairs[k] >> 16][1]++;
+    uint32_t first = h->global_count;
+    for (uint32_t c = 0; c < PBR_CLUSTER_COUNT; c++) {
+        h->clusters[c][0] = first;
+        first += h->clusters[c][1];
+        h->clusters[c][1] = 0;
+    }
+    for (uint32_t k = 0; k < g->pair_count; k++) {
+        uint32_t *range = h->clusters[g->pairs[k] >> 16];
+        g->indices[range[0] + range[1]++] = g->pairs[k] & 0xFFFFu;
+    }
+    g->index_count = first;
+    return true;
+}
+
+void pbr_light_grid_free(PbrLightGrid *g)
+{
+    free(g->indices);
+    free(g->pairs);
+    g->indices = g->pairs = NULL;
+    g->index_count = g->index_capacity = 0;
+    g->pair_count  = g->pair_capacity  = 0;
+    g->ready = false;
+}
@@ -2,21 +2,47 @@
  * pbr_forward.c  --  Forward+ renderer passes for the PBR backend.
  *
  * Pass layout (priority order):
+ *   Prepare (priority -100): light clustering, GPU scene upload,
+ *                            per-cascade caster selection, sort + batch
+ *                            draws, frustum / early occlusion cull into
+ *                            indirect commands (compute, or CPU reference)
  *   Pass 0 (priority   0):  CSM shadow depth  (QS_CSM_CASCADES cascades)
- *   Pass 1 (priority 100):  Forward lit        (PBR GGX + CSM shadows)
- *   Pass 2 (priority 200):  Bloom              (Kawase downsample + tent up)
+ *   Pass 1 (priority 100):  Forward lit        (optional opaque depth pre-pass,
+ *                                               then PBR GGX + CSM shadows;
+ *                                               with occlusion culling, Hi-Z
+ *                                               build and late cull before
+ *                                               the late and blended draws)
+ *   Pass 2a (priority 200): Bloom downsample   (Kawase, HDR -> bloom[0])
+ *   Pass 2b (priority 250): Bloom upsample     (tent, bloom[0] -> bloom[1])
  *   Pass 3 (priority 300):  Composite          (ACES tonemap + vignette -> swapchain)
+ * Passes 0-3 declare their attachment accesses; the engine render graph
+ * records all attachment layout transitions between them.
  *
  * Descriptor layout:
  *   set=0  binding 0  UNIFORM_BUFFER           FrameUBO   (engine-written)
- *   set=0  binding 1  UNIFORM_BUFFER           LightsUBO  (engine-written)
+ *   set=0  binding 1  STORAGE_BUFFER           LightsBuffer (engine-written)
  *   set=0  binding 2  UNIFORM_BUFFER           ShadowUBO  (plugin-written, CSM data)
  *   set=0  binding 3-5 COMBINED_IMAGE_SAMPLER  shadow maps [3]
- *   set=1  material textures  (5 COMBINED_IMAGE_SAMPLER via qs_material_set_layout)
+ *   set=0  binding 6  STORAGE_BUFFER           PbrGpuObject[] (GPU scene)
+ *   set=0  binding 7  STORAGE_BUFFER           visible object indices (cull output)
+ *   set=0  binding 8  STORAGE_BUFFER           light grid (cluster ranges + light indices)
+ *   set=0  binding 9  STORAGE_BUFFER           PbrGpuMaterial[] by material id (bindless only)
+ *   set=1  material textures  (5 COMBINED_IMAGE_SAMPLER via qs_material_set_layout, or
+ *                              with descriptor indexing the sampler array of
+ *                              qs_material_bindless_set, bound once per pass)
+ *   cull   binding 0-4 STORAGE_BUFFER          objects, items, commands, visible,
+ *                                              Hi-Z pyramid (late cull only)
+ *   hiz    binding 0  COMBINED_IMAGE_SAMPLER   forward depth
+ *   hiz    binding 1  STORAGE_BUFFER           Hi-Z pyramid
+ *   cluster binding 0-1 STORAGE_BUFFER         lights, light grid
  *
- * Engine now owns:  depth buffer, frame_ubo, lights_ubo, HDR attachment,
- *                   bloom attachments, shadow map attachments.
- * Plugin owns:      pipelines, descriptor sets, shadow_ubo, CSM matrices.
+ * Engine now owns:  depth buffer, per-slot frame_ubo / lights_buffer, frame
+ *                   arena, HDR and bloom attachments (transient: aliased
+ *                   in one heap), persistent shadow map attachments.
+ * Plugin owns:      pipelines, per-slot descriptor sets, CSM matrices and
+ *                   schedule, static shadow caches, GPU scene, draw staging,
+ *                   light grid, Hi-Z pyramid.  The shadow UBO, light grid and draw
+ *                   buffers are allocated from the frame arena.
  */
 
 #include "qs_renderer.h"
@@ -25,7 +51,9 @@
 #include "qs_material.h"
 #include "qs_light.h"
 #include "qs_log.h"
+#include "quasar.h"
 #include "pbr_internal.h"
+#include "pbr_fxaa.h"
 
 #include <string.h>
 #include <math.h>
@@ -35,6 +63,11 @@ static PbrPostProcessSettings g_pp_settings = {
     .bloom_strength    = 0.04f,
     .vignette_strength = 0.35f,
     .msaa_sample_count = PBR_MSAA_SAMPLES,
+    .gpu_culling       = true,
+    .occlusion_culling = true,
+    .gpu_light_binning = false,
+    .depth_prepass     = PBR_DEPTH_PREPASS_AUTO,
+    .anti_aliasing     = PBR_AA_MSAA,
 };
 
 PbrPostProcessSettings *pbr_post_process_settings(void) { return &g_pp_settings; }
@@ -50,20 +83,44 @@ PbrPostProcessSettings *pbr_post_process_settings(void) { return &g_pp_settings;
 
 typedef struct {
     float cascade_vp[QS_CSM_CASCADES][16];
-    float cascade_splits[QS_CSM_CASCADES];
-    float _pad;
 } ShadowUBO;
 
-/* Material params pushed at offset 64 (fragment stage), total push constant = 112 bytes */
 typedef struct {
-    float base_color_factor[4];  /* offset  0 rel (abs  64), 16 bytes */
-    float metallic_factor;       /* offset 16 rel (abs  80) */
-    float roughness_factor;      /* offset 20 rel (abs  84) */
-    float normal_scale;          /* offset 24 rel (abs  88) */
-    float occlusion_strength;    /* offset 28 rel (abs  92) */
-    float emissive_factor[3];    /* offset 32 rel (abs  96), 12 bytes */
-    float alpha_cutoff;          /* offset 44 rel (abs 108) */
-} FwdMatPC;                      /* total: 48 bytes */
+    int32_t cascade_idx;
+    int32_t _p[3];
+} ShadowPC;
+
+typedef struct {
+    float    planes[6][4];   /* camera frustum, Qs_Frustum order */
+    uint32_t item_count;
+    uint32_t _p[3];
+} CullPC;                    /* total: 112 bytes */
+
+typedef struct {
+    uint32_t src[2], dst[2]; /* level sizes; src is the depth buffer for level 0 */
+    uint32_t src_offset;
+    uint32_t dst_offset;
+    uint32_t samples;        /* MSAA depth samples (seed only) */
+    uint32_t _p;
+} HiZPC;                     /* total: 32 bytes */
+
+typedef struct {
+    float    view_proj[16];
+    uint32_t item_count;
+    uint32_t first_item;     /* forward items start here in the item buffer */
+    uint32_t first_command;  /* command of forward batch 0 */
+    uint32_t late_shift;
+    uint32_t depth_size[2];
+    uint32_t levels;
+    uint32_t _p;
+} OcclusionPC;               /* total: 96 bytes */
+
+typedef struct {
+    float    view[16];
+    float    proj[4];        /* x, y scale; slicing near, far */
+    uint32_t ortho;
+    uint32_t _p[3];
+} ClusterPC;                 /* total: 96 bytes */
 
 /* ================================================================
    GLSL SHADERS
@@ -72,14 +129,15 @@ typedef struct {
 static const char *SHADOW_VERT =
     "#version 450\n"
     "layout(location = 0) in vec3 a_position;\n"
-    "layout(push_constant) uniform PC { mat4 model; int cascade_idx; int _p[3]; } pc;\n"
-    "layout(set = 0, binding = 2) uniform ShadowUBO {\n"
-    "    mat4  cascade_vp[3];\n"
-    "    float cascade_splits[3];\n"
-    "    float _pad;\n"
-    "} shadow;\n"
+    "layout(push_constant) uniform PC { int cascade_idx; } pc;\n"
+    "layout(set = 0, binding = 2) uniform ShadowUBO { mat4 cascade_vp[3]; } shadow;\n"
+    "struct Object { mat4 model; vec4 normal[3]; vec4 tint; vec4 center; vec4 extent; };\n"
+    "layout(std430, set = 0, binding = 6) readonly buffer ObjectBuf { Object obj[]; } objects;\n"
+    "layout(std430, set = 0, binding = 7) readonly buffer VisibleBuf { uint idx[]; } visible;\n"
     "void main() {\n"
-    "    gl_Position = shadow.cascade_vp[pc.cascade_idx] * pc.model * vec4(a_position, 1.0);\n"
+    "    mat4 model = objects.obj[visible.idx[gl_InstanceIndex]].model;\n"
+    "    gl_Position = shadow.cascade_vp[pc.cascade_idx] * model * vec4(a_position, 1.0);\n"
+    "    gl_Position.z = max(gl_Position.z, 0.0);\n"
     "}\n";
 
 static const char *SHADOW_FRAG = "#version 450\nvoid main() {}\n";
@@ -90,7 +148,9 @@ static const char *FORWARD_VERT =
     "layout(location = 1) in vec3 a_normal;\n"
     "layout(location = 2) in vec4 a_tangent;\n"
     "layout(location = 3) in vec2 a_uv;\n"
-    "layout(push_constant) uniform PC { mat4 model; } pc;\n"
+    "struct Object { mat4 model; vec4 normal[3]; vec4 tint; vec4 center; vec4 extent; };\n"
+    "layout(std430, set = 0, binding = 6) readonly buffer ObjectBuf { Object obj[]; } objects;\n"
+    "layout(std430, set = 0, binding = 7) readonly buffer VisibleBuf { uint idx[]; } visible;\n"
     "layout(set = 0, binding = 0) uniform FrameUBO {\n"
     "    mat4  view; mat4  proj; mat4  inv_view_proj;\n"
     "    vec3  cam_pos; float time;\n"
@@ -101,143 +161,222 @@ static const char *FORWARD_VERT =
     "layout(location = 2) out vec3 v_tangent;\n"
     "layout(location = 3) out vec3 v_bitangent;\n"
     "layout(location = 4) out vec2 v_uv;\n"
+    "layout(location = 5) out vec4 v_tint;\n"
+    "layout(location = 6) flat out uint v_material;\n"
+    "invariant gl_Position;\n"
     "void main() {\n"
-    "    vec4 world = pc.model * vec4(a_position, 1.0);\n"
+    "    Object inst = objects.obj[visible.idx[gl_InstanceIndex]];\n"
+    "    vec4 world = inst.model * vec4(a_position, 1.0);\n"
     "    v_world_pos = world.xyz;\n"
-    "    mat3 N = transpose(inverse(mat3(pc.model)));\n"
+    "    mat3 N = mat3(inst.normal[0].xyz, inst.normal[1].xyz, inst.normal[2].xyz);\n"
     "    v_normal    = normalize(N * a_normal);\n"
     "    v_tangent   = normalize(N * a_tangent.xyz);\n"
     "    v_bitangent = cross(v_normal, v_tangent) * a_tangent.w;\n"
     "    v_uv = a_uv;\n"
+    "    v_tint = inst.tint;\n"
+    "    v_material = uint(inst.center.w);\n"
     "    gl_Position = frame.proj * frame.view * world;\n"
     "}\n";
 
-static const char *FORWARD_FRAG =
+/* Depth pre-pass: the position math of FORWARD_VERT, invariant in both
+   so the lit pass's EQUAL test matches the depth written here. */
+static const char *DEPTH_VERT =
     "#version 450\n"
-    "layout(location = 0) in vec3 v_world_pos;\n"
-    "layout(location = 1) in vec3 v_normal;\n"
-    "layout(location = 2) in vec3 v_tangent;\n"
-    "layout(location = 3) in vec3 v_bitangent;\n"
-    "layout(location = 4) in vec2 v_uv;\n"
+    "layout(location = 0) in vec3 a_position;\n"
+    "struct Object { mat4 model; vec4 normal[3]; vec4 tint; vec4 center; vec4 extent; };\n"
+    "layout(std430, set = 0, binding = 6) readonly buffer ObjectBuf { Object obj[]; } objects;\n"
+    "layout(std430, set = 0, binding = 7) readonly buffer VisibleBuf { uint idx[]; } visible;\n"
     "layout(set = 0, binding = 0) uniform FrameUBO {\n"
     "    mat4  view; mat4  proj; mat4  inv_view_proj;\n"
     "    vec3  cam_pos; float time;\n"
     "    float screen_width; float screen_height; uint debug_flags; float _pad;\n"
     "} frame;\n"
-    "struct LightEntry {\n"
-    "    vec3  position;  float range;\n"
-    "    vec3  direction; float intensity;\n"
-    "    vec3  color;     float inner_cone_cos;\n"
-    "    float outer_cone_cos; uint type; uint cast_shadows; uint _pad;\n"
-    "};\n"
-    "layout(set = 0, binding = 1) uniform LightUBO {\n"
-    "    LightEntry lights[128]; uint count; uint _pad[3];\n"
-    "} light_data;\n"
-    "layout(set = 0, binding = 2) uniform ShadowUBO {\n"
-    "    mat4  cascade_vp[3];\n"
-    "    float cascade_splits[3]; float _pad;\n"
-    "} shadow_data;\n"
-    "layout(set = 0, binding = 3) uniform sampler2D shadow_map_0;\n"
-    "layout(set = 0, binding = 4) uniform sampler2D shadow_map_1;\n"
+    "invariant gl_Position;\n"
+    "void main() {\n"
+    "    vec4 world = objects.obj[visible.idx[gl_InstanceIndex]].model * vec4(a_position, 1.0);\n"
+    "    gl_Position = frame.proj * frame.view * world;\n"
+    "}\n";
+
+/* Lit forward shading.  The per-material variant reads textures from
+   set 1 and factors from push constants; the bindless variant indexes the
+   material system's sampler array and frame binding 9 with the material
+   id carried in the object record (QS_MATERIAL_TEXTURE_SLOTS textures per
+   id), so draws of different materials can share a batch.  Both are
+   specialized on FEATURES, a PbrMaterialFeature mask: textures a material
+   lacks are not sampled, and masked materials are alpha-tested. */
+#define FORWARD_FRAG_HEAD \
+    "layout(location = 0) in vec3 v_world_pos;\n" \
+    "layout(location = 1) in vec3 v_normal;\n" \
+    "layout(location = 2) in vec3 v_tangent;\n" \
+    "layout(location = 3) in vec3 v_bitangent;\n" \
+    "layout(location = 4) in vec2 v_uv;\n" \
+    "layout(location = 5) in vec4 v_tint;\n" \
+    "layout(set = 0, binding = 0) uniform FrameUBO {\n" \
+    "    mat4  view; mat4  proj; mat4  inv_view_proj;\n" \
+    "    vec3  cam_pos; float time;\n" \
+    "    float screen_width; float screen_height; uint debug_flags; float _pad;\n" \
+    "} frame;\n" \
+    "struct LightEntry {\n" \
+    "    vec3  position;  float range;\n" \
+    "    vec3  direction; float intensity;\n" \
+    "    vec3  color;     float inner_cone_cos;\n" \
+    "    float outer_cone_cos; uint type; uint cast_shadows; uint _pad;\n" \
+    "};\n" \
+    "layout(std430, set = 0, binding = 1) readonly buffer LightBuf {\n" \
+    "    uint count; uint _pad[3]; LightEntry lights[];\n" \
+    "} light_data;\n" \
+    "layout(std430, set = 0, binding = 8) readonly buffer LightGrid {\n" \
+    "    float z_scale; float z_bias; uint global_count; uint _pad;\n" \
+    "    uvec2 cluster[3456]; uint index[];\n" \
+    "} grid;\n" \
+    "layout(set = 0, binding = 2) uniform ShadowUBO { mat4 cascade_vp[3]; } shadow_data;\n" \
+    "layout(set = 0, binding = 3) uniform sampler2D shadow_map_0;\n" \
+    "layout(set = 0, binding = 4) uniform sampler2D shadow_map_1;\n" \
     "layout(set = 0, binding = 5) uniform sampler2D shadow_map_2;\n"
+
+#define FORWARD_FRAG_MAIN \
+    "layout(location = 0) out vec4 out_color;\n" \
+    "layout(constant_id = 0) const uint FEATURES = 31u;\n" \
+    "const bool HAS_BASE_COLOR = (FEATURES & 1u) != 0u;\n" \
+    "const bool HAS_METALLIC_ROUGHNESS = (FEATURES & 2u) != 0u;\n" \
+    "const bool HAS_NORMAL = (FEATURES & 4u) != 0u;\n" \
+    "const bool HAS_OCCLUSION = (FEATURES & 8u) != 0u;\n" \
+    "const bool HAS_EMISSIVE = (FEATURES & 16u) != 0u;\n" \
+    "const bool ALPHA_TEST = (FEATURES & 32u) != 0u;\n" \
+    "const float PI = 3.14159265359;\n" \
+    "float D_GGX(float NdotH, float r) { float a2=(r*r)*(r*r); float d=NdotH*NdotH*(a2-1.0)+1.0; return a2/(PI*d*d); }\n" \
+    "float G_Smith(float NdotV, float NdotL, float r) {\n" \
+    "    float k=(r+1.0)*(r+1.0)/8.0;\n" \
+    "    return (NdotV/(NdotV*(1.0-k)+k))*(NdotL/(NdotL*(1.0-k)+k)); }\n" \
+    "vec3 F_Schlick(float c, vec3 F0) { return F0+(1.0-F0)*pow(clamp(1.0-c,0.0,1.0),5.0); }\n" \
+    "const vec2 POISSON[16]=vec2[](\n" \
+    "    vec2(-0.94201624,-0.39906216),vec2( 0.94558609,-0.76890725),\n" \
+    "    vec2(-0.09418410,-0.92938870),vec2( 0.34495938, 0.29387760),\n" \
+    "    vec2(-0.91588581, 0.45771432),vec2(-0.81544232,-0.87912464),\n" \
+    "    vec2(-0.38277543, 0.27676845),vec2( 0.97484398, 0.75648379),\n" \
+    "    vec2( 0.44323325,-0.97511554),vec2( 0.53742981,-0.47373420),\n" \
+    "    vec2(-0.26496911,-0.41893023),vec2( 0.79197514, 0.19090188),\n" \
+    "    vec2(-0.24188840, 0.99706507),vec2(-0.81409955, 0.91437590),\n" \
+    "    vec2( 0.19984126, 0.78641367),vec2( 0.14383161,-0.14100790));\n" \
+    "float shadow_pcf(sampler2D sm,vec3 p,float bias){\n" \
+    "    vec2 uv=p.xy*0.5+0.5;\n" \
+    "    float z=p.z-bias;\n" \
+    "    float spread=1.5/float(textureSize(sm,0).x);\n" \
+    "    float angle=fract(52.9829189*fract(dot(gl_FragCoord.xy,vec2(0.06711056,0.00583715))))*6.28318;\n" \
+    "    float ca=cos(angle); float sa=sin(angle);\n" \
+    "    float s=0.0;\n" \
+    "    for(int i=0;i<16;i++){\n" \
+    "        vec2 r=vec2(ca*POISSON[i].x-sa*POISSON[i].y,sa*POISSON[i].x+ca*POISSON[i].y);\n" \
+    "        float d=texture(sm,uv+r*spread).r;\n" \
+    "        s+=(d<1.0&&d<z)?0.0:1.0;}\n" \
+    "    return s/16.0;}\n" \
+    "float cascade_pcf(int c,vec3 p,float bias){\n" \
+    "    if(c==0) return shadow_pcf(shadow_map_0,p,bias);\n" \
+    "    if(c==1) return shadow_pcf(shadow_map_1,p,bias);\n" \
+    "    return shadow_pcf(shadow_map_2,p,bias);}\n" \
+    "float compute_shadow(vec3 wpos,vec3 N,vec3 sun_dir){\n" \
+    "    float NdotL=max(dot(N,normalize(-sun_dir)),0.0);\n" \
+    "    float bias=max(0.003*(1.0-NdotL),0.0003);\n" \
+    "    for(int c=0;c<3;c++){\n" \
+    "        vec3 p=(shadow_data.cascade_vp[c]*vec4(wpos,1.0)).xyz;\n" \
+    "        float edge=max(abs(p.x),abs(p.y));\n" \
+    "        if(edge>1.0||p.z<0.0) continue;\n" \
+    "        float s=cascade_pcf(c,p,bias);\n" \
+    "        if(c<2&&edge>0.9){\n" \
+    "            vec3 q=(shadow_data.cascade_vp[c+1]*vec4(wpos,1.0)).xyz;\n" \
+    "            s=mix(s,cascade_pcf(c+1,q,bias),(edge-0.9)/0.1);}\n" \
+    "        return s;}\n" \
+    "    return 1.0;}\n" \
+    "uint cluster_index(){\n" \
+    "    float depth=-(frame.view*vec4(v_world_pos,1.0)).z;\n" \
+    "    int z=clamp(int(floor(log(max(depth,1e-6))*grid.z_scale+grid.z_bias)),0,23);\n" \
+    "    uvec2 t=min(uvec2(gl_FragCoord.xy*vec2(16.0/frame.screen_width,9.0/frame.screen_height)),uvec2(15u,8u));\n" \
+    "    return (uint(z)*9u+t.y)*16u+t.x;}\n" \
+    "vec3 shade(LightEntry l,vec3 N,vec3 V,vec3 F0,vec3 albedo,float metallic,float roughness){\n" \
+    "    vec3 L; float att=1.0;\n" \
+    "    if(l.type==0u) { L=normalize(-l.direction); }\n" \
+    "    else { vec3 dv=l.position-v_world_pos; float dist=length(dv); L=dv/dist;\n" \
+    "           att=1.0/(1.0+dist*dist);\n" \
+    "           if(l.range>0.0) att*=clamp(1.0-dist/l.range,0.0,1.0);\n" \
+    "           if(l.type==2u){ float ct=dot(-L,normalize(l.direction));\n" \
+    "               float sa=clamp((ct-l.outer_cone_cos)/(l.inner_cone_cos-l.outer_cone_cos),0.0,1.0);\n" \
+    "               att*=sa*sa; } }\n" \
+    "    float NdotL=max(dot(N,L),0.0); if(NdotL<=0.0) return vec3(0);\n" \
+    "    vec3 H=normalize(V+L);\n" \
+    "    float NdotV=max(dot(N,V),0.001),NdotH=max(dot(N,H),0.001),VdotH=max(dot(V,H),0.001);\n" \
+    "    float D=D_GGX(NdotH,roughness); float G=G_Smith(NdotV,NdotL,roughness);\n" \
+    "    vec3 F=F_Schlick(VdotH,F0);\n" \
+    "    vec3 spec=(D*G*F)/(4.0*NdotV*NdotL);\n" \
+    "    vec3 kd=(vec3(1.0)-F)*(1.0-metallic);\n" \
+    "    float shad=(l.cast_shadows!=0u&&l.type==0u)?compute_shadow(v_world_pos,N,l.direction):1.0;\n" \
+    "    return (kd*albedo/PI+spec)*l.color*l.intensity*NdotL*att*shad;}\n" \
+    "void main() {\n" \
+    "    vec4 base=material.base_color_factor*v_tint;\n" \
+    "    if(HAS_BASE_COLOR) base*=texture(u_base_color,v_uv);\n" \
+    "    if(ALPHA_TEST&&base.a<material.alpha_cutoff) discard;\n" \
+    "    vec2 mr=HAS_METALLIC_ROUGHNESS?texture(u_metallic_roughness,v_uv).bg:vec2(1.0);\n" \
+    "    float metallic=mr.x*material.metallic_factor; float roughness=max(mr.y*material.roughness_factor,0.04);\n" \
+    "    float ao=HAS_OCCLUSION?mix(1.0,texture(u_occlusion,v_uv).r,material.occlusion_strength):1.0;\n" \
+    "    vec3 emissive=HAS_EMISSIVE?texture(u_emissive,v_uv).rgb*material.emissive_factor:vec3(0.0);\n" \
+    "    vec3 N=normalize(v_normal);\n" \
+    "    if(HAS_NORMAL){\n" \
+    "        vec3 nmap=texture(u_normal_map,v_uv).rgb*2.0-1.0;\n" \
+    "        N=normalize(mat3(normalize(v_tangent),normalize(v_bitangent),N)*nmap);}\n" \
+    "    if((frame.debug_flags&1u)!=0u){out_color=vec4(N*0.5+0.5,1.0);return;}\n" \
+    "    vec3 V=normalize(frame.cam_pos-v_world_pos);\n" \
+    "    vec3 F0=mix(vec3(0.04),base.rgb,metallic);\n" \
+    "    vec3 Lo=vec3(0);\n" \
+    "    for(uint i=0u;i<grid.global_count;i++)\n" \
+    "        Lo+=shade(light_data.lights[grid.index[i]],N,V,F0,base.rgb,metallic,roughness);\n" \
+    "    uvec2 range=grid.cluster[cluster_index()];\n" \
+    "    for(uint i=0u;i<range.y;i++)\n" \
+    "        Lo+=shade(light_data.lights[grid.index[range.x+i]],N,V,F0,base.rgb,metallic,roughness);\n" \
+    "    vec3 ambient=0.03*base.rgb*ao;\n" \
+    "    out_color=vec4(ambient+Lo+emissive,base.a);\n" \
+    "}\n"
+
+static const char *FORWARD_FRAG =
+    "#version 450\n"
+    FORWARD_FRAG_HEAD
     "layout(set = 1, binding = 0) uniform sampler2D u_base_color;\n"
     "layout(set = 1, binding = 1) uniform sampler2D u_metallic_roughness;\n"
     "layout(set = 1, binding = 2) uniform sampler2D u_normal_map;\n"
     "layout(set = 1, binding = 3) uniform sampler2D u_occlusion;\n"
     "layout(set = 1, binding = 4) uniform sampler2D u_emissive;\n"
     "layout(push_constant) uniform MatPC {\n"
-    "    layout(offset=64)  vec4  base_color_factor;\n"
-    "    layout(offset=80)  float metallic_factor;\n"
-    "    layout(offset=84)  float roughness_factor;\n"
-    "    layout(offset=88)  float normal_scale;\n"
-    "    layout(offset=92)  float occlusion_strength;\n"
-    "    layout(offset=96)  vec3  emissive_factor;\n"
-    "    layout(offset=108) float alpha_cutoff;\n"
-    "} mat_pc;\n"
-    "layout(location = 0) out vec4 out_color;\n"
-    "const float PI = 3.14159265359;\n"
-    "float D_GGX(float NdotH, float r) { float a2=(r*r)*(r*r); float d=NdotH*NdotH*(a2-1.0)+1.0; return a2/(PI*d*d); }\n"
-    "float G_Smith(float NdotV, float NdotL, float r) {\n"
-    "    float k=(r+1.0)*(r+1.0)/8.0;\n"
-    "    return (NdotV/(NdotV*(1.0-k)+k))*(NdotL/(NdotL*(1.0-k)+k)); }\n"
-    "vec3 F_Schlick(float c, vec3 F0) { return F0+(1.0-F0)*pow(clamp(1.0-c,0.0,1.0),5.0); }\n"
-    "const vec2 POISSON[16]=vec2[](\n"
-    "    vec2(-0.94201624,-0.39906216),vec2( 0.94558609,-0.76890725),\n"
-    "    vec2(-0.09418410,-0.92938870),vec2( 0.34495938, 0.29387760),\n"
-    "    vec2(-0.91588581, 0.45771432),vec2(-0.81544232,-0.87912464),\n"
-    "    vec2(-0.38277543, 0.27676845),vec2( 0.97484398, 0.75648379),\n"
-    "    vec2( 0.44323325,-0.97511554),vec2( 0.53742981,-0.47373420),\n"
-    "    vec2(-0.26496911,-0.41893023),vec2( 0.79197514, 0.19090188),\n"
-    "    vec2(-0.24188840, 0.99706507),vec2(-0.81409955, 0.91437590),\n"
-    "    vec2( 0.19984126, 0.78641367),vec2( 0.14383161,-0.14100790));\n"
-    "float shadow_pcf(sampler2D sm,vec4 lsp,float bias){\n"
-    "    vec3 p=lsp.xyz/lsp.w; vec2 uv=p.xy*0.5+0.5;\n"
-    "    if(p.z<0.0||p.z>1.0||any(lessThan(uv,vec2(0.0)))||any(greaterThan(uv,vec2(1.0)))) return 1.0;\n"
-    "    float z=p.z-bias;\n"
-    "    float spread=1.5/float(textureSize(sm,0).x);\n"
-    "    float angle=fract(52.9829189*fract(dot(gl_FragCoord.xy,vec2(0.06711056,0.00583715))))*6.28318;\n"
-    "    float ca=cos(angle); float sa=sin(angle);\n"
-    "    float s=0.0;\n"
-    "    for(int i=0;i<16;i++){\n"
-    "        vec2 r=vec2(ca*POISSON[i].x-sa*POISSON[i].y,sa*POISSON[i].x+ca*POISSON[i].y);\n"
-    "        s+=(texture(sm,uv+r*spread).r<z)?0.0:1.0;}\n"
-    "    return s/16.0;}\n"
-    "float compute_shadow(vec3 wpos,vec3 N,vec3 sun_dir){\n"
-    "    float NdotL=max(dot(N,normalize(-sun_dir)),0.0);\n"
-    "    float bias=max(0.003*(1.0-NdotL),0.0003);\n"
-    "    float depth=-(frame.view*vec4(wpos,1.0)).z;\n"
-    "    float split0=shadow_data.cascade_splits[0];\n"
-    "    float split1=shadow_data.cascade_splits[1];\n"
-    "    float s;\n"
-    "    if(depth<split0){\n"
-    "        s=shadow_pcf(shadow_map_0,shadow_data.cascade_vp[0]*vec4(wpos,1.0),bias);\n"
-    "        float bt=split0*0.85; if(depth>bt){\n"
-    "            float t=clamp((depth-bt)/(split0-bt),0.0,1.0);\n"
-    "            s=mix(s,shadow_pcf(shadow_map_1,shadow_data.cascade_vp[1]*vec4(wpos,1.0),bias),t);}\n"
-    "    }else if(depth<split1){\n"
-    "        s=shadow_pcf(shadow_map_1,shadow_data.cascade_vp[1]*vec4(wpos,1.0),bias);\n"
-    "        float bt=split0+(split1-split0)*0.85; if(depth>bt){\n"
-    "            float t=clamp((depth-bt)/(split1-bt),0.0,1.0);\n"
-    "            s=mix(s,shadow_pcf(shadow_map_2,shadow_data.cascade_vp[2]*vec4(wpos,1.0),bias),t);}\n"
-    "    }else{\n"
-    "        s=shadow_pcf(shadow_map_2,shadow_data.cascade_vp[2]*vec4(wpos,1.0),bias);}\n"
-    "    return s;}\n"
-    "void main() {\n"
-    "    vec4 base=texture(u_base_color,v_uv)*mat_pc.base_color_factor;\n"
-    "    vec2 mr=texture(u_metallic_roughness,v_uv).bg;\n"
-    "    float metallic=mr.x*mat_pc.metallic_factor; float roughness=max(mr.y*mat_pc.roughness_factor,0.04);\n"
-    "    float ao=mix(1.0,texture(u_occlusion,v_uv).r,mat_pc.occlusion_strength);\n"
-    "    vec3 emissive=texture(u_emissive,v_uv).rgb*mat_pc.emissive_factor;\n"
-    "    vec3 nmap=texture(u_normal_map,v_uv).rgb*2.0-1.0;\n"
-    "    mat3 TBN=mat3(normalize(v_tangent),normalize(v_bitangent),normalize(v_normal));\n"
-    "    vec3 N=normalize(TBN*nmap);\n"
-    "    if((frame.debug_flags&1u)!=0u){out_color=vec4(N*0.5+0.5,1.0);return;}\n"
-    "    vec3 V=normalize(frame.cam_pos-v_world_pos);\n"
-    "    vec3 F0=mix(vec3(0.04),base.rgb,metallic);\n"
-    "    vec3 Lo=vec3(0);\n"
-    "    for(uint i=0u;i<light_data.count;i++) {\n"
-    "        LightEntry l=light_data.lights[i];\n"
-    "        vec3 L; float att=1.0;\n"
-    "        if(l.type==0u) { L=normalize(-l.direction); }\n"
-    "        else { vec3 dv=l.position-v_world_pos; float dist=length(dv); L=dv/dist;\n"
-    "               att=1.0/(1.0+dist*dist);\n"
-    "               if(l.range>0.0) att*=clamp(1.0-dist/l.range,0.0,1.0);\n"
-    "               if(l.type==2u){ float ct=dot(-L,normalize(l.direction));\n"
-    "                   float sa=clamp((ct-l.outer_cone_cos)/(l.inner_cone_cos-l.outer_cone_cos),0.0,1.0);\n"
-    "                   att*=sa*sa; } }\n"
-    "        float NdotL=max(dot(N,L),0.0); if(NdotL<=0.0) continue;\n"
-    "        vec3 H=normalize(V+L);\n"
-    "        float NdotV=max(dot(N,V),0.001),NdotH=max(dot(N,H),0.001),VdotH=max(dot(V,H),0.001);\n"
-    "        float D=D_GGX(NdotH,roughness); float G=G_Smith(NdotV,NdotL,roughness);\n"
-    "        vec3 F=F_Schlick(VdotH,F0);\n"
-    "        vec3 spec=(D*G*F)/(4.0*NdotV*NdotL);\n"
-    "        vec3 kd=(vec3(1.0)-F)*(1.0-metallic);\n"
-    "        float shad=(l.cast_shadows!=0u&&l.type==0u)?compute_shadow(v_world_pos,N,l.direction):1.0;\n"
-    "        Lo+=(kd*base.rgb/PI+spec)*l.color*l.intensity*NdotL*att*shad;\n"
-    "    }\n"
-    "    vec3 ambient=0.03*base.rgb*ao;\n"
-    "    out_color=vec4(ambient+Lo+emissive,base.a);\n"
-    "}\n";
+    "    vec4  base_color_factor;\n"
+    "    float metallic_factor;\n"
+    "    float roughness_factor;\n"
+    "    float normal_scale;\n"
+    "    float occlusion_strength;\n"
+    "    vec3  emissive_factor;\n"
+    "    float alpha_cutoff;\n"
+    "} material;\n"
+    FORWARD_FRAG_MAIN;
+
+static const char *FORWARD_BINDLESS_FRAG =
+    "#version 450\n"
+    "#extension GL_EXT_nonuniform_qualifier : require\n"
+    FORWARD_FRAG_HEAD
+    "layout(location = 6) flat in uint v_material;\n"
+    "struct Material {\n"
+    "    vec4  base_color_factor;\n"
+    "    float metallic_factor;\n"
+    "    float roughness_factor;\n"
+    "    float normal_scale;\n"
+    "    float occlusion_strength;\n"
+    "    vec3  emissive_factor;\n"
+    "    float alpha_cutoff;\n"
+    "};\n"
+    "layout(std430, set = 0, binding = 9) readonly buffer MaterialBuf { Material m[]; } materials;\n"
+    "layout(set = 1, binding = 0) uniform sampler2D u_textures[];\n"
+    "#define material materials.m[v_material]\n"
+    "#define u_base_color         u_textures[nonuniformEXT(v_material * 5u + 0u)]\n"
+    "#define u_metallic_roughness u_textures[nonuniformEXT(v_material * 5u + 1u)]\n"
+    "#define u_normal_map         u_textures[nonuniformEXT(v_material * 5u + 2u)]\n"
+    "#define u_occlusion          u_textures[nonuniformEXT(v_material * 5u + 3u)]\n"
+    "#define u_emissive           u_textures[nonuniformEXT(v_material * 5u + 4u)]\n"
+    FORWARD_FRAG_MAIN;
 
 static const char *BLOOM_DOWN_FRAG =
     "#version 450\n"
@@ -271,16 +410,37 @@ static const char *BLOOM_UP_FRAG =
     "    out_color=vec4(s/16.0,1.0);\n"
     "}\n";
 
+/* Composite.  The FXAA variant (spec constant 0) anti-aliases the HDR
+   image before bloom and tonemapping with the edge search of
+   pbr_fxaa.h, re-sampling each edge pixel across its edge. */
 static const char *COMPOSITE_FRAG =
     "#version 450\n"
+    "layout(constant_id=0) const bool FXAA=false;\n"
     "layout(set=0,binding=0) uniform sampler2D u_hdr;\n"
     "layout(set=0,binding=1) uniform sampler2D u_bloom;\n"
     "layout(push_constant) uniform PC { vec2 inv_size; float bloom_str; float vignette_str; } pc;\n"
     "layout(location=0) out vec4 out_color;\n"
+    "#define FXAA_FN\n"
+    "#define FXAA_CONST const\n"
+    "#define PbrFxaaOffset vec2\n"
+    "#define FXAA_OFFSET(x,y) vec2(x,y)\n"
+    "#define FXAA_ABS abs\n"
+    "#define FXAA_MIN min\n"
+    "#define FXAA_MAX max\n"
+    "#define FXAA_SQRT sqrt\n"
+    "#define FXAA_LUMA(u,v) luma_at(vec2(u,v))\n"
+    "float luma_at(vec2 uv);\n"
+    PBR_FXAA_GLSL "\n"
+    "float luma_at(vec2 uv) { vec3 c=textureLod(u_hdr,uv,0.0).rgb; return fxaa_luma(c.r,c.g,c.b); }\n"
+    "vec3 fxaa(vec2 uv) {\n"
+    "    vec2 px=1.0/vec2(textureSize(u_hdr,0));\n"
+    "    return textureLod(u_hdr,uv+fxaa_offset(uv.x,uv.y,px.x,px.y),0.0).rgb;\n"
+    "}\n"
     "vec3 aces(vec3 x) { return clamp((x*(2.51*x+0.03))/(x*(2.43*x+0.59)+0.14),0.0,1.0); }\n"
     "void main() {\n"
     "    vec2 uv=gl_FragCoord.xy*pc.inv_size;\n"
-    "    vec3 color=texture(u_hdr,uv).rgb + texture(u_bloom,uv).rgb*pc.bloom_str;\n"
+    "    vec3 hdr=FXAA?fxaa(uv):texture(u_hdr,uv).rgb;\n"
+    "    vec3 color=hdr + texture(u_bloom,uv).rgb*pc.bloom_str;\n"
     "    color=aces(color);\n"
     "    color=pow(color,vec3(1.0/2.2));\n"
     "    vec2 vu=uv*(1.0-uv.yx);\n"
@@ -288,108 +448,220 @@ static const char *COMPOSITE_FRAG =
     "    out_color=vec4(color,1.0);\n"
     "}\n";
 
-static const char *FULLSCREEN_VERT =
+/* Frustum cull: one invocation per PbrCullItem.  Survivors append their
+   object index to the batch's visible range and bump its instance count
+   (word 1 of both indirect command layouts).  Occlusion-tested items
+   (w = 2) of objects flagged occluded are left to the late cull. */
+static const char *CULL_COMP =
     "#version 450\n"
+    "layout(local_size_x = 64) in;\n"
+    "struct Object { mat4 model; vec4 normal[3]; vec4 tint; vec4 center; vec4 extent; };\n"
+    "layout(std430, set = 0, binding = 0) readonly buffer ObjectBuf { Object obj[]; } objects;\n"
+    "layout(std430, set = 0, binding = 1) readonly buffer ItemBuf { uvec4 item[]; } items;\n"
+    "layout(std430, set = 0, binding = 2) buffer CommandBuf { uint word[]; } commands;\n"
+    "layout(std430, set = 0, binding = 3) writeonly buffer VisibleBuf { uint idx[]; } visible;\n"
+    "layout(push_constant) uniform PC { vec4 planes[6]; uint item_count; } pc;\n"
     "void main() {\n"
-    "    vec2 pos=vec2((gl_VertexIndex==2)?3.0:-1.0,(gl_VertexIndex==1)?3.0:-1.0);\n"
-    "    gl_Position=vec4(pos,0.0,1.0);\n"
+    "    uint i = gl_GlobalInvocationID.x;\n"
+    "    if (i >= pc.item_count) return;\n"
+    "    uvec4 it = items.item[i];\n"
+    "    if (it.w != 0u) {\n"
+    "        vec3 c = objects.obj[it.x].center.xyz;\n"
+    "        vec3 e = objects.obj[it.x].extent.xyz;\n"
+    "        for (int p = 0; p < 6; p++) {\n"
+    "            vec4 pl = pc.planes[p];\n"
+    "            if (dot(pl.xyz, c) + pl.w + dot(abs(pl.xyz), e) < 0.0) return;\n"
+    "        }\n"
+    "        if (it.w == 2u && objects.obj[it.x].extent.w != 0.0) return;\n"
+    "    }\n"
+    "    uint slot = atomicAdd(commands.word[it.y * 5u + 1u], 1u);\n"
+    "    visible.idx[it.z + slot] = it.x;\n"
     "}\n";
 
-/* ================================================================
-   MATH HELPERS (CSM computation)
-   ================================================================ */
-
-static void compute_csm(const Qs_Camera *cam,
-                         const Qs_LightGPU *lights, uint32_t light_count,
-                         float shadow_matrices[QS_CSM_CASCADES][16],
-                         float shadow_splits[QS_CSM_CASCADES+1])
-{
-    /* Find the first directional light; fall back to a default sun direction. */
-    float light_dir[3] = { 0.4f, -1.0f, 0.3f };
-    for (uint32_t i = 0; i < light_count; i++) {
-        if (lights[i].type == (uint32_t)QS_LIGHT_DIRECTIONAL) {
-            light_dir[0] = lights[i].direction[0];
-            light_dir[1] = lights[i].direction[1];
-            light_dir[2] = lights[i].direction[2];
-            break;
-        }
-    }
-    float ld = sqrtf(light_dir[0]*light_dir[0]+light_dir[1]*light_dir[1]+light_dir[2]*light_dir[2]);
-    if (ld > 1e-6f) { light_dir[0]/=ld; light_dir[1]/=ld; light_dir[2]/=ld; }
-
-    float near_p = cam->near_plane > 0.0f ? cam->near_plane : 0.1f;
-    float far_p  = cam->far_plane  > 0.0f ? cam->far_plane  : 500.0f;
-
-    /* Practical Split Scheme (blend of logarithmic and uniform) */
-    shadow_splits[0] = near_p;
-    for (int i = 1; i <= QS_CSM_CASCADES; i++) {
-        float fi = (float)i / (float)QS_CSM_CASCADES;
-        float lg = near_p * powf(far_p / near_p, fi);
-        float ln = near_p + (far_p - near_p) * fi;
-        shadow_splits[i] = 0.75f * lg + 0.25f * ln;
-    }
+/* Light binning: one invocation per cluster.  The workgroup stages the
+   view-space bounding spheres of 64 lights at a time (the same bounds
+   pbr_cluster.c derives); each invocation appends those meeting its
+   cluster box to the cluster's PBR_CLUSTER_GPU_LIGHTS index slots after
+   the global lights.  w < 0 marks a global light. */
+static const char *CLUSTER_COMP =
+    "#version 450\n"
+    "layout(local_size_x = 64) in;\n"
+    "struct LightEntry {\n"
+    "    vec3  position;  float range;\n"
+    "    vec3  direction; float intensity;\n"
+    "    vec3  color;     float inner_cone_cos;\n"
+    "    float outer_cone_cos; uint type; uint cast_shadows; uint _pad;\n"
+    "};\n"
+    "layout(std430, set = 0, binding = 0) readonly buffer LightBuf {\n"
+    "    uint count; uint _pad[3]; LightEntry lights[];\n"
+    "} light_data;\n"
+    "layout(std430, set = 0, binding = 1) buffer LightGrid {\n"
+    "    float z_scale; float z_bias; uint global_count; uint _pad;\n"
+    "    uvec2 cluster[3456]; uint index[];\n"
+    "} grid;\n"
+    "layout(push_constant) uniform PC { mat4 view; vec4 proj; uint ortho; } pc;\n"
+    "shared vec4 spheres[64];\n"
+    "vec4 light_sphere(uint i) {\n"
+    "    LightEntry l = light_data.lights[i];\n"
+    "    if (l.type == 0u || !(l.range > 0.0)) return vec4(0.0, 0.0, 0.0, -1.0);\n"
+    "    vec3 c = l.position; float r = l.range;\n"
+    "    float len = length(l.direction), ca = l.outer_cone_cos;\n"
+    "    if (l.type == 2u && ca > 0.0 && len > 0.0) {\n"
+    "        float t;\n"
+    "        if (ca < 0.70710678) { t = r * ca; r *= sqrt(1.0 - ca * ca); }\n"
+    "        else { r /= 2.0 * ca; t = r; }\n"
+    "        c += l.direction / len * t;\n"
+    "    }\n"
+    "    return vec4((pc.view * vec4(c, 1.0)).xyz, r);\n"
+    "}\n"
+    "void main() {\n"
+    "    uint c = gl_GlobalInvocationID.x;\n"
+    "    uvec3 t = uvec3(c % 16u, (c / 16u) % 9u, c / 144u);\n"
+    "    float ratio = pc.proj.w / pc.proj.z;\n"
+    "    float d0 = t.z == 0u ? 0.0 : pc.proj.z * pow(ratio, float(t.z) / 24.0);\n"
+    "    float d1 = pc.proj.z * pow(ratio, float(t.z + 1u) / 24.0);\n"
+    "    vec2 tile = vec2(2.0 / 16.0, 2.0 / 9.0);\n"
+    "    vec2 n0 = vec2(t.xy) * tile - 1.0, n1 = n0 + tile;\n"
+    "    vec2 w0 = vec2(pc.ortho != 0u ? 1.0 : d0), w1 = vec2(pc.ortho != 0u ? 1.0 : d1);\n"
+    "    vec2 a = n0 * w0 / pc.proj.xy, b = n1 * w0 / pc.proj.xy;\n"
+    "    vec2 e = n0 * w1 / pc.proj.xy, f = n1 * w1 / pc.proj.xy;\n"
+    "    vec3 lo = vec3(min(min(a, b), min(e, f)), -d1);\n"
+    "    vec3 hi = vec3(max(max(a, b), max(e, f)), -d0);\n"
+    "    uint first = grid.global_count + c * 128u, count = 0u;\n"
+    "    for (uint base = 0u; base < light_data.count; base += 64u) {\n"
+    "        uint li = base + gl_LocalInvocationID.x;\n"
+    "        spheres[gl_LocalInvocationID.x] =\n"
+    "            li < light_data.count ? light_sphere(li) : vec4(0.0, 0.0, 0.0, -1.0);\n"
+    "        barrier();\n"
+    "        uint n = min(64u, light_data.count - base);\n"
+    "        for (uint k = 0u; k < n && count < 128u; k++) {\n"
+    "            vec4 s = spheres[k];\n"
+    "            vec3 q = clamp(s.xyz, lo, hi) - s.xyz;\n"
+    "            if (s.w >= 0.0 && dot(q, q) <= s.w * s.w)\n"
+    "                grid.index[first + count++] = base + k;\n"
+    "        }\n"
+    "        barrier();\n"
+    "    }\n"
+    "    grid.cluster[c] = uvec2(first, count);\n"
+    "}\n";
 
-    /* Light-space orthonormal basis */
-    float l_fwd[3] = { light_dir[0], light_dir[1], light_dir[2] };
-    float l_up[3]  = { 0.0f, 1.0f, 0.0f };
-    if (fabsf(l_fwd[1]) > 0.99f) { l_up[0] = 1.0f; l_up[1] = 0.0f; l_up[2] = 0.0f; }
-    float l_right[3] = {
-        l_fwd[1]*l_up[2]-l_fwd[2]*l_up[1],
-        l_fwd[2]*l_up[0]-l_fwd[0]*l_up[2],
-        l_fwd[0]*l_up[1]-l_fwd[1]*l_up[0]
-    };
-    float ll = sqrtf(l_right[0]*l_right[0]+l_right[1]*l_right[1]+l_right[2]*l_right[2]);
-    if (ll > 1e-6f) { l_right[0]/=ll; l_right[1]/=ll; l_right[2]/=ll; }
-    float l_up2[3] = {
-        l_right[1]*l_fwd[2]-l_right[2]*l_fwd[1],
-        l_right[2]*l_fwd[0]-l_right[0]*l_fwd[2],
-        l_right[0]*l_fwd[1]-l_right[1]*l_fwd[0]
-    };
+/* Hi-Z pyramid build: one invocation per texel of the level written, the
+   farthest of the 2x2 texels it covers in the level below (level 0: depth
+   pixels, every sample), clamped at odd edges.  src_depth reads the level
+   below.  pbr_hiz_build is the CPU reference. */
+#define HIZ_COMP_HEAD \
+    "#version 450\n" \
+    "layout(local_size_x = 8, local_size_y = 8) in;\n" \
+    "layout(std430, set = 0, binding = 1) buffer HiZ { float texel[]; } hiz;\n" \
+    "layout(push_constant) uniform PC {\n" \
+    "    uvec2 src; uvec2 dst; uint src_offset; uint dst_offset; uint samples;\n" \
+    "} pc;\n"
+
+#define HIZ_COMP_MAIN \
+    "void main() {\n" \
+    "    uvec2 t = gl_GlobalInvocationID.xy;\n" \
+    "    if (any(greaterThanEqual(t, pc.dst))) return;\n" \
+    "    ivec2 p = ivec2(t * 2u);\n" \
+    "    ivec2 q = min(p + 1, ivec2(pc.src) - 1);\n" \
+    "    hiz.texel[pc.dst_offset + t.y * pc.dst.x + t.x] =\n" \
+    "        max(max(src_depth(p), src_depth(ivec2(q.x, p.y))),\n" \
+    "            max(src_depth(ivec2(p.x, q.y)), src_depth(q)));\n" \
+    "}\n"
+
+static const char *HIZ_SEED_COMP =
+    HIZ_COMP_HEAD
+    "layout(set = 0, binding = 0) uniform sampler2D depth_tex;\n"
+    "float src_depth(ivec2 p) { return texelFetch(depth_tex, p, 0).r; }\n"
+    HIZ_COMP_MAIN;
+
+static const char *HIZ_SEED_MS_COMP =
+    HIZ_COMP_HEAD
+    "layout(set = 0, binding = 0) uniform sampler2DMS depth_tex;\n"
+    "float src_depth(ivec2 p) {\n"
+    "    float d = 0.0;\n"
+    "    for (int s = 0; s < int(pc.samples); s++) d = max(d, texelFetch(depth_tex, p, s).r);\n"
+    "    return d;\n"
+    "}\n"
+    HIZ_COMP_MAIN;
+
+static const char *HIZ_REDUCE_COMP =
+    HIZ_COMP_HEAD
+    "float src_depth(ivec2 p) { return hiz.texel[pc.src_offset + uint(p.y) * pc.src.x + uint(p.x)]; }\n"
+    HIZ_COMP_MAIN;
+
+/* Late cull: one invocation per occlusion-tested forward item, classified
+   against the Hi-Z pyramid as pbr_hiz_test does.  On-screen objects take
+   the result as their occluded flag (extent.w) for the next early cull;
+   those visible now that the early cull skipped append to the late
+   commands, whose visible ranges sit late_shift past the early ones. */
+static const char *OCCLUSION_COMP =
+    "#version 450\n"
+    "layout(local_size_x = 64) in;\n"
+    "struct Object { mat4 model; vec4 normal[3]; vec4 tint; vec4 center; vec4 extent; };\n"
+    "layout(std430, set = 0, binding = 0) buffer ObjectBuf { Object obj[]; } objects;\n"
+    "layout(std430, set = 0, binding = 1) readonly buffer ItemBuf { uvec4 item[]; } items;\n"
+    "layout(std430, set = 0, binding = 2) buffer CommandBuf { uint word[]; } commands;\n"
+    "layout(std430, set = 0, binding = 3) writeonly buffer VisibleBuf { uint idx[]; } visible;\n"
+    "layout(std430, set = 0, binding = 4) readonly buffer HiZ { float texel[]; } hiz;\n"
+    "layout(push_constant) uniform PC {\n"
+    "    mat4 view_proj;\n"
+    "    uint item_count; uint first_item; uint first_command; uint late_shift;\n"
+    "    uvec2 depth_size; uint levels;\n"
+    "} pc;\n"
+    "const uint OUTSIDE = 0u, OCCLUDED = 1u, VISIBLE = 2u;\n"
+    "uint hiz_test(vec3 c, vec3 e) {\n"
+    "    vec3 lo = vec3(1e30);\n"
+    "    vec2 hi = vec2(-1e30);\n"
+    "    for (int k = 0; k < 8; k++) {\n"
+    "        vec3 s = vec3((k & 1) != 0 ? 1.0 : -1.0, (k & 2) != 0 ? 1.0 : -1.0,\n"
+    "                      (k & 4) != 0 ? 1.0 : -1.0);\n"
+    "        vec4 clip = pc.view_proj * vec4(c + s * e, 1.0);\n"
+    "        if (clip.w <= 0.0) return VISIBLE;\n"
+    "        vec3 ndc = clip.xyz / clip.w;\n"
+    "        lo = min(lo, ndc);\n"
+    "        hi = max(hi, ndc.xy);\n"
+    "    }\n"
+    "    if (any(lessThan(hi, vec2(-1.0))) || any(greaterThan(lo, vec3(1.0)))) return OUTSIDE;\n"
+    "    vec2 size = vec2(pc.depth_size);\n"
+    "    vec2 p0 = (max(lo.xy, vec2(-1.0)) * 0.5 + 0.5) * size;\n"
+    "    vec2 p1 = (min(hi, vec2(1.0)) * 0.5 + 0.5) * size;\n"
+    "    float span = max(p1.x - p0.x, p1.y - p0.y) * 0.5;\n"
+    "    uint level = min(span > 1.0 ? uint(ceil(log2(span))) : 0u, pc.levels - 1u);\n"
+    "    uvec2 dim = (pc.depth_size + 1u) / 2u;\n"
+    "    uint offset = 0u;\n"
+    "    for (uint l = 0u; l < level; l++) {\n"
+    "        offset += dim.x * dim.y;\n"
+    "        dim = (dim + 1u) / 2u;\n"
+    "    }\n"
+    "    float scale = 1.0 / float(2u << level);\n"
+    "    uvec2 t1 = min(uvec2(p1 * scale), dim - 1u);\n"
+    "    uvec2 t0 = min(uvec2(p0 * scale), t1);\n"
+    "    float farthest = 0.0;\n"
+    "    for (uint y = t0.y; y <= t1.y; y++)\n"
+    "        for (uint x = t0.x; x <= t1.x; x++)\n"
+    "            farthest = max(farthest, hiz.texel[offset + y * dim.x + x]);\n"
+    "    return lo.z <= farthest ? VISIBLE : OCCLUDED;\n"
+    "}\n"
+    "void main() {\n"
+    "    uint i = gl_GlobalInvocationID.x;\n"
+    "    if (i >= pc.item_count) return;\n"
+    "    uvec4 it = items.item[pc.first_item + i];\n"
+    "    if (it.w != 2u) return;\n"
+    "    uint result = hiz_test(objects.obj[it.x].center.xyz, objects.obj[it.x].extent.xyz);\n"
+    "    if (result == OUTSIDE) return;\n"
+    "    bool skipped = objects.obj[it.x].extent.w != 0.0;\n"
+    "    objects.obj[it.x].extent.w = result == OCCLUDED ? 1.0 : 0.0;\n"
+    "    if (result == OCCLUDED || !skipped) return;\n"
+    "    uint slot = atomicAdd(commands.word[(it.y - pc.first_command) * 5u + 1u], 1u);\n"
+    "    visible.idx[it.z + pc.late_shift + slot] = it.x;\n"
+    "}\n";
 
-    for (int c = 0; c < QS_CSM_CASCADES; c++) {
-        float near_c = shadow_splits[c], far_c = shadow_splits[c+1];
-
-        /* Shadow map XY radius: proportional to cascade depth slice.
-           Anchored on the camera's orbit target so the tightest coverage always
-           wraps the visible scene even when the camera is looking steeply downward
-           (placing the view-ray midpoint underground). */
-        float radius = (far_c - near_c) * 0.6f + 2.0f;
-
-        float cx = cam->target[0];
-        float cy = cam->target[1];
-        float cz = cam->target[2];
-
-        /* Snap center to texel grid in light space (eliminates shadow shimmer) */
-        float texel = 2.0f * radius / (float)QS_SHADOW_MAP_SIZE;
-        float lc_r  = cx*l_right[0] + cy*l_right[1] + cz*l_right[2];
-        float lc_u  = cx*l_up2[0]   + cy*l_up2[1]   + cz*l_up2[2];
-        float lc_d  = cx*l_fwd[0]   + cy*l_fwd[1]   + cz*l_fwd[2];
-        lc_r = roundf(lc_r / texel) * texel;
-        lc_u = roundf(lc_u / texel) * texel;
-        cx = lc_r*l_right[0] + lc_u*l_up2[0] + lc_d*l_fwd[0];
-        cy = lc_r*l_right[1] + lc_u*l_up2[1] + lc_d*l_fwd[1];
-        cz = lc_r*l_right[2] + lc_u*l_up2[2] + lc_d*l_fwd[2];
-
-        /* Pull light eye back so scene geometry sits well within the depth range. */
-        float pull = radius;
-        float lx = cx - light_dir[0]*pull;
-        float ly = cy - light_dir[1]*pull;
-        float lz = cz - light_dir[2]*pull;
-
-        /* Standard GL right-handed view matrix: Z row = -l_fwd.
-           Objects land at view_z = -pull (negative), consistent with ortho below. */
-        float lv[16]; memset(lv, 0, 64);
-        lv[0]= l_right[0]; lv[4]= l_right[1]; lv[8]= l_right[2];  lv[12]=-(l_right[0]*lx+l_right[1]*ly+l_right[2]*lz);
-        lv[1]= l_up2[0];   lv[5]= l_up2[1];   lv[9]= l_up2[2];    lv[13]=-(l_up2[0]*lx+l_up2[1]*ly+l_up2[2]*lz);
-        lv[2]=-l_fwd[0];   lv[6]=-l_fwd[1];   lv[10]=-l_fwd[2];   lv[14]= (l_fwd[0]*lx+l_fwd[1]*ly+l_fwd[2]*lz);
-        lv[3]=0; lv[7]=0; lv[11]=0; lv[15]=1.0f;
-        float lp[16];
-        /* Symmetric Z range [-5r, +5r] keeps scene geometry (view_z = -pull = -r)
-           centred in the depth range at NDC z = 0.2, identical to the original. */
-        qs_m4_ortho_lrtbnf(lp, -radius, radius, -radius, radius, -radius*5.0f, radius*5.0f);
-        qs_m4_mul(lp, lv, shadow_matrices[c]);
-    }
-}
+static const char *FULLSCREEN_VERT =
+    "#version 450\n"
+    "void main() {\n"
+    "    vec2 pos=vec2((gl_VertexIndex==2)?3.0:-1.0,(gl_VertexIndex==1)?3.0:-1.0);\n"
+    "    gl_Position=vec4(pos,0.0,1.0);\n"
+    "}\n";
 
 /* ================================================================
    SHARED PASS RESOURCE CREATION / DESTRUCTION
@@ -428,17 +700,33 @@ static uint32_t effective_sample_count(uint32_t want, uint32_t dev_max)
     return result;
 }
 
+static bool fxaa_active(const PbrPassResources *ps)
+{
+    return g_pp_settings.anti_aliasing == PBR_AA_FXAA && ps->composite_fxaa_pipeline;
+}
+
+/* Sample count the forward targets should have: FXAA replaces MSAA. */
+static uint32_t wanted_sample_count(const PbrPassResources *ps)
+{
+    if (fxaa_active(ps)) return 1;
+    return effective_sample_count(g_pp_settings.msaa_sample_count, ps->dev_max_samples);
+}
+
 static bool create_frame_set_layout(Qs_GpuContext *gpu, PbrPassResources *ps)
 {
-    Qs_GpuDescriptorBinding b[6] = {
+    Qs_GpuDescriptorBinding b[10] = {
         {0,QS_GPU_DESCRIPTOR_UNIFORM_BUFFER,        1,QS_GPU_SHADER_VERTEX|QS_GPU_SHADER_FRAGMENT},
-        {1,QS_GPU_DESCRIPTOR_UNIFORM_BUFFER,        1,QS_GPU_SHADER_FRAGMENT},
+        {1,QS_GPU_DESCRIPTOR_STORAGE_BUFFER,        1,QS_GPU_SHADER_FRAGMENT},
         {2,QS_GPU_DESCRIPTOR_UNIFORM_BUFFER,        1,QS_GPU_SHADER_VERTEX|QS_GPU_SHADER_FRAGMENT},
         {3,QS_GPU_DESCRIPTOR_COMBINED_IMAGE_SAMPLER,1,QS_GPU_SHADER_FRAGMENT},
         {4,QS_GPU_DESCRIPTOR_COMBINED_IMAGE_SAMPLER,1,QS_GPU_SHADER_FRAGMENT},
         {5,QS_GPU_DESCRIPTOR_COMBINED_IMAGE_SAMPLER,1,QS_GPU_SHADER_FRAGMENT},
+        {6,QS_GPU_DESCRIPTOR_STORAGE_BUFFER,        1,QS_GPU_SHADER_VERTEX},
+        {7,QS_GPU_DESCRIPTOR_STORAGE_BUFFER,        1,QS_GPU_SHADER_VERTEX},
+        {8,QS_GPU_DESCRIPTOR_STORAGE_BUFFER,        1,QS_GPU_SHADER_FRAGMENT},
+        {9,QS_GPU_DESCRIPTOR_STORAGE_BUFFER,        1,QS_GPU_SHADER_FRAGMENT},
     };
-    ps->frame_set_layout = qs_gpu_create_descriptor_set_layout(gpu, b, 6);
+    ps->frame_set_layout = qs_gpu_create_descriptor_set_layout(gpu, b, 10);
     return ps->frame_set_layout != NULL;
 }
 
@@ -453,66 +741,239 @@ static bool create_single_sampler_layout(Qs_GpuContext *gpu,
     return *out != NULL;
 }
 
+/* ================================================================
+   SHADER COMPILATION
+   ================================================================ */
+
+static const char **const k_shader_sources[PBR_SHADER_COUNT] = {
+    [PBR_SHADER_SHADOW_VERT]     = &SHADOW_VERT,
+    [PBR_SHADER_SHADOW_FRAG]     = &SHADOW_FRAG,
+    [PBR_SHADER_FORWARD_VERT]    = &FORWARD_VERT,
+    [PBR_SHADER_FORWARD_FRAG]    = &FORWARD_FRAG,
+    [PBR_SHADER_FORWARD_BINDLESS_FRAG] = &FORWARD_BINDLESS_FRAG,
+    [PBR_SHADER_DEPTH_VERT]      = &DEPTH_VERT,
+    [PBR_SHADER_FULLSCREEN_VERT] = &FULLSCREEN_VERT,
+    [PBR_SHADER_BLOOM_DOWN_FRAG] = &BLOOM_DOWN_FRAG,
+    [PBR_SHADER_BLOOM_UP_FRAG]   = &BLOOM_UP_FRAG,
+    [PBR_SHADER_COMPOSITE_FRAG]  = &COMPOSITE_FRAG,
+    [PBR_SHADER_CULL_COMP]       = &CULL_COMP,
+    [PBR_SHADER_CLUSTER_COMP]    = &CLUSTER_COMP,
+    [PBR_SHADER_HIZ_SEED_COMP]    = &HIZ_SEED_COMP,
+    [PBR_SHADER_HIZ_SEED_MS_COMP] = &HIZ_SEED_MS_COMP,
+    [PBR_SHADER_HIZ_REDUCE_COMP]  = &HIZ_REDUCE_COMP,
+    [PBR_SHADER_OCCLUSION_COMP]   = &OCCLUSION_COMP,
+};
+
+static const Qs_GpuShaderStage k_shader_stages[PBR_SHADER_COUNT] = {
+    [PBR_SHADER_SHADOW_VERT]     = QS_GPU_SHADER_VERTEX,
+    [PBR_SHADER_SHADOW_FRAG]     = QS_GPU_SHADER_FRAGMENT,
+    [PBR_SHADER_FORWARD_VERT]    = QS_GPU_SHADER_VERTEX,
+    [PBR_SHADER_FORWARD_FRAG]    = QS_GPU_SHADER_FRAGMENT,
+    [PBR_SHADER_FORWARD_BINDLESS_FRAG] = QS_GPU_SHADER_FRAGMENT,
+    [PBR_SHADER_DEPTH_VERT]      = QS_GPU_SHADER_VERTEX,
+    [PBR_SHADER_FULLSCREEN_VERT] = QS_GPU_SHADER_VERTEX,
+    [PBR_SHADER_BLOOM_DOWN_FRAG] = QS_GPU_SHADER_FRAGMENT,
+    [PBR_SHADER_BLOOM_UP_FRAG]   = QS_GPU_SHADER_FRAGMENT,
+    [PBR_SHADER_COMPOSITE_FRAG]  = QS_GPU_SHADER_FRAGMENT,
+    [PBR_SHADER_CULL_COMP]       = QS_GPU_SHADER_COMPUTE,
+    [PBR_SHADER_CLUSTER_COMP]    = QS_GPU_SHADER_COMPUTE,
+    [PBR_SHADER_HIZ_SEED_COMP]    = QS_GPU_SHADER_COMPUTE,
+    [PBR_SHADER_HIZ_SEED_MS_COMP] = QS_GPU_SHADER_COMPUTE,
+    [PBR_SHADER_HIZ_REDUCE_COMP]  = QS_GPU_SHADER_COMPUTE,
+    [PBR_SHADER_OCCLUSION_COMP]   = QS_GPU_SHADER_COMPUTE,
+};
+
+/* The bindless forward shader needs descriptor indexing; without the
+   material system's bindless set it is never compiled, and failing to
+   compile it only keeps the per-material path. */
+static bool shader_wanted(PbrShader shader)
+{
+    return shader != PBR_SHADER_FORWARD_BINDLESS_FRAG || qs_material_bindless_set_layout();
+}
+
+static bool shader_required(PbrShader shader)
+{
+    return shader != PBR_SHADER_FORWARD_BINDLESS_FRAG;
+}
+
+static void shader_compile_job(void *data)
+{
+    PbrShaderTask *t = data;
+    for (uint32_t i = 0; i < PBR_SHADER_COUNT; i++) {
+        if (shader_wanted((PbrShader)i))
+            t->out[i] = qs_gpu_compile_shader(t->gpu, *k_shader_sources[i], k_shader_stages[i]);
+    }
+}
+
+void pbr_shaders_compile_async(Qs_Engine *engine, Qs_GpuContext *gpu,
+                               PbrPassResources *ps)
+{
+    Qs_JobSystem *jobs = qs_engine_job_system(engine);
+    ps->shader_counter = jobs ? qs_job_counter_create(jobs) : NULL;
+    if (!ps->shader_counter) return; /* compiled inline by shaders_acquire */
+    ps->shader_jobs = jobs;
+
+    ps->shader_task = (PbrShaderTask){ gpu, ps->shaders };
+    qs_job_dispatch(jobs, &(Qs_JobDesc){ .fn = shader_compile_job, .data = &ps->shader_task,
+                                         .name = "pbr_compile_shaders" },
+                    ps->shader_counter);
+}
+
+static void shaders_wait(PbrPassResources *ps)
+{
+    if (!ps->shader_counter) return;
+    qs_job_wait(ps->shader_jobs, ps->shader_counter);
+    qs_job_counter_destroy(ps->shader_jobs, ps->shader_counter);
+    ps->shader_counter = NULL;
+}
+
+/* Waits for the async compile, then compiles inline whatever is missing
+   (no job system, or a retry after a failed pass-resource init). */
+static bool shaders_acquire(Qs_GpuContext *gpu, PbrPassResources *ps)
+{
+    shaders_wait(ps);
+    bool ok = true;
+    for (uint32_t i = 0; i < PBR_SHADER_COUNT; i++) {
+        if (!ps->shaders[i] && shader_wanted((PbrShader)i))
+            ps->shaders[i] = qs_gpu_compile_shader(gpu, *k_shader_sources[i], k_shader_stages[i]);
+        if (!ps->shaders[i] && shader_required((PbrShader)i)) ok = false;
+    }
+    return ok;
+}
+
+static void shaders_release(Qs_GpuContext *gpu, PbrPassResources *ps)
+{
+    shaders_wait(ps);
+    for (uint32_t i = 0; i < PBR_SHADER_COUNT; i++) {
+        qs_gpu_destroy_shader(gpu, ps->shaders[i]);
+        ps->shaders[i] = NULL;
+    }
+}
+
+/* Mesh vertex streams: depth-only pipelines read the position stream
+   alone, the forward pipelines the attribute stream at binding 1 too. */
+static const Qs_GpuVertexAttribute k_position_attrs[1] = {
+    {0,QS_GPU_VERTEX_FORMAT_FLOAT3,0},
+};
+static const Qs_GpuVertexAttribute k_attribute_attrs[3] = {
+    {1,QS_GPU_VERTEX_FORMAT_FLOAT3,offsetof(Qs_VertexAttributes,normal)},
+    {2,QS_GPU_VERTEX_FORMAT_FLOAT4,offsetof(Qs_VertexAttributes,tangent)},
+    {3,QS_GPU_VERTEX_FORMAT_FLOAT2,offsetof(Qs_VertexAttributes,uv)},
+};
+static const Qs_GpuVertexBinding k_forward_bindings[2] = {
+    {0,QS_VERTEX_POSITION_STRIDE,k_position_attrs,1},
+    {1,sizeof(Qs_VertexAttributes),k_attribute_attrs,3},
+};
+
 static bool create_shadow_pipeline(Qs_GpuContext *gpu, PbrPassResources *ps)
 {
-    Qs_GpuShader *vs=qs_gpu_compile_shader(gpu,SHADOW_VERT,QS_GPU_SHADER_VERTEX);
-    Qs_GpuShader *fs=qs_gpu_compile_shader(gpu,SHADOW_FRAG,QS_GPU_SHADER_FRAGMENT);
-    if(!vs||!fs){if(vs)qs_gpu_destroy_shader(gpu,vs);if(fs)qs_gpu_destroy_shader(gpu,fs);return false;}
-    Qs_GpuPushConstantRange pc={QS_GPU_SHADER_VERTEX,0,80};
+    Qs_GpuShader *vs=ps->shaders[PBR_SHADER_SHADOW_VERT];
+    Qs_GpuShader *fs=ps->shaders[PBR_SHADER_SHADOW_FRAG];
+    Qs_GpuPushConstantRange pc={QS_GPU_SHADER_VERTEX,0,sizeof(ShadowPC)};
     Qs_GpuDescriptorSetLayout *sets[]={ps->frame_set_layout};
     ps->shadow_layout=qs_gpu_create_pipeline_layout(gpu,&(Qs_GpuPipelineLayoutDesc){sets,1,&pc,1});
-    Qs_GpuVertexAttribute attr={0,QS_GPU_VERTEX_FORMAT_FLOAT3,offsetof(Qs_Vertex,position)};
-    Qs_GpuVertexBinding vb={0,sizeof(Qs_Vertex),&attr,1};
+    Qs_GpuVertexBinding vb={0,QS_VERTEX_POSITION_STRIDE,k_position_attrs,1};
     ps->shadow_pipeline=qs_gpu_create_graphics_pipeline(gpu,&(Qs_GpuGraphicsPipelineDesc){
         ps->shadow_layout,vs,fs,&vb,1,
         QS_GPU_TOPOLOGY_TRIANGLES,QS_GPU_CULL_FRONT,true,true,
         QS_GPU_FORMAT_NONE,QS_GPU_FORMAT_D32_SFLOAT});
-    qs_gpu_destroy_shader(gpu,vs);qs_gpu_destroy_shader(gpu,fs);
     return ps->shadow_pipeline!=NULL;
 }
 
+/* Rasterizer and depth state of each forward pass */
+static const struct {
+    Qs_GpuCullMode  cull;
+    bool            depth_write;
+    bool            wireframe;
+    Qs_GpuCompareOp compare;
+} k_forward_passes[PBR_FORWARD_PASS_COUNT] = {
+    [PBR_FORWARD_LIT]       = { QS_GPU_CULL_BACK, true,  false, QS_GPU_COMPARE_LESS  },
+    [PBR_FORWARD_WIREFRAME] = { QS_GPU_CULL_NONE, true,  true,  QS_GPU_COMPARE_LESS  },
+    [PBR_FORWARD_EQUAL]     = { QS_GPU_CULL_BACK, false, false, QS_GPU_COMPARE_EQUAL },
+};
+
+/* Creates the forward pipeline of pass at MSAA tier (1 << tier samples)
+   specialized on a PbrMaterialFeature mask into the variant table. */
+static bool create_forward_variant(Qs_GpuContext *gpu, PbrPassResources *ps,
+                                   PbrForwardPass pass, uint32_t tier, uint32_t features)
+{
+    uint64_t start=qs_clock_ns();
+    Qs_GpuPipeline *pipeline=qs_gpu_create_graphics_pipeline(gpu,&(Qs_GpuGraphicsPipelineDesc){
+        ps->forward_layout,ps->forward_vs,ps->forward_fs,k_forward_bindings,2,
+        QS_GPU_TOPOLOGY_TRIANGLES,k_forward_passes[pass].cull,true,k_forward_passes[pass].depth_write,
+        QS_GPU_FORMAT_RGBA16_SFLOAT,QS_GPU_FORMAT_DEPTH_AUTO,
+        .wireframe=k_forward_passes[pass].wireframe,.sample_count=1u<<tier,
+        .depth_compare=k_forward_passes[pass].compare,
+        .fragment_constants=&features,.fragment_constant_count=1});
+    uint64_t elapsed=qs_clock_ns()-start;
+    if(!pipeline){
+        ps->variant_failed[pass][tier]|=1ull<<features;
+        QS_LOG_WARN("PBR Renderer: forward variant 0x%02x (pass %d, %ux) failed",
+                    features,(int)pass,1u<<tier);
+        return false;
+    }
+    ps->forward_variants[pass][tier][features]=pipeline;
+    ps->variant_count++;
+    ps->variant_create_ns+=elapsed;
+    QS_LOG_DEBUG("PBR Renderer: forward variant 0x%02x (pass %d, %ux) in %.2f ms",
+                 features,(int)pass,1u<<tier,(double)elapsed/1e6);
+    return true;
+}
+
+/* With descriptor indexing every forward pipeline is the bindless
+   variant: set 1 is the material system's sampler array and no push
+   constants are used.  The forward shaders outlive the other modules:
+   feature variants are created from them as materials need them. */
 static bool create_forward_pipeline(Qs_GpuContext *gpu, PbrPassResources *ps)
 {
-    Qs_GpuShader *vs=qs_gpu_compile_shader(gpu,FORWARD_VERT,QS_GPU_SHADER_VERTEX);
-    Qs_GpuShader *fs=qs_gpu_compile_shader(gpu,FORWARD_FRAG,QS_GPU_SHADER_FRAGMENT);
-    if(!vs||!fs){if(vs)qs_gpu_destroy_shader(gpu,vs);if(fs)qs_gpu_destroy_shader(gpu,fs);return false;}
-    Qs_GpuDescriptorSetLayout *mat_layout=qs_material_set_layout();
-    if(!mat_layout){qs_gpu_destroy_shader(gpu,vs);qs_gpu_destroy_shader(gpu,fs);
-        QS_LOG_ERROR("PBR Renderer: material set layout unavailable");return false;}
-    Qs_GpuPushConstantRange pcs[2]={{QS_GPU_SHADER_VERTEX,0,64},{QS_GPU_SHADER_FRAGMENT,64,48}};
+    ps->bindless = ps->shaders[PBR_SHADER_FORWARD_BINDLESS_FRAG] != NULL;
+    PbrShader fs=ps->bindless ? PBR_SHADER_FORWARD_BINDLESS_FRAG : PBR_SHADER_FORWARD_FRAG;
+    ps->forward_vs=ps->shaders[PBR_SHADER_FORWARD_VERT];
+    ps->forward_fs=ps->shaders[fs];
+    ps->shaders[PBR_SHADER_FORWARD_VERT]=ps->shaders[fs]=NULL;
+    Qs_GpuDescriptorSetLayout *mat_layout=ps->bindless ? qs_material_bindless_set_layout()
+                                                       : qs_material_set_layout();
+    if(!mat_layout){QS_LOG_ERROR("PBR Renderer: material set layout unavailable");return false;}
+    Qs_GpuPushConstantRange pc={QS_GPU_SHADER_FRAGMENT,0,sizeof(PbrGpuMaterial)};
     Qs_GpuDescriptorSetLayout *sets[]={ps->frame_set_layout,mat_layout};
-    ps->forward_layout=qs_gpu_create_pipeline_layout(gpu,&(Qs_GpuPipelineLayoutDesc){sets,2,pcs,2});
-    Qs_GpuVertexAttribute attrs[4]={
-        {0,QS_GPU_VERTEX_FORMAT_FLOAT3,offsetof(Qs_Vertex,position)},
-        {1,QS_GPU_VERTEX_FORMAT_FLOAT3,offsetof(Qs_Vertex,normal)},
-        {2,QS_GPU_VERTEX_FORMAT_FLOAT4,offsetof(Qs_Vertex,tangent)},
-        {3,QS_GPU_VERTEX_FORMAT_FLOAT2,offsetof(Qs_Vertex,uv)},
-    };
-    Qs_GpuVertexBinding vb={0,sizeof(Qs_Vertex),attrs,4};
-
-    /* Create one pipeline pair per supported MSAA tier (0=1×, 1=2×, 2=4×, 3=8×) */
-    static const uint32_t k_tiers[PBR_MSAA_TIER_COUNT] = {1, 2, 4, 8};
+    ps->forward_layout=qs_gpu_create_pipeline_layout(gpu,&(Qs_GpuPipelineLayoutDesc){
+        sets,2,ps->bindless ? NULL : &pc,ps->bindless ? 0 : 1});
+    if(!ps->forward_layout) return false;
+    Qs_GpuVertexBinding depth_vb={0,QS_VERTEX_POSITION_STRIDE,k_position_attrs,1};
+    Qs_GpuShader *dvs=ps->shaders[PBR_SHADER_DEPTH_VERT];
+    Qs_GpuShader *dfs=ps->shaders[PBR_SHADER_SHADOW_FRAG];
+
+    /* Create the default variants per supported MSAA tier (0=1×, 1=2×, 2=4×, 3=8×) */
     ps->dev_max_samples = qs_gpu_max_sample_count(gpu);
-    for (int i = 0; i < PBR_MSAA_TIER_COUNT; i++) {
-        uint32_t sc = k_tiers[i];
+    for (uint32_t i = 0; i < PBR_MSAA_TIER_COUNT; i++) {
+        uint32_t sc = 1u << i;
         if (sc > ps->dev_max_samples) break;
-        ps->forward_pipelines[i] = qs_gpu_create_graphics_pipeline(gpu,&(Qs_GpuGraphicsPipelineDesc){
-            ps->forward_layout,vs,fs,&vb,1,
+        for (int pass = 0; pass < PBR_FORWARD_PASS_COUNT; pass++)
+            if (!create_forward_variant(gpu, ps, (PbrForwardPass)pass, i, PBR_FEATURES_DEFAULT) ||
+                !create_forward_variant(gpu, ps, (PbrForwardPass)pass, i,
+                                        PBR_FEATURES_DEFAULT | PBR_FEATURE_ALPHA_TEST))
+                return false;
+        ps->depth_pipelines[i] = qs_gpu_create_graphics_pipeline(gpu,&(Qs_GpuGraphicsPipelineDesc){
+            ps->forward_layout,dvs,dfs,&depth_vb,1,
             QS_GPU_TOPOLOGY_TRIANGLES,QS_GPU_CULL_BACK,true,true,
-            QS_GPU_FORMAT_RGBA16_SFLOAT,QS_GPU_FORMAT_DEPTH_AUTO,
-            .wireframe=false,.sample_count=sc});
-        ps->forward_wireframe_pipelines[i] = qs_gpu_create_graphics_pipeline(gpu,&(Qs_GpuGraphicsPipelineDesc){
-            ps->forward_layout,vs,fs,&vb,1,
-            QS_GPU_TOPOLOGY_TRIANGLES,QS_GPU_CULL_NONE,true,true,
-            QS_GPU_FORMAT_RGBA16_SFLOAT,QS_GPU_FORMAT_DEPTH_AUTO,
-            .wireframe=true,.sample_count=sc});
-        if (!ps->forward_pipelines[i] || !ps->forward_wireframe_pipelines[i]) {
-            qs_gpu_destroy_shader(gpu,vs); qs_gpu_destroy_shader(gpu,fs);
+            QS_GPU_FORMAT_NONE,QS_GPU_FORMAT_DEPTH_AUTO,
+            .sample_count=sc});
+        if (!ps->depth_pipelines[i])
             return false;
-        }
     }
-    qs_gpu_destroy_shader(gpu,vs);qs_gpu_destroy_shader(gpu,fs);
-    return ps->forward_pipelines[0] != NULL;
+    return ps->forward_variants[PBR_FORWARD_LIT][0][PBR_FEATURES_DEFAULT] != NULL;
+}
+
+/* Pipeline for the batches of features in pass at tier; the default
+   variant with the same alpha-test bit stands in while that one is
+   missing or failed to build, so masked materials keep their cutout. */
+static Qs_GpuPipeline *forward_variant(const PbrPassResources *ps, PbrForwardPass pass,
+                                       uint32_t tier, uint32_t features)
+{
+    Qs_GpuPipeline *pipeline = ps->forward_variants[pass][tier][features];
+    return pipeline ? pipeline
+                    : ps->forward_variants[pass][tier][PBR_FEATURES_DEFAULT |
+                                                       (features & PBR_FEATURE_ALPHA_TEST)];
 }
 
 static bool create_bloom_pipelines(Qs_GpuContext *gpu, PbrPassResources *ps)
@@ -522,16 +983,14 @@ static bool create_bloom_pipelines(Qs_GpuContext *gpu, PbrPassResources *ps)
     Qs_GpuDescriptorSetLayout *sets[]={ps->bloom_set_layout};
     ps->bloom_layout=qs_gpu_create_pipeline_layout(gpu,&(Qs_GpuPipelineLayoutDesc){sets,1,&pc,1});
     if(!ps->bloom_layout) return false;
-    Qs_GpuShader *fv=qs_gpu_compile_shader(gpu,FULLSCREEN_VERT,QS_GPU_SHADER_VERTEX);
-    Qs_GpuShader *fd=qs_gpu_compile_shader(gpu,BLOOM_DOWN_FRAG,QS_GPU_SHADER_FRAGMENT);
-    Qs_GpuShader *fu=qs_gpu_compile_shader(gpu,BLOOM_UP_FRAG,  QS_GPU_SHADER_FRAGMENT);
-    if(!fv||!fd||!fu){if(fv)qs_gpu_destroy_shader(gpu,fv);if(fd)qs_gpu_destroy_shader(gpu,fd);if(fu)qs_gpu_destroy_shader(gpu,fu);return false;}
+    Qs_GpuShader *fv=ps->shaders[PBR_SHADER_FULLSCREEN_VERT];
+    Qs_GpuShader *fd=ps->shaders[PBR_SHADER_BLOOM_DOWN_FRAG];
+    Qs_GpuShader *fu=ps->shaders[PBR_SHADER_BLOOM_UP_FRAG];
     Qs_GpuGraphicsPipelineDesc pd={ps->bloom_layout,fv,fd,NULL,0,
         QS_GPU_TOPOLOGY_TRIANGLES,QS_GPU_CULL_NONE,false,false,QS_GPU_FORMAT_RGBA16_SFLOAT,QS_GPU_FORMAT_DEPTH_AUTO};
     ps->bloom_down_pipeline=qs_gpu_create_graphics_pipeline(gpu,&pd);
     pd.fragment_shader=fu;
     ps->bloom_up_pipeline=qs_gpu_create_graphics_pipeline(gpu,&pd);
-    qs_gpu_destroy_shader(gpu,fv);qs_gpu_destroy_shader(gpu,fd);qs_gpu_destroy_shader(gpu,fu);
     return ps->bloom_down_pipeline&&ps->bloom_up_pipeline;
 }
 
@@ -543,14 +1002,88 @@ static bool create_composite_pipeline(Qs_GpuContext *gpu, PbrPassResources *ps,
     Qs_GpuDescriptorSetLayout *sets[]={ps->composite_set_layout};
     ps->composite_layout=qs_gpu_create_pipeline_layout(gpu,&(Qs_GpuPipelineLayoutDesc){sets,1,&pc,1});
     if(!ps->composite_layout) return false;
-    Qs_GpuShader *fv=qs_gpu_compile_shader(gpu,FULLSCREEN_VERT,QS_GPU_SHADER_VERTEX);
-    Qs_GpuShader *fc=qs_gpu_compile_shader(gpu,COMPOSITE_FRAG, QS_GPU_SHADER_FRAGMENT);
-    if(!fv||!fc){if(fv)qs_gpu_destroy_shader(gpu,fv);if(fc)qs_gpu_destroy_shader(gpu,fc);return false;}
-    ps->composite_pipeline=qs_gpu_create_graphics_pipeline(gpu,&(Qs_GpuGraphicsPipelineDesc){
+    Qs_GpuShader *fv=ps->shaders[PBR_SHADER_FULLSCREEN_VERT];
+    Qs_GpuShader *fc=ps->shaders[PBR_SHADER_COMPOSITE_FRAG];
+    Qs_GpuGraphicsPipelineDesc pd={
         ps->composite_layout,fv,fc,NULL,0,
-        QS_GPU_TOPOLOGY_TRIANGLES,QS_GPU_CULL_NONE,false,false,swapchain_fmt,QS_GPU_FORMAT_DEPTH_AUTO});
-    qs_gpu_destroy_shader(gpu,fv);qs_gpu_destroy_shader(gpu,fc);
-    return ps->composite_pipeline!=NULL;
+        QS_GPU_TOPOLOGY_TRIANGLES,QS_GPU_CULL_NONE,false,false,swapchain_fmt,QS_GPU_FORMAT_DEPTH_AUTO};
+    ps->composite_pipeline=qs_gpu_create_graphics_pipeline(gpu,&pd);
+    if(!ps->composite_pipeline) return false;
+    static const uint32_t fxaa_on=1;
+    pd.fragment_constants=&fxaa_on;
+    pd.fragment_constant_count=1;
+    ps->composite_fxaa_pipeline=qs_gpu_create_graphics_pipeline(gpu,&pd);
+    if(!ps->composite_fxaa_pipeline)
+        QS_LOG_WARN("PBR Renderer: FXAA composite pipeline failed, FXAA unavailable");
+    return true;
+}
+
+static bool create_cull_pipeline(Qs_GpuContext *gpu, PbrPassResources *ps)
+{
+    Qs_GpuDescriptorBinding b[5] = {
+        {0,QS_GPU_DESCRIPTOR_STORAGE_BUFFER,1,QS_GPU_SHADER_COMPUTE},
+        {1,QS_GPU_DESCRIPTOR_STORAGE_BUFFER,1,QS_GPU_SHADER_COMPUTE},
+        {2,QS_GPU_DESCRIPTOR_STORAGE_BUFFER,1,QS_GPU_SHADER_COMPUTE},
+        {3,QS_GPU_DESCRIPTOR_STORAGE_BUFFER,1,QS_GPU_SHADER_COMPUTE},
+        {4,QS_GPU_DESCRIPTOR_STORAGE_BUFFER,1,QS_GPU_SHADER_COMPUTE},
+    };
+    ps->cull_set_layout=qs_gpu_create_descriptor_set_layout(gpu,b,5);
+    if(!ps->cull_set_layout) return false;
+    Qs_GpuPushConstantRange pc={QS_GPU_SHADER_COMPUTE,0,sizeof(CullPC)};
+    Qs_GpuDescriptorSetLayout *sets[]={ps->cull_set_layout};
+    ps->cull_layout=qs_gpu_create_pipeline_layout(gpu,&(Qs_GpuPipelineLayoutDesc){sets,1,&pc,1,.compute=true});
+    if(!ps->cull_layout) return false;
+    ps->cull_pipeline=qs_gpu_create_compute_pipeline(gpu,&(Qs_GpuComputePipelineDesc){
+        ps->cull_layout,ps->shaders[PBR_SHADER_CULL_COMP]});
+    return ps->cull_pipeline!=NULL;
+}
+
+/* The late cull shares the cull set layout; needs create_cull_pipeline. */
+static bool create_hiz_pipelines(Qs_GpuContext *gpu, PbrPassResources *ps)
+{
+    if(!ps->cull_set_layout) return false;
+    Qs_GpuDescriptorBinding b[2] = {
+        {0,QS_GPU_DESCRIPTOR_COMBINED_IMAGE_SAMPLER,1,QS_GPU_SHADER_COMPUTE},
+        {1,QS_GPU_DESCRIPTOR_STORAGE_BUFFER,        1,QS_GPU_SHADER_COMPUTE},
+    };
+    ps->hiz_set_layout=qs_gpu_create_descriptor_set_layout(gpu,b,2);
+    if(!ps->hiz_set_layout) return false;
+    Qs_GpuPushConstantRange pc={QS_GPU_SHADER_COMPUTE,0,sizeof(HiZPC)};
+    Qs_GpuDescriptorSetLayout *sets[]={ps->hiz_set_layout};
+    ps->hiz_layout=qs_gpu_create_pipeline_layout(gpu,&(Qs_GpuPipelineLayoutDesc){sets,1,&pc,1,.compute=true});
+    if(!ps->hiz_layout) return false;
+    ps->hiz_seed_pipeline=qs_gpu_create_compute_pipeline(gpu,&(Qs_GpuComputePipelineDesc){
+        ps->hiz_layout,ps->shaders[PBR_SHADER_HIZ_SEED_COMP]});
+    ps->hiz_seed_ms_pipeline=qs_gpu_create_compute_pipeline(gpu,&(Qs_GpuComputePipelineDesc){
+        ps->hiz_layout,ps->shaders[PBR_SHADER_HIZ_SEED_MS_COMP]});
+    ps->hiz_reduce_pipeline=qs_gpu_create_compute_pipeline(gpu,&(Qs_GpuComputePipelineDesc){
+        ps->hiz_layout,ps->shaders[PBR_SHADER_HIZ_REDUCE_COMP]});
+
+    Qs_GpuPushConstantRange opc={QS_GPU_SHADER_COMPUTE,0,sizeof(OcclusionPC)};
+    Qs_GpuDescriptorSetLayout *osets[]={ps->cull_set_layout};
+    ps->occlusion_layout=qs_gpu_create_pipeline_layout(gpu,&(Qs_GpuPipelineLayoutDesc){osets,1,&opc,1,.compute=true});
+    if(!ps->occlusion_layout) return false;
+    ps->occlusion_pipeline=qs_gpu_create_compute_pipeline(gpu,&(Qs_GpuComputePipelineDesc){
+        ps->occlusion_layout,ps->shaders[PBR_SHADER_OCCLUSION_COMP]});
+    return ps->hiz_seed_pipeline&&ps->hiz_seed_ms_pipeline&&ps->hiz_reduce_pipeline&&
+           ps->occlusion_pipeline;
+}
+
+static bool create_cluster_pipeline(Qs_GpuContext *gpu, PbrPassResources *ps)
+{
+    Qs_GpuDescriptorBinding b[2] = {
+        {0,QS_GPU_DESCRIPTOR_STORAGE_BUFFER,1,QS_GPU_SHADER_COMPUTE},
+        {1,QS_GPU_DESCRIPTOR_STORAGE_BUFFER,1,QS_GPU_SHADER_COMPUTE},
+    };
+    ps->cluster_set_layout=qs_gpu_create_descriptor_set_layout(gpu,b,2);
+    if(!ps->cluster_set_layout) return false;
+    Qs_GpuPushConstantRange pc={QS_GPU_SHADER_COMPUTE,0,sizeof(ClusterPC)};
+    Qs_GpuDescriptorSetLayout *sets[]={ps->cluster_set_layout};
+    ps->cluster_layout=qs_gpu_create_pipeline_layout(gpu,&(Qs_GpuPipelineLayoutDesc){sets,1,&pc,1,.compute=true});
+    if(!ps->cluster_layout) return false;
+    ps->cluster_pipeline=qs_gpu_create_compute_pipeline(gpu,&(Qs_GpuComputePipelineDesc){
+        ps->cluster_layout,ps->shaders[PBR_SHADER_CLUSTER_COMP]});
+    return ps->cluster_pipeline!=NULL;
 }
 
 static bool pbr_pass_resources_init(Qs_GpuContext *gpu, PbrPassResources *ps)
@@ -558,13 +1091,19 @@ static bool pbr_pass_resources_init(Qs_GpuContext *gpu, PbrPassResources *ps)
     if (ps->ok) return true;
     if (!create_samplers(gpu,ps))                               { QS_LOG_ERROR("PBR Renderer: samplers failed");          goto fail; }
     if (!create_frame_set_layout(gpu,ps))                       { QS_LOG_ERROR("PBR Renderer: frame set layout failed");  goto fail; }
+    if (!shaders_acquire(gpu,ps))                               { QS_LOG_ERROR("PBR Renderer: shader compilation failed");goto fail; }
     if (!create_shadow_pipeline(gpu,ps))                        { QS_LOG_ERROR("PBR Renderer: shadow pipeline failed");   goto fail; }
     if (!create_forward_pipeline(gpu,ps))                       { QS_LOG_ERROR("PBR Renderer: forward pipeline failed");  goto fail; }
     if (!create_bloom_pipelines(gpu,ps))                        { QS_LOG_ERROR("PBR Renderer: bloom pipelines failed");   goto fail; }
     if (!create_composite_pipeline(gpu,ps,QS_GPU_FORMAT_BGRA8_UNORM))
                                                                 { QS_LOG_ERROR("PBR Renderer: composite pipeline failed");goto fail; }
+    if (!create_cull_pipeline(gpu,ps))                          { QS_LOG_WARN("PBR Renderer: cull pipeline failed, culling on the CPU"); }
+    if (!create_hiz_pipelines(gpu,ps))                          { QS_LOG_WARN("PBR Renderer: Hi-Z pipelines failed, occlusion culling off"); }
+    if (!create_cluster_pipeline(gpu,ps))                       { QS_LOG_WARN("PBR Renderer: cluster pipeline failed, binning lights on the CPU"); }
+    shaders_release(gpu,ps);
     ps->ok = true;
-    QS_LOG_INFO("PBR Renderer: shared pass resources ready");
+    QS_LOG_INFO("PBR Renderer: shared pass resources ready (%s materials)",
+                ps->bindless ? "bindless" : "per-material");
     return true;
 fail:
     pbr_pass_resources_shutdown(gpu, ps);
@@ -573,12 +1112,17 @@ fail:
 
 void pbr_pass_resources_shutdown(Qs_GpuContext *gpu, PbrPassResources *ps)
 {
+    shaders_release(gpu, ps);
     qs_gpu_destroy_pipeline(gpu, ps->shadow_pipeline);
     qs_gpu_destroy_pipeline_layout(gpu, ps->shadow_layout);
-    for (int i = 0; i < PBR_MSAA_TIER_COUNT; i++) {
-        qs_gpu_destroy_pipeline(gpu, ps->forward_pipelines[i]);
-        qs_gpu_destroy_pipeline(gpu, ps->forward_wireframe_pipelines[i]);
-    }
+    for (int pass = 0; pass < PBR_FORWARD_PASS_COUNT; pass++)
+        for (int i = 0; i < PBR_MSAA_TIER_COUNT; i++)
+            for (int f = 0; f < PBR_FEATURE_MASKS; f++)
+                qs_gpu_destroy_pipeline(gpu, ps->forward_variants[pass][i][f]);
+    for (int i = 0; i < PBR_MSAA_TIER_COUNT; i++)
+        qs_gpu_destroy_pipeline(gpu, ps->depth_pipelines[i]);
+    qs_gpu_destroy_shader(gpu, ps->forward_vs);
+    qs_gpu_destroy_shader(gpu, ps->forward_fs);
     qs_gpu_destroy_pipeline_layout(gpu, ps->forward_layout);
     qs_gpu_destroy_descriptor_set_layout(gpu, ps->frame_set_layout);
     qs_gpu_destroy_pipeline(gpu, ps->bloom_down_pipeline);
@@ -586,8 +1130,22 @@ void pbr_pass_resources_shutdown(Qs_GpuContext *gpu, PbrPassResources *ps)
     qs_gpu_destroy_pipeline_layout(gpu, ps->bloom_layout);
     qs_gpu_destroy_descriptor_set_layout(gpu, ps->bloom_set_layout);
     qs_gpu_destroy_pipeline(gpu, ps->composite_pipeline);
+    qs_gpu_destroy_pipeline(gpu, ps->composite_fxaa_pipeline);
     qs_gpu_destroy_pipeline_layout(gpu, ps->composite_layout);
     qs_gpu_destroy_descriptor_set_layout(gpu, ps->composite_set_layout);
+    qs_gpu_destroy_pipeline(gpu, ps->cull_pipeline);
+    qs_gpu_destroy_pipeline_layout(gpu, ps->cull_layout);
+    qs_gpu_destroy_pipeline(gpu, ps->hiz_seed_pipeline);
+    qs_gpu_destroy_pipeline(gpu, ps->hiz_seed_ms_pipeline);
+    qs_gpu_destroy_pipeline(gpu, ps->hiz_reduce_pipeline);
+    qs_gpu_destroy_pipeline_layout(gpu, ps->hiz_layout);
+    qs_gpu_destroy_descriptor_set_layout(gpu, ps->hiz_set_layout);
+    qs_gpu_destroy_pipeline(gpu, ps->occlusion_pipeline);
+    qs_gpu_destroy_pipeline_layout(gpu, ps->occlusion_layout);
+    qs_gpu_destroy_descriptor_set_layout(gpu, ps->cull_set_layout);
+    qs_gpu_destroy_pipeline(gpu, ps->cluster_pipeline);
+    qs_gpu_destroy_pipeline_layout(gpu, ps->cluster_layout);
+    qs_gpu_destroy_descriptor_set_layout(gpu, ps->cluster_set_layout);
     qs_gpu_destroy_sampler(gpu, ps->linear_sampler);
     qs_gpu_destroy_sampler(gpu, ps->point_sampler);
     qs_gpu_destroy_sampler(gpu, ps->shadow_sampler);
@@ -600,127 +1158,1016 @@ void pbr_pass_resources_shutdown(Qs_GpuContext *gpu, PbrPassResources *ps)
 
 static bool fwd_alloc_descriptors(PbrRenderer *r, Qs_GpuContext *gpu, PbrPassResources *ps)
 {
+    /* Per frame slot: frame set (2 UBOs, cascade samplers, 5 storage),
+       cull and late cull sets (5 storage each), cluster set (2 storage)
+       and Hi-Z set (1 sampler, 1 storage).  Once: composite (2) and
+       bloom (2x1) samplers. */
+    const uint32_t slots = QS_RENDER_FRAMES_IN_FLIGHT;
     Qs_GpuDescriptorPoolSize sizes[] = {
-        {QS_GPU_DESCRIPTOR_UNIFORM_BUFFER,         12},
-        {QS_GPU_DESCRIPTOR_COMBINED_IMAGE_SAMPLER, 12},
+        {QS_GPU_DESCRIPTOR_UNIFORM_BUFFER,         2 * slots},
+        {QS_GPU_DESCRIPTOR_COMBINED_IMAGE_SAMPLER, (QS_CSM_CASCADES + 1) * slots + 4},
+        {QS_GPU_DESCRIPTOR_STORAGE_BUFFER,         18 * slots},
     };
     r->desc_pool = qs_gpu_create_descriptor_pool(gpu,
-                   &(Qs_GpuDescriptorPoolDesc){sizes,2,8});
+                   &(Qs_GpuDescriptorPoolDesc){sizes,3,5 * slots + 3});
     if (!r->desc_pool) return false;
 
-    r->frame_desc_set     = qs_gpu_alloc_descriptor_set(gpu, r->desc_pool, ps->frame_set_layout);
+    for (uint32_t i = 0; i < slots; i++) {
+        r->frame_desc_sets[i] = qs_gpu_alloc_descriptor_set(gpu, r->desc_pool, ps->frame_set_layout);
+        if (!r->frame_desc_sets[i]) return false;
+        if (ps->cull_set_layout) {
+            r->cull_desc_sets[i]      = qs_gpu_alloc_descriptor_set(gpu, r->desc_pool, ps->cull_set_layout);
+            r->late_cull_desc_sets[i] = qs_gpu_alloc_descriptor_set(gpu, r->desc_pool, ps->cull_set_layout);
+        }
+        if (ps->hiz_set_layout)
+            r->hiz_desc_sets[i] = qs_gpu_alloc_descriptor_set(gpu, r->desc_pool, ps->hiz_set_layout);
+        if (ps->cluster_set_layout)
+            r->cluster_desc_sets[i] = qs_gpu_alloc_descriptor_set(gpu, r->desc_pool, ps->cluster_set_layout);
+    }
     r->composite_desc_set = qs_gpu_alloc_descriptor_set(gpu, r->desc_pool, ps->composite_set_layout);
     r->bloom_desc_sets[0] = qs_gpu_alloc_descriptor_set(gpu, r->desc_pool, ps->bloom_set_layout);
     r->bloom_desc_sets[1] = qs_gpu_alloc_descriptor_set(gpu, r->desc_pool, ps->bloom_set_layout);
-    return r->frame_desc_set && r->composite_desc_set &&
-           r->bloom_desc_sets[0] && r->bloom_desc_sets[1];
+    return r->composite_desc_set && r->bloom_desc_sets[0] && r->bloom_desc_sets[1];
 }
 
 /* ================================================================
    RENDER NODE CALLBACKS
    ================================================================ */
 
-/* Pass 0: CSM shadow maps */
+/* ----------------------------------------------------------------
+   Bind tracking for sorted draw lists.  Neighbouring draws usually
+   share a material or mesh, so binds are issued only on change and
+   the elided ones are reported through qs_renderer_add_draw_stats.
+   ---------------------------------------------------------------- */
+typedef struct DrawBinds {
+    const Qs_GpuPipeline      *pipeline;
+    const Qs_GpuDescriptorSet *material_set;
+    const Qs_GpuBuffer        *position_buffer;
+    const Qs_GpuBuffer        *attribute_buffer;
+    const Qs_GpuBuffer        *index_buffer;
+    uint32_t                   material_id;
+    uint32_t                   draws;
+    uint32_t                   binds;
+    uint32_t                   skipped;
+    bool                       attributes; /* bind the attribute stream; depth-only
+                                              passes read positions alone */
+} DrawBinds;
+
+static void draw_binds_reset(DrawBinds *b)
+{
+    b->pipeline         = NULL;
+    b->material_set     = NULL;
+    b->position_buffer  = NULL;
+    b->attribute_buffer = NULL;
+    b->index_buffer     = NULL;
+    b->material_id      = UINT32_MAX;
+}
+
+static void draw_batch(Qs_GpuCmd *cmd, DrawBinds *b, const Qs_Renderable *ren,
+                       const Qs_FrameAlloc *commands, uint32_t command)
+{
+    if (ren->position_buffer != b->position_buffer) {
+        qs_cmd_bind_vertex_buffer(cmd, 0, ren->position_buffer, 0);
+        b->position_buffer = ren->position_buffer;
+        b->binds++;
+    } else {
+        b->skipped++;
+    }
+    if (b->attributes) {
+        if (ren->attribute_buffer != b->attribute_buffer) {
+            qs_cmd_bind_vertex_buffer(cmd, 1, ren->attribute_buffer, 0);
+            b->attribute_buffer = ren->attribute_buffer;
+            b->binds++;
+        } else {
+            b->skipped++;
+        }
+    }
+    if (ren->index_buffer) {
+        if (ren->index_buffer != b->index_buffer) {
+            qs_cmd_bind_index_buffer(cmd, ren->index_buffer, ren->index_16bit);
+            b->index_buffer = ren->index_buffer;
+            b->binds++;
+        } else {
+            b->skipped++;
+        }
+    }
+    uint64_t offset = commands->offset + (uint64_t)command * sizeof(PbrDrawCommand);
+    if (ren->index_count > 0)
+        qs_cmd_draw_indexed_indirect(cmd, commands->buffer, offset, 1, sizeof(PbrDrawCommand));
+    else
+        qs_cmd_draw_indirect(cmd, commands->buffer, offset, 1, sizeof(PbrDrawCommand));
+    b->draws++;
+}
+
+/* ----------------------------------------------------------------
+   Range recorders for qs_renderer_record_draws.  Each range starts
+   from unbound state and keeps its own bind counters; they are summed
+   into the frame stats once the pass is recorded.
+   ---------------------------------------------------------------- */
+typedef struct PassRecord {
+    PbrRenderer            *r;
+    PbrPassResources       *ps;
+    const Qs_RenderContext *ctx;
+    Qs_GpuPipeline         *pipeline;
+    const PbrDrawQueue     *queue;    /* shadow: queue being drawn */
+    PbrForwardPass          pass;           /* forward: pass and MSAA tier */
+    uint32_t                tier;           /* of the variants drawn with */
+    uint32_t                equal_batches;  /* forward: batches below the depth
+                                               pre-pass covered use the equal
+                                               pass */
+    uint32_t                late_batches;   /* forward: batches below draw the
+                                               late cull's commands */
+    uint32_t                cascade;
+    uint32_t                ranges;
+    DrawBinds               binds[QS_RENDER_RECORD_RANGES_MAX];
+} PassRecord;
+
+static void pass_record_flush(PassRecord *rec)
+{
+    DrawBinds sum = {0};
+    for (uint32_t i = 0; i < rec->ranges; i++) {
+        sum.draws   += rec->binds[i].draws;
+        sum.binds   += rec->binds[i].binds;
+        sum.skipped += rec->binds[i].skipped;
+    }
+    qs_renderer_add_draw_stats(rec->ctx->renderer, sum.draws, sum.binds, sum.skipped);
+}
+
+static void shadow_record_range(Qs_GpuCmd *cmd, uint32_t range,
+                                uint32_t begin, uint32_t end, void *user_data)
+{
+    PassRecord         *rec = user_data;
+    PbrRenderer        *r   = rec->r;
+    PbrPassResources   *ps  = rec->ps;
+    const PbrDrawQueue *sq  = rec->queue;
+    DrawBinds *binds = &rec->binds[range];
+    *binds = (DrawBinds){ .binds = 2 };
+    draw_binds_reset(binds);
+
+    qs_cmd_bind_pipeline(cmd, ps->shadow_pipeline);
+    qs_cmd_bind_descriptor_set(cmd, ps->shadow_layout, 0,
+                               r->frame_desc_sets[rec->ctx->frame_slot]);
+    ShadowPC spc = { .cascade_idx = (int32_t)rec->cascade };
+    qs_cmd_push_constants(cmd, ps->shadow_layout,
+                          QS_GPU_SHADER_VERTEX, 0, sizeof(ShadowPC), &spc);
+    for (uint32_t bi = begin; bi < end; bi++) {
+        const PbrDrawBatch *b = &sq->batches[bi];
+        draw_batch(cmd, binds, &rec->ctx->renderables[sq->list.items[b->first]],
+                   &r->frame_commands, sq->first_command + bi);
+    }
+}
+
+/* Depth pre-pass: the opaque forward batches in prepass_list order. */
+static void prepass_record_range(Qs_GpuCmd *cmd, uint32_t range,
+                                 uint32_t begin, uint32_t end, void *user_data)
+{
+    PassRecord         *rec = user_data;
+    PbrRenderer        *r   = rec->r;
+    const PbrDrawQueue *fq  = &r->forward_queue;
+    DrawBinds *binds = &rec->binds[range];
+    *binds = (DrawBinds){ .binds = 2 };
+    draw_binds_reset(binds);
+
+    qs_cmd_bind_pipeline(cmd, rec->pipeline);
+    qs_cmd_bind_descriptor_set(cmd, rec->ps->forward_layout, 0,
+                               r->frame_desc_sets[rec->ctx->frame_slot]);
+    for (uint32_t i = begin; i < end; i++) {
+        uint32_t            bi = r->prepass_list.items[i];
+        const PbrDrawBatch *b  = &fq->batches[bi];
+        draw_batch(cmd, binds, &rec->ctx->renderables[fq->list.items[b->first]],
+                   &r->frame_commands, fq->first_command + bi);
+    }
+}
+
+/* Creates the variants the forward batches need that do not exist yet.
+   Runs before the batches are recorded, on one thread: the ranges only
+   look variants up.  A variant that failed is not retried. */
+static void forward_variants_prepare(Qs_GpuContext *gpu, PbrPassResources *ps,
+                                     const PassRecord *rec)
+{
+    const PbrDrawQueue *fq = &rec->r->forward_queue;
+    for (uint32_t bi = 0; bi < fq->batch_count; bi++) {
+        const Qs_Renderable *ren = &rec->ctx->renderables[fq->list.items[fq->batches[bi].first]];
+        PbrForwardPass pass = bi < rec->equal_batches ? PBR_FORWARD_EQUAL : rec->pass;
+        uint32_t features = pbr_material_features(&ren->material_params);
+        if (!ps->forward_variants[pass][rec->tier][features] &&
+            !(ps->variant_failed[pass][rec->tier] & (1ull << features)))
+            create_forward_variant(gpu, ps, pass, rec->tier, features);
+    }
+}
+
+static void forward_record_range(Qs_GpuCmd *cmd, uint32_t range,
+                                 uint32_t begin, uint32_t end, void *user_data)
+{
+    PassRecord         *rec = user_data;
+    PbrRenderer        *r   = rec->r;
+    PbrPassResources   *ps  = rec->ps;
+    const PbrDrawQueue *fq  = &r->forward_queue;
+    DrawBinds *binds = &rec->binds[range];
+    *binds = (DrawBinds){ .binds = 1, .attributes = true };
+    draw_binds_reset(binds);
+
+    qs_cmd_bind_descriptor_set(cmd, ps->forward_layout, 0,
+                               r->frame_desc_sets[rec->ctx->frame_slot]);
+    if (ps->bindless) {
+        qs_cmd_bind_descriptor_set(cmd, ps->forward_layout, 1, qs_material_bindless_set());
+        binds->binds++;
+    }
+    for (uint32_t bi = begin; bi < end; bi++) {
+        const PbrDrawBatch  *b   = &fq->batches[bi];
+        const Qs_Renderable *ren = &rec->ctx->renderables[fq->list.items[b->first]];
+        Qs_GpuPipeline *pipeline = forward_variant(ps,
+            bi < rec->equal_batches ? PBR_FORWARD_EQUAL : rec->pass, rec->tier,
+            pbr_material_features(&ren->material_params));
+        if (pipeline != binds->pipeline) {
+            qs_cmd_bind_pipeline(cmd, pipeline);
+            binds->pipeline = pipeline;
+            binds->binds++;
+        } else {
+            binds->skipped++;
+        }
+        if (!ps->bindless) {
+            if (ren->material_id != binds->material_id) {
+                PbrGpuMaterial mpc;
+                pbr_write_material(&mpc, &ren->material_params);
+                qs_cmd_push_constants(cmd, ps->forward_layout, QS_GPU_SHADER_FRAGMENT,
+                                      0, sizeof(PbrGpuMaterial), &mpc);
+                binds->material_id = ren->material_id;
+            }
+            if (ren->material_set != binds->material_set) {
+                qs_cmd_bind_descriptor_set(cmd, ps->forward_layout, 1, ren->material_set);
+                binds->material_set = ren->material_set;
+                binds->binds++;
+            } else {
+                binds->skipped++;
+            }
+        }
+        bool late = bi < rec->late_batches;
+        draw_batch(cmd, binds, ren, late ? &r->late_commands : &r->frame_commands,
+                   late ? bi : fq->first_command + bi);
+    }
+}
+
+/* Grows the GPU scene to hold at least count objects and points frame
+   binding 6 and binding 0 of both cull sets of every frame slot at it.  Destroying the
+   old buffer idles the device, so no slot's sets are in flight when they
+   are rewritten.  A new buffer starts empty, so the next upload is a full
+   one.  Only called from the prepare node, before any pass of this frame
+   has bound the descriptor sets. */
+static bool object_buffer_reserve(PbrRenderer *r, uint32_t count)
+{
+    if (r->object_buffer && count <= r->object_capacity) return true;
+    uint32_t cap = r->object_capacity ? r->object_capacity : PBR_OBJECT_INITIAL_CAPACITY;
+    while (cap < count) cap *= 2;
+
+    Qs_GpuBuffer *buf = qs_gpu_create_buffer(r->gpu, &(Qs_GpuBufferDesc){
+        .size=(uint64_t)cap*sizeof(PbrGpuObject),
+        .usage=QS_GPU_BUFFER_STORAGE,.memory=QS_GPU_MEMORY_DEVICE_LOCAL});
+    Qs_GpuBufferCopy *copies = realloc(r->object_copies, cap * sizeof(Qs_GpuBufferCopy));
+    if (copies) r->object_copies = copies;
+    if (!buf || !copies) {
+        qs_gpu_destroy_buffer(r->gpu, buf);
+        return false;
+    }
+    qs_gpu_destroy_buffer(r->gpu, r->object_buffer);
+    r->object_buffer   = buf;
+    r->object_capacity = cap;
+    r->objects_stale   = true;
+    for (uint32_t i = 0; i < QS_RENDER_FRAMES_IN_FLIGHT; i++) {
+        qs_gpu_write_buffer_descriptor(r->gpu, r->frame_desc_sets[i], 6,
+                                       QS_GPU_DESCRIPTOR_STORAGE_BUFFER, buf, 0, 0);
+        if (r->cull_desc_sets[i])
+            qs_gpu_write_buffer_descriptor(r->gpu, r->cull_desc_sets[i], 0,
+                                           QS_GPU_DESCRIPTOR_STORAGE_BUFFER, buf, 0, 0);
+        if (r->late_cull_desc_sets[i])
+            qs_gpu_write_buffer_descriptor(r->gpu, r->late_cull_desc_sets[i], 0,
+                                           QS_GPU_DESCRIPTOR_STORAGE_BUFFER, buf, 0, 0);
+    }
+    return true;
+}
+
+/* Grows the CPU staging of the indirect commands and cull items. */
+static bool draw_staging_reserve(PbrRenderer *r, uint32_t count)
+{
+    if (r->draw_commands && count <= r->draw_capacity) return true;
+    uint32_t cap = r->draw_capacity ? r->draw_capacity : PBR_DRAW_INITIAL_CAPACITY;
+    while (cap < count) cap *= 2;
+
+    PbrDrawCommand *commands = realloc(r->draw_commands, cap * sizeof(PbrDrawCommand));
+    if (commands) r->draw_commands = commands;
+    PbrCullItem *items = realloc(r->draw_items, cap * sizeof(PbrCullItem));
+    if (items) r->draw_items = items;
+    if (!commands || !items) return false;
+    r->draw_capacity = cap;
+    return true;
+}
+
+/* Brings the GPU scene up to date: every object after a (re)allocation,
+   otherwise only the engine's dirty proxies.  Records are staged in the
+   frame arena; runs of consecutive indices share one copy region.  The
+   material table takes the parameters of the same proxies. */
+static void gpu_scene_upload(PbrRenderer *r, const Qs_RenderContext *ctx)
+{
+    uint32_t n     = ctx->renderable_count;
+    bool     full  = r->objects_stale;
+    uint32_t count = full ? n : ctx->dirty_count;
+    if (count == 0) { r->objects_stale = false; return; }
+
+    const uint64_t stride = sizeof(PbrGpuObject);
+    Qs_FrameAlloc staging;
+    if (!qs_renderer_frame_alloc(ctx, count * stride, &staging)) {
+        r->objects_stale = true;
+        return;
+    }
+    PbrGpuObject *objects = staging.data;
+    uint32_t written = 0, regions = 0;
+    for (uint32_t k = 0; k < count; k++) {
+        uint32_t i = full ? k : ctx->dirty[k];
+        if (i >= n) continue;
+        const Qs_Renderable *ren = &ctx->renderables[i];
+        pbr_write_object(&objects[written], ctx->transforms[i], ren, ctx->bounds, i);
+        if (ren->material_id < QS_MAX_MATERIALS) {
+            pbr_write_material(&r->materials[ren->material_id], &ren->material_params);
+            if (ren->material_id >= r->material_count) r->material_count = ren->material_id + 1;
+        }
+        Qs_GpuBufferCopy *last = regions ? &r->object_copies[regions - 1] : NULL;
+        if (last && last->dst_offset + last->size == i * stride)
+            last->size += stride;
+        else
+            r->object_copies[regions++] = (Qs_GpuBufferCopy){
+                .src_offset = staging.offset + written * stride,
+                .dst_offset = i * stride, .size = stride };
+        written++;
+    }
+    r->objects_stale = false;
+    if (regions == 0) return;
+
+    /* The previous frame may still be reading the records being replaced */
+    qs_cmd_buffer_barrier(ctx->cmd, &(Qs_GpuBufferBarrier){
+        .buffer=r->object_buffer,.src=QS_GPU_ACCESS_COMPUTE_READ|QS_GPU_ACCESS_VERTEX_READ,
+        .dst=QS_GPU_ACCESS_TRANSFER_WRITE});
+    qs_cmd_copy_buffer(ctx->cmd, staging.buffer, r->object_buffer,
+                       r->object_copies, regions);
+    qs_cmd_buffer_barrier(ctx->cmd, &(Qs_GpuBufferBarrier){
+        .buffer=r->object_buffer,.src=QS_GPU_ACCESS_TRANSFER_WRITE,
+        .dst=QS_GPU_ACCESS_COMPUTE_READ|QS_GPU_ACCESS_VERTEX_READ});
+}
+
+/* Copies the matrix each cascade was last rendered with into this
+   frame's shadow UBO (frame binding 2).  Written every frame so the
+   forward pass never samples through a binding left pointing at a
+   recycled arena. */
+static bool shadow_ubo_write(PbrRenderer *r, const Qs_RenderContext *ctx)
+{
+    Qs_FrameAlloc ubo;
+    if (!qs_renderer_frame_alloc(ctx, sizeof(ShadowUBO), &ubo)) return false;
+    ShadowUBO *subo = ubo.data;
+    memcpy(subo->cascade_vp, r->shadow.matrices, sizeof(subo->cascade_vp));
+    qs_gpu_write_buffer_descriptor(r->gpu, r->frame_desc_sets[ctx->frame_slot], 2,
+                                   QS_GPU_DESCRIPTOR_UNIFORM_BUFFER, ubo.buffer,
+                                   ubo.offset, sizeof(ShadowUBO));
+    return true;
+}
+
+/* Copies the material table into this frame's arena and points frame
+   binding 9 at it; bindless forward pipelines only. */
+static bool material_table_write(PbrRenderer *r, const Qs_RenderContext *ctx)
+{
+    if (r->material_count == 0) return true;
+    uint64_t size = (uint64_t)r->material_count * sizeof(PbrGpuMaterial);
+    Qs_FrameAlloc buf;
+    if (!qs_renderer_frame_alloc(ctx, size, &buf)) return false;
+    memcpy(buf.data, r->materials, size);
+    qs_gpu_write_buffer_descriptor(r->gpu, r->frame_desc_sets[ctx->frame_slot], 9,
+                                   QS_GPU_DESCRIPTOR_STORAGE_BUFFER, buf.buffer, buf.offset, size);
+    return true;
+}
+
+/* Bins this frame's lights into the view-space clusters and points frame
+   binding 8 at the grid.  The CPU binning fills in every cluster range;
+   with GPU binning only the global lights are listed up front and the
+   cluster dispatch writes the ranges, each cluster owning
+   PBR_CLUSTER_GPU_LIGHTS index slots past them. */
+static bool light_grid_write(PbrRenderer *r, const Qs_RenderContext *ctx,
+                             const PbrPassResources *ps)
+{
+    PbrLightGrid        *g           = &r->light_grid;
+    Qs_GpuDescriptorSet *cluster_set = r->cluster_desc_sets[ctx->frame_slot];
+    bool gpu_bin = g_pp_settings.gpu_light_binning && ps->cluster_pipeline && cluster_set;
+    pbr_light_grid_setup(g, ctx->proj);
+    if (!pbr_light_grid_build(g, ctx->view, ctx->lights, ctx->light_count, !gpu_bin))
+        return false;
+
+    uint32_t indices = gpu_bin
+        ? g->header.global_count + PBR_CLUSTER_COUNT * PBR_CLUSTER_GPU_LIGHTS
+        : g->index_count;
+    uint64_t size = sizeof(PbrLightGridHeader) + (uint64_t)indices * sizeof(uint32_t);
+    Qs_FrameAlloc buf;
+    if (!qs_renderer_frame_alloc(ctx, size, &buf)) return false;
+    memcpy(buf.data, &g->header, sizeof(PbrLightGridHeader));
+    memcpy((char *)buf.data + sizeof(PbrLightGridHeader), g->indices,
+           (gpu_bin ? g->header.global_count : g->index_count) * sizeof(uint32_t));
+    qs_gpu_write_buffer_descriptor(r->gpu, r->frame_desc_sets[ctx->frame_slot], 8,
+                                   QS_GPU_DESCRIPTOR_STORAGE_BUFFER, buf.buffer, buf.offset, size);
+    if (!gpu_bin) return true;
+
+    qs_gpu_write_buffer_descriptor(r->gpu, cluster_set, 1, QS_GPU_DESCRIPTOR_STORAGE_BUFFER,
+                                   buf.buffer, buf.offset, size);
+    ClusterPC cpc = {
+        .proj  = { ctx->proj[0], ctx->proj[5], g->z_near, g->z_far },
+        .ortho = g->ortho,
+    };
+    memcpy(cpc.view, ctx->view, sizeof(cpc.view));
+    qs_cmd_bind_pipeline(ctx->cmd, ps->cluster_pipeline);
+    qs_cmd_bind_descriptor_set(ctx->cmd, ps->cluster_layout, 0, cluster_set);
+    qs_cmd_push_constants(ctx->cmd, ps->cluster_layout, QS_GPU_SHADER_COMPUTE,
+                          0, sizeof(ClusterPC), &cpc);
+    qs_cmd_dispatch(ctx->cmd, PBR_CLUSTER_COUNT / PBR_CLUSTER_GROUP_SIZE, 1, 1);
+    qs_cmd_buffer_barrier(ctx->cmd, &(Qs_GpuBufferBarrier){
+        .buffer=buf.buffer,.src=QS_GPU_ACCESS_COMPUTE_WRITE,.dst=QS_GPU_ACCESS_FRAGMENT_READ});
+    return true;
+}
+
+/* Draws no cascade this frame and redraws them all at the next one:
+   the scheduled cascades were already marked as rendered. */
+static void shadow_frame_abort(PbrRenderer *r)
+{
+    pbr_shadow_invalidate(&r->shadow);
+    r->shadow.due = r->shadow.rebuild = 0;
+}
+
+/* Lists the opaque forward batches — a prefix of the queue, whose keys
+   lead with the alpha mode — front to back by their nearest entry when
+   the depth pre-pass pays off this frame.  Alpha-tested and blended
+   draws are left to the lit pass's LESS test. */
+static void prepass_build(PbrRenderer *r, const Qs_RenderContext *ctx,
+                          const float view_proj[16])
+{
+    const PbrDrawQueue *fq = &r->forward_queue;
+    PbrDepthPrepass mode = g_pp_settings.depth_prepass;
+    if (mode == PBR_DEPTH_PREPASS_OFF || ctx->wireframe) return;
+
+    uint32_t opaque = 0;
+    while (opaque < fq->batch_count &&
+           ctx->renderables[fq->list.items[fq->batches[opaque].first]].alpha_mode
+               == QS_ALPHA_MODE_OPAQUE)
+        opaque++;
+    if (opaque == 0) return;
+
+    if (mode == PBR_DEPTH_PREPASS_AUTO) {
+        PbrOverdrawEstimate est;
+        pbr_estimate_overdraw(fq, opaque, ctx->renderables, ctx->bounds, view_proj, &est);
+        float pixels = (float)ctx->width * (float)ctx->height;
+        if (est.coverage < PBR_PREPASS_MIN_OVERDRAW ||
+            (float)est.triangles > pixels * PBR_PREPASS_MAX_TRIANGLES_PER_PIXEL)
+            return;
+    }
+
+    const uint64_t depth_mask = (1u << QS_DRAW_KEY_DEPTH_BITS) - 1u;
+    for (uint32_t bi = 0; bi < opaque; bi++)
+        qs_draw_list_push(&r->prepass_list,
+                          fq->list.keys[fq->batches[bi].first] & depth_mask, bi);
+    qs_draw_list_sort(&r->prepass_list);
+}
+
+/* Forward batches occlusion-culled this frame: the non-blended prefix of
+   the queue, or none when culling runs on the CPU, in wireframe, or
+   without the pipelines, a pyramid matching the viewport or depth. */
+static uint32_t occlusion_batch_count(const PbrRenderer *r, const PbrPassResources *ps,
+                                      const Qs_RenderContext *ctx)
+{
+    uint32_t slot = ctx->frame_slot;
+    if (!g_pp_settings.occlusion_culling || ctx->wireframe ||
+        !ps->hiz_seed_pipeline || !ps->hiz_seed_ms_pipeline ||
+        !ps->hiz_reduce_pipeline || !ps->occlusion_pipeline ||
+        !r->hiz_buffer || !r->late_cull_desc_sets[slot] || !r->hiz_desc_sets[slot] ||
+        r->hiz_layout.depth_width != ctx->width || r->hiz_layout.depth_height != ctx->height ||
+        !qs_renderer_depth_view(ctx->renderer))
+        return 0;
+
+    const PbrDrawQueue *fq = &r->forward_queue;
+    uint32_t n = 0;
+    while (n < fq->batch_count &&
+           ctx->renderables[fq->list.items[fq->batches[n].first]].alpha_mode
+               != QS_ALPHA_MODE_BLEND)
+        n++;
+    return n;
+}
+
+/* Grows the caster selection scratch to count indices. */
+static bool caster_scratch_reserve(PbrRenderer *r, uint32_t count)
+{
+    if (r->caster_scratch && count <= r->caster_capacity) return true;
+    uint32_t cap = r->caster_capacity ? r->caster_capacity : PBR_DRAW_INITIAL_CAPACITY;
+    while (cap < count) cap *= 2;
+    uint32_t *scratch = realloc(r->caster_scratch, cap * sizeof(uint32_t));
+    if (!scratch) return false;
+    r->caster_scratch  = scratch;
+    r->caster_capacity = cap;
+    return true;
+}
+
+/* Prepare: schedules the cascades, writes the shadow UBO, bins the
+   lights, updates the GPU scene, sorts and batches the shadow and forward
+   draws into one indirect command per batch, then culls.  The shadow
+   queues come first in the item / visible buffers, cascade by cascade
+   (static, then dynamic), and forward draws follow.
+     shadow:  per due cascade, the casters pbr_csm_select_casters keeps
+              for it, split by pbr_shadow_classify into the static queue
+              (cache rebuilds only) and the dynamic one.  Keyed by mesh
+              only — depth-only draws differ in geometry alone — and not
+              culled again.
+     forward: every lit draw in ctx->visible (inside the frustum and not
+              behind the engine's CPU occluders), grouped by alpha mode
+              (the pipeline slot), material and mesh, front-to-back
+              within a group; blended draws follow back-to-front.  Depth
+              is the view-space distance of the model origin over the far
+              plane.  Culled against the camera frustum again per
+              instance.  prepass_build orders the
+              opaque batches for the depth pre-pass.  With occlusion
+              culling the non-blended batches are also occlusion-tested
+              and mirrored by the late cull's commands, whose visible
+              ranges follow all the early ones.
+   The cull runs as a compute dispatch, or through pbr_cull_reference
+   when GPU culling is off or its pipeline is unavailable.  Commands,
+   items and visible indices are allocated from this frame's arena and
+   this slot's frame and cull sets are pointed at them. */
+static void prepare_pass_execute(const Qs_RenderContext *ctx, void *user_data)
+{
+    PbrRenderer      *r  = user_data;
+    PbrPassResources *ps = pbr_renderer_pass_resources();
+    PbrDrawQueue     *sq = r->shadow_queue;
+    PbrDrawQueue     *cq = r->static_queue;
+    PbrDrawQueue     *fq = &r->forward_queue;
+    for (int c=0; c<QS_CSM_CASCADES; c++) {
+        sq[c].list.count = sq[c].batch_count = 0;
+        cq[c].list.count = cq[c].batch_count = 0;
+        r->shadow_casters[c] = 0;
+    }
+    fq->list.count = fq->batch_count = 0;
+    r->prepass_list.count = 0;
+    r->occlusion_batches  = 0;
+    r->shadow.due = r->shadow.rebuild = 0;
+    if (!ps || !ps->ok || !r->ok) { r->objects_stale = true; return; }
+
+    float cascades[QS_CSM_CASCADES][16];
+    pbr_csm_compute(ctx->camera, ctx->lights, ctx->light_count, cascades);
+    if (!pbr_shadow_begin_frame(&r->shadow, ctx->dirty, ctx->dirty_count,
+                                ctx->renderable_count)) {
+        QS_LOG_ERROR("PBR Renderer: cannot track %u shadow casters", ctx->renderable_count);
+        shadow_frame_abort(r);
+        r->objects_stale = true;
+        return;
+    }
+    uint32_t due = pbr_shadow_schedule(&r->shadow, cascades);
+    if (!shadow_ubo_write(r, ctx)) {
+        QS_LOG_ERROR("PBR Renderer: frame arena exhausted");
+        shadow_frame_abort(r);
+        r->objects_stale = true;
+        return;
+    }
+    if (!light_grid_write(r, ctx, ps)) {
+        QS_LOG_ERROR("PBR Renderer: cannot bin %u lights", ctx->light_count);
+        shadow_frame_abort(r);
+        r->objects_stale = true;
+        return;
+    }
+
+    uint32_t n = ctx->renderable_count;
+    if (!object_buffer_reserve(r, n)) {
+        QS_LOG_ERROR("PBR Renderer: cannot grow GPU scene to %u objects", n);
+        shadow_frame_abort(r);
+        r->objects_stale = true;
+        return;
+    }
+    gpu_scene_upload(r, ctx);
+    if (ps->bindless && !material_table_write(r, ctx)) {
+        QS_LOG_ERROR("PBR Renderer: frame arena exhausted");
+        shadow_frame_abort(r);
+        r->objects_stale = true;
+        return;
+    }
+
+    bool queues_ok = pbr_draw_queue_reserve(fq, n) && caster_scratch_reserve(r, n) &&
+                     qs_draw_list_reserve(&r->prepass_list, n);
+    for (int c=0; c<QS_CSM_CASCADES; c++)
+        queues_ok = queues_ok && pbr_draw_queue_reserve(&sq[c], n) &&
+                    pbr_draw_queue_reserve(&cq[c], n);
+    if (!queues_ok) {
+        QS_LOG_ERROR("PBR Renderer: cannot grow draw queues to %u draws", n);
+        shadow_frame_abort(r);
+        return;
+    }
+
+    uint32_t total = 0;
+    for (uint32_t c=0; c<QS_CSM_CASCADES; c++) {
+        if (!(due & (1u << c))) continue;
+        uint32_t casters = pbr_csm_select_casters(r->shadow.matrices, c, ctx->bounds,
+                                                  ctx->renderables, r->caster_scratch);
+        for (uint32_t k=0; k<casters; k++) {
+            uint32_t ri = r->caster_scratch[k];
+            PbrCasterPass pass = pbr_shadow_classify(&r->shadow, c, ri);
+            if (pass == PBR_CASTER_SKIP) continue;
+            PbrDrawQueue *q = (pass == PBR_CASTER_CACHE) ? &cq[c] : &sq[c];
+            qs_draw_list_push(&q->list,
+                              qs_draw_key_opaque(0, 0, 0, ctx->renderables[ri].mesh_id, 0.0f), ri);
+        }
+        r->shadow_casters[c] = cq[c].list.count + sq[c].list.count;
+        total += r->shadow_casters[c];
+    }
+
+    const Qs_Camera *cam = ctx->camera;
+    float inv_far = (cam && cam->far_plane > 0.0f) ? 1.0f / cam->far_plane : 0.0f;
+    for (uint32_t vi=0; vi<ctx->visible_count; vi++) {
+        uint32_t ri = ctx->visible[vi];
+        const Qs_Renderable *ren = &ctx->renderables[ri];
+        if (!ren->position_buffer || !ren->material_set) continue;
+        const float *m = ctx->transforms[ri];
+        float depth = -(ctx->view[2]*m[12] + ctx->view[6]*m[13]
+                      + ctx->view[10]*m[14] + ctx->view[14]) * inv_far;
+        qs_draw_list_push(&fq->list, pbr_forward_key(ren, depth, ps->bindless), ri);
+    }
+
+    total += fq->list.count;
+    if (total == 0) return;
+    if (!draw_staging_reserve(r, total)) {
+        QS_LOG_ERROR("PBR Renderer: cannot grow draw buffers to %u draws", total);
+        for (int c=0; c<QS_CSM_CASCADES; c++) sq[c].list.count = cq[c].list.count = 0;
+        fq->list.count = 0;
+        shadow_frame_abort(r);
+        return;
+    }
+
+    uint32_t instances = 0, commands = 0;
+    for (int c=0; c<QS_CSM_CASCADES; c++) {
+        PbrDrawQueue *queues[2] = { &cq[c], &sq[c] };
+        for (int k=0; k<2; k++) {
+            PbrDrawQueue *q = queues[k];
+            qs_draw_list_sort(&q->list);
+            pbr_draw_queue_batch(q, ctx->renderables, PBR_BATCH_MESH);
+            q->first_instance = instances;
+            q->first_command  = commands;
+            instances += q->list.count;
+            commands  += q->batch_count;
+            pbr_write_draws(q, ctx->renderables, PBR_CULL_NONE, r->draw_commands, r->draw_items);
+        }
+    }
+    qs_draw_list_sort(&fq->list);
+    pbr_draw_queue_batch(fq, ctx->renderables,
+                         ps->bindless ? PBR_BATCH_FEATURES : PBR_BATCH_MATERIAL);
+    fq->first_instance = instances;
+    fq->first_command  = commands;
+    commands += fq->batch_count;
+
+    Qs_GpuDescriptorSet *frame_set = r->frame_desc_sets[ctx->frame_slot];
+    Qs_GpuDescriptorSet *cull_set  = r->cull_desc_sets[ctx->frame_slot];
+    Qs_GpuDescriptorSet *late_set  = r->late_cull_desc_sets[ctx->frame_slot];
+    bool gpu_cull = g_pp_settings.gpu_culling && ps->cull_pipeline && cull_set;
+    uint32_t late = gpu_cull ? occlusion_batch_count(r, ps, ctx) : 0;
+    pbr_write_draws(fq, ctx->renderables, late ? PBR_CULL_OCCLUSION : PBR_CULL_FRUSTUM,
+                    r->draw_commands, r->draw_items);
+
+    float view_proj[16];
+    qs_m4_mul(ctx->proj, ctx->view, view_proj);
+    prepass_build(r, ctx, view_proj);
+    Qs_Frustum frustum;
+    qs_frustum_from_matrix(&frustum, view_proj);
+
+    uint64_t command_size = commands * sizeof(PbrDrawCommand);
+    uint64_t late_size    = late * sizeof(PbrDrawCommand);
+    uint64_t item_size    = total * sizeof(PbrCullItem);
+    uint64_t visible_size = (total + (late ? fq->list.count : 0)) * sizeof(uint32_t);
+    Qs_FrameAlloc items, visible;
+    if (!qs_renderer_frame_alloc(ctx, command_size, &r->frame_commands) ||
+        !qs_renderer_frame_alloc(ctx, visible_size, &visible) ||
+        (gpu_cull && !qs_renderer_frame_alloc(ctx, item_size, &items)) ||
+        (late && !qs_renderer_frame_alloc(ctx, late_size, &r->late_commands))) {
+        QS_LOG_ERROR("PBR Renderer: frame arena exhausted");
+        for (int c=0; c<QS_CSM_CASCADES; c++) sq[c].batch_count = cq[c].batch_count = 0;
+        fq->batch_count = 0;
+        r->prepass_list.count = 0;
+        shadow_frame_abort(r);
+        return;
+    }
+    qs_gpu_write_buffer_descriptor(r->gpu, frame_set, 7, QS_GPU_DESCRIPTOR_STORAGE_BUFFER,
+                                   visible.buffer, visible.offset, visible_size);
+
+    if (!gpu_cull) {
+        pbr_cull_reference(&frustum, ctx->bounds, r->draw_items, total,
+                           r->draw_commands, visible.data);
+        memcpy(r->frame_commands.data, r->draw_commands, command_size);
+        return;
+    }
+    memcpy(r->frame_commands.data, r->draw_commands, command_size);
+    memcpy(items.data, r->draw_items, item_size);
+    qs_gpu_write_buffer_descriptor(r->gpu, cull_set, 1, QS_GPU_DESCRIPTOR_STORAGE_BUFFER,
+                                   items.buffer, items.offset, item_size);
+    qs_gpu_write_buffer_descriptor(r->gpu, cull_set, 2, QS_GPU_DESCRIPTOR_STORAGE_BUFFER,
+                                   r->frame_commands.buffer, r->frame_commands.offset, command_size);
+    qs_gpu_write_buffer_descriptor(r->gpu, cull_set, 3, QS_GPU_DESCRIPTOR_STORAGE_BUFFER,
+                                   visible.buffer, visible.offset, visible_size);
+    if (late) {
+        PbrDrawCommand *lc = r->late_commands.data;
+        r->late_shift        = total - fq->first_instance;
+        r->occlusion_batches = late;
+        memcpy(lc, r->draw_commands + fq->first_command, late_size);
+        for (uint32_t bi = 0; bi < late; bi++) {
+            if (ctx->renderables[fq->list.items[fq->batches[bi].first]].index_count > 0)
+                lc[bi].indexed.first_instance += r->late_shift;
+            else
+                lc[bi].direct.first_instance  += r->late_shift;
+        }
+        qs_gpu_write_buffer_descriptor(r->gpu, late_set, 1, QS_GPU_DESCRIPTOR_STORAGE_BUFFER,
+                                       items.buffer, items.offset, item_size);
+        qs_gpu_write_buffer_descriptor(r->gpu, late_set, 2, QS_GPU_DESCRIPTOR_STORAGE_BUFFER,
+                                       r->late_commands.buffer, r->late_commands.offset, late_size);
+        qs_gpu_write_buffer_descriptor(r->gpu, late_set, 3, QS_GPU_DESCRIPTOR_STORAGE_BUFFER,
+                                       visible.buffer, visible.offset, visible_size);
+    }
+
+    CullPC cpc = { .item_count = total };
+    memcpy(cpc.planes, frustum.planes, sizeof(cpc.planes));
+    qs_cmd_bind_pipeline(ctx->cmd, ps->cull_pipeline);
+    qs_cmd_bind_descriptor_set(ctx->cmd, ps->cull_layout, 0, cull_set);
+    qs_cmd_push_constants(ctx->cmd, ps->cull_layout, QS_GPU_SHADER_COMPUTE,
+                          0, sizeof(CullPC), &cpc);
+    qs_cmd_dispatch(ctx->cmd, (total + PBR_CULL_GROUP_SIZE - 1) / PBR_CULL_GROUP_SIZE, 1, 1);
+    qs_cmd_buffer_barrier(ctx->cmd, &(Qs_GpuBufferBarrier){
+        .buffer=r->frame_commands.buffer,.src=QS_GPU_ACCESS_COMPUTE_WRITE,
+        .dst=QS_GPU_ACCESS_INDIRECT_READ|QS_GPU_ACCESS_VERTEX_READ});
+}
+
+static void shadow_image_barrier(Qs_GpuCmd *cmd, Qs_GpuImage *image,
+                                 Qs_GpuImageLayout old_layout, Qs_GpuImageLayout new_layout,
+                                 Qs_GpuImageLayout wait_layout)
+{
+    qs_cmd_image_barrier(cmd, &(Qs_GpuImageBarrier){
+        .image=image,.old_layout=old_layout,.new_layout=new_layout,
+        .aspect=QS_GPU_IMAGE_ASPECT_DEPTH,.base_mip=0,.mip_count=1,
+        .wait_layout=wait_layout});
+}
+
+static void shadow_record_queue(PassRecord *rec, Qs_GpuImageView *view,
+                                bool load, const PbrDrawQueue *queue)
+{
+    rec->queue  = queue;
+    rec->ranges = qs_renderer_record_draws(rec->ctx, &(Qs_GpuRenderTarget){
+        .color=NULL,.depth=view,.clear_depth=1.0f,.load_depth=load,
+        .width=QS_SHADOW_MAP_SIZE,.height=QS_SHADOW_MAP_SIZE},
+        queue->batch_count, shadow_record_range, rec);
+    pass_record_flush(rec);
+}
+
+/* Pass 0: CSM shadow maps.  Only the cascades due this frame are drawn;
+   the rest keep their contents (the maps are persistent).  A due
+   cascade first redraws its static cache if scheduled, then copies the
+   cache into the map and draws the dynamic casters over it.  The graph
+   hands the maps over in DEPTH_ATTACHMENT and expects them back so. */
 static void shadow_pass_execute(const Qs_RenderContext *ctx, void *user_data)
 {
     PbrRenderer      *r  = user_data;
     PbrPassResources *ps = pbr_renderer_pass_resources();
     if (!ps || !ps->ok || !r->ok) return;
-    if (ctx->renderable_count == 0) return;
 
-    /* Update plugin-owned ShadowUBO (CSM matrices) */
-    Qs_Camera *cam = qs_renderer_camera(ctx->renderer);
-    compute_csm(cam, ctx->lights, ctx->light_count, r->shadow_matrices, r->shadow_splits);
+    PassRecord rec = { .r = r, .ps = ps, .ctx = ctx };
+    for (uint32_t cascade=0; cascade<QS_CSM_CASCADES; cascade++) {
+        uint32_t     bit = 1u << cascade;
+        Qs_GpuImage *map = qs_attachment_image(r->shadow_att[cascade]);
+        Qs_GpuImageView *sv = qs_attachment_view(r->shadow_att[cascade]);
+        if (!(r->shadow.due & bit) || !sv) continue;
+        rec.cascade = cascade;
+
+        Qs_GpuImage *cache  = r->shadow_cache_image[cascade];
+        bool         cached = r->shadow.cached_count[cascade] > 0;
+        if ((r->shadow.rebuild & bit) && cached) {
+            shadow_image_barrier(ctx->cmd, cache, QS_GPU_IMAGE_LAYOUT_UNDEFINED,
+                                 QS_GPU_IMAGE_LAYOUT_DEPTH_ATTACHMENT,
+                                 QS_GPU_IMAGE_LAYOUT_TRANSFER_SRC);
+            shadow_record_queue(&rec, r->shadow_cache_view[cascade], false,
+                                &r->static_queue[cascade]);
+            shadow_image_barrier(ctx->cmd, cache, QS_GPU_IMAGE_LAYOUT_DEPTH_ATTACHMENT,
+                                 QS_GPU_IMAGE_LAYOUT_TRANSFER_SRC,
+                                 QS_GPU_IMAGE_LAYOUT_UNDEFINED);
+        }
 
-    ShadowUBO *subo = qs_gpu_map_buffer(r->gpu, r->shadow_ubo);
-    if (subo) {
-        for (int c=0; c<QS_CSM_CASCADES; c++) {
-            memcpy(subo->cascade_vp[c], r->shadow_matrices[c], 64);
-            subo->cascade_splits[c] = r->shadow_splits[c+1];
+        if (cached) {
+            shadow_image_barrier(ctx->cmd, map, QS_GPU_IMAGE_LAYOUT_DEPTH_ATTACHMENT,
+                                 QS_GPU_IMAGE_LAYOUT_TRANSFER_DST,
+                                 QS_GPU_IMAGE_LAYOUT_UNDEFINED);
+            qs_cmd_copy_image(ctx->cmd, cache, map, QS_GPU_IMAGE_ASPECT_DEPTH,
+                              QS_SHADOW_MAP_SIZE, QS_SHADOW_MAP_SIZE);
+            shadow_image_barrier(ctx->cmd, map, QS_GPU_IMAGE_LAYOUT_TRANSFER_DST,
+                                 QS_GPU_IMAGE_LAYOUT_DEPTH_ATTACHMENT,
+                                 QS_GPU_IMAGE_LAYOUT_UNDEFINED);
         }
-        qs_gpu_unmap_buffer(r->gpu, r->shadow_ubo);
+        shadow_record_queue(&rec, sv, cached, &r->shadow_queue[cascade]);
     }
+}
 
-    for (int cascade=0; cascade<QS_CSM_CASCADES; cascade++) {
-        Qs_GpuImageView *sv  = qs_attachment_view(r->shadow_att[cascade]);
-        Qs_GpuImage     *img = qs_attachment_image(r->shadow_att[cascade]);
-        if (!sv || !img) continue;
+/* Creates the per-cascade static caster caches once; their size is fixed.
+   They stay outside the render graph, which never sees them. */
+static bool shadow_caches_create(PbrRenderer *r)
+{
+    for (int i=0; i<QS_CSM_CASCADES; i++) {
+        if (r->shadow_cache_view[i]) continue;
+        if (!r->shadow_cache_image[i])
+            r->shadow_cache_image[i] = qs_gpu_create_image(r->gpu, &(Qs_GpuImageDesc){
+                .width = QS_SHADOW_MAP_SIZE, .height = QS_SHADOW_MAP_SIZE, .mip_levels = 1,
+                .format = QS_GPU_FORMAT_D32_SFLOAT,
+                .usage  = QS_GPU_IMAGE_DEPTH_ATTACHMENT | QS_GPU_IMAGE_TRANSFER_SRC,
+            });
+        if (!r->shadow_cache_image[i]) return false;
+        r->shadow_cache_view[i] = qs_gpu_create_image_view_for(
+            r->gpu, r->shadow_cache_image[i], QS_GPU_IMAGE_ASPECT_DEPTH);
+        if (!r->shadow_cache_view[i]) return false;
+    }
+    return true;
+}
 
-        qs_cmd_image_barrier(ctx->cmd, &(Qs_GpuImageBarrier){
-            .image=img,.old_layout=QS_GPU_IMAGE_LAYOUT_SHADER_READ,
-            .new_layout=QS_GPU_IMAGE_LAYOUT_DEPTH_ATTACHMENT,
-            .aspect=QS_GPU_IMAGE_ASPECT_DEPTH,.base_mip=0,.mip_count=1});
+/* (Re)creates the plugin-owned MSAA color and depth targets for the
+   current sample-count setting.  They stay outside the render graph
+   since the sample count changes at runtime. */
+static void msaa_targets_rebuild(PbrRenderer *r, PbrPassResources *ps,
+                                 uint32_t w, uint32_t h)
+{
+    Qs_GpuContext *gpu = r->gpu;
 
-        qs_cmd_begin_rendering(ctx->cmd, &(Qs_GpuRenderTarget){
-            .color=NULL,.depth=sv,.clear_depth=1.0f,
-            .width=QS_SHADOW_MAP_SIZE,.height=QS_SHADOW_MAP_SIZE});
-        qs_cmd_set_viewport(ctx->cmd, QS_SHADOW_MAP_SIZE, QS_SHADOW_MAP_SIZE);
-        qs_cmd_bind_pipeline(ctx->cmd, ps->shadow_pipeline);
-        qs_cmd_bind_descriptor_set(ctx->cmd, ps->shadow_layout, 0, r->frame_desc_set);
-
-        for (uint32_t ri=0; ri<ctx->renderable_count; ri++) {
-            const Qs_Renderable *ren = &ctx->renderables[ri];
-            if (!ren->cast_shadows || !ren->vertex_buffer) continue;
-            typedef struct { float model[16]; int32_t cascade_idx; int32_t _p[3]; } ShadowPC;
-            ShadowPC spc; memcpy(spc.model, ren->transform, 64);
-            spc.cascade_idx=cascade; spc._p[0]=spc._p[1]=spc._p[2]=0;
-            qs_cmd_push_constants(ctx->cmd, ps->shadow_layout,
-                                  QS_GPU_SHADER_VERTEX, 0, sizeof(ShadowPC), &spc);
-            qs_cmd_bind_vertex_buffer(ctx->cmd, 0, ren->vertex_buffer, 0);
-            if (ren->index_buffer)
-                qs_cmd_bind_index_buffer(ctx->cmd, ren->index_buffer, ren->index_16bit);
-            if (ren->index_count > 0)
-                qs_cmd_draw_indexed(ctx->cmd, ren->index_count, 0, 0);
-            else
-                qs_cmd_draw(ctx->cmd, ren->vertex_count, 0);
+    uint32_t want = wanted_sample_count(ps);
+
+    /* Destroy old MSAA images whenever dimensions or sample count change */
+    if (r->msaa_color_view)  { qs_gpu_destroy_image_view(gpu, r->msaa_color_view);  r->msaa_color_view  = NULL; }
+    if (r->msaa_color_image) { qs_gpu_destroy_image(gpu, r->msaa_color_image);      r->msaa_color_image = NULL; }
+    if (r->msaa_depth_view)  { qs_gpu_destroy_image_view(gpu, r->msaa_depth_view);  r->msaa_depth_view  = NULL; }
+    if (r->msaa_depth_image) { qs_gpu_destroy_image(gpu, r->msaa_depth_image);      r->msaa_depth_image = NULL; }
+    r->current_msaa_samples = want;
+
+    if (want > 1) {
+        r->msaa_color_image = qs_gpu_create_image(gpu, &(Qs_GpuImageDesc){
+            .width = w, .height = h, .mip_levels = 1,
+            .format = QS_GPU_FORMAT_RGBA16_SFLOAT,
+            .usage  = QS_GPU_IMAGE_COLOR_ATTACHMENT,
+            .sample_count = want,
+        });
+        if (r->msaa_color_image)
+            r->msaa_color_view = qs_gpu_create_image_view_for(
+                gpu, r->msaa_color_image, QS_GPU_IMAGE_ASPECT_COLOR);
+
+        r->msaa_depth_image = qs_gpu_create_image(gpu, &(Qs_GpuImageDesc){
+            .width = w, .height = h, .mip_levels = 1,
+            .format = QS_GPU_FORMAT_DEPTH_AUTO,
+            .usage  = QS_GPU_IMAGE_DEPTH_ATTACHMENT,
+            .sample_count = want,
+        });
+        if (r->msaa_depth_image)
+            r->msaa_depth_view = qs_gpu_create_image_view_for(
+                gpu, r->msaa_depth_image, QS_GPU_IMAGE_ASPECT_DEPTH);
+
+        if (!r->msaa_color_view || !r->msaa_depth_view) {
+            QS_LOG_ERROR("PBR Renderer: MSAA image creation failed at %ux%u with %ux", w, h, want);
+            if (r->msaa_color_view)  { qs_gpu_destroy_image_view(gpu, r->msaa_color_view);  r->msaa_color_view  = NULL; }
+            if (r->msaa_color_image) { qs_gpu_destroy_image(gpu, r->msaa_color_image);      r->msaa_color_image = NULL; }
+            if (r->msaa_depth_view)  { qs_gpu_destroy_image_view(gpu, r->msaa_depth_view);  r->msaa_depth_view  = NULL; }
+            if (r->msaa_depth_image) { qs_gpu_destroy_image(gpu, r->msaa_depth_image);      r->msaa_depth_image = NULL; }
+            r->current_msaa_samples = 1;
+        } else {
+            /* RGBA16F color and 32-bit depth per sample; FXAA needs none */
+            QS_LOG_DEBUG("PBR Renderer: %ux MSAA targets at %ux%u, %.1f MiB", want, w, h,
+                         (double)w * h * want * (8 + 4) / (1024.0 * 1024.0));
         }
-        qs_cmd_end_rendering(ctx->cmd);
+    }
+}
 
-        qs_cmd_image_barrier(ctx->cmd, &(Qs_GpuImageBarrier){
-            .image=img,.old_layout=QS_GPU_IMAGE_LAYOUT_DEPTH_ATTACHMENT,
-            .new_layout=QS_GPU_IMAGE_LAYOUT_SHADER_READ,
-            .aspect=QS_GPU_IMAGE_ASPECT_DEPTH,.base_mip=0,.mip_count=1});
+/* (Re)creates the Hi-Z pyramid for a w x h depth buffer.  Destroying the
+   old buffer idles the device; the sets reading the pyramid are written
+   by occlusion_cull each frame. */
+static bool hiz_buffer_create(PbrRenderer *r, PbrPassResources *ps, uint32_t w, uint32_t h)
+{
+    qs_gpu_destroy_buffer(r->gpu, r->hiz_buffer);
+    r->hiz_buffer = NULL;
+    pbr_hiz_layout(&r->hiz_layout, w, h);
+    if (!ps->occlusion_pipeline || w == 0 || h == 0) return true;
+    r->hiz_buffer = qs_gpu_create_buffer(r->gpu, &(Qs_GpuBufferDesc){
+        .size=(uint64_t)r->hiz_layout.texel_count*sizeof(float),
+        .usage=QS_GPU_BUFFER_STORAGE,.memory=QS_GPU_MEMORY_DEVICE_LOCAL});
+    return r->hiz_buffer != NULL;
+}
+
+/* Between the two forward phases: reduces the depth of the early draws
+   into the Hi-Z pyramid, level by level, then runs the late cull over
+   the occlusion-tested items.  depth arrives in DEPTH_ATTACHMENT, the
+   layout the engine depth buffer rests in from creation and the MSAA
+   depth is moved to every frame, and is returned there. */
+static void occlusion_cull(const Qs_RenderContext *ctx, PbrRenderer *r, PbrPassResources *ps,
+                           Qs_GpuImage *depth, Qs_GpuImageView *depth_view, bool msaa)
+{
+    Qs_GpuCmd           *cmd      = ctx->cmd;
+    Qs_GpuDescriptorSet *hiz_set  = r->hiz_desc_sets[ctx->frame_slot];
+    Qs_GpuDescriptorSet *late_set = r->late_cull_desc_sets[ctx->frame_slot];
+    const PbrHiZLayout  *l        = &r->hiz_layout;
+    const PbrDrawQueue  *fq       = &r->forward_queue;
+    qs_gpu_write_image_descriptor(r->gpu, hiz_set, 0, ps->point_sampler, depth_view);
+    qs_gpu_write_buffer_descriptor(r->gpu, hiz_set, 1, QS_GPU_DESCRIPTOR_STORAGE_BUFFER,
+                                   r->hiz_buffer, 0, 0);
+    qs_gpu_write_buffer_descriptor(r->gpu, late_set, 4, QS_GPU_DESCRIPTOR_STORAGE_BUFFER,
+                                   r->hiz_buffer, 0, 0);
+
+    qs_cmd_image_barrier(cmd, &(Qs_GpuImageBarrier){
+        .image=depth,.old_layout=QS_GPU_IMAGE_LAYOUT_DEPTH_ATTACHMENT,
+        .new_layout=QS_GPU_IMAGE_LAYOUT_SHADER_READ,
+        .aspect=QS_GPU_IMAGE_ASPECT_DEPTH,.base_mip=0,.mip_count=1});
+    /* The previous frame's late cull may still be reading the pyramid */
+    qs_cmd_buffer_barrier(cmd, &(Qs_GpuBufferBarrier){
+        .buffer=r->hiz_buffer,.src=QS_GPU_ACCESS_COMPUTE_READ,.dst=QS_GPU_ACCESS_COMPUTE_WRITE});
+
+    HiZPC hpc = { .src = { l->depth_width, l->depth_height },
+                  .samples = r->current_msaa_samples };
+    qs_cmd_bind_pipeline(cmd, msaa ? ps->hiz_seed_ms_pipeline : ps->hiz_seed_pipeline);
+    qs_cmd_bind_descriptor_set(cmd, ps->hiz_layout, 0, hiz_set);
+    for (uint32_t level = 0; level < l->levels; level++) {
+        if (level > 0) {
+            qs_cmd_buffer_barrier(cmd, &(Qs_GpuBufferBarrier){
+                .buffer=r->hiz_buffer,.src=QS_GPU_ACCESS_COMPUTE_WRITE,
+                .dst=QS_GPU_ACCESS_COMPUTE_READ});
+            if (level == 1) qs_cmd_bind_pipeline(cmd, ps->hiz_reduce_pipeline);
+            hpc.src[0]     = l->width[level - 1];
+            hpc.src[1]     = l->height[level - 1];
+            hpc.src_offset = l->offset[level - 1];
+        }
+        hpc.dst[0]     = l->width[level];
+        hpc.dst[1]     = l->height[level];
+        hpc.dst_offset = l->offset[level];
+        qs_cmd_push_constants(cmd, ps->hiz_layout, QS_GPU_SHADER_COMPUTE,
+                              0, sizeof(HiZPC), &hpc);
+        qs_cmd_dispatch(cmd, (hpc.dst[0] + PBR_HIZ_GROUP_SIZE - 1) / PBR_HIZ_GROUP_SIZE,
+                             (hpc.dst[1] + PBR_HIZ_GROUP_SIZE - 1) / PBR_HIZ_GROUP_SIZE, 1);
     }
+    qs_cmd_buffer_barrier(cmd, &(Qs_GpuBufferBarrier){
+        .buffer=r->hiz_buffer,.src=QS_GPU_ACCESS_COMPUTE_WRITE,.dst=QS_GPU_ACCESS_COMPUTE_READ});
+    qs_cmd_image_barrier(cmd, &(Qs_GpuImageBarrier){
+        .image=depth,.old_layout=QS_GPU_IMAGE_LAYOUT_SHADER_READ,
+        .new_layout=QS_GPU_IMAGE_LAYOUT_DEPTH_ATTACHMENT,
+        .aspect=QS_GPU_IMAGE_ASPECT_DEPTH,.base_mip=0,.mip_count=1});
+    /* The early cull read the flags the late cull rewrites */
+    qs_cmd_buffer_barrier(cmd, &(Qs_GpuBufferBarrier){
+        .buffer=r->object_buffer,.src=QS_GPU_ACCESS_COMPUTE_READ,
+        .dst=QS_GPU_ACCESS_COMPUTE_WRITE});
+
+    /* Items of the occlusion-tested batches lead the forward items */
+    const PbrDrawBatch *last = &fq->batches[r->occlusion_batches - 1];
+    OcclusionPC opc = {
+        .item_count    = last->first + last->count,
+        .first_item    = fq->first_instance,
+        .first_command = fq->first_command,
+        .late_shift    = r->late_shift,
+        .depth_size    = { l->depth_width, l->depth_height },
+        .levels        = l->levels };
+    qs_m4_mul(ctx->proj, ctx->view, opc.view_proj);
+    qs_cmd_bind_pipeline(cmd, ps->occlusion_pipeline);
+    qs_cmd_bind_descriptor_set(cmd, ps->occlusion_layout, 0, late_set);
+    qs_cmd_push_constants(cmd, ps->occlusion_layout, QS_GPU_SHADER_COMPUTE,
+                          0, sizeof(OcclusionPC), &opc);
+    qs_cmd_dispatch(cmd, (opc.item_count + PBR_CULL_GROUP_SIZE - 1) / PBR_CULL_GROUP_SIZE, 1, 1);
+    qs_cmd_buffer_barrier(cmd, &(Qs_GpuBufferBarrier){
+        .buffer=r->late_commands.buffer,.src=QS_GPU_ACCESS_COMPUTE_WRITE,
+        .dst=QS_GPU_ACCESS_INDIRECT_READ|QS_GPU_ACCESS_VERTEX_READ});
+    /* Next frame's early cull and scene upload follow the new flags */
+    qs_cmd_buffer_barrier(cmd, &(Qs_GpuBufferBarrier){
+        .buffer=r->object_buffer,.src=QS_GPU_ACCESS_COMPUTE_WRITE,
+        .dst=QS_GPU_ACCESS_COMPUTE_READ|QS_GPU_ACCESS_VERTEX_READ|QS_GPU_ACCESS_TRANSFER_WRITE});
 }
 
 /* Pass 1: Forward lit (HDR target).  When MSAA is active the scene is rendered
    into a transient MSAA color + depth target and automatically resolved into the
    single-sample hdr_att at vkCmdEndRendering.  Bloom and composite then read
-   the resolved hdr_att as usual; no changes are needed in those passes. */
+   the resolved hdr_att as usual; no changes are needed in those passes.
+   With occlusion culling the pass runs in two phases around
+   occlusion_cull: the early draws of the non-blended batches, unresolved,
+   then the late draws of those batches and the blended draws over the
+   loaded targets. */
 static void forward_pass_execute(const Qs_RenderContext *ctx, void *user_data)
 {
     PbrRenderer      *r  = user_data;
     PbrPassResources *ps = pbr_renderer_pass_resources();
     if (!ps || !ps->ok || !r->ok) return;
 
-    /* Lazy MSAA rebuild when the user changes the sample-count setting */
-    {
-        uint32_t want = effective_sample_count(
-            g_pp_settings.msaa_sample_count, ps->dev_max_samples);
-        if (want != r->current_msaa_samples && r->last_w > 0)
-            pbr_forward_on_resize(r, r->last_w, r->last_h);
-    }
+    /* Lazy MSAA rebuild when the user changes the sample count or AA mode */
+    if (wanted_sample_count(ps) != r->current_msaa_samples && r->last_w > 0)
+        msaa_targets_rebuild(r, ps, r->last_w, r->last_h);
 
     Qs_GpuImageView *hdr_view = qs_attachment_view(r->hdr_att);
-    Qs_GpuImage     *hdr_img  = qs_attachment_image(r->hdr_att);
-    if (!hdr_view || !hdr_img) return;
+    if (!hdr_view) return;
 
     const float *cc = qs_renderer_clear_color(ctx->renderer);
     float clear[4] = { cc ? cc[0]:0.0f, cc ? cc[1]:0.0f,
                         cc ? cc[2]:0.0f, cc ? cc[3]:1.0f };
 
-    /* Transition HDR image to COLOR_ATTACHMENT — acts as render or resolve target */
-    qs_cmd_image_barrier(ctx->cmd, &(Qs_GpuImageBarrier){
-        .image=hdr_img,.old_layout=QS_GPU_IMAGE_LAYOUT_SHADER_READ,
-        .new_layout=QS_GPU_IMAGE_LAYOUT_COLOR_ATTACHMENT,
-        .aspect=QS_GPU_IMAGE_ASPECT_COLOR,.base_mip=0,.mip_count=1});
-
     bool use_msaa = (r->current_msaa_samples > 1)
                  && r->msaa_color_image && r->msaa_color_view
                  && r->msaa_depth_image && r->msaa_depth_view;
-    int tier_idx = sample_count_to_idx(r->current_msaa_samples);
+    int tier_idx = use_msaa ? sample_count_to_idx(r->current_msaa_samples) : 0;
 
-    Qs_GpuPipeline *fwd_pipeline;
+    PassRecord rec = { .r = r, .ps = ps, .ctx = ctx };
+    Qs_GpuRenderTarget target;
     if (use_msaa) {
         /* Transition transient MSAA images.  Always clear (UNDEFINED old layout
            discards previous content; this is safe since loadOp=CLEAR). */
@@ -734,128 +2181,106 @@ static void forward_pass_execute(const Qs_RenderContext *ctx, void *user_data)
             .old_layout=QS_GPU_IMAGE_LAYOUT_UNDEFINED,
             .new_layout=QS_GPU_IMAGE_LAYOUT_DEPTH_ATTACHMENT,
             .aspect=QS_GPU_IMAGE_ASPECT_DEPTH,.base_mip=0,.mip_count=1});
-        qs_cmd_begin_rendering(ctx->cmd, &(Qs_GpuRenderTarget){
+        target = (Qs_GpuRenderTarget){
             .color          = r->msaa_color_view,
             .depth          = r->msaa_depth_view,
             .resolve_target = hdr_view,
             .clear_color    = {clear[0],clear[1],clear[2],clear[3]},
             .clear_depth    = 1.0f,
             .width          = ctx->width,
-            .height         = ctx->height});
-        fwd_pipeline = qs_renderer_wireframe(ctx->renderer)
-            ? ps->forward_wireframe_pipelines[tier_idx]
-            : ps->forward_pipelines[tier_idx];
+            .height         = ctx->height};
     } else {
         /* Non-MSAA fallback — render directly to the single-sample HDR attachment */
-        qs_cmd_begin_rendering(ctx->cmd, &(Qs_GpuRenderTarget){
+        target = (Qs_GpuRenderTarget){
             .color      = hdr_view,
             .depth      = qs_renderer_depth_view(ctx->renderer),
             .clear_color = {clear[0],clear[1],clear[2],clear[3]},
             .clear_depth = 1.0f,
             .width       = ctx->width,
-            .height      = ctx->height});
-        fwd_pipeline = qs_renderer_wireframe(ctx->renderer)
-            ? ps->forward_wireframe_pipelines[0]
-            : ps->forward_pipelines[0];
+            .height      = ctx->height};
     }
-    qs_cmd_set_viewport(ctx->cmd, ctx->width, ctx->height);
-    qs_cmd_bind_pipeline(ctx->cmd, fwd_pipeline);
-    qs_cmd_bind_descriptor_set(ctx->cmd, ps->forward_layout, 0, r->frame_desc_set);
 
-    for (uint32_t ri=0; ri<ctx->renderable_count; ri++) {
-        const Qs_Renderable *ren = &ctx->renderables[ri];
-        if (!ren->material_set || !ren->vertex_buffer) continue;
-        qs_cmd_push_constants(ctx->cmd, ps->forward_layout,
-                              QS_GPU_SHADER_VERTEX, 0, 64, ren->transform);
-        {
-            FwdMatPC mpc;
-            const Qs_PBRParams *p = &ren->material_params;
-            memcpy(mpc.base_color_factor, p->base_color_factor, sizeof(mpc.base_color_factor));
-            mpc.metallic_factor    = p->metallic_factor;
-            mpc.roughness_factor   = p->roughness_factor;
-            mpc.normal_scale       = p->normal_scale;
-            mpc.occlusion_strength = p->occlusion_strength;
-            memcpy(mpc.emissive_factor, p->emissive_factor, sizeof(mpc.emissive_factor));
-            mpc.alpha_cutoff       = p->alpha_cutoff;
-            qs_cmd_push_constants(ctx->cmd, ps->forward_layout,
-                                  QS_GPU_SHADER_FRAGMENT, 64, sizeof(FwdMatPC), &mpc);
-        }
-        qs_cmd_bind_descriptor_set(ctx->cmd, ps->forward_layout, 1, ren->material_set);
-        qs_cmd_bind_vertex_buffer(ctx->cmd, 0, ren->vertex_buffer, 0);
-        if (ren->index_buffer)
-            qs_cmd_bind_index_buffer(ctx->cmd, ren->index_buffer, ren->index_16bit);
-        if (ren->index_count > 0)
-            qs_cmd_draw_indexed(ctx->cmd, ren->index_count, 0, 0);
-        else
-            qs_cmd_draw(ctx->cmd, ren->vertex_count, 0);
+    /* Depth pre-pass: opaque depth first, then the lit pass shades those
+       draws once each under an EQUAL test on the loaded depth */
+    if (r->prepass_list.count > 0 && target.depth) {
+        rec.pipeline = ps->depth_pipelines[tier_idx];
+        rec.ranges   = qs_renderer_record_draws(ctx, &(Qs_GpuRenderTarget){
+            .color=NULL,.depth=target.depth,.clear_depth=1.0f,
+            .width=ctx->width,.height=ctx->height},
+            r->prepass_list.count, prepass_record_range, &rec);
+        pass_record_flush(&rec);
+        qs_cmd_image_barrier(ctx->cmd, &(Qs_GpuImageBarrier){
+            .image=use_msaa ? r->msaa_depth_image : qs_renderer_depth_image(ctx->renderer),
+            .old_layout=QS_GPU_IMAGE_LAYOUT_DEPTH_ATTACHMENT,
+            .new_layout=QS_GPU_IMAGE_LAYOUT_DEPTH_ATTACHMENT,
+            .aspect=QS_GPU_IMAGE_ASPECT_DEPTH,.base_mip=0,.mip_count=1});
+        target.load_depth  = true;
+        rec.equal_batches  = r->prepass_list.count;
     }
-    qs_cmd_end_rendering(ctx->cmd);
-
-    qs_cmd_image_barrier(ctx->cmd, &(Qs_GpuImageBarrier){
-        .image=hdr_img,.old_layout=QS_GPU_IMAGE_LAYOUT_COLOR_ATTACHMENT,
-        .new_layout=QS_GPU_IMAGE_LAYOUT_SHADER_READ,
-        .aspect=QS_GPU_IMAGE_ASPECT_COLOR,.base_mip=0,.mip_count=1});
+    rec.pass = ctx->wireframe ? PBR_FORWARD_WIREFRAME : PBR_FORWARD_LIT;
+    rec.tier = (uint32_t)tier_idx;
+    forward_variants_prepare(r->gpu, ps, &rec);
+    uint32_t late = r->occlusion_batches;
+    if (late > 0) {
+        Qs_GpuRenderTarget early = target;
+        early.resolve_target = NULL;
+        rec.ranges = qs_renderer_record_draws(ctx, &early, late, forward_record_range, &rec);
+        pass_record_flush(&rec);
+        occlusion_cull(ctx, r, ps,
+                       use_msaa ? r->msaa_depth_image : qs_renderer_depth_image(ctx->renderer),
+                       target.depth, use_msaa);
+        target.load_color = target.load_depth = true;
+        rec.equal_batches = 0;
+        rec.late_batches  = late;
+    }
+    rec.ranges = qs_renderer_record_draws(ctx, &target, r->forward_queue.batch_count,
+                                          forward_record_range, &rec);
+    pass_record_flush(&rec);
 }
 
-/* Pass 2: Bloom */
-static void bloom_pass_execute(const Qs_RenderContext *ctx, void *user_data)
-{
-    PbrRenderer      *r  = user_data;
-    PbrPassResources *ps = pbr_renderer_pass_resources();
-    if (!ps || !ps->ok || !r->ok) return;
+typedef struct { float inv_w, inv_h, _p[2]; } BloomPC;
 
+/* Draws one half-resolution bloom step into dst, sampling through set.
+   inv_src_size maps destination pixel position to source UV: 1/bw, 1/bh
+   so gl_FragCoord.xy * inv_src_size covers [0,1] of the source. */
+static void bloom_step(const Qs_RenderContext *ctx, PbrPassResources *ps,
+                       Qs_GpuPipeline *pipeline, Qs_GpuDescriptorSet *set,
+                       Qs_RenderAttachment *dst)
+{
+    Qs_GpuImageView *view = qs_attachment_view(dst);
+    if (!view) return;
     uint32_t bw = (ctx->width+1)/2, bh = (ctx->height+1)/2;
-    typedef struct { float inv_w, inv_h, _p[2]; } BloomPC;
-
-    Qs_GpuImage *bimg0 = qs_attachment_image(r->bloom_att[0]);
-    Qs_GpuImage *bimg1 = qs_attachment_image(r->bloom_att[1]);
-    if (!bimg0 || !bimg1) return;
-
-    /* Downsample: HDR -> bloom[0] */
-    qs_cmd_image_barrier(ctx->cmd, &(Qs_GpuImageBarrier){
-        .image=bimg0,.old_layout=QS_GPU_IMAGE_LAYOUT_SHADER_READ,
-        .new_layout=QS_GPU_IMAGE_LAYOUT_COLOR_ATTACHMENT,
-        .aspect=QS_GPU_IMAGE_ASPECT_COLOR,.base_mip=0,.mip_count=1});
     qs_cmd_begin_rendering(ctx->cmd, &(Qs_GpuRenderTarget){
-        .color=qs_attachment_view(r->bloom_att[0]),.depth=NULL,
+        .color=view,.depth=NULL,
         .clear_color={0,0,0,0},.width=bw,.height=bh});
     qs_cmd_set_viewport(ctx->cmd,bw,bh);
-    qs_cmd_bind_pipeline(ctx->cmd,ps->bloom_down_pipeline);
-    qs_cmd_bind_descriptor_set(ctx->cmd,ps->bloom_layout,0,r->bloom_desc_sets[0]);
-    /* inv_src_size maps destination pixel position to source UV:
-       use 1/bw, 1/bh so gl_FragCoord.xy * inv_src_size covers [0,1]
-       across the full-res HDR source. */
+    qs_cmd_bind_pipeline(ctx->cmd,pipeline);
+    qs_cmd_bind_descriptor_set(ctx->cmd,ps->bloom_layout,0,set);
     BloomPC bpc={1.0f/(float)bw,1.0f/(float)bh,{0,0}};
     qs_cmd_push_constants(ctx->cmd,ps->bloom_layout,QS_GPU_SHADER_FRAGMENT,0,16,&bpc);
     qs_cmd_draw(ctx->cmd,3,0);
     qs_cmd_end_rendering(ctx->cmd);
-    qs_cmd_image_barrier(ctx->cmd, &(Qs_GpuImageBarrier){
-        .image=bimg0,.old_layout=QS_GPU_IMAGE_LAYOUT_COLOR_ATTACHMENT,
-        .new_layout=QS_GPU_IMAGE_LAYOUT_SHADER_READ,
-        .aspect=QS_GPU_IMAGE_ASPECT_COLOR,.base_mip=0,.mip_count=1});
+}
 
-    /* Upsample: bloom[0] -> bloom[1] */
-    qs_cmd_image_barrier(ctx->cmd, &(Qs_GpuImageBarrier){
-        .image=bimg1,.old_layout=QS_GPU_IMAGE_LAYOUT_SHADER_READ,
-        .new_layout=QS_GPU_IMAGE_LAYOUT_COLOR_ATTACHMENT,
-        .aspect=QS_GPU_IMAGE_ASPECT_COLOR,.base_mip=0,.mip_count=1});
-    qs_cmd_begin_rendering(ctx->cmd, &(Qs_GpuRenderTarget){
-        .color=qs_attachment_view(r->bloom_att[1]),.depth=NULL,
-        .clear_color={0,0,0,0},.width=bw,.height=bh});
-    qs_cmd_set_viewport(ctx->cmd,bw,bh);
-    qs_cmd_bind_pipeline(ctx->cmd,ps->bloom_up_pipeline);
-    qs_cmd_bind_descriptor_set(ctx->cmd,ps->bloom_layout,0,r->bloom_desc_sets[1]);
-    BloomPC upc={1.0f/(float)bw,1.0f/(float)bh,{0,0}};
-    qs_cmd_push_constants(ctx->cmd,ps->bloom_layout,QS_GPU_SHADER_FRAGMENT,0,16,&upc);
-    qs_cmd_draw(ctx->cmd,3,0);
-    qs_cmd_end_rendering(ctx->cmd);
-    qs_cmd_image_barrier(ctx->cmd, &(Qs_GpuImageBarrier){
-        .image=bimg1,.old_layout=QS_GPU_IMAGE_LAYOUT_COLOR_ATTACHMENT,
-        .new_layout=QS_GPU_IMAGE_LAYOUT_SHADER_READ,
-        .aspect=QS_GPU_IMAGE_ASPECT_COLOR,.base_mip=0,.mip_count=1});
+/* Pass 2a: Bloom downsample (HDR -> bloom[0]) */
+static void bloom_down_pass_execute(const Qs_RenderContext *ctx, void *user_data)
+{
+    PbrRenderer      *r  = user_data;
+    PbrPassResources *ps = pbr_renderer_pass_resources();
+    if (!ps || !ps->ok || !r->ok) return;
+    bloom_step(ctx, ps, ps->bloom_down_pipeline, r->bloom_desc_sets[0], r->bloom_att[0]);
 }
 
-/* Pass 3: Composite (ACES tonemap + vignette -> swapchain) */
+/* Pass 2b: Bloom upsample (bloom[0] -> bloom[1]) */
+static void bloom_up_pass_execute(const Qs_RenderContext *ctx, void *user_data)
+{
+    PbrRenderer      *r  = user_data;
+    PbrPassResources *ps = pbr_renderer_pass_resources();
+    if (!ps || !ps->ok || !r->ok) return;
+    bloom_step(ctx, ps, ps->bloom_up_pipeline, r->bloom_desc_sets[1], r->bloom_att[1]);
+}
+
+/* Pass 3: Composite (optional FXAA, ACES tonemap + vignette -> swapchain) */
 static void composite_pass_execute(const Qs_RenderContext *ctx, void *user_data)
 {
     PbrRenderer      *r  = user_data;
@@ -868,7 +2293,8 @@ static void composite_pass_execute(const Qs_RenderContext *ctx, void *user_data)
         .clear_color={0,0,0,0},
         .width=ctx->swapchain_width,.height=ctx->swapchain_height});
     qs_cmd_set_viewport(ctx->cmd, ctx->swapchain_width, ctx->swapchain_height);
-    qs_cmd_bind_pipeline(ctx->cmd, ps->composite_pipeline);
+    qs_cmd_bind_pipeline(ctx->cmd, fxaa_active(ps) ? ps->composite_fxaa_pipeline
+                                                   : ps->composite_pipeline);
     qs_cmd_bind_descriptor_set(ctx->cmd, ps->composite_layout, 0, r->composite_desc_set);
     typedef struct { float inv_w, inv_h, bloom_str, vignette_str; } CompositePC;
     CompositePC cpc={1.0f/(float)ctx->swapchain_width,1.0f/(float)ctx->swapchain_height,
@@ -900,36 +2326,21 @@ void pbr_forward_attach(Qs_Engine *engine, PbrRenderer *r, Qs_Renderer *handle)
 
     r->hdr_att = qs_renderer_add_attachment(handle, &(Qs_RenderAttachmentDesc){
         .name="hdr",.format=QS_GPU_FORMAT_RGBA16_SFLOAT,.usage=QS_ATTACHMENT_COLOR,
-        .width_scale=1.0f,.height_scale=1.0f});
+        .width_scale=1.0f,.height_scale=1.0f,.transient=true});
 
     char sname[32];
     for (int i=0; i<QS_CSM_CASCADES; i++) {
         snprintf(sname, sizeof(sname), "shadow_%d", i);
         r->shadow_att[i] = qs_renderer_add_attachment(handle, &(Qs_RenderAttachmentDesc){
             .name=sname,.format=QS_GPU_FORMAT_D32_SFLOAT,.usage=QS_ATTACHMENT_DEPTH,
-            .fixed_width=QS_SHADOW_MAP_SIZE,.fixed_height=QS_SHADOW_MAP_SIZE});
+            .fixed_width=QS_SHADOW_MAP_SIZE,.fixed_height=QS_SHADOW_MAP_SIZE,
+            .copy_dst=true});
     }
     for (int i=0; i<2; i++) {
         char bname[32]; snprintf(bname, sizeof(bname), "bloom_%d", i);
         r->bloom_att[i] = qs_renderer_add_attachment(handle, &(Qs_RenderAttachmentDesc){
             .name=bname,.format=QS_GPU_FORMAT_RGBA16_SFLOAT,.usage=QS_ATTACHMENT_COLOR,
-            .width_scale=0.5f,.height_scale=0.5f});
-    }
-
-    /* --- Create shadow sample views (from fixed-size shadow images) --- */
-    for (int i=0; i<QS_CSM_CASCADES; i++) {
-        if (!r->shadow_att[i]) continue;
-        r->shadow_sample_views[i] = qs_gpu_create_image_view_for(
-            gpu, qs_attachment_image(r->shadow_att[i]), QS_GPU_IMAGE_ASPECT_DEPTH);
-    }
-
-    /* --- Plugin-owned shadow UBO --- */
-    r->shadow_ubo = qs_gpu_create_buffer(gpu, &(Qs_GpuBufferDesc){
-        .size=sizeof(ShadowUBO),.usage=QS_GPU_BUFFER_UNIFORM,
-        .memory=QS_GPU_MEMORY_HOST_VISIBLE});
-    if (!r->shadow_ubo) {
-        QS_LOG_ERROR("PBR Renderer: shadow UBO creation failed");
-        pbr_forward_detach(r); return;
+            .width_scale=0.5f,.height_scale=0.5f,.transient=true});
     }
 
     /* --- Allocate descriptor pool and sets --- */
@@ -938,29 +2349,70 @@ void pbr_forward_attach(Qs_Engine *engine, PbrRenderer *r, Qs_Renderer *handle)
         pbr_forward_detach(r); return;
     }
 
-    /* --- Write static descriptors (UBO bindings and shadow map samplers).
-           These never change after creation so we write them once here. --- */
-    Qs_GpuBuffer *frame_ubo  = qs_renderer_get_frame_ubo(handle);
-    Qs_GpuBuffer *lights_ubo = qs_renderer_get_lights_ubo(handle);
-    qs_gpu_write_buffer_descriptor(gpu, r->frame_desc_set, 0, frame_ubo,  0, 0);
-    qs_gpu_write_buffer_descriptor(gpu, r->frame_desc_set, 1, lights_ubo, 0, 0);
-    qs_gpu_write_buffer_descriptor(gpu, r->frame_desc_set, 2, r->shadow_ubo, 0, 0);
+    /* --- Write static descriptors (engine buffer bindings), one frame
+           set per frame slot.  Bindings 2, 7 and 8, the cull buffers and
+           the cluster grid are rewritten each frame by the prepare node. --- */
+    for (uint32_t slot=0; slot<QS_RENDER_FRAMES_IN_FLIGHT; slot++) {
+        Qs_GpuDescriptorSet *set    = r->frame_desc_sets[slot];
+        Qs_GpuBuffer        *lights = qs_renderer_get_lights_buffer(handle, slot);
+        qs_gpu_write_buffer_descriptor(gpu, set, 0, QS_GPU_DESCRIPTOR_UNIFORM_BUFFER,
+                                       qs_renderer_get_frame_ubo(handle, slot), 0, 0);
+        qs_gpu_write_buffer_descriptor(gpu, set, 1, QS_GPU_DESCRIPTOR_STORAGE_BUFFER,
+                                       lights, 0, 0);
+        if (r->cluster_desc_sets[slot])
+            qs_gpu_write_buffer_descriptor(gpu, r->cluster_desc_sets[slot], 0,
+                                           QS_GPU_DESCRIPTOR_STORAGE_BUFFER, lights, 0, 0);
+    }
+    /* shadow map, composite and bloom descriptors are written in
+       pbr_forward_on_resize */
+
+    /* --- Plugin-owned GPU scene (binding 6 and cull binding 0) and draw
+           staging; regrown by the prepare node --- */
+    if (!object_buffer_reserve(r, PBR_OBJECT_INITIAL_CAPACITY) ||
+        !draw_staging_reserve(r, PBR_DRAW_INITIAL_CAPACITY)) {
+        QS_LOG_ERROR("PBR Renderer: GPU scene / draw buffer creation failed");
+        pbr_forward_detach(r); return;
+    }
+
+    /* --- Add render nodes via engine API.  Declared accesses let the
+           render graph order the passes and record every attachment
+           transition; prepare touches buffers only and stays opaque. --- */
+    Qs_RenderAccess shadow_acc[QS_CSM_CASCADES], forward_acc[QS_CSM_CASCADES + 1];
     for (int i=0; i<QS_CSM_CASCADES; i++) {
-        if (r->shadow_sample_views[i])
-            qs_gpu_write_image_descriptor(gpu, r->frame_desc_set, 3+(uint32_t)i,
-                                           ps->shadow_sampler, r->shadow_sample_views[i]);
+        shadow_acc[i]  = (Qs_RenderAccess){ r->shadow_att[i], QS_GPU_IMAGE_LAYOUT_DEPTH_ATTACHMENT };
+        forward_acc[i] = (Qs_RenderAccess){ r->shadow_att[i], QS_GPU_IMAGE_LAYOUT_SHADER_READ };
     }
-    /* composite + bloom descriptors are written in pbr_forward_on_resize */
+    forward_acc[QS_CSM_CASCADES] = (Qs_RenderAccess){ r->hdr_att, QS_GPU_IMAGE_LAYOUT_COLOR_ATTACHMENT };
+    const Qs_RenderAccess bloom_down_acc[] = {
+        { r->hdr_att,      QS_GPU_IMAGE_LAYOUT_SHADER_READ },
+        { r->bloom_att[0], QS_GPU_IMAGE_LAYOUT_COLOR_ATTACHMENT },
+    };
+    const Qs_RenderAccess bloom_up_acc[] = {
+        { r->bloom_att[0], QS_GPU_IMAGE_LAYOUT_SHADER_READ },
+        { r->bloom_att[1], QS_GPU_IMAGE_LAYOUT_COLOR_ATTACHMENT },
+    };
+    const Qs_RenderAccess composite_acc[] = {
+        { r->hdr_att,      QS_GPU_IMAGE_LAYOUT_SHADER_READ },
+        { r->bloom_att[1], QS_GPU_IMAGE_LAYOUT_SHADER_READ },
+    };
 
-    /* --- Add render nodes via engine API --- */
+    r->prepare_node = qs_renderer_add_node(handle, &(Qs_RenderNodeDesc){
+        .name="prepare_pbr",.priority=-100,.execute=prepare_pass_execute,.user_data=r});
     r->shadow_node = qs_renderer_add_node(handle, &(Qs_RenderNodeDesc){
-        .name="shadow_csm",.priority=0,.execute=shadow_pass_execute,.user_data=r});
+        .name="shadow_csm",.priority=0,.execute=shadow_pass_execute,.user_data=r,
+        .accesses=shadow_acc,.access_count=QS_CSM_CASCADES});
     r->forward_node = qs_renderer_add_node(handle, &(Qs_RenderNodeDesc){
-        .name="forward_pbr",.priority=100,.execute=forward_pass_execute,.user_data=r});
-    r->bloom_node = qs_renderer_add_node(handle, &(Qs_RenderNodeDesc){
-        .name="bloom",.priority=200,.execute=bloom_pass_execute,.user_data=r});
+        .name="forward_pbr",.priority=100,.execute=forward_pass_execute,.user_data=r,
+        .accesses=forward_acc,.access_count=QS_CSM_CASCADES + 1});
+    r->bloom_down_node = qs_renderer_add_node(handle, &(Qs_RenderNodeDesc){
+        .name="bloom_down",.priority=200,.execute=bloom_down_pass_execute,.user_data=r,
+        .accesses=bloom_down_acc,.access_count=2});
+    r->bloom_up_node = qs_renderer_add_node(handle, &(Qs_RenderNodeDesc){
+        .name="bloom_up",.priority=250,.execute=bloom_up_pass_execute,.user_data=r,
+        .accesses=bloom_up_acc,.access_count=2});
     r->composite_node = qs_renderer_add_node(handle, &(Qs_RenderNodeDesc){
-        .name="composite",.priority=300,.execute=composite_pass_execute,.user_data=r});
+        .name="composite",.priority=300,.execute=composite_pass_execute,.user_data=r,
+        .accesses=composite_acc,.access_count=2,.side_effects=true});
 
     /* r->ok stays false until pbr_forward_on_resize is called */
     QS_LOG_INFO("PBR Renderer: Forward+ renderer attached to '%s'", r->name);
@@ -974,9 +2426,11 @@ void pbr_forward_detach(PbrRenderer *r)
 
     /* Remove render nodes (engine removes from its sorted list) */
     if (handle) {
+        if (r->prepare_node)   qs_renderer_remove_node(handle, r->prepare_node);
         if (r->shadow_node)    qs_renderer_remove_node(handle, r->shadow_node);
         if (r->forward_node)   qs_renderer_remove_node(handle, r->forward_node);
-        if (r->bloom_node)     qs_renderer_remove_node(handle, r->bloom_node);
+        if (r->bloom_down_node) qs_renderer_remove_node(handle, r->bloom_down_node);
+        if (r->bloom_up_node)   qs_renderer_remove_node(handle, r->bloom_up_node);
         if (r->composite_node) qs_renderer_remove_node(handle, r->composite_node);
     }
 
@@ -986,21 +2440,36 @@ void pbr_forward_detach(PbrRenderer *r)
     if (r->msaa_depth_view)  { qs_gpu_destroy_image_view(gpu, r->msaa_depth_view);  r->msaa_depth_view  = NULL; }
     if (r->msaa_depth_image) { qs_gpu_destroy_image(gpu, r->msaa_depth_image);      r->msaa_depth_image = NULL; }
 
-    /* Destroy plugin-owned shadow sample views */
     for (int i=0; i<QS_CSM_CASCADES; i++) {
-        if (r->shadow_sample_views[i]) {
-            qs_gpu_destroy_image_view(gpu, r->shadow_sample_views[i]);
-            r->shadow_sample_views[i] = NULL;
-        }
+        pbr_draw_queue_free(&r->shadow_queue[i]);
+        pbr_draw_queue_free(&r->static_queue[i]);
+        if (r->shadow_cache_view[i])  { qs_gpu_destroy_image_view(gpu, r->shadow_cache_view[i]); r->shadow_cache_view[i]  = NULL; }
+        if (r->shadow_cache_image[i]) { qs_gpu_destroy_image(gpu, r->shadow_cache_image[i]);     r->shadow_cache_image[i] = NULL; }
     }
-
-    /* Destroy plugin-owned UBO and descriptor pool */
-    if (r->shadow_ubo) { qs_gpu_destroy_buffer(gpu, r->shadow_ubo); r->shadow_ubo = NULL; }
+    pbr_draw_queue_free(&r->forward_queue);
+    qs_draw_list_free(&r->prepass_list);
+    pbr_shadow_state_free(&r->shadow);
+    pbr_light_grid_free(&r->light_grid);
+    free(r->caster_scratch); r->caster_scratch = NULL;
+    if (r->object_buffer)  { qs_gpu_destroy_buffer(gpu, r->object_buffer);  r->object_buffer  = NULL; }
+    if (r->hiz_buffer)     { qs_gpu_destroy_buffer(gpu, r->hiz_buffer);     r->hiz_buffer     = NULL; }
+    free(r->object_copies); r->object_copies = NULL;
+    free(r->draw_commands); r->draw_commands = NULL;
+    free(r->draw_items);    r->draw_items    = NULL;
+    r->object_capacity = r->draw_capacity = r->caster_capacity = 0;
+
+    /* Destroy plugin-owned descriptor pool */
     if (r->desc_pool)  { qs_gpu_destroy_descriptor_pool(gpu, r->desc_pool); r->desc_pool = NULL; }
 
-    r->frame_desc_set = r->composite_desc_set = NULL;
+    memset(r->frame_desc_sets, 0, sizeof(r->frame_desc_sets));
+    memset(r->cull_desc_sets,  0, sizeof(r->cull_desc_sets));
+    memset(r->cluster_desc_sets, 0, sizeof(r->cluster_desc_sets));
+    memset(r->late_cull_desc_sets, 0, sizeof(r->late_cull_desc_sets));
+    memset(r->hiz_desc_sets, 0, sizeof(r->hiz_desc_sets));
+    r->composite_desc_set = NULL;
     r->bloom_desc_sets[0] = r->bloom_desc_sets[1] = NULL;
-    r->shadow_node = r->forward_node = r->bloom_node = r->composite_node = NULL;
+    r->prepare_node = r->shadow_node = r->forward_node = NULL;
+    r->bloom_down_node = r->bloom_up_node = r->composite_node = NULL;
     r->hdr_att = NULL;
     for (int i=0;i<QS_CSM_CASCADES;i++) r->shadow_att[i] = NULL;
     for (int i=0;i<2;i++) r->bloom_att[i] = NULL;
@@ -1020,59 +2489,40 @@ void pbr_forward_on_resize(PbrRenderer *r, uint32_t w, uint32_t h)
     r->last_w = w;
     r->last_h = h;
 
-    /* Compute the effective MSAA sample count from the current setting */
-    uint32_t want = effective_sample_count(
-        g_pp_settings.msaa_sample_count, ps->dev_max_samples);
-
-    /* Destroy old MSAA images whenever dimensions or sample count change */
-    if (r->msaa_color_view)  { qs_gpu_destroy_image_view(gpu, r->msaa_color_view);  r->msaa_color_view  = NULL; }
-    if (r->msaa_color_image) { qs_gpu_destroy_image(gpu, r->msaa_color_image);      r->msaa_color_image = NULL; }
-    if (r->msaa_depth_view)  { qs_gpu_destroy_image_view(gpu, r->msaa_depth_view);  r->msaa_depth_view  = NULL; }
-    if (r->msaa_depth_image) { qs_gpu_destroy_image(gpu, r->msaa_depth_image);      r->msaa_depth_image = NULL; }
-    r->current_msaa_samples = want;
-
-    if (want > 1) {
-        r->msaa_color_image = qs_gpu_create_image(gpu, &(Qs_GpuImageDesc){
-            .width = w, .height = h, .mip_levels = 1,
-            .format = QS_GPU_FORMAT_RGBA16_SFLOAT,
-            .usage  = QS_GPU_IMAGE_COLOR_ATTACHMENT,
-            .sample_count = want,
-        });
-        if (r->msaa_color_image)
-            r->msaa_color_view = qs_gpu_create_image_view_for(
-                gpu, r->msaa_color_image, QS_GPU_IMAGE_ASPECT_COLOR);
-
-        r->msaa_depth_image = qs_gpu_create_image(gpu, &(Qs_GpuImageDesc){
-            .width = w, .height = h, .mip_levels = 1,
-            .format = QS_GPU_FORMAT_DEPTH_AUTO,
-            .usage  = QS_GPU_IMAGE_DEPTH_ATTACHMENT,
-            .sample_count = want,
-        });
-        if (r->msaa_depth_image)
-            r->msaa_depth_view = qs_gpu_create_image_view_for(
-                gpu, r->msaa_depth_image, QS_GPU_IMAGE_ASPECT_DEPTH);
-
-        if (!r->msaa_color_view || !r->msaa_depth_view) {
-            QS_LOG_ERROR("PBR Renderer: MSAA image creation failed at %ux%u with %ux", w, h, want);
-            if (r->msaa_color_view)  { qs_gpu_destroy_image_view(gpu, r->msaa_color_view);  r->msaa_color_view  = NULL; }
-            if (r->msaa_color_image) { qs_gpu_destroy_image(gpu, r->msaa_color_image);      r->msaa_color_image = NULL; }
-            if (r->msaa_depth_view)  { qs_gpu_destroy_image_view(gpu, r->msaa_depth_view);  r->msaa_depth_view  = NULL; }
-            if (r->msaa_depth_image) { qs_gpu_destroy_image(gpu, r->msaa_depth_image);      r->msaa_depth_image = NULL; }
-            r->current_msaa_samples = 1;
-        }
+    msaa_targets_rebuild(r, ps, w, h);
+    if (!hiz_buffer_create(r, ps, w, h))
+        QS_LOG_WARN("PBR Renderer: Hi-Z pyramid creation failed at %ux%u, occlusion culling off", w, h);
+    if (!shadow_caches_create(r)) {
+        QS_LOG_ERROR("PBR Renderer: on_resize — shadow cache creation failed");
+        r->ok = false;
+        return;
     }
+    /* The graph may have been rebuilt around the shadow maps */
+    pbr_shadow_invalidate(&r->shadow);
 
-    /* Get current attachment views (engine just resized them) */
+    /* Get current attachment views (engine just recreated them) */
     Qs_GpuImageView *hdr_view    = qs_attachment_view(r->hdr_att);
     Qs_GpuImageView *bloom0_view = qs_attachment_view(r->bloom_att[0]);
     Qs_GpuImageView *bloom1_view = qs_attachment_view(r->bloom_att[1]);
+    Qs_GpuImageView *shadow_views[QS_CSM_CASCADES];
+    bool             views_ok = hdr_view && bloom0_view && bloom1_view;
+    for (int i=0; i<QS_CSM_CASCADES; i++) {
+        shadow_views[i] = qs_attachment_view(r->shadow_att[i]);
+        views_ok = views_ok && shadow_views[i];
+    }
 
-    if (!hdr_view || !bloom0_view || !bloom1_view) {
+    if (!views_ok) {
         QS_LOG_ERROR("PBR Renderer: on_resize — attachment views unavailable");
         r->ok = false;
         return;
     }
 
+    /* Re-write shadow map samplers in every frame set */
+    for (uint32_t slot=0; slot<QS_RENDER_FRAMES_IN_FLIGHT; slot++)
+        for (int i=0; i<QS_CSM_CASCADES; i++)
+            qs_gpu_write_image_descriptor(gpu, r->frame_desc_sets[slot], 3+(uint32_t)i,
+                                           ps->shadow_sampler, shadow_views[i]);
+
     /* Re-write composite descriptor set */
     qs_gpu_write_image_descriptor(gpu, r->composite_desc_set, 0,
                                    ps->linear_sampler, hdr_view);
@@ -0,0 +1,124 @@
+/*
+ * pbr_fxaa.h — the FXAA edge search of the composite shader, kept in one
+ * place for COMPOSITE_FRAG and the CPU tests.
+ *
+ * PBR_FXAA_CORE holds the source in the subset C and GLSL share.  It is
+ * stringized into the shader (PBR_FXAA_GLSL) and expanded as C code
+ * (PBR_FXAA_C), so the tests run the shader's own edge search.  The
+ * vocabulary it is written in is defined below for C and by #defines in
+ * COMPOSITE_FRAG for GLSL:
+ *
+ *   FXAA_FN                 function qualifier
+ *   FXAA_CONST              qualifier of the global constants
+ *   PbrFxaaOffset           two-float uv offset type
+ *   FXAA_OFFSET(x, y)       constructs a PbrFxaaOffset
+ *   FXAA_ABS/MIN/MAX/SQRT   float math
+ *   FXAA_LUMA(u, v)         fxaa_luma of the HDR image sampled at (u, v)
+ *                           with the composite's linear clamp sampler;
+ *                           left to the includer in C
+ *
+ * fxaa_offset returns where to re-sample the HDR image relative to the
+ * pixel centre (u, v); (0, 0) off edges.  px, py are one texel in uv.
+ */
+
+#ifndef PBR_FXAA_H
+#define PBR_FXAA_H
+
+#include <math.h>
+#include <stdbool.h>
+
+#define PBR_FXAA_CORE(EMIT) EMIT(                                              \
+FXAA_CONST float FXAA_EDGE_MIN = 0.0312f;                                      \
+FXAA_CONST float FXAA_EDGE_REL = 0.125f;                                       \
+FXAA_CONST float FXAA_SUBPIXEL = 0.75f;                                        \
+FXAA_CONST int   FXAA_STEPS    = 10;                                           \
+                                                                               \
+/* Compressed luma: edges in HDR highlights are found like dark ones */        \
+FXAA_FN float fxaa_luma(float r, float g, float b)                             \
+{                                                                              \
+    float l = r * 0.299f + g * 0.587f + b * 0.114f;                           \
+    return FXAA_SQRT(l / (1.0f + l));                                          \
+}                                                                              \
+                                                                               \
+/* Distance of edge-search step i, in texels */                                \
+FXAA_FN float fxaa_step(int i)                                                 \
+{                                                                              \
+    return i < 4 ? 1.0f : i == 4 ? 1.5f : i < 8 ? 2.0f : i == 8 ? 4.0f : 8.0f; \
+}                                                                              \
+                                                                               \
+FXAA_FN PbrFxaaOffset fxaa_offset(float u, float v, float px, float py)        \
+{                                                                              \
+    float m = FXAA_LUMA(u, v);                                                 \
+    float n = FXAA_LUMA(u, v + py), s = FXAA_LUMA(u, v - py);                  \
+    float e = FXAA_LUMA(u + px, v), w = FXAA_LUMA(u - px, v);                  \
+    float lo = FXAA_MIN(m, FXAA_MIN(FXAA_MIN(n, s), FXAA_MIN(e, w)));          \
+    float hi = FXAA_MAX(m, FXAA_MAX(FXAA_MAX(n, s), FXAA_MAX(e, w)));          \
+    float range = hi - lo;                                                     \
+    if (range < FXAA_MAX(FXAA_EDGE_MIN, hi * FXAA_EDGE_REL))                   \
+        return FXAA_OFFSET(0.0f, 0.0f);                                        \
+    float ne = FXAA_LUMA(u + px, v + py), nw = FXAA_LUMA(u - px, v + py);      \
+    float se = FXAA_LUMA(u + px, v - py), sw = FXAA_LUMA(u - px, v - py);      \
+    float ns = n + s, ew = e + w, west = nw + sw, east = ne + se;               \
+                                                                               \
+    /* Edge direction, then the steeper side across it */                      \
+    bool horz = FXAA_ABS(west - 2.0f * w) + 2.0f * FXAA_ABS(ns - 2.0f * m) +   \
+                FXAA_ABS(east - 2.0f * e) >=                                   \
+                FXAA_ABS(nw + ne - 2.0f * n) + 2.0f * FXAA_ABS(ew - 2.0f * m) + \
+                FXAA_ABS(sw + se - 2.0f * s);                                  \
+    float l1 = horz ? s : w, l2 = horz ? n : e;                                \
+    float g1 = l1 - m, g2 = l2 - m;                                            \
+    bool steep1 = FXAA_ABS(g1) >= FXAA_ABS(g2);                                \
+    float grad = 0.25f * FXAA_MAX(FXAA_ABS(g1), FXAA_ABS(g2));                 \
+    float step_len = horz ? py : px;                                           \
+    float avg = 0.5f * ((steep1 ? l1 : l2) + m);                               \
+    if (steep1) step_len = -step_len;                                          \
+                                                                               \
+    /* Walk along the edge, half a texel across it, to both ends */            \
+    float ou = horz ? px : 0.0f, ov = horz ? 0.0f : py;                        \
+    float cu = u + (horz ? 0.0f : 0.5f * step_len);                            \
+    float cv = v + (horz ? 0.5f * step_len : 0.0f);                            \
+    float u1 = cu - ou, v1 = cv - ov, u2 = cu + ou, v2 = cv + ov;              \
+    float end1 = 0.0f, end2 = 0.0f;                                            \
+    bool done1 = false, done2 = false;                                         \
+    for (int i = 0; i < FXAA_STEPS; i++) {                                     \
+        if (!done1) end1 = FXAA_LUMA(u1, v1) - avg;                            \
+        if (!done2) end2 = FXAA_LUMA(u2, v2) - avg;                            \
+        done1 = FXAA_ABS(end1) >= grad;                                        \
+        done2 = FXAA_ABS(end2) >= grad;                                        \
+        if (done1 && done2) break;                                             \
+        if (!done1) { u1 -= ou * fxaa_step(i); v1 -= ov * fxaa_step(i); }      \
+        if (!done2) { u2 += ou * fxaa_step(i); v2 += ov * fxaa_step(i); }      \
+    }                                                                          \
+                                                                               \
+    /* Offset by the position on the edge, or the sub-pixel blend */           \
+    float d1 = horz ? u - u1 : v - v1;                                         \
+    float d2 = horz ? u2 - u : v2 - v;                                         \
+    bool near1 = d1 < d2;                                                      \
+    float edge_ofs = 0.5f - FXAA_MIN(d1, d2) / (d1 + d2);                      \
+    if (((near1 ? end1 : end2) < 0.0f) == (m < avg)) edge_ofs = 0.0f;          \
+    float sub = FXAA_ABS((2.0f * (ns + ew) + west + east) / 12.0f - m) / range; \
+    sub = FXAA_MIN(FXAA_MAX(sub, 0.0f), 1.0f);                                 \
+    sub = (3.0f - 2.0f * sub) * sub * sub;                                     \
+    float ofs = FXAA_MAX(edge_ofs, sub * sub * FXAA_SUBPIXEL) * step_len;      \
+    return horz ? FXAA_OFFSET(0.0f, ofs) : FXAA_OFFSET(ofs, 0.0f);             \
+}                                                                              \
+)
+
+#define PBR_FXAA_STRINGIZE(...) #__VA_ARGS__
+#define PBR_FXAA_EXPAND(...)    __VA_ARGS__
+
+/* Shader text, one line; COMPOSITE_FRAG defines the vocabulary ahead */
+#define PBR_FXAA_GLSL PBR_FXAA_CORE(PBR_FXAA_STRINGIZE)
+
+/* C definitions; the includer defines FXAA_LUMA and expands PBR_FXAA_C */
+typedef struct { float x, y; } PbrFxaaOffset;
+#define FXAA_FN            static inline
+#define FXAA_CONST         static const
+#define FXAA_OFFSET(x, y)  ((PbrFxaaOffset){ (x), (y) })
+#define FXAA_ABS           fabsf
+#define FXAA_MIN           fminf
+#define FXAA_MAX           fmaxf
+#define FXAA_SQRT          sqrtf
+#define PBR_FXAA_C         PBR_FXAA_CORE(PBR_FXAA_EXPAND)
+
+#endif /* PBR_FXAA_H */
@@ -0,0 +1,109 @@
+/*
+ * pbr_hiz.c — Hi-Z pyramid and occlusion test, CPU reference.
+ *
+ * CPU-only mirror of the pyramid build and late cull compute shaders in
+ * pbr_forward.c, for validating them against a read-back depth buffer.
+ * The layout is also what sizes the GPU pyramid buffer.  Every texel
+ * holds the farthest depth of the texels (level 0: pixels) it covers;
+ * a box whose nearest projected depth lies beyond that of every texel
+ * under its screen rectangle is occluded.
+ */
+
+#include "pbr_internal.h"
+
+#include <math.h>
+
+void pbr_hiz_layout(PbrHiZLayout *out, uint32_t depth_width, uint32_t depth_height)
+{
+    out->depth_width  = depth_width;
+    out->depth_height = depth_height;
+    out->levels       = 0;
+    out->texel_count  = 0;
+    uint32_t w = depth_width, h = depth_height;
+    while (out->levels < PBR_HIZ_MAX_LEVELS) {
+        w = (w + 1) / 2;
+        h = (h + 1) / 2;
+        out->width[out->levels]  = w;
+        out->height[out->levels] = h;
+        out->offset[out->levels] = out->texel_count;
+        out->texel_count += w * h;
+        out->levels++;
+        if (w <= 1 && h <= 1) break;
+    }
+}
+
+/* Farthest of the 2x2 source texels under (x, y), the last row and
+   column repeated when the source size is odd. */
+static float reduce_2x2(const float *src, uint32_t src_w, uint32_t src_h,
+                        uint32_t x, uint32_t y)
+{
+    uint32_t x0 = 2 * x, x1 = x0 + 1 < src_w ? x0 + 1 : src_w - 1;
+    uint32_t y0 = 2 * y, y1 = y0 + 1 < src_h ? y0 + 1 : src_h - 1;
+    return fmaxf(fmaxf(src[y0 * src_w + x0], src[y0 * src_w + x1]),
+                 fmaxf(src[y1 * src_w + x0], src[y1 * src_w + x1]));
+}
+
+void pbr_hiz_build(const PbrHiZLayout *l, const float *depth, float *texels)
+{
+    const float *src = depth;
+    uint32_t src_w = l->depth_width, src_h = l->depth_height;
+    for (uint32_t level = 0; level < l->levels; level++) {
+        float *dst = texels + l->offset[level];
+        for (uint32_t y = 0; y < l->height[level]; y++)
+            for (uint32_t x = 0; x < l->width[level]; x++)
+                dst[y * l->width[level] + x] = reduce_2x2(src, src_w, src_h, x, y);
+        src   = dst;
+        src_w = l->width[level];
+        src_h = l->height[level];
+    }
+}
+
+PbrHiZResult pbr_hiz_test(const PbrHiZLayout *l, const float *texels,
+                          const float view_proj[16],
+                          const float center[3], const float extent[3])
+{
+    const float *m = view_proj;
+    float lo[3] = {  INFINITY,  INFINITY, INFINITY };
+    float hi[2] = { -INFINITY, -INFINITY };
+    for (int k = 0; k < 8; k++) {
+        float p[3] = {
+            center[0] + ((k & 1) ? extent[0] : -extent[0]),
+            center[1] + ((k & 2) ? extent[1] : -extent[1]),
+            center[2] + ((k & 4) ? extent[2] : -extent[2]),
+        };
+        float w = m[3]*p[0] + m[7]*p[1] + m[11]*p[2] + m[15];
+        if (w <= 0.0f) return PBR_HIZ_VISIBLE;
+        for (int a = 0; a < 3; a++) {
+            float v = (m[a]*p[0] + m[a + 4]*p[1] + m[a + 8]*p[2] + m[a + 12]) / w;
+            lo[a] = fminf(lo[a], v);
+            if (a < 2) hi[a] = fmaxf(hi[a], v);
+        }
+    }
+    if (hi[0] < -1.0f || lo[0] > 1.0f || hi[1] < -1.0f || lo[1] > 1.0f || lo[2] > 1.0f)
+        return PBR_HIZ_OUTSIDE;
+
+    /* Screen rectangle in pixels; level 0 texels cover 2x2 of them */
+    float x0 = (fmaxf(lo[0], -1.0f) * 0.5f + 0.5f) * (float)l->depth_width;
+    float x1 = (fminf(hi[0],  1.0f) * 0.5f + 0.5f) * (float)l->depth_width;
+    float y0 = (fmaxf(lo[1], -1.0f) * 0.5f + 0.5f) * (float)l->depth_height;
+    float y1 = (fminf(hi[1],  1.0f) * 0.5f + 0.5f) * (float)l->depth_height;
+    float size = fmaxf(x1 - x0, y1 - y0) * 0.5f;
+    uint32_t level = size > 1.0f ? (uint32_t)ceilf(log2f(size)) : 0;
+    if (level >= l->levels) level = l->levels - 1;
+
+    float    scale = 1.0f / (float)(2u << level);
+    uint32_t w = l->width[level], h = l->height[level];
+    uint32_t tx0 = (uint32_t)(x0 * scale), tx1 = (uint32_t)(x1 * scale);
+    uint32_t ty0 = (uint32_t)(y0 * scale), ty1 = (uint32_t)(y1 * scale);
+    if (tx1 >= w) tx1 = w - 1;
+    if (ty1 >= h) ty1 = h - 1;
+    if (tx0 > tx1) tx0 = tx1;
+    if (ty0 > ty1) ty0 = ty1;
+
+    const float *t   = texels + l->offset[level];
+    float        farthest = 0.0f;
+    for (uint32_t y = ty0; y <= ty1; y++)
+        for (uint32_t x = tx0; x <= tx1; x++)
+            farthest = fmaxf(farthest, t[y * w + x]);
+    return lo[2] <= farthest ? PBR_HIZ_VISIBLE : PBR_HIZ_OCCLUDED;
+}
@@ -0,0 +1,219 @@
+/*
+ * pbr_instances.c — Draw batching, GPU scene records and reference culling.
+ *
+ * CPU-only helpers shared by the prepare, shadow and forward passes: a
+ * sorted draw list is split into runs that become one indirect draw
+ * each, renderables and materials are packed into GPU records, and
+ * pbr_cull_reference mirrors the cull compute shader so the passes can
+ * run without it.  pbr_estimate_overdraw feeds the depth pre-pass
+ * decision.
+ */
+
+#include "pbr_internal.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+bool pbr_draw_queue_reserve(PbrDrawQueue *q, uint32_t capacity)
+{
+    if (!qs_draw_list_reserve(&q->list, capacity)) return false;
+    if (capacity <= q->batch_capacity) return true;
+    PbrDrawBatch *b = realloc(q->batches, capacity * sizeof(PbrDrawBatch));
+    if (!b) return false;
+    q->batches        = b;
+    q->batch_capacity = capacity;
+    return true;
+}
+
+void pbr_draw_queue_free(PbrDrawQueue *q)
+{
+    qs_draw_list_free(&q->list);
+    free(q->batches);
+    memset(q, 0, sizeof(*q));
+}
+
+void pbr_draw_queue_batch(PbrDrawQueue *q, const Qs_Renderable *renderables,
+                          PbrBatchBy by)
+{
+    q->batch_count = 0;
+    const Qs_Renderable *prev = NULL;
+    for (uint32_t i = 0; i < q->list.count; i++) {
+        const Qs_Renderable *ren = &renderables[q->list.items[i]];
+        bool same = prev && ren->mesh_id == prev->mesh_id &&
+                    ren->alpha_mode != QS_ALPHA_MODE_BLEND;
+        if (same && by == PBR_BATCH_MATERIAL)
+            same = ren->material_id == prev->material_id;
+        else if (same && by == PBR_BATCH_FEATURES)
+            same = pbr_material_features(&ren->material_params) ==
+                   pbr_material_features(&prev->material_params);
+        if (same) {
+            q->batches[q->batch_count - 1].count++;
+        } else {
+            q->batches[q->batch_count++] = (PbrDrawBatch){ .first = i, .count = 1 };
+            prev = ren;
+        }
+    }
+}
+
+/* The normal matrix is the inverse-transpose of the upper 3x3, which
+   for columns a, b, c is [b×c, c×a, a×b] / det. */
+static void normal_matrix(const float m[16], float out[12])
+{
+    const float *a = m, *b = m + 4, *c = m + 8;
+    float n[3][3] = {
+        { b[1]*c[2] - b[2]*c[1], b[2]*c[0] - b[0]*c[2], b[0]*c[1] - b[1]*c[0] },
+        { c[1]*a[2] - c[2]*a[1], c[2]*a[0] - c[0]*a[2], c[0]*a[1] - c[1]*a[0] },
+        { a[1]*b[2] - a[2]*b[1], a[2]*b[0] - a[0]*b[2], a[0]*b[1] - a[1]*b[0] },
+    };
+    float det = a[0]*n[0][0] + a[1]*n[0][1] + a[2]*n[0][2];
+    float inv = (det != 0.0f) ? 1.0f / det : 1.0f;
+    for (int col = 0; col < 3; col++) {
+        out[col*4 + 0] = n[col][0] * inv;
+        out[col*4 + 1] = n[col][1] * inv;
+        out[col*4 + 2] = n[col][2] * inv;
+        out[col*4 + 3] = 0.0f;
+    }
+}
+
+void pbr_write_object(PbrGpuObject *out, const float model[16], const Qs_Renderable *ren,
+                      const Qs_CullBounds *bounds, uint32_t index)
+{
+    memcpy(out->model, model, sizeof(out->model));
+    normal_matrix(model, out->normal);
+    memcpy(out->tint, ren->tint, sizeof(out->tint));
+    for (int k = 0; k < 3; k++) {
+        out->center[k] = bounds->center[k][index];
+        out->extent[k] = bounds->extent[k][index];
+    }
+    out->center[3] = (float)ren->material_id;
+    out->extent[3] = 0.0f;
+}
+
+void pbr_write_material(PbrGpuMaterial *out, const Qs_PBRParams *params)
+{
+    memcpy(out->base_color_factor, params->base_color_factor, sizeof(out->base_color_factor));
+    out->metallic_factor    = params->metallic_factor;
+    out->roughness_factor   = params->roughness_factor;
+    out->normal_scale       = params->normal_scale;
+    out->occlusion_strength = params->occlusion_strength;
+    memcpy(out->emissive_factor, params->emissive_factor, sizeof(out->emissive_factor));
+    out->alpha_cutoff       = params->alpha_cutoff;
+}
+
+uint32_t pbr_material_features(const Qs_PBRParams *params)
+{
+    uint32_t features = 0;
+    if (params->has_base_color_tex)         features |= PBR_FEATURE_BASE_COLOR_TEX;
+    if (params->has_metallic_roughness_tex) features |= PBR_FEATURE_METALLIC_ROUGHNESS_TEX;
+    if (params->has_normal_tex)             features |= PBR_FEATURE_NORMAL_TEX;
+    if (params->has_occlusion_tex)          features |= PBR_FEATURE_OCCLUSION_TEX;
+    if (params->has_emissive_tex)           features |= PBR_FEATURE_EMISSIVE_TEX;
+    if (params->alpha_mode == QS_ALPHA_MODE_MASK) features |= PBR_FEATURE_ALPHA_TEST;
+    return features;
+}
+
+uint64_t pbr_forward_key(const Qs_Renderable *ren, float depth01, bool bindless)
+{
+    uint32_t material = bindless ? 0 : ren->material_id;
+    uint32_t features = pbr_material_features(&ren->material_params);
+    return ren->alpha_mode == QS_ALPHA_MODE_BLEND
+        ? qs_draw_key_blended(1, features, material, ren->mesh_id, depth01)
+        : qs_draw_key_opaque (0, features, material, ren->mesh_id, depth01);
+}
+
+void pbr_write_draws(const PbrDrawQueue *q, const Qs_Renderable *renderables,
+                     PbrCullMode cull, PbrDrawCommand *commands, PbrCullItem *items)
+{
+    for (uint32_t bi = 0; bi < q->batch_count; bi++) {
+        const PbrDrawBatch  *b   = &q->batches[bi];
+        const Qs_Renderable *ren = &renderables[q->list.items[b->first]];
+        uint32_t command = q->first_command + bi;
+        uint32_t base    = q->first_instance + b->first;
+        uint32_t mode    = (cull == PBR_CULL_OCCLUSION && ren->alpha_mode == QS_ALPHA_MODE_BLEND)
+                         ? PBR_CULL_FRUSTUM : cull;
+
+        if (ren->index_count > 0)
+            commands[command].indexed = (Qs_GpuDrawIndexedIndirect){
+                .index_count = ren->index_count, .first_instance = base };
+        else
+            commands[command].direct = (Qs_GpuDrawIndirect){
+                .vertex_count = ren->vertex_count, .first_instance = base };
+
+        for (uint32_t i = b->first; i < b->first + b->count; i++)
+            items[q->first_instance + i] = (PbrCullItem){
+                .object = q->list.items[i], .command = command,
+                .visible_base = base, .cull = mode };
+    }
+}
+
+void pbr_cull_reference(const Qs_Frustum *frustum, const Qs_CullBounds *bounds,
+                        const PbrCullItem *items, uint32_t item_count,
+                        PbrDrawCommand *commands, uint32_t *visible)
+{
+    for (uint32_t i = 0; i < item_count; i++) {
+        const PbrCullItem *it = &items[i];
+        if (it->cull) {
+            uint32_t o = it->object;
+            float cx = bounds->center[0][o], cy = bounds->center[1][o], cz = bounds->center[2][o];
+            float ex = bounds->extent[0][o], ey = bounds->extent[1][o], ez = bounds->extent[2][o];
+            bool inside = true;
+            for (int p = 0; p < 6 && inside; p++) {
+                const float *pl = frustum->planes[p];
+                inside = pl[0]*cx + pl[1]*cy + pl[2]*cz + pl[3]
+                       + fabsf(pl[0])*ex + fabsf(pl[1])*ey + fabsf(pl[2])*ez >= 0.0f;
+            }
+            if (!inside) continue;
+        }
+        uint32_t slot = commands[it->command].indexed.instance_count++;
+        visible[it->visible_base + slot] = it->object;
+    }
+}
+
+/* Screen fraction covered by the projection of a box; the whole screen
+   when some corner lies behind the eye plane, none when all do. */
+static float box_coverage(const float m[16], const float c[3], const float e[3])
+{
+    float lo[2] = {  1.0f,  1.0f };
+    float hi[2] = { -1.0f, -1.0f };
+    int   behind = 0;
+    for (int k = 0; k < 8; k++) {
+        float p[3] = {
+            c[0] + ((k & 1) ? e[0] : -e[0]),
+            c[1] + ((k & 2) ? e[1] : -e[1]),
+            c[2] + ((k & 4) ? e[2] : -e[2]),
+        };
+        float w = m[3]*p[0] + m[7]*p[1] + m[11]*p[2] + m[15];
+        if (w <= 0.0f) { behind++; continue; }
+        for (int a = 0; a < 2; a++) {
+            float v = (m[a]*p[0] + m[a + 4]*p[1] + m[a + 8]*p[2] + m[a + 12]) / w;
+            lo[a] = fminf(lo[a], v);
+            hi[a] = fmaxf(hi[a], v);
+        }
+    }
+    if (behind == 8) return 0.0f;
+    if (behind > 0)  return 1.0f;
+    float w = fminf(hi[0], 1.0f) - fmaxf(lo[0], -1.0f);
+    float h = fminf(hi[1], 1.0f) - fmaxf(lo[1], -1.0f);
+    return (w > 0.0f && h > 0.0f) ? w * h * 0.25f : 0.0f;
+}
+
+void pbr_estimate_overdraw(const PbrDrawQueue *q, uint32_t batch_count,
+                           const Qs_Renderable *renderables, const Qs_CullBounds *bounds,
+                           const float view_proj[16], PbrOverdrawEstimate *out)
+{
+    out->coverage  = 0.0f;
+    out->triangles = 0;
+    if (batch_count == 0) return;
+    const PbrDrawBatch *last = &q->batches[batch_count - 1];
+    for (uint32_t i = q->batches[0].first; i < last->first + last->count; i++) {
+        uint32_t o = q->list.items[i];
+        float c[3] = { bounds->center[0][o], bounds->center[1][o], bounds->center[2][o] };
+        float e[3] = { bounds->extent[0][o], bounds->extent[1][o], bounds->extent[2][o] };
+        float cover = box_coverage(view_proj, c, e);
+        if (cover <= 0.0f) continue;
+        const Qs_Renderable *ren = &renderables[o];
+        out->coverage  += cover;
+        out->triangles += (ren->index_count > 0 ? ren->index_count : ren->vertex_count) / 3;
+    }
+}
@@ -5,8 +5,10 @@
    Not part of the public engine API. */
 
 #include "qs_renderer.h"
+#include "qs_draw_list.h"
 #include "qs_gpu.h"
 #include "qs_light.h"
+#include "qs_job.h"
 
 /* ----------------------------------------------------------------
    Constants
@@ -14,18 +16,384 @@
 #define QS_CSM_CASCADES    3
 #define QS_SHADOW_MAP_SIZE 2048
 
+/* Fraction of a cascade's half-extent (light-space NDC x / y) past which
+   receivers blend toward the next cascade.  Matches the literal in
+   compute_shadow (FORWARD_FRAG). */
+#define PBR_CSM_BLEND_START 0.9f
+
+/* Cascade centres move in steps of this many shadow texels, so a
+   cascade's matrix — and with it its static cache — stays put while the
+   camera moves within a step. */
+#define PBR_CSM_SNAP_TEXELS 64
+
+/* Cascade c refreshes every 1 << (c * PBR_CSM_REFRESH_SHIFT) frames. */
+#define PBR_CSM_REFRESH_SHIFT 1
+
+/* Frames a caster must stay unchanged before it is cached as static. */
+#define PBR_SHADOW_STATIC_FRAMES 60
+
 /* Desired MSAA sample count for the forward lit pass.  Automatically clamped
    to the device maximum at attach time.  Set to 1 to disable MSAA. */
 #define PBR_MSAA_SAMPLES   4
 
+/* Initial GPU scene and per-frame draw buffer sizes; both grow by doubling. */
+#define PBR_OBJECT_INITIAL_CAPACITY 1024
+#define PBR_DRAW_INITIAL_CAPACITY   1024
+
+/* Invocations per workgroup of the cull compute shader. */
+#define PBR_CULL_GROUP_SIZE 64
+
+/* Invocations per axis of the Hi-Z pyramid build workgroups; matches
+   HIZ_COMP_HEAD. */
+#define PBR_HIZ_GROUP_SIZE 8
+
+/* Hi-Z pyramid levels; level 0 halves the depth buffer, so depth buffers
+   up to 2^PBR_HIZ_MAX_LEVELS pixels across reduce to a single texel. */
+#define PBR_HIZ_MAX_LEVELS 16
+
+/* PBR_DEPTH_PREPASS_AUTO draws the pre-pass when the opaque draws cover
+   the screen at least this many times over on average... */
+#define PBR_PREPASS_MIN_OVERDRAW 1.5f
+/* ...and have at most this many triangles per pixel, past which drawing
+   the geometry twice costs more than the shading it saves. */
+#define PBR_PREPASS_MAX_TRIANGLES_PER_PIXEL 0.5f
+
+/* Light clusters: screen tiles across and down, depth slices.  Match the
+   literals in FORWARD_FRAG and CLUSTER_COMP. */
+#define PBR_CLUSTER_X     16
+#define PBR_CLUSTER_Y     9
+#define PBR_CLUSTER_Z     24
+#define PBR_CLUSTER_COUNT (PBR_CLUSTER_X * PBR_CLUSTER_Y * PBR_CLUSTER_Z)
+
+/* Closest view depth of the first slice boundary, so that slicing stays
+   defined for near planes at or behind the eye (orthographic cameras). */
+#define PBR_CLUSTER_DEPTH_MIN 0.01f
+
+/* Index slots of each cluster when binning on the GPU; lights past them
+   are dropped.  Matches CLUSTER_COMP. */
+#define PBR_CLUSTER_GPU_LIGHTS 128
+
+/* Invocations (clusters) per workgroup of the light binning compute
+   shader; divides PBR_CLUSTER_COUNT. */
+#define PBR_CLUSTER_GROUP_SIZE 64
+
+/* ----------------------------------------------------------------
+   GPU-driven drawing
+   Every renderable owns a PbrGpuObject in a persistent device-local
+   storage buffer (set=0 binding=6), indexed like ctx->renderables and
+   re-uploaded only for ctx->dirty entries.  Each frame the sorted draw
+   lists are split into batches of neighbouring entries sharing a mesh
+   (and, for lit passes on the per-material path, a material); every
+   batch is one indirect command whose instance_count starts at zero.
+   One PbrCullItem per list entry is then tested against the camera
+   frustum — on the GPU by the cull compute shader, or on the CPU by
+   pbr_cull_reference — and each survivor appends its object index to its batch's range of the
+   visible buffer (binding 7) and bumps the command's instance_count.
+   Occlusion-tested items are also skipped while their object is flagged
+   occluded; see the Hi-Z section below.
+   ---------------------------------------------------------------- */
+typedef struct PbrGpuObject {
+    float model[16];
+    float normal[12];   /* inverse-transpose of the upper 3x3, three vec4 columns */
+    float tint[4];
+    float center[4];    /* world AABB center; w = material id */
+    float extent[4];    /* world AABB half-size; w = 1 while occluded (set
+                           by the late cull, cleared by every upload) */
+} PbrGpuObject;
+
+/* Material parameters as the forward shader reads them: the per-draw
+   push constants of the per-material path, or one record per material
+   id in frame binding 9 on the bindless path. */
+typedef struct PbrGpuMaterial {
+    float base_color_factor[4];  /* offset  0, 16 bytes */
+    float metallic_factor;       /* offset 16 */
+    float roughness_factor;      /* offset 20 */
+    float normal_scale;          /* offset 24 */
+    float occlusion_strength;    /* offset 28 */
+    float emissive_factor[3];    /* offset 32, 12 bytes */
+    float alpha_cutoff;          /* offset 44 */
+} PbrGpuMaterial;                /* total: 48 bytes */
+
+typedef enum PbrCullMode {
+    PBR_CULL_NONE,       /* always drawn (shadow casters) */
+    PBR_CULL_FRUSTUM,
+    PBR_CULL_OCCLUSION,  /* frustum, and left to the late cull while occluded */
+} PbrCullMode;
+
+typedef struct PbrCullItem {
+    uint32_t object;        /* renderable index */
+    uint32_t command;       /* indirect command of the item's batch */
+    uint32_t visible_base;  /* the command's first_instance */
+    uint32_t cull;          /* PbrCullMode */
+} PbrCullItem;
+
+/* One indirect command; indexed when the batch mesh has an index buffer.
+   instance_count sits at the same offset in both layouts. */
+typedef union PbrDrawCommand {
+    Qs_GpuDrawIndexedIndirect indexed;
+    Qs_GpuDrawIndirect        direct;
+} PbrDrawCommand;
+
+typedef struct PbrDrawBatch {
+    uint32_t first;     /* first list entry */
+    uint32_t count;     /* list entries = maximum instances */
+} PbrDrawBatch;
+
+typedef struct PbrDrawQueue {
+    Qs_DrawList   list;
+    PbrDrawBatch *batches;
+    uint32_t      batch_count;
+    uint32_t      batch_capacity;
+    uint32_t      first_instance; /* visible / item index of list entry 0 */
+    uint32_t      first_command;  /* command index of batch 0 */
+} PbrDrawQueue;
+
+/* Grows the list and batch arrays to hold capacity draws. */
+bool pbr_draw_queue_reserve(PbrDrawQueue *q, uint32_t capacity);
+void pbr_draw_queue_free(PbrDrawQueue *q);
+
+/* What neighbouring draws must share, besides the mesh, to be merged. */
+typedef enum PbrBatchBy {
+    PBR_BATCH_MESH,      /* shadow and depth-only passes */
+    PBR_BATCH_FEATURES,  /* the same forward pipeline variant (bindless) */
+    PBR_BATCH_MATERIAL,  /* the same material, hence also the same variant */
+} PbrBatchBy;
+
+/* Splits the sorted list into batches of neighbouring draws with the same
+   mesh and whatever else by asks for.  Blended draws are never merged:
+   the order of instances within a batch is not preserved by culling, and
+   blending needs it back-to-front. */
+void pbr_draw_queue_batch(PbrDrawQueue *q, const Qs_Renderable *renderables,
+                          PbrBatchBy by);
+
+/* Packs a model matrix, the tint and material id of ren and box index of
+   bounds into a GPU scene record. */
+void pbr_write_object(PbrGpuObject *out, const float model[16], const Qs_Renderable *ren,
+                      const Qs_CullBounds *bounds, uint32_t index);
+
+void pbr_write_material(PbrGpuMaterial *out, const Qs_PBRParams *params);
+
+/* Material features the forward shader is specialized on (constant_id 0).
+   A missing texture is replaced by its neutral value instead of sampling
+   the fallback texture.  ALPHA_TEST is the highest bit so that masked
+   draws, keyed by their features, sort after all opaque ones. */
+typedef enum PbrMaterialFeature {
+    PBR_FEATURE_BASE_COLOR_TEX         = 0x01,
+    PBR_FEATURE_METALLIC_ROUGHNESS_TEX = 0x02,
+    PBR_FEATURE_NORMAL_TEX             = 0x04,
+    PBR_FEATURE_OCCLUSION_TEX          = 0x08,
+    PBR_FEATURE_EMISSIVE_TEX           = 0x10,
+    PBR_FEATURE_ALPHA_TEST             = 0x20,
+} PbrMaterialFeature;
+
+#define PBR_FEATURE_MASKS 64
+/* Every texture sampled, no alpha test: the shader's default.  It and its
+   alpha-tested twin are created up front and stand in for any variant
+   that fails to build, keyed on that variant's alpha-test bit. */
+#define PBR_FEATURES_DEFAULT 0x1Fu
+
+uint32_t pbr_material_features(const Qs_PBRParams *params);
+
+/* Sort key of a forward draw at view depth depth01.  The bindless path
+   leaves the material out, so draws of one mesh and variant sort
+   together whatever their material and batch by PBR_BATCH_FEATURES; the
+   per-material path keeps it and batches by PBR_BATCH_MATERIAL. */
+uint64_t pbr_forward_key(const Qs_Renderable *ren, float depth01, bool bindless);
+
+/* Writes the queue's commands at commands[q->first_command] (instance
+   counts zeroed) and its items at items[q->first_instance].  Blended
+   items get PBR_CULL_FRUSTUM in place of PBR_CULL_OCCLUSION: they are
+   drawn after the late cull, in their own order. */
+void pbr_write_draws(const PbrDrawQueue *q, const Qs_Renderable *renderables,
+                     PbrCullMode cull, PbrDrawCommand *commands, PbrCullItem *items);
+
+/* CPU reference of the cull compute shader: same test, same outputs, but
+   instances keep list order within each batch.  The occlusion flags live
+   on the GPU only, so occlusion-tested items are frustum-tested. */
+void pbr_cull_reference(const Qs_Frustum *frustum, const Qs_CullBounds *bounds,
+                        const PbrCullItem *items, uint32_t item_count,
+                        PbrDrawCommand *commands, uint32_t *visible);
+
+typedef struct PbrOverdrawEstimate {
+    float    coverage;   /* summed screen fractions of the projected boxes */
+    uint64_t triangles;
+} PbrOverdrawEstimate;
+
+/* Estimates the shading and vertex load of batches [0, batch_count) of
+   a queue: the screen fraction each entry's bounding box projects to
+   through view_proj (the whole screen when it straddles the eye plane),
+   summed, and the triangles of the entries that project on screen. */
+void pbr_estimate_overdraw(const PbrDrawQueue *q, uint32_t batch_count,
+                           const Qs_Renderable *renderables, const Qs_CullBounds *bounds,
+                           const float view_proj[16], PbrOverdrawEstimate *out);
+
+/* ----------------------------------------------------------------
+   Cascaded shadow maps (pbr_shadow.c)
+   ---------------------------------------------------------------- */
+
+/* Light view-projection of every cascade, from the camera and the first
+   directional light (a default sun when there is none). */
+void pbr_csm_compute(const Qs_Camera *cam,
+                     const Qs_LightGPU *lights, uint32_t light_count,
+                     float shadow_matrices[QS_CSM_CASCADES][16]);
+
+/* Writes to out (bounds->count entries) the ascending indices of the
+   shadow casters of one cascade: renderables with cast_shadows and
+   geometry whose box meets the cascade volume extruded toward the light,
+   except those inside the core of a nearer cascade.  Returns the count. */
+uint32_t pbr_csm_select_casters(const float shadow_matrices[QS_CSM_CASCADES][16],
+                                uint32_t cascade, const Qs_CullBounds *bounds,
+                                const Qs_Renderable *renderables, uint32_t *out);
+
+/* ----------------------------------------------------------------
+   Cascade scheduling and static caster caching (pbr_shadow.c)
+   Cascade 0 is rendered every frame and cascade c > 0 every
+   1 << (c * PBR_CSM_REFRESH_SHIFT) frames, staggered so that no two far
+   cascades refresh together.  Between refreshes receivers keep sampling
+   a cascade through the matrix it was rendered with.  A caster left
+   unchanged for PBR_SHADOW_STATIC_FRAMES frames is static: each cascade
+   draws its static casters once into a cached depth image, and every
+   refresh copies that image into the shadow map and draws only the
+   dynamic casters on top.  A cache is rebuilt when the matrix of its
+   cascade or of a nearer one changes (light direction, a snap step, the
+   camera range), or when one of its casters changes or is removed.
+   ---------------------------------------------------------------- */
+typedef enum PbrCasterPass {
+    PBR_CASTER_SKIP,     /* already in the cascade's valid cache */
+    PBR_CASTER_CACHE,    /* drawn into the cache being rebuilt */
+    PBR_CASTER_DYNAMIC,  /* drawn over the cache every refresh */
+} PbrCasterPass;
+
+typedef struct PbrShadowState {
+    float     matrices[QS_CSM_CASCADES][16]; /* as last rendered, per cascade */
+    uint32_t  frame;
+    uint32_t  due;          /* cascades rendered this frame */
+    uint32_t  rebuild;      /* cascades whose cache is redrawn this frame */
+    uint32_t  map_valid;    /* cascades whose shadow map holds a render */
+    uint32_t  cache_valid;  /* cascades whose cache holds all their static casters */
+    uint32_t  cached_count[QS_CSM_CASCADES];
+    uint32_t *changed;      /* per renderable: frame of its last change */
+    uint8_t  *cached;       /* per renderable: bit c = drawn in cascade c's cache */
+    uint32_t  count;        /* renderables tracked */
+    uint32_t  capacity;
+} PbrShadowState;
+
+/* Starts a frame: tracks renderable_count renderables, dirty listing
+   those that changed, and invalidates the caches holding changed or
+   removed casters.  False when the tracking arrays cannot grow. */
+bool pbr_shadow_begin_frame(PbrShadowState *s, const uint32_t *dirty,
+                            uint32_t dirty_count, uint32_t renderable_count);
+
+/* Picks this frame's due cascades and those of them whose cache is
+   rebuilt; due cascades adopt their matrix from fresh.  Returns s->due. */
+uint32_t pbr_shadow_schedule(PbrShadowState *s,
+                             const float fresh[QS_CSM_CASCADES][16]);
+
+/* Routes a caster selected for a due cascade. */
+PbrCasterPass pbr_shadow_classify(PbrShadowState *s, uint32_t cascade,
+                                  uint32_t renderable);
+
+/* Forces every cascade and cache to be redrawn at the next schedule. */
+void pbr_shadow_invalidate(PbrShadowState *s);
+void pbr_shadow_state_free(PbrShadowState *s);
+
+/* ----------------------------------------------------------------
+   Clustered lighting (pbr_cluster.c)
+   The light grid buffer (set=0 binding 8) starts with a
+   PbrLightGridHeader, followed by light indices: the global lights
+   (directional, or without a range), then each cluster's lights.  A
+   fragment shades the global lights and those of the cluster holding
+   its screen tile and view depth.
+   ---------------------------------------------------------------- */
+typedef struct PbrLightGridHeader {
+    float    z_scale;       /* slice = floor(log(view depth) * z_scale + z_bias) */
+    float    z_bias;
+    uint32_t global_count;  /* global lights at the start of the indices */
+    uint32_t _pad;
+    uint32_t clusters[PBR_CLUSTER_COUNT][2]; /* first index, light count */
+} PbrLightGridHeader;
+
+typedef struct PbrLightGrid {
+    PbrLightGridHeader header;
+    uint32_t *indices;       /* the indices following the header */
+    uint32_t  index_count;
+    uint32_t  index_capacity;
+    uint32_t *pairs;         /* binning scratch: cluster << 16 | light */
+    uint32_t  pair_count;
+    uint32_t  pair_capacity;
+
+    /* Projection terms the slicing and boxes were derived from */
+    float     key[5];
+    bool      ready;
+    bool      ortho;
+    float     near_plane;
+    float     z_near, z_far; /* depth range sliced exponentially */
+    /* View-space cluster boxes, structure-of-arrays: centre xyz, half-size xyz */
+    float     box[6][PBR_CLUSTER_COUNT];
+} PbrLightGrid;
+
+/* Derives the depth slicing and the cluster boxes from a projection
+   matrix; does nothing while the projection is unchanged. */
+void pbr_light_grid_setup(PbrLightGrid *g, const float proj[16]);
+
+/* Lists the global lights, then, when clusters is set, bins every other
+   light into the clusters its bounding sphere meets (ascending within a
+   cluster).  Without clusters the cluster ranges are left to the
+   binning compute shader.  False when the index arrays cannot grow. */
+bool pbr_light_grid_build(PbrLightGrid *g, const float view[16],
+                          const Qs_LightGPU *lights, uint32_t light_count,
+                          bool clusters);
+void pbr_light_grid_free(PbrLightGrid *g);
+
+/* ----------------------------------------------------------------
+   Hi-Z occlusion culling (pbr_hiz.c)
+   Opaque and alpha-tested forward draws are culled in two phases.  The
+   early cull draws the objects not flagged occluded in the GPU scene;
+   the depth they lay down is reduced into a pyramid of farthest depths,
+   level 0 at half resolution and each level half the one before, sizes
+   rounded up.  The late cull then tests every such object's screen
+   rectangle against the level where it spans at most 2x2 texels,
+   re-flags it, and draws those found visible that the early cull
+   skipped, so an object coming into view is drawn the frame it appears.
+   These functions are the CPU reference of HIZ_SEED_COMP,
+   HIZ_REDUCE_COMP and OCCLUSION_COMP in pbr_forward.c.
+   ---------------------------------------------------------------- */
+typedef struct PbrHiZLayout {
+    uint32_t depth_width, depth_height;
+    uint32_t levels;
+    uint32_t width[PBR_HIZ_MAX_LEVELS];
+    uint32_t height[PBR_HIZ_MAX_LEVELS];
+    uint32_t offset[PBR_HIZ_MAX_LEVELS];  /* first texel of each level */
+    uint32_t texel_count;                 /* all levels */
+} PbrHiZLayout;
+
+typedef enum PbrHiZResult {
+    PBR_HIZ_OUTSIDE,   /* off screen or past the far plane */
+    PBR_HIZ_OCCLUDED,
+    PBR_HIZ_VISIBLE,
+} PbrHiZResult;
+
+/* Sizes the levels of the pyramid of a depth buffer, down to 1x1. */
+void pbr_hiz_layout(PbrHiZLayout *out, uint32_t depth_width, uint32_t depth_height);
+
+/* Fills texels (l->texel_count) from a row-major depth buffer of
+   l->depth_width x l->depth_height. */
+void pbr_hiz_build(const PbrHiZLayout *l, const float *depth, float *texels);
+
+/* Classifies a world AABB against the pyramid seen through view_proj.
+   Boxes reaching behind the eye plane are visible. */
+PbrHiZResult pbr_hiz_test(const PbrHiZLayout *l, const float *texels,
+                          const float view_proj[16],
+                          const float center[3], const float extent[3]);
+
 /* ----------------------------------------------------------------
    PbrRenderer — plugin-internal per-renderer state.
    The engine now owns: camera, clear_color, name, nodes, renderables,
-   lights, depth buffer, frame UBO, lights UBO, default material, and
+   lights, depth buffer, frame UBO, lights buffer, default material, and
    all viewport attachments declared via qs_renderer_add_attachment.
 
    The plugin owns: pipelines, descriptor sets, shadow UBO (CSM data),
-   CSM matrices, and shadow sample views.
+   CSM matrices, the GPU scene and the draw buffers.
    ---------------------------------------------------------------- */
 struct PbrRenderer {
     char          name[64];
@@ -35,21 +403,37 @@ struct PbrRenderer {
     Qs_GpuContext *gpu;             /* cached pointer from the system context */
 
     /* CSM shadow computation state */
-    float         shadow_matrices[QS_CSM_CASCADES][16];
-    float         shadow_splits[QS_CSM_CASCADES + 1];
-
-    /* Plugin-owned UBO — shadow/CSM data (not written by the engine) */
-    Qs_GpuBuffer *shadow_ubo;
-
-    /* Descriptor pool + per-renderer descriptor sets */
+    PbrShadowState shadow;
+    uint32_t      shadow_casters[QS_CSM_CASCADES]; /* casters drawn per cascade last frame */
+
+    /* Per-cascade depth images holding the static casters (see
+       PbrShadowState); plugin-owned, resting in TRANSFER_SRC */
+    Qs_GpuImage     *shadow_cache_image[QS_CSM_CASCADES];
+    Qs_GpuImageView *shadow_cache_view[QS_CSM_CASCADES];
+
+    /* Light clusters, rebuilt by the prepare node */
+    PbrLightGrid  light_grid;
+
+    /* Descriptor pool + per-renderer descriptor sets.  Frame, cull,
+       cluster and Hi-Z sets are ringed by frame slot: their per-frame
+       bindings (shadow UBO, light grid, visible indices, cull buffers)
+       point into the engine frame arena, and the Hi-Z sets take the
+       depth target of the frame's MSAA setting. */
     Qs_GpuDescriptorPool *desc_pool;
-    Qs_GpuDescriptorSet  *frame_desc_set;      /* set=0: UBOs + shadow samplers */
+    Qs_GpuDescriptorSet  *frame_desc_sets[QS_RENDER_FRAMES_IN_FLIGHT]; /* set=0 */
     Qs_GpuDescriptorSet  *composite_desc_set;  /* tonemap pass                  */
     Qs_GpuDescriptorSet  *bloom_desc_sets[2];  /* bloom ping-pong               */
-
-    /* Engine attachment handles declared at renderer_create time */
+    Qs_GpuDescriptorSet  *cull_desc_sets[QS_RENDER_FRAMES_IN_FLIGHT];  /* cull compute */
+    Qs_GpuDescriptorSet  *cluster_desc_sets[QS_RENDER_FRAMES_IN_FLIGHT]; /* light binning */
+    Qs_GpuDescriptorSet  *late_cull_desc_sets[QS_RENDER_FRAMES_IN_FLIGHT]; /* occlusion cull */
+    Qs_GpuDescriptorSet  *hiz_desc_sets[QS_RENDER_FRAMES_IN_FLIGHT];  /* pyramid build */
+
+    /* Engine attachment handles declared at renderer_create time.  All but
+       the shadow maps, which persist across frames, are render-graph
+       transients, recreated (and possibly aliased) on every graph rebuild,
+       so their views are re-bound in pbr_forward_on_resize. */
     Qs_RenderAttachment *hdr_att;             /* full-res RGBA16F color target */
-    Qs_RenderAttachment *shadow_att[QS_CSM_CASCADES]; /* 1024x1024 depth maps  */
+    Qs_RenderAttachment *shadow_att[QS_CSM_CASCADES]; /* QS_SHADOW_MAP_SIZE depth maps */
     Qs_RenderAttachment *bloom_att[2];        /* half-res bloom ping-pong       */
 
     /* Plugin-owned MSAA transient resources for the forward lit pass.
@@ -62,15 +446,48 @@ struct PbrRenderer {
     uint32_t         current_msaa_samples; /* sample count of the allocated MSAA images */
     uint32_t         last_w, last_h;       /* viewport dimensions from last on_resize */
 
-    /* Shadow sampling views (one per cascade, created from shadow_att images).
-       The engine manages the depth-attachment view via qs_attachment_view();
-       these are separate sampler views created by the plugin. */
-    Qs_GpuImageView *shadow_sample_views[QS_CSM_CASCADES];
+    /* GPU scene: one PbrGpuObject per renderable, updated from the frame
+       arena with one copy region per run of dirty indices */
+    Qs_GpuBuffer     *object_buffer;
+    Qs_GpuBufferCopy *object_copies;
+    uint32_t          object_capacity;
+    bool              objects_stale;  /* next prepare re-uploads every object */
+
+    /* Bindless path: parameters of every material id, refreshed with the
+       GPU scene and copied to frame binding 9 each frame */
+    PbrGpuMaterial    materials[QS_MAX_MATERIALS];
+    uint32_t          material_count; /* highest material id seen + 1 */
+
+    /* Sorted, batched draw queues and their indirect commands, cull items
+       and visible indices, rebuilt every frame by the prepare node; the
+       GPU copies live in the frame arena */
+    PbrDrawQueue    shadow_queue[QS_CSM_CASCADES];  /* dynamic casters */
+    PbrDrawQueue    static_queue[QS_CSM_CASCADES];  /* casters of rebuilt caches */
+    PbrDrawQueue    forward_queue;
+    Qs_DrawList     prepass_list;    /* opaque forward batches, front to back;
+                                        empty when the pre-pass is skipped */
+    uint32_t       *caster_scratch;  /* pbr_csm_select_casters output */
+    uint32_t        caster_capacity;
+    PbrDrawCommand *draw_commands;   /* CPU staging of frame_commands */
+    PbrCullItem    *draw_items;      /* CPU staging of the cull items */
+    uint32_t        draw_capacity;
+    Qs_FrameAlloc   frame_commands;  /* this frame's indirect commands */
+
+    /* Two-phase occlusion culling.  The pyramid buffer is device-local,
+       sized by on_resize and rebuilt within each frame that uses it. */
+    Qs_GpuBuffer   *hiz_buffer;
+    PbrHiZLayout    hiz_layout;
+    uint32_t        occlusion_batches; /* forward batches occlusion-tested this
+                                          frame (the non-blended prefix); 0 = off */
+    uint32_t        late_shift;      /* late visible slot - early visible slot */
+    Qs_FrameAlloc   late_commands;   /* late cull commands of those batches */
 
     /* Render node handles (kept for removal in renderer_destroy) */
+    Qs_RenderNode *prepare_node;
     Qs_RenderNode *shadow_node;
     Qs_RenderNode *forward_node;
-    Qs_RenderNode *bloom_node;
+    Qs_RenderNode *bloom_down_node;
+    Qs_RenderNode *bloom_up_node;
     Qs_RenderNode *composite_node;
 
     bool ok; /* false until first renderer_on_resize completes */
@@ -78,25 +495,78 @@ struct PbrRenderer {
 
 typedef struct PbrRenderer PbrRenderer;
 
+/* ----------------------------------------------------------------
+   Shader modules used by the shared pipelines.  Compiled on the job
+   system from backend init so GLSL compilation overlaps the rest of
+   engine startup; consumed by the first renderer_create.
+   ---------------------------------------------------------------- */
+typedef enum PbrShader {
+    PBR_SHADER_SHADOW_VERT,
+    PBR_SHADER_SHADOW_FRAG,
+    PBR_SHADER_FORWARD_VERT,
+    PBR_SHADER_FORWARD_FRAG,
+    PBR_SHADER_FORWARD_BINDLESS_FRAG,
+    PBR_SHADER_DEPTH_VERT,
+    PBR_SHADER_FULLSCREEN_VERT,
+    PBR_SHADER_BLOOM_DOWN_FRAG,
+    PBR_SHADER_BLOOM_UP_FRAG,
+    PBR_SHADER_COMPOSITE_FRAG,
+    PBR_SHADER_CULL_COMP,
+    PBR_SHADER_CLUSTER_COMP,
+    PBR_SHADER_HIZ_SEED_COMP,
+    PBR_SHADER_HIZ_SEED_MS_COMP,
+    PBR_SHADER_HIZ_REDUCE_COMP,
+    PBR_SHADER_OCCLUSION_COMP,
+    PBR_SHADER_COUNT
+} PbrShader;
+
+typedef struct PbrShaderTask {
+    Qs_GpuContext *gpu;
+    Qs_GpuShader **out; /* PBR_SHADER_COUNT slots */
+} PbrShaderTask;
+
 /* ----------------------------------------------------------------
    Shared pipeline resources
    Shared across all renderer instances for efficiency.  Pipelines,
    pipeline layouts, descriptor set layouts, and samplers are
    stateless once created and safe to reuse.
    ---------------------------------------------------------------- */
+/* Forward passes with their own rasterizer / depth state */
+typedef enum PbrForwardPass {
+    PBR_FORWARD_LIT,
+    PBR_FORWARD_WIREFRAME,
+    PBR_FORWARD_EQUAL,      /* shades the pre-pass depth, depth writes off */
+    PBR_FORWARD_PASS_COUNT
+} PbrForwardPass;
+
 typedef struct PbrPassResources {
     /* Shadow depth-only pass (CSM) */
     Qs_GpuPipeline            *shadow_pipeline;
     Qs_GpuPipelineLayout      *shadow_layout;
 
     /* Forward lit pass
-     * One pipeline pair per MSAA tier: index 0=1×, 1=2×, 2=4×, 3=8×.
-     * Only entries up to [sample_count_to_idx(dev_max_samples)] are created. */
+     * One pipeline set per MSAA tier: index 0=1×, 1=2×, 2=4×, 3=8×.
+     * Only entries up to [sample_count_to_idx(dev_max_samples)] are created.
+     * The depth pre-pass lays down opaque depth with the position-only
+     * depth pipeline; the equal pass then shades those draws with depth
+     * writes off.  Forward pipelines are variants by material feature
+     * mask: the default one per pass and tier is created with the shared
+     * resources, the others on first use by forward_pass_execute. */
 #define PBR_MSAA_TIER_COUNT 4
-    Qs_GpuPipeline            *forward_pipelines[PBR_MSAA_TIER_COUNT];
-    Qs_GpuPipeline            *forward_wireframe_pipelines[PBR_MSAA_TIER_COUNT];
+    Qs_GpuPipeline            *forward_variants[PBR_FORWARD_PASS_COUNT]
+                                               [PBR_MSAA_TIER_COUNT][PBR_FEATURE_MASKS];
+    uint64_t                   variant_failed[PBR_FORWARD_PASS_COUNT]
+                                             [PBR_MSAA_TIER_COUNT]; /* bit per mask */
+    uint32_t                   variant_count;
+    uint64_t                   variant_create_ns; /* total spent creating them */
+    Qs_GpuPipeline            *depth_pipelines[PBR_MSAA_TIER_COUNT];
     Qs_GpuPipelineLayout      *forward_layout;
+    Qs_GpuShader              *forward_vs; /* kept for variants made later */
+    Qs_GpuShader              *forward_fs;
     Qs_GpuDescriptorSetLayout *frame_set_layout;
+    bool                       bindless; /* forward pipelines index the material
+                                            system's bindless set (set 1) and
+                                            frame binding 9 by material id */
     uint32_t                   dev_max_samples; /* highest tier supported by the device */
 
     /* Bloom (downsample / upsample) */
@@ -105,16 +575,44 @@ typedef struct PbrPassResources {
     Qs_GpuPipelineLayout      *bloom_layout;
     Qs_GpuDescriptorSetLayout *bloom_set_layout;
 
-    /* Composite (ACES tonemap + vignette  swapchain) */
+    /* Composite (ACES tonemap + vignette  swapchain); the FXAA variant
+       is NULL when it failed to build */
     Qs_GpuPipeline            *composite_pipeline;
+    Qs_GpuPipeline            *composite_fxaa_pipeline;
     Qs_GpuPipelineLayout      *composite_layout;
     Qs_GpuDescriptorSetLayout *composite_set_layout;
 
+    /* Frustum cull compute; NULL pipeline = CPU reference culling */
+    Qs_GpuPipeline            *cull_pipeline;
+    Qs_GpuPipelineLayout      *cull_layout;
+    Qs_GpuDescriptorSetLayout *cull_set_layout;
+
+    /* Hi-Z pyramid build and late occlusion cull; any NULL pipeline
+       turns occlusion culling off */
+    Qs_GpuPipeline            *hiz_seed_pipeline;    /* single-sample depth */
+    Qs_GpuPipeline            *hiz_seed_ms_pipeline; /* MSAA depth */
+    Qs_GpuPipeline            *hiz_reduce_pipeline;
+    Qs_GpuPipelineLayout      *hiz_layout;
+    Qs_GpuDescriptorSetLayout *hiz_set_layout;
+    Qs_GpuPipeline            *occlusion_pipeline;   /* uses cull_set_layout */
+    Qs_GpuPipelineLayout      *occlusion_layout;
+
+    /* Light binning compute; NULL pipeline = CPU binning */
+    Qs_GpuPipeline            *cluster_pipeline;
+    Qs_GpuPipelineLayout      *cluster_layout;
+    Qs_GpuDescriptorSetLayout *cluster_set_layout;
+
     /* Shared samplers */
     Qs_GpuSampler             *linear_sampler;
     Qs_GpuSampler             *point_sampler;
     Qs_GpuSampler             *shadow_sampler; /* compare/PCF */
 
+    /* Shader modules; released once the pipelines above exist */
+    Qs_GpuShader              *shaders[PBR_SHADER_COUNT];
+    PbrShaderTask              shader_task;
+    Qs_JobSystem              *shader_jobs;
+    Qs_JobCounter             *shader_counter; /* non-NULL while compiling */
+
     bool ok;
 } PbrPassResources;
 
@@ -128,6 +626,9 @@ PbrPassResources *pbr_renderer_pass_resources(void);
 /* Returns the active Qs_Renderer handle (set during renderer_create). */
 Qs_Renderer *pbr_active_renderer(void);
 
+/* Returns the plugin state behind pbr_active_renderer(), or NULL. */
+PbrRenderer *pbr_active_instance(void);
+
 /* Debug flag bits owned by the PBR plugin (stored in Qs_FrameUBO.debug_flags) */
 #define PBR_DEBUG_SHOW_NORMALS 0x1u
 
@@ -146,6 +647,13 @@ void pbr_forward_detach(PbrRenderer *r);
    viewport-scaled attachments.  Re-writes descriptor sets. */
 void pbr_forward_on_resize(PbrRenderer *r, uint32_t w, uint32_t h);
 
+/* Starts compiling the shared shader modules in one job-system job (the
+   compiler is serialized, so more jobs would only wait on each other).
+   Called from pbr_render_init; pipelines wait for the results at first
+   renderer_create. */
+void pbr_shaders_compile_async(Qs_Engine *engine, Qs_GpuContext *gpu,
+                               PbrPassResources *ps);
+
 /* Destroys all shared pass resources (pipelines, layouts, samplers).
    Called from pbr_render_shutdown after all renderer instances are gone. */
 void pbr_pass_resources_shutdown(Qs_GpuContext *gpu, PbrPassResources *ps);
@@ -154,10 +662,30 @@ void pbr_pass_resources_shutdown(Qs_GpuContext *gpu, PbrPassResources *ps);
    Post-process settings
    Exposed to the editor via the plugin's on_editor_ui callback.
    ---------------------------------------------------------------- */
+typedef enum PbrDepthPrepass {
+    PBR_DEPTH_PREPASS_OFF,
+    PBR_DEPTH_PREPASS_ON,
+    PBR_DEPTH_PREPASS_AUTO, /* per frame, from pbr_estimate_overdraw */
+} PbrDepthPrepass;
+
+typedef enum PbrAntiAliasing {
+    PBR_AA_MSAA, /* msaa_sample_count samples per pixel (1 = no AA) */
+    PBR_AA_FXAA, /* FXAA on the HDR image in the composite; no MSAA targets */
+} PbrAntiAliasing;
+
 typedef struct PbrPostProcessSettings {
     float    bloom_strength;    /* blend factor for bloom over HDR (default 0.04) */
     float    vignette_strength; /* vignette power exponent        (default 0.35)  */
     uint32_t msaa_sample_count; /* MSAA tier: 1=off, 2/4/8=on (default PBR_MSAA_SAMPLES) */
+    bool     gpu_culling;       /* frustum-cull draws in a compute pass (default true);
+                                   false runs pbr_cull_reference on the CPU */
+    bool     occlusion_culling; /* two-phase Hi-Z occlusion culling of the
+                                   forward draws (default true; needs
+                                   gpu_culling and a depth buffer) */
+    bool     gpu_light_binning; /* bin lights into clusters in a compute pass
+                                   (default false: SIMD binning on the CPU) */
+    PbrDepthPrepass depth_prepass; /* opaque depth pre-pass (default AUTO) */
+    PbrAntiAliasing anti_aliasing; /* default MSAA; FXAA ignores msaa_sample_count */
 } PbrPostProcessSettings;
 
 /* Returns a pointer to the single mutable post-process settings instance. */
@@ -5,12 +5,12 @@
  *   - Per-frame viewport callbacks (on_render / on_resize)
  *   - Camera, clear colour, render node list
  *   - Depth buffer, engine-declared render attachments
- *   - frame_ubo and lights_ubo (written by engine each frame)
+ *   - frame_ubo and lights_buffer per frame slot (written by engine each frame)
  *
  * The backend is responsible for:
  *   - Initialising the Vulkan render system (GPU context cache)
  *   - Creating / destroying per-renderer GPU resources (pipelines,
- *     descriptor sets, shadow UBO) via pbr_forward_attach / detach
+ *     descriptor sets, GPU scene) via pbr_forward_attach / detach
  *   - Re-writing descriptor sets after resize via pbr_forward_on_resize
  */
 
@@ -33,27 +33,34 @@ typedef struct {
 
 static VkRenderSystemData *g_render_system;
 
-/* Active Qs_Renderer handle — set in create, cleared in destroy.
-   Used by the plugin toolbar to access wireframe / debug_flags. */
+/* Active Qs_Renderer handle and its plugin state — set in create,
+   cleared in destroy.  Used by the plugin toolbar to access wireframe /
+   debug_flags and by the stats window. */
 static Qs_Renderer *s_active_handle = NULL;
+static PbrRenderer *s_active_impl   = NULL;
 
 Qs_Renderer *pbr_active_renderer(void)
 {
     return s_active_handle;
 }
 
+PbrRenderer *pbr_active_instance(void)
+{
+    return s_active_impl;
+}
+
 /* ================================================================
    BACKEND LIFECYCLE
    ================================================================ */
 
 static bool pbr_render_init(Qs_Engine *engine, Qs_GpuContext *gpu, void **out_ctx)
 {
-    (void)engine;
     VkRenderSystemData *data = calloc(1, sizeof(VkRenderSystemData));
     if (!data) return false;
     data->gpu      = gpu;
     g_render_system = data;
     *out_ctx        = data;
+    pbr_shaders_compile_async(engine, gpu, &data->passes);
     QS_LOG_INFO("PBR Renderer: render system initialised");
     return true;
 }
@@ -95,6 +102,7 @@ static void *pbr_renderer_create(void *ctx, Qs_Engine *engine,
     /* Attach the forward pass — declares attachments and adds render nodes. */
     pbr_forward_attach(engine, r, handle);
     s_active_handle = handle;
+    s_active_impl   = r;
     return r;
 }
 
@@ -106,8 +114,10 @@ static void pbr_renderer_destroy(void *ctx, void *impl)
 
     pbr_forward_detach(r);
 
-    if (s_active_handle == r->engine_renderer)
+    if (s_active_impl == r) {
         s_active_handle = NULL;
+        s_active_impl   = NULL;
+    }
 
     QS_LOG_INFO("PBR Renderer: '%s' destroyed", r->name);
     free(r);
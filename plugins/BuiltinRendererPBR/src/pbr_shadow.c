@@ -0,0 +1,276 @@
+/*
+ * pbr_shadow.c — Cascaded shadow map setup and caster selection.
+ *
+ * CPU-only helpers used by the prepare pass: the cascade matrices are
+ * derived from the camera and the first directional light, and each
+ * cascade draws only the casters that can darken a receiver it is
+ * sampled for.  Receivers pick the first cascade whose map covers them
+ * (see compute_shadow in FORWARD_FRAG), so a caster lying wholly inside
+ * the core of a nearer cascade — the map area sampled without blending —
+ * can only shade receivers that cascade serves, and is left out of the
+ * farther ones.  PbrShadowState then decides which cascades are redrawn
+ * each frame and which of their casters go through the static cache.
+ */
+
+#include "pbr_internal.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+void pbr_csm_compute(const Qs_Camera *cam,
+                     const Qs_LightGPU *lights, uint32_t light_count,
+                     float shadow_matrices[QS_CSM_CASCADES][16])
+{
+    /* Find the first directional light; fall back to a default sun direction. */
+    float light_dir[3] = { 0.4f, -1.0f, 0.3f };
+    for (uint32_t i = 0; i < light_count; i++) {
+        if (lights[i].type == (uint32_t)QS_LIGHT_DIRECTIONAL) {
+            light_dir[0] = lights[i].direction[0];
+            light_dir[1] = lights[i].direction[1];
+            light_dir[2] = lights[i].direction[2];
+            break;
+        }
+    }
+    float ld = sqrtf(light_dir[0]*light_dir[0]+light_dir[1]*light_dir[1]+light_dir[2]*light_dir[2]);
+    if (ld > 1e-6f) { light_dir[0]/=ld; light_dir[1]/=ld; light_dir[2]/=ld; }
+
+    float near_p = cam->near_plane > 0.0f ? cam->near_plane : 0.1f;
+    float far_p  = cam->far_plane  > 0.0f ? cam->far_plane  : 500.0f;
+
+    /* Practical Split Scheme (blend of logarithmic and uniform) */
+    float shadow_splits[QS_CSM_CASCADES + 1];
+    shadow_splits[0] = near_p;
+    for (int i = 1; i <= QS_CSM_CASCADES; i++) {
+        float fi = (float)i / (float)QS_CSM_CASCADES;
+        float lg = near_p * powf(far_p / near_p, fi);
+        float ln = near_p + (far_p - near_p) * fi;
+        shadow_splits[i] = 0.75f * lg + 0.25f * ln;
+    }
+
+    /* Light-space orthonormal basis */
+    float l_fwd[3] = { light_dir[0], light_dir[1], light_dir[2] };
+    float l_up[3]  = { 0.0f, 1.0f, 0.0f };
+    if (fabsf(l_fwd[1]) > 0.99f) { l_up[0] = 1.0f; l_up[1] = 0.0f; l_up[2] = 0.0f; }
+    float l_right[3] = {
+        l_fwd[1]*l_up[2]-l_fwd[2]*l_up[1],
+        l_fwd[2]*l_up[0]-l_fwd[0]*l_up[2],
+        l_fwd[0]*l_up[1]-l_fwd[1]*l_up[0]
+    };
+    float ll = sqrtf(l_right[0]*l_right[0]+l_right[1]*l_right[1]+l_right[2]*l_right[2]);
+    if (ll > 1e-6f) { l_right[0]/=ll; l_right[1]/=ll; l_right[2]/=ll; }
+    float l_up2[3] = {
+        l_right[1]*l_fwd[2]-l_right[2]*l_fwd[1],
+        l_right[2]*l_fwd[0]-l_right[0]*l_fwd[2],
+        l_right[0]*l_fwd[1]-l_right[1]*l_fwd[0]
+    };
+
+    for (int c = 0; c < QS_CSM_CASCADES; c++) {
+        float near_c = shadow_splits[c], far_c = shadow_splits[c+1];
+
+        /* Shadow map XY radius: proportional to cascade depth slice.
+           Anchored on the camera's orbit target so the tightest coverage always
+           wraps the visible scene even when the camera is looking steeply downward
+           (placing the view-ray midpoint underground). */
+        float radius = (far_c - near_c) * 0.6f + 2.0f;
+
+        float cx = cam->target[0];
+        float cy = cam->target[1];
+        float cz = cam->target[2];
+
+        /* Snap center to a grid of whole texels in light space: no shadow
+           shimmer, and the matrix only changes once per step (depth
+           included) so cached static casters stay valid in between. */
+        float step = 2.0f * radius / (float)QS_SHADOW_MAP_SIZE * (float)PBR_CSM_SNAP_TEXELS;
+        float lc_r = cx*l_right[0] + cy*l_right[1] + cz*l_right[2];
+        float lc_u = cx*l_up2[0]   + cy*l_up2[1]   + cz*l_up2[2];
+        float lc_d = cx*l_fwd[0]   + cy*l_fwd[1]   + cz*l_fwd[2];
+        lc_r = roundf(lc_r / step) * step;
+        lc_u = roundf(lc_u / step) * step;
+        lc_d = roundf(lc_d / step) * step;
+        cx = lc_r*l_right[0] + lc_u*l_up2[0] + lc_d*l_fwd[0];
+        cy = lc_r*l_right[1] + lc_u*l_up2[1] + lc_d*l_fwd[1];
+        cz = lc_r*l_right[2] + lc_u*l_up2[2] + lc_d*l_fwd[2];
+
+        /* Pull light eye back so scene geometry sits well within the depth range. */
+        float pull = radius;
+        float lx = cx - light_dir[0]*pull;
+        float ly = cy - light_dir[1]*pull;
+        float lz = cz - light_dir[2]*pull;
+
+        /* Standard GL right-handed view matrix: Z row = -l_fwd.
+           Objects land at view_z = -pull (negative), consistent with ortho below. */
+        float lv[16]; memset(lv, 0, 64);
+        lv[0]= l_right[0]; lv[4]= l_right[1]; lv[8]= l_right[2];  lv[12]=-(l_right[0]*lx+l_right[1]*ly+l_right[2]*lz);
+        lv[1]= l_up2[0];   lv[5]= l_up2[1];   lv[9]= l_up2[2];    lv[13]=-(l_up2[0]*lx+l_up2[1]*ly+l_up2[2]*lz);
+        lv[2]=-l_fwd[0];   lv[6]=-l_fwd[1];   lv[10]=-l_fwd[2];   lv[14]= (l_fwd[0]*lx+l_fwd[1]*ly+l_fwd[2]*lz);
+        lv[3]=0; lv[7]=0; lv[11]=0; lv[15]=1.0f;
+        float lp[16];
+        /* Symmetric Z range [-5r, +5r] keeps scene geometry (view_z = -pull = -r)
+           centred in the depth range at NDC z = 0.2, identical to the original. */
+        qs_m4_ortho_lrtbnf(lp, -radius, radius, -radius, radius, -radius*5.0f, radius*5.0f);
+        qs_m4_mul(lp, lv, shadow_matrices[c]);
+    }
+}
+
+/* ================================================================
+   CASTER SELECTION
+   ================================================================ */
+
+/* Plane bound*w + sign*row >= 0 of a column-major matrix, normalised. */
+static void clip_plane(float out[4], const float m[16], int row, float sign, float bound)
+{
+    for (int c = 0; c < 4; c++)
+        out[c] = bound * m[c*4 + 3] + sign * m[c*4 + row];
+    float len = sqrtf(out[0]*out[0] + out[1]*out[1] + out[2]*out[2]);
+    if (len > 0.0f)
+        for (int c = 0; c < 4; c++) out[c] /= len;
+}
+
+/* The part of a cascade's map sampled without blending: |x|,|y| within
+   PBR_CSM_BLEND_START and the stored depth range z in [0, 1]. */
+static void cascade_core(Qs_Frustum *out, const float m[16])
+{
+    clip_plane(out->planes[0], m, 0,  1.0f, PBR_CSM_BLEND_START);
+    clip_plane(out->planes[1], m, 0, -1.0f, PBR_CSM_BLEND_START);
+    clip_plane(out->planes[2], m, 1,  1.0f, PBR_CSM_BLEND_START);
+    clip_plane(out->planes[3], m, 1, -1.0f, PBR_CSM_BLEND_START);
+    clip_plane(out->planes[4], m, 2,  1.0f, 0.0f);
+    clip_plane(out->planes[5], m, 2, -1.0f, 1.0f);
+}
+
+static bool box_inside(const Qs_Frustum *f, const Qs_CullBounds *bounds, uint32_t i)
+{
+    float cx = bounds->center[0][i], cy = bounds->center[1][i], cz = bounds->center[2][i];
+    float ex = bounds->extent[0][i], ey = bounds->extent[1][i], ez = bounds->extent[2][i];
+    for (int p = 0; p < 6; p++) {
+        const float *pl = f->planes[p];
+        if (pl[0]*cx + pl[1]*cy + pl[2]*cz + pl[3]
+            - fabsf(pl[0])*ex - fabsf(pl[1])*ey - fabsf(pl[2])*ez < 0.0f)
+            return false;
+    }
+    return true;
+}
+
+uint32_t pbr_csm_select_casters(const float shadow_matrices[QS_CSM_CASCADES][16],
+                                uint32_t cascade, const Qs_CullBounds *bounds,
+                                const Qs_Renderable *renderables, uint32_t *out)
+{
+    /* Extrude toward the light: without a near plane the volume keeps
+       everything between the light and the far plane, and the shadow
+       vertex shader flattens casters beyond the near plane onto it. */
+    Qs_Frustum volume;
+    qs_frustum_from_matrix(&volume, shadow_matrices[cascade]);
+    memcpy(volume.planes[4], (float[4]){ 0.0f, 0.0f, 0.0f, 1.0f }, sizeof(volume.planes[4]));
+
+    Qs_Frustum cores[QS_CSM_CASCADES];
+    for (uint32_t c = 0; c < cascade; c++)
+        cascade_core(&cores[c], shadow_matrices[c]);
+
+    uint32_t hit   = qs_cull_frustum(&volume, bounds, out);
+    uint32_t count = 0;
+    for (uint32_t k = 0; k < hit; k++) {
+        uint32_t i = out[k];
+        if (!renderables[i].cast_shadows || !renderables[i].position_buffer) continue;
+        bool covered = false;
+        for (uint32_t c = 0; c < cascade && !covered; c++)
+            covered = box_inside(&cores[c], bounds, i);
+        if (!covered) out[count++] = i;
+    }
+    return count;
+}
+
+/* ================================================================
+   SCHEDULING AND STATIC CACHE
+   ================================================================ */
+
+bool pbr_shadow_begin_frame(PbrShadowState *s, const uint32_t *dirty,
+                            uint32_t dirty_count, uint32_t renderable_count)
+{
+    s->frame++;
+    if (renderable_count > s->capacity) {
+        uint32_t cap = s->capacity ? s->capacity : PBR_DRAW_INITIAL_CAPACITY;
+        while (cap < renderable_count) cap *= 2;
+        uint32_t *changed = realloc(s->changed, cap * sizeof(uint32_t));
+        if (changed) s->changed = changed;
+        uint8_t *cached = realloc(s->cached, cap * sizeof(uint8_t));
+        if (cached) s->cached = cached;
+        if (!changed || !cached) return false;
+        s->capacity = cap;
+    }
+
+    for (uint32_t i = renderable_count; i < s->count; i++)
+        s->cache_valid &= ~(uint32_t)s->cached[i];
+    for (uint32_t i = s->count; i < renderable_count; i++) {
+        s->changed[i] = s->frame;
+        s->cached[i]  = 0;
+    }
+    for (uint32_t k = 0; k < dirty_count; k++) {
+        uint32_t i = dirty[k];
+        if (i >= renderable_count) continue;
+        s->cache_valid &= ~(uint32_t)s->cached[i];
+        s->changed[i] = s->frame;
+        s->cached[i]  = 0;
+    }
+    s->count = renderable_count;
+    return true;
+}
+
+uint32_t pbr_shadow_schedule(PbrShadowState *s,
+                             const float fresh[QS_CSM_CASCADES][16])
+{
+    s->due = s->rebuild = 0;
+    bool moved = false;     /* a nearer cascade changed, so its core did */
+    for (uint32_t c = 0; c < QS_CSM_CASCADES; c++) {
+        uint32_t bit      = 1u << c;
+        uint32_t interval = 1u << (c * PBR_CSM_REFRESH_SHIFT);
+        bool due = moved || !(s->map_valid & s->cache_valid & bit) ||
+                   s->frame % interval == interval / 2;
+        if (!due) continue;
+
+        if (memcmp(s->matrices[c], fresh[c], sizeof(s->matrices[c])) != 0) {
+            memcpy(s->matrices[c], fresh[c], sizeof(s->matrices[c]));
+            moved = true;
+        }
+        if (moved) s->cache_valid &= ~bit;
+        s->due       |= bit;
+        s->map_valid |= bit;
+        if (s->cache_valid & bit) continue;
+
+        s->rebuild     |= bit;
+        s->cache_valid |= bit;
+        s->cached_count[c] = 0;
+        for (uint32_t i = 0; i < s->count; i++)
+            s->cached[i] &= (uint8_t)~bit;
+    }
+    return s->due;
+}
+
+PbrCasterPass pbr_shadow_classify(PbrShadowState *s, uint32_t cascade,
+                                  uint32_t renderable)
+{
+    uint32_t bit = 1u << cascade;
+    if (s->frame - s->changed[renderable] < PBR_SHADOW_STATIC_FRAMES)
+        return PBR_CASTER_DYNAMIC;
+    if (s->rebuild & bit) {
+        s->cached[renderable] |= (uint8_t)bit;
+        s->cached_count[cascade]++;
+        return PBR_CASTER_CACHE;
+    }
+    if (s->cached[renderable] & bit) return PBR_CASTER_SKIP;
+    /* Turned static since the last rebuild: fold it in at the next refresh */
+    s->cache_valid &= ~bit;
+    return PBR_CASTER_DYNAMIC;
+}
+
+void pbr_shadow_invalidate(PbrShadowState *s)
+{
+    s->map_valid = s->cache_valid = 0;
+}
+
+void pbr_shadow_state_free(PbrShadowState *s)
+{
+    free(s->changed);
+    free(s->cached);
+    memset(s, 0, sizeof(*s));
+}
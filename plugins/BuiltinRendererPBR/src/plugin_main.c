@@ -17,6 +17,8 @@ static Ca_Label     *s_lbl_frametime   = NULL;
 static Ca_Label     *s_lbl_bloom       = NULL;
 static Ca_Label     *s_lbl_vignette    = NULL;
 static Ca_Label     *s_lbl_msaa        = NULL;
+static Ca_Label     *s_lbl_casters     = NULL;
+static Ca_Label     *s_lbl_variants    = NULL;
 
 /* ---- on_frame: update stat labels ---- */
 
@@ -45,13 +47,29 @@ static void renderer_win_frame(void *data)
         PbrPassResources *ps = pbr_renderer_pass_resources();
         uint32_t samples = ps ? ps->dev_max_samples : 1;
         uint32_t cur = pp ? pp->msaa_sample_count : 1;
-        if (pp->msaa_sample_count > 1)
+        if (pp->anti_aliasing == PBR_AA_FXAA && ps && ps->composite_fxaa_pipeline)
+            snprintf(buf, sizeof(buf), "MSAA:        off (FXAA)");
+        else if (pp->msaa_sample_count > 1)
             snprintf(buf, sizeof(buf), "MSAA:        %ux", pp->msaa_sample_count);
         else
             snprintf(buf, sizeof(buf), "MSAA:        off");
         (void)samples;
         ca_set_text(s_lbl_msaa, buf);
     }
+
+    PbrRenderer *r = pbr_active_instance();
+    if (r) {
+        snprintf(buf, sizeof(buf), "Casters:     %u / %u / %u",
+                 r->shadow_casters[0], r->shadow_casters[1], r->shadow_casters[2]);
+        ca_set_text(s_lbl_casters, buf);
+    }
+
+    PbrPassResources *ps = pbr_renderer_pass_resources();
+    if (ps) {
+        snprintf(buf, sizeof(buf), "Variants:    %u (%.1f ms)",
+                 ps->variant_count, (double)ps->variant_create_ns / 1e6);
+        ca_set_text(s_lbl_variants, buf);
+    }
 }
 
 /* ---- Slider callbacks ---- */
@@ -77,6 +95,40 @@ static void on_msaa_select(Ca_Select *sel, void *user_data)
         pbr_post_process_settings()->msaa_sample_count = k_counts[idx];
 }
 
+static void on_aa_select(Ca_Select *sel, void *user_data)
+{
+    (void)user_data;
+    int idx = ca_select_get(sel);
+    if (idx >= PBR_AA_MSAA && idx <= PBR_AA_FXAA)
+        pbr_post_process_settings()->anti_aliasing = (PbrAntiAliasing)idx;
+}
+
+static void on_depth_prepass_select(Ca_Select *sel, void *user_data)
+{
+    (void)user_data;
+    int idx = ca_select_get(sel);
+    if (idx >= PBR_DEPTH_PREPASS_OFF && idx <= PBR_DEPTH_PREPASS_AUTO)
+        pbr_post_process_settings()->depth_prepass = (PbrDepthPrepass)idx;
+}
+
+static void on_gpu_culling_toggle(Ca_Checkbox *cb, void *user_data)
+{
+    (void)user_data;
+    pbr_post_process_settings()->gpu_culling = ca_checkbox_get(cb);
+}
+
+static void on_occlusion_culling_toggle(Ca_Checkbox *cb, void *user_data)
+{
+    (void)user_data;
+    pbr_post_process_settings()->occlusion_culling = ca_checkbox_get(cb);
+}
+
+static void on_gpu_light_binning_toggle(Ca_Checkbox *cb, void *user_data)
+{
+    (void)user_data;
+    pbr_post_process_settings()->gpu_light_binning = ca_checkbox_get(cb);
+}
+
 /* ---- Window builder ---- */
 
 static void open_renderer_window(void *user_data)
@@ -142,6 +194,27 @@ static void open_renderer_window(void *user_data)
         });
         ca_div_end();
 
+        {
+            static const char *k_labels[2] = {"MSAA", "FXAA"};
+            ca_div_begin(&(Ca_DivDesc){
+                .direction = CA_HORIZONTAL,
+                .style     = "renderer-setting-row",
+            });
+            ca_text(&(Ca_TextDesc){
+                .text  = "Anti-aliasing",
+                .style = "renderer-setting-label",
+            });
+            ca_div_begin(&(Ca_DivDesc){ .style = "pm-spacer" }); ca_div_end();
+            ca_select(&(Ca_SelectDesc){
+                .options      = k_labels,
+                .option_count = 2,
+                .selected     = pp ? (int)pp->anti_aliasing : PBR_AA_MSAA,
+                .on_change    = on_aa_select,
+                .style        = "inspector-select",
+            });
+            ca_div_end();
+        }
+
         {
             static const char *k_labels[4] = {"Off (1x)", "2x", "4x", "8x"};
             static const uint32_t k_counts[4] = {1, 2, 4, 8};
@@ -171,6 +244,51 @@ static void open_renderer_window(void *user_data)
             ca_div_end();
         }
 
+        {
+            static const char *k_labels[3] = {"Off", "On", "Auto"};
+            ca_div_begin(&(Ca_DivDesc){
+                .direction = CA_HORIZONTAL,
+                .style     = "renderer-setting-row",
+            });
+            ca_text(&(Ca_TextDesc){
+                .text  = "Depth Pre-pass",
+                .style = "renderer-setting-label",
+            });
+            ca_div_begin(&(Ca_DivDesc){ .style = "pm-spacer" }); ca_div_end();
+            ca_select(&(Ca_SelectDesc){
+                .options      = k_labels,
+                .option_count = 3,
+                .selected     = pp ? (int)pp->depth_prepass : PBR_DEPTH_PREPASS_AUTO,
+                .on_change    = on_depth_prepass_select,
+                .style        = "inspector-select",
+            });
+            ca_div_end();
+        }
+
+        ca_div_begin(&(Ca_DivDesc){
+            .direction = CA_VERTICAL,
+            .style     = "renderer-setting-row",
+        });
+        ca_checkbox(&(Ca_CheckboxDesc){
+            .text      = "GPU Culling",
+            .checked   = pp ? pp->gpu_culling : false,
+            .id        = "renderer-gpu-culling",
+            .on_change = on_gpu_culling_toggle,
+        });
+        ca_checkbox(&(Ca_CheckboxDesc){
+            .text      = "Occlusion Culling",
+            .checked   = pp ? pp->occlusion_culling : false,
+            .id        = "renderer-occlusion-culling",
+            .on_change = on_occlusion_culling_toggle,
+        });
+        ca_checkbox(&(Ca_CheckboxDesc){
+            .text      = "GPU Light Binning",
+            .checked   = pp ? pp->gpu_light_binning : false,
+            .id        = "renderer-gpu-light-binning",
+            .on_change = on_gpu_light_binning_toggle,
+        });
+        ca_div_end();
+
         ca_hr(&(Ca_HrDesc){ .color = 0 });
 
         /* ---- Stats section ---- */
@@ -188,6 +306,8 @@ static void open_renderer_window(void *user_data)
         s_lbl_bloom    = ca_text(&(Ca_TextDesc){ .text = "Bloom:",       .style = "renderer-stat-row" });
         s_lbl_vignette = ca_text(&(Ca_TextDesc){ .text = "Vignette:",    .style = "renderer-stat-row" });
         s_lbl_msaa     = ca_text(&(Ca_TextDesc){ .text = "MSAA:",        .style = "renderer-stat-row" });
+        s_lbl_casters  = ca_text(&(Ca_TextDesc){ .text = "Casters:",     .style = "renderer-stat-row" });
+        s_lbl_variants = ca_text(&(Ca_TextDesc){ .text = "Variants:",    .style = "renderer-stat-row" });
         ca_div_end();
     }
     ca_ui_end();
@@ -239,6 +359,8 @@ static void on_unload(Qs_Engine *engine)
     s_lbl_bloom      = NULL;
     s_lbl_vignette   = NULL;
     s_lbl_msaa       = NULL;
+    s_lbl_casters    = NULL;
+    s_lbl_variants   = NULL;
     s_engine         = NULL;
     qs_renderer_backend_unregister("PBRRenderer");
 }
@@ -0,0 +1,374 @@
+/*
+ * bench_occlusion.c — software occlusion culling (qs_occlusion.c) on a
+ * synthetic city: a grid of box buildings with props scattered along
+ * the streets, seen from a camera walking down the avenues at street
+ * level and above the roofs.
+ *
+ * Every frame the frustum-visible buildings are added front to back as
+ * occluders, rasterized on one thread and every frustum-visible box is
+ * tested, as the renderer does.  An exact per-pixel depth buffer of the
+ * same buildings is the reference: a box is hidden when its nearest
+ * depth lies behind every reference pixel under its screen rectangle.
+ *
+ *   bench_occlusion [grid] [width] [height] [frames]
+ *
+ * defaults to a 40x40 city at 256x144 over 60 frames.  --quick runs a
+ * small city for ctest.  Fails when a box the reference sees is culled.
+ */
+
+#include "qs_math.h"
+#include "qs_occlusion.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#define CITY_BLOCK        30.0f   /* building footprint */
+#define CITY_STREET       12.0f
+#define CITY_PROPS        20      /* per building */
+#define CITY_SEED         7u
+
+static double now_ms(void)
+{
+#ifdef _WIN32
+    static LARGE_INTEGER freq = {0};
+    if (!freq.QuadPart) QueryPerformanceFrequency(&freq);
+    LARGE_INTEGER t;
+    QueryPerformanceCounter(&t);
+    return (double)t.QuadPart * 1e3 / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e3 + (double)ts.tv_nsec * 1e-6;
+#endif
+}
+
+static uint32_t rng = CITY_SEED;
+
+static float randf(void)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return (float)(rng >> 8) * (1.0f / 16777216.0f);
+}
+
+static const float    cube_positions[24] = { -1,-1,-1, 1,-1,-1, 1,1,-1, -1,1,-1,
+                                             -1,-1, 1, 1,-1, 1, 1,1, 1, -1,1, 1 };
+static const uint32_t cube_indices[36]   = { 0,1,2, 0,2,3, 4,6,5, 4,7,6, 0,4,5, 0,5,1,
+                                             3,2,6, 3,6,7, 0,3,7, 0,7,4, 1,5,6, 1,6,2 };
+
+/* ================================================================
+   REFERENCE DEPTH BUFFER
+   Double-precision rasterization at pixel centres after clipping to
+   the frustum, nearest depth kept.
+   ================================================================ */
+
+typedef struct RefDepth {
+    float   *z;
+    uint32_t width, height;
+} RefDepth;
+
+static void ref_triangle(RefDepth *ref, const double *v[3])
+{
+    double x[3], y[3], z[3];
+    for (int k = 0; k < 3; k++) {
+        x[k] = (v[k][0] / v[k][3] * 0.5 + 0.5) * ref->width;
+        y[k] = (v[k][1] / v[k][3] * 0.5 + 0.5) * ref->height;
+        z[k] = v[k][2] / v[k][3];
+    }
+    double area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+    if (area == 0.0) return;
+    int x0 = (int)fmax(0.0, floor(fmin(x[0], fmin(x[1], x[2]))));
+    int x1 = (int)fmin(ref->width - 1.0, ceil(fmax(x[0], fmax(x[1], x[2]))));
+    int y0 = (int)fmax(0.0, floor(fmin(y[0], fmin(y[1], y[2]))));
+    int y1 = (int)fmin(ref->height - 1.0, ceil(fmax(y[0], fmax(y[1], y[2]))));
+    for (int py = y0; py <= y1; py++)
+        for (int px = x0; px <= x1; px++) {
+            double p[2] = { px + 0.5, py + 0.5 }, w[3];
+            for (int k = 0; k < 3; k++) {
+                int j = (k + 1) % 3, l = (k + 2) % 3;
+                w[l] = ((x[j] - x[k]) * (p[1] - y[k]) - (y[j] - y[k]) * (p[0] - x[k])) / area;
+            }
+            if (w[0] < 0.0 || w[1] < 0.0 || w[2] < 0.0) continue;
+            float d = (float)(w[0] * z[0] + w[1] * z[1] + w[2] * z[2]);
+            float *dst = &ref->z[py * ref->width + px];
+            if (d < *dst) *dst = d;
+        }
+}
+
+static double plane_distance(const double v[4], int plane)
+{
+    switch (plane) {
+    case 0:  return v[3] + v[0];
+    case 1:  return v[3] - v[0];
+    case 2:  return v[3] + v[1];
+    case 3:  return v[3] - v[1];
+    default: return v[3] + v[2];
+    }
+}
+
+/* Clips to the side and near planes, then fans the polygon */
+static void ref_clip_triangle(RefDepth *ref, const double *a, const double *b, const double *c)
+{
+    double poly[2][16][4];
+    int    n = 3, cur = 0;
+    memcpy(poly[0][0], a, sizeof(poly[0][0]));
+    memcpy(poly[0][1], b, sizeof(poly[0][0]));
+    memcpy(poly[0][2], c, sizeof(poly[0][0]));
+    for (int plane = 0; plane < 5 && n >= 3; plane++) {
+        int m = 0;
+        for (int i = 0; i < n; i++) {
+            const double *p = poly[cur][i], *q = poly[cur][(i + 1) % n];
+            double dp = plane_distance(p, plane), dq = plane_distance(q, plane);
+            if (dp >= 0.0) memcpy(poly[cur ^ 1][m++], p, sizeof(poly[0][0]));
+            if ((dp >= 0.0) != (dq >= 0.0)) {
+                double s = dp / (dp - dq);
+                for (int k = 0; k < 4; k++) poly[cur ^ 1][m][k] = p[k] + (q[k] - p[k]) * s;
+                m++;
+            }
+        }
+        n   = m;
+        cur ^= 1;
+    }
+    for (int i = 2; i < n; i++)
+        ref_triangle(ref, (const double *[3]){ poly[cur][0], poly[cur][i - 1], poly[cur][i] });
+}
+
+static void ref_add_cube(RefDepth *ref, const float clip_from_model[16])
+{
+    double v[8][4];
+    for (int i = 0; i < 8; i++) {
+        const float *p = cube_positions + i * 3;
+        for (int r = 0; r < 4; r++)
+            v[i][r] = (double)clip_from_model[r] * p[0] + (double)clip_from_model[r + 4] * p[1]
+                    + (double)clip_from_model[r + 8] * p[2] + clip_from_model[r + 12];
+    }
+    for (int t = 0; t < 36; t += 3)
+        ref_clip_triangle(ref, v[cube_indices[t]], v[cube_indices[t + 1]], v[cube_indices[t + 2]]);
+}
+
+/* Whether the box lies behind every reference pixel under its screen
+   rectangle; boxes reaching behind the eye never are */
+static bool ref_hidden(const RefDepth *ref, const float view_proj[16],
+                       const float center[3], const float extent[3])
+{
+    const float *m = view_proj;
+    double lo[3] = { INFINITY, INFINITY, INFINITY }, hi[2] = { -INFINITY, -INFINITY };
+    for (int k = 0; k < 8; k++) {
+        double p[3] = { center[0] + ((k & 1) ? extent[0] : -extent[0]),
+                        center[1] + ((k & 2) ? extent[1] : -extent[1]),
+                        center[2] + ((k & 4) ? extent[2] : -extent[2]) };
+        double w = m[3] * p[0] + m[7] * p[1] + m[11] * p[2] + m[15];
+        if (w <= 0.0) return false;
+        for (int a = 0; a < 3; a++) {
+            double v = (m[a] * p[0] + m[a + 4] * p[1] + m[a + 8] * p[2] + m[a + 12]) / w;
+            lo[a] = fmin(lo[a], v);
+            if (a < 2) hi[a] = fmax(hi[a], v);
+        }
+    }
+    int x0 = (int)floor((fmax(lo[0], -1.0) * 0.5 + 0.5) * ref->width);
+    int x1 = (int)floor((fmin(hi[0],  1.0) * 0.5 + 0.5) * ref->width);
+    int y0 = (int)floor((fmax(lo[1], -1.0) * 0.5 + 0.5) * ref->height);
+    int y1 = (int)floor((fmin(hi[1],  1.0) * 0.5 + 0.5) * ref->height);
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 > (int)ref->width - 1)  x1 = (int)ref->width - 1;
+    if (y1 > (int)ref->height - 1) y1 = (int)ref->height - 1;
+    for (int y = y0; y <= y1; y++)
+        for (int x = x0; x <= x1; x++)
+            if (!(lo[2] > ref->z[y * ref->width + x])) return false;
+    return true;
+}
+
+/* ================================================================
+   CITY
+   ================================================================ */
+
+typedef struct City {
+    uint32_t      buildings;      /* bounds [0, buildings) */
+    uint32_t      count;          /* buildings plus props */
+    float       (*model)[16];     /* unit cube to building */
+    Qs_CullBounds bounds;
+} City;
+
+static bool city_create(City *city, uint32_t grid)
+{
+    memset(city, 0, sizeof(*city));
+    city->buildings = grid * grid;
+    city->count     = city->buildings * (1 + CITY_PROPS);
+    city->model     = malloc(city->buildings * sizeof(*city->model));
+    if (!city->model || !qs_cull_bounds_reserve(&city->bounds, city->count)) return false;
+
+    const float pitch = CITY_BLOCK + CITY_STREET, half = CITY_BLOCK * 0.5f;
+    for (uint32_t i = 0; i < grid; i++)
+        for (uint32_t j = 0; j < grid; j++) {
+            uint32_t b  = i * grid + j;
+            float    hy = 10.0f + randf() * 60.0f;
+            float    cx = ((float)i - (float)(grid / 2)) * pitch;
+            float    cz = ((float)j - (float)(grid / 2)) * pitch;
+            float   *m  = city->model[b];
+            memset(m, 0, 16 * sizeof(float));
+            m[0]  = half; m[5] = hy; m[10] = half;
+            m[12] = cx;   m[13] = hy; m[14] = cz; m[15] = 1.0f;
+            qs_cull_bounds_set(&city->bounds, b, &(Qs_AABB){ { cx - half, 0.0f, cz - half },
+                                                             { cx + half, 2.0f * hy, cz + half } });
+        }
+    for (uint32_t p = city->buildings; p < city->count; p++) {
+        float cx = (floorf(randf() * (float)grid) - (float)(grid / 2)) * pitch + half + CITY_STREET * randf();
+        float cz = (floorf(randf() * (float)grid) - (float)(grid / 2)) * pitch + pitch * randf() - half;
+        if (randf() < 0.5f) { float t = cx; cx = cz; cz = t; }
+        float s = 0.5f + randf() * 2.0f;
+        qs_cull_bounds_set(&city->bounds, p, &(Qs_AABB){ { cx - s, 0.0f, cz - s },
+                                                         { cx + s, 2.0f * s, cz + s } });
+    }
+    return true;
+}
+
+static void city_destroy(City *city)
+{
+    free(city->model);
+    qs_cull_bounds_free(&city->bounds);
+}
+
+/* Walks down the avenues, looking around, at street level and from two
+   storeys of rooftops */
+static void frame_camera(uint32_t frame, float aspect, float view_proj[16], float eye[3])
+{
+    const float pitch = CITY_BLOCK + CITY_STREET;
+    float angle = (float)frame * 0.1f;
+    eye[0] = ((float)(frame % 7) - 3.0f) * pitch + CITY_BLOCK * 0.5f + CITY_STREET * 0.5f;
+    eye[1] = 1.7f + (float)(frame % 3) * 15.0f;
+    eye[2] = -200.0f + (float)frame * 5.0f;
+    const float center[3] = { eye[0] + sinf(angle) * 10.0f, eye[1] - 0.5f, eye[2] + cosf(angle) * 10.0f };
+    const float up[3]     = { 0.0f, 1.0f, 0.0f };
+    float view[16], proj[16];
+    qs_m4_look_at(view, eye, center, up);
+    qs_m4_perspective(proj, 1.0f, aspect, 0.1f, 2000.0f);
+    qs_m4_mul(proj, view, view_proj);
+}
+
+/* ================================================================
+   MAIN
+   ================================================================ */
+
+static const float *sort_distance;
+
+static int by_distance(const void *a, const void *b)
+{
+    float da = sort_distance[*(const uint32_t *)a], db = sort_distance[*(const uint32_t *)b];
+    return (da > db) - (da < db);
+}
+
+int main(int argc, char **argv)
+{
+    bool     quick  = argc > 1 && strcmp(argv[1], "--quick") == 0;
+    uint32_t grid   = quick ? 12 : 40, width = 256, height = 144, frames = quick ? 6 : 60;
+    if (!quick) {
+        if (argc > 1) grid   = (uint32_t)atoi(argv[1]);
+        if (argc > 2) width  = (uint32_t)atoi(argv[2]);
+        if (argc > 3) height = (uint32_t)atoi(argv[3]);
+        if (argc > 4) frames = (uint32_t)atoi(argv[4]);
+    }
+    width  = (width  + QS_OCCLUSION_TILE_WIDTH  - 1) / QS_OCCLUSION_TILE_WIDTH  * QS_OCCLUSION_TILE_WIDTH;
+    height = (height + QS_OCCLUSION_TILE_HEIGHT - 1) / QS_OCCLUSION_TILE_HEIGHT * QS_OCCLUSION_TILE_HEIGHT;
+
+    City city;
+    Qs_OcclusionBuffer *buffer = qs_occlusion_create(width, height);
+    RefDepth ref = { malloc((size_t)width * height * sizeof(float)), width, height };
+    bool ok = city_create(&city, grid) && buffer && ref.z;
+    uint32_t *candidates = ok ? malloc(city.count * sizeof(uint32_t)) : NULL;
+    uint32_t *visible    = ok ? malloc(city.count * sizeof(uint32_t)) : NULL;
+    uint32_t *occluders  = ok ? malloc(city.buildings * sizeof(uint32_t)) : NULL;
+    float    *distance   = ok ? malloc(city.buildings * sizeof(float)) : NULL;
+    if (!ok || !candidates || !visible || !occluders || !distance) {
+        fprintf(stderr, "bench_occlusion: out of memory\n");
+        return 1;
+    }
+
+    const Qs_OccluderMesh cube = { cube_positions, cube_indices, 8, 36 };
+    uint64_t tested = 0, culled = 0, hidden = 0, wrong = 0, triangles = 0;
+    double   t_add = 0.0, t_raster = 0.0, t_test = 0.0;
+    for (uint32_t frame = 0; frame < frames; frame++) {
+        float view_proj[16], eye[3];
+        frame_camera(frame, (float)width / (float)height, view_proj, eye);
+        Qs_Frustum frustum;
+        qs_frustum_from_matrix(&frustum, view_proj);
+        uint32_t count = qs_cull_frustum(&frustum, &city.bounds, candidates);
+
+        /* Frustum-visible buildings, front to back */
+        uint32_t occluder_count = 0;
+        for (uint32_t k = 0; k < count && candidates[k] < city.buildings; k++) {
+            uint32_t b  = candidates[k];
+            float    dx = city.model[b][12] - eye[0], dz = city.model[b][14] - eye[2];
+            distance[b] = dx * dx + dz * dz;
+            occluders[occluder_count++] = b;
+        }
+        sort_distance = distance;
+        qsort(occluders, occluder_count, sizeof(uint32_t), by_distance);
+
+        double t0 = now_ms();
+        qs_occlusion_clear(buffer);
+        for (uint32_t k = 0; k < occluder_count; k++) {
+            float clip_from_model[16];
+            qs_m4_mul(view_proj, city.model[occluders[k]], clip_from_model);
+            qs_occlusion_add(buffer, &cube, clip_from_model);
+        }
+        double t1 = now_ms();
+        qs_occlusion_rasterize(buffer, NULL);
+        double t2 = now_ms();
+        uint32_t visible_count = qs_occlusion_cull(buffer, view_proj, &city.bounds,
+                                                   candidates, count, visible);
+        double t3 = now_ms();
+        t_add    += t1 - t0;
+        t_raster += t2 - t1;
+        t_test   += t3 - t2;
+        tested   += count;
+        culled   += count - visible_count;
+        triangles += occluder_count * 12u;
+
+        for (uint32_t i = 0; i < width * height; i++) ref.z[i] = INFINITY;
+        for (uint32_t k = 0; k < occluder_count; k++) {
+            float clip_from_model[16];
+            qs_m4_mul(view_proj, city.model[occluders[k]], clip_from_model);
+            ref_add_cube(&ref, clip_from_model);
+        }
+        for (uint32_t k = 0, v = 0; k < count; k++) {
+            uint32_t i = candidates[k];
+            bool kept = v < visible_count && visible[v] == i;
+            if (kept) v++;
+            const float center[3] = { city.bounds.center[0][i], city.bounds.center[1][i],
+                                      city.bounds.center[2][i] };
+            const float extent[3] = { city.bounds.extent[0][i], city.bounds.extent[1][i],
+                                      city.bounds.extent[2][i] };
+            bool is_hidden = ref_hidden(&ref, view_proj, center, extent);
+            hidden += is_hidden;
+            if (!kept && !is_hidden) {
+                if (wrong < 8) fprintf(stderr, "frame %u: box %u culled but visible\n", frame, i);
+                wrong++;
+            }
+        }
+    }
+
+    printf("city %ux%u, %u boxes, %ux%u, %u frames\n", grid, grid, city.count, width, height, frames);
+    printf("tested %llu  culled %llu  hidden (exact) %llu  wrongly culled %llu\n",
+           (unsigned long long)tested, (unsigned long long)culled,
+           (unsigned long long)hidden, (unsigned long long)wrong);
+    printf("per frame: %.0f occluder triangles  add %.3f ms  rasterize %.3f ms  test %.3f ms\n",
+           (double)triangles / frames, t_add / frames, t_raster / frames, t_test / frames);
+
+    free(distance);
+    free(occluders);
+    free(visible);
+    free(candidates);
+    free(ref.z);
+    qs_occlusion_destroy(buffer);
+    city_destroy(&city);
+    return wrong == 0 && culled > 0 ? 0 : 1;
+}
@@ -0,0 +1,65 @@
+#ifndef QS_TEST_H
+#define QS_TEST_H
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/* ================================================================
+   UNIT TEST HARNESS
+   Each test executable runs its static test functions from main with
+   QS_TEST_RUN and returns QS_TEST_RESULT().  A failed check prints its
+   location and the test keeps going, so one run reports every failure.
+   ================================================================ */
+
+static int qs_test_failures = 0;
+
+#define QS_CHECK(cond) do {                                                  \
+        if (!(cond)) {                                                       \
+            fprintf(stderr, "%s:%d: check failed: %s\n",                     \
+                    __FILE__, __LINE__, #cond);                              \
+            qs_test_failures++;                                              \
+        }                                                                    \
+    } while (0)
+
+#define QS_CHECK_EQ_U(a, b) do {                                             \
+        unsigned long long qs_a_ = (unsigned long long)(a);                  \
+        unsigned long long qs_b_ = (unsigned long long)(b);                  \
+        if (qs_a_ != qs_b_) {                                                \
+            fprintf(stderr, "%s:%d: %s == %s failed: %llu != %llu\n",        \
+                    __FILE__, __LINE__, #a, #b, qs_a_, qs_b_);               \
+            qs_test_failures++;                                              \
+        }                                                                    \
+    } while (0)
+
+#define QS_CHECK_NEAR(a, b, tol) do {                                        \
+        double qs_a_ = (double)(a), qs_b_ = (double)(b);                     \
+        if (!(fabs(qs_a_ - qs_b_) <= (double)(tol))) {                       \
+            fprintf(stderr, "%s:%d: %s ~= %s failed: %g != %g\n",            \
+                    __FILE__, __LINE__, #a, #b, qs_a_, qs_b_);               \
+            qs_test_failures++;                                              \
+        }                                                                    \
+    } while (0)
+
+#define QS_TEST_RUN(fn) do {                                                 \
+        int qs_before_ = qs_test_failures;                                   \
+        fn();                                                                \
+        printf("%s %s\n", qs_test_failures == qs_before_ ? "ok  " : "FAIL", #fn); \
+    } while (0)
+
+#define QS_TEST_RESULT() (qs_test_failures ? 1 : 0)
+
+/* Deterministic xorshift32 so synthetic scenes match on every platform. */
+static uint32_t qs_test_rng = 0x9E3779B9u;
+
+static inline void qs_test_seed(uint32_t seed) { qs_test_rng = seed ? seed : 0x9E3779B9u; }
+
+static inline float qs_test_randf(float lo, float hi)
+{
+    qs_test_rng ^= qs_test_rng << 13;
+    qs_test_rng ^= qs_test_rng >> 17;
+    qs_test_rng ^= qs_test_rng << 5;
+    return lo + (hi - lo) * (float)(qs_test_rng >> 8) * (1.0f / 16777216.0f);
+}
+
+#endif
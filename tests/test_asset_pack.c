@@ -0,0 +1,147 @@
+/*
+ * test_asset_pack.c — .qsmesh compatibility: v1 files with interleaved
+ * vertices and v2 files with split position / attribute streams load to
+ * the same mesh, and files from a newer version are rejected.
+ */
+
+#include "qs_asset_pack_internal.h"
+#include "qs_test.h"
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MESH_VERTICES 37
+#define MESH_INDICES  60
+
+static const char *const V1_PATH     = "test_asset_pack_v1.qsmesh";
+static const char *const V2_PATH     = "test_asset_pack_v2.qsmesh";
+static const char *const FUTURE_PATH = "test_asset_pack_v3.qsmesh";
+static const char *const SHORT_PATH  = "test_asset_pack_short.qsmesh";
+
+static Qs_Vertex vertices[MESH_VERTICES];
+static uint32_t  indices[MESH_INDICES];
+
+static void make_mesh(void)
+{
+    qs_test_seed(49);
+    for (uint32_t i = 0; i < MESH_VERTICES; i++) {
+        Qs_Vertex *v = &vertices[i];
+        for (int k = 0; k < 3; k++) v->position[k] = qs_test_randf(-10.0f, 10.0f);
+        for (int k = 0; k < 3; k++) v->normal[k]   = qs_test_randf(-1.0f, 1.0f);
+        for (int k = 0; k < 4; k++) v->tangent[k]  = qs_test_randf(-1.0f, 1.0f);
+        for (int k = 0; k < 2; k++) v->uv[k]       = qs_test_randf(0.0f, 1.0f);
+    }
+    for (uint32_t i = 0; i < MESH_INDICES; i++)
+        indices[i] = (i * 7u) % MESH_VERTICES;
+}
+
+static Qs_MeshFileHeader make_header(uint32_t version, uint32_t flags)
+{
+    Qs_MeshFileHeader h;
+    memset(&h, 0, sizeof(h));
+    h.magic        = QS_MESH_MAGIC;
+    h.version      = version;
+    h.vertex_count = MESH_VERTICES;
+    h.index_count  = MESH_INDICES;
+    h.aabb_min[0]  = h.aabb_min[1] = h.aabb_min[2] = -10.0f;
+    h.aabb_max[0]  = h.aabb_max[1] = h.aabb_max[2] =  10.0f;
+    h.flags        = flags;
+    snprintf(h.surface_name, sizeof(h.surface_name), "surface");
+    return h;
+}
+
+/* Writes header_size bytes of h, then vertex_bytes of verts and the
+   indices */
+static bool write_mesh(const char *path, const Qs_MeshFileHeader *h, size_t header_size,
+                       const void *verts, size_t vertex_bytes)
+{
+    FILE *f = fopen(path, "wb");
+    if (!f) return false;
+    bool ok = fwrite(h, header_size, 1, f) == 1 &&
+              fwrite(verts, vertex_bytes, 1, f) == 1 &&
+              fwrite(indices, sizeof(indices), 1, f) == 1;
+    return fclose(f) == 0 && ok;
+}
+
+static void test_v1_and_v2_load_alike(void)
+{
+    make_mesh();
+    Qs_MeshFileHeader v1 = make_header(1, 0);
+    QS_CHECK(write_mesh(V1_PATH, &v1, offsetof(Qs_MeshFileHeader, flags),
+                        vertices, sizeof(vertices)));
+    Qs_Vertex split[MESH_VERTICES];
+    memcpy(split, vertices, sizeof(split));
+    QS_CHECK(qs_asset_split_vertex_streams(split, MESH_VERTICES));
+    Qs_MeshFileHeader v2 = make_header(QS_MESH_VERSION, QS_MESH_FLAG_SPLIT_STREAMS);
+    QS_CHECK(write_mesh(V2_PATH, &v2, sizeof(v2), split, sizeof(split)));
+
+    Qs_MeshFileHeader h1, h2;
+    void *verts1 = NULL, *verts2 = NULL;
+    uint32_t *idx1 = NULL, *idx2 = NULL;
+    QS_CHECK(qs_asset_read_qsmesh(V1_PATH, &h1, &verts1, &idx1));
+    QS_CHECK(qs_asset_read_qsmesh(V2_PATH, &h2, &verts2, &idx2));
+    if (!verts1 || !verts2) goto done;
+
+    QS_CHECK_EQ_U(h1.flags, 0);
+    QS_CHECK_EQ_U(h2.flags, QS_MESH_FLAG_SPLIT_STREAMS);
+    QS_CHECK_EQ_U(h1.vertex_count, MESH_VERTICES);
+    QS_CHECK_EQ_U(h2.vertex_count, MESH_VERTICES);
+    QS_CHECK_EQ_U(h1.index_count, MESH_INDICES);
+    QS_CHECK_EQ_U(h2.index_count, MESH_INDICES);
+    QS_CHECK(strcmp(h1.surface_name, h2.surface_name) == 0);
+    QS_CHECK(memcmp(h1.aabb_min, h2.aabb_min, sizeof(h1.aabb_min)) == 0);
+    QS_CHECK(memcmp(h1.aabb_max, h2.aabb_max, sizeof(h1.aabb_max)) == 0);
+    QS_CHECK(memcmp(idx1, indices, sizeof(indices)) == 0);
+    QS_CHECK(memcmp(idx2, indices, sizeof(indices)) == 0);
+
+    /* v1 comes back interleaved as written; v2 as the two streams */
+    QS_CHECK(memcmp(verts1, vertices, sizeof(vertices)) == 0);
+    const float               *positions  = verts2;
+    const Qs_VertexAttributes *attributes =
+        (const Qs_VertexAttributes *)(positions + 3 * (size_t)MESH_VERTICES);
+    for (uint32_t i = 0; i < MESH_VERTICES; i++) {
+        const Qs_Vertex *v = &vertices[i];
+        QS_CHECK(memcmp(positions + 3 * (size_t)i, v->position, sizeof(v->position)) == 0);
+        QS_CHECK(memcmp(attributes[i].normal,  v->normal,  sizeof(v->normal))  == 0);
+        QS_CHECK(memcmp(attributes[i].tangent, v->tangent, sizeof(v->tangent)) == 0);
+        QS_CHECK(memcmp(attributes[i].uv,      v->uv,      sizeof(v->uv))      == 0);
+    }
+
+    /* Splitting the v1 vertices as the loader's consumers do gives v2 */
+    QS_CHECK(qs_asset_split_vertex_streams(verts1, MESH_VERTICES));
+    QS_CHECK(memcmp(verts1, verts2, sizeof(vertices)) == 0);
+
+done:
+    free(verts1); free(idx1);
+    free(verts2); free(idx2);
+    remove(V1_PATH);
+    remove(V2_PATH);
+}
+
+static void test_newer_version_rejected(void)
+{
+    make_mesh();
+    Qs_MeshFileHeader h = make_header(QS_MESH_VERSION + 1, QS_MESH_FLAG_SPLIT_STREAMS);
+    QS_CHECK(write_mesh(FUTURE_PATH, &h, sizeof(h), vertices, sizeof(vertices)));
+    void *verts = NULL;
+    uint32_t *idx = NULL;
+    QS_CHECK(!qs_asset_read_qsmesh(FUTURE_PATH, &h, &verts, &idx));
+    QS_CHECK(verts == NULL && idx == NULL);
+    remove(FUTURE_PATH);
+
+    /* A v2 header with the v1 size misreads the vertices and runs short */
+    h = make_header(QS_MESH_VERSION, QS_MESH_FLAG_SPLIT_STREAMS);
+    QS_CHECK(write_mesh(SHORT_PATH, &h, offsetof(Qs_MeshFileHeader, flags),
+                        vertices, sizeof(vertices)));
+    QS_CHECK(!qs_asset_read_qsmesh(SHORT_PATH, &h, &verts, &idx));
+    remove(SHORT_PATH);
+}
+
+int main(void)
+{
+    QS_TEST_RUN(test_v1_and_v2_load_alike);
+    QS_TEST_RUN(test_newer_version_rejected);
+    return QS_TEST_RESULT();
+}
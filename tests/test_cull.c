@@ -0,0 +1,160 @@
+/*
+ * test_cull.c — frustum extraction, the SoA bounds store and the
+ * 8-lane frustum kernel against a per-corner reference.
+ */
+
+#include "qs_cull.h"
+#include "qs_test.h"
+
+#include <stdlib.h>
+
+#define CULL_RANDOM_BOXES 1003 /* not a multiple of QS_CULL_LANES */
+#define CULL_PLANE_EPS    1e-4f
+
+static void camera_frustum(Qs_Frustum *out, float view_proj[16])
+{
+    float view[16], proj[16];
+    const float eye[3] = { 0.0f, 2.0f, 10.0f }, target[3] = { 0.0f, 0.0f, 0.0f };
+    const float up[3]  = { 0.0f, 1.0f, 0.0f };
+    qs_m4_look_at(view, eye, target, up);
+    qs_m4_perspective(proj, 1.0f, 1.6f, 0.1f, 100.0f);
+    qs_m4_mul(proj, view, view_proj);
+    qs_frustum_from_matrix(out, view_proj);
+}
+
+static Qs_AABB box_at(float x, float y, float z, float half)
+{
+    return (Qs_AABB){ { x - half, y - half, z - half }, { x + half, y + half, z + half } };
+}
+
+/* Reference: a box is outside when all eight corners are behind one plane. */
+static bool box_visible_reference(const Qs_Frustum *f, const Qs_AABB *b)
+{
+    for (int p = 0; p < 6; p++) {
+        bool any = false;
+        for (int c = 0; c < 8 && !any; c++) {
+            float x = (c & 1) ? b->max[0] : b->min[0];
+            float y = (c & 2) ? b->max[1] : b->min[1];
+            float z = (c & 4) ? b->max[2] : b->min[2];
+            any = f->planes[p][0]*x + f->planes[p][1]*y + f->planes[p][2]*z
+                + f->planes[p][3] >= -CULL_PLANE_EPS;
+        }
+        if (!any) return false;
+    }
+    return true;
+}
+
+static void test_known_boxes(void)
+{
+    Qs_Frustum f;
+    float vp[16];
+    camera_frustum(&f, vp);
+
+    Qs_CullBounds b = { 0 };
+    QS_CHECK(qs_cull_bounds_reserve(&b, 4));
+    Qs_AABB boxes[4] = {
+        box_at(0.0f, 0.0f, 0.0f, 1.0f),    /* in front of the camera */
+        box_at(0.0f, 0.0f, 30.0f, 1.0f),   /* behind it */
+        box_at(0.0f, 0.0f, -200.0f, 1.0f), /* past the far plane */
+        box_at(0.0f, 2.0f, 10.0f, 0.5f),   /* around the eye: straddles near */
+    };
+    for (uint32_t i = 0; i < 4; i++) qs_cull_bounds_set(&b, i, &boxes[i]);
+    QS_CHECK_EQ_U(b.count, 4);
+
+    uint32_t visible[4];
+    uint32_t n = qs_cull_frustum(&f, &b, visible);
+    QS_CHECK_EQ_U(n, 2);
+    QS_CHECK_EQ_U(visible[0], 0);
+    QS_CHECK_EQ_U(visible[1], 3);
+    qs_cull_bounds_free(&b);
+}
+
+static void test_random_boxes_match_reference(void)
+{
+    Qs_Frustum f;
+    float vp[16];
+    camera_frustum(&f, vp);
+
+    qs_test_seed(1);
+    Qs_CullBounds b = { 0 };
+    Qs_AABB *boxes = malloc(CULL_RANDOM_BOXES * sizeof(*boxes));
+    uint32_t *visible = malloc(CULL_RANDOM_BOXES * sizeof(*visible));
+    QS_CHECK(boxes && visible);
+    if (!boxes || !visible) { free(boxes); free(visible); return; }
+
+    /* Grow in two steps to check reserve keeps existing boxes */
+    QS_CHECK(qs_cull_bounds_reserve(&b, 10));
+    for (uint32_t i = 0; i < CULL_RANDOM_BOXES; i++) {
+        if (i == b.capacity) QS_CHECK(qs_cull_bounds_reserve(&b, CULL_RANDOM_BOXES));
+        boxes[i] = box_at(qs_test_randf(-60.0f, 60.0f), qs_test_randf(-60.0f, 60.0f),
+                          qs_test_randf(-120.0f, 20.0f), qs_test_randf(0.1f, 3.0f));
+        qs_cull_bounds_set(&b, i, &boxes[i]);
+    }
+
+    uint32_t n = qs_cull_frustum(&f, &b, visible);
+    uint32_t expected = 0, mismatches = 0;
+    for (uint32_t i = 0; i < CULL_RANDOM_BOXES; i++) {
+        if (!box_visible_reference(&f, &boxes[i])) continue;
+        if (expected >= n || visible[expected] != i) mismatches++;
+        else expected++;
+    }
+    QS_CHECK(n > 0 && n < CULL_RANDOM_BOXES);
+    QS_CHECK_EQ_U(expected, n);
+    QS_CHECK_EQ_U(mismatches, 0);
+
+    free(visible);
+    free(boxes);
+    qs_cull_bounds_free(&b);
+}
+
+static void test_bounds_remove_swaps_last(void)
+{
+    Qs_CullBounds b = { 0 };
+    QS_CHECK(qs_cull_bounds_reserve(&b, 3));
+    for (uint32_t i = 0; i < 3; i++) {
+        Qs_AABB box = box_at((float)i, 0.0f, 0.0f, 0.5f);
+        qs_cull_bounds_set(&b, i, &box);
+    }
+    qs_cull_bounds_remove(&b, 0);
+    QS_CHECK_EQ_U(b.count, 2);
+    QS_CHECK_NEAR(b.center[0][0], 2.0f, 0.0f);
+    QS_CHECK_NEAR(b.center[0][1], 1.0f, 0.0f);
+    QS_CHECK_NEAR(b.extent[1][0], 0.5f, 0.0f);
+    qs_cull_bounds_free(&b);
+    QS_CHECK(b.count == 0 && b.capacity == 0);
+}
+
+/* Arvo's transform must enclose every transformed corner and touch the
+   extremes on each axis. */
+static void test_aabb_transform_is_tight(void)
+{
+    const float pos[3] = { 3.0f, -1.0f, 2.0f };
+    const float quat[4] = { 0.0f, 0.38268343f, 0.0f, 0.92387953f }; /* 45 deg about y */
+    const float scale[3] = { 2.0f, 1.0f, 0.5f };
+    float m[16];
+    qs_m4_from_trs(m, pos, quat, scale);
+
+    Qs_AABB box = { { -1.0f, -2.0f, -3.0f }, { 1.0f, 2.0f, 3.0f } }, out;
+    qs_aabb_transform(&box, m, &out);
+
+    float lo[3] = { INFINITY, INFINITY, INFINITY }, hi[3] = { -INFINITY, -INFINITY, -INFINITY };
+    for (int c = 0; c < 8; c++) {
+        float p[4] = { (c & 1) ? box.max[0] : box.min[0], (c & 2) ? box.max[1] : box.min[1],
+                       (c & 4) ? box.max[2] : box.min[2], 1.0f }, t[4];
+        qs_m4_mul_v4(m, p, t);
+        for (int a = 0; a < 3; a++) { lo[a] = fminf(lo[a], t[a]); hi[a] = fmaxf(hi[a], t[a]); }
+    }
+    for (int a = 0; a < 3; a++) {
+        QS_CHECK_NEAR(out.min[a], lo[a], 1e-4f);
+        QS_CHECK_NEAR(out.max[a], hi[a], 1e-4f);
+    }
+}
+
+int main(void)
+{
+    QS_TEST_RUN(test_known_boxes);
+    QS_TEST_RUN(test_random_boxes_match_reference);
+    QS_TEST_RUN(test_bounds_remove_swaps_last);
+    QS_TEST_RUN(test_aabb_transform_is_tight);
+    return QS_TEST_RESULT();
+}
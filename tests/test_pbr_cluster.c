@@ -0,0 +1,309 @@
+/*
+ * test_pbr_cluster.c — clustered light binning of the PBR backend
+ * (pbr_cluster.c) against known spheres and against a transliteration
+ * of CLUSTER_COMP, including its per-cluster light cap.
+ */
+
+#include "pbr_internal.h"
+#include "qs_test.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RANDOM_LIGHTS   96
+#define CAPPED_LIGHTS   (PBR_CLUSTER_GPU_LIGHTS + 72)
+#define BOUNDARY_EPS    1e-4f
+
+static PbrLightGrid grid;
+static float        proj[16];
+static const float  view[16] = { 1,0,0,0, 0,1,0,0, 0,0,1,0, 0,0,0,1 };
+
+/* 60 degree 16:9 camera at the origin looking down -z; view = world */
+static void setup_grid(void)
+{
+    pbr_light_grid_free(&grid);
+    memset(&grid, 0, sizeof(grid));
+    qs_m4_perspective(proj, 1.0471976f, 16.0f / 9.0f, 0.1f, 100.0f);
+    pbr_light_grid_setup(&grid, proj);
+}
+
+static Qs_LightGPU point_light(float x, float y, float z, float range)
+{
+    Qs_LightGPU l;
+    memset(&l, 0, sizeof(l));
+    l.type        = (uint32_t)QS_LIGHT_POINT;
+    l.position[0] = x;
+    l.position[1] = y;
+    l.position[2] = z;
+    l.range       = range;
+    return l;
+}
+
+static uint32_t cluster_index(uint32_t x, uint32_t y, uint32_t z)
+{
+    return (z * PBR_CLUSTER_Y + y) * PBR_CLUSTER_X + x;
+}
+
+static bool cluster_has(uint32_t c, uint32_t light)
+{
+    const uint32_t *range = grid.header.clusters[c];
+    for (uint32_t k = 0; k < range[1]; k++)
+        if (grid.indices[range[0] + k] == light) return true;
+    return false;
+}
+
+/* ── CLUSTER_COMP, transliterated ──────────────────────────── */
+
+typedef struct RefBox { float lo[3], hi[3]; } RefBox;
+
+static RefBox ref_box(uint32_t c)
+{
+    uint32_t t[3] = { c % 16u, (c / 16u) % 9u, c / 144u };
+    float zn = grid.z_near, zf = grid.z_far, ratio = zf / zn;
+    float d0 = t[2] == 0u ? 0.0f : zn * powf(ratio, (float)t[2] / 24.0f);
+    float d1 = zn * powf(ratio, (float)(t[2] + 1u) / 24.0f);
+    float tile[2] = { 2.0f / 16.0f, 2.0f / 9.0f }, scale[2] = { proj[0], proj[5] };
+    RefBox box;
+    for (int k = 0; k < 2; k++) {
+        float n0 = (float)t[k] * tile[k] - 1.0f, n1 = n0 + tile[k];
+        float a = n0 * d0 / scale[k], b = n1 * d0 / scale[k];
+        float e = n0 * d1 / scale[k], f = n1 * d1 / scale[k];
+        box.lo[k] = fminf(fminf(a, b), fminf(e, f));
+        box.hi[k] = fmaxf(fmaxf(a, b), fmaxf(e, f));
+    }
+    box.lo[2] = -d1;
+    box.hi[2] = -d0;
+    return box;
+}
+
+static bool ref_sphere(const Qs_LightGPU *l, float s[4])
+{
+    if (l->type == 0u || !(l->range > 0.0f)) return false;
+    float c[3] = { l->position[0], l->position[1], l->position[2] }, r = l->range;
+    float len = sqrtf(l->direction[0]*l->direction[0] + l->direction[1]*l->direction[1] +
+                      l->direction[2]*l->direction[2]);
+    float ca = l->outer_cone_cos;
+    if (l->type == 2u && ca > 0.0f && len > 0.0f) {
+        float t;
+        if (ca < 0.70710678f) { t = r * ca; r *= sqrtf(1.0f - ca * ca); }
+        else                  { r /= 2.0f * ca; t = r; }
+        for (int k = 0; k < 3; k++) c[k] += l->direction[k] / len * t;
+    }
+    s[0] = c[0]; s[1] = c[1]; s[2] = c[2]; s[3] = r;   /* view is identity */
+    return true;
+}
+
+/* Distance from the sphere centre to the box, minus the radius */
+static float ref_gap(const RefBox *box, const float s[4])
+{
+    float d2 = 0.0f;
+    for (int k = 0; k < 3; k++) {
+        float q = fminf(fmaxf(s[k], box->lo[k]), box->hi[k]) - s[k];
+        d2 += q * q;
+    }
+    return sqrtf(d2) - s[3];
+}
+
+/* Whether the screen rectangle of the sphere's bounding cube misses
+   cluster c's tile.  CLUSTER_COMP tests the tile's view-space box, which
+   around the screen edges bulges past the tile's frustum; the CPU narrows
+   to the projected tile first, so it may drop lights the shader keeps
+   only when this holds. */
+static bool outside_tile(uint32_t c, const float s[4])
+{
+    uint32_t t[2]    = { c % 16u, (c / 16u) % 9u };
+    float    tile[2] = { 2.0f / 16.0f, 2.0f / 9.0f }, scale[2] = { proj[0], proj[5] };
+    float    w[2]    = { fmaxf(-s[2] - s[3], grid.near_plane), -s[2] + s[3] };
+    for (int k = 0; k < 2; k++) {
+        float lo = INFINITY, hi = -INFINITY;
+        for (int corner = 0; corner < 4; corner++) {
+            float n = scale[k] * (s[k] + (corner & 1 ? s[3] : -s[3])) / w[corner >> 1];
+            lo = fminf(lo, n);
+            hi = fmaxf(hi, n);
+        }
+        float n0 = (float)t[k] * tile[k] - 1.0f;
+        if (hi < n0 || lo > n0 + tile[k]) return true;
+    }
+    return false;
+}
+
+/* Lights the shader lists for cluster c, in order, at most 128 */
+static uint32_t ref_cluster(uint32_t c, const Qs_LightGPU *lights, uint32_t count,
+                            uint32_t *out)
+{
+    RefBox   box = ref_box(c);
+    uint32_t n   = 0;
+    for (uint32_t i = 0; i < count && n < PBR_CLUSTER_GPU_LIGHTS; i++) {
+        float s[4];
+        if (ref_sphere(&lights[i], s) && ref_gap(&box, s) <= 0.0f) out[n++] = i;
+    }
+    return n;
+}
+
+/* ── Tests ──────────────────────────────────────────────────── */
+
+static void test_grid_slicing(void)
+{
+    setup_grid();
+    QS_CHECK_NEAR(grid.z_near, 0.1f, 1e-4f);
+    QS_CHECK_NEAR(grid.z_far, 100.0f, 1e-2f);
+    /* The shader's slice formula lands every slice's mid depth in it */
+    for (uint32_t k = 0; k < PBR_CLUSTER_Z; k++) {
+        float mid = grid.z_near * powf(grid.z_far / grid.z_near, ((float)k + 0.5f) / PBR_CLUSTER_Z);
+        float s   = floorf(logf(mid) * grid.header.z_scale + grid.header.z_bias);
+        QS_CHECK_EQ_U((uint32_t)s, k);
+        RefBox box = ref_box(cluster_index(0, 0, k));
+        QS_CHECK(-box.hi[2] <= mid && mid <= -box.lo[2]);
+    }
+}
+
+static void test_known_spheres(void)
+{
+    setup_grid();
+    Qs_LightGPU lights[6];
+    lights[0] = point_light(0.0f, 0.0f, -10.0f, 0.5f);    /* straddles tiles 7|8, row 4 */
+    lights[1] = point_light(0.0f, 0.0f, 5.0f, 1.0f);      /* behind the camera */
+    lights[2] = point_light(0.0f, 0.0f, -200.0f, 5.0f);   /* past the far plane */
+    lights[3] = point_light(0.0f, 0.0f, -10.0f, 0.0f);    /* no range: global */
+    memset(&lights[4], 0, sizeof(lights[4]));
+    lights[4].type         = (uint32_t)QS_LIGHT_DIRECTIONAL;
+    lights[4].direction[1] = -1.0f;
+    lights[5] = point_light(40.0f, 0.0f, -10.0f, 1.0f);   /* off screen to the right */
+    QS_CHECK(pbr_light_grid_build(&grid, view, lights, 6, true));
+
+    QS_CHECK_EQ_U(grid.header.global_count, 2);
+    QS_CHECK_EQ_U(grid.indices[0], 3);
+    QS_CHECK_EQ_U(grid.indices[1], 4);
+
+    float    s  = floorf(logf(10.0f) * grid.header.z_scale + grid.header.z_bias);
+    uint32_t z  = (uint32_t)s;
+    QS_CHECK(cluster_has(cluster_index(7, 4, z), 0));
+    QS_CHECK(cluster_has(cluster_index(8, 4, z), 0));
+    QS_CHECK(!cluster_has(cluster_index(6, 4, z), 0));
+    QS_CHECK(!cluster_has(cluster_index(7, 4, z + 3), 0));
+    QS_CHECK(!cluster_has(cluster_index(7, 4, z - 3), 0));
+
+    uint32_t listed = 0;
+    for (uint32_t c = 0; c < PBR_CLUSTER_COUNT; c++)
+        for (uint32_t k = 0; k < grid.header.clusters[c][1]; k++) {
+            uint32_t light = grid.indices[grid.header.clusters[c][0] + k];
+            QS_CHECK(light == 0);
+            listed++;
+        }
+    QS_CHECK(listed >= 2);
+    QS_CHECK_EQ_U(grid.index_count, grid.header.global_count + listed);
+}
+
+/* A narrow spot's sphere hugs its cone: clusters beside the apex that
+   a point light of the same range would reach stay empty. */
+static void test_spot_bounds(void)
+{
+    setup_grid();
+    Qs_LightGPU lights[2];
+    lights[0] = point_light(0.0f, 0.0f, -2.0f, 10.0f);
+    lights[0].type           = (uint32_t)QS_LIGHT_SPOT;
+    lights[0].direction[2]   = -1.0f;
+    lights[0].outer_cone_cos = 0.9f;
+    lights[1] = lights[0];
+    lights[1].type = (uint32_t)QS_LIGHT_POINT;
+    QS_CHECK(pbr_light_grid_build(&grid, view, lights, 2, true));
+
+    float    s = floorf(logf(1.0f) * grid.header.z_scale + grid.header.z_bias);
+    uint32_t c = cluster_index(0, 4, (uint32_t)s);  /* left edge, 1 unit deep */
+    QS_CHECK(cluster_has(c, 1));
+    QS_CHECK(!cluster_has(c, 0));
+}
+
+/* Every cluster lists the lights CLUSTER_COMP would, ascending, apart
+   from spheres that touch the box to within float error and spheres the
+   shader's looser box test keeps although they miss the tile. */
+static void test_matches_cluster_shader(void)
+{
+    setup_grid();
+    static Qs_LightGPU lights[RANDOM_LIGHTS];
+    qs_test_seed(43);
+    for (uint32_t i = 0; i < RANDOM_LIGHTS; i++) {
+        float z = qs_test_randf(-60.0f, 2.0f);
+        float half = fabsf(z) * 0.7f + 1.0f;
+        lights[i] = point_light(qs_test_randf(-half * 1.8f, half * 1.8f),
+                                qs_test_randf(-half, half), z, qs_test_randf(0.2f, 6.0f));
+        if (i % 4 == 0) {
+            lights[i].type           = (uint32_t)QS_LIGHT_SPOT;
+            lights[i].direction[0]   = qs_test_randf(-1.0f, 1.0f);
+            lights[i].direction[2]   = -1.0f;
+            lights[i].outer_cone_cos = qs_test_randf(0.3f, 0.95f);
+        }
+    }
+    QS_CHECK(pbr_light_grid_build(&grid, view, lights, RANDOM_LIGHTS, true));
+
+    uint32_t ref[PBR_CLUSTER_GPU_LIGHTS];
+    uint32_t mismatches = 0, looser = 0, listed = 0;
+    for (uint32_t c = 0; c < PBR_CLUSTER_COUNT; c++) {
+        const uint32_t *range = grid.header.clusters[c];
+        const uint32_t *cpu   = grid.indices + range[0];
+        for (uint32_t k = 1; k < range[1]; k++) QS_CHECK(cpu[k - 1] < cpu[k]);
+        QS_CHECK_EQ_U(range[0], grid.header.global_count + listed);
+        listed += range[1];
+
+        uint32_t n = ref_cluster(c, lights, RANDOM_LIGHTS, ref);
+        RefBox box = ref_box(c);
+        uint32_t a = 0, b = 0;
+        while (a < range[1] || b < n) {
+            uint32_t light;
+            bool     shader_only = false;
+            if (b == n || (a < range[1] && cpu[a] < ref[b])) light = cpu[a++];
+            else if (a == range[1] || ref[b] < cpu[a])        light = ref[b++], shader_only = true;
+            else { a++; b++; continue; }
+            float s[4];
+            ref_sphere(&lights[light], s);
+            if (shader_only && outside_tile(c, s)) {
+                looser++;
+                continue;
+            }
+            if (fabsf(ref_gap(&box, s)) > BOUNDARY_EPS * fmaxf(1.0f, fabsf(s[2]))) {
+                fprintf(stderr, "cluster %u light %u: CPU and shader disagree\n", c, light);
+                mismatches++;
+            }
+        }
+    }
+    QS_CHECK_EQ_U(mismatches, 0);
+    QS_CHECK(listed > 0);
+    QS_CHECK(looser < listed / 4);
+}
+
+/* CLUSTER_COMP keeps PBR_CLUSTER_GPU_LIGHTS index slots per cluster and
+   drops the lights past them; the CPU path lists them all. */
+static void test_gpu_light_cap(void)
+{
+    setup_grid();
+    static Qs_LightGPU lights[CAPPED_LIGHTS];
+    for (uint32_t i = 0; i < CAPPED_LIGHTS; i++)
+        lights[i] = point_light(0.01f * (float)(i % 7), 0.0f, -10.0f, 1.0f);
+    QS_CHECK(pbr_light_grid_build(&grid, view, lights, CAPPED_LIGHTS, true));
+
+    float    s = floorf(logf(10.0f) * grid.header.z_scale + grid.header.z_bias);
+    uint32_t c = cluster_index(8, 4, (uint32_t)s);
+    const uint32_t *range = grid.header.clusters[c];
+    QS_CHECK_EQ_U(range[1], CAPPED_LIGHTS);
+
+    uint32_t ref[PBR_CLUSTER_GPU_LIGHTS];
+    uint32_t n = ref_cluster(c, lights, CAPPED_LIGHTS, ref);
+    QS_CHECK_EQ_U(n, PBR_CLUSTER_GPU_LIGHTS);
+    /* The shader keeps the lowest light indices, in order */
+    for (uint32_t k = 0; k < n; k++) {
+        QS_CHECK_EQ_U(ref[k], k);
+        QS_CHECK_EQ_U(grid.indices[range[0] + k], ref[k]);
+    }
+}
+
+int main(void)
+{
+    QS_TEST_RUN(test_grid_slicing);
+    QS_TEST_RUN(test_known_spheres);
+    QS_TEST_RUN(test_spot_bounds);
+    QS_TEST_RUN(test_matches_cluster_shader);
+    QS_TEST_RUN(test_gpu_light_cap);
+    pbr_light_grid_free(&grid);
+    return QS_TEST_RESULT();
+}
@@ -0,0 +1,226 @@
+/*
+ * test_pbr_fxaa.c — the FXAA composite variant of the PBR backend on the
+ * CPU: the shader's edge search (pbr_fxaa.h, the same source
+ * COMPOSITE_FRAG stringizes) behind a CPU transliteration of its texture
+ * sampling, against reference images of a synthetic scene rendered on
+ * the CPU: aliased, MSAA-resolved and 256-sample supersampled.
+ */
+
+#include "pbr_internal.h"
+#include "pbr_fxaa.h"
+#include "qs_test.h"
+
+#include <math.h>
+
+#define IMG_W     96
+#define IMG_H     64
+#define SS_GRID   16   /* ground truth: SS_GRID x SS_GRID samples per pixel */
+
+typedef struct { float r, g, b; } Rgb;
+
+static Rgb aliased[IMG_W * IMG_H];
+static Rgb filtered[IMG_W * IMG_H];
+static Rgb reference[IMG_W * IMG_H];
+static Rgb resolved[IMG_W * IMG_H];
+
+/* ── The shader's edge search, compiled as C ──────────────── */
+
+static const Rgb *g_src;
+
+static Rgb texel(const Rgb *img, int x, int y)
+{
+    x = x < 0 ? 0 : x >= IMG_W ? IMG_W - 1 : x;
+    y = y < 0 ? 0 : y >= IMG_H ? IMG_H - 1 : y;
+    return img[y * IMG_W + x];
+}
+
+/* textureLod through the composite's linear clamp-to-edge sampler */
+static Rgb sample(const Rgb *img, float u, float v)
+{
+    float fx = u * IMG_W - 0.5f, fy = v * IMG_H - 0.5f;
+    int   x0 = (int)floorf(fx), y0 = (int)floorf(fy);
+    float ax = fx - (float)x0, ay = fy - (float)y0;
+    Rgb a = texel(img, x0, y0),     b = texel(img, x0 + 1, y0);
+    Rgb c = texel(img, x0, y0 + 1), d = texel(img, x0 + 1, y0 + 1);
+    float wa = (1 - ax) * (1 - ay), wb = ax * (1 - ay), wc = (1 - ax) * ay, wd = ax * ay;
+    return (Rgb){ a.r * wa + b.r * wb + c.r * wc + d.r * wd,
+                  a.g * wa + b.g * wb + c.g * wc + d.g * wd,
+                  a.b * wa + b.b * wb + c.b * wc + d.b * wd };
+}
+
+static float luma_at(float u, float v);
+
+#define FXAA_LUMA(u, v) luma_at(u, v)
+PBR_FXAA_C
+
+static float luma_at(float u, float v)
+{
+    Rgb c = sample(g_src, u, v);
+    return fxaa_luma(c.r, c.g, c.b);
+}
+
+/* fxaa() of COMPOSITE_FRAG over the whole image */
+static void ref_fxaa_image(const Rgb *src, Rgb *dst)
+{
+    const float px = 1.0f / IMG_W, py = 1.0f / IMG_H;
+    g_src = src;
+    for (int y = 0; y < IMG_H; y++)
+        for (int x = 0; x < IMG_W; x++) {
+            float u = ((float)x + 0.5f) * px, v = ((float)y + 0.5f) * py;
+            PbrFxaaOffset o = fxaa_offset(u, v, px, py);
+            dst[y * IMG_W + x] = sample(src, u + o.x, v + o.y);
+        }
+}
+
+/* aces() and the gamma of the composite: what reaches the swapchain */
+static float display(float x)
+{
+    float c = (x * (2.51f * x + 0.03f)) / (x * (2.43f * x + 0.59f) + 0.14f);
+    return powf(fminf(fmaxf(c, 0.0f), 1.0f), 1.0f / 2.2f);
+}
+
+/* ── Scene ─────────────────────────────────────────────────── */
+
+/* A bright HDR wedge with edges at several slopes, a green disc and a
+   thin sliver, on a dim background */
+static Rgb shade(float x, float y)
+{
+    if (x - 1.9f * y > -40.0f && x + 0.35f * y < 70.0f && y - 0.08f * x > 6.0f)
+        return (Rgb){ 4.0f, 3.0f, 2.0f };
+    float dx = x - 74.0f, dy = y - 44.0f;
+    if (dx * dx + dy * dy < 13.0f * 13.0f) return (Rgb){ 0.2f, 0.8f, 0.3f };
+    if (fabsf(y - 0.6f * x - 2.0f) < 0.6f) return (Rgb){ 1.0f, 1.0f, 1.0f };
+    return (Rgb){ 0.05f, 0.05f, 0.08f };
+}
+
+/* Standard Vulkan sample positions, in pixel units */
+static const float k_pos1[] = { 0.5f, 0.5f };
+static const float k_pos2[] = { 0.75f, 0.75f, 0.25f, 0.25f };
+static const float k_pos4[] = { 0.375f, 0.125f, 0.875f, 0.375f, 0.125f, 0.625f, 0.625f, 0.875f };
+static const float k_pos8[] = { 0.5625f, 0.3125f, 0.4375f, 0.6875f, 0.8125f, 0.5625f,
+                                0.3125f, 0.1875f, 0.1875f, 0.8125f, 0.0625f, 0.4375f,
+                                0.6875f, 0.9375f, 0.9375f, 0.0625f };
+
+/* Renders the scene with count samples at pos per pixel and resolves
+   them by averaging, as the forward pass's MSAA resolve does */
+static void render(Rgb *dst, const float *pos, uint32_t count)
+{
+    for (int y = 0; y < IMG_H; y++)
+        for (int x = 0; x < IMG_W; x++) {
+            Rgb sum = { 0, 0, 0 };
+            for (uint32_t s = 0; s < count; s++) {
+                Rgb c = shade((float)x + pos[2 * s], (float)y + pos[2 * s + 1]);
+                sum.r += c.r; sum.g += c.g; sum.b += c.b;
+            }
+            dst[y * IMG_W + x] = (Rgb){ sum.r / (float)count, sum.g / (float)count,
+                                        sum.b / (float)count };
+        }
+}
+
+static void render_reference(void)
+{
+    static float grid[2 * SS_GRID * SS_GRID];
+    for (int j = 0; j < SS_GRID; j++)
+        for (int i = 0; i < SS_GRID; i++) {
+            grid[2 * (j * SS_GRID + i)]     = ((float)i + 0.5f) / SS_GRID;
+            grid[2 * (j * SS_GRID + i) + 1] = ((float)j + 0.5f) / SS_GRID;
+        }
+    render(reference, grid, SS_GRID * SS_GRID);
+}
+
+/* Mean absolute display-space error against the reference */
+static double image_error(const Rgb *img)
+{
+    double sum = 0.0;
+    for (uint32_t i = 0; i < IMG_W * IMG_H; i++)
+        sum += fabs(display(img[i].r) - display(reference[i].r)) +
+               fabs(display(img[i].g) - display(reference[i].g)) +
+               fabs(display(img[i].b) - display(reference[i].b));
+    return sum / (3.0 * IMG_W * IMG_H);
+}
+
+/* ── Tests ─────────────────────────────────────────────────── */
+
+/* Flat regions and gradients below the edge threshold pass through */
+static void test_flat_unchanged(void)
+{
+    for (int y = 0; y < IMG_H; y++)
+        for (int x = 0; x < IMG_W; x++)
+            aliased[y * IMG_W + x] = (Rgb){ 0.3f + 0.001f * (float)x, 0.3f, 0.2f };
+    ref_fxaa_image(aliased, filtered);
+    for (uint32_t i = 0; i < IMG_W * IMG_H; i++) {
+        QS_CHECK_NEAR(filtered[i].r, aliased[i].r, 1e-5);
+        QS_CHECK_NEAR(filtered[i].g, aliased[i].g, 1e-5);
+    }
+}
+
+/* FXAA only re-samples between neighbours: every output lies within
+   the 3x3 neighbourhood's range, and only pixels on edges change */
+static void test_stays_in_neighbourhood(void)
+{
+    render(aliased, k_pos1, 1);
+    ref_fxaa_image(aliased, filtered);
+    uint32_t changed = 0, edge = 0;
+    for (int y = 0; y < IMG_H; y++)
+        for (int x = 0; x < IMG_W; x++) {
+            Rgb lo = texel(aliased, x, y), hi = lo;
+            for (int dy = -1; dy <= 1; dy++)
+                for (int dx = -1; dx <= 1; dx++) {
+                    Rgb c = texel(aliased, x + dx, y + dy);
+                    lo.r = fminf(lo.r, c.r); hi.r = fmaxf(hi.r, c.r);
+                    lo.g = fminf(lo.g, c.g); hi.g = fmaxf(hi.g, c.g);
+                    lo.b = fminf(lo.b, c.b); hi.b = fmaxf(hi.b, c.b);
+                }
+            Rgb f = filtered[y * IMG_W + x];
+            QS_CHECK(f.r >= lo.r - 1e-5f && f.r <= hi.r + 1e-5f);
+            QS_CHECK(f.g >= lo.g - 1e-5f && f.g <= hi.g + 1e-5f);
+            QS_CHECK(f.b >= lo.b - 1e-5f && f.b <= hi.b + 1e-5f);
+            Rgb  a = aliased[y * IMG_W + x];
+            bool differs = fabsf(f.r - a.r) + fabsf(f.g - a.g) + fabsf(f.b - a.b) > 1e-4f;
+            changed += differs;
+            edge    += lo.r != hi.r || lo.g != hi.g || lo.b != hi.b;
+            if (differs) QS_CHECK(lo.r != hi.r || lo.g != hi.g || lo.b != hi.b);
+        }
+    QS_CHECK(changed > edge / 2);
+}
+
+/* Against the supersampled reference FXAA must close most of the gap
+   between the aliased image and 2x MSAA; prints where it lands among the
+   MSAA tiers alongside each mode's extra target memory at 1080p. */
+static void test_reference_images(void)
+{
+    render_reference();
+    render(aliased, k_pos1, 1);
+    ref_fxaa_image(aliased, filtered);
+    double err_none = image_error(aliased);
+    double err_fxaa = image_error(filtered);
+
+    static const float *const positions[PBR_MSAA_TIER_COUNT] = { k_pos1, k_pos2, k_pos4, k_pos8 };
+    double err_msaa[PBR_MSAA_TIER_COUNT];
+    for (uint32_t tier = 0; tier < PBR_MSAA_TIER_COUNT; tier++) {
+        render(resolved, positions[tier], 1u << tier);
+        err_msaa[tier] = image_error(resolved);
+    }
+    QS_CHECK_NEAR(err_msaa[0], err_none, 1e-9);
+    QS_CHECK(err_msaa[3] < err_msaa[2] && err_msaa[2] < err_msaa[1] && err_msaa[1] < err_none);
+    QS_CHECK(err_fxaa < 0.5 * (err_none + err_msaa[1]));
+    QS_CHECK(err_fxaa < err_none * 0.75);
+
+    /* Multisampled RGBA16F color and 32-bit depth per sample, on top of
+       the single-sample HDR and depth targets every mode keeps */
+    const double pixels = 1920.0 * 1080.0;
+    printf("  mode   error    extra targets at 1080p\n");
+    printf("  none   %.4f   %6.1f MiB\n", err_none, 0.0);
+    printf("  FXAA   %.4f   %6.1f MiB\n", err_fxaa, 0.0);
+    for (uint32_t tier = 1; tier < PBR_MSAA_TIER_COUNT; tier++)
+        printf("  MSAA%u  %.4f   %6.1f MiB\n", 1u << tier, err_msaa[tier],
+               pixels * (double)(1u << tier) * (8.0 + 4.0) / (1024.0 * 1024.0));
+}
+
+int main(void)
+{
+    QS_TEST_RUN(test_flat_unchanged);
+    QS_TEST_RUN(test_stays_in_neighbourhood);
+    QS_TEST_RUN(test_reference_images);
+    return QS_TEST_RESULT();
+}
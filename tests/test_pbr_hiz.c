@@ -0,0 +1,333 @@
+/*
+ * test_pbr_hiz.c — Hi-Z occlusion of the PBR backend (pbr_hiz.c): the
+ * pyramid build and the box test against each other on synthetic depth
+ * buffers, and against transliterations of HIZ_SEED_COMP,
+ * HIZ_SEED_MS_COMP, HIZ_REDUCE_COMP and OCCLUSION_COMP.
+ */
+
+#include "pbr_internal.h"
+#include "qs_test.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEPTH_W       37
+#define DEPTH_H       23
+#define MS_SAMPLES    4
+#define RANDOM_BOXES  4000
+
+static PbrHiZLayout layout;
+static float        depth[DEPTH_W * DEPTH_H];
+static float        texels[DEPTH_W * DEPTH_H];   /* pyramid is at most 1/3 of it */
+static float        view_proj[16];
+
+/* 60 degree camera at the origin looking down -z, matching the depth
+   buffer's aspect */
+static void setup_camera(void)
+{
+    qs_m4_perspective(view_proj, 1.0471976f, (float)DEPTH_W / (float)DEPTH_H, 0.1f, 100.0f);
+}
+
+/* Depth buffer value of a surface d units in front of the camera */
+static float ndc_depth(float d)
+{
+    return (view_proj[10] * -d + view_proj[14]) / d;
+}
+
+static void fill_random(uint32_t seed)
+{
+    qs_test_seed(seed);
+    for (uint32_t i = 0; i < DEPTH_W * DEPTH_H; i++)
+        depth[i] = ndc_depth(qs_test_randf(1.0f, 60.0f));
+}
+
+/* ── The shaders, transliterated ───────────────────────────── */
+
+typedef float (*SrcDepthFn)(const void *src, uint32_t src_w, int x, int y);
+
+/* HIZ_COMP_MAIN for one dispatch of dst_w x dst_h invocations */
+static void ref_dispatch(SrcDepthFn src_depth, const void *src, uint32_t src_w,
+                         uint32_t src_h, float *dst, uint32_t dst_w, uint32_t dst_h)
+{
+    for (uint32_t ty = 0; ty < dst_h; ty++)
+        for (uint32_t tx = 0; tx < dst_w; tx++) {
+            int px = (int)(tx * 2u), py = (int)(ty * 2u);
+            int qx = px + 1 < (int)src_w - 1 ? px + 1 : (int)src_w - 1;
+            int qy = py + 1 < (int)src_h - 1 ? py + 1 : (int)src_h - 1;
+            dst[ty * dst_w + tx] =
+                fmaxf(fmaxf(src_depth(src, src_w, px, py), src_depth(src, src_w, qx, py)),
+                      fmaxf(src_depth(src, src_w, px, qy), src_depth(src, src_w, qx, qy)));
+        }
+}
+
+/* HIZ_SEED_COMP and HIZ_REDUCE_COMP: texelFetch / the level below */
+static float seed_depth(const void *src, uint32_t src_w, int x, int y)
+{
+    return ((const float *)src)[(uint32_t)y * src_w + (uint32_t)x];
+}
+
+/* HIZ_SEED_MS_COMP: the farthest sample of the pixel */
+static float seed_ms_depth(const void *src, uint32_t src_w, int x, int y)
+{
+    const float *samples = (const float *)src + ((uint32_t)y * src_w + (uint32_t)x) * MS_SAMPLES;
+    float d = 0.0f;
+    for (int s = 0; s < MS_SAMPLES; s++) d = fmaxf(d, samples[s]);
+    return d;
+}
+
+/* The seed dispatch, then one reduce per further level */
+static void ref_pyramid(SrcDepthFn seed, const void *src, float *out)
+{
+    uint32_t w = (DEPTH_W + 1u) / 2u, h = (DEPTH_H + 1u) / 2u, offset = 0;
+    ref_dispatch(seed, src, DEPTH_W, DEPTH_H, out, w, h);
+    while (w > 1u || h > 1u) {
+        uint32_t nw = (w + 1u) / 2u, nh = (h + 1u) / 2u;
+        ref_dispatch(seed_depth, out + offset, w, h, out + offset + w * h, nw, nh);
+        offset += w * h;
+        w = nw;
+        h = nh;
+    }
+}
+
+/* OCCLUSION_COMP's hiz_test */
+static PbrHiZResult ref_hiz_test(const float *hiz, const float c[3], const float e[3])
+{
+    const float *m = view_proj;
+    float lo[3] = { 1e30f, 1e30f, 1e30f }, hi[2] = { -1e30f, -1e30f };
+    for (int k = 0; k < 8; k++) {
+        float p[3] = { c[0] + ((k & 1) ? e[0] : -e[0]), c[1] + ((k & 2) ? e[1] : -e[1]),
+                       c[2] + ((k & 4) ? e[2] : -e[2]) };
+        float clip[4];
+        for (int a = 0; a < 4; a++)
+            clip[a] = m[a]*p[0] + m[a + 4]*p[1] + m[a + 8]*p[2] + m[a + 12];
+        if (clip[3] <= 0.0f) return PBR_HIZ_VISIBLE;
+        for (int a = 0; a < 3; a++) lo[a] = fminf(lo[a], clip[a] / clip[3]);
+        for (int a = 0; a < 2; a++) hi[a] = fmaxf(hi[a], clip[a] / clip[3]);
+    }
+    if (hi[0] < -1.0f || hi[1] < -1.0f || lo[0] > 1.0f || lo[1] > 1.0f || lo[2] > 1.0f)
+        return PBR_HIZ_OUTSIDE;
+    float size[2] = { (float)DEPTH_W, (float)DEPTH_H }, p0[2], p1[2];
+    for (int a = 0; a < 2; a++) {
+        p0[a] = (fmaxf(lo[a], -1.0f) * 0.5f + 0.5f) * size[a];
+        p1[a] = (fminf(hi[a],  1.0f) * 0.5f + 0.5f) * size[a];
+    }
+    float    span  = fmaxf(p1[0] - p0[0], p1[1] - p0[1]) * 0.5f;
+    uint32_t level = span > 1.0f ? (uint32_t)ceilf(log2f(span)) : 0u;
+    if (level > layout.levels - 1u) level = layout.levels - 1u;
+    uint32_t dim[2] = { (DEPTH_W + 1u) / 2u, (DEPTH_H + 1u) / 2u }, offset = 0;
+    for (uint32_t l = 0; l < level; l++) {
+        offset += dim[0] * dim[1];
+        dim[0] = (dim[0] + 1u) / 2u;
+        dim[1] = (dim[1] + 1u) / 2u;
+    }
+    float    scale = 1.0f / (float)(2u << level);
+    uint32_t t0[2], t1[2];
+    for (int a = 0; a < 2; a++) {
+        t1[a] = (uint32_t)(p1[a] * scale);
+        if (t1[a] > dim[a] - 1u) t1[a] = dim[a] - 1u;
+        t0[a] = (uint32_t)(p0[a] * scale);
+        if (t0[a] > t1[a]) t0[a] = t1[a];
+    }
+    float farthest = 0.0f;
+    for (uint32_t y = t0[1]; y <= t1[1]; y++)
+        for (uint32_t x = t0[0]; x <= t1[0]; x++)
+            farthest = fmaxf(farthest, hiz[offset + y * dim[0] + x]);
+    return lo[2] <= farthest ? PBR_HIZ_VISIBLE : PBR_HIZ_OCCLUDED;
+}
+
+/* ── Helpers ────────────────────────────────────────────────── */
+
+static void random_box(float c[3], float e[3])
+{
+    c[2] = qs_test_randf(-70.0f, 3.0f);
+    float half = fabsf(c[2]) * 0.8f + 1.0f;
+    c[0] = qs_test_randf(-half, half);
+    c[1] = qs_test_randf(-half, half);
+    for (int a = 0; a < 3; a++) e[a] = qs_test_randf(0.05f, 4.0f);
+}
+
+/* Nearest depth and pixel rectangle of a box wholly in front of the
+   camera, by brute force over its corners */
+static bool box_footprint(const float c[3], const float e[3], float *nearest,
+                          uint32_t *x0, uint32_t *y0, uint32_t *x1, uint32_t *y1)
+{
+    float lo[3] = { INFINITY, INFINITY, INFINITY }, hi[2] = { -INFINITY, -INFINITY };
+    for (int k = 0; k < 8; k++) {
+        float p[3] = { c[0] + ((k & 1) ? e[0] : -e[0]), c[1] + ((k & 2) ? e[1] : -e[1]),
+                       c[2] + ((k & 4) ? e[2] : -e[2]) };
+        if (p[2] >= -0.1f) return false;
+        float w = -p[2];
+        float n[3] = { view_proj[0] * p[0] / w, view_proj[5] * p[1] / w, ndc_depth(w) };
+        for (int a = 0; a < 3; a++) lo[a] = fminf(lo[a], n[a]);
+        for (int a = 0; a < 2; a++) hi[a] = fmaxf(hi[a], n[a]);
+    }
+    if (hi[0] < -1.0f || hi[1] < -1.0f || lo[0] > 1.0f || lo[1] > 1.0f) return false;
+    *nearest = lo[2];
+    *x0 = (uint32_t)((fmaxf(lo[0], -1.0f) * 0.5f + 0.5f) * (float)DEPTH_W);
+    *x1 = (uint32_t)((fminf(hi[0],  1.0f) * 0.5f + 0.5f) * (float)DEPTH_W);
+    *y0 = (uint32_t)((fmaxf(lo[1], -1.0f) * 0.5f + 0.5f) * (float)DEPTH_H);
+    *y1 = (uint32_t)((fminf(hi[1],  1.0f) * 0.5f + 0.5f) * (float)DEPTH_H);
+    if (*x1 > DEPTH_W - 1) *x1 = DEPTH_W - 1;
+    if (*y1 > DEPTH_H - 1) *y1 = DEPTH_H - 1;
+    return true;
+}
+
+/* ── Tests ──────────────────────────────────────────────────── */
+
+static void test_layout(void)
+{
+    pbr_hiz_layout(&layout, DEPTH_W, DEPTH_H);
+    const uint32_t w[] = { 19, 10, 5, 3, 2, 1 }, h[] = { 12, 6, 3, 2, 1, 1 };
+    QS_CHECK_EQ_U(layout.levels, 6);
+    uint32_t offset = 0;
+    for (uint32_t l = 0; l < layout.levels && l < 6; l++) {
+        QS_CHECK_EQ_U(layout.width[l], w[l]);
+        QS_CHECK_EQ_U(layout.height[l], h[l]);
+        QS_CHECK_EQ_U(layout.offset[l], offset);
+        offset += w[l] * h[l];
+    }
+    QS_CHECK_EQ_U(layout.texel_count, offset);
+    QS_CHECK(layout.texel_count <= DEPTH_W * DEPTH_H);
+
+    PbrHiZLayout one;
+    pbr_hiz_layout(&one, 1, 1);
+    QS_CHECK_EQ_U(one.levels, 1);
+    QS_CHECK_EQ_U(one.texel_count, 1);
+}
+
+/* Every texel holds the farthest depth of the pixels under it, odd edges
+   included */
+static void test_build_farthest_of_block(void)
+{
+    setup_camera();
+    pbr_hiz_layout(&layout, DEPTH_W, DEPTH_H);
+    fill_random(45);
+    pbr_hiz_build(&layout, depth, texels);
+    for (uint32_t l = 0; l < layout.levels; l++) {
+        uint32_t block = 2u << l;
+        for (uint32_t y = 0; y < layout.height[l]; y++)
+            for (uint32_t x = 0; x < layout.width[l]; x++) {
+                float farthest = 0.0f;
+                for (uint32_t py = y * block; py < (y + 1) * block && py < DEPTH_H; py++)
+                    for (uint32_t px = x * block; px < (x + 1) * block && px < DEPTH_W; px++)
+                        farthest = fmaxf(farthest, depth[py * DEPTH_W + px]);
+                QS_CHECK(texels[layout.offset[l] + y * layout.width[l] + x] == farthest);
+            }
+    }
+}
+
+static void test_build_matches_shaders(void)
+{
+    setup_camera();
+    pbr_hiz_layout(&layout, DEPTH_W, DEPTH_H);
+    fill_random(46);
+    static float ref[DEPTH_W * DEPTH_H];
+    pbr_hiz_build(&layout, depth, texels);
+    ref_pyramid(seed_depth, depth, ref);
+    QS_CHECK(memcmp(texels, ref, layout.texel_count * sizeof(float)) == 0);
+
+    /* A multisampled depth buffer seeds with each pixel's farthest sample */
+    static float samples[DEPTH_W * DEPTH_H * MS_SAMPLES];
+    for (uint32_t i = 0; i < DEPTH_W * DEPTH_H * MS_SAMPLES; i++)
+        samples[i] = ndc_depth(qs_test_randf(1.0f, 60.0f));
+    for (uint32_t i = 0; i < DEPTH_W * DEPTH_H; i++)
+        depth[i] = seed_ms_depth(samples, DEPTH_W, (int)(i % DEPTH_W), (int)(i / DEPTH_W));
+    pbr_hiz_build(&layout, depth, texels);
+    ref_pyramid(seed_ms_depth, samples, ref);
+    QS_CHECK(memcmp(texels, ref, layout.texel_count * sizeof(float)) == 0);
+}
+
+/* A wall across the screen hides what is behind it and nothing else */
+static void test_wall(void)
+{
+    setup_camera();
+    pbr_hiz_layout(&layout, DEPTH_W, DEPTH_H);
+    for (uint32_t i = 0; i < DEPTH_W * DEPTH_H; i++) depth[i] = ndc_depth(10.0f);
+    pbr_hiz_build(&layout, depth, texels);
+
+    const float small[3] = { 0.5f, 0.5f, 0.5f };
+    QS_CHECK_EQ_U(pbr_hiz_test(&layout, texels, view_proj, (float[3]){ 0, 0, -20 }, small),
+                  PBR_HIZ_OCCLUDED);
+    QS_CHECK_EQ_U(pbr_hiz_test(&layout, texels, view_proj, (float[3]){ 3, -2, -40 },
+                               (float[3]){ 8, 8, 8 }), PBR_HIZ_OCCLUDED);
+    QS_CHECK_EQ_U(pbr_hiz_test(&layout, texels, view_proj, (float[3]){ 0, 0, -5 }, small),
+                  PBR_HIZ_VISIBLE);
+    /* Straddling the wall */
+    QS_CHECK_EQ_U(pbr_hiz_test(&layout, texels, view_proj, (float[3]){ 0, 0, -10 }, small),
+                  PBR_HIZ_VISIBLE);
+    /* Reaching behind the eye plane */
+    QS_CHECK_EQ_U(pbr_hiz_test(&layout, texels, view_proj, (float[3]){ 0, 0, -20 },
+                               (float[3]){ 1, 1, 21 }), PBR_HIZ_VISIBLE);
+    /* Beside the screen and past the far plane */
+    QS_CHECK_EQ_U(pbr_hiz_test(&layout, texels, view_proj, (float[3]){ 60, 0, -20 }, small),
+                  PBR_HIZ_OUTSIDE);
+    QS_CHECK_EQ_U(pbr_hiz_test(&layout, texels, view_proj, (float[3]){ 0, 0, -150 }, small),
+                  PBR_HIZ_OUTSIDE);
+}
+
+/* A hole in the wall lets a box behind it through */
+static void test_hole(void)
+{
+    setup_camera();
+    pbr_hiz_layout(&layout, DEPTH_W, DEPTH_H);
+    for (uint32_t y = 0; y < DEPTH_H; y++)
+        for (uint32_t x = 0; x < DEPTH_W; x++) {
+            bool hole = x >= 16 && x <= 20 && y >= 9 && y <= 13;
+            depth[y * DEPTH_W + x] = ndc_depth(hole ? 90.0f : 10.0f);
+        }
+    pbr_hiz_build(&layout, depth, texels);
+    const float small[3] = { 0.2f, 0.2f, 0.2f };
+    QS_CHECK_EQ_U(pbr_hiz_test(&layout, texels, view_proj, (float[3]){ 0, 0, -30 }, small),
+                  PBR_HIZ_VISIBLE);
+    QS_CHECK_EQ_U(pbr_hiz_test(&layout, texels, view_proj, (float[3]){ 20, 0, -30 }, small),
+                  PBR_HIZ_OCCLUDED);
+}
+
+/* An occluded box is behind every pixel under it, and the CPU and the
+   shader classify every box alike */
+static void test_random_boxes(void)
+{
+    setup_camera();
+    pbr_hiz_layout(&layout, DEPTH_W, DEPTH_H);
+    fill_random(47);
+    /* Coarse blocks of near and far depths so both results occur */
+    for (uint32_t y = 0; y < DEPTH_H; y++)
+        for (uint32_t x = 0; x < DEPTH_W; x++)
+            if ((x / 8 + y / 8) % 2 == 0) depth[y * DEPTH_W + x] = ndc_depth(8.0f);
+    pbr_hiz_build(&layout, depth, texels);
+
+    uint32_t seen[3] = { 0, 0, 0 }, differ = 0, wrong = 0;
+    qs_test_seed(48);
+    for (uint32_t i = 0; i < RANDOM_BOXES; i++) {
+        float c[3], e[3];
+        random_box(c, e);
+        PbrHiZResult r = pbr_hiz_test(&layout, texels, view_proj, c, e);
+        seen[r]++;
+        if (ref_hiz_test(texels, c, e) != r) differ++;
+
+        float    nearest;
+        uint32_t x0, y0, x1, y1;
+        if (r != PBR_HIZ_OCCLUDED || !box_footprint(c, e, &nearest, &x0, &y0, &x1, &y1))
+            continue;
+        for (uint32_t y = y0; y <= y1; y++)
+            for (uint32_t x = x0; x <= x1; x++)
+                if (depth[y * DEPTH_W + x] >= nearest) wrong++;
+    }
+    QS_CHECK_EQ_U(differ, 0);
+    QS_CHECK_EQ_U(wrong, 0);
+    QS_CHECK(seen[PBR_HIZ_OUTSIDE] > 0);
+    QS_CHECK(seen[PBR_HIZ_OCCLUDED] > 0);
+    QS_CHECK(seen[PBR_HIZ_VISIBLE] > 0);
+}
+
+int main(void)
+{
+    QS_TEST_RUN(test_layout);
+    QS_TEST_RUN(test_build_farthest_of_block);
+    QS_TEST_RUN(test_build_matches_shaders);
+    QS_TEST_RUN(test_wall);
+    QS_TEST_RUN(test_hole);
+    QS_TEST_RUN(test_random_boxes);
+    return QS_TEST_RESULT();
+}
@@ -0,0 +1,354 @@
+/*
+ * test_pbr_instances.c — draw batching, GPU scene records, indirect
+ * command generation and the CPU cull reference of the PBR backend
+ * (pbr_instances.c).
+ */
+
+#include "pbr_internal.h"
+#include "qs_test.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define INSTANCE_DRAWS  5
+#define CULL_OBJECTS    257
+#define CULL_MESHES     6
+#define COMMAND_WORDS   (sizeof(PbrDrawCommand) / sizeof(uint32_t))
+
+/* Lists renderables 0..count-1 in the queue, in index order. */
+static void queue_in_order(PbrDrawQueue *q, uint32_t count)
+{
+    QS_CHECK(pbr_draw_queue_reserve(q, count));
+    q->list.count = 0;
+    for (uint32_t i = 0; i < count; i++) qs_draw_list_push(&q->list, i, i);
+}
+
+static Qs_Renderable draw_of(uint32_t mesh, uint32_t material, Qs_AlphaMode alpha)
+{
+    Qs_Renderable r;
+    memset(&r, 0, sizeof(r));
+    r.mesh_id     = mesh;
+    r.material_id = material;
+    r.alpha_mode  = alpha;
+    r.material_params.alpha_mode = alpha;
+    r.index_count = 36;
+    for (int k = 0; k < 4; k++) r.tint[k] = 1.0f;
+    return r;
+}
+
+static void check_batches(const PbrDrawQueue *q, const uint32_t *expected_counts,
+                          uint32_t expected_batches)
+{
+    QS_CHECK_EQ_U(q->batch_count, expected_batches);
+    uint32_t first = 0;
+    for (uint32_t b = 0; b < q->batch_count && b < expected_batches; b++) {
+        QS_CHECK_EQ_U(q->batches[b].first, first);
+        QS_CHECK_EQ_U(q->batches[b].count, expected_counts[b]);
+        first += expected_counts[b];
+    }
+}
+
+static void test_batch_by_mesh_material_and_features(void)
+{
+    Qs_Renderable r[INSTANCE_DRAWS] = {
+        draw_of(5, 1, QS_ALPHA_MODE_OPAQUE),
+        draw_of(5, 2, QS_ALPHA_MODE_OPAQUE),
+        draw_of(6, 1, QS_ALPHA_MODE_OPAQUE),
+        draw_of(6, 1, QS_ALPHA_MODE_OPAQUE),
+        draw_of(6, 1, QS_ALPHA_MODE_OPAQUE),
+    };
+    r[2].material_params.has_normal_tex = 1;
+    r[3].material_params.has_normal_tex = 1;
+
+    PbrDrawQueue q = { 0 };
+    queue_in_order(&q, INSTANCE_DRAWS);
+
+    pbr_draw_queue_batch(&q, r, PBR_BATCH_MESH);
+    check_batches(&q, (const uint32_t[]){ 2, 3 }, 2);
+
+    pbr_draw_queue_batch(&q, r, PBR_BATCH_MATERIAL);
+    check_batches(&q, (const uint32_t[]){ 1, 1, 3 }, 3);
+
+    /* Materials 1 and 2 share their features; r[4] lacks the normal map */
+    pbr_draw_queue_batch(&q, r, PBR_BATCH_FEATURES);
+    check_batches(&q, (const uint32_t[]){ 2, 2, 1 }, 3);
+
+    pbr_draw_queue_free(&q);
+}
+
+static void test_blended_draws_never_merge(void)
+{
+    Qs_Renderable r[3] = {
+        draw_of(7, 3, QS_ALPHA_MODE_BLEND),
+        draw_of(7, 3, QS_ALPHA_MODE_BLEND),
+        draw_of(7, 3, QS_ALPHA_MODE_BLEND),
+    };
+    PbrDrawQueue q = { 0 };
+    queue_in_order(&q, 3);
+    pbr_draw_queue_batch(&q, r, PBR_BATCH_MESH);
+    check_batches(&q, (const uint32_t[]){ 1, 1, 1 }, 3);
+    pbr_draw_queue_free(&q);
+}
+
+static void test_material_features(void)
+{
+    Qs_PBRParams p;
+    memset(&p, 0, sizeof(p));
+    QS_CHECK_EQ_U(pbr_material_features(&p), 0);
+    p.has_base_color_tex = p.has_metallic_roughness_tex = p.has_normal_tex = 1;
+    p.has_occlusion_tex  = p.has_emissive_tex = 1;
+    QS_CHECK_EQ_U(pbr_material_features(&p), PBR_FEATURES_DEFAULT);
+    p.alpha_mode = QS_ALPHA_MODE_MASK;
+    QS_CHECK_EQ_U(pbr_material_features(&p), PBR_FEATURES_DEFAULT | PBR_FEATURE_ALPHA_TEST);
+    QS_CHECK(pbr_material_features(&p) < PBR_FEATURE_MASKS);
+}
+
+/* Forward queue of interleaved materials on one mesh, as the forward
+   pass builds it on either path: bindless merges materials sharing a
+   variant, the per-material path splits them and keeps masked draws
+   apart in both. */
+static void check_forward_path(bool bindless, const uint32_t *expected_counts,
+                               uint32_t expected_batches)
+{
+    Qs_Renderable r[5] = {
+        draw_of(4, 3, QS_ALPHA_MODE_OPAQUE),
+        draw_of(4, 7, QS_ALPHA_MODE_OPAQUE),
+        draw_of(4, 9, QS_ALPHA_MODE_MASK),
+        draw_of(4, 3, QS_ALPHA_MODE_OPAQUE),
+        draw_of(4, 7, QS_ALPHA_MODE_OPAQUE),
+    };
+    const float depth[5] = { 0.9f, 0.1f, 0.5f, 0.3f, 0.7f };
+    PbrDrawQueue q = { 0 };
+    QS_CHECK(pbr_draw_queue_reserve(&q, 5));
+    for (uint32_t i = 0; i < 5; i++)
+        qs_draw_list_push(&q.list, pbr_forward_key(&r[i], depth[i], bindless), i);
+    qs_draw_list_sort(&q.list);
+    pbr_draw_queue_batch(&q, r, bindless ? PBR_BATCH_FEATURES : PBR_BATCH_MATERIAL);
+    check_batches(&q, expected_counts, expected_batches);
+
+    for (uint32_t b = 0; b < q.batch_count; b++) {
+        const Qs_Renderable *first = &r[q.list.items[q.batches[b].first]];
+        for (uint32_t i = q.batches[b].first; i < q.batches[b].first + q.batches[b].count; i++) {
+            const Qs_Renderable *ren = &r[q.list.items[i]];
+            QS_CHECK_EQ_U(pbr_material_features(&ren->material_params),
+                          pbr_material_features(&first->material_params));
+            if (!bindless) QS_CHECK_EQ_U(ren->material_id, first->material_id);
+        }
+    }
+    /* Masked draws sort after every opaque one */
+    QS_CHECK_EQ_U(q.list.items[4], 2);
+    pbr_draw_queue_free(&q);
+}
+
+static void test_forward_paths(void)
+{
+    check_forward_path(true,  (const uint32_t[]){ 4, 1 }, 2);
+    check_forward_path(false, (const uint32_t[]){ 2, 2, 1 }, 3);
+}
+
+/* The normal columns must be the inverse-transpose of the upper 3x3, and
+   the box and material id land in the w-padded center / extent. */
+static void test_write_object(void)
+{
+    const float pos[3] = { 1.0f, 2.0f, 3.0f };
+    const float quat[4] = { 0.18257419f, 0.36514837f, 0.18257419f, 0.89442719f };
+    const float scale[3] = { 2.0f, 0.5f, 3.0f };
+    float model[16], inv[16];
+    qs_m4_from_trs(model, pos, quat, scale);
+    QS_CHECK(qs_m4_inverse(model, inv));
+
+    Qs_CullBounds bounds = { 0 };
+    QS_CHECK(qs_cull_bounds_reserve(&bounds, 2));
+    Qs_AABB box = { { -1.0f, 0.0f, 2.0f }, { 3.0f, 4.0f, 2.5f } };
+    qs_cull_bounds_set(&bounds, 1, &box);
+
+    Qs_Renderable ren = draw_of(1, 42, QS_ALPHA_MODE_OPAQUE);
+    ren.tint[1] = 0.5f;
+    PbrGpuObject obj;
+    pbr_write_object(&obj, model, &ren, &bounds, 1);
+
+    QS_CHECK(memcmp(obj.model, model, sizeof(model)) == 0);
+    for (int c = 0; c < 3; c++) {
+        for (int r = 0; r < 3; r++)
+            QS_CHECK_NEAR(obj.normal[c * 4 + r], inv[r * 4 + c], 1e-5f);
+        QS_CHECK_NEAR(obj.normal[c * 4 + 3], 0.0f, 0.0f);
+    }
+    QS_CHECK_NEAR(obj.tint[1], 0.5f, 0.0f);
+    QS_CHECK_NEAR(obj.center[0], 1.0f, 0.0f);
+    QS_CHECK_NEAR(obj.center[2], 2.25f, 0.0f);
+    QS_CHECK_NEAR(obj.extent[1], 2.0f, 0.0f);
+    QS_CHECK_NEAR(obj.center[3], 42.0f, 0.0f);
+    QS_CHECK_NEAR(obj.extent[3], 0.0f, 0.0f);
+    qs_cull_bounds_free(&bounds);
+}
+
+static void test_write_draws(void)
+{
+    Qs_Renderable r[4] = {
+        draw_of(1, 1, QS_ALPHA_MODE_OPAQUE),
+        draw_of(1, 1, QS_ALPHA_MODE_OPAQUE),
+        draw_of(2, 1, QS_ALPHA_MODE_OPAQUE),
+        draw_of(3, 1, QS_ALPHA_MODE_BLEND),
+    };
+    r[2].index_count  = 0;
+    r[2].vertex_count = 30;
+
+    PbrDrawQueue q = { 0 };
+    queue_in_order(&q, 4);
+    pbr_draw_queue_batch(&q, r, PBR_BATCH_MESH);
+    q.first_command  = 2;
+    q.first_instance = 10;
+
+    /* CULL_COMP addresses commands as 5-word records */
+    QS_CHECK_EQ_U(COMMAND_WORDS, 5);
+
+    PbrDrawCommand commands[5];
+    PbrCullItem    items[14];
+    memset(commands, 0xff, sizeof(commands));
+    pbr_write_draws(&q, r, PBR_CULL_OCCLUSION, commands, items);
+
+    QS_CHECK_EQ_U(commands[2].indexed.index_count, 36);
+    QS_CHECK_EQ_U(commands[2].indexed.instance_count, 0);
+    QS_CHECK_EQ_U(commands[2].indexed.first_instance, 10);
+    QS_CHECK_EQ_U(commands[3].direct.vertex_count, 30);
+    QS_CHECK_EQ_U(commands[3].direct.instance_count, 0);
+    QS_CHECK_EQ_U(commands[3].direct.first_instance, 12);
+    QS_CHECK_EQ_U(commands[4].indexed.first_instance, 13);
+
+    for (uint32_t i = 0; i < 4; i++) {
+        const PbrCullItem *it = &items[10 + i];
+        QS_CHECK_EQ_U(it->object, i);
+        QS_CHECK_EQ_U(it->command, i < 2 ? 2 : i + 1);
+        QS_CHECK_EQ_U(it->visible_base, i < 2 ? 10 : 10 + i);
+        /* blended draws are drawn after the late cull, frustum-tested only */
+        QS_CHECK_EQ_U(it->cull, i == 3 ? PBR_CULL_FRUSTUM : PBR_CULL_OCCLUSION);
+    }
+    pbr_draw_queue_free(&q);
+}
+
+/* C transliteration of one CULL_COMP invocation (pbr_forward.c): the
+   same plane test on the object record, the occluded flag in extent.w,
+   and the append through the command's instance count (word 1). */
+static void cull_shader_invocation(const Qs_Frustum *f, const PbrGpuObject *objects,
+                                   const PbrCullItem *it, uint32_t *words, uint32_t *visible)
+{
+    if (it->cull != 0u) {
+        const float *c = objects[it->object].center, *e = objects[it->object].extent;
+        for (int p = 0; p < 6; p++) {
+            const float *pl = f->planes[p];
+            if (pl[0]*c[0] + pl[1]*c[1] + pl[2]*c[2] + pl[3]
+                + fabsf(pl[0])*e[0] + fabsf(pl[1])*e[1] + fabsf(pl[2])*e[2] < 0.0f) return;
+        }
+        if (it->cull == 2u && e[3] != 0.0f) return;
+    }
+    uint32_t slot = words[it->command * COMMAND_WORDS + 1u]++;
+    visible[it->visible_base + slot] = it->object;
+}
+
+static int cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+/* Random scene drawn by batches of CULL_MESHES meshes.  The reference and
+   the shader, run over the items in reverse (GPU invocation order is
+   unspecified), must produce the same instance counts and the same set
+   of objects in every batch's visible range; the reference additionally
+   keeps list order. */
+static void test_cull_reference_matches_cull_shader(void)
+{
+    float view[16], proj[16], vp[16];
+    const float eye[3] = { 0.0f, 5.0f, 20.0f }, target[3] = { 0.0f, 0.0f, 0.0f };
+    const float up[3]  = { 0.0f, 1.0f, 0.0f };
+    qs_m4_look_at(view, eye, target, up);
+    qs_m4_perspective(proj, 1.0f, 16.0f / 9.0f, 0.1f, 200.0f);
+    qs_m4_mul(proj, view, vp);
+    Qs_Frustum f;
+    qs_frustum_from_matrix(&f, vp);
+
+    Qs_Renderable *r       = calloc(CULL_OBJECTS, sizeof(*r));
+    PbrGpuObject  *objects = calloc(CULL_OBJECTS, sizeof(*objects));
+    PbrCullItem   *items   = calloc(CULL_OBJECTS, sizeof(*items));
+    uint32_t *vis_ref = calloc(CULL_OBJECTS, sizeof(uint32_t));
+    uint32_t *vis_gpu = calloc(CULL_OBJECTS, sizeof(uint32_t));
+    PbrDrawCommand *cmd_ref = calloc(CULL_OBJECTS, sizeof(PbrDrawCommand));
+    PbrDrawCommand *cmd_gpu = calloc(CULL_OBJECTS, sizeof(PbrDrawCommand));
+    Qs_CullBounds bounds = { 0 };
+    PbrDrawQueue q = { 0 };
+    QS_CHECK(r && objects && items && vis_ref && vis_gpu && cmd_ref && cmd_gpu);
+    if (!(r && objects && items && vis_ref && vis_gpu && cmd_ref && cmd_gpu)) goto done;
+    QS_CHECK(qs_cull_bounds_reserve(&bounds, CULL_OBJECTS));
+
+    qs_test_seed(35);
+    float identity[16];
+    qs_m4_identity(identity);
+    for (uint32_t i = 0; i < CULL_OBJECTS; i++) {
+        r[i] = draw_of(i % CULL_MESHES, 1, QS_ALPHA_MODE_OPAQUE);
+        float c[3] = { qs_test_randf(-80.0f, 80.0f), qs_test_randf(-20.0f, 20.0f),
+                       qs_test_randf(-150.0f, 40.0f) };
+        float h = qs_test_randf(0.2f, 4.0f);
+        Qs_AABB box = { { c[0] - h, c[1] - h, c[2] - h }, { c[0] + h, c[1] + h, c[2] + h } };
+        qs_cull_bounds_set(&bounds, i, &box);
+        pbr_write_object(&objects[i], identity, &r[i], &bounds, i);
+    }
+
+    /* Sorted by mesh like the passes' draw keys */
+    QS_CHECK(pbr_draw_queue_reserve(&q, CULL_OBJECTS));
+    for (uint32_t i = 0; i < CULL_OBJECTS; i++)
+        qs_draw_list_push(&q.list, (uint64_t)r[i].mesh_id << 32 | i, i);
+    qs_draw_list_sort(&q.list);
+    pbr_draw_queue_batch(&q, r, PBR_BATCH_MESH);
+    QS_CHECK_EQ_U(q.batch_count, CULL_MESHES);
+    pbr_write_draws(&q, r, PBR_CULL_OCCLUSION, cmd_ref, items);
+    memcpy(cmd_gpu, cmd_ref, CULL_OBJECTS * sizeof(PbrDrawCommand));
+
+    pbr_cull_reference(&f, &bounds, items, CULL_OBJECTS, cmd_ref, vis_ref);
+    for (uint32_t i = CULL_OBJECTS; i-- > 0; )
+        cull_shader_invocation(&f, objects, &items[i], (uint32_t *)cmd_gpu, vis_gpu);
+
+    uint32_t total = 0;
+    for (uint32_t b = 0; b < q.batch_count; b++) {
+        uint32_t n    = cmd_ref[b].indexed.instance_count;
+        uint32_t base = cmd_ref[b].indexed.first_instance;
+        total += n;
+        QS_CHECK_EQ_U(cmd_gpu[b].indexed.instance_count, n);
+        QS_CHECK(n <= q.batches[b].count);
+        for (uint32_t k = 1; k < n; k++)
+            QS_CHECK(vis_ref[base + k - 1] < vis_ref[base + k]);
+        qsort(vis_gpu + base, n, sizeof(uint32_t), cmp_u32);
+        QS_CHECK(memcmp(vis_ref + base, vis_gpu + base, n * sizeof(uint32_t)) == 0);
+    }
+    QS_CHECK(total > 0 && total < CULL_OBJECTS);
+
+    /* The same verdicts as the engine's frustum kernel */
+    uint32_t *engine_visible = vis_gpu;
+    QS_CHECK_EQ_U(qs_cull_frustum(&f, &bounds, engine_visible), total);
+
+    /* Occluded objects drop out on the GPU only; the reference has no
+       flags and keeps them. */
+    for (uint32_t b = 0; b < q.batch_count; b++) cmd_gpu[b].indexed.instance_count = 0;
+    for (uint32_t i = 0; i < CULL_OBJECTS; i++) objects[i].extent[3] = 1.0f;
+    for (uint32_t i = 0; i < CULL_OBJECTS; i++)
+        cull_shader_invocation(&f, objects, &items[i], (uint32_t *)cmd_gpu, vis_gpu);
+    for (uint32_t b = 0; b < q.batch_count; b++)
+        QS_CHECK_EQ_U(cmd_gpu[b].indexed.instance_count, 0);
+
+done:
+    pbr_draw_queue_free(&q);
+    qs_cull_bounds_free(&bounds);
+    free(cmd_gpu); free(cmd_ref); free(vis_gpu); free(vis_ref);
+    free(items); free(objects); free(r);
+}
+
+int main(void)
+{
+    QS_TEST_RUN(test_batch_by_mesh_material_and_features);
+    QS_TEST_RUN(test_blended_draws_never_merge);
+    QS_TEST_RUN(test_material_features);
+    QS_TEST_RUN(test_forward_paths);
+    QS_TEST_RUN(test_write_object);
+    QS_TEST_RUN(test_write_draws);
+    QS_TEST_RUN(test_cull_reference_matches_cull_shader);
+    return QS_TEST_RESULT();
+}
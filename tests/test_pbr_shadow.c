@@ -0,0 +1,351 @@
+/*
+ * test_pbr_shadow.c — cascade caster selection of the PBR backend
+ * (pbr_shadow.c): extrusion toward the light and casters left out of
+ * cascades whose nearer neighbour already covers them; cascade refresh
+ * scheduling and the static caster caches.
+ */
+
+#include "pbr_internal.h"
+#include "qs_test.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum {
+    CASTER_CORE,        /* small box at the camera target */
+    CASTER_BLEND,       /* in cascade 0's blend band, inside cascade 1's core */
+    CASTER_TOWER,       /* rises above cascade 0's depth range, not cascade 1's */
+    CASTER_SPIRE,       /* rises above cascade 1's depth range too */
+    CASTER_ABOVE,       /* wholly between the light and the light volume */
+    CASTER_BELOW,       /* past every cascade's far plane */
+    CASTER_OUTSIDE,     /* beside every cascade */
+    CASTER_NO_SHADOW,   /* cast_shadows = false */
+    CASTER_NO_GEOMETRY, /* no position buffer */
+    CASTER_COUNT
+};
+
+static float shadow[QS_CSM_CASCADES][16];
+static float radius[QS_CSM_CASCADES];
+
+/* Sun straight down: light-space x runs along world z and y along world
+   x, so a cascade covers |x|, |z| <= radius around the snapped target
+   (the origin) and stores depths for world y in [-4 radius, radius]. */
+static void setup_cascades(void)
+{
+    Qs_Camera cam;
+    memset(&cam, 0, sizeof(cam));
+    cam.position[1] = 10.0f;
+    cam.position[2] = 20.0f;
+    cam.near_plane  = 0.1f;
+    cam.far_plane   = 200.0f;
+    Qs_LightGPU sun;
+    memset(&sun, 0, sizeof(sun));
+    sun.type         = (uint32_t)QS_LIGHT_DIRECTIONAL;
+    sun.direction[1] = -1.0f;
+    pbr_csm_compute(&cam, &sun, 1, shadow);
+    for (uint32_t c = 0; c < QS_CSM_CASCADES; c++)
+        radius[c] = 1.0f / fabsf(shadow[c][8]);
+}
+
+static void set_box(Qs_CullBounds *b, uint32_t i, float x, float y0, float y1,
+                    float z, float half)
+{
+    qs_cull_bounds_set(b, i, &(Qs_AABB){ { x - half, y0, z - half },
+                                         { x + half, y1, z + half } });
+}
+
+static bool selected(const uint32_t *out, uint32_t count, uint32_t index)
+{
+    for (uint32_t k = 0; k < count; k++)
+        if (out[k] == index) return true;
+    return false;
+}
+
+static void test_caster_selection(void)
+{
+    setup_cascades();
+    QS_CHECK(radius[0] < radius[1] && radius[1] < radius[2]);
+    float r0 = radius[0];
+
+    Qs_CullBounds bounds;
+    memset(&bounds, 0, sizeof(bounds));
+    QS_CHECK(qs_cull_bounds_reserve(&bounds, CASTER_COUNT));
+    set_box(&bounds, CASTER_CORE,        0.0f, -0.5f, 0.5f, 0.0f, 0.5f);
+    set_box(&bounds, CASTER_BLEND,       0.0f, -0.5f, 0.5f, 0.95f * r0, 0.1f);
+    set_box(&bounds, CASTER_TOWER,       0.0f, 0.0f, 0.5f * (r0 + radius[1]), 0.0f, 0.5f);
+    set_box(&bounds, CASTER_SPIRE,       0.0f, 0.0f, 2.0f * radius[1], 0.0f, 0.5f);
+    set_box(&bounds, CASTER_ABOVE,       0.0f, 7.0f * r0, 7.0f * r0 + 1.0f, 0.0f, 0.5f);
+    set_box(&bounds, CASTER_BELOW,       0.0f, -10.0f * radius[2] - 1.0f, -10.0f * radius[2], 0.0f, 0.5f);
+    set_box(&bounds, CASTER_OUTSIDE,     0.0f, -0.5f, 0.5f, 1.5f * radius[2], 0.5f);
+    set_box(&bounds, CASTER_NO_SHADOW,   0.0f, -0.5f, 0.5f, 0.0f, 0.5f);
+    set_box(&bounds, CASTER_NO_GEOMETRY, 0.0f, -0.5f, 0.5f, 0.0f, 0.5f);
+
+    Qs_Renderable renderables[CASTER_COUNT];
+    memset(renderables, 0, sizeof(renderables));
+    for (uint32_t i = 0; i < CASTER_COUNT; i++) {
+        renderables[i].cast_shadows    = i != CASTER_NO_SHADOW;
+        renderables[i].position_buffer = i != CASTER_NO_GEOMETRY ? (Qs_GpuBuffer *)&bounds : NULL;
+    }
+
+    /* Without the extrusion the plain light volume misses the caster above */
+    Qs_Frustum plain;
+    uint32_t   plain_out[CASTER_COUNT];
+    qs_frustum_from_matrix(&plain, shadow[0]);
+    QS_CHECK(!selected(plain_out, qs_cull_frustum(&plain, &bounds, plain_out), CASTER_ABOVE));
+
+    const bool expected[QS_CSM_CASCADES][CASTER_COUNT] = {
+        /* core  blend  tower  spire  above  below  outside noshadow nogeom */
+        {  true, true,  true,  true,  true,  false, false, false, false },
+        { false, true,  true,  true,  true,  false, false, false, false },
+        { false, false, false, true,  true,  false, false, false, false },
+    };
+    uint32_t out[CASTER_COUNT];
+    for (uint32_t c = 0; c < QS_CSM_CASCADES; c++) {
+        uint32_t count = pbr_csm_select_casters(shadow, c, &bounds, renderables, out);
+        for (uint32_t i = 0; i < CASTER_COUNT; i++)
+            if (selected(out, count, i) != expected[c][i]) {
+                fprintf(stderr, "cascade %u caster %u: expected %s\n",
+                        c, i, expected[c][i] ? "selected" : "skipped");
+                qs_test_failures++;
+            }
+        for (uint32_t k = 1; k < count; k++)
+            QS_CHECK(out[k - 1] < out[k]);
+    }
+    qs_cull_bounds_free(&bounds);
+}
+
+/* A caster in cascade 1's blend band is not covered by that cascade, so
+   cascade 2 draws it as well as one beyond cascade 1 altogether. */
+static void test_far_cascade_keeps_uncovered_casters(void)
+{
+    setup_cascades();
+    float r1 = radius[1];
+
+    Qs_CullBounds bounds;
+    memset(&bounds, 0, sizeof(bounds));
+    QS_CHECK(qs_cull_bounds_reserve(&bounds, 2));
+    set_box(&bounds, 0, 0.0f, -0.5f, 0.5f, 0.95f * r1, 0.1f);   /* cascade 1 blend band */
+    set_box(&bounds, 1, 0.0f, -0.5f, 0.5f, 1.2f * r1, 0.1f);    /* beyond cascade 1 */
+
+    Qs_Renderable renderables[2];
+    memset(renderables, 0, sizeof(renderables));
+    for (uint32_t i = 0; i < 2; i++) {
+        renderables[i].cast_shadows    = true;
+        renderables[i].position_buffer = (Qs_GpuBuffer *)&bounds;
+    }
+
+    uint32_t out[2];
+    QS_CHECK_EQ_U(pbr_csm_select_casters(shadow, 1, &bounds, renderables, out), 1);
+    QS_CHECK_EQ_U(out[0], 0);
+    QS_CHECK_EQ_U(pbr_csm_select_casters(shadow, 2, &bounds, renderables, out), 2);
+    qs_cull_bounds_free(&bounds);
+}
+
+/* ── Scheduling and static caches ───────────────────────────── */
+
+/* Cascades of a sun tilted sun_x off vertical, camera at camera_x */
+static void compute_cascades(float out[QS_CSM_CASCADES][16], float sun_x, float camera_x)
+{
+    Qs_Camera cam;
+    memset(&cam, 0, sizeof(cam));
+    cam.position[0] = camera_x;
+    cam.position[1] = 10.0f;
+    cam.position[2] = 20.0f;
+    cam.near_plane  = 0.1f;
+    cam.far_plane   = 200.0f;
+    Qs_LightGPU sun;
+    memset(&sun, 0, sizeof(sun));
+    sun.type         = (uint32_t)QS_LIGHT_DIRECTIONAL;
+    sun.direction[0] = sun_x;
+    sun.direction[1] = -1.0f;
+    pbr_csm_compute(&cam, &sun, 1, out);
+}
+
+/* One frame as the renderer runs it: begin, schedule, then every
+   renderable classified for every due cascade.  pass[i][c] is left
+   untouched for cascades that are not due. */
+static uint32_t run_frame(PbrShadowState *s, const float cascades[QS_CSM_CASCADES][16],
+                          const uint32_t *dirty, uint32_t dirty_count, uint32_t count,
+                          PbrCasterPass pass[][QS_CSM_CASCADES])
+{
+    QS_CHECK(pbr_shadow_begin_frame(s, dirty, dirty_count, count));
+    uint32_t due = pbr_shadow_schedule(s, cascades);
+    for (uint32_t c = 0; c < QS_CSM_CASCADES; c++)
+        if (due & (1u << c))
+            for (uint32_t i = 0; i < count; i++)
+                pass[i][c] = pbr_shadow_classify(s, c, i);
+    return due;
+}
+
+/* Cascade 0 renders every frame; cascade c only on the frames where
+   frame % interval == interval / 2, so no two far cascades coincide */
+static void test_far_cascades_staggered(void)
+{
+    float cascades[QS_CSM_CASCADES][16];
+    compute_cascades(cascades, 0.0f, 0.0f);
+    PbrShadowState s;
+    memset(&s, 0, sizeof(s));
+    PbrCasterPass pass[1][QS_CSM_CASCADES];
+
+    /* Nothing is valid yet: everything renders and rebuilds */
+    QS_CHECK_EQ_U(run_frame(&s, cascades, NULL, 0, 1, pass), 0x7);
+    QS_CHECK_EQ_U(s.rebuild, 0x7);
+
+    for (uint32_t f = 0; f < 32; f++) {
+        uint32_t due = run_frame(&s, cascades, NULL, 0, 1, pass);
+        uint32_t expected = 0;
+        for (uint32_t c = 0; c < QS_CSM_CASCADES; c++) {
+            uint32_t interval = 1u << (c * PBR_CSM_REFRESH_SHIFT);
+            if (s.frame % interval == interval / 2) expected |= 1u << c;
+        }
+        QS_CHECK_EQ_U(due, expected);
+        QS_CHECK(due & 1u);
+        QS_CHECK_EQ_U(s.rebuild, 0);
+        QS_CHECK((due & 0x6) != 0x6);
+    }
+    pbr_shadow_state_free(&s);
+}
+
+/* A camera move inside a snap step keeps the texel-snapped matrices and
+   the caches; moving the light changes them and rebuilds each cache the
+   next time its cascade renders, along with every farther cascade */
+static void test_light_move_invalidates_cache(void)
+{
+    float cascades[QS_CSM_CASCADES][16], moved[QS_CSM_CASCADES][16];
+    compute_cascades(cascades, 0.0f, 0.0f);
+    PbrShadowState s;
+    memset(&s, 0, sizeof(s));
+    PbrCasterPass pass[1][QS_CSM_CASCADES];
+    for (uint32_t f = 0; f < 8; f++)
+        run_frame(&s, cascades, NULL, 0, 1, pass);
+
+    compute_cascades(moved, 0.0f, 1e-3f);
+    QS_CHECK(memcmp(moved, cascades, sizeof(moved)) == 0);
+    for (uint32_t f = 0; f < 4; f++) {
+        run_frame(&s, moved, NULL, 0, 1, pass);
+        QS_CHECK_EQ_U(s.rebuild, 0);
+    }
+
+    compute_cascades(moved, 0.3f, 0.0f);
+    for (uint32_t c = 0; c < QS_CSM_CASCADES; c++)
+        QS_CHECK(memcmp(moved[c], cascades[c], sizeof(moved[c])) != 0);
+    /* Cascade 0 changes first, which makes the far ones due at once */
+    QS_CHECK_EQ_U(run_frame(&s, moved, NULL, 0, 1, pass), 0x7);
+    QS_CHECK_EQ_U(s.rebuild, 0x7);
+    for (uint32_t c = 0; c < QS_CSM_CASCADES; c++)
+        QS_CHECK(memcmp(s.matrices[c], moved[c], sizeof(moved[c])) == 0);
+    run_frame(&s, moved, NULL, 0, 1, pass);
+    QS_CHECK_EQ_U(s.rebuild, 0);
+
+    /* Only the far cascade's matrix changes: it rebuilds on its own frame */
+    memcpy(cascades, moved, sizeof(moved));
+    moved[2][12] += 0.5f;
+    for (uint32_t f = 0; f < 4; f++) {
+        uint32_t due = run_frame(&s, moved, NULL, 0, 1, pass);
+        QS_CHECK_EQ_U(s.rebuild, due & 0x4);
+    }
+    QS_CHECK(memcmp(s.matrices[2], moved[2], sizeof(moved[2])) == 0);
+    pbr_shadow_state_free(&s);
+}
+
+/* Runs frames frames with no caster changing */
+static void run_frames(PbrShadowState *s, const float cascades[QS_CSM_CASCADES][16],
+                       uint32_t frames, uint32_t count, PbrCasterPass pass[][QS_CSM_CASCADES])
+{
+    for (uint32_t f = 0; f < frames; f++)
+        run_frame(s, cascades, NULL, 0, count, pass);
+}
+
+/* A changed static caster leaves the cache and is drawn dynamically until
+   it has been still for PBR_SHADOW_STATIC_FRAMES, then folds back in */
+static void test_dirty_caster_leaves_and_rejoins_cache(void)
+{
+    float cascades[QS_CSM_CASCADES][16];
+    compute_cascades(cascades, 0.0f, 0.0f);
+    PbrShadowState s;
+    memset(&s, 0, sizeof(s));
+    PbrCasterPass pass[2][QS_CSM_CASCADES];
+
+    /* New casters are dynamic; once static they are cached, then skipped */
+    run_frame(&s, cascades, NULL, 0, 2, pass);
+    QS_CHECK_EQ_U(pass[0][0], PBR_CASTER_DYNAMIC);
+    run_frames(&s, cascades, PBR_SHADOW_STATIC_FRAMES - 1, 2, pass);
+    QS_CHECK_EQ_U(pass[0][0], PBR_CASTER_DYNAMIC);
+    run_frame(&s, cascades, NULL, 0, 2, pass);
+    QS_CHECK_EQ_U(pass[0][0], PBR_CASTER_DYNAMIC);   /* static, cache not yet rebuilt */
+    QS_CHECK(!(s.cache_valid & 1u));
+    run_frame(&s, cascades, NULL, 0, 2, pass);
+    QS_CHECK_EQ_U(s.rebuild & 1u, 1);
+    QS_CHECK_EQ_U(pass[0][0], PBR_CASTER_CACHE);
+    QS_CHECK_EQ_U(pass[1][0], PBR_CASTER_CACHE);
+    QS_CHECK_EQ_U(s.cached_count[0], 2);
+    run_frame(&s, cascades, NULL, 0, 2, pass);
+    QS_CHECK_EQ_U(pass[0][0], PBR_CASTER_SKIP);
+    QS_CHECK_EQ_U(pass[1][0], PBR_CASTER_SKIP);
+
+    /* Caster 0 moves: the cache is rebuilt without it */
+    const uint32_t dirty[] = { 0 };
+    run_frame(&s, cascades, dirty, 1, 2, pass);
+    QS_CHECK_EQ_U(s.rebuild & 1u, 1);
+    QS_CHECK_EQ_U(pass[0][0], PBR_CASTER_DYNAMIC);
+    QS_CHECK_EQ_U(pass[1][0], PBR_CASTER_CACHE);
+    QS_CHECK_EQ_U(s.cached_count[0], 1);
+    run_frames(&s, cascades, PBR_SHADOW_STATIC_FRAMES - 1, 2, pass);
+    QS_CHECK_EQ_U(pass[0][0], PBR_CASTER_DYNAMIC);
+    QS_CHECK_EQ_U(pass[1][0], PBR_CASTER_SKIP);
+
+    /* Still for PBR_SHADOW_STATIC_FRAMES: folded in at the next refresh */
+    run_frame(&s, cascades, NULL, 0, 2, pass);
+    QS_CHECK_EQ_U(pass[0][0], PBR_CASTER_DYNAMIC);
+    run_frame(&s, cascades, NULL, 0, 2, pass);
+    QS_CHECK_EQ_U(pass[0][0], PBR_CASTER_CACHE);
+    QS_CHECK_EQ_U(s.cached_count[0], 2);
+    run_frame(&s, cascades, NULL, 0, 2, pass);
+    QS_CHECK_EQ_U(pass[0][0], PBR_CASTER_SKIP);
+    pbr_shadow_state_free(&s);
+}
+
+/* Removing cached casters from the tail invalidates exactly the caches
+   that held them; removing a dynamic one keeps every cache */
+static void test_removed_caster_invalidates_cache(void)
+{
+    float cascades[QS_CSM_CASCADES][16];
+    compute_cascades(cascades, 0.0f, 0.0f);
+    PbrShadowState s;
+    memset(&s, 0, sizeof(s));
+    PbrCasterPass pass[4][QS_CSM_CASCADES];
+    run_frames(&s, cascades, PBR_SHADOW_STATIC_FRAMES + 8, 3, pass);
+    QS_CHECK_EQ_U(s.cache_valid, 0x7);
+    for (uint32_t c = 0; c < QS_CSM_CASCADES; c++)
+        QS_CHECK_EQ_U(s.cached_count[c], 3);
+
+    /* A fourth caster arrives and leaves while still dynamic */
+    run_frame(&s, cascades, NULL, 0, 4, pass);
+    QS_CHECK_EQ_U(pass[3][0], PBR_CASTER_DYNAMIC);
+    QS_CHECK(pbr_shadow_begin_frame(&s, NULL, 0, 3));
+    QS_CHECK_EQ_U(s.cache_valid, 0x7);
+    pbr_shadow_schedule(&s, cascades);
+    QS_CHECK_EQ_U(s.rebuild, 0);
+
+    /* Caster 2 is in every cache: each rebuilds when its cascade is due */
+    QS_CHECK(pbr_shadow_begin_frame(&s, NULL, 0, 2));
+    QS_CHECK_EQ_U(s.cache_valid, 0);
+    QS_CHECK_EQ_U(s.count, 2);
+    QS_CHECK_EQ_U(pbr_shadow_schedule(&s, cascades), 0x7);
+    QS_CHECK_EQ_U(s.rebuild, 0x7);
+    for (uint32_t c = 0; c < QS_CSM_CASCADES; c++)
+        QS_CHECK_EQ_U(s.cached_count[c], 0);
+    pbr_shadow_state_free(&s);
+}
+
+int main(void)
+{
+    QS_TEST_RUN(test_caster_selection);
+    QS_TEST_RUN(test_far_cascade_keeps_uncovered_casters);
+    QS_TEST_RUN(test_far_cascades_staggered);
+    QS_TEST_RUN(test_light_move_invalidates_cache);
+    QS_TEST_RUN(test_dirty_caster_leaves_and_rejoins_cache);
+    QS_TEST_RUN(test_removed_caster_invalidates_cache);
+    return QS_TEST_RESULT();
+}
@@ -0,0 +1,239 @@
+/*
+ * test_render_graph.c — render graph compiler on synthetic passes:
+ * scheduling, culling, transient placement and barrier layouts.
+ */
+
+#include "qs_render_graph.h"
+#include "qs_test.h"
+
+#define COLOR QS_GPU_IMAGE_LAYOUT_COLOR_ATTACHMENT
+#define DEPTH QS_GPU_IMAGE_LAYOUT_DEPTH_ATTACHMENT
+#define READ  QS_GPU_IMAGE_LAYOUT_SHADER_READ
+#define UNDEF QS_GPU_IMAGE_LAYOUT_UNDEFINED
+
+#define PASS(side_effects, ...)                                               \
+    make_pass(side_effects, (const Qs_RgAccess[]){ __VA_ARGS__ },             \
+              sizeof((const Qs_RgAccess[]){ __VA_ARGS__ }) / sizeof(Qs_RgAccess))
+
+static Qs_RgPlan plan;
+
+static Qs_RgPass make_pass(bool side_effects, const Qs_RgAccess *accesses, uint32_t count)
+{
+    Qs_RgPass p = { .access_count = count, .side_effects = side_effects };
+    for (uint32_t a = 0; a < count; a++) p.accesses[a] = accesses[a];
+    return p;
+}
+
+static Qs_RgResource transient(uint64_t size, uint64_t alignment, uint32_t type_bits)
+{
+    return (Qs_RgResource){ .transient = true, .layout = UNDEF, .size = size,
+                            .alignment = alignment, .type_bits = type_bits };
+}
+
+static Qs_RgResource persistent(Qs_GpuImageLayout layout)
+{
+    return (Qs_RgResource){ .layout = layout };
+}
+
+static void check_barrier(uint32_t b, uint32_t resource, Qs_GpuImageLayout old_layout,
+                          Qs_GpuImageLayout new_layout, Qs_GpuImageLayout wait_layout)
+{
+    QS_CHECK(b < plan.barrier_count);
+    if (b >= plan.barrier_count) return;
+    QS_CHECK_EQ_U(plan.barriers[b].resource,    resource);
+    QS_CHECK_EQ_U(plan.barriers[b].old_layout,  old_layout);
+    QS_CHECK_EQ_U(plan.barriers[b].new_layout,  new_layout);
+    QS_CHECK_EQ_U(plan.barriers[b].wait_layout, wait_layout);
+}
+
+/* ── Scheduling ─────────────────────────────────────────────── */
+
+/* A read declared before the transient's writer consumes this frame's
+   contents, so the writer runs first; unrelated passes keep their order. */
+static void test_writer_pulled_ahead_of_reader(void)
+{
+    const Qs_RgResource res[] = { transient(256, 256, 1), persistent(READ), persistent(READ) };
+    const Qs_RgPass passes[] = {
+        PASS(false, { 0, READ }, { 1, COLOR }),   /* composite */
+        PASS(false, { 0, COLOR }),                /* producer */
+        PASS(false, { 2, COLOR }),                /* independent */
+    };
+    QS_CHECK(qs_render_graph_compile(res, 3, passes, 3, &plan));
+    QS_CHECK_EQ_U(plan.order_count, 3);
+    QS_CHECK_EQ_U(plan.order[0], 1);
+    QS_CHECK_EQ_U(plan.order[1], 0);
+    QS_CHECK_EQ_U(plan.order[2], 2);
+}
+
+/* Persistent contents carry over, so a read before the writer reads
+   last frame's image and declaration order stands. */
+static void test_persistent_read_keeps_order(void)
+{
+    const Qs_RgResource res[] = { persistent(READ), persistent(READ) };
+    const Qs_RgPass passes[] = {
+        PASS(false, { 0, READ }, { 1, COLOR }),
+        PASS(false, { 0, COLOR }),
+    };
+    QS_CHECK(qs_render_graph_compile(res, 2, passes, 2, &plan));
+    QS_CHECK_EQ_U(plan.order_count, 2);
+    QS_CHECK_EQ_U(plan.order[0], 0);
+    QS_CHECK_EQ_U(plan.order[1], 1);
+}
+
+static void test_invalid_graphs_rejected(void)
+{
+    /* p0 must follow p2 (pulled writer of T0), p1 follows p0 (reads P1)
+       and p2 follows p1 (reads T2): a cycle */
+    const Qs_RgResource res[] = { transient(64, 64, 1), persistent(READ), transient(64, 64, 1) };
+    const Qs_RgPass cycle[] = {
+        PASS(false, { 0, READ }, { 1, COLOR }),
+        PASS(false, { 1, READ }, { 2, COLOR }),
+        PASS(false, { 2, READ }, { 0, COLOR }),
+    };
+    QS_CHECK(!qs_render_graph_compile(res, 3, cycle, 3, &plan));
+
+    const Qs_RgPass out_of_range[] = { PASS(false, { 3, COLOR }) };
+    QS_CHECK(!qs_render_graph_compile(res, 3, out_of_range, 1, &plan));
+}
+
+/* ── Culling ────────────────────────────────────────────────── */
+
+static void test_unconsumed_passes_culled(void)
+{
+    const Qs_RgResource res[] = { transient(64, 64, 1), transient(64, 64, 1), persistent(READ) };
+    const Qs_RgPass passes[] = {
+        PASS(false, { 0, COLOR }),                /* nobody reads T0 */
+        PASS(false, { 1, COLOR }),
+        PASS(false, { 1, READ }, { 2, COLOR }),   /* writes a persistent */
+        PASS(true,  { 2, READ }),                 /* side effects */
+        make_pass(false, NULL, 0),                /* opaque */
+    };
+    QS_CHECK(qs_render_graph_compile(res, 3, passes, 5, &plan));
+    QS_CHECK_EQ_U(plan.order_count, 4);
+    QS_CHECK_EQ_U(plan.order[0], 1);
+    QS_CHECK_EQ_U(plan.order[1], 2);
+    QS_CHECK_EQ_U(plan.order[2], 3);
+    QS_CHECK_EQ_U(plan.order[3], 4);
+    /* Only the culled pass touched T0, so it gets no memory */
+    QS_CHECK_EQ_U(plan.heap_offset[0], QS_RG_NOT_ALIASED);
+    QS_CHECK(plan.heap_offset[1] != QS_RG_NOT_ALIASED);
+}
+
+static void test_dead_chain_culled(void)
+{
+    const Qs_RgResource res[] = { transient(64, 64, 1), transient(64, 64, 1) };
+    const Qs_RgPass passes[] = {
+        PASS(false, { 0, COLOR }),
+        PASS(false, { 0, READ }, { 1, COLOR }),   /* T1 never read */
+    };
+    QS_CHECK(qs_render_graph_compile(res, 2, passes, 2, &plan));
+    QS_CHECK_EQ_U(plan.order_count, 0);
+    QS_CHECK_EQ_U(plan.heap_size, 0);
+    QS_CHECK_EQ_U(plan.barrier_count, 0);
+}
+
+/* ── Transient placement ────────────────────────────────────── */
+
+static void test_alias_placement(void)
+{
+    /* Lifetimes in scheduled passes: T0 [0,1], T2 [1,2], T1 [2,3], T3 [4,5] */
+    const Qs_RgResource res[] = {
+        transient(100, 64, 0x3),
+        transient(100, 64, 0x1),
+        transient(60,  64, 0x3),
+        transient(50,  64, 0x4),   /* no memory type in common */
+        persistent(READ),
+    };
+    const Qs_RgPass passes[] = {
+        PASS(false, { 0, COLOR }),
+        PASS(false, { 0, READ }, { 2, COLOR }),
+        PASS(false, { 2, READ }, { 1, COLOR }),
+        PASS(false, { 1, READ }, { 4, COLOR }),
+        PASS(false, { 3, COLOR }),
+        PASS(false, { 3, READ }, { 4, COLOR }),
+    };
+    QS_CHECK(qs_render_graph_compile(res, 5, passes, 6, &plan));
+    QS_CHECK_EQ_U(plan.order_count, 6);
+
+    QS_CHECK_EQ_U(plan.heap_offset[0], 0);
+    QS_CHECK_EQ_U(plan.heap_offset[1], 0);     /* disjoint from T0: shares it */
+    QS_CHECK_EQ_U(plan.heap_offset[2], 128);   /* overlaps both; aligned past them */
+    QS_CHECK_EQ_U(plan.heap_offset[3], QS_RG_NOT_ALIASED);
+    QS_CHECK_EQ_U(plan.heap_offset[4], QS_RG_NOT_ALIASED);
+    QS_CHECK_EQ_U(plan.heap_size, 188);
+    QS_CHECK_EQ_U(plan.heap_type_bits, 0x1);
+
+    /* No two placed transients with overlapping lifetimes share bytes */
+    const uint32_t first[] = { 0, 2, 1 }, last[] = { 1, 3, 2 };
+    for (uint32_t a = 0; a < 3; a++)
+        for (uint32_t b = a + 1; b < 3; b++) {
+            if (last[a] < first[b] || last[b] < first[a]) continue;
+            bool apart = plan.heap_offset[a] + res[a].size <= plan.heap_offset[b] ||
+                         plan.heap_offset[b] + res[b].size <= plan.heap_offset[a];
+            QS_CHECK(apart);
+        }
+}
+
+/* ── Barriers ───────────────────────────────────────────────── */
+
+static void test_barrier_layouts(void)
+{
+    /* T0 [0,1] and T1 [2,3] alias at offset 0; P2 rests in SHADER_READ */
+    const Qs_RgResource res[] = { transient(64, 64, 1), transient(64, 64, 1), persistent(READ) };
+    const Qs_RgPass passes[] = {
+        PASS(false, { 0, COLOR }),
+        PASS(false, { 0, READ }, { 2, COLOR }),
+        PASS(false, { 1, DEPTH }),
+        PASS(false, { 1, READ }, { 2, COLOR }),
+    };
+    QS_CHECK(qs_render_graph_compile(res, 3, passes, 4, &plan));
+    QS_CHECK_EQ_U(plan.order_count, 4);
+    QS_CHECK_EQ_U(plan.heap_offset[0], 0);
+    QS_CHECK_EQ_U(plan.heap_offset[1], 0);
+
+    QS_CHECK_EQ_U(plan.barrier_count, 7);
+    QS_CHECK_EQ_U(plan.barrier_start[0], 0);
+    QS_CHECK_EQ_U(plan.barrier_start[1], 1);
+    QS_CHECK_EQ_U(plan.barrier_start[2], 3);
+    QS_CHECK_EQ_U(plan.barrier_start[3], 4);
+    QS_CHECK_EQ_U(plan.barrier_start[4], 6);
+
+    /* First use discards; the memory last held T1 from the previous frame */
+    check_barrier(0, 0, UNDEF, COLOR, READ);
+    check_barrier(1, 0, COLOR, READ,  UNDEF);
+    check_barrier(2, 2, READ,  COLOR, UNDEF);
+    /* T1 takes over T0's memory, which T0 left in SHADER_READ */
+    check_barrier(3, 1, UNDEF, DEPTH, READ);
+    check_barrier(4, 1, DEPTH, READ,  UNDEF);
+    /* Write after write still needs a barrier */
+    check_barrier(5, 2, COLOR, COLOR, UNDEF);
+    /* End of frame: P2 goes back to its resting layout */
+    check_barrier(6, 2, COLOR, READ,  UNDEF);
+}
+
+static void test_repeated_reads_share_barrier(void)
+{
+    const Qs_RgResource res[] = { persistent(READ), persistent(READ), persistent(READ) };
+    const Qs_RgPass passes[] = {
+        PASS(false, { 0, READ }, { 1, COLOR }),
+        PASS(false, { 0, READ }, { 2, COLOR }),
+    };
+    QS_CHECK(qs_render_graph_compile(res, 3, passes, 2, &plan));
+    /* P0 never leaves SHADER_READ and is never written: no barrier at all */
+    for (uint32_t b = 0; b < plan.barrier_count; b++)
+        QS_CHECK(plan.barriers[b].resource != 0);
+    QS_CHECK_EQ_U(plan.barrier_count, 4);   /* P1, P2 in and back out */
+}
+
+int main(void)
+{
+    QS_TEST_RUN(test_writer_pulled_ahead_of_reader);
+    QS_TEST_RUN(test_persistent_read_keeps_order);
+    QS_TEST_RUN(test_invalid_graphs_rejected);
+    QS_TEST_RUN(test_unconsumed_passes_culled);
+    QS_TEST_RUN(test_dead_chain_culled);
+    QS_TEST_RUN(test_alias_placement);
+    QS_TEST_RUN(test_barrier_layouts);
+    QS_TEST_RUN(test_repeated_reads_share_barrier);
+    return QS_TEST_RESULT();
+}
@@ -0,0 +1,196 @@
+/*
+ * test_render_handoff.c — render snapshot handoff between the simulation,
+ * the render thread and the recorder, driven by a null backend that
+ * "prepares" snapshots on the CPU only.
+ */
+
+#include "qs_render_thread.h"
+#include "qs_test.h"
+
+#include <causality.h>
+#include <stdatomic.h>
+#include <string.h>
+
+#define HANDOFF_STRESS_FRAMES 20000
+
+/* Stand-in for RenderSnapshot: the simulation writes serial into both
+   halves, the null backend copies it into prepared. */
+typedef struct TestSnapshot {
+    uint32_t    serial_a;
+    uint32_t    serial_b;
+    uint32_t    prepared;
+    atomic_uint holders;     /* roles holding the snapshot right now */
+} TestSnapshot;
+
+typedef struct NullBackend {
+    TestSnapshot snaps[QS_RENDER_HANDOFF_SNAPSHOTS];
+    atomic_uint  prepare_calls;
+    atomic_uint  last_prepared;
+    atomic_uint  overlaps;   /* a snapshot held by two roles at once */
+    atomic_uint  torn;       /* a snapshot seen half-written */
+    atomic_bool  done;
+} NullBackend;
+
+static void hold(NullBackend *nb, uint32_t index)
+{
+    if (atomic_fetch_add(&nb->snaps[index].holders, 1) != 0)
+        atomic_fetch_add(&nb->overlaps, 1);
+}
+
+static void release(NullBackend *nb, uint32_t index)
+{
+    atomic_fetch_sub(&nb->snaps[index].holders, 1);
+}
+
+static void null_prepare(uint32_t index, void *user_data)
+{
+    NullBackend  *nb = user_data;
+    TestSnapshot *s  = &nb->snaps[index];
+    hold(nb, index);
+    if (s->serial_a != s->serial_b) atomic_fetch_add(&nb->torn, 1);
+    s->prepared = s->serial_a;
+    atomic_fetch_add(&nb->prepare_calls, 1);
+    atomic_store(&nb->last_prepared, s->serial_a);
+    release(nb, index);
+}
+
+static void publish(Qs_RenderHandoff *h, NullBackend *nb, uint32_t serial)
+{
+    TestSnapshot *s = &nb->snaps[qs_render_handoff_write_index(h)];
+    s->serial_a = serial;
+    s->serial_b = serial;
+    s->prepared = 0;
+    qs_render_handoff_publish(h);
+}
+
+/* ── Without a render thread ───────────────────────────────── */
+
+static void test_unthreaded_newest_wins(void)
+{
+    static NullBackend nb;
+    memset(&nb, 0, sizeof(nb));
+    Qs_RenderHandoff *h = qs_render_handoff_create(NULL, &nb);
+    QS_CHECK(h != NULL);
+    if (!h) return;
+    QS_CHECK(!qs_render_handoff_threaded(h));
+
+    /* Nothing published: the recorder holds a never-written snapshot */
+    QS_CHECK_EQ_U(nb.snaps[qs_render_handoff_acquire(h)].serial_a, 0);
+
+    publish(h, &nb, 1);
+    uint32_t rec = qs_render_handoff_acquire(h);
+    QS_CHECK_EQ_U(nb.snaps[rec].serial_a, 1);
+    QS_CHECK(rec != qs_render_handoff_write_index(h));
+
+    /* No publish: the same snapshot is drawn again */
+    QS_CHECK_EQ_U(qs_render_handoff_acquire(h), rec);
+
+    /* Two publishes between frames: the older one is skipped */
+    publish(h, &nb, 2);
+    publish(h, &nb, 3);
+    rec = qs_render_handoff_acquire(h);
+    QS_CHECK_EQ_U(nb.snaps[rec].serial_a, 3);
+    QS_CHECK(rec != qs_render_handoff_write_index(h));
+
+    /* Flush has nothing to wait for */
+    qs_render_handoff_flush(h);
+    QS_CHECK_EQ_U(atomic_load(&nb.prepare_calls), 0);
+    qs_render_handoff_destroy(h);
+}
+
+/* ── With a render thread ──────────────────────────────────── */
+
+static void test_threaded_records_prepared_snapshots(void)
+{
+    static NullBackend nb;
+    memset(&nb, 0, sizeof(nb));
+    Qs_RenderHandoff *h = qs_render_handoff_create(null_prepare, &nb);
+    QS_CHECK(h != NULL);
+    if (!h) return;
+    QS_CHECK(qs_render_handoff_threaded(h));
+
+    for (uint32_t serial = 1; serial <= 8; serial++) {
+        publish(h, &nb, serial);
+        qs_render_handoff_flush(h);
+        QS_CHECK_EQ_U(atomic_load(&nb.last_prepared), serial);
+
+        uint32_t rec = qs_render_handoff_acquire(h);
+        QS_CHECK_EQ_U(nb.snaps[rec].serial_a, serial);
+        QS_CHECK_EQ_U(nb.snaps[rec].prepared, serial);
+        QS_CHECK(rec != qs_render_handoff_write_index(h));
+    }
+    QS_CHECK_EQ_U(atomic_load(&nb.prepare_calls), 8);
+
+    /* Nothing new: the recorder keeps its snapshot */
+    uint32_t rec = qs_render_handoff_acquire(h);
+    QS_CHECK_EQ_U(qs_render_handoff_acquire(h), rec);
+    qs_render_handoff_destroy(h);
+}
+
+static void *recorder_fn(void *arg)
+{
+    NullBackend *nb = ((void **)arg)[0];
+    Qs_RenderHandoff *h = ((void **)arg)[1];
+    uint32_t held = qs_render_handoff_acquire(h), last = 0;
+    hold(nb, held);
+    while (!atomic_load(&nb->done)) {
+        release(nb, held);
+        held = qs_render_handoff_acquire(h);
+        hold(nb, held);
+
+        TestSnapshot *s = &nb->snaps[held];
+        if (s->serial_a != s->serial_b) atomic_fetch_add(&nb->torn, 1);
+        /* Only prepared snapshots reach the recorder, newest first */
+        if (s->serial_a != 0 && s->prepared != s->serial_a) atomic_fetch_add(&nb->torn, 1);
+        if (s->serial_a < last) atomic_fetch_add(&nb->torn, 1);
+        last = s->serial_a;
+    }
+    release(nb, held);
+    return NULL;
+}
+
+/* The simulation publishes as fast as it can while the render thread and
+   a recorder thread consume; no snapshot may ever have two holders. */
+static void test_threaded_roles_never_share(void)
+{
+    static NullBackend nb;
+    memset(&nb, 0, sizeof(nb));
+    Qs_RenderHandoff *h = qs_render_handoff_create(null_prepare, &nb);
+    QS_CHECK(h != NULL);
+    if (!h) return;
+
+    void *args[2] = { &nb, h };
+    Ca_Thread *recorder = ca_thread_create(recorder_fn, args);
+    QS_CHECK(recorder != NULL);
+
+    uint32_t write = qs_render_handoff_write_index(h);
+    hold(&nb, write);
+    for (uint32_t serial = 1; serial <= HANDOFF_STRESS_FRAMES; serial++) {
+        TestSnapshot *s = &nb.snaps[write];
+        s->serial_a = serial;
+        s->prepared = 0;
+        s->serial_b = serial;
+        release(&nb, write);
+        write = qs_render_handoff_publish(h);
+        hold(&nb, write);
+    }
+    release(&nb, write);
+    qs_render_handoff_flush(h);
+    QS_CHECK_EQ_U(atomic_load(&nb.last_prepared), HANDOFF_STRESS_FRAMES);
+
+    atomic_store(&nb.done, true);
+    if (recorder) ca_thread_join(recorder);
+    qs_render_handoff_destroy(h);
+
+    QS_CHECK_EQ_U(atomic_load(&nb.overlaps), 0);
+    QS_CHECK_EQ_U(atomic_load(&nb.torn), 0);
+    QS_CHECK(atomic_load(&nb.prepare_calls) >= 1);
+}
+
+int main(void)
+{
+    QS_TEST_RUN(test_unthreaded_newest_wins);
+    QS_TEST_RUN(test_threaded_records_prepared_snapshots);
+    QS_TEST_RUN(test_threaded_roles_never_share);
+    return QS_TEST_RESULT();
+}